@@ -53,6 +53,11 @@ Here is a list of arguments.
   in an input file, used to allocate internal read buffer.  This is an
   optional advisory parameter.
 
+- <code>-j number-of-threads</code> the number of threads used to read
+  the text/CSV files.  It sets the parameter "tafel.readCSV.threads",
+  which defaults to the number of processors online.  Files smaller than
+  4 MB are always read sequentially.
+
 - <code>-k column-name dictionary-filename</code> supply an ASCII
   dictionary for the column of categorical values.  The ASCII dictionary
   contains a pair of "integer-code: string value" on each line.  Must
@@ -119,7 +124,7 @@ static void usage(const char* name) {
         "[-r a-row-in-ASCII] [-t text-file-to-read] "
         "[-sqldump file-to-read] [-b break/delimiters-in-text-data]"
         "[-M metadata-file] [-m name:type[,name:type,...]] "
-        "[-k column-name dictionary-filename] "
+        "[-k column-name dictionary-filename] [-j number-of-threads] "
         "[-m max-rows-per-file] [-tag name-value-pair] [-p max-per-partition]"
         "[-select clause] [-where clause] [-v[=| ]verbose_level]\n\n"
         "Note:\n\tColumn name must start with an alphabet and can only "
@@ -228,6 +233,13 @@ static void parse_args(int argc, char** argv, qList& qcnd, const char*& sel,
                     build_indexes = 1;
                 }
                 break;
+            case 'j':
+            case 'J': // number of threads to read CSV files
+                if (i+1 < argc) {
+                    ++ i;
+                    ibis::gParameters().add("tafel.readCSV.threads", argv[i]);
+                }
+                break;
             case 'k':
             case 'K': { // key (aka category) and dictionary
                 if (i+2 < argc) {
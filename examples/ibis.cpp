@@ -264,7 +264,10 @@ static void help(const char* name) {
         "information about number of hits will be printed.\n"
         "If FROM clause is present, the WHERE clause will be "
         "only apply on the named datasets, otherwise, all "
-        "available datasets will be used.\n\n"
+        "available datasets will be used.\n"
+        "A query prefixed with EXPLAIN ANALYZE is processed as usual, "
+        "followed by a report of the time and the work spent in each "
+        "phase; EXPLAIN ANALYZE JSON prints the report in JSON.\n\n"
         "append dir -- add the data in dir to database.\n"
         "print [Parts|Columns|Distributions|column-name [: conditions]]\n"
         "           -- print information about partition names, column names "
@@ -4665,6 +4668,27 @@ static void parseString(const char* uid, const char* qstr,
 
     // skip leading space
     while (std::isspace(*str)) ++str;
+    // EXPLAIN ANALYZE [JSON] query -- process the query and print its profile
+    if (0 == strnicmp(str, "explain analyze ", 16)) {
+        str += 16;
+        while (std::isspace(*str)) ++str;
+        const bool json = (0 == strnicmp(str, "json ", 5));
+        if (json) {
+            str += 5;
+            while (std::isspace(*str)) ++str;
+        }
+
+        ibis::profile prof(str);
+        {
+            ibis::profile::activate act(prof);
+            parseString(uid, str, prts);
+        }
+        if (json)
+            prof.printJSON(std::cout);
+        else
+            prof.print(std::cout);
+        return;
+    }
     // look for key word SELECT
     if (0 == strnicmp(str, "select ", 7)) {
         str += 7;
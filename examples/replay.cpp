@@ -0,0 +1,444 @@
+// $Id$
+// Author: John Wu <John.Wu at ACM.org> Lawrence Berkeley National Laboratory
+// Copyright (c) 2007-2016 the Regents of the University of California
+/** @file replay.cpp
+
+This program re-executes a workload log captured by FastBit (see
+ibis::workload) against a set of data partitions, and reports the
+distributions of the latencies and the calls whose numbers of rows differ
+from the ones recorded in the log.
+
+Command line arguments
+[-c conf-file] [-d directory_containing_a_dataset] [-l workload-log]
+[-j #-of-threads] [-s speed] [-r #-of-repeats] [-m max-mismatches-to-print]
+[-v[=| ]verbose_level] [-help]
+
+The option -s controls the pace of the replay.  With the default speed of
+0, the calls are issued as fast as the threads can process them.  With a
+positive speed, the calls are issued at the times recorded in the log
+divided by the speed, e.g., -s 1 replays the workload at the pace it was
+captured and -s 2 replays it twice as fast.  Since the records in the log
+are in the order of their completion, the calls may be issued slightly
+later than their recorded start times.
+
+The exit code is 0 if all calls produce the recorded numbers of rows, 1
+otherwise.
+    @ingroup FastBitExamples
+*/
+#include "ibis.h"
+#include "workload.h"   // ibis::workload
+#include <memory>       // std::unique_ptr
+#include <algorithm>    // std::sort
+#include <iomanip>      // std::setw, std::setprecision
+#include <map>          // std::map
+
+/// The outcome of replaying a record.
+struct replayResult {
+    double elapsed; ///!< Duration of the call in seconds.
+    int64_t rows;   ///!< Number of rows produced, -1 for error.
+
+    replayResult() : elapsed(0.0), rows(-1) {}
+};
+
+/// The data shared by the replay threads.
+struct thArg {
+    const std::vector<ibis::workload::record>& recs;
+    const std::map<std::string, ibis::table*>& tables;
+    std::vector<replayResult>& res;
+    ibis::util::counter& task;
+    const ibis::horometer& clock;
+    unsigned repeats;
+    double speed;
+
+    thArg(const std::vector<ibis::workload::record>& r,
+          const std::map<std::string, ibis::table*>& t,
+          std::vector<replayResult>& o, ibis::util::counter& tc,
+          const ibis::horometer& c, unsigned n, double s)
+        : recs(r), tables(t), res(o), task(tc), clock(c),
+          repeats(n), speed(s) {}
+};
+
+/// Find the data partition with the given name.  If there is only one data
+/// partition, it is used regardless of the name.
+static const ibis::part* findPart(const std::string& name) {
+    const ibis::part* pt = ibis::findDataset(name.c_str());
+    if (pt == 0 && ibis::datasets.size() == 1)
+        pt = ibis::datasets[0];
+    return pt;
+} // findPart
+
+/// Execute a record.  Return the number of rows produced, or a negative
+/// number on error.
+static int64_t execute(const thArg& arg, const ibis::workload::record& rec) {
+    const std::vector<std::string>& as = rec.args;
+    if (rec.kind == "select" && as.size() >= 3) {
+        std::map<std::string, ibis::table*>::const_iterator it =
+            arg.tables.find(as[0]);
+        if (it == arg.tables.end() || it->second == 0) return -2;
+        std::unique_ptr<ibis::table>
+            res(it->second->select(as[1].c_str(), as[2].c_str()));
+        return (res.get() != 0 ? static_cast<int64_t>(res->nRows()) : -1);
+    }
+    else if (rec.kind == "query" && as.size() >= 3) {
+        const ibis::part* pt = findPart(as[0]);
+        if (pt == 0) return -2;
+        ibis::query qq(ibis::util::userName(), pt);
+        if (! as[1].empty() && qq.setSelectClause(as[1].c_str()) < 0)
+            return -3;
+        if (qq.setWhereClause(as[2].c_str()) < 0)
+            return -4;
+        if (qq.evaluate() < 0)
+            return -5;
+        return qq.getNumHits();
+    }
+    else if (rec.kind == "count" && as.size() >= 2) {
+        const ibis::part* pt = findPart(as[0]);
+        if (pt == 0) return -2;
+        ibis::countQuery qq(pt);
+        if (qq.setWhereClause(as[1].c_str()) < 0)
+            return -4;
+        if (qq.evaluate() < 0)
+            return -5;
+        return qq.getNumHits();
+    }
+    else if (rec.kind == "quaere" && as.size() >= 3) {
+        std::unique_ptr<ibis::quaere>
+            qr(ibis::quaere::create(as[0].c_str(), as[1].c_str(),
+                                    as[2].c_str(), ibis::datasets));
+        return (qr.get() != 0 ? qr->count() : -6);
+    }
+    else if (rec.kind == "join" && as.size() >= 6) {
+        const ibis::part* pr = ibis::findDataset(as[0].c_str());
+        const ibis::part* ps = ibis::findDataset(as[1].c_str());
+        if (pr == 0 || ps == 0) return -2;
+        std::unique_ptr<ibis::quaere>
+            qr(ibis::quaere::create(pr, ps, as[2].c_str(), as[3].c_str(),
+                                    as[4].c_str(), as[5].c_str()));
+        return (qr.get() != 0 ? qr->count() : -6);
+    }
+    LOGGER(ibis::gVerbose > 0)
+        << "Warning -- replay does not know how to execute a record of kind "
+        << rec.kind << " with " << as.size() << " argument"
+        << (as.size() > 1 ? "s" : "");
+    return -1;
+} // execute
+
+/// Wait until the given number of seconds since the start of the replay.
+static void waitUntil(const ibis::horometer& clock, double target) {
+    while (true) {
+        ibis::horometer now(clock);
+        now.stop();
+        const double delta = target - now.realTime();
+        if (delta <= 0.0) break;
+#if defined(_WIN32) && defined(_MSC_VER)
+        Sleep(static_cast<DWORD>(delta * 1e3 + 1));
+#else
+        struct timespec ts;
+        ts.tv_sec = static_cast<time_t>(delta);
+        ts.tv_nsec = static_cast<long>((delta - ts.tv_sec) * 1e9);
+        (void) nanosleep(&ts, 0);
+#endif
+    }
+} // waitUntil
+
+extern "C" void* thFun(void* arg) {
+    thArg* myArg = (thArg*)arg; // recast the argument to the right type
+    const size_t nrecs = myArg->recs.size();
+    const double span = (nrecs > 0 ? myArg->recs.back().start : 0.0);
+    for (unsigned j = myArg->task(); j < nrecs * myArg->repeats;
+         j = myArg->task()) {
+        const ibis::workload::record& rec = myArg->recs[j % nrecs];
+        if (myArg->speed > 0.0)
+            waitUntil(myArg->clock,
+                      ((j / nrecs) * span + rec.start) / myArg->speed);
+
+        ibis::horometer timer;
+        timer.start();
+        try {
+            myArg->res[j].rows = execute(*myArg, rec);
+        }
+        catch (const std::exception& e) {
+            LOGGER(ibis::gVerbose >= 0)
+                << "Warning -- replay received a std::exception -- "
+                << e.what() << " while executing record " << j % nrecs;
+        }
+        catch (const char* s) {
+            LOGGER(ibis::gVerbose >= 0)
+                << "Warning -- replay received a string exception -- "
+                << s << " while executing record " << j % nrecs;
+        }
+        catch (...) {
+            LOGGER(ibis::gVerbose >= 0)
+                << "Warning -- replay received an unexpected exception "
+                "while executing record " << j % nrecs;
+        }
+        timer.stop();
+        myArg->res[j].elapsed = timer.realTime();
+    }
+    return 0;
+} // thFun
+
+/// Return the value at the given fraction of the sorted list.
+static double quantile(const std::vector<double>& vals, double f) {
+    if (vals.empty()) return 0.0;
+    size_t j = static_cast<size_t>(f * vals.size());
+    if (j >= vals.size())
+        j = vals.size() - 1;
+    return vals[j];
+} // quantile
+
+/// Print the latencies of the calls of one kind.  The latencies recorded in
+/// the log are printed on the line that follows.
+static void printLatencies(std::ostream& out, const char* kind,
+                           std::vector<double>& now,
+                           std::vector<double>& old) {
+    std::sort(now.begin(), now.end());
+    std::sort(old.begin(), old.end());
+    double tnow = 0.0, told = 0.0;
+    for (size_t j = 0; j < now.size(); ++ j)
+        tnow += now[j];
+    for (size_t j = 0; j < old.size(); ++ j)
+        told += old[j];
+    out << std::setw(8) << kind << std::setw(8) << now.size()
+        << std::setw(12) << (now.empty() ? 0.0 : now.front())
+        << std::setw(12) << quantile(now, 0.5)
+        << std::setw(12) << quantile(now, 0.9)
+        << std::setw(12) << quantile(now, 0.99)
+        << std::setw(12) << (now.empty() ? 0.0 : now.back())
+        << std::setw(12) << (now.empty() ? 0.0 : tnow / now.size())
+        << "\n" << std::setw(8) << "(log)" << std::setw(8) << old.size()
+        << std::setw(12) << (old.empty() ? 0.0 : old.front())
+        << std::setw(12) << quantile(old, 0.5)
+        << std::setw(12) << quantile(old, 0.9)
+        << std::setw(12) << quantile(old, 0.99)
+        << std::setw(12) << (old.empty() ? 0.0 : old.back())
+        << std::setw(12) << (old.empty() ? 0.0 : told / old.size())
+        << "\n";
+} // printLatencies
+
+// printout the usage string
+static void usage(const char* name) {
+    std::cout << "usage:\n" << name << " [-c conf-file] [-help] "
+        "[-d directory_containing_a_dataset] [-l workload-log] "
+        "[-j #-of-threads] [-s speed] [-r #-of-repeats] "
+        "[-m max-mismatches-to-print] [-v[=| ]verbose_level]"
+        "\n\nRe-executes the calls recorded in a workload log against the "
+        "data partitions named by -d and -c, and reports the latencies and "
+        "the calls that produce numbers of rows different from the log."
+        "\n-- a speed of 0 (the default) issues the calls as fast as "
+        "possible, a positive speed issues them at the recorded times "
+        "divided by the speed."
+        "\n-- the workload log is produced by setting the parameter "
+        "workload.capture or by calling ibis::workload::startCapture."
+              << std::endl;
+} // usage
+
+int main(int argc, char** argv) {
+    const char* conffile = 0;
+    const char* logfile = 0;
+    std::vector<const char*> dirs;
+    unsigned nthreads = 1;
+    unsigned repeats = 1;
+    unsigned maxprint = 10;
+    double speed = 0.0;
+    for (int i = 1; i < argc; ++ i) {
+        if (*argv[i] != '-') {
+            usage(*argv);
+            return -1;
+        }
+        switch (argv[i][1]) {
+        case 'c': case 'C':
+            if (i+1 < argc) conffile = argv[++i];
+            break;
+        case 'd': case 'D':
+            if (i+1 < argc) dirs.push_back(argv[++i]);
+            break;
+        case 'j': case 'J':
+            if (i+1 < argc) nthreads = (unsigned) atoi(argv[++i]);
+            break;
+        case 'l': case 'L':
+            if (i+1 < argc) logfile = argv[++i];
+            break;
+        case 'm': case 'M':
+            if (i+1 < argc) maxprint = (unsigned) atoi(argv[++i]);
+            break;
+        case 'r': case 'R':
+            if (i+1 < argc) repeats = (unsigned) atoi(argv[++i]);
+            break;
+        case 's': case 'S':
+            if (i+1 < argc) speed = atof(argv[++i]);
+            break;
+        case 'v': case 'V': {
+            char *ptr = strchr(argv[i], '=');
+            if (ptr == 0) {
+                if (i+1 < argc) {
+                    if (isdigit(*argv[i+1])) {
+                        ibis::gVerbose += atoi(argv[i+1]);
+                        i = i + 1;
+                    }
+                    else {
+                        ++ ibis::gVerbose;
+                    }
+                }
+                else {
+                    ++ ibis::gVerbose;
+                }
+            }
+            else {
+                ibis::gVerbose += atoi(++ptr);
+            }
+            break;}
+        default:
+            usage(*argv);
+            return 0;
+        }
+    }
+    if (logfile == 0 || *logfile == 0) {
+        usage(*argv);
+        return -1;
+    }
+    if (nthreads == 0) nthreads = 1;
+    if (repeats == 0) repeats = 1;
+
+    ibis::init(conffile);
+    // replaying a workload must not add to a workload being captured
+    ibis::workload::stopCapture();
+    ibis::util::timer mytimer(*argv, 0);
+    for (size_t j = 0; j < dirs.size(); ++ j)
+        (void) ibis::util::gatherParts(ibis::datasets, dirs[j]);
+    if (ibis::datasets.empty()) {
+        std::cerr << *argv << " needs at least one data partition, use -d "
+            "or -c to specify the data" << std::endl;
+        return -2;
+    }
+
+    std::vector<ibis::workload::record> recs;
+    int ierr = ibis::workload::readLog(logfile, recs);
+    if (ierr <= 0) {
+        std::cerr << *argv << " failed to read any record from " << logfile
+                  << ", ierr = " << ierr << std::endl;
+        return -3;
+    }
+    // the records are written in the order of completion
+    std::stable_sort(recs.begin(), recs.end(),
+                     [](const ibis::workload::record& a,
+                        const ibis::workload::record& b) {
+                         return a.start < b.start;});
+
+    // the tables named by the select records, each is a list of data
+    // partitions separated by commas
+    std::map<std::string, ibis::table*> tables;
+    for (size_t j = 0; j < recs.size(); ++ j) {
+        if (recs[j].kind != "select" || recs[j].args.empty() ||
+            tables.find(recs[j].args[0]) != tables.end())
+            continue;
+
+        const std::string& names = recs[j].args[0];
+        ibis::partList pl;
+        for (size_t k = 0; k < names.size(); ) {
+            size_t e = names.find(',', k);
+            if (e == std::string::npos)
+                e = names.size();
+            ibis::part* pt = ibis::findDataset(names.substr(k, e-k).c_str());
+            if (pt != 0) {
+                pl.push_back(pt);
+            }
+            else {
+                LOGGER(ibis::gVerbose > 0)
+                    << "Warning -- " << *argv << " can not find a data "
+                    "partition named " << names.substr(k, e-k);
+                pl.clear();
+                break;
+            }
+            k = e + 1;
+        }
+        if (pl.empty() && ibis::datasets.size() == 1)
+            pl.push_back(ibis::datasets[0]);
+        tables[names] = (pl.empty() ? 0 : ibis::table::create(pl));
+    }
+
+    std::vector<replayResult> res(recs.size() * repeats);
+    ibis::util::counter taskpool;
+    ibis::horometer clock;
+    clock.start();
+    thArg args(recs, tables, res, taskpool, clock, repeats, speed);
+    const unsigned nth = nthreads - 1;
+    std::vector<pthread_t> tid(nth);
+    LOGGER(ibis::gVerbose > 0)
+        << *argv << " will replay " << recs.size() << " record"
+        << (recs.size()>1?"s":"") << " from " << logfile << " " << repeats
+        << " time" << (repeats>1?"s":"") << " using " << nthreads
+        << " thread" << (nthreads>1?"s":"");
+    for (unsigned i = 0; i < nth; ++ i) {
+        ierr = pthread_create(&(tid[i]), 0, thFun, (void*)&args);
+        if (ierr != 0) {
+            LOGGER(ibis::gVerbose >= 0)
+                << "Warning -- pthread_create failed to create thread "
+                << i << " -- " << strerror(ierr);
+            return -5;
+        }
+    }
+    thFun((void*)&args); // this thread does something too
+    for (unsigned i = 0; i < nth; ++ i) {
+        void *status;
+        ierr = pthread_join(tid[i], (void**)&status);
+        LOGGER(ibis::gVerbose >= 0 && ierr != 0)
+            << "pthread_join failed on thread " << i
+            << " -- " << strerror(ierr);
+    }
+    clock.stop();
+
+    // summarize the latencies by kind and find the mismatches
+    std::map<std::string, std::vector<double> > lnow, lold;
+    std::vector<double> tnow, told;
+    size_t nerrors = 0, nmismatches = 0;
+    for (size_t j = 0; j < res.size(); ++ j) {
+        const ibis::workload::record& rec = recs[j % recs.size()];
+        lnow[rec.kind].push_back(res[j].elapsed);
+        tnow.push_back(res[j].elapsed);
+        if (j < recs.size()) {
+            lold[rec.kind].push_back(rec.elapsed);
+            told.push_back(rec.elapsed);
+        }
+        if (res[j].rows < 0)
+            ++ nerrors;
+        if (res[j].rows != rec.rows) {
+            ++ nmismatches;
+            if (nmismatches <= maxprint) {
+                std::cout << "Warning -- record " << j % recs.size()
+                          << " (" << rec.kind;
+                for (size_t k = 0; k < rec.args.size(); ++ k)
+                    std::cout << (k > 0 ? ", " : ": ") << rec.args[k];
+                std::cout << ") produced " << res[j].rows
+                          << " row(s), but the log recorded " << rec.rows
+                          << "\n";
+            }
+        }
+    }
+
+    std::cout << "\n" << *argv << " replayed " << res.size() << " call"
+              << (res.size()>1?"s":"") << " from " << logfile << " in "
+              << clock.realTime() << " sec using " << nthreads << " thread"
+              << (nthreads>1?"s":"");
+    if (speed > 0.0)
+        std::cout << " at speed " << speed;
+    std::cout << "\nLatencies in seconds\n" << std::setprecision(4)
+              << std::setw(8) << "kind" << std::setw(8) << "count"
+              << std::setw(12) << "min" << std::setw(12) << "median"
+              << std::setw(12) << "p90" << std::setw(12) << "p99"
+              << std::setw(12) << "max" << std::setw(12) << "mean" << "\n";
+    for (std::map<std::string, std::vector<double> >::iterator it =
+             lnow.begin(); it != lnow.end(); ++ it)
+        printLatencies(std::cout, it->first.c_str(), it->second,
+                       lold[it->first]);
+    if (lnow.size() > 1)
+        printLatencies(std::cout, "all", tnow, told);
+    std::cout << "\n" << nmismatches << " mismatch"
+              << (nmismatches!=1?"es":"") << ", " << nerrors << " error"
+              << (nerrors!=1?"s":"") << std::endl;
+
+    for (std::map<std::string, ibis::table*>::iterator it = tables.begin();
+         it != tables.end(); ++ it)
+        delete it->second;
+    return (nmismatches > 0 ? 1 : 0);
+} // main
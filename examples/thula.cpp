@@ -32,6 +32,7 @@ http://msnucleus.org/watersheds/elizabeth/duck_island.htm for some pictures.
 #include "resource.h"   // ibis::gParameters
 #include "mensa.h"      // ibis::mensa::select2
 #include "blob.h"       // operator<< involving ibis::opaque
+#include "profile.h"    // ibis::profile
 #include <set>          // std::set
 #include <iomanip>      // std::setprecision
 #include <memory>       // std::unique_ptr
@@ -56,7 +57,9 @@ static void usage(const char* name) {
         "\n\nPerforms a projection of rows satisfying the specified "
         "conditions, a very limited version of SQL"
         "\n  SELECT select-clause FROM from-clause WHERE where-clause."
-        "\nEach where-clause will be used in turn."
+        "\nEach where-clause will be used in turn.  A where-clause "
+        "prefixed with \"EXPLAIN ANALYZE\" (or \"EXPLAIN ANALYZE JSON\") "
+        "also prints the time and the work spent in each phase."
         "\n\n-- both select clause and where clause may contain "
         "arithmetic expressions."
         "\n-- data in all directories specified by -c and -d "
@@ -658,6 +661,27 @@ static void printValues(const ibis::table& tbl) {
 void doQuery(const ibis::table& tbl, const char* wstr, const char* sstr,
              const char* fstr, const char* ostr) {
     if (wstr == 0 || *wstr == 0) return;
+    if (0 == strnicmp(wstr, "explain analyze ", 16)) {
+        // process the query and print its profile, in JSON if requested
+        wstr += 16;
+        while (isspace(*wstr)) ++ wstr;
+        const bool json = (0 == strnicmp(wstr, "json ", 5));
+        if (json) {
+            wstr += 5;
+            while (isspace(*wstr)) ++ wstr;
+        }
+
+        ibis::profile prof(wstr);
+        {
+            ibis::profile::activate act(prof);
+            doQuery(tbl, wstr, sstr, fstr, ostr);
+        }
+        if (json)
+            prof.printJSON(std::cout);
+        else
+            prof.print(std::cout);
+        return;
+    }
 
     std::string mesg;
     mesg = "doQuery(";
@@ -0,0 +1,317 @@
+// File $Id$
+// Author: John Wu <John.Wu at ACM.org>
+//      Lawrence Berkeley National Laboratory
+// Copyright (c) 2007-2016 the Regents of the University of California
+//
+// This file contains the functions to record the query workload and to
+// recommend index specifications.  See advisor.h for a description.
+#include "advisor.h"    // ibis::advisor
+#include "index.h"      // ibis::index
+#include "resource.h"   // ibis::gParameters
+
+#include <memory>       // std::unique_ptr
+#include <sstream>      // std::ostringstream
+
+/// The number of conditions kept for each column.
+#ifndef FASTBIT_ADVISOR_SAMPLES
+#define FASTBIT_ADVISOR_SAMPLES 64
+#endif
+
+namespace ibis {
+    namespace advisor {
+        /// The conditions observed on a column.
+        struct workload {
+            uint64_t nequal;    ///!< Number of equality conditions.
+            uint64_t nrange;    ///!< Number of other range conditions.
+            uint64_t ndiscrete; ///!< Number of discrete range conditions.
+            uint32_t next;      ///!< Next sample to replace.
+            /// A sample of the conditions, the most recent ones.
+            std::vector<ibis::qRange*> samples;
+
+            workload() : nequal(0), nrange(0), ndiscrete(0), next(0) {}
+            ~workload() {
+                for (size_t j = 0; j < samples.size(); ++ j)
+                    delete samples[j];
+            }
+
+        private:
+            workload(const workload&); // no copying
+            workload& operator=(const workload&);
+        }; // workload
+
+        /// The workloads of all columns, keyed by partName.columnName.
+        class registry : public std::map<std::string, workload*> {
+        public:
+            ~registry() {
+                for (iterator it = begin(); it != end(); ++ it)
+                    delete (*it).second;
+            }
+        }; // registry
+    } // namespace advisor
+} // namespace ibis
+
+bool ibis::advisor::enabled = false;
+
+/// Turn the recording of the conditions on or off.  The conditions
+/// recorded so far are kept.
+void ibis::advisor::enable(bool on) {
+    ibis::advisor::enabled = on;
+} // ibis::advisor::enable
+
+/// The workloads recorded so far.
+static ibis::advisor::registry _ibis_advisor_loads;
+/// Protects _ibis_advisor_loads.
+static pthread_mutex_t _ibis_advisor_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/// Is the condition a test of equality?
+static bool _ibis_advisor_isEquality(const ibis::qRange& cmp) {
+    if (cmp.getType() == ibis::qExpr::DRANGE)
+        return (cmp.nItems() == 1);
+    if (cmp.getType() != ibis::qExpr::RANGE)
+        return false;
+    const ibis::qContinuousRange& rng =
+        static_cast<const ibis::qContinuousRange&>(cmp);
+    return (rng.leftOperator() == ibis::qExpr::OP_EQ ||
+            rng.rightOperator() == ibis::qExpr::OP_EQ ||
+            (rng.leftOperator() == ibis::qExpr::OP_LE &&
+             rng.rightOperator() == ibis::qExpr::OP_LE &&
+             rng.leftBound() == rng.rightBound()));
+} // _ibis_advisor_isEquality
+
+/// The kinds of conditions counted separately.
+enum _ibis_advisor_kind {_ibis_advisor_equal=0, _ibis_advisor_range=1,
+                         _ibis_advisor_discrete=2};
+
+/// Classify a condition as an equality, a discrete range or another range
+/// condition.
+static _ibis_advisor_kind _ibis_advisor_classify(const ibis::qRange& cmp) {
+    if (cmp.getType() == ibis::qExpr::DRANGE && cmp.nItems() > 1)
+        return _ibis_advisor_discrete;
+    else if (_ibis_advisor_isEquality(cmp))
+        return _ibis_advisor_equal;
+    else
+        return _ibis_advisor_range;
+} // _ibis_advisor_classify
+
+/// The default candidates for a column.  The unbinned indexes are only
+/// considered for integer columns whose range of values is small compared
+/// with the number of rows, following the choice of the default index in
+/// ibis::index::create.
+static void _ibis_advisor_candidates(const ibis::column& col,
+                                     std::vector<std::string>& cands) {
+    cands.clear();
+    const char* str = ibis::gParameters()["advisor.candidates"];
+    if (str != 0 && *str != 0) {
+        const char* end;
+        while (*str != 0) {
+            while (*str == ';' || isspace(*str)) ++ str;
+            end = strchr(str, ';');
+            if (end == 0)
+                end = str + std::strlen(str);
+            if (end > str)
+                cands.push_back(std::string(str, end));
+            str = end;
+        }
+        return;
+    }
+
+    if (! col.isNumeric())
+        return;
+    if (col.isInteger()) {
+        double amin = col.lowerBound();
+        double amax = col.upperBound();
+        if (! (amin <= amax)) {
+            const_cast<ibis::column&>(col).computeMinMax();
+            amin = col.lowerBound();
+            amax = col.upperBound();
+        }
+        if (amax - amin < 1e4 || amax - amin < col.nRows()*0.1) {
+            cands.push_back("<binning none/><encoding equality/>");
+            cands.push_back("<binning none/><encoding range/>");
+            cands.push_back("<binning none/><encoding interval-equality/>");
+            cands.push_back("<binning none/><encoding range-equality/>");
+            cands.push_back("<binning none/><encoding equality-equality/>");
+        }
+    }
+    cands.push_back("<binning nbins=1000/>");
+} // _ibis_advisor_candidates
+
+/// Record a condition evaluated on the data partition @c p.  Nothing is
+/// recorded unless the recording is turned on, see ibis::advisor::enable.
+void ibis::advisor::record(const ibis::part& p, const ibis::qRange& cmp) {
+    if (! enabled ||
+        (cmp.getType() != ibis::qExpr::RANGE &&
+         cmp.getType() != ibis::qExpr::DRANGE))
+        return;
+    const ibis::column* col = p.getColumn(cmp.colName());
+    if (col == 0) return;
+
+    std::string key = p.name();
+    key += '.';
+    key += col->name();
+    ibis::util::mutexLock lck(&_ibis_advisor_mutex, "advisor::record");
+    workload*& wl = _ibis_advisor_loads[key];
+    if (wl == 0)
+        wl = new workload;
+    switch (_ibis_advisor_classify(cmp)) {
+    case _ibis_advisor_discrete: ++ wl->ndiscrete; break;
+    case _ibis_advisor_equal: ++ wl->nequal; break;
+    default: ++ wl->nrange; break;
+    }
+
+    ibis::qRange* tmp = static_cast<ibis::qRange*>(cmp.dup());
+    if (wl->samples.size() < FASTBIT_ADVISOR_SAMPLES) {
+        wl->samples.push_back(tmp);
+    }
+    else {
+        delete wl->samples[wl->next];
+        wl->samples[wl->next] = tmp;
+        ++ wl->next;
+        if (wl->next >= wl->samples.size())
+            wl->next = 0;
+    }
+} // ibis::advisor::record
+
+/// Recommend an index specification for each column of the data partition
+/// @c p with recorded conditions.  The recommendations are placed in @c
+/// specs keyed by the column names.  Each candidate index is built in
+/// memory, therefore this function could take a while; it is meant to be
+/// invoked before building the indexes, for example, through
+/// ibis::part::buildIndexes with the index option "advise".
+///
+/// Returns the number of columns with a recommendation.
+long ibis::advisor::advise(const ibis::part& p,
+                           std::map<std::string, std::string>& specs) {
+    specs.clear();
+    std::string prefix = p.name();
+    prefix += '.';
+    // copy the samples and the counts so that the lock is not held while
+    // building the candidate indexes
+    std::map<std::string, std::vector<ibis::qRange*> > todo;
+    std::map<std::string, std::vector<double> > counts;
+    {
+        ibis::util::mutexLock lck(&_ibis_advisor_mutex, "advisor::advise");
+        for (registry::const_iterator it =
+                 _ibis_advisor_loads.lower_bound(prefix);
+             it != _ibis_advisor_loads.end() &&
+                 (*it).first.compare(0, prefix.size(), prefix) == 0;
+             ++ it) {
+            const std::string cname = (*it).first.substr(prefix.size());
+            std::vector<ibis::qRange*>& smp = todo[cname];
+            for (size_t j = 0; j < (*it).second->samples.size(); ++ j)
+                smp.push_back(static_cast<ibis::qRange*>
+                              ((*it).second->samples[j]->dup()));
+            std::vector<double>& cnt = counts[cname];
+            cnt.resize(3);
+            cnt[_ibis_advisor_equal] = (*it).second->nequal;
+            cnt[_ibis_advisor_range] = (*it).second->nrange;
+            cnt[_ibis_advisor_discrete] = (*it).second->ndiscrete;
+        }
+    }
+
+    std::vector<std::string> cands;
+    for (std::map<std::string, std::vector<ibis::qRange*> >::iterator it =
+             todo.begin(); it != todo.end(); ++ it) {
+        std::vector<ibis::qRange*>& smp = (*it).second;
+        const std::vector<double>& cnt = counts[(*it).first];
+        std::vector<_ibis_advisor_kind> kinds(smp.size());
+        double nsmp[3] = {0.0, 0.0, 0.0};
+        for (size_t j = 0; j < smp.size(); ++ j) {
+            kinds[j] = _ibis_advisor_classify(*smp[j]);
+            ++ nsmp[kinds[j]];
+        }
+        const ibis::column* col = p.getColumn((*it).first.c_str());
+        if (col != 0)
+            _ibis_advisor_candidates(*col, cands);
+        else
+            cands.clear();
+
+        double best = 0.0;
+        float bsize = 0.0;
+        const std::string* choice = 0;
+        for (size_t k = 0; k < cands.size(); ++ k) {
+            std::unique_ptr<ibis::index>
+                ind(ibis::index::build(col, cands[k].c_str()));
+            if (ind.get() == 0) continue;
+
+            // the average cost of each kind of conditions in the sample
+            // times the number of conditions of the kind recorded
+            double cost = 0.0;
+            for (size_t j = 0; j < smp.size(); ++ j) {
+                double c;
+                if (smp[j]->getType() == ibis::qExpr::DRANGE)
+                    c = ind->estimateCost
+                        (*static_cast<const ibis::qDiscreteRange*>(smp[j]));
+                else
+                    c = ind->estimateCost
+                        (*static_cast<const ibis::qContinuousRange*>(smp[j]));
+                cost += c * cnt[kinds[j]] / nsmp[kinds[j]];
+            }
+            const float sz = ind->sizeInBytes();
+            LOGGER(ibis::gVerbose > 2)
+                << "advisor::advise -- " << col->fullname() << " with `"
+                << cands[k] << "' (" << ind->name() << ", " << sz
+                << " bytes) costs " << cost << " for " << smp.size()
+                << " sampled condition" << (smp.size()>1?"s":"");
+            // prefer the smaller index when the costs are close
+            if (choice == 0 || cost < 0.95 * best ||
+                (cost <= 1.05 * best && sz < bsize)) {
+                choice = &(cands[k]);
+                best = cost;
+                bsize = sz;
+            }
+        }
+        if (choice != 0) {
+            specs[col->name()] = *choice;
+            LOGGER(ibis::gVerbose > 1)
+                << "advisor::advise recommends `" << *choice << "' for "
+                << col->fullname() << ", estimated cost " << best;
+        }
+        for (size_t j = 0; j < smp.size(); ++ j)
+            delete smp[j];
+    }
+    return specs.size();
+} // ibis::advisor::advise
+
+/// Print the conditions recorded for the columns of data partition @c p.
+void ibis::advisor::print(std::ostream& out, const ibis::part& p) {
+    std::string prefix = p.name();
+    prefix += '.';
+    ibis::util::mutexLock lck(&_ibis_advisor_mutex, "advisor::print");
+    out << "advisor -- workload recorded for data partition " << p.name();
+    for (registry::const_iterator it =
+             _ibis_advisor_loads.lower_bound(prefix);
+         it != _ibis_advisor_loads.end() &&
+             (*it).first.compare(0, prefix.size(), prefix) == 0;
+         ++ it) {
+        const workload& wl = *((*it).second);
+        out << "\n" << (*it).first.substr(prefix.size()) << ":\t"
+            << wl.nequal << " equality, " << wl.nrange << " range, "
+            << wl.ndiscrete << " discrete range condition"
+            << (wl.ndiscrete>1?"s":"") << ", " << wl.samples.size()
+            << " sampled";
+    }
+    out << std::endl;
+} // ibis::advisor::print
+
+/// Forget the conditions recorded for the data partition @c p.  If @c p
+/// is nil, forget all conditions recorded.
+void ibis::advisor::clear(const ibis::part* p) {
+    ibis::util::mutexLock lck(&_ibis_advisor_mutex, "advisor::clear");
+    if (p == 0) {
+        for (registry::iterator it = _ibis_advisor_loads.begin();
+             it != _ibis_advisor_loads.end(); ++ it)
+            delete (*it).second;
+        _ibis_advisor_loads.clear();
+        return;
+    }
+
+    std::string prefix = p->name();
+    prefix += '.';
+    registry::iterator it = _ibis_advisor_loads.lower_bound(prefix);
+    while (it != _ibis_advisor_loads.end() &&
+           (*it).first.compare(0, prefix.size(), prefix) == 0) {
+        delete (*it).second;
+        _ibis_advisor_loads.erase(it++);
+    }
+} // ibis::advisor::clear
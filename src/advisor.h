@@ -0,0 +1,54 @@
+// File: $Id$
+// Author: John Wu <John.Wu at acm.org>
+//      Lawrence Berkeley National Laboratory
+// Copyright (c) 2007-2016 the Regents of the University of California
+#ifndef IBIS_ADVISOR_H
+#define IBIS_ADVISOR_H
+///@file
+/// Selection of index specifications based on the observed queries.
+///
+/// The range conditions evaluated by ibis::query and ibis::countQuery are
+/// recorded for each column: the number of equality, range and discrete
+/// range conditions and a sample of the conditions themselves.  To
+/// recommend an index specification for a column, each candidate index is
+/// built in memory and its cost of answering the sampled conditions is
+/// computed with the function estimateCost of the index.  The average
+/// cost of the sampled conditions of each kind is weighted by the number
+/// of conditions of that kind recorded, so that the recent sample stands
+/// for the whole workload.  The candidate with the lowest total cost is
+/// recommended.
+///
+/// The candidates are given by the parameter advisor.candidates as a list
+/// of index specifications separated by semicolons.  Without this
+/// parameter, the unbinned indexes with a cost model (equality, range,
+/// interval-equality, range-equality and equality-equality encodings) are
+/// considered for integer columns with a modest range of values, and the
+/// binned index is considered for all numerical columns.
+///
+/// The recording is off by default.  It is turned on by calling
+/// ibis::advisor::enable or by setting the parameter advisor.recordWorkload
+/// to true before calling ibis::init.  While it is off, the query
+/// processing only tests the flag ibis::advisor::enabled.
+#include "qExpr.h"      // ibis::qRange
+#include "part.h"       // ibis::part
+
+#include <map>          // std::map
+
+namespace ibis {
+    /// Functions to record the query workload of the columns and to
+    /// recommend index specifications for them.
+    namespace advisor {
+        /// Are the conditions being recorded?  Use ibis::advisor::enable
+        /// to change it.
+        extern FASTBIT_CXX_DLLSPEC bool enabled;
+        FASTBIT_CXX_DLLSPEC void enable(bool on);
+        FASTBIT_CXX_DLLSPEC void record(const ibis::part& p,
+                                        const ibis::qRange& cmp);
+        FASTBIT_CXX_DLLSPEC long
+        advise(const ibis::part& p, std::map<std::string, std::string>& specs);
+        FASTBIT_CXX_DLLSPEC void print(std::ostream& out,
+                                       const ibis::part& p);
+        FASTBIT_CXX_DLLSPEC void clear(const ibis::part* p);
+    } // namespace advisor
+} // namespace ibis
+#endif // IBIS_ADVISOR_H
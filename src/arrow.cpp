@@ -0,0 +1,709 @@
+// File $Id$
+// Author: John Wu <John.Wu at ACM.org>
+//      Lawrence Berkeley National Laboratory
+// Copyright (c) 2007-2016 the Regents of the University of California
+//
+// This file contains the functions to exchange in-memory data through the
+// Arrow C Data Interface.  See arrow.h for a description.
+#include "arrow.h"      // ibis::arrow
+#include "bord.h"       // ibis::bord
+#include "dictionary.h" // ibis::dictionary
+
+#include <map>          // std::map
+#include <memory>       // std::unique_ptr
+
+namespace ibis {
+    namespace arrow {
+        /// The private data of an exported ArrowSchema.
+        struct schemaData {
+            std::string format; ///!< The format string.
+            std::string name;   ///!< The name of the field.
+            /// The children, owned by this object.
+            std::vector<ArrowSchema*> children;
+            /// The dictionary, owned by this object.
+            ArrowSchema* dictionary;
+
+            schemaData() : dictionary(0) {}
+        }; // schemaData
+
+        /// The private data of an exported ArrowArray.
+        struct arrayData {
+            /// The type of @c values.
+            ibis::TYPE_T type;
+            /// A shallow copy of the array_t holding the values of the
+            /// column.  It keeps the storage of the column in use.
+            void* values;
+            /// The validity bitmap.
+            std::vector<unsigned char> validity;
+            /// The offsets of the strings.
+            std::vector<int32_t> offsets;
+            /// The characters of the strings.
+            std::string chars;
+            /// The codes of the categorical values converted here.
+            std::vector<int32_t> codes;
+            /// The list of buffers passed to the consumer.
+            std::vector<const void*> buffers;
+            /// The children, owned by this object.
+            std::vector<ArrowArray*> children;
+            /// The dictionary, owned by this object.
+            ArrowArray* dictionary;
+
+            arrayData() : type(ibis::UNKNOWN_TYPE), values(0), dictionary(0) {}
+        }; // arrayData
+
+        /// An imported ArrowArray shared by the columns using its buffers.
+        /// The array is released when the last of them is freed.
+        struct holder {
+            ArrowArray array; ///!< The imported array.
+            /// The dictionaries of the categorical columns.
+            std::vector<ibis::dictionary*> dictionaries;
+            /// The number of storage objects using the array.
+            ibis::util::sharedInt32 nref;
+
+            holder() {array.release = 0;}
+            ~holder() {
+                if (array.release != 0)
+                    array.release(&array);
+                for (size_t j = 0; j < dictionaries.size(); ++ j)
+                    delete dictionaries[j];
+            }
+            /// Record one more user.
+            void beginUse() {++ nref;}
+            /// Remove a user, delete the holder if it is the last one.
+            void endUse() {
+                if (-- nref == 0)
+                    delete this;
+            }
+        }; // holder
+
+        /// A storage object wrapping a buffer of an imported ArrowArray.
+        /// Unlike the storage objects wrapping user memory, this object is
+        /// deleted by the last array_t using it, which in turn releases the
+        /// ArrowArray when no other column uses it.
+        class storage : public ibis::fileManager::storage {
+        public:
+            storage(holder* h, const void* addr, size_t nbytes) : hld(h) {
+                m_begin = static_cast<char*>(const_cast<void*>(addr));
+                m_end = m_begin + nbytes;
+                hld->beginUse();
+            }
+            virtual ~storage() {
+                // the memory belongs to the ArrowArray, not to this object
+                m_begin = 0;
+                m_end = 0;
+                hld->endUse();
+            }
+
+        private:
+            holder* hld;
+
+            storage(const storage&); // no copying
+            storage& operator=(const storage&);
+        }; // storage
+    } // namespace arrow
+} // namespace ibis
+
+/// Release an exported ArrowSchema.
+static void _ibis_arrow_releaseSchema(ArrowSchema* schema) {
+    if (schema == 0 || schema->release == 0) return;
+
+    ibis::arrow::schemaData* sd =
+        static_cast<ibis::arrow::schemaData*>(schema->private_data);
+    if (sd != 0) {
+        for (size_t j = 0; j < sd->children.size(); ++ j) {
+            if (sd->children[j]->release != 0)
+                sd->children[j]->release(sd->children[j]);
+            delete sd->children[j];
+        }
+        if (sd->dictionary != 0) {
+            if (sd->dictionary->release != 0)
+                sd->dictionary->release(sd->dictionary);
+            delete sd->dictionary;
+        }
+        delete sd;
+    }
+    schema->release = 0;
+} // _ibis_arrow_releaseSchema
+
+/// Release an exported ArrowArray.
+static void _ibis_arrow_releaseArray(ArrowArray* array) {
+    if (array == 0 || array->release == 0) return;
+
+    ibis::arrow::arrayData* ad =
+        static_cast<ibis::arrow::arrayData*>(array->private_data);
+    if (ad != 0) {
+        ibis::table::freeBuffer(ad->values, ad->type);
+        for (size_t j = 0; j < ad->children.size(); ++ j) {
+            if (ad->children[j]->release != 0)
+                ad->children[j]->release(ad->children[j]);
+            delete ad->children[j];
+        }
+        if (ad->dictionary != 0) {
+            if (ad->dictionary->release != 0)
+                ad->dictionary->release(ad->dictionary);
+            delete ad->dictionary;
+        }
+        delete ad;
+    }
+    array->release = 0;
+} // _ibis_arrow_releaseArray
+
+/// Fill an ArrowSchema with the given format and name.
+static ibis::arrow::schemaData*
+_ibis_arrow_initSchema(ArrowSchema* schema, const char* fmt,
+                       const char* name, int64_t flags) {
+    ibis::arrow::schemaData* sd = new ibis::arrow::schemaData;
+    sd->format = fmt;
+    if (name != 0)
+        sd->name = name;
+    schema->format = sd->format.c_str();
+    schema->name = sd->name.c_str();
+    schema->metadata = 0;
+    schema->flags = flags;
+    schema->n_children = 0;
+    schema->children = 0;
+    schema->dictionary = 0;
+    schema->release = _ibis_arrow_releaseSchema;
+    schema->private_data = sd;
+    return sd;
+} // _ibis_arrow_initSchema
+
+/// Fill an ArrowArray with the given length.  The buffers are to be
+/// filled by the caller.
+static ibis::arrow::arrayData*
+_ibis_arrow_initArray(ArrowArray* array, int64_t nr) {
+    ibis::arrow::arrayData* ad = new ibis::arrow::arrayData;
+    array->length = nr;
+    array->null_count = 0;
+    array->offset = 0;
+    array->n_buffers = 0;
+    array->n_children = 0;
+    array->buffers = 0;
+    array->children = 0;
+    array->dictionary = 0;
+    array->release = _ibis_arrow_releaseArray;
+    array->private_data = ad;
+    return ad;
+} // _ibis_arrow_initArray
+
+/// Set the buffers of an ArrowArray from the list in its private data.
+static void _ibis_arrow_setBuffers(ArrowArray* array) {
+    ibis::arrow::arrayData* ad =
+        static_cast<ibis::arrow::arrayData*>(array->private_data);
+    array->n_buffers = ad->buffers.size();
+    array->buffers = (ad->buffers.empty() ? 0 : &(ad->buffers[0]));
+} // _ibis_arrow_setBuffers
+
+/// Convert the null mask of the first @c nr rows into a validity bitmap.
+/// Returns the number of nulls.  The bitmap is left empty if there is no
+/// null value.
+static int64_t _ibis_arrow_validity(const ibis::bitvector& mask, uint32_t nr,
+                                    std::vector<unsigned char>& bits) {
+    bits.clear();
+    if (mask.size() == nr && mask.cnt() == nr)
+        return 0;
+
+    int64_t nvalid = 0;
+    bits.assign((nr + 7) / 8, 0);
+    for (ibis::bitvector::indexSet is = mask.firstIndexSet();
+         is.nIndices() > 0; ++ is) {
+        const ibis::bitvector::word_t *ii = is.indices();
+        if (is.isRange()) {
+            for (ibis::bitvector::word_t i = *ii; i < ii[1] && i < nr; ++ i) {
+                bits[i >> 3] |= (1 << (i & 7));
+                ++ nvalid;
+            }
+        }
+        else {
+            for (unsigned k = 0; k < is.nIndices(); ++ k) {
+                if (ii[k] < nr) {
+                    bits[ii[k] >> 3] |= (1 << (ii[k] & 7));
+                    ++ nvalid;
+                }
+            }
+        }
+    }
+    return nr - nvalid;
+} // _ibis_arrow_validity
+
+/// Export a list of strings as a UTF-8 string array.  The strings are
+/// copied.
+static void _ibis_arrow_exportStrings(const std::vector<const char*>& strs,
+                                      ArrowSchema* schema, ArrowArray* array,
+                                      const char* name) {
+    _ibis_arrow_initSchema(schema, "u", name, ARROW_FLAG_NULLABLE);
+    ibis::arrow::arrayData* ad = _ibis_arrow_initArray(array, strs.size());
+    ad->offsets.resize(strs.size()+1);
+    ad->offsets[0] = 0;
+    for (size_t j = 0; j < strs.size(); ++ j) {
+        if (strs[j] != 0)
+            ad->chars += strs[j];
+        ad->offsets[j+1] = ad->chars.size();
+    }
+    ad->buffers.push_back(0);
+    ad->buffers.push_back(&(ad->offsets[0]));
+    ad->buffers.push_back(ad->chars.data());
+    _ibis_arrow_setBuffers(array);
+} // _ibis_arrow_exportStrings
+
+/// Make a shallow copy of the array_t holding the values.
+template <typename T> static void*
+_ibis_arrow_share(const void* buf, uint32_t nr, const void*& addr) {
+    const ibis::array_t<T>& arr = *static_cast<const ibis::array_t<T>*>(buf);
+    if (arr.size() < nr)
+        return 0;
+    ibis::array_t<T>* tmp = new ibis::array_t<T>(arr);
+    addr = tmp->begin();
+    return tmp;
+} // _ibis_arrow_share
+
+/// Export a column of an in-memory data table.  The integers and the
+/// floating-point values are not copied; the exported array keeps the
+/// underlying storage of the column in use until it is released, however,
+/// if the column wraps memory provided by the user, such as an array
+/// registered through the in-memory API, that memory must outlive the
+/// exported array.  A column of type ibis::UINT with a dictionary and a
+/// column of type ibis::CATEGORY are exported as dictionary arrays with
+/// the strings in the dictionary, while a column of type ibis::TEXT is
+/// exported as a UTF-8 string array.
+///
+/// The caller owns the ArrowSchema and the ArrowArray and must call their
+/// release functions when they are no longer needed.  Returns 0 on
+/// success, a negative number to indicate error, in which case neither
+/// structure needs to be released.
+int ibis::arrow::exportColumn(const ibis::column& c, ArrowSchema* schema,
+                              ArrowArray* array) {
+    if (schema == 0 || array == 0)
+        return -1;
+    const ibis::bord::column* col =
+        dynamic_cast<const ibis::bord::column*>(&c);
+    if (col == 0 || col->getArray() == 0) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- arrow::exportColumn can only export in-memory "
+            "columns, " << c.fullname() << " is not one of them";
+        return -2;
+    }
+
+    const uint32_t nr = (col->partition() != 0 ?
+                         col->partition()->nRows() : col->nRows());
+    ibis::bitvector mask;
+    col->getNullMask(mask);
+    std::unique_ptr<ibis::arrow::arrayData> ad(new ibis::arrow::arrayData);
+    ad->type = col->type();
+    std::unique_ptr<ArrowSchema> dschema; // schema of the dictionary
+    const void* addr = 0;
+    const char* fmt = 0;
+    int64_t nnull = _ibis_arrow_validity(mask, nr, ad->validity);
+
+    switch (col->type()) {
+    default:
+        break;
+    case ibis::OID:
+        fmt = "L";
+        ad->values = _ibis_arrow_share<ibis::rid_t>(col->getArray(), nr, addr);
+        break;
+    case ibis::BYTE:
+        fmt = "c";
+        ad->values = _ibis_arrow_share<signed char>(col->getArray(), nr, addr);
+        break;
+    case ibis::UBYTE:
+        fmt = "C";
+        ad->values = _ibis_arrow_share<unsigned char>
+            (col->getArray(), nr, addr);
+        break;
+    case ibis::SHORT:
+        fmt = "s";
+        ad->values = _ibis_arrow_share<int16_t>(col->getArray(), nr, addr);
+        break;
+    case ibis::USHORT:
+        fmt = "S";
+        ad->values = _ibis_arrow_share<uint16_t>(col->getArray(), nr, addr);
+        break;
+    case ibis::INT:
+        fmt = "i";
+        ad->values = _ibis_arrow_share<int32_t>(col->getArray(), nr, addr);
+        break;
+    case ibis::UINT:
+        fmt = "I";
+        ad->values = _ibis_arrow_share<uint32_t>(col->getArray(), nr, addr);
+        break;
+    case ibis::LONG:
+        fmt = "l";
+        ad->values = _ibis_arrow_share<int64_t>(col->getArray(), nr, addr);
+        break;
+    case ibis::ULONG:
+        fmt = "L";
+        ad->values = _ibis_arrow_share<uint64_t>(col->getArray(), nr, addr);
+        break;
+    case ibis::FLOAT:
+        fmt = "f";
+        ad->values = _ibis_arrow_share<float>(col->getArray(), nr, addr);
+        break;
+    case ibis::DOUBLE:
+        fmt = "g";
+        ad->values = _ibis_arrow_share<double>(col->getArray(), nr, addr);
+        break;
+    case ibis::CATEGORY:
+    case ibis::TEXT: {
+        const std::vector<std::string>& strs =
+            *static_cast<const std::vector<std::string>*>(col->getArray());
+        if (strs.size() < nr)
+            break;
+        fmt = (col->type() == ibis::TEXT ? "u" : "i");
+        if (col->type() == ibis::TEXT) {
+            ad->offsets.resize(nr+1);
+            ad->offsets[0] = 0;
+            for (uint32_t j = 0; j < nr; ++ j) {
+                ad->chars += strs[j];
+                ad->offsets[j+1] = ad->chars.size();
+            }
+            addr = &(ad->offsets[0]);
+        }
+        else { // assign codes to the distinct strings
+            std::map<std::string, int32_t> dic;
+            ad->codes.resize(nr);
+            for (uint32_t j = 0; j < nr; ++ j) {
+                std::map<std::string, int32_t>::const_iterator it =
+                    dic.find(strs[j]);
+                if (it == dic.end()) {
+                    const int32_t tmp = dic.size();
+                    dic[strs[j]] = tmp;
+                    ad->codes[j] = tmp;
+                }
+                else {
+                    ad->codes[j] = it->second;
+                }
+            }
+            std::vector<const char*> words(dic.size());
+            for (std::map<std::string, int32_t>::const_iterator it =
+                     dic.begin(); it != dic.end(); ++ it)
+                words[it->second] = it->first.c_str();
+            ad->dictionary = new ArrowArray;
+            dschema.reset(new ArrowSchema);
+            _ibis_arrow_exportStrings(words, dschema.get(), ad->dictionary, 0);
+            addr = (nr > 0 ? &(ad->codes[0]) : 0);
+        }
+        break;}
+    }
+    if (fmt == 0 || (addr == 0 && nr > 0 && ad->codes.empty())) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- arrow::exportColumn can not export column "
+            << col->fullname() << " of type "
+            << ibis::TYPESTRING[(int)col->type()] << " with " << nr
+            << " row" << (nr>1?"s":"");
+        if (ad->dictionary != 0) {
+            ad->dictionary->release(ad->dictionary);
+            delete ad->dictionary;
+            ad->dictionary = 0;
+            dschema->release(dschema.get());
+        }
+        ibis::table::freeBuffer(ad->values, ad->type);
+        return -3;
+    }
+
+    const ibis::dictionary* dic = col->getDictionary();
+    if (col->type() == ibis::UINT && dic != 0) {
+        // codes outside of the dictionary are nulls
+        const ibis::array_t<uint32_t>& codes =
+            *static_cast<const ibis::array_t<uint32_t>*>(ad->values);
+        for (uint32_t j = 0; j < nr; ++ j) {
+            if (codes[j] < dic->size() && (*dic)[codes[j]] != 0)
+                continue;
+            if (ad->validity.empty())
+                ad->validity.assign((nr + 7) / 8, 0xFF);
+            if (ad->validity[j >> 3] & (1 << (j & 7))) {
+                ad->validity[j >> 3] &= ~(1 << (j & 7));
+                ++ nnull;
+            }
+        }
+        std::vector<const char*> words(dic->size());
+        for (uint32_t j = 0; j < dic->size(); ++ j)
+            words[j] = (*dic)[j];
+        ad->dictionary = new ArrowArray;
+        dschema.reset(new ArrowSchema);
+        _ibis_arrow_exportStrings(words, dschema.get(), ad->dictionary, 0);
+    }
+
+    ibis::arrow::schemaData* sd =
+        _ibis_arrow_initSchema(schema, fmt, col->name(), ARROW_FLAG_NULLABLE);
+    if (dschema.get() != 0) {
+        sd->dictionary = dschema.release();
+        schema->dictionary = sd->dictionary;
+    }
+    ad->buffers.push_back(ad->validity.empty() ? 0 : &(ad->validity[0]));
+    ad->buffers.push_back(addr);
+    if (col->type() == ibis::TEXT)
+        ad->buffers.push_back(ad->chars.data());
+
+    ibis::arrow::arrayData* tmp = ad.release();
+    ArrowArray* dicarr = tmp->dictionary;
+    array->length = nr;
+    array->null_count = nnull;
+    array->offset = 0;
+    array->n_children = 0;
+    array->children = 0;
+    array->dictionary = dicarr;
+    array->release = _ibis_arrow_releaseArray;
+    array->private_data = tmp;
+    _ibis_arrow_setBuffers(array);
+    return 0;
+} // ibis::arrow::exportColumn
+
+/// Export an in-memory data table, such as the result of
+/// ibis::table::select, as a struct array with one child per column.  See
+/// ibis::arrow::exportColumn for the treatment of the columns.  Returns 0
+/// on success, a negative number to indicate error.
+int ibis::arrow::exportTable(const ibis::table& tbl, ArrowSchema* schema,
+                             ArrowArray* array) {
+    if (schema == 0 || array == 0)
+        return -1;
+    const ibis::bord* brd = dynamic_cast<const ibis::bord*>(&tbl);
+    if (brd == 0) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- arrow::exportTable can only export in-memory "
+            "data tables, " << tbl.name() << " is not one of them";
+        return -2;
+    }
+
+    const uint32_t ncols = brd->ibis::part::nColumns();
+    ibis::arrow::schemaData* sd =
+        _ibis_arrow_initSchema(schema, "+s", tbl.name(), 0);
+    ibis::arrow::arrayData* ad = _ibis_arrow_initArray(array, tbl.nRows());
+    for (uint32_t j = 0; j < ncols; ++ j) {
+        const ibis::column* col = brd->getColumn(j);
+        std::unique_ptr<ArrowSchema> cs(new ArrowSchema);
+        std::unique_ptr<ArrowArray> ca(new ArrowArray);
+        int ierr = (col != 0 ? exportColumn(*col, cs.get(), ca.get()) : -4);
+        if (ierr < 0) {
+            schema->release(schema);
+            array->release(array);
+            return ierr - 10;
+        }
+        sd->children.push_back(cs.release());
+        ad->children.push_back(ca.release());
+    }
+
+    ad->buffers.push_back(0);
+    _ibis_arrow_setBuffers(array);
+    schema->n_children = sd->children.size();
+    schema->children = (sd->children.empty() ? 0 : &(sd->children[0]));
+    array->n_children = ad->children.size();
+    array->children = (ad->children.empty() ? 0 : &(ad->children[0]));
+    return 0;
+} // ibis::arrow::exportTable
+
+/// Convert the validity bitmap of an imported array into a null mask.
+static void _ibis_arrow_nullMask(const ArrowArray& arr,
+                                 ibis::bitvector& mask) {
+    mask.clear();
+    const unsigned char* bits = static_cast<const unsigned char*>
+        (arr.n_buffers > 0 ? arr.buffers[0] : 0);
+    if (bits == 0 || arr.null_count == 0) {
+        mask.set(1, static_cast<ibis::bitvector::word_t>(arr.length));
+        return;
+    }
+
+    for (int64_t i = arr.offset; i < arr.offset + arr.length; ++ i)
+        mask += ((bits[i >> 3] >> (i & 7)) & 1);
+} // _ibis_arrow_nullMask
+
+/// Wrap the values buffer of an imported array in an array_t.
+template <typename T> static void*
+_ibis_arrow_wrap(ibis::arrow::holder* hld, const ArrowArray& arr) {
+    if (arr.n_buffers < 2 || arr.buffers[1] == 0)
+        return 0;
+    const T* addr = static_cast<const T*>(arr.buffers[1]) + arr.offset;
+    // the array_t deletes the storage object when it is no longer used
+    return new ibis::array_t<T>
+        (new ibis::arrow::storage(hld, addr, arr.length * sizeof(T)));
+} // _ibis_arrow_wrap
+
+/// Copy the strings of an imported UTF-8 string array.
+static std::vector<std::string>*
+_ibis_arrow_strings(const ArrowArray& arr) {
+    if (arr.n_buffers < 3 || arr.buffers[1] == 0)
+        return 0;
+    const int32_t* offsets = static_cast<const int32_t*>(arr.buffers[1]);
+    const char* chars = static_cast<const char*>(arr.buffers[2]);
+    std::vector<std::string>* strs = new std::vector<std::string>(arr.length);
+    for (int64_t i = 0; i < arr.length; ++ i) {
+        const int32_t b = offsets[arr.offset+i];
+        const int32_t e = offsets[arr.offset+i+1];
+        if (e > b && chars != 0)
+            (*strs)[i].assign(chars + b, e - b);
+    }
+    return strs;
+} // _ibis_arrow_strings
+
+/// Import an ArrowArray as an in-memory data table.  If the schema is a
+/// struct, each child becomes a column, otherwise the array becomes the
+/// only column of the table.  The supported types are the integers, the
+/// floating-point numbers, the UTF-8 strings, and the dictionary arrays
+/// with 32-bit indices and UTF-8 strings as values; the children of other
+/// types are skipped.
+///
+/// The integers and the floating-point values are used in place.  The
+/// content of @c array is moved into the new table, which calls its
+/// release function after all columns using its buffers are freed; upon
+/// return, the release function of @c array is set to nil as required by
+/// the Arrow C Data Interface.  The schema remains with the caller.
+///
+/// @note The buffers may be modified by the operations that reorder the
+/// rows of the table in place, such as ibis::bord::reverseRows.
+///
+/// Returns a nil pointer in case of error.
+ibis::bord* ibis::arrow::importTable(const ArrowSchema* schema,
+                                     ArrowArray* array, const char* name) {
+    if (schema == 0 || array == 0 || array->release == 0 ||
+        schema->format == 0)
+        return 0;
+    if (array->length > 0x7FFFFFFF) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- arrow::importTable can not handle " << array->length
+            << " rows in an in-memory data table";
+        return 0;
+    }
+
+    ibis::arrow::holder* hld = new ibis::arrow::holder;
+    hld->array = *array;
+    array->release = 0; // moved into hld
+    hld->beginUse(); // held until the table is constructed
+
+    std::vector<const ArrowSchema*> fields;
+    std::vector<const ArrowArray*> arrays;
+    if (std::strcmp(schema->format, "+s") == 0) {
+        for (int64_t j = 0; j < schema->n_children &&
+                 j < hld->array.n_children; ++ j) {
+            fields.push_back(schema->children[j]);
+            arrays.push_back(hld->array.children[j]);
+        }
+    }
+    else {
+        fields.push_back(schema);
+        arrays.push_back(&(hld->array));
+    }
+
+    ibis::table::bufferArray buf;
+    ibis::table::typeArray types;
+    ibis::table::stringArray names;
+    std::vector<const ibis::dictionary*> dics;
+    std::vector<ibis::bitvector> masks;
+    for (size_t j = 0; j < fields.size(); ++ j) {
+        const ArrowSchema& fld = *(fields[j]);
+        const ArrowArray& arr = *(arrays[j]);
+        if (arr.length != hld->array.length && fields.size() > 1)
+            continue;
+
+        const char* fmt = (fld.format != 0 ? fld.format : "");
+        void* vals = 0;
+        ibis::TYPE_T t = ibis::UNKNOWN_TYPE;
+        ibis::dictionary* dic = 0;
+        if (fld.dictionary != 0) {
+            const ArrowSchema& ds = *(fld.dictionary);
+            if ((std::strcmp(fmt, "i") == 0 || std::strcmp(fmt, "I") == 0) &&
+                ds.format != 0 && std::strcmp(ds.format, "u") == 0 &&
+                arr.dictionary != 0) {
+                std::unique_ptr< std::vector<std::string> >
+                    words(_ibis_arrow_strings(*(arr.dictionary)));
+                if (words.get() != 0) {
+                    dic = new ibis::dictionary;
+                    for (size_t i = 0; i < words->size(); ++ i)
+                        dic->insert((*words)[i].c_str(),
+                                    static_cast<uint32_t>(i));
+                    hld->dictionaries.push_back(dic);
+                    t = ibis::UINT;
+                    vals = _ibis_arrow_wrap<uint32_t>(hld, arr);
+                }
+            }
+        }
+        else if (fmt[0] != 0 && fmt[1] == 0) {
+            switch (*fmt) {
+            default:
+                break;
+            case 'c':
+                t = ibis::BYTE;
+                vals = _ibis_arrow_wrap<signed char>(hld, arr);
+                break;
+            case 'C':
+                t = ibis::UBYTE;
+                vals = _ibis_arrow_wrap<unsigned char>(hld, arr);
+                break;
+            case 's':
+                t = ibis::SHORT;
+                vals = _ibis_arrow_wrap<int16_t>(hld, arr);
+                break;
+            case 'S':
+                t = ibis::USHORT;
+                vals = _ibis_arrow_wrap<uint16_t>(hld, arr);
+                break;
+            case 'i':
+                t = ibis::INT;
+                vals = _ibis_arrow_wrap<int32_t>(hld, arr);
+                break;
+            case 'I':
+                t = ibis::UINT;
+                vals = _ibis_arrow_wrap<uint32_t>(hld, arr);
+                break;
+            case 'l':
+                t = ibis::LONG;
+                vals = _ibis_arrow_wrap<int64_t>(hld, arr);
+                break;
+            case 'L':
+                t = ibis::ULONG;
+                vals = _ibis_arrow_wrap<uint64_t>(hld, arr);
+                break;
+            case 'f':
+                t = ibis::FLOAT;
+                vals = _ibis_arrow_wrap<float>(hld, arr);
+                break;
+            case 'g':
+                t = ibis::DOUBLE;
+                vals = _ibis_arrow_wrap<double>(hld, arr);
+                break;
+            case 'u':
+                t = ibis::TEXT;
+                vals = _ibis_arrow_strings(arr);
+                break;
+            }
+        }
+        if (vals == 0) {
+            LOGGER(ibis::gVerbose > 1)
+                << "Warning -- arrow::importTable skips field " << j << " ("
+                << (fld.name ? fld.name : "") << ") with format \"" << fmt
+                << "\"";
+            continue;
+        }
+
+        buf.push_back(vals);
+        types.push_back(t);
+        names.push_back(fld.name);
+        dics.push_back(dic);
+        masks.resize(masks.size()+1);
+        _ibis_arrow_nullMask(arr, masks.back());
+    }
+
+    ibis::bord* ret = 0;
+    if (! buf.empty()) {
+        try {
+            // the bord takes over the buffers
+            ret = new ibis::bord(name, "imported through the Arrow C Data "
+                                 "Interface", hld->array.length, buf, types,
+                                 names, 0, &dics);
+            if (ret->ibis::part::nColumns() == masks.size()) {
+                for (uint32_t j = 0; j < masks.size(); ++ j)
+                    if (masks[j].cnt() < masks[j].size())
+                        ret->getColumn(j)->setNullMask(masks[j]);
+            }
+        }
+        catch (...) {
+            LOGGER(ibis::gVerbose > 0)
+                << "Warning -- arrow::importTable failed to construct an "
+                "in-memory data table from " << buf.size() << " column"
+                << (buf.size()>1?"s":"");
+            ibis::table::freeBuffers(buf, types);
+            ret = 0;
+        }
+    }
+    hld->endUse(); // the array is released here if no column uses it
+    return ret;
+} // ibis::arrow::importTable
@@ -0,0 +1,83 @@
+// File: $Id$
+// Author: John Wu <John.Wu at acm.org>
+//      Lawrence Berkeley National Laboratory
+// Copyright (c) 2007-2016 the Regents of the University of California
+#ifndef IBIS_ARROW_H
+#define IBIS_ARROW_H
+///@file
+/// Exchange in-memory data with the Apache Arrow C Data Interface.
+///
+/// The columns of an in-memory data table (ibis::bord), such as the
+/// results of ibis::table::select, are exported as ArrowArray and
+/// ArrowSchema structures without copying the integers and floating-point
+/// values; each exported array holds a reference to the storage of the
+/// column, which keeps the values alive until the consumer calls the
+/// release callback.  Only the validity bitmaps and the string values are
+/// converted.  Categorical values are exported as dictionary arrays and
+/// text values as UTF-8 string arrays.
+///
+/// In the other direction, an ArrowArray is imported as an ibis::bord
+/// that uses the Arrow buffers directly and releases the array when the
+/// columns are no longer in use.
+///
+/// The structures follow the definition of the Arrow C Data Interface,
+/// which is a stable ABI, therefore no Arrow library is needed.
+#include "table.h"      // ibis::table
+
+extern "C" {
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+    /// The description of the type of an Arrow array.
+    struct ArrowSchema {
+        const char* format;
+        const char* name;
+        const char* metadata;
+        int64_t flags;
+        int64_t n_children;
+        struct ArrowSchema** children;
+        struct ArrowSchema* dictionary;
+
+        void (*release)(struct ArrowSchema*);
+        void* private_data;
+    };
+
+    /// The content of an Arrow array.
+    struct ArrowArray {
+        int64_t length;
+        int64_t null_count;
+        int64_t offset;
+        int64_t n_buffers;
+        int64_t n_children;
+        const void** buffers;
+        struct ArrowArray** children;
+        struct ArrowArray* dictionary;
+
+        void (*release)(struct ArrowArray*);
+        void* private_data;
+    };
+#endif // ARROW_C_DATA_INTERFACE
+}
+
+namespace ibis {
+    class bord;   // forward declaration
+    class column; // forward declaration
+
+    /// Functions to exchange data through the Arrow C Data Interface.
+    namespace arrow {
+        FASTBIT_CXX_DLLSPEC int
+        exportColumn(const ibis::column& col, struct ArrowSchema* schema,
+                     struct ArrowArray* array);
+        FASTBIT_CXX_DLLSPEC int
+        exportTable(const ibis::table& tbl, struct ArrowSchema* schema,
+                    struct ArrowArray* array);
+        FASTBIT_CXX_DLLSPEC ibis::bord*
+        importTable(const struct ArrowSchema* schema,
+                    struct ArrowArray* array, const char* name=0);
+    } // namespace arrow
+} // namespace ibis
+#endif // IBIS_ARROW_H
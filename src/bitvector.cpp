@@ -10,6 +10,8 @@
 #pragma warning(disable:4786)   // some identifier longer than 256 characters
 #endif
 #include "bitvector.h"
+#include "profile.h"    // ibis::profile
+#include "metrics.h"    // ibis::metrics
 #define FASTBIT_LAZY_INIT 1
 
 #include <iomanip>      // setw
@@ -275,6 +277,55 @@ void ibis::bitvector::set(int val, ibis::bitvector::word_t n) {
     }
 } // ibis::bitvector::set
 
+/// Create a vector with @c n bits, where the bits at the @c npos
+/// positions listed in @c pos are 1 and the others are 0.  The positions
+/// must be in ascending order; those not less than @c n are ignored.  The
+/// compressed words are generated directly, which is much faster than
+/// calling setBit for each position.
+void ibis::bitvector::set(const word_t* pos, word_t npos, word_t n) {
+    clear(); // clear the current content
+    m_vec.nosharing(); // make sure the array is not shared
+    word_t next = 0; // the next literal word to be generated
+    for (word_t i = 0; i < npos && pos[i] < n; ) {
+        const word_t w = pos[i] / MAXBITS;
+        if (w > next+1) {
+            append_counter(0, w - next);
+        }
+        else if (w > next) {
+            active.val = 0;
+            append_active();
+        }
+
+        // collect the bits falling in word w
+        const word_t base = w * MAXBITS;
+        word_t lit = 0;
+        for (; i < npos && pos[i] < base + MAXBITS && pos[i] < n; ++ i)
+            lit |= (1U << (MAXBITS - 1 - (pos[i] - base)));
+        next = w + 1;
+        if (base + MAXBITS <= n) {
+            active.val = lit;
+            append_active();
+        }
+        else { // the last bits go into the active word
+            active.nbits = n - base;
+            active.val = (lit >> (MAXBITS - active.nbits));
+        }
+    }
+
+    if (active.nbits == 0 && next * MAXBITS < n) { // trailing 0s
+        const word_t k = n / MAXBITS - next;
+        if (k > 1) {
+            append_counter(0, k);
+        }
+        else if (k == 1) {
+            active.val = 0;
+            append_active();
+        }
+        active.nbits = n - (next + k) * MAXBITS;
+        active.val = 0;
+    }
+} // ibis::bitvector::set
+
 /// Append a WAH word.
 /// The incoming argument @c w is assumed to be a WAH compressed word.
 void ibis::bitvector::appendWord(ibis::bitvector::word_t w) {
@@ -1192,6 +1243,9 @@ int ibis::bitvector::operator==(const ibis::bitvector& rhs) const {
 ///@note If the two bit vectors are not of the same length, the shorter one
 /// is implicitly padded with 0 bits so the two are of the same length.
 void ibis::bitvector::operator&=(const ibis::bitvector& rhs) {
+    if (ibis::profile::enabled())
+        ibis::profile::countBitvectorOp(bytes() + rhs.bytes());
+    ibis::metrics::bitvectorAnd.add();
 #if defined(WAH_CHECK_SIZE)
     if (nbits == 0)
         nbits = do_cnt();
@@ -1291,6 +1345,9 @@ void ibis::bitvector::operator&=(const ibis::bitvector& rhs) {
 ///@sa ibis::bitvector::operator&=
 ibis::bitvector* ibis::bitvector::operator&(const ibis::bitvector& rhs)
     const {
+    if (ibis::profile::enabled())
+        ibis::profile::countBitvectorOp(bytes() + rhs.bytes());
+    ibis::metrics::bitvectorAnd.add();
 #if defined(WAH_CHECK_SIZE)
     LOGGER((nbits > 0 && rhs.nbits > 0 && nbits != rhs.nbits) ||
            active.nbits != rhs.active.nbits)
@@ -1411,6 +1468,9 @@ ibis::bitvector* ibis::bitvector::operator&(const ibis::bitvector& rhs)
 ///
 ///@sa ibis::bitvector::operator&=
 void ibis::bitvector::operator|=(const ibis::bitvector& rhs) {
+    if (ibis::profile::enabled())
+        ibis::profile::countBitvectorOp(bytes() + rhs.bytes());
+    ibis::metrics::bitvectorOr.add();
 #if defined(WAH_CHECK_SIZE)
     if (nbits == 0)
         nbits = do_cnt();
@@ -1487,6 +1547,9 @@ void ibis::bitvector::operator|=(const ibis::bitvector& rhs) {
 ///@sa ibis::bitvector::operator&
 ibis::bitvector* ibis::bitvector::operator|(const ibis::bitvector& rhs)
     const {
+    if (ibis::profile::enabled())
+        ibis::profile::countBitvectorOp(bytes() + rhs.bytes());
+    ibis::metrics::bitvectorOr.add();
 #if defined(WAH_CHECK_SIZE)
     LOGGER((nbits > 0 && rhs.nbits > 0 && nbits != rhs.nbits) ||
            active.nbits != rhs.active.nbits)
@@ -1555,6 +1618,9 @@ ibis::bitvector* ibis::bitvector::operator|(const ibis::bitvector& rhs)
 ///
 ///@sa ibis::bitvector::operator&=
 void ibis::bitvector::operator^=(const ibis::bitvector& rhs) {
+    if (ibis::profile::enabled())
+        ibis::profile::countBitvectorOp(bytes() + rhs.bytes());
+    ibis::metrics::bitvectorXor.add();
 #if defined(WAH_CHECK_SIZE)
     if (nbits == 0)
         nbits = do_cnt();
@@ -1623,6 +1689,9 @@ void ibis::bitvector::operator^=(const ibis::bitvector& rhs) {
 ///@sa ibis::bitvector::operator&
 ibis::bitvector* ibis::bitvector::operator^(const ibis::bitvector& rhs)
     const {
+    if (ibis::profile::enabled())
+        ibis::profile::countBitvectorOp(bytes() + rhs.bytes());
+    ibis::metrics::bitvectorXor.add();
 #if defined(WAH_CHECK_SIZE)
     LOGGER((nbits > 0 && rhs.nbits > 0 && nbits != rhs.nbits) ||
         active.nbits != rhs.active.nbits)
@@ -1683,6 +1752,9 @@ ibis::bitvector* ibis::bitvector::operator^(const ibis::bitvector& rhs)
 ///
 ///@sa ibis::bitvector::operator&=
 void ibis::bitvector::operator-=(const ibis::bitvector& rhs) {
+    if (ibis::profile::enabled())
+        ibis::profile::countBitvectorOp(bytes() + rhs.bytes());
+    ibis::metrics::bitvectorMinus.add();
 #if defined(WAH_CHECK_SIZE)
     if (nbits == 0)
         nbits = do_cnt();
@@ -1767,6 +1839,9 @@ void ibis::bitvector::operator-=(const ibis::bitvector& rhs) {
 ///@sa ibis::bitvector::operator&
 ibis::bitvector* ibis::bitvector::operator-(const ibis::bitvector& rhs)
     const {
+    if (ibis::profile::enabled())
+        ibis::profile::countBitvectorOp(bytes() + rhs.bytes());
+    ibis::metrics::bitvectorMinus.add();
 #if defined(WAH_CHECK_SIZE)
     LOGGER((nbits > 0 && rhs.nbits > 0 && nbits != rhs.nbits) ||
            active.nbits != rhs.active.nbits)
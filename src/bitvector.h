@@ -87,6 +87,7 @@ public:
     void erase(word_t i, word_t j);
 
     void set(int val, word_t n);
+    void set(const word_t* pos, word_t npos, word_t n);
     void clear();
 
     bitvector& operator+=(const bitvector& bv);
@@ -13,6 +13,7 @@
 #include "bundle.h"     // ibis::bundle
 #include "ikeywords.h"  // ibis::keyword::tokenizer
 #include "blob.h"       // printing ibis::opaque
+#include "colpack.h"    // ibis::colpack
 
 #include <iomanip>      // std::setprecision
 #include <limits>       // std::numeric_limits
@@ -2766,6 +2767,11 @@ int ibis::bord::backup(const char* dir, const char* tname,
                 "file \"" << dict << "\", ierr = " << ierr;
             cnm += ".int";
         }
+        if (ibis::colpack::isPacked(cnm.c_str())) {
+            // restore the raw data file before appending to it
+            ibis::fileManager::instance().flushFile(cnm.c_str());
+            (void) ibis::colpack::unpack(cnm.c_str());
+        }
         int fdes = UnixOpen(cnm.c_str(), OPEN_WRITEADD, OPEN_FILEMODE);
         if (fdes < 0) {
             LOGGER(ibis::gVerbose >= 0)
@@ -12999,6 +13005,49 @@ int ibis::bord::cursor::getColumnAsOpaque(uint32_t j, ibis::opaque& val) const {
     return ierr;
 } // ibis::bord::cursor::getColumnAsOpaque
 
+/// Fetch the values of up to @c nr rows following the current row.  Since
+/// the values are already in memory, they are copied directly from the
+/// arrays of the columns.  See ibis::table::cursor::fetchBatch for a
+/// description of the arguments and the return value.
+int64_t ibis::bord::cursor::fetchBatch(uint64_t nr,
+                                       ibis::table::bufferArray& buf,
+                                       std::vector<ibis::bitvector>& valid) {
+    const ibis::table::typeArray tps = columnTypes();
+    int ierr = prepareBatch(tps, nr, buf, valid);
+    if (ierr < 0) return ierr;
+
+    const uint64_t start = (curRow >= 0 ? curRow + 1 : 0);
+    if (start >= tab.nRows()) {
+        curRow = tab.nRows();
+        return 0;
+    }
+    const uint64_t nb = (start + nr <= tab.nRows() ? nr :
+                         tab.nRows() - start);
+    if (nb == 0) return 0;
+
+    ibis::bitvector msk;
+    for (uint32_t j = 0; j < tps.size() && j < buffer.size(); ++ j) {
+        if (buf[j] == 0) {
+            valid[j].appendFill(0, static_cast<ibis::bitvector::word_t>(nb));
+            continue;
+        }
+
+        const ibis::column* col = tab.getColumn(buffer[j].cname);
+        if (col == 0 || buffer[j].cval == 0) {
+            appendBatch(tps[j], 0, 0, nb, buf[j]);
+            valid[j].appendFill(0, static_cast<ibis::bitvector::word_t>(nb));
+            continue;
+        }
+
+        appendBatch(tps[j], buffer[j].cval, start, nb, buf[j]);
+        col->getNullMask(msk);
+        appendValid(msk, start, nb, valid[j]);
+    }
+
+    curRow = start + nb - 1;
+    return nb;
+} // ibis::bord::cursor::fetchBatch
+
 /// Constructor.
 ///
 /// @param[in] nd: number of dimensions specified for the hyperslab.
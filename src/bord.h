@@ -683,6 +683,9 @@ public:
     virtual int getColumnAsString(uint32_t, std::string&) const;
     virtual int getColumnAsOpaque(uint32_t, ibis::opaque&) const;
 
+    virtual int64_t fetchBatch(uint64_t, ibis::table::bufferArray&,
+                               std::vector<ibis::bitvector>&);
+
 protected:
     struct bufferElement {
 	const char* cname;
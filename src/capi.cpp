@@ -8,7 +8,12 @@
 #include "query.h"      // ibis::query
 #include "bundle.h"     // ibis::query::result
 #include "tafel.h"      // a concrete instance of ibis::tablex
+#include "arrow.h"      // ibis::arrow
+#include "metrics.h"    // ibis::metrics
+#include "preparedQuery.h"      // ibis::preparedQuery
 
+#include <memory>       // std::unique_ptr
+#include <sstream>      // std::ostringstream
 #include <time.h>       // clock, clock_gettime
 #if defined(__sun) || defined(__linux__) || defined(__HOS_AIX__) || \
     defined(__CYGWIN__) || defined(__APPLE__) || defined(__FreeBSD__)
@@ -74,6 +79,32 @@ extern "C" {
         /// A place-holder for all the string objects.
         std::vector<std::string> strbuf;
     };
+
+    /// A @c FastBitPreparedQuery holds a query parsed once for repeated
+    /// executions with different values.
+    struct FastBitPreparedQuery {
+        const ibis::part *t; ///!< The ibis::part this query refers to.
+        ibis::preparedQuery pq; ///!< The prepared query.
+
+        FastBitPreparedQuery(const ibis::part *p, const char *sel,
+                             const char *cond) : t(p), pq(sel, cond) {}
+    };
+
+    /// A @c FastBitCursor holds a table and a cursor on it, along with the
+    /// values of the last batch of rows fetched.
+    struct FastBitCursor {
+        ibis::table *base;   ///!< The table of the data directory.
+        ibis::table *sel;    ///!< The results of the selection, may be nil.
+        ibis::table::cursor *cur; ///!< The cursor.
+        ibis::table::stringArray names; ///!< Names of the columns.
+        ibis::table::typeArray types;   ///!< Types of the columns.
+        ibis::table::bufferArray buffers; ///!< Values of the last batch.
+        std::vector<ibis::bitvector> valid; ///!< Non-null values.
+        /// Packed version of the validity bitmaps.
+        std::vector< std::vector<unsigned char> > bitmaps;
+        /// Pointers to the string values.
+        std::vector< std::vector<const char*> > strings;
+    };
 }
 
 /// A list of data partitions known to the C API.  This class is only
@@ -661,6 +692,136 @@ fastbit_destroy_query(FastBitQueryHandle qhandle) {
     }
 } // fastbit_destroy_query
 
+/// Prepare the query "SELECT selectClause FROM dataDir WHERE
+/// queryConditions" for repeated executions.  The query conditions may
+/// contain question marks in place of the numbers, which are to be bound
+/// with fastbit_bind_double before each call to fastbit_execute_prepared.
+/// The query conditions are parsed and verified here.  Returns a nil
+/// pointer if the data directory can not be read or the query conditions
+/// are not valid.
+///
+/// @note Must call fastbit_destroy_prepared on the handle returned to free
+/// the resources.
+extern "C" FastBitPreparedQueryHandle
+fastbit_prepare_query(const char *select, const char *datadir,
+                      const char *where) {
+    if (datadir == 0 || *datadir == 0)
+        return 0;
+
+    try {
+        const ibis::part *t = _capi_get_part(datadir);
+        if (t == 0) {
+            LOGGER(ibis::gVerbose >= 0)
+                << "Warning -- fastbit_prepare_query failed to generate table "
+                "object from data directory \"" << datadir << "\"";
+            return 0;
+        }
+
+        FastBitPreparedQueryHandle h =
+            new FastBitPreparedQuery(t, select, where);
+        int ierr = h->pq.prepare(*t);
+        if (ierr < 0) {
+            LOGGER(ibis::gVerbose >= 0)
+                << "Warning -- fastbit_prepare_query failed to verify "
+                << "conditions (" << (where ? where : "") << ") on "
+                << t->name() << ", prepare returned " << ierr;
+            delete h;
+            h = 0;
+        }
+        return h;
+    }
+    catch (const std::exception& e) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- fastbit_prepare_query failed for \"SELECT "
+            << (select && *select ? select : "count(*)")
+            << " FROM " << datadir << " WHERE " << (where ? where : "")
+            << "\" due to exception: " << e.what();
+    }
+    catch (const char* s) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- fastbit_prepare_query failed for \"SELECT "
+            << (select && *select ? select : "count(*)")
+            << " FROM " << datadir << " WHERE " << (where ? where : "")
+            << "\" due to a string exception: " << s;
+    }
+    catch (...) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- fastbit_prepare_query failed for \"SELECT "
+            << (select && *select ? select : "count(*)")
+            << " FROM " << datadir << " WHERE " << (where ? where : "")
+            << "\" due to a unknown exception";
+    }
+    return 0;
+} // fastbit_prepare_query
+
+extern "C" int
+fastbit_prepared_parameters(FastBitPreparedQueryHandle h) {
+    if (h == 0) return -1;
+    return h->pq.nParameters();
+} // fastbit_prepared_parameters
+
+extern "C" int
+fastbit_bind_double(FastBitPreparedQueryHandle h, unsigned i, double v) {
+    if (h == 0) return -1;
+    return h->pq.bind(i, v);
+} // fastbit_bind_double
+
+/// Evaluate the prepared query with the values bound.  Returns a query
+/// handle that can be used with the other functions taking a
+/// FastBitQueryHandle, or a nil pointer in case of error.
+///
+/// @note Must call fastbit_destroy_query on the handle returned to free
+/// the resources.
+extern "C" FastBitQueryHandle
+fastbit_execute_prepared(FastBitPreparedQueryHandle pq) {
+    if (pq == 0) return 0;
+
+    FastBitQueryHandle h = 0;
+    try {
+        h = new FastBitQuery;
+        h->t = pq->t;
+        int ierr = h->q.setPartition(h->t);
+        if (ierr >= 0)
+            ierr = pq->pq.apply(h->q);
+        if (ierr >= 0)
+            ierr = h->q.evaluate();
+        if (ierr < 0) {
+            LOGGER(ibis::gVerbose > 0)
+                << "Warning -- fastbit_execute_prepared failed to evaluate \""
+                << pq->pq.boundWhereClause() << "\" on " << pq->t->name()
+                << ", error code " << ierr;
+            fastbit_destroy_query(h);
+            h = 0;
+        }
+        return h;
+    }
+    catch (const std::exception& e) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- fastbit_execute_prepared failed for \""
+            << pq->pq.getWhereClause() << "\" due to exception: "
+            << e.what();
+    }
+    catch (const char* s) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- fastbit_execute_prepared failed for \""
+            << pq->pq.getWhereClause() << "\" due to a string exception: "
+            << s;
+    }
+    catch (...) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- fastbit_execute_prepared failed for \""
+            << pq->pq.getWhereClause() << "\" due to a unknown exception";
+    }
+    fastbit_destroy_query(h);
+    return 0;
+} // fastbit_execute_prepared
+
+extern "C" int
+fastbit_destroy_prepared(FastBitPreparedQueryHandle h) {
+    delete h;
+    return 0;
+} // fastbit_destroy_prepared
+
 /// Return the number of ids placed in ids.  The row ids are limited to be
 /// uint32_t so that no more than 4 billion rows could be stored in a
 /// single data partition.
@@ -1997,6 +2158,106 @@ extern "C" double fastbit_read_clock() {
 #endif
 } //  fastbit_read_clock
 
+extern "C" void fastbit_metrics_enable(int on) {
+    ibis::metrics::enable(on != 0);
+} // fastbit_metrics_enable
+
+extern "C" int fastbit_metrics_write(const char *filename) {
+    try {
+        return ibis::metrics::write(filename);
+    }
+    catch (const std::exception& e) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- fastbit_metrics_write failed due to "
+            "exception: " << e.what();
+        return -5;
+    }
+    catch (const char* s) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- fastbit_metrics_write failed due to a "
+            "string exception: " << s;
+        return -5;
+    }
+    catch (...) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- fastbit_metrics_write failed due to a "
+            "unknown exception";
+        return -5;
+    }
+} // fastbit_metrics_write
+
+/// The callback is invoked once with the complete text, which makes it
+/// suitable for answering a scrape request of an HTTP server embedded in
+/// the caller.
+extern "C" int
+fastbit_metrics_scrape(void (*fn)(const char *text, void *ctx), void *ctx) {
+    if (fn == 0) return -1;
+
+    try {
+        std::ostringstream oss;
+        ibis::metrics::print(oss);
+        fn(oss.str().c_str(), ctx);
+        return 0;
+    }
+    catch (const std::exception& e) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- fastbit_metrics_scrape failed due to "
+            "exception: " << e.what();
+        return -2;
+    }
+    catch (const char* s) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- fastbit_metrics_scrape failed due to a "
+            "string exception: " << s;
+        return -2;
+    }
+    catch (...) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- fastbit_metrics_scrape failed due to a "
+            "unknown exception";
+        return -2;
+    }
+} // fastbit_metrics_scrape
+
+extern "C" void fastbit_lock_stats_enable(int on) {
+    ibis::util::lockStats::enable(on != 0);
+} // fastbit_lock_stats_enable
+
+extern "C" void fastbit_lock_stats_clear(void) {
+    ibis::util::lockStats::clear();
+} // fastbit_lock_stats_clear
+
+extern "C" int
+fastbit_lock_stats_report(void (*fn)(const char *text, void *ctx),
+                          void *ctx) {
+    if (fn == 0) return -1;
+
+    try {
+        std::ostringstream oss;
+        ibis::util::lockStats::print(oss);
+        fn(oss.str().c_str(), ctx);
+        return 0;
+    }
+    catch (const std::exception& e) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- fastbit_lock_stats_report failed due to "
+            "exception: " << e.what();
+        return -2;
+    }
+    catch (const char* s) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- fastbit_lock_stats_report failed due to a "
+            "string exception: " << s;
+        return -2;
+    }
+    catch (...) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- fastbit_lock_stats_report failed due to a "
+            "unknown exception";
+        return -2;
+    }
+} // fastbit_lock_stats_report
+
 /// Create a @c FastBitResultSetHandle from a query object.
 extern "C" FastBitResultSetHandle
 fastbit_build_result_set(FastBitQueryHandle qhandle) {
@@ -2475,6 +2736,251 @@ fastbit_result_set_getString(FastBitResultSetHandle rset,
     }
 } // fastbit_result_set_getString
 
+extern "C" FastBitCursorHandle
+fastbit_open_cursor(const char *dir, const char *sel, const char *cond) {
+    if (dir == 0 || *dir == 0)
+        return 0;
+
+    FastBitCursorHandle ret = 0;
+    try {
+        std::unique_ptr<ibis::table> base(ibis::table::create(dir));
+        if (base.get() == 0 || base->nColumns() == 0) {
+            LOGGER(ibis::gVerbose > 0)
+                << "Warning -- fastbit_open_cursor found no data in " << dir;
+            return ret;
+        }
+
+        std::unique_ptr<ibis::table> res;
+        if (cond != 0 && *cond != 0) {
+            res.reset(base->select(sel, cond));
+            if (res.get() == 0) {
+                LOGGER(ibis::gVerbose > 0)
+                    << "Warning -- fastbit_open_cursor failed to select \""
+                    << (sel ? sel : "") << "\" from " << dir << " where "
+                    << cond;
+                return ret;
+            }
+        }
+
+        const ibis::table& tbl = (res.get() != 0 ? *res : *base);
+        std::unique_ptr<ibis::table::cursor> cur(tbl.createCursor());
+        if (cur.get() == 0)
+            return ret;
+
+        ret = new FastBitCursor;
+        ret->names = cur->columnNames();
+        ret->types = cur->columnTypes();
+        ret->cur = cur.release();
+        ret->sel = res.release();
+        ret->base = base.release();
+    }
+    catch (const std::exception& e) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- fastbit_open_cursor failed to open a cursor on "
+            << dir << " due to exception: " << e.what();
+        ret = 0;
+    }
+    catch (const char* s) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- fastbit_open_cursor failed to open a cursor on "
+            << dir << " due to a string exception: " << s;
+        ret = 0;
+    }
+    catch (...) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- fastbit_open_cursor failed to open a cursor on "
+            << dir << " due to a unknown exception";
+        ret = 0;
+    }
+    return ret;
+} // fastbit_open_cursor
+
+extern "C" int
+fastbit_destroy_cursor(FastBitCursorHandle cur) {
+    if (cur == 0)
+        return -1;
+
+    ibis::table::freeBuffers(cur->buffers, cur->types);
+    delete cur->cur;
+    delete cur->sel;
+    delete cur->base;
+    delete cur;
+    return 0;
+} // fastbit_destroy_cursor
+
+extern "C" int
+fastbit_cursor_columns(FastBitCursorHandle cur) {
+    if (cur == 0)
+        return -1;
+    return cur->names.size();
+} // fastbit_cursor_columns
+
+extern "C" const char*
+fastbit_cursor_column_name(FastBitCursorHandle cur, unsigned pos) {
+    if (cur == 0 || pos >= cur->names.size())
+        return 0;
+    return cur->names[pos];
+} // fastbit_cursor_column_name
+
+extern "C" const char*
+fastbit_cursor_column_type(FastBitCursorHandle cur, unsigned pos) {
+    if (cur == 0 || pos >= cur->types.size())
+        return 0;
+    return ibis::TYPESTRING[(int)cur->types[pos]];
+} // fastbit_cursor_column_type
+
+/// The values are placed in the buffers held by the cursor.  The validity
+/// bitmaps are unpacked from the bit vectors into arrays of bytes and the
+/// strings are turned into arrays of pointers so that they can be accessed
+/// from C.
+extern "C" int64_t
+fastbit_cursor_fetch_batch(FastBitCursorHandle cur, uint64_t maxrows) {
+    if (cur == 0)
+        return -1;
+
+    int64_t nr = -2;
+    try {
+        nr = cur->cur->fetchBatch(maxrows, cur->buffers, cur->valid);
+        if (nr < 0)
+            return nr;
+
+        const size_t nbytes = (nr + 7) / 8;
+        cur->bitmaps.resize(cur->valid.size());
+        cur->strings.resize(cur->types.size());
+        for (size_t j = 0; j < cur->valid.size(); ++ j) {
+            std::vector<unsigned char>& bm = cur->bitmaps[j];
+            bm.assign(nbytes, 0);
+            for (ibis::bitvector::indexSet is = cur->valid[j].firstIndexSet();
+                 is.nIndices() > 0; ++ is) {
+                const ibis::bitvector::word_t *ii = is.indices();
+                if (is.isRange()) {
+                    for (ibis::bitvector::word_t i = *ii; i < ii[1]; ++ i)
+                        bm[i >> 3] |= (1 << (i & 7));
+                }
+                else {
+                    for (unsigned k = 0; k < is.nIndices(); ++ k)
+                        bm[ii[k] >> 3] |= (1 << (ii[k] & 7));
+                }
+            }
+        }
+        for (size_t j = 0; j < cur->types.size(); ++ j) {
+            cur->strings[j].clear();
+            if ((cur->types[j] == ibis::TEXT ||
+                 cur->types[j] == ibis::CATEGORY) && cur->buffers[j] != 0) {
+                const std::vector<std::string>& strs =
+                    *static_cast<const std::vector<std::string>*>
+                    (cur->buffers[j]);
+                cur->strings[j].resize(strs.size());
+                for (size_t i = 0; i < strs.size(); ++ i)
+                    cur->strings[j][i] = strs[i].c_str();
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- fastbit_cursor_fetch_batch failed to fetch "
+            << maxrows << " rows due to exception: " << e.what();
+        nr = -3;
+    }
+    catch (const char* s) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- fastbit_cursor_fetch_batch failed to fetch "
+            << maxrows << " rows due to a string exception: " << s;
+        nr = -4;
+    }
+    catch (...) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- fastbit_cursor_fetch_batch failed to fetch "
+            << maxrows << " rows due to a unknown exception";
+        nr = -5;
+    }
+    return nr;
+} // fastbit_cursor_fetch_batch
+
+extern "C" const void*
+fastbit_cursor_batch_values(FastBitCursorHandle cur, unsigned pos) {
+    if (cur == 0 || pos >= cur->buffers.size() || cur->buffers[pos] == 0)
+        return 0;
+
+    switch (cur->types[pos]) {
+    default:
+        return 0;
+    case ibis::OID:
+        return static_cast<ibis::array_t<ibis::rid_t>*>
+            (cur->buffers[pos])->begin();
+    case ibis::BYTE:
+        return static_cast<ibis::array_t<signed char>*>
+            (cur->buffers[pos])->begin();
+    case ibis::UBYTE:
+        return static_cast<ibis::array_t<unsigned char>*>
+            (cur->buffers[pos])->begin();
+    case ibis::SHORT:
+        return static_cast<ibis::array_t<int16_t>*>
+            (cur->buffers[pos])->begin();
+    case ibis::USHORT:
+        return static_cast<ibis::array_t<uint16_t>*>
+            (cur->buffers[pos])->begin();
+    case ibis::INT:
+        return static_cast<ibis::array_t<int32_t>*>
+            (cur->buffers[pos])->begin();
+    case ibis::UINT:
+        return static_cast<ibis::array_t<uint32_t>*>
+            (cur->buffers[pos])->begin();
+    case ibis::LONG:
+        return static_cast<ibis::array_t<int64_t>*>
+            (cur->buffers[pos])->begin();
+    case ibis::ULONG:
+        return static_cast<ibis::array_t<uint64_t>*>
+            (cur->buffers[pos])->begin();
+    case ibis::FLOAT:
+        return static_cast<ibis::array_t<float>*>
+            (cur->buffers[pos])->begin();
+    case ibis::DOUBLE:
+        return static_cast<ibis::array_t<double>*>
+            (cur->buffers[pos])->begin();
+    case ibis::TEXT:
+    case ibis::CATEGORY:
+        return (pos < cur->strings.size() && ! cur->strings[pos].empty() ?
+                &(cur->strings[pos][0]) : 0);
+    }
+} // fastbit_cursor_batch_values
+
+extern "C" const unsigned char*
+fastbit_cursor_batch_valid(FastBitCursorHandle cur, unsigned pos) {
+    if (cur == 0 || pos >= cur->bitmaps.size() || cur->bitmaps[pos].empty())
+        return 0;
+    return &(cur->bitmaps[pos][0]);
+} // fastbit_cursor_batch_valid
+
+extern "C" int
+fastbit_cursor_export_arrow(FastBitCursorHandle cur, ArrowSchema *schema,
+                            ArrowArray *array) {
+    if (cur == 0 || cur->sel == 0 || schema == 0 || array == 0)
+        return -1;
+
+    try {
+        return ibis::arrow::exportTable(*(cur->sel), schema, array);
+    }
+    catch (const std::exception& e) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- fastbit_cursor_export_arrow failed due to "
+            "exception: " << e.what();
+        return -2;
+    }
+    catch (const char* s) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- fastbit_cursor_export_arrow failed due to a "
+            "string exception: " << s;
+        return -2;
+    }
+    catch (...) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- fastbit_cursor_export_arrow failed due to a "
+            "unknown exception";
+        return -2;
+    }
+} // fastbit_cursor_export_arrow
+
 /// The new data records are appended to the records already in the
 /// directory if there is any.  In addition, if the new records contain
 /// columns that are not already in the directory, then the new columns are
@@ -110,6 +110,37 @@ extern "C" {
 	@note The handle becomes invalid. */
     FASTBIT_DLLSPEC int fastbit_destroy_query(FastBitQueryHandle query);
 
+    /** @brief The opaque object to hold a prepared query. */
+    struct FastBitPreparedQuery;
+    /** @brief A handle to a prepared query. */
+    typedef struct FastBitPreparedQuery* FastBitPreparedQueryHandle;
+
+    /** @brief Prepare a query whose conditions may contain question marks
+	(?) in place of the numbers in range conditions and in the lists of
+	the IN operator.  The query conditions are parsed and verified
+	once, and executed with fastbit_execute_prepared after the values
+	are bound with fastbit_bind_double. */
+    FASTBIT_DLLSPEC FastBitPreparedQueryHandle
+    fastbit_prepare_query(const char *selectClause, const char *indexLocation,
+			  const char *queryConditions);
+    /** @brief Return the number of placeholders in the prepared query. */
+    FASTBIT_DLLSPEC int
+    fastbit_prepared_parameters(FastBitPreparedQueryHandle pq);
+    /** @brief Bind a value to the ith placeholder, counting from 0.
+	Returns 0 on success. */
+    FASTBIT_DLLSPEC int
+    fastbit_bind_double(FastBitPreparedQueryHandle pq, unsigned i, double v);
+    /** @brief Evaluate the prepared query with the values bound.  The
+	returned query handle is used in the same way as the one returned
+	by fastbit_build_query and shall be freed with
+	fastbit_destroy_query. */
+    FASTBIT_DLLSPEC FastBitQueryHandle
+    fastbit_execute_prepared(FastBitPreparedQueryHandle pq);
+    /** @brief Free the prepared query.
+	@note The handle becomes invalid. */
+    FASTBIT_DLLSPEC int
+    fastbit_destroy_prepared(FastBitPreparedQueryHandle pq);
+
     /** Count the number of columns selected in the select clause of the
 	query. */
     FASTBIT_DLLSPEC int fastbit_get_result_columns(FastBitQueryHandle query);
@@ -251,6 +282,67 @@ extern "C" {
 				 unsigned position);
     /** @} */
 
+    /** @defgroup FastBitCursor Batch-wise access functions.
+	This set of functions retrieve the values of a data table or of the
+	results of a selection a batch of rows at a time.  The values of
+	each column are returned as a typed array with a validity bitmap.
+	@{
+	@brief The opaque object used to hold a cursor. */
+    struct FastBitCursor;
+    /** @brief A handle to identify a cursor. */
+    typedef struct FastBitCursor* FastBitCursorHandle;
+
+    /** @brief Open a cursor on the data in the directory @c datadir.  If
+	@c whereClause is nil or empty, the cursor covers all rows and
+	columns of the data and @c selectClause is ignored, otherwise it
+	covers the results of the selection. */
+    FASTBIT_DLLSPEC FastBitCursorHandle
+    fastbit_open_cursor(const char *datadir, const char *selectClause,
+			const char *whereClause);
+    /** @brief Destroy a cursor. */
+    FASTBIT_DLLSPEC int fastbit_destroy_cursor(FastBitCursorHandle cur);
+    /** @brief Return the number of columns of the cursor. */
+    FASTBIT_DLLSPEC int fastbit_cursor_columns(FastBitCursorHandle cur);
+    /** @brief Return the name of the column at @c position. */
+    FASTBIT_DLLSPEC const char*
+    fastbit_cursor_column_name(FastBitCursorHandle cur, unsigned position);
+    /** @brief Return the type of the column at @c position, such as
+	"INT" or "DOUBLE". */
+    FASTBIT_DLLSPEC const char*
+    fastbit_cursor_column_type(FastBitCursorHandle cur, unsigned position);
+    /** @brief Fetch up to @c maxrows rows following the current row.
+	Returns the number of rows fetched, 0 at the end of the data, or a
+	negative number to indicate error. */
+    FASTBIT_DLLSPEC int64_t
+    fastbit_cursor_fetch_batch(FastBitCursorHandle cur, uint64_t maxrows);
+    /** @brief Return the values of the column at @c position in the last
+	batch fetched.  The pointer points to an array of the type of the
+	column, e.g., int32_t for "INT", or an array of const char* for
+	strings.  It is valid until the next call to
+	fastbit_cursor_fetch_batch or fastbit_destroy_cursor. */
+    FASTBIT_DLLSPEC const void*
+    fastbit_cursor_batch_values(FastBitCursorHandle cur, unsigned position);
+    /** @brief Return the validity bitmap of the column at @c position in
+	the last batch fetched.  The bit (i%8) of byte (i/8) is 1 if the
+	value of the ith row is not null.  It is valid until the next call
+	to fastbit_cursor_fetch_batch or fastbit_destroy_cursor. */
+    FASTBIT_DLLSPEC const unsigned char*
+    fastbit_cursor_batch_valid(FastBitCursorHandle cur, unsigned position);
+
+    struct ArrowSchema;
+    struct ArrowArray;
+    /** @brief Export the results of the selection behind the cursor
+	through the Arrow C Data Interface (see arrow.h).  The numerical
+	values are not copied.  The caller is to call the release functions
+	of @c schema and @c array, which may happen after the cursor is
+	destroyed.  Returns 0 on success, a negative number to indicate
+	error, e.g., the cursor was opened without a where clause. */
+    FASTBIT_DLLSPEC int
+    fastbit_cursor_export_arrow(FastBitCursorHandle cur,
+				struct ArrowSchema *schema,
+				struct ArrowArray *array);
+    /** @} */
+
     /** @brief Flush the in-memory data to the named directory. */
     FASTBIT_DLLSPEC int fastbit_flush_buffer(const char *dir);
     /** @brief Add @c nelem values of the specified column (@c colname) to
@@ -279,6 +371,29 @@ extern "C" {
     FASTBIT_DLLSPEC FILE* fastbit_get_logfilepointer();
     FASTBIT_DLLSPEC double fastbit_read_clock();
 
+    /** @brief Turn the process-wide metrics on (@c on != 0) or off. */
+    FASTBIT_DLLSPEC void fastbit_metrics_enable(int on);
+    /** @brief Write the metrics to the named file in the Prometheus text
+	format.  The file is replaced atomically.  Returns 0 on success. */
+    FASTBIT_DLLSPEC int fastbit_metrics_write(const char *filename);
+    /** @brief Pass the metrics in the Prometheus text format to the
+	function @c fn along with @c ctx.  The text is only valid during
+	the call.  Returns 0 on success. */
+    FASTBIT_DLLSPEC int
+    fastbit_metrics_scrape(void (*fn)(const char *text, void *ctx),
+			   void *ctx);
+    /** @brief Turn the statistics on the lock acquisitions on (@c on != 0)
+	or off. */
+    FASTBIT_DLLSPEC void fastbit_lock_stats_enable(int on);
+    /** @brief Discard the statistics on the lock acquisitions. */
+    FASTBIT_DLLSPEC void fastbit_lock_stats_clear(void);
+    /** @brief Pass a report of the statistics on the lock acquisitions,
+	one line per lock and purpose, to the function @c fn along with
+	@c ctx.  Returns 0 on success. */
+    FASTBIT_DLLSPEC int
+    fastbit_lock_stats_report(void (*fn)(const char *text, void *ctx),
+			      void *ctx);
+
     /** @brief Return the software version as a string. */
     FASTBIT_DLLSPEC const char* fastbit_get_version_string();
     /** @brief Return the software version as an integer. */
@@ -13,6 +13,7 @@
 #include "category.h"
 #include "irelic.h"     // ibis::relic
 #include "ikeywords.h"
+#include "ingram.h"      // ibis::ngram
 
 #include <algorithm>    // std::copy
 #include <memory>       // std::unique_ptr
@@ -305,6 +306,8 @@ void ibis::category::readDictionary(const char *dir) const {
     fnm += FASTBIT_DIRSEP;
     fnm += m_name;
     fnm += ".dic"; // suffix of the dictionary
+    delete ngm;
+    ngm = 0;
     int ierr = dic.read(fnm.c_str());
     LOGGER(ierr < 0 && ibis::gVerbose > 2)
         << "Warning -- category[" << fullname()
@@ -468,8 +471,10 @@ ibis::direkte* ibis::category::fillIndex(const char *dir) const {
                 ints.resize(thePart->nRows());
 
             try {
-                if ((ints.size() >> ibis::gVerbose) == 0) {
-                    // reorder dictionary and ints if the dictioinary is small
+                if ((! dic.isSorted() && orderedDictionaryRequested()) ||
+                    (ints.size() >> ibis::gVerbose) == 0) {
+                    // reorder dictionary and ints if the dictioinary is
+                    // small or an ordered dictionary is requested
                     ibis::array_t<uint32_t> o2n;
                     dic.sort(o2n);
                     if (! o2n.isSorted()) {
@@ -517,6 +522,8 @@ ibis::direkte* ibis::category::fillIndex(const char *dir) const {
     dicfile += m_name;
     dicfile += ".dic";
     dic.write(dicfile.c_str());
+    delete ngm; // the codes may have changed
+    ngm = 0;
     return rlc;
 } // ibis::category::fillIndex
 
@@ -595,6 +602,8 @@ int ibis::category::setDictionary(const ibis::dictionary &sup) {
     }
 
     dic.copy(sup);
+    delete ngm;
+    ngm = 0;
     fnm += ".dic";
     dic.write(fnm.c_str());
     fnm.erase(fnm.size()-3);
@@ -928,9 +937,18 @@ long ibis::category::patternSearch(const char *pat) const {
     LOGGER(ibis::gVerbose > 5)
         << "category[" << (thePart != 0 ? thePart->name() : "??") << '.'
         << m_name << "]::patternSearch starting to match pattern " << pat;
+    uint32_t lo, hi;
+    if (prefixCodes(pat, lo, hi)) {
+        if (lo >= hi) return 0;
+
+        ibis::qContinuousRange expr(lo, ibis::qExpr::OP_LE, m_name.c_str(),
+                                    ibis::qExpr::OP_LT, hi);
+        return rlc->estimate(expr);
+    }
+
     long est = 0;
     ibis::array_t<uint32_t> tmp;
-    dic.patternSearch(pat, tmp);
+    patternCodes(pat, tmp);
     for (uint32_t j = 0; j < tmp.size(); ++ j) {
         const ibis::bitvector *bv = rlc->getBitvector(tmp[j]);
         if (bv != 0)
@@ -967,8 +985,23 @@ long ibis::category::patternSearch(const char *pat,
         << "category[" << (thePart != 0 ? thePart->name() : "??") << '.'
         << m_name << "]::patternSearch starting to match pattern " << pat;
 
+    uint32_t lo, hi;
+    if (prefixCodes(pat, lo, hi)) {
+        if (lo >= hi) {
+            hits.set(0, thePart->nRows());
+            return 0;
+        }
+
+        ibis::qContinuousRange expr(lo, ibis::qExpr::OP_LE, m_name.c_str(),
+                                    ibis::qExpr::OP_LT, hi);
+        long ierr = rlc->evaluate(expr, hits);
+        if (ierr >= 0)
+            return ierr;
+        hits.clear();
+    }
+
     ibis::array_t<uint32_t> tmp;
-    dic.patternSearch(pat, tmp);
+    patternCodes(pat, tmp);
     if (tmp.empty()) {
         hits.set(0, thePart->nRows());
         return 0;
@@ -979,6 +1012,183 @@ long ibis::category::patternSearch(const char *pat,
     }
 } // ibis::category::patternSearch
 
+/// Find the dictionary codes of the strings matching the SQL LIKE
+/// pattern.  If the index specification of the column asks for a trigram
+/// index (see ibis::ngram), the trigram index over the dictionary is used
+/// to select the candidates and only the candidates are compared against
+/// the pattern.  Otherwise, it calls ibis::dictionary::patternSearch to
+/// examine every entry of the dictionary.
+void ibis::category::patternCodes(const char *pat,
+                                  ibis::array_t<uint32_t> &codes) const {
+    if (strpbrk(pat, "%_*?") != 0 && ibis::ngram::requested(indexSpec())) {
+        mutexLock lock(this, "category::patternCodes");
+        try {
+            if (ngm == 0 || ngm->getNRows() != dic.size()) {
+                delete ngm;
+                ngm = 0;
+                ngm = new ibis::ngram(this, dic);
+            }
+
+            ibis::bitvector cand;
+            if (ngm->candidates(pat, cand) >= 0) {
+                for (ibis::bitvector::indexSet ix = cand.firstIndexSet();
+                     ix.nIndices() > 0; ++ ix) {
+                    const ibis::bitvector::word_t *ind = ix.indices();
+                    if (ix.isRange()) {
+                        for (uint32_t j = *ind; j < ind[1]; ++ j)
+                            if (dic[j] != 0 &&
+                                ibis::util::strMatch(dic[j], pat))
+                                codes.push_back(j);
+                    }
+                    else {
+                        for (uint32_t j = 0; j < ix.nIndices(); ++ j)
+                            if (dic[ind[j]] != 0 &&
+                                ibis::util::strMatch(dic[ind[j]], pat))
+                                codes.push_back(ind[j]);
+                    }
+                }
+                LOGGER(ibis::gVerbose > 5)
+                    << "category[" << fullname() << "]::patternCodes found "
+                    << codes.size() << " out of " << cand.cnt()
+                    << " candidate" << (cand.cnt()>1?"s":"")
+                    << " matching " << pat;
+                return;
+            }
+        }
+        catch (...) {
+            LOGGER(ibis::gVerbose > 1)
+                << "Warning -- category[" << fullname() << "]::patternCodes "
+                "failed to use the trigram index, examine the dictionary";
+            delete ngm;
+            ngm = 0;
+            codes.clear();
+        }
+    }
+    dic.patternSearch(pat, codes);
+} // ibis::category::patternCodes
+
+/// Determine the range of codes matching a LIKE pattern of the form
+/// 'abc%'.  This is only possible if the dictionary is sorted and the
+/// pattern consists of a literal prefix followed by nothing but the meta
+/// characters matching any number of characters.  Returns true if the
+/// range [lo, hi) is determined, otherwise false.
+bool ibis::category::prefixCodes(const char *pat, uint32_t &lo,
+                                 uint32_t &hi) const {
+    if (pat == 0 || *pat == 0 || ! dic.isSorted()) return false;
+
+    std::string prefix;
+    const char *ptr = pat;
+    for (; *ptr != 0; ++ ptr) {
+        if (*ptr == STRMATCH_META_ESCAPE) {
+            ++ ptr;
+            if (*ptr == 0) return false;
+            prefix += *ptr;
+        }
+        else if (*ptr == STRMATCH_META_CSH_ANY ||
+                 *ptr == STRMATCH_META_SQL_ANY) {
+            break;
+        }
+        else if (*ptr == STRMATCH_META_CSH_ONE ||
+                 *ptr == STRMATCH_META_SQL_ONE) {
+            return false;
+        }
+        else {
+            prefix += *ptr;
+        }
+    }
+    if (*ptr == 0 || prefix.empty()) return false;
+    for (; *ptr != 0; ++ ptr) {
+        if (*ptr != STRMATCH_META_CSH_ANY && *ptr != STRMATCH_META_SQL_ANY)
+            return false;
+    }
+
+    dic.prefixRange(prefix.c_str(), lo, hi);
+    LOGGER(ibis::gVerbose > 5)
+        << "category[" << fullname() << "]::prefixCodes translated " << pat
+        << " into codes [" << lo << ", " << hi << ')';
+    return true;
+} // ibis::category::prefixCodes
+
+/// Find the rows with string values in a lexicographic range.  The range
+/// is specified in the same way as ibis::qContinuousRange, i.e., as "lo lop
+/// value hop hi", where lop and hop can be either OP_LT or OP_LE.  Use
+/// OP_UNDEFINED (or a null string) to leave one end of the range open.
+/// Null values are not in any range.
+///
+/// This function requires the dictionary to be sorted, see
+/// orderedDictionaryRequested.  It returns the number of hits if
+/// successful, otherwise a negative number.
+long ibis::category::rangeSearch(const char *lo, ibis::qExpr::COMPARE lop,
+                                 const char *hi, ibis::qExpr::COMPARE hop,
+                                 ibis::bitvector &hits) const {
+    std::string evt = "category[";
+    evt += fullname();
+    evt += "]::rangeSearch";
+    if ((lop != ibis::qExpr::OP_LT && lop != ibis::qExpr::OP_LE &&
+         lop != ibis::qExpr::OP_UNDEFINED) ||
+        (hop != ibis::qExpr::OP_LT && hop != ibis::qExpr::OP_LE &&
+         hop != ibis::qExpr::OP_UNDEFINED)) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- " << evt << " can only use operators < and <=";
+        return -1;
+    }
+
+    ibis::util::timer mytimer(evt.c_str(), 4);
+    prepareMembers();
+    if (! dic.isSorted()) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- " << evt << " requires a sorted dictionary";
+        return -2;
+    }
+
+    const uint32_t c0 =
+        (lo == 0 || lop == ibis::qExpr::OP_UNDEFINED ? dic.lowerBound(0) :
+         lop == ibis::qExpr::OP_LE ? dic.lowerBound(lo) :
+         dic.upperBound(lo));
+    const uint32_t c1 =
+        (hi == 0 || hop == ibis::qExpr::OP_UNDEFINED ? dic.size() :
+         hop == ibis::qExpr::OP_LT ? dic.lowerBound(hi) :
+         dic.upperBound(hi));
+    if (c0 >= c1) {
+        hits.set(0, thePart->nRows());
+        return 0;
+    }
+
+    indexLock lock(this, evt.c_str());
+    if (idx == 0) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- " << evt << " can not proceed without an index";
+        return -3;
+    }
+
+    ibis::qContinuousRange expr(c0, ibis::qExpr::OP_LE, m_name.c_str(),
+                                ibis::qExpr::OP_LT, c1);
+    long ierr = idx->evaluate(expr, hits);
+    LOGGER(ierr < 0 && ibis::gVerbose > 1)
+        << "Warning -- " << evt << " failed because idx->evaluate(" << expr
+        << ") returned " << ierr;
+    return ierr;
+} // ibis::category::rangeSearch
+
+/// Should the dictionary codes follow the sorted order of the strings?
+/// This is requested with the keyword "ordered" in the index specification
+/// or the parameter <partition-name>.<column-name>.orderedDictionary.
+bool ibis::category::orderedDictionaryRequested() const {
+    const char* spec = indexSpec();
+    if (spec != 0 && *spec != 0 &&
+        (strstr(spec, "ordered") != 0 || strstr(spec, "Ordered") != 0 ||
+         strstr(spec, "ORDERED") != 0))
+        return true;
+    if (thePart == 0 || thePart->name() == 0)
+        return false;
+
+    std::string key = thePart->name();
+    key += '.';
+    key += m_name;
+    key += ".orderedDictionary";
+    return ibis::gParameters().isTrue(key.c_str());
+} // ibis::category::orderedDictionaryRequested
+
 /// Return the string at the <code>i</code>th row.  If the .int file is
 /// present, it will be used, otherwise this function uses the raw data
 /// file.
@@ -1461,7 +1671,96 @@ const char* ibis::category::isKey(const char* str) const {
 
 ////////////////////////////////////////////////////////////////////////
 // functions for ibis::text
-ibis::text::text(const part* tbl, FILE* file) : ibis::column(tbl, file) {
+
+/// Compute the hash value used by the hash index of a text column.  This
+/// is a 32-bit FNV-1a hash.  When the string comparisons are case
+/// insensitive, the bytes are folded to lower case before hashing so that
+/// strings equal under stricmp produce the same hash value.
+static uint32_t _ibis_text_hash(const char *str, size_t len) {
+    uint32_t h = 2166136261U;
+    for (size_t j = 0; j < len; ++ j) {
+#if FASTBIT_CASE_SENSITIVE_COMPARE+0 == 0
+        h ^= static_cast<unsigned char>(tolower(str[j]));
+#else
+        h ^= static_cast<unsigned char>(str[j]);
+#endif
+        h *= 16777619U;
+    }
+    return h;
+} // _ibis_text_hash
+
+/// The number of 32-bit words in the header of a hash index file.
+static const uint32_t _ibis_text_hashHeader = 7;
+
+/// Fill @c stamp with the size of the data file and the modification
+/// times of the data file and the .sp file, as three 64-bit values split
+/// into six 32-bit words.  The hash index records these values, so that
+/// it is rebuilt after the strings are rewritten, even when the number of
+/// rows stays the same.
+static void _ibis_text_hashStamp(const std::string& data,
+                                 const std::string& spfile,
+                                 uint32_t stamp[6]) {
+    uint64_t vals[3] = {0, 0, 0};
+    Stat_T st;
+    if (UnixStat(data.c_str(), &st) == 0) {
+        vals[0] = st.st_size;
+#if defined(__linux__)
+        vals[1] = static_cast<uint64_t>(st.st_mtim.tv_sec) * 1000000000U +
+            st.st_mtim.tv_nsec;
+#else
+        vals[1] = static_cast<uint64_t>(st.st_mtime);
+#endif
+    }
+    if (UnixStat(spfile.c_str(), &st) == 0) {
+#if defined(__linux__)
+        vals[2] = static_cast<uint64_t>(st.st_mtim.tv_sec) * 1000000000U +
+            st.st_mtim.tv_nsec;
+#else
+        vals[2] = static_cast<uint64_t>(st.st_mtime);
+#endif
+    }
+    for (int j = 0; j < 3; ++ j) {
+        stamp[j+j] = static_cast<uint32_t>(vals[j]);
+        stamp[j+j+1] = static_cast<uint32_t>(vals[j] >> 32);
+    }
+} // _ibis_text_hashStamp
+
+/// Is the hash index file @c hsfile current?  It must have the expected
+/// size and record the current state of the data file and the .sp file.
+static bool _ibis_text_hashCurrent(const std::string& hsfile,
+                                   const std::string& data,
+                                   const std::string& spfile,
+                                   uint32_t nrows) {
+    const off_t hsbytes = (2 * static_cast<off_t>(nrows) +
+                           _ibis_text_hashHeader) * sizeof(uint32_t);
+    if (ibis::util::getFileSize(hsfile.c_str()) != hsbytes)
+        return false;
+
+    uint32_t head[_ibis_text_hashHeader], stamp[6];
+    FILE *fhs = fopen(hsfile.c_str(), "rb");
+    if (fhs == 0) return false;
+    const size_t nread = fread(head, sizeof(uint32_t),
+                               _ibis_text_hashHeader, fhs);
+    fclose(fhs);
+    if (nread != _ibis_text_hashHeader || head[0] != nrows)
+        return false;
+    _ibis_text_hashStamp(data, spfile, stamp);
+    return (0 == memcmp(head+1, stamp, sizeof(stamp)));
+} // _ibis_text_hashCurrent
+
+/// Compare @c len bytes of a stored string against a search string.  The
+/// caller has already checked that the two strings have the same length.
+static inline bool _ibis_text_same(const char *val, const char *pat,
+                                   size_t len) {
+#if FASTBIT_CASE_SENSITIVE_COMPARE+0 == 0
+    return (len == 0 || strnicmp(val, pat, len) == 0);
+#else
+    return (len == 0 || std::memcmp(val, pat, len) == 0);
+#endif
+} // _ibis_text_same
+
+ibis::text::text(const part* tbl, FILE* file)
+    : ibis::column(tbl, file), ngm(0) {
 #ifdef FASTBIT_EAGER_INIT
     if (thePart != 0)
         startPositions(thePart->currentDataDir(), 0, 0);
@@ -1470,7 +1769,7 @@ ibis::text::text(const part* tbl, FILE* file) : ibis::column(tbl, file) {
 
 /// Construct a text object for a data partition with the given name.
 ibis::text::text(const part* tbl, const char* name, ibis::TYPE_T t)
-    : ibis::column(tbl, t, name) {
+    : ibis::column(tbl, t, name), ngm(0) {
 #ifdef FASTBIT_EAGER_INIT
     if (thePart != 0 && thePart->currentDataDir() != 0)
         startPositions(thePart->currentDataDir(), 0, 0);
@@ -1478,7 +1777,7 @@ ibis::text::text(const part* tbl, const char* name, ibis::TYPE_T t)
 }
 
 /// Copy constructor.  Copy from a column of the type TEXT.
-ibis::text::text(const ibis::column& col) : ibis::column(col) {
+ibis::text::text(const ibis::column& col) : ibis::column(col), ngm(0) {
     if (m_type != ibis::TEXT && m_type != ibis::CATEGORY) {
         throw ibis::bad_alloc("Must be either TEXT or CATEGORY -- text::ctor"
                               IBIS_FILE_LINE);
@@ -1489,6 +1788,12 @@ ibis::text::text(const ibis::column& col) : ibis::column(col) {
 #endif
 } // copy constructor
 
+/// Destructor.  Free the indexes.
+ibis::text::~text() {
+    unloadIndex();
+    delete ngm;
+} // ibis::text::~text
+
 /// Locate the starting position of each string.
 /// Using the data file located in the named directory @c dir.  If @c dir
 /// is a nil pointer, the directory defaults to the current working
@@ -1725,6 +2030,12 @@ void ibis::text::startPositions(const char *dir, char *buf,
     }
     (void) fclose(fdata);
     (void) fclose(fsp);
+    if (nnew > 0) { // the hash index no longer covers all the strings
+        std::string hsfile = dfile;
+        hsfile += ".hsh";
+        ibis::fileManager::instance().flushFile(hsfile.c_str());
+        (void) remove(hsfile.c_str());
+    }
 
     LOGGER(ibis::gVerbose > 3)
         << evt << " located the starting positions of " << nnew
@@ -1764,6 +2075,8 @@ void ibis::text::startPositions(const char *dir, char *buf,
 void ibis::text::loadIndex(const char* iopt, int ropt) const throw () {
     if (thePart != 0 && thePart->currentDataDir() != 0) {
         startPositions(thePart->currentDataDir(), 0, 0);
+        if (hashIndexRequested())
+            (void) hashPositions(thePart->currentDataDir());
         ibis::column::loadIndex(iopt, ropt);
     }
 } // ibis::text::loadIndex
@@ -1931,6 +2244,17 @@ long ibis::text::stringSearch(const std::vector<std::string>&) const {
 long ibis::text::stringSearch(const char* str, ibis::bitvector& hits) const {
     hits.clear(); // clear the existing content of hits
     if (thePart == 0) return -1L;
+    {   // try the hash index and the memory-mapped scan first
+        const std::vector<std::string> strs(1, std::string(str ? str : ""));
+        long ierr = -1;
+        if (hashIndexRequested())
+            ierr = hashSearch(strs, hits);
+        if (ierr < 0)
+            ierr = mappedSearch(strs, hits);
+        if (ierr >= 0)
+            return ierr;
+        hits.clear();
+    }
 
     std::string evt = "text[";
     if (thePart != 0 && thePart->name() != 0) {
@@ -2333,6 +2657,16 @@ long ibis::text::stringSearch(const std::vector<std::string>& strs,
 
     hits.clear();
     if (thePart == 0) return -1L;
+    {   // try the hash index and the memory-mapped scan first
+        long ierr = -1;
+        if (hashIndexRequested())
+            ierr = hashSearch(strs, hits);
+        if (ierr < 0)
+            ierr = mappedSearch(strs, hits);
+        if (ierr >= 0)
+            return ierr;
+        hits.clear();
+    }
 
     std::string evt = "text[";
     if (thePart != 0 && thePart->name() != 0) {
@@ -2535,7 +2869,520 @@ long ibis::text::stringSearch(const std::vector<std::string>& strs,
     return hits.cnt();
 } // ibis::text::stringSearch
 
-long ibis::text::patternSearch(const char*) const {
+/// Is the hash index for exact string matches requested?  The hash index
+/// is requested by including the keyword "hash" in the index
+/// specification of the column, or by setting the parameter
+/// <partition-name>.<column-name>.hashIndex to true.
+bool ibis::text::hashIndexRequested() const {
+    const char* spec = indexSpec();
+    if (spec != 0 && *spec != 0 &&
+        (strstr(spec, "hash") != 0 || strstr(spec, "Hash") != 0 ||
+         strstr(spec, "HASH") != 0))
+        return true;
+    if (thePart == 0 || thePart->name() == 0)
+        return false;
+
+    std::string key = thePart->name();
+    key += '.';
+    key += m_name;
+    key += ".hashIndex";
+    return ibis::gParameters().isTrue(key.c_str());
+} // ibis::text::hashIndexRequested
+
+/// Build the hash index for exact string matches.  The hash index is
+/// stored in a file with extension .hsh next to the .sp file.  It contains
+/// the number of rows and a stamp of the data files, followed by the hash
+/// values of all the strings in ascending order, followed by the row
+/// numbers in the same order.  All values are 32-bit unsigned integers.
+/// The stamp holds the size of the data file and the modification times
+/// of the data file and the .sp file.  The file is only generated if the
+/// existing one does not cover all the rows of the data partition or the
+/// strings have been rewritten since it was built.
+///
+/// Return 0 if the hash index is ready to be used, otherwise return a
+/// negative number to indicate error.
+int ibis::text::hashPositions(const char *dir) const {
+    if (thePart == 0) return -1;
+    if (dir == 0) // default to the current data directory
+        dir = thePart->currentDataDir();
+    if (dir == 0 || *dir == 0) return -1;
+
+    const uint32_t nrows = thePart->nRows();
+    std::string data = dir;
+    data += FASTBIT_DIRSEP;
+    data += m_name;
+    std::string spfile = data;
+    spfile += ".sp";
+    std::string hsfile = data;
+    hsfile += ".hsh";
+    const off_t hsbytes = (2 * static_cast<off_t>(nrows) +
+                           _ibis_text_hashHeader) * sizeof(uint32_t);
+    if (_ibis_text_hashCurrent(hsfile, data, spfile, nrows))
+        return 0;
+
+    std::string evt = "text[";
+    evt += fullname();
+    evt += "]::hashPositions";
+    const off_t spbytes = (static_cast<off_t>(nrows) + 1) * sizeof(int64_t);
+    if (ibis::util::getFileSize(spfile.c_str()) != spbytes) {
+        startPositions(dir, 0, 0);
+        if (ibis::util::getFileSize(spfile.c_str()) != spbytes) {
+            LOGGER(ibis::gVerbose > 1)
+                << "Warning -- " << evt << " expects file " << spfile
+                << " to have " << spbytes << " bytes, but it does not";
+            return -2;
+        }
+    }
+
+    mutexLock lock(this, "text::hashPositions");
+    if (_ibis_text_hashCurrent(hsfile, data, spfile, nrows))
+        return 0; // another thread has just built it
+
+    ibis::util::timer mytimer(evt.c_str(), 3);
+    ibis::fileManager::instance().flushFile(hsfile.c_str());
+    try {
+        const array_t<int64_t>
+            sp(spfile.c_str(), static_cast<off_t>(0), spbytes);
+        array_t<uint32_t> keys(nrows), rows(nrows);
+        if (sp.back() > 0) {
+            int fdata = UnixOpen(data.c_str(), OPEN_READONLY);
+            if (fdata < 0) {
+                LOGGER(ibis::gVerbose > 1)
+                    << "Warning -- " << evt << " failed to open data file "
+                    << data;
+                return -3;
+            }
+            IBIS_BLOCK_GUARD(UnixClose, fdata);
+#if defined(_WIN32) && defined(_MSC_VER)
+            (void)_setmode(fdata, _O_BINARY);
+#endif
+            const array_t<char> raw(data.c_str(), fdata, static_cast<off_t>(0),
+                                    static_cast<off_t>(sp.back()));
+            for (uint32_t j = 0; j < nrows; ++ j) {
+                const int64_t len = sp[j+1] - sp[j] - 1;
+                keys[j] = _ibis_text_hash(raw.begin()+sp[j],
+                                          (len > 0 ? len : 0));
+                rows[j] = j;
+            }
+            ibis::fileManager::instance().recordPages(0, sp.back());
+        }
+        else {
+            const uint32_t h0 = _ibis_text_hash("", 0);
+            for (uint32_t j = 0; j < nrows; ++ j) {
+                keys[j] = h0;
+                rows[j] = j;
+            }
+        }
+        ibis::util::sortKeys(keys, rows);
+
+        FILE *fhs = fopen(hsfile.c_str(), "wb");
+        if (fhs == 0) {
+            LOGGER(ibis::gVerbose > 1)
+                << "Warning -- " << evt << " failed to open file " << hsfile
+                << " for writing";
+            return -4;
+        }
+        uint32_t head[_ibis_text_hashHeader];
+        head[0] = nrows;
+        _ibis_text_hashStamp(data, spfile, head+1);
+        long ierr = fwrite(head, sizeof(uint32_t), _ibis_text_hashHeader,
+                           fhs);
+        if (ierr == static_cast<long>(_ibis_text_hashHeader))
+            ierr = keys.write(fhs);
+        if (ierr >= 0)
+            ierr = rows.write(fhs);
+        fclose(fhs);
+        if (ierr < 0 ||
+            ibis::util::getFileSize(hsfile.c_str()) != hsbytes) {
+            LOGGER(ibis::gVerbose > 1)
+                << "Warning -- " << evt << " failed to write " << hsbytes
+                << " bytes to " << hsfile;
+            (void) remove(hsfile.c_str());
+            return -5;
+        }
+    }
+    catch (...) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- " << evt << " failed to build the hash index due "
+            "to an exception";
+        (void) remove(hsfile.c_str());
+        return -6;
+    }
+
+    LOGGER(ibis::gVerbose > 3)
+        << evt << " wrote the hash values of " << nrows << " string"
+        << (nrows > 1 ? "s" : "") << " to " << hsfile;
+    return 0;
+} // ibis::text::hashPositions
+
+/// Locate the rows matching any of the given strings through the hash
+/// index.  The hash values narrow the search to a small number of
+/// candidate rows, and only these candidates are compared with the search
+/// strings.
+///
+/// Return the number of hits upon successful completion of this function,
+/// otherwise return a negative number to indicate error.
+long ibis::text::hashSearch(const std::vector<std::string>& strs,
+                            ibis::bitvector& hits) const {
+    hits.clear();
+    if (thePart == 0 || thePart->currentDataDir() == 0 ||
+        *(thePart->currentDataDir()) == 0) return -1L;
+    if (hashPositions(thePart->currentDataDir()) < 0) return -2L;
+
+    std::string evt = "text[";
+    evt += fullname();
+    evt += "]::hashSearch";
+    ibis::util::timer mytimer(evt.c_str(), 4);
+    const uint32_t nrows = thePart->nRows();
+    std::string data = thePart->currentDataDir();
+    data += FASTBIT_DIRSEP;
+    data += m_name;
+    std::string hsfile = data;
+    hsfile += ".hsh";
+    array_t<uint32_t> hs;
+    int ierr = ibis::fileManager::instance().getFile(hsfile.c_str(), hs);
+    if (ierr != 0 || hs.size() != 2*nrows+_ibis_text_hashHeader ||
+        hs[0] != nrows) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- " << evt << " failed to read the hash index from "
+            << hsfile;
+        return -3L;
+    }
+
+    const array_t<uint32_t> keys(hs, _ibis_text_hashHeader,
+                                 nrows+_ibis_text_hashHeader);
+    const array_t<uint32_t> rows(hs, nrows+_ibis_text_hashHeader,
+                                 2*nrows+_ibis_text_hashHeader);
+    // candidates are pairs of (row number, string number)
+    std::vector< std::pair<uint32_t, uint32_t> > cand;
+    for (uint32_t i = 0; i < strs.size(); ++ i) {
+        const uint32_t h = _ibis_text_hash(strs[i].data(), strs[i].size());
+        for (const uint32_t *it = std::lower_bound(keys.begin(),
+                                                   keys.end(), h);
+             it < keys.end() && *it == h; ++ it)
+            cand.push_back(std::make_pair(rows[it-keys.begin()], i));
+    }
+    if (cand.empty()) {
+        hits.set(0, nrows);
+        return 0L;
+    }
+    std::sort(cand.begin(), cand.end());
+
+    // verify the candidates against the actual string values
+    std::string spfile = data;
+    spfile += ".sp";
+    try {
+        const array_t<int64_t> sp(spfile.c_str(), static_cast<off_t>(0),
+                                  static_cast<off_t>((nrows+1) *
+                                                     sizeof(int64_t)));
+        if (sp.back() > 0) {
+            int fdata = UnixOpen(data.c_str(), OPEN_READONLY);
+            if (fdata < 0) {
+                LOGGER(ibis::gVerbose > 1)
+                    << "Warning -- " << evt << " failed to open data file "
+                    << data;
+                return -4L;
+            }
+            IBIS_BLOCK_GUARD(UnixClose, fdata);
+#if defined(_WIN32) && defined(_MSC_VER)
+            (void)_setmode(fdata, _O_BINARY);
+#endif
+            const array_t<char> raw(data.c_str(), fdata, static_cast<off_t>(0),
+                                    static_cast<off_t>(sp.back()));
+            for (size_t j = 0; j < cand.size(); ++ j) {
+                const uint32_t irow = cand[j].first;
+                const std::string &str = strs[cand[j].second];
+                if (sp[irow+1] - sp[irow] ==
+                    static_cast<int64_t>(str.size()+1) &&
+                    _ibis_text_same(raw.begin()+sp[irow], str.data(),
+                                    str.size()))
+                    hits.setBit(irow, 1);
+            }
+        }
+        else { // all strings are empty
+            for (size_t j = 0; j < cand.size(); ++ j) {
+                if (strs[cand[j].second].empty())
+                    hits.setBit(cand[j].first, 1);
+            }
+        }
+    }
+    catch (...) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- " << evt << " failed to map the data file "
+            << data << ", will read the candidates one at a time";
+        hits.clear();
+        std::string tmp;
+        for (size_t j = 0; j < cand.size(); ++ j) {
+            if (readString(cand[j].first, tmp) < 0) {
+                hits.clear();
+                return -5L;
+            }
+#if FASTBIT_CASE_SENSITIVE_COMPARE+0 == 0
+            if (stricmp(tmp.c_str(), strs[cand[j].second].c_str()) == 0)
+#else
+            if (tmp == strs[cand[j].second])
+#endif
+                hits.setBit(cand[j].first, 1);
+        }
+    }
+    hits.adjustSize(0, nrows);
+
+    LOGGER(ibis::gVerbose > 4)
+        << evt << " found " << hits.cnt() << " string"
+        << (hits.cnt()>1?"s":"") << " in \"" << data << "\" after checking "
+        << cand.size() << " candidate" << (cand.size()>1?"s":"")
+        << " from the hash index";
+    return hits.cnt();
+} // ibis::text::hashSearch
+
+/// Locate the rows matching any of the given strings by scanning the data
+/// file through a memory map.  The starting positions in the .sp file
+/// determine the length of every string, therefore only the strings with
+/// the same length as one of the search strings are actually compared.
+/// The length checks run over a contiguous array of integers and the
+/// comparisons use memcmp (or strnicmp), avoiding the per-row bookkeeping
+/// of the buffered reads.
+///
+/// Return the number of hits upon successful completion of this function,
+/// otherwise return a negative number.  The caller is expected to fall
+/// back to the buffered reads if this function fails, e.g., when the data
+/// file can not be mapped into memory.
+long ibis::text::mappedSearch(const std::vector<std::string>& strs,
+                              ibis::bitvector& hits) const {
+    hits.clear();
+    if (thePart == 0 || thePart->currentDataDir() == 0 ||
+        *(thePart->currentDataDir()) == 0 || strs.empty()) return -1L;
+
+    const uint32_t nrows = thePart->nRows();
+    std::string evt = "text[";
+    evt += fullname();
+    evt += "]::mappedSearch";
+    ibis::util::timer mytimer(evt.c_str(), 4);
+    std::string data = thePart->currentDataDir();
+    data += FASTBIT_DIRSEP;
+    data += m_name;
+    std::string spfile = data;
+    spfile += ".sp";
+    const off_t spbytes = (static_cast<off_t>(nrows) + 1) * sizeof(int64_t);
+    if (ibis::util::getFileSize(spfile.c_str()) != spbytes) {
+        startPositions(thePart->currentDataDir(), 0, 0);
+        if (ibis::util::getFileSize(spfile.c_str()) != spbytes) {
+            LOGGER(ibis::gVerbose > 2)
+                << "Warning -- " << evt << " expects file " << spfile
+                << " to have " << spbytes << " bytes, but it does not";
+            return -2L;
+        }
+    }
+
+    // pairs of (string length including the terminator, string number)
+    std::vector< std::pair<int64_t, uint32_t> > lens(strs.size());
+    for (uint32_t i = 0; i < strs.size(); ++ i)
+        lens[i] = std::make_pair(static_cast<int64_t>(strs[i].size()+1), i);
+    std::sort(lens.begin(), lens.end());
+    const int64_t minlen = lens.front().first;
+    const int64_t maxlen = lens.back().first;
+
+    try {
+        const array_t<int64_t> sp(spfile.c_str(), static_cast<off_t>(0),
+                                  spbytes);
+        if (sp.front() != 0 || sp.back() <= 0 ||
+            ibis::util::getFileSize(data.c_str()) < sp.back())
+            return -3L;
+
+        int fdata = UnixOpen(data.c_str(), OPEN_READONLY);
+        if (fdata < 0) {
+            LOGGER(ibis::gVerbose > 1)
+                << "Warning -- " << evt << " failed to open data file "
+                << data;
+            return -4L;
+        }
+        IBIS_BLOCK_GUARD(UnixClose, fdata);
+#if defined(_WIN32) && defined(_MSC_VER)
+        (void)_setmode(fdata, _O_BINARY);
+#endif
+        const array_t<char> raw(data.c_str(), fdata, static_cast<off_t>(0),
+                                static_cast<off_t>(sp.back()));
+        const char *buf = raw.begin();
+        if (lens.size() == 1) { // the common case of a single string
+            const char *pat = strs[0].data();
+            for (uint32_t irow = 0; irow < nrows; ++ irow) {
+                if (sp[irow+1] - sp[irow] == minlen &&
+                    _ibis_text_same(buf+sp[irow], pat, minlen-1))
+                    hits.setBit(irow, 1);
+            }
+        }
+        else {
+            for (uint32_t irow = 0; irow < nrows; ++ irow) {
+                const int64_t len = sp[irow+1] - sp[irow];
+                if (len < minlen || len > maxlen) continue;
+
+                for (std::vector< std::pair<int64_t, uint32_t> >::
+                         const_iterator it = std::lower_bound
+                         (lens.begin(), lens.end(), std::make_pair(len, 0U));
+                     it != lens.end() && it->first == len; ++ it) {
+                    if (_ibis_text_same(buf+sp[irow],
+                                        strs[it->second].data(), len-1)) {
+                        hits.setBit(irow, 1);
+                        break;
+                    }
+                }
+            }
+        }
+        ibis::fileManager::instance().recordPages(0, sp.back());
+        ibis::fileManager::instance().recordPages(0, spbytes);
+    }
+    catch (...) {
+        LOGGER(ibis::gVerbose > 2)
+            << "Warning -- " << evt << " failed to map data file " << data;
+        hits.clear();
+        return -5L;
+    }
+    hits.adjustSize(0, nrows);
+
+    LOGGER(ibis::gVerbose > 4)
+        << evt << " found " << hits.cnt() << " string"
+        << (hits.cnt()>1?"s":"") << " in \"" << data << "\" matching "
+        << strs.size() << " string" << (strs.size()>1?"s":"");
+    return hits.cnt();
+} // ibis::text::mappedSearch
+
+/// Compare the candidates marked in @c cand against a SQL LIKE pattern.
+/// The data file and the starting positions are mapped into memory and
+/// only the strings marked 1 in @c cand are examined.  Returns the number
+/// of hits on success, otherwise a negative number.
+long ibis::text::mappedSearch(const char* pat, const ibis::bitvector& cand,
+                              ibis::bitvector& hits) const {
+    hits.clear();
+    if (thePart == 0 || thePart->currentDataDir() == 0 ||
+        *(thePart->currentDataDir()) == 0 || pat == 0) return -1L;
+
+    const uint32_t nrows = thePart->nRows();
+    if (cand.sloppyCount() == 0) {
+        hits.set(0, nrows);
+        return 0L;
+    }
+
+    std::string evt = "text[";
+    evt += fullname();
+    evt += "]::mappedSearch(";
+    evt += pat;
+    evt += ')';
+    ibis::util::timer mytimer(evt.c_str(), 4);
+    std::string data = thePart->currentDataDir();
+    data += FASTBIT_DIRSEP;
+    data += m_name;
+    std::string spfile = data;
+    spfile += ".sp";
+    const off_t spbytes = (static_cast<off_t>(nrows) + 1) * sizeof(int64_t);
+    if (ibis::util::getFileSize(spfile.c_str()) != spbytes) {
+        startPositions(thePart->currentDataDir(), 0, 0);
+        if (ibis::util::getFileSize(spfile.c_str()) != spbytes) {
+            LOGGER(ibis::gVerbose > 2)
+                << "Warning -- " << evt << " expects file " << spfile
+                << " to have " << spbytes << " bytes, but it does not";
+            return -2L;
+        }
+    }
+
+    try {
+        const array_t<int64_t> sp(spfile.c_str(), static_cast<off_t>(0),
+                                  spbytes);
+        if (sp.front() != 0 || sp.back() <= 0 ||
+            ibis::util::getFileSize(data.c_str()) < sp.back())
+            return -3L;
+
+        int fdata = UnixOpen(data.c_str(), OPEN_READONLY);
+        if (fdata < 0) {
+            LOGGER(ibis::gVerbose > 1)
+                << "Warning -- " << evt << " failed to open data file "
+                << data;
+            return -4L;
+        }
+        IBIS_BLOCK_GUARD(UnixClose, fdata);
+#if defined(_WIN32) && defined(_MSC_VER)
+        (void)_setmode(fdata, _O_BINARY);
+#endif
+        const array_t<char> raw(data.c_str(), fdata, static_cast<off_t>(0),
+                                static_cast<off_t>(sp.back()));
+        const char *buf = raw.begin();
+        for (ibis::bitvector::indexSet ix = cand.firstIndexSet();
+             ix.nIndices() > 0; ++ ix) {
+            const ibis::bitvector::word_t *ind = ix.indices();
+            if (ix.isRange()) {
+                for (uint32_t irow = *ind; irow < ind[1] && irow < nrows;
+                     ++ irow) {
+                    if (ibis::util::strMatch(buf+sp[irow], pat))
+                        hits.setBit(irow, 1);
+                }
+            }
+            else {
+                for (uint32_t j = 0; j < ix.nIndices(); ++ j) {
+                    if (ind[j] < nrows &&
+                        ibis::util::strMatch(buf+sp[ind[j]], pat))
+                        hits.setBit(ind[j], 1);
+                }
+            }
+        }
+    }
+    catch (...) {
+        LOGGER(ibis::gVerbose > 2)
+            << "Warning -- " << evt << " failed to map data file " << data;
+        hits.clear();
+        return -5L;
+    }
+    hits.adjustSize(0, nrows);
+
+    LOGGER(ibis::gVerbose > 4)
+        << evt << " found " << hits.cnt() << " string"
+        << (hits.cnt()>1?"s":"") << " out of " << cand.cnt()
+        << " candidate" << (cand.cnt()>1?"s":"");
+    return hits.cnt();
+} // ibis::text::mappedSearch
+
+/// Select the candidates for a LIKE pattern with the trigram index.  The
+/// trigram index is read from its own file or built from the data file on
+/// first use, and is rebuilt when the number of rows changes.  It returns
+/// the number of candidates, or a negative value if the trigram index is
+/// not requested or can not narrow down the search.
+long ibis::text::ngramCandidates(const char* pat,
+                                 ibis::bitvector& cand) const {
+    if (thePart == 0 || pat == 0 || ! ibis::ngram::requested(indexSpec()))
+        return -1L;
+
+    try {
+        { // the bitmaps are read with the mutex of the column, therefore
+          // the trigram index is guarded by the read-write lock
+            readLock lock(this, "text::ngramCandidates");
+            if (ngm != 0 && ngm->getNRows() == thePart->nRows())
+                return ngm->candidates(pat, cand);
+        }
+        {
+            writeLock lock(this, "text::ngramCandidates");
+            if (ngm == 0 || ngm->getNRows() != thePart->nRows()) {
+                delete ngm;
+                ngm = 0;
+                ngm = new ibis::ngram(this);
+            }
+        }
+        readLock lock(this, "text::ngramCandidates");
+        if (ngm != 0)
+            return ngm->candidates(pat, cand);
+    }
+    catch (...) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- text[" << fullname() << "]::ngramCandidates "
+            "failed to use the trigram index";
+    }
+    return -2L;
+} // ibis::text::ngramCandidates
+
+/// Estimate an upper bound on the number of strings matching the pattern.
+/// If a trigram index is available, the number of candidates selected by
+/// the index is returned, otherwise the number of rows.
+long ibis::text::patternSearch(const char* pat) const {
+    ibis::bitvector cand;
+    if (ngramCandidates(pat, cand) >= 0)
+        return cand.cnt();
     return (thePart ? thePart->nRows() : INT_MAX);
 } // ibis::text::patternSearch
 
@@ -2551,6 +3398,18 @@ long ibis::text::patternSearch(const char* pat, ibis::bitvector& hits) const {
     evt += m_name;
     evt += "]::patternSearch";
     ibis::util::timer mytimer(evt.c_str(), 4);
+    {
+        // use the trigram index to select the candidates
+        ibis::bitvector cand;
+        long ierr = ngramCandidates(pat, cand);
+        if (ierr >= 0) {
+            ierr = mappedSearch(pat, cand, hits);
+            if (ierr >= 0)
+                return ierr;
+            hits.clear();
+        }
+    }
+
     std::string data = thePart->currentDataDir();
     data += FASTBIT_DIRSEP;
     data += m_name;
@@ -3851,6 +4710,10 @@ long ibis::text::saveSelected(const ibis::bitvector& sel, const char *dest,
             }
         }
         ibis::fileManager::instance().flushFile(fname.c_str());
+        std::string hname = fname;
+        hname += ".hsh"; // the hash index is rebuilt when needed
+        ibis::fileManager::instance().flushFile(hname.c_str());
+        (void) remove(hname.c_str());
 
         ierr = rename(fname.c_str(), gname.c_str());
         if (ierr != 0) {
@@ -3884,6 +4747,10 @@ long ibis::text::saveSelected(const ibis::bitvector& sel, const char *dest,
         tname += ".sp";
 
         purgeIndexFile(dest);
+        std::string hname = fname;
+        hname += ".hsh";
+        ibis::fileManager::instance().flushFile(hname.c_str());
+        (void) remove(hname.c_str());
         readLock lock(this, "saveSelected");
         ierr = writeStrings(fname.c_str(), gname.c_str(),
                             sname.c_str(), tname.c_str(),
@@ -21,12 +21,15 @@
 /// structure.  The most useful search operation supported on this type of
 /// data is the keyword search, also known as full-text search.  The
 /// keyword search operation is implemented through a boolean term-document
-/// matrix (implemented as ibis::keywords).
+/// matrix (implemented as ibis::keywords).  If the index specification
+/// asks for a trigram index, an ibis::ngram is kept next to the keyword
+/// index to narrow down the LIKE searches.
 ///
 /// @sa ibis::keywords
+/// @sa ibis::ngram
 class ibis::text : public ibis::column {
 public:
-    virtual ~text() {unloadIndex();};
+    virtual ~text();
     text(const part* tbl, FILE* file);
     text(const part* tbl, const char* name, ibis::TYPE_T t=ibis::TEXT);
     text(const ibis::column& col); // copy from column
@@ -46,6 +49,8 @@ public:
     virtual long patternSearch(const char*, ibis::bitvector&) const;
     virtual long patternSearch(const char*) const;
 
+    bool hashIndexRequested() const;
+
     using ibis::column::estimateCost;
     virtual double estimateCost(const ibis::qString& cmp) const;
     virtual double estimateCost(const ibis::qAnyString& cmp) const;
@@ -95,8 +100,21 @@ public:
     }; // struct tokenizer
 
 protected:
+    /// The trigram index.  For a text column, it is a companion of the
+    /// keyword index stored in its own file and is guarded by the
+    /// read-write lock of the column.  For a category column, it is built
+    /// over the dictionary in memory and is guarded by the mutex of the
+    /// column.
+    mutable ibis::ngram *ngm;
 
     void startPositions(const char *dir, char *buf, uint32_t nbuf) const;
+    int  hashPositions(const char *dir) const;
+    long hashSearch(const std::vector<std::string>&, ibis::bitvector&) const;
+    long mappedSearch(const std::vector<std::string>&,
+		      ibis::bitvector&) const;
+    long mappedSearch(const char*, const ibis::bitvector&,
+		      ibis::bitvector&) const;
+    long ngramCandidates(const char*, ibis::bitvector&) const;
     int  readString(uint32_t i, std::string &val) const;
     int  readString(std::string&, int, long, long, char*, uint32_t,
 		    uint32_t&, off_t&) const;
@@ -116,6 +134,13 @@ private:
 /// string values into bitvectors (as ibis::direkte), and does not store
 /// integer version of the string.
 ///
+/// If the keyword "ordered" appears in the index specification, the
+/// integer codes are reassigned in the ascending order of the strings
+/// whenever the index is built.  With such a sorted dictionary, a LIKE
+/// pattern of the form 'abc%' and a lexicographic range (see rangeSearch)
+/// each correspond to a single range of codes, and are answered with one
+/// ibis::qContinuousRange on the index.
+///
 /// @note The integer zero (0) is reserved for NULL values.
 class ibis::category : public ibis::text {
 public:
@@ -145,6 +170,11 @@ public:
 
     virtual long patternSearch(const char* pat) const;
     virtual long patternSearch(const char* pat, ibis::bitvector &hits) const;
+    long rangeSearch(const char* lo, ibis::qExpr::COMPARE lop,
+                     const char* hi, ibis::qExpr::COMPARE hop,
+                     ibis::bitvector &hits) const;
+
+    bool orderedDictionaryRequested() const;
 
     using ibis::text::estimateCost;
     virtual double estimateCost(const ibis::qLike& cmp) const;
@@ -185,6 +215,8 @@ private:
     // private member functions
     void prepareMembers() const;
     void readDictionary(const char *dir=0) const;
+    void patternCodes(const char *pat, array_t<uint32_t> &codes) const;
+    bool prefixCodes(const char *pat, uint32_t &lo, uint32_t &hi) const;
 
     category& operator=(const category&);
 }; // ibis::category
@@ -0,0 +1,1199 @@
+// File $Id$
+// Author: John Wu <John.Wu at ACM.org>
+//      Lawrence Berkeley National Laboratory
+// Copyright (c) 2007-2016 the Regents of the University of California
+//
+// This file contains the functions to pack and unpack the raw data files
+// of fixed-size columns.  See colpack.h for a description of the format.
+#include "colpack.h"    // ibis::colpack
+#include "fileManager.h"
+#include "qExpr.h"      // ibis::qContinuousRange
+
+#include <typeinfo>     // typeid
+#include <limits>       // std::numeric_limits
+#include <algorithm>    // std::lower_bound
+#include <cmath>        // std::floor
+
+/// The number of rows in a block of a packed data file.
+#ifndef FASTBIT_PACK_BLOCK_SIZE
+#define FASTBIT_PACK_BLOCK_SIZE 4096
+#endif
+
+namespace ibis {
+    namespace colpack {
+        /// The content of the header of a packed data file.
+        struct header {
+            uint32_t nrows;   ///!< Number of rows.
+            uint32_t bsize;   ///!< Number of rows per block.
+            uint32_t nblocks; ///!< Number of blocks.
+            unsigned elsize;  ///!< Size of a value in bytes.
+            /// Starting positions (in bytes) of the blocks, followed by
+            /// the size of the file.
+            ibis::array_t<uint64_t> offsets;
+        }; // header
+    } // namespace colpack
+} // namespace ibis
+
+/// The first eight bytes of a packed data file.
+static const char _ibis_colpack_magic[] = "#IBISPK1";
+
+/// Number of bits needed to represent the value @c x.
+static inline unsigned _ibis_colpack_width(uint64_t x) {
+    unsigned w = 0;
+    while (x != 0) {
+        ++ w;
+        x >>= 1;
+    }
+    return w;
+} // _ibis_colpack_width
+
+/// Pack the differences between @c n values and @c ref using @c w bits
+/// each.  The array @c words must have room for (n*w+63)/64+1 words and
+/// be filled with zero.
+template <typename U>
+static void _ibis_colpack_bitpack(const U* in, uint32_t n, U ref, unsigned w,
+                                  uint64_t* words) {
+    if (w == 0) return;
+    for (uint32_t i = 0; i < n; ++ i) {
+        const uint64_t v = static_cast<U>(in[i] - ref);
+        const uint64_t pos = static_cast<uint64_t>(i) * w;
+        const unsigned sh = static_cast<unsigned>(pos & 63);
+        words[pos >> 6] |= (v << sh);
+        if (sh + w > 64)
+            words[(pos >> 6) + 1] |= (v >> (64 - sh));
+    }
+} // _ibis_colpack_bitpack
+
+/// Unpack @c n values packed with @c w bits each and add @c ref to them.
+/// Every value is assembled from two consecutive words without a branch,
+/// which is why a packed array carries one extra word at the end.  The
+/// loop has no dependency between iterations and is vectorized by the
+/// compilers that support gather operations.
+template <typename U>
+static void _ibis_colpack_unpack(const uint64_t* words, unsigned w,
+                                 uint32_t n, U ref, U* out) {
+    if (w == 0) {
+        for (uint32_t i = 0; i < n; ++ i)
+            out[i] = ref;
+        return;
+    }
+
+    const uint64_t mask = (w < 64 ? ((static_cast<uint64_t>(1) << w) - 1)
+                           : ~static_cast<uint64_t>(0));
+    for (uint32_t i = 0; i < n; ++ i) {
+        const uint64_t pos = static_cast<uint64_t>(i) * w;
+        const unsigned sh = static_cast<unsigned>(pos & 63);
+        const uint64_t lo = words[pos >> 6];
+        const uint64_t hi = words[(pos >> 6) + 1];
+        // (hi << 1) << (63 - sh) is hi << (64 - sh), and zero for sh = 0
+        out[i] = ref + static_cast<U>(((lo >> sh) | ((hi << 1) << (63 - sh)))
+                                      & mask);
+    }
+} // _ibis_colpack_unpack
+
+/// Encode a block of @c n values.  The type @c S is the type of the
+/// values and determines the order used to find the minimum and to check
+/// whether the values are sorted, @c U is the unsigned integer type of the
+/// same size.  The encoded block is placed in @c blk, which starts with
+/// three words: (method | width << 8 | n << 32), the reference value and
+/// a second reference value.
+template <typename S, typename U>
+static void _ibis_colpack_encode(const S* vals, uint32_t n,
+                                 ibis::array_t<uint64_t>& blk) {
+    const U* uvals = reinterpret_cast<const U*>(vals);
+    S vmin = vals[0], vmax = vals[0];
+    U dmin = 0, dmax = 0;
+    bool sorted = true;
+    uint32_t nruns = 1;
+    if (n > 1) {
+        dmin = static_cast<U>(uvals[1] - uvals[0]);
+        dmax = dmin;
+    }
+    for (uint32_t i = 1; i < n; ++ i) {
+        if (vals[i] < vmin)
+            vmin = vals[i];
+        else if (vals[i] > vmax)
+            vmax = vals[i];
+        if (vals[i] != vals[i-1])
+            ++ nruns;
+        if (sorted) {
+            if (vals[i] < vals[i-1]) {
+                sorted = false;
+            }
+            else {
+                const U d = static_cast<U>(uvals[i] - uvals[i-1]);
+                if (d < dmin)
+                    dmin = d;
+                else if (d > dmax)
+                    dmax = d;
+            }
+        }
+    }
+
+    const U umin = static_cast<U>(vmin);
+    const unsigned wfor =
+        _ibis_colpack_width(static_cast<U>(static_cast<U>(vmax) - umin));
+    const unsigned wdel = (sorted && n > 1 ?
+                           _ibis_colpack_width(static_cast<U>(dmax - dmin))
+                           : 64);
+    const size_t sraw = (n * sizeof(U) + 7) / 8;
+    const size_t sfor = (static_cast<uint64_t>(n) * wfor + 63) / 64 + 1;
+    const size_t sdel = (sorted && n > 1 ?
+                         (static_cast<uint64_t>(n-1) * wdel + 63) / 64 + 1 :
+                         sraw + 1);
+    const size_t srle = (nruns * sizeof(U) + 7) / 8 + (nruns * 4 + 7) / 8;
+
+    ibis::colpack::METHOD m = ibis::colpack::RAW;
+    size_t sz = sraw;
+    if (sfor < sz) {
+        m = ibis::colpack::FOR;
+        sz = sfor;
+    }
+    if (sdel < sz) {
+        m = ibis::colpack::DELTA;
+        sz = sdel;
+    }
+    if (srle < sz) {
+        m = ibis::colpack::RLE;
+        sz = srle;
+    }
+
+    blk.resize(3 + sz);
+    for (size_t j = 0; j < blk.size(); ++ j)
+        blk[j] = 0;
+    uint64_t* payload = blk.begin() + 3;
+    switch (m) {
+    default:
+    case ibis::colpack::RAW: {
+        blk[0] = static_cast<uint64_t>(m) | (static_cast<uint64_t>(n) << 32);
+        memcpy(payload, vals, n * sizeof(U));
+        break;}
+    case ibis::colpack::FOR: {
+        blk[0] = static_cast<uint64_t>(m) | (wfor << 8) |
+            (static_cast<uint64_t>(n) << 32);
+        blk[1] = umin;
+        _ibis_colpack_bitpack(uvals, n, umin, wfor, payload);
+        break;}
+    case ibis::colpack::DELTA: {
+        blk[0] = static_cast<uint64_t>(m) | (wdel << 8) |
+            (static_cast<uint64_t>(n) << 32);
+        blk[1] = uvals[0];
+        blk[2] = dmin;
+        ibis::array_t<U> diff(n-1);
+        for (uint32_t i = 1; i < n; ++ i)
+            diff[i-1] = static_cast<U>(uvals[i] - uvals[i-1]);
+        _ibis_colpack_bitpack(diff.begin(), n-1, dmin, wdel, payload);
+        break;}
+    case ibis::colpack::RLE: {
+        blk[0] = static_cast<uint64_t>(m) | (static_cast<uint64_t>(n) << 32);
+        blk[2] = nruns;
+        U* rv = reinterpret_cast<U*>(payload);
+        uint32_t* rl = reinterpret_cast<uint32_t*>
+            (payload + (nruns * sizeof(U) + 7) / 8);
+        uint32_t k = 0;
+        rv[0] = uvals[0];
+        rl[0] = 1;
+        for (uint32_t i = 1; i < n; ++ i) {
+            if (uvals[i] == rv[k]) {
+                ++ rl[k];
+            }
+            else {
+                ++ k;
+                rv[k] = uvals[i];
+                rl[k] = 1;
+            }
+        }
+        break;}
+    }
+} // _ibis_colpack_encode
+
+/// Decode a block of @c nw words into at most @c cap values.  Return the
+/// number of values decoded or a negative number to indicate error.
+template <typename U>
+static long _ibis_colpack_decode(const uint64_t* blk, size_t nw, U* out,
+                                 uint32_t cap) {
+    if (nw < 3) return -1;
+    const unsigned m = static_cast<unsigned>(blk[0] & 255);
+    const unsigned w = static_cast<unsigned>((blk[0] >> 8) & 255);
+    const uint32_t n = static_cast<uint32_t>(blk[0] >> 32);
+    if (n > cap || w > 64) return -2;
+    if (n == 0) return 0;
+
+    const uint64_t* payload = blk + 3;
+    switch (m) {
+    case ibis::colpack::RAW: {
+        if (nw < 3 + (n * sizeof(U) + 7) / 8) return -3;
+        memcpy(out, payload, n * sizeof(U));
+        break;}
+    case ibis::colpack::FOR: {
+        if (nw < 3 + (static_cast<uint64_t>(n) * w + 63) / 64 + 1) return -3;
+        _ibis_colpack_unpack(payload, w, n, static_cast<U>(blk[1]), out);
+        break;}
+    case ibis::colpack::DELTA: {
+        if (nw < 3 + (static_cast<uint64_t>(n-1) * w + 63) / 64 + 1)
+            return -3;
+        out[0] = static_cast<U>(blk[1]);
+        _ibis_colpack_unpack(payload, w, n-1, static_cast<U>(blk[2]), out+1);
+        for (uint32_t i = 1; i < n; ++ i)
+            out[i] += out[i-1];
+        break;}
+    case ibis::colpack::RLE: {
+        const uint64_t nruns = blk[2];
+        if (nruns > n ||
+            nw < 3 + (nruns * sizeof(U) + 7) / 8 + (nruns * 4 + 7) / 8)
+            return -3;
+        const U* rv = reinterpret_cast<const U*>(payload);
+        const uint32_t* rl = reinterpret_cast<const uint32_t*>
+            (payload + (nruns * sizeof(U) + 7) / 8);
+        uint32_t i = 0;
+        for (uint64_t k = 0; k < nruns; ++ k) {
+            if (rl[k] > n - i) return -4;
+            const U v = rv[k];
+            for (uint32_t j = 0; j < rl[k]; ++ j, ++ i)
+                out[i] = v;
+        }
+        if (i != n) return -4;
+        break;}
+    default:
+        return -5;
+    }
+    return n;
+} // _ibis_colpack_decode
+
+/// Decode a block according to the element size.
+static long _ibis_colpack_decode(const uint64_t* blk, size_t nw,
+                                 unsigned elsize, void* out, uint32_t cap) {
+    switch (elsize) {
+    case 1:
+        return _ibis_colpack_decode(blk, nw, static_cast<uint8_t*>(out), cap);
+    case 2:
+        return _ibis_colpack_decode(blk, nw, static_cast<uint16_t*>(out), cap);
+    case 4:
+        return _ibis_colpack_decode(blk, nw, static_cast<uint32_t*>(out), cap);
+    case 8:
+        return _ibis_colpack_decode(blk, nw, static_cast<uint64_t*>(out), cap);
+    default:
+        return -6;
+    }
+} // _ibis_colpack_decode
+
+/// Encode a block according to the data type.  Floating-point values are
+/// encoded through their bit patterns.  Return 0 on success, a negative
+/// number if the type is not supported.
+static int _ibis_colpack_encode(ibis::TYPE_T t, const void* vals, uint32_t n,
+                                ibis::array_t<uint64_t>& blk) {
+    switch (t) {
+    case ibis::BYTE:
+        _ibis_colpack_encode<signed char, uint8_t>
+            (static_cast<const signed char*>(vals), n, blk);
+        break;
+    case ibis::UBYTE:
+        _ibis_colpack_encode<uint8_t, uint8_t>
+            (static_cast<const uint8_t*>(vals), n, blk);
+        break;
+    case ibis::SHORT:
+        _ibis_colpack_encode<int16_t, uint16_t>
+            (static_cast<const int16_t*>(vals), n, blk);
+        break;
+    case ibis::USHORT:
+        _ibis_colpack_encode<uint16_t, uint16_t>
+            (static_cast<const uint16_t*>(vals), n, blk);
+        break;
+    case ibis::INT:
+        _ibis_colpack_encode<int32_t, uint32_t>
+            (static_cast<const int32_t*>(vals), n, blk);
+        break;
+    case ibis::UINT:
+    case ibis::FLOAT:
+        _ibis_colpack_encode<uint32_t, uint32_t>
+            (static_cast<const uint32_t*>(vals), n, blk);
+        break;
+    case ibis::LONG:
+        _ibis_colpack_encode<int64_t, uint64_t>
+            (static_cast<const int64_t*>(vals), n, blk);
+        break;
+    case ibis::ULONG:
+    case ibis::DOUBLE:
+    case ibis::OID:
+        _ibis_colpack_encode<uint64_t, uint64_t>
+            (static_cast<const uint64_t*>(vals), n, blk);
+        break;
+    default:
+        return -1;
+    }
+    return 0;
+} // _ibis_colpack_encode
+
+/// Read the header of a packed data file.  Return 0 on success, a
+/// negative number to indicate error.
+static int _ibis_colpack_readHeader(int fdes, ibis::colpack::header& hdr) {
+    uint64_t w[3];
+    if (ibis::util::read(fdes, w, sizeof(w)) != (int64_t)sizeof(w))
+        return -1;
+    if (memcmp(w, _ibis_colpack_magic, 8) != 0)
+        return -2;
+
+    hdr.nrows = static_cast<uint32_t>(w[1]);
+    hdr.bsize = static_cast<uint32_t>(w[1] >> 32);
+    hdr.nblocks = static_cast<uint32_t>(w[2]);
+    hdr.elsize = static_cast<unsigned>((w[2] >> 32) & 255);
+    if (hdr.bsize == 0 ||
+        hdr.nblocks != (hdr.nrows + hdr.bsize - 1) / hdr.bsize ||
+        (hdr.elsize != 1 && hdr.elsize != 2 && hdr.elsize != 4 &&
+         hdr.elsize != 8))
+        return -3;
+
+    hdr.offsets.resize(hdr.nblocks + 1);
+    const int64_t nb = sizeof(uint64_t) * (hdr.nblocks + 1);
+    if (ibis::util::read(fdes, hdr.offsets.begin(), nb) != nb)
+        return -4;
+    return 0;
+} // _ibis_colpack_readHeader
+
+/// Read the encoded block @c b into @c buf.  Return the number of words
+/// read or a negative number to indicate error.
+static long _ibis_colpack_loadBlock(int fdes, const ibis::colpack::header& hdr,
+                                    uint32_t b, ibis::array_t<uint64_t>& buf) {
+    const uint64_t start = hdr.offsets[b];
+    const uint64_t bytes = hdr.offsets[b+1] - start;
+    if (hdr.offsets[b+1] <= start || (bytes & 7) != 0)
+        return -11;
+
+    buf.resize(bytes / 8);
+    if (UnixSeek(fdes, start, SEEK_SET) != (off_t)start)
+        return -12;
+    if (ibis::util::read(fdes, buf.begin(), bytes) != (int64_t)bytes)
+        return -13;
+    ibis::fileManager::instance().recordPages(start, start+bytes);
+    return buf.size();
+} // _ibis_colpack_loadBlock
+
+/// Number of values in block @c b.
+static inline uint32_t
+_ibis_colpack_blockSize(const ibis::colpack::header& hdr, uint32_t b) {
+    return (hdr.nrows - b * hdr.bsize < hdr.bsize ?
+            hdr.nrows - b * hdr.bsize : hdr.bsize);
+} // _ibis_colpack_blockSize
+
+/// Read and decode block @c b into @c out.  The array @c buf is used to
+/// hold the encoded block.  Return the number of values decoded or a
+/// negative number to indicate error.
+static long _ibis_colpack_readBlock(int fdes, const ibis::colpack::header& hdr,
+                                    uint32_t b, ibis::array_t<uint64_t>& buf,
+                                    void* out) {
+    long ierr = _ibis_colpack_loadBlock(fdes, hdr, b, buf);
+    if (ierr < 0)
+        return ierr;
+    return _ibis_colpack_decode(buf.begin(), buf.size(), hdr.elsize, out,
+                                _ibis_colpack_blockSize(hdr, b));
+} // _ibis_colpack_readBlock
+
+/// Compose the name of the packed data file from the name of the raw
+/// data file.
+void ibis::colpack::packedName(const char* raw, std::string& pk) {
+    pk = raw;
+    pk += ".pk";
+} // ibis::colpack::packedName
+
+/// Is the named raw data file replaced by a packed data file?  Returns
+/// true only if the raw data file does not exist and the packed data file
+/// has a valid header.
+bool ibis::colpack::isPacked(const char* raw) {
+    if (raw == 0 || *raw == 0) return false;
+    Stat_T st;
+    if (UnixStat(raw, &st) == 0) return false;
+    return (unpackedSize(raw) >= 0);
+} // ibis::colpack::isPacked
+
+/// Size (in bytes) of the raw data file recorded in the packed data file.
+/// Returns a negative number if the packed data file does not exist or is
+/// not valid.
+int64_t ibis::colpack::unpackedSize(const char* raw) {
+    if (raw == 0 || *raw == 0) return -1;
+    std::string pk;
+    packedName(raw, pk);
+    int fdes = UnixOpen(pk.c_str(), OPEN_READONLY);
+    if (fdes < 0) return -2;
+#if defined(_WIN32) && defined(_MSC_VER)
+    (void)_setmode(fdes, _O_BINARY);
+#endif
+    IBIS_BLOCK_GUARD(UnixClose, fdes);
+
+    uint64_t w[3];
+    if (ibis::util::read(fdes, w, sizeof(w)) != (int64_t)sizeof(w) ||
+        memcmp(w, _ibis_colpack_magic, 8) != 0)
+        return -3;
+    return static_cast<int64_t>(static_cast<uint32_t>(w[1])) *
+        static_cast<int64_t>((w[2] >> 32) & 255);
+} // ibis::colpack::unpackedSize
+
+/// Pack the raw data file @c raw containing @c nrows values of type @c t.
+/// The packed data file is written next to the raw data file, which is
+/// left in place.  Each block is decoded and compared with the original
+/// values before it is written.
+///
+/// Returns the size of the packed data file in bytes, or a negative
+/// number to indicate error.
+int64_t ibis::colpack::pack(const char* raw, ibis::TYPE_T t, uint32_t nrows) {
+    if (raw == 0 || *raw == 0 || nrows == 0)
+        return -1;
+    unsigned elsize = 0;
+    switch (t) {
+    case ibis::BYTE:
+    case ibis::UBYTE:
+        elsize = 1; break;
+    case ibis::SHORT:
+    case ibis::USHORT:
+        elsize = 2; break;
+    case ibis::INT:
+    case ibis::UINT:
+    case ibis::FLOAT:
+        elsize = 4; break;
+    case ibis::LONG:
+    case ibis::ULONG:
+    case ibis::DOUBLE:
+    case ibis::OID:
+        elsize = 8; break;
+    default:
+        return -2;
+    }
+    if (ibis::util::getFileSize(raw) != (off_t)nrows * elsize) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- colpack::pack expected file " << raw << " to have "
+            << nrows * elsize << " bytes, but it has "
+            << ibis::util::getFileSize(raw);
+        return -3;
+    }
+
+    int in = UnixOpen(raw, OPEN_READONLY);
+    if (in < 0) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- colpack::pack failed to open " << raw
+            << " for reading ... " << (errno ? strerror(errno) : "??");
+        return -4;
+    }
+#if defined(_WIN32) && defined(_MSC_VER)
+    (void)_setmode(in, _O_BINARY);
+#endif
+    IBIS_BLOCK_GUARD(UnixClose, in);
+
+    std::string pk;
+    packedName(raw, pk);
+    int out = UnixOpen(pk.c_str(), OPEN_WRITENEW, OPEN_FILEMODE);
+    if (out < 0) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- colpack::pack failed to open " << pk
+            << " for writing ... " << (errno ? strerror(errno) : "??");
+        return -5;
+    }
+#if defined(_WIN32) && defined(_MSC_VER)
+    (void)_setmode(out, _O_BINARY);
+#endif
+
+    const uint32_t bsize = FASTBIT_PACK_BLOCK_SIZE;
+    const uint32_t nblocks = (nrows + bsize - 1) / bsize;
+    ibis::array_t<uint64_t> offsets(nblocks+1);
+    uint64_t w[3];
+    memcpy(w, _ibis_colpack_magic, 8);
+    w[1] = nrows | (static_cast<uint64_t>(bsize) << 32);
+    w[2] = nblocks | (static_cast<uint64_t>(elsize) << 32);
+    offsets[0] = sizeof(w) + sizeof(uint64_t) * offsets.size();
+    int64_t ierr = ibis::util::write(out, w, sizeof(w));
+    if (ierr == (int64_t)sizeof(w))
+        ierr = ibis::util::write(out, offsets.begin(),
+                                 sizeof(uint64_t) * offsets.size());
+    if (ierr != (int64_t)(sizeof(uint64_t) * offsets.size())) {
+        UnixClose(out);
+        remove(pk.c_str());
+        return -6;
+    }
+
+    ibis::array_t<uint64_t> vals((bsize * elsize + 7) / 8);
+    ibis::array_t<uint64_t> check((bsize * elsize + 7) / 8);
+    ibis::array_t<uint64_t> blk;
+    for (uint32_t b = 0; b < nblocks; ++ b) {
+        const uint32_t n = (nrows - b * bsize < bsize ? nrows - b * bsize
+                            : bsize);
+        ierr = ibis::util::read(in, vals.begin(), n * elsize);
+        if (ierr != (int64_t)(n * elsize)) {
+            ierr = -7;
+            break;
+        }
+        ierr = _ibis_colpack_encode(t, vals.begin(), n, blk);
+        if (ierr < 0) {
+            ierr = -8;
+            break;
+        }
+        ierr = _ibis_colpack_decode(blk.begin(), blk.size(), elsize,
+                                    check.begin(), n);
+        if (ierr != (int64_t)n ||
+            memcmp(vals.begin(), check.begin(), n * elsize) != 0) {
+            LOGGER(ibis::gVerbose >= 0)
+                << "Warning -- colpack::pack failed to verify block " << b
+                << " of " << raw << " (decode returned " << ierr << ")";
+            ierr = -9;
+            break;
+        }
+        ierr = ibis::util::write(out, blk.begin(),
+                                 sizeof(uint64_t) * blk.size());
+        if (ierr != (int64_t)(sizeof(uint64_t) * blk.size())) {
+            ierr = -10;
+            break;
+        }
+        offsets[b+1] = offsets[b] + sizeof(uint64_t) * blk.size();
+    }
+    if (ierr >= 0) {
+        if (UnixSeek(out, sizeof(w), SEEK_SET) == (off_t)sizeof(w))
+            ierr = ibis::util::write(out, offsets.begin(),
+                                     sizeof(uint64_t) * offsets.size());
+        else
+            ierr = -11;
+        if (ierr >= 0 && ierr != (int64_t)(sizeof(uint64_t)*offsets.size()))
+            ierr = -11;
+    }
+#if defined(FASTBIT_SYNC_WRITE)
+#if _POSIX_FSYNC+0 > 0
+    (void) UnixFlush(out); // write to disk
+#elif defined(_WIN32) && defined(_MSC_VER)
+    (void) _commit(out);
+#endif
+#endif
+    UnixClose(out);
+    if (ierr < 0) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- colpack::pack failed to write " << pk
+            << ", ierr = " << ierr;
+        remove(pk.c_str());
+        return ierr;
+    }
+
+    LOGGER(ibis::gVerbose > 3)
+        << "colpack::pack -- wrote " << nrows << " value"
+        << (nrows>1?"s":"") << " from " << raw << " (" << nrows * elsize
+        << " bytes) to " << pk << " (" << offsets.back() << " bytes)";
+    return offsets.back();
+} // ibis::colpack::pack
+
+/// Decode the whole packed data file corresponding to @c raw into @c buf,
+/// which must have room for @c nbytes bytes.  Returns the number of bytes
+/// decoded or a negative number to indicate error.
+int64_t ibis::colpack::unpack(const char* raw, char* buf, uint64_t nbytes) {
+    if (raw == 0 || *raw == 0 || buf == 0)
+        return -1;
+    std::string pk;
+    packedName(raw, pk);
+    int fdes = UnixOpen(pk.c_str(), OPEN_READONLY);
+    if (fdes < 0) return -2;
+#if defined(_WIN32) && defined(_MSC_VER)
+    (void)_setmode(fdes, _O_BINARY);
+#endif
+    IBIS_BLOCK_GUARD(UnixClose, fdes);
+
+    ibis::colpack::header hdr;
+    int ierr = _ibis_colpack_readHeader(fdes, hdr);
+    if (ierr < 0) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- colpack::unpack failed to read the header of "
+            << pk << ", ierr = " << ierr;
+        return -3;
+    }
+    const uint64_t total = static_cast<uint64_t>(hdr.nrows) * hdr.elsize;
+    if (total > nbytes)
+        return -4;
+
+    ibis::array_t<uint64_t> blk;
+    for (uint32_t b = 0; b < hdr.nblocks; ++ b) {
+        long ierr = _ibis_colpack_readBlock
+            (fdes, hdr, b, blk,
+             buf + static_cast<uint64_t>(b) * hdr.bsize * hdr.elsize);
+        const uint32_t n = (hdr.nrows - b * hdr.bsize < hdr.bsize ?
+                            hdr.nrows - b * hdr.bsize : hdr.bsize);
+        if (ierr != (long)n) {
+            LOGGER(ibis::gVerbose > 1)
+                << "Warning -- colpack::unpack failed to decode block " << b
+                << " of " << pk << ", ierr = " << ierr;
+            return -5;
+        }
+    }
+    return total;
+} // ibis::colpack::unpack
+
+/// Restore the raw data file from the packed data file and remove the
+/// packed data file.  Returns the size of the raw data file or a negative
+/// number to indicate error.
+int64_t ibis::colpack::unpack(const char* raw) {
+    const int64_t nbytes = unpackedSize(raw);
+    if (nbytes < 0) return -1;
+
+    ibis::array_t<uint64_t> buf((nbytes + 7) / 8);
+    int64_t ierr = unpack(raw, reinterpret_cast<char*>(buf.begin()), nbytes);
+    if (ierr != nbytes) return -2;
+
+    int fdes = UnixOpen(raw, OPEN_WRITENEW, OPEN_FILEMODE);
+    if (fdes < 0) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- colpack::unpack failed to open " << raw
+            << " for writing ... " << (errno ? strerror(errno) : "??");
+        return -3;
+    }
+#if defined(_WIN32) && defined(_MSC_VER)
+    (void)_setmode(fdes, _O_BINARY);
+#endif
+    ierr = ibis::util::write(fdes, buf.begin(), nbytes);
+    UnixClose(fdes);
+    if (ierr != nbytes) {
+        remove(raw);
+        return -4;
+    }
+
+    std::string pk;
+    packedName(raw, pk);
+    remove(pk.c_str());
+    return nbytes;
+} // ibis::colpack::unpack
+
+/// Decode the values marked 1 in @c mask.  Only the blocks containing
+/// such values are read from the packed data file.  If @c inds is not
+/// nil, the positions of the values are recorded in it.
+template <typename T>
+static long _ibis_colpack_select(const char* raw, const ibis::bitvector& mask,
+                                 ibis::array_t<T>& vals,
+                                 ibis::array_t<uint32_t>* inds) {
+    vals.clear();
+    if (inds != 0)
+        inds->clear();
+    std::string pk;
+    ibis::colpack::packedName(raw, pk);
+    int fdes = UnixOpen(pk.c_str(), OPEN_READONLY);
+    if (fdes < 0) return -1;
+#if defined(_WIN32) && defined(_MSC_VER)
+    (void)_setmode(fdes, _O_BINARY);
+#endif
+    IBIS_BLOCK_GUARD(UnixClose, fdes);
+
+    ibis::colpack::header hdr;
+    long ierr = _ibis_colpack_readHeader(fdes, hdr);
+    if (ierr < 0) return -2;
+    if (hdr.elsize != sizeof(T)) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- colpack::selectValues<" << typeid(T).name()
+            << "> can not read " << pk << " with " << hdr.elsize
+            << "-byte elements";
+        return -3;
+    }
+
+    const uint32_t tot = mask.cnt();
+    vals.reserve(tot);
+    if (inds != 0)
+        inds->reserve(tot);
+    ibis::array_t<T> dec(hdr.bsize);
+    ibis::array_t<uint64_t> blk;
+    uint32_t cur = hdr.nblocks; // the block in dec
+    uint32_t nblk = 0; // number of blocks decoded
+    for (ibis::bitvector::indexSet ix = mask.firstIndexSet();
+         ix.nIndices() > 0; ++ ix) {
+        const ibis::bitvector::word_t *ixval = ix.indices();
+        if (ix.isRange()) {
+            uint32_t i = ixval[0];
+            const uint32_t stop = (ixval[1] <= hdr.nrows ? ixval[1]
+                                   : hdr.nrows);
+            while (i < stop) {
+                const uint32_t b = i / hdr.bsize;
+                if (b != cur) {
+                    ierr = _ibis_colpack_readBlock(fdes, hdr, b, blk,
+                                                   dec.begin());
+                    if (ierr < 0) return ierr;
+                    cur = b;
+                    ++ nblk;
+                }
+                const uint32_t bstart = b * hdr.bsize;
+                const uint32_t bend = (stop - bstart < hdr.bsize ? stop :
+                                       bstart + hdr.bsize);
+                for (; i < bend; ++ i) {
+                    vals.push_back(dec[i - bstart]);
+                    if (inds != 0)
+                        inds->push_back(i);
+                }
+            }
+        }
+        else {
+            for (uint32_t j = 0; j < ix.nIndices(); ++ j) {
+                const uint32_t i = ixval[j];
+                if (i >= hdr.nrows) break;
+                const uint32_t b = i / hdr.bsize;
+                if (b != cur) {
+                    ierr = _ibis_colpack_readBlock(fdes, hdr, b, blk,
+                                                   dec.begin());
+                    if (ierr < 0) return ierr;
+                    cur = b;
+                    ++ nblk;
+                }
+                vals.push_back(dec[i - b * hdr.bsize]);
+                if (inds != 0)
+                    inds->push_back(i);
+            }
+        }
+    }
+
+    LOGGER(ibis::gVerbose > 4)
+        << "colpack::selectValues<" << typeid(T).name() << "> -- decoded "
+        << nblk << " of " << hdr.nblocks << " block" << (hdr.nblocks>1?"s":"")
+        << " in " << pk << " to get " << vals.size() << " value"
+        << (vals.size()>1?"s":"");
+    return vals.size();
+} // _ibis_colpack_select
+
+/// Select the values marked 1 in @c mask from the packed version of the
+/// raw data file @c raw.  Returns the number of values selected or a
+/// negative number to indicate error.
+template <typename T>
+long ibis::colpack::selectValues(const char* raw, const ibis::bitvector& mask,
+                                 ibis::array_t<T>& vals) {
+    return _ibis_colpack_select(raw, mask, vals,
+                                static_cast<ibis::array_t<uint32_t>*>(0));
+} // ibis::colpack::selectValues
+
+/// Select the values marked 1 in @c mask along with their positions.
+template <typename T>
+long ibis::colpack::selectValues(const char* raw, const ibis::bitvector& mask,
+                                 ibis::array_t<T>& vals,
+                                 ibis::array_t<uint32_t>& inds) {
+    return _ibis_colpack_select(raw, mask, vals, &inds);
+} // ibis::colpack::selectValues
+
+/// Append bits to a bitvector, 31 bits at a time as literal words.
+struct _ibis_colpack_bits {
+    ibis::bitvector& bv;
+    ibis::bitvector::word_t acc; ///!< Bits not yet appended.
+    unsigned nacc; ///!< Number of bits in @c acc.
+
+    _ibis_colpack_bits(ibis::bitvector& b) : bv(b), acc(0), nacc(0) {}
+    /// Append a single bit, @c b must be 0 or 1.
+    inline void add(ibis::bitvector::word_t b) {
+        acc = (acc << 1) | b;
+        if (++ nacc == 31) {
+            bv.appendWord(acc);
+            acc = 0;
+            nacc = 0;
+        }
+    }
+    /// Append @c n copies of @c val.
+    void fill(int val, ibis::bitvector::word_t n) {
+        flush();
+        bv.appendFill(val, n);
+    }
+    /// Move the pending bits to the bitvector.
+    void flush() {
+        for (unsigned j = nacc; j > 0; -- j)
+            bv += static_cast<int>((acc >> (j-1)) & 1);
+        acc = 0;
+        nacc = 0;
+    }
+}; // _ibis_colpack_bits
+
+/// Compare @c n codes packed with @c w bits each against the code range
+/// [clo, clo+span].  A code c is in the range if (c - clo) <= span with
+/// unsigned arithmetic, which requires a single comparison per code and
+/// no branch.
+static void _ibis_colpack_codeRange(const uint64_t* words, unsigned w,
+                                    uint32_t n, uint64_t clo, uint64_t span,
+                                    _ibis_colpack_bits& bits) {
+    const uint64_t mask = (w < 64 ? ((static_cast<uint64_t>(1) << w) - 1)
+                           : ~static_cast<uint64_t>(0));
+    for (uint32_t i = 0; i < n; ++ i) {
+        const uint64_t pos = static_cast<uint64_t>(i) * w;
+        const unsigned sh = static_cast<unsigned>(pos & 63);
+        const uint64_t c = ((words[pos >> 6] >> sh) |
+                            ((words[(pos >> 6) + 1] << 1) << (63 - sh))) & mask;
+        bits.add(c - clo <= span);
+    }
+} // _ibis_colpack_codeRange
+
+/// Raise @c lo to the smallest value of type @c T greater than @c b, or
+/// not less than @c b if @c strict is false.  Return false if there is no
+/// such value.  The bound is stepped in the type @c T because a double
+/// can not represent every 64-bit integer.
+template <typename T>
+static bool _ibis_colpack_atLeast(double b, bool strict, T& lo) {
+    const bool exact = (std::numeric_limits<T>::digits <=
+                        std::numeric_limits<double>::digits);
+    const double tmin = static_cast<double>(std::numeric_limits<T>::min());
+    const double tmax = static_cast<double>(std::numeric_limits<T>::max());
+    if (b != b) return false;
+    if (b < tmin) return true;
+    if (b > tmax || (! exact && b >= tmax)) return false;
+
+    T t;
+    if (strict) {
+        t = static_cast<T>(std::floor(b));
+        if (t == std::numeric_limits<T>::max()) return false;
+        ++ t;
+    }
+    else {
+        t = static_cast<T>(std::ceil(b));
+    }
+    if (lo < t)
+        lo = t;
+    return true;
+} // _ibis_colpack_atLeast
+
+/// Lower @c hi to the largest value of type @c T less than @c b, or not
+/// greater than @c b if @c strict is false.  Return false if there is no
+/// such value.
+template <typename T>
+static bool _ibis_colpack_atMost(double b, bool strict, T& hi) {
+    const bool exact = (std::numeric_limits<T>::digits <=
+                        std::numeric_limits<double>::digits);
+    const double tmin = static_cast<double>(std::numeric_limits<T>::min());
+    const double tmax = static_cast<double>(std::numeric_limits<T>::max());
+    if (b != b) return false;
+    if (b > tmax || (! exact && b >= tmax)) return true;
+    if (b < tmin) return false;
+
+    T t;
+    if (strict) {
+        t = static_cast<T>(std::ceil(b));
+        if (t == std::numeric_limits<T>::min()) return false;
+        -- t;
+    }
+    else {
+        t = static_cast<T>(std::floor(b));
+    }
+    if (t < hi)
+        hi = t;
+    return true;
+} // _ibis_colpack_atMost
+
+/// Translate a continuous range into the closed range [lo, hi] of the
+/// integer type @c T.  Return false if no value of type @c T satisfies the
+/// condition.  The result agrees with the comparisons in the type @c T
+/// performed by ibis::part::doScan on the raw data files.
+template <typename T>
+static bool _ibis_colpack_bounds(const ibis::qContinuousRange& rng,
+                                 T& lo, T& hi) {
+    lo = std::numeric_limits<T>::min();
+    hi = std::numeric_limits<T>::max();
+    const double lb = rng.leftBound();
+    const double rb = rng.rightBound();
+    bool ok = true;
+    switch (rng.leftOperator()) {
+    case ibis::qExpr::OP_LT: ok = _ibis_colpack_atLeast(lb, true, lo); break;
+    case ibis::qExpr::OP_LE: ok = _ibis_colpack_atLeast(lb, false, lo); break;
+    case ibis::qExpr::OP_GT: ok = _ibis_colpack_atMost(lb, true, hi); break;
+    case ibis::qExpr::OP_GE: ok = _ibis_colpack_atMost(lb, false, hi); break;
+    case ibis::qExpr::OP_EQ:
+        ok = (lb == std::floor(lb) &&
+              _ibis_colpack_atLeast(lb, false, lo) &&
+              _ibis_colpack_atMost(lb, false, hi));
+        break;
+    default: break;
+    }
+    if (! ok) return false;
+    switch (rng.rightOperator()) {
+    case ibis::qExpr::OP_LT: ok = _ibis_colpack_atMost(rb, true, hi); break;
+    case ibis::qExpr::OP_LE: ok = _ibis_colpack_atMost(rb, false, hi); break;
+    case ibis::qExpr::OP_GT: ok = _ibis_colpack_atLeast(rb, true, lo); break;
+    case ibis::qExpr::OP_GE: ok = _ibis_colpack_atLeast(rb, false, lo); break;
+    case ibis::qExpr::OP_EQ:
+        ok = (rb == std::floor(rb) &&
+              _ibis_colpack_atLeast(rb, false, lo) &&
+              _ibis_colpack_atMost(rb, false, hi));
+        break;
+    default: break;
+    }
+    return (ok && lo <= hi);
+} // _ibis_colpack_bounds
+
+/// Evaluate a range condition on the packed version of the raw data file
+/// @c raw.  The result is the rows satisfying @c cmp among those marked 1
+/// in @c mask.  Return the number of hits or a negative number to
+/// indicate error.
+///
+/// The blocks are processed without decoding whenever possible.  For
+/// integer values, the bounds of the condition are translated into the
+/// code space of each frame-of-reference block by subtracting the
+/// reference value of the block.  A block whose code range does not
+/// overlap the translated bounds is skipped, a block whose code range is
+/// inside the bounds is filled with 1s, and the codes of the other blocks
+/// are compared against the bounds directly.  The condition is evaluated
+/// once for each run of a run-length encoded block.  The remaining blocks
+/// are decoded and the values compared one at a time.
+///
+/// If fewer than 1/8 of the rows are marked in @c mask, only the blocks
+/// containing the marked rows are decoded with selectValues.  Either way,
+/// a continuous range on integers is compared in the type @c T after its
+/// bounds are translated once, so that the 64-bit values beyond 2^53 are
+/// not rounded to doubles.
+///
+/// @note The comparisons are plain loops over 64-bit words without
+/// machine-specific instructions.
+template <typename T>
+long ibis::colpack::evaluateRange(const char* raw, const ibis::qRange& cmp,
+                                  const ibis::bitvector& mask,
+                                  ibis::bitvector& hits) {
+    if (cmp.getType() != ibis::qExpr::RANGE &&
+        cmp.getType() != ibis::qExpr::DRANGE)
+        return -1;
+
+    const bool isint = std::numeric_limits<T>::is_integer;
+    const bool isrange = (cmp.getType() == ibis::qExpr::RANGE);
+    T lo = 0, hi = 0;
+    if (isint && isrange &&
+        ! _ibis_colpack_bounds
+        (static_cast<const ibis::qContinuousRange&>(cmp), lo, hi)) {
+        hits.set(0, mask.size());
+        return 0;
+    }
+    const uint64_t span = static_cast<uint64_t>(hi) -
+        static_cast<uint64_t>(lo);
+
+    long ierr;
+    if (mask.cnt() < (mask.size() >> 3)) {
+        ibis::array_t<T> vals;
+        ibis::array_t<uint32_t> inds;
+        ierr = ibis::colpack::selectValues(raw, mask, vals, inds);
+        if (ierr < 0)
+            return ierr;
+
+        hits.clear();
+        for (size_t j = 0; j < vals.size(); ++ j) {
+            if (isint && isrange ?
+                (static_cast<uint64_t>(vals[j]) -
+                 static_cast<uint64_t>(lo) <= span) :
+                cmp.inRange(static_cast<double>(vals[j])))
+                hits.setBit(inds[j], 1);
+        }
+        hits.adjustSize(0, mask.size());
+        return hits.cnt();
+    }
+
+    std::string pk;
+    ibis::colpack::packedName(raw, pk);
+    int fdes = UnixOpen(pk.c_str(), OPEN_READONLY);
+    if (fdes < 0) return -1;
+#if defined(_WIN32) && defined(_MSC_VER)
+    (void)_setmode(fdes, _O_BINARY);
+#endif
+    IBIS_BLOCK_GUARD(UnixClose, fdes);
+
+    ibis::colpack::header hdr;
+    ierr = _ibis_colpack_readHeader(fdes, hdr);
+    if (ierr < 0) return -2;
+    if (hdr.elsize != sizeof(T)) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- colpack::evaluateRange<" << typeid(T).name()
+            << "> can not read " << pk << " with " << hdr.elsize
+            << "-byte elements";
+        return -3;
+    }
+
+    const ibis::array_t<double>* dvals = (isrange ? 0 :
+        &(static_cast<const ibis::qDiscreteRange&>(cmp).getValues()));
+
+    hits.clear();
+    _ibis_colpack_bits bits(hits);
+    ibis::array_t<T> dec(hdr.bsize);
+    ibis::array_t<uint64_t> blk;
+    uint32_t nskip = 0, nfill = 0, ncode = 0, nrun = 0, ndec = 0;
+    for (uint32_t b = 0; b < hdr.nblocks; ++ b) {
+        ierr = _ibis_colpack_loadBlock(fdes, hdr, b, blk);
+        if (ierr < 3) return (ierr < 0 ? ierr : -14);
+
+        const uint64_t *payload = blk.begin() + 3;
+        const unsigned m = static_cast<unsigned>(blk[0] & 255);
+        const unsigned w = static_cast<unsigned>((blk[0] >> 8) & 255);
+        const uint32_t n = static_cast<uint32_t>(blk[0] >> 32);
+        if (n != _ibis_colpack_blockSize(hdr, b) || w > 64)
+            return -15;
+
+        if (m == ibis::colpack::RLE) {
+            const uint64_t nruns = blk[2];
+            if (nruns > n || blk.size() < 3 + (nruns * sizeof(T) + 7) / 8
+                + (nruns * 4 + 7) / 8)
+                return -16;
+            const T* rv = reinterpret_cast<const T*>(payload);
+            const uint32_t* rl = reinterpret_cast<const uint32_t*>
+                (payload + (nruns * sizeof(T) + 7) / 8);
+            uint32_t tot = 0;
+            for (uint64_t k = 0; k < nruns; ++ k) {
+                bits.fill(isint && isrange ?
+                          (static_cast<uint64_t>(rv[k]) -
+                           static_cast<uint64_t>(lo) <= span) :
+                          cmp.inRange(static_cast<double>(rv[k])), rl[k]);
+                tot += rl[k];
+            }
+            if (tot != n) return -16;
+            ++ nrun;
+            continue;
+        }
+
+        if (isint && m == ibis::colpack::FOR) {
+            // translate the condition into the code space of the block
+            const T ref = static_cast<T>(blk[1]);
+            const uint64_t maxcode =
+                (w < 64 ? ((static_cast<uint64_t>(1) << w) - 1)
+                 : ~static_cast<uint64_t>(0));
+            uint64_t clo = 0, chi = 0;
+            bool none = false, decode = false;
+            if (isrange) {
+                if (hi < ref) {
+                    none = true;
+                }
+                else {
+                    clo = (lo <= ref ? 0 : static_cast<uint64_t>(lo) -
+                           static_cast<uint64_t>(ref));
+                    chi = static_cast<uint64_t>(hi) -
+                        static_cast<uint64_t>(ref);
+                }
+            }
+            else {
+                // find the values of the discrete range that may appear
+                // in the block, use the codes if there is only one
+                const double bmin = static_cast<double>(ref);
+                const double bmax = bmin + static_cast<double>(maxcode);
+                const double *vb = std::lower_bound
+                    (dvals->begin(), dvals->end(), bmin);
+                const double *ve = std::upper_bound(vb, dvals->end(), bmax);
+                if (vb >= ve) {
+                    none = true;
+                }
+                else if (ve - vb == 1 && *vb == std::floor(*vb)) {
+                    clo = static_cast<uint64_t>(static_cast<T>(*vb)) -
+                        static_cast<uint64_t>(ref);
+                    chi = clo;
+                }
+                else {
+                    decode = true;
+                }
+            }
+            if (! decode) {
+                if (none || clo > maxcode) {
+                    bits.fill(0, n);
+                    ++ nskip;
+                    continue;
+                }
+                if (chi > maxcode)
+                    chi = maxcode;
+                if (clo == 0 && chi == maxcode) {
+                    bits.fill(1, n);
+                    ++ nfill;
+                    continue;
+                }
+                if (blk.size() < 3 + (static_cast<uint64_t>(n) * w + 63) / 64
+                    + 1)
+                    return -17;
+                _ibis_colpack_codeRange(payload, w, n, clo, chi - clo, bits);
+                ++ ncode;
+                continue;
+            }
+        }
+
+        ierr = _ibis_colpack_decode(blk.begin(), blk.size(), hdr.elsize,
+                                    dec.begin(), n);
+        if (ierr != static_cast<long>(n))
+            return (ierr < 0 ? ierr : -18);
+        if (isint && isrange) {
+            for (uint32_t i = 0; i < n; ++ i)
+                bits.add(static_cast<uint64_t>(dec[i]) -
+                         static_cast<uint64_t>(lo) <= span);
+        }
+        else {
+            for (uint32_t i = 0; i < n; ++ i)
+                bits.add(cmp.inRange(static_cast<double>(dec[i])));
+        }
+        ++ ndec;
+    }
+    bits.flush();
+    hits.adjustSize(0, mask.size());
+    hits &= mask;
+
+    LOGGER(ibis::gVerbose > 4)
+        << "colpack::evaluateRange<" << typeid(T).name() << "> -- " << pk
+        << " has " << hdr.nblocks << " block" << (hdr.nblocks>1?"s":"")
+        << ": skipped " << nskip << ", filled " << nfill << ", compared "
+        << ncode << " by codes and " << nrun << " by runs, decoded " << ndec
+        << "; found " << hits.cnt() << " hit" << (hits.cnt()>1?"s":"");
+    return hits.cnt();
+} // ibis::colpack::evaluateRange
+
+// explicit template instantiations
+template long ibis::colpack::selectValues
+(const char*, const ibis::bitvector&, ibis::array_t<signed char>&);
+template long ibis::colpack::selectValues
+(const char*, const ibis::bitvector&, ibis::array_t<unsigned char>&);
+template long ibis::colpack::selectValues
+(const char*, const ibis::bitvector&, ibis::array_t<char>&);
+template long ibis::colpack::selectValues
+(const char*, const ibis::bitvector&, ibis::array_t<int16_t>&);
+template long ibis::colpack::selectValues
+(const char*, const ibis::bitvector&, ibis::array_t<uint16_t>&);
+template long ibis::colpack::selectValues
+(const char*, const ibis::bitvector&, ibis::array_t<int32_t>&);
+template long ibis::colpack::selectValues
+(const char*, const ibis::bitvector&, ibis::array_t<uint32_t>&);
+template long ibis::colpack::selectValues
+(const char*, const ibis::bitvector&, ibis::array_t<int64_t>&);
+template long ibis::colpack::selectValues
+(const char*, const ibis::bitvector&, ibis::array_t<uint64_t>&);
+template long ibis::colpack::selectValues
+(const char*, const ibis::bitvector&, ibis::array_t<float>&);
+template long ibis::colpack::selectValues
+(const char*, const ibis::bitvector&, ibis::array_t<double>&);
+template long ibis::colpack::selectValues
+(const char*, const ibis::bitvector&, ibis::array_t<ibis::rid_t>&);
+template long ibis::colpack::selectValues
+(const char*, const ibis::bitvector&, ibis::array_t<signed char>&,
+ ibis::array_t<uint32_t>&);
+template long ibis::colpack::selectValues
+(const char*, const ibis::bitvector&, ibis::array_t<unsigned char>&,
+ ibis::array_t<uint32_t>&);
+template long ibis::colpack::selectValues
+(const char*, const ibis::bitvector&, ibis::array_t<char>&,
+ ibis::array_t<uint32_t>&);
+template long ibis::colpack::selectValues
+(const char*, const ibis::bitvector&, ibis::array_t<int16_t>&,
+ ibis::array_t<uint32_t>&);
+template long ibis::colpack::selectValues
+(const char*, const ibis::bitvector&, ibis::array_t<uint16_t>&,
+ ibis::array_t<uint32_t>&);
+template long ibis::colpack::selectValues
+(const char*, const ibis::bitvector&, ibis::array_t<int32_t>&,
+ ibis::array_t<uint32_t>&);
+template long ibis::colpack::selectValues
+(const char*, const ibis::bitvector&, ibis::array_t<uint32_t>&,
+ ibis::array_t<uint32_t>&);
+template long ibis::colpack::selectValues
+(const char*, const ibis::bitvector&, ibis::array_t<int64_t>&,
+ ibis::array_t<uint32_t>&);
+template long ibis::colpack::selectValues
+(const char*, const ibis::bitvector&, ibis::array_t<uint64_t>&,
+ ibis::array_t<uint32_t>&);
+template long ibis::colpack::selectValues
+(const char*, const ibis::bitvector&, ibis::array_t<float>&,
+ ibis::array_t<uint32_t>&);
+template long ibis::colpack::selectValues
+(const char*, const ibis::bitvector&, ibis::array_t<double>&,
+ ibis::array_t<uint32_t>&);
+template long ibis::colpack::selectValues
+(const char*, const ibis::bitvector&, ibis::array_t<ibis::rid_t>&,
+ ibis::array_t<uint32_t>&);
+template long ibis::colpack::evaluateRange<signed char>
+(const char*, const ibis::qRange&, const ibis::bitvector&, ibis::bitvector&);
+template long ibis::colpack::evaluateRange<unsigned char>
+(const char*, const ibis::qRange&, const ibis::bitvector&, ibis::bitvector&);
+template long ibis::colpack::evaluateRange<int16_t>
+(const char*, const ibis::qRange&, const ibis::bitvector&, ibis::bitvector&);
+template long ibis::colpack::evaluateRange<uint16_t>
+(const char*, const ibis::qRange&, const ibis::bitvector&, ibis::bitvector&);
+template long ibis::colpack::evaluateRange<int32_t>
+(const char*, const ibis::qRange&, const ibis::bitvector&, ibis::bitvector&);
+template long ibis::colpack::evaluateRange<uint32_t>
+(const char*, const ibis::qRange&, const ibis::bitvector&, ibis::bitvector&);
+template long ibis::colpack::evaluateRange<int64_t>
+(const char*, const ibis::qRange&, const ibis::bitvector&, ibis::bitvector&);
+template long ibis::colpack::evaluateRange<uint64_t>
+(const char*, const ibis::qRange&, const ibis::bitvector&, ibis::bitvector&);
+template long ibis::colpack::evaluateRange<float>
+(const char*, const ibis::qRange&, const ibis::bitvector&, ibis::bitvector&);
+template long ibis::colpack::evaluateRange<double>
+(const char*, const ibis::qRange&, const ibis::bitvector&, ibis::bitvector&);
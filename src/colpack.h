@@ -0,0 +1,70 @@
+// File: $Id$
+// Author: John Wu <John.Wu at acm.org>
+//      Lawrence Berkeley National Laboratory
+// Copyright (c) 2007-2016 the Regents of the University of California
+#ifndef IBIS_COLPACK_H
+#define IBIS_COLPACK_H
+///@file
+/// Lightweight compression of the raw data files of fixed-size columns.
+///
+/// A packed data file replaces the raw data file of a column.  The values
+/// are divided into blocks of a fixed number of rows and each block is
+/// encoded separately with one of the following methods, whichever
+/// produces the smallest block:
+/// - frame-of-reference: the minimum value of the block followed by the
+///   differences from the minimum, bit-packed with as many bits as the
+///   largest difference requires;
+/// - delta: for blocks of values in non-decreasing order, the first value
+///   followed by the bit-packed differences between consecutive values;
+/// - run-length encoding: the distinct runs of identical values;
+/// - raw: the values as they are.
+///
+/// The packed file has the name of the raw data file followed by ".pk".
+/// The file starts with a header recording the number of rows, the block
+/// size and the element size, followed by the offsets of the blocks.
+/// A block can therefore be located and decoded without reading the rest
+/// of the file.
+///
+/// Range conditions can be evaluated on a packed data file without
+/// decoding most of the blocks.  The bounds of a condition are translated
+/// into the code space of each frame-of-reference block, so that a block
+/// is either skipped, filled, or scanned by comparing its packed codes;
+/// the condition is evaluated once per run of a run-length encoded block.
+#include "table.h"      // ibis::TYPE_T
+#include "array_t.h"    // ibis::array_t
+#include "bitvector.h"  // ibis::bitvector
+
+namespace ibis {
+    class qRange; // forward declaration
+
+    /// Functions to pack and unpack the raw data files of fixed-size
+    /// columns.  The functions operate on the names of the raw data files;
+    /// the names of the packed files are derived from them.
+    namespace colpack {
+        /// Compression methods of a block.
+        enum METHOD {RAW=0, FOR=1, DELTA=2, RLE=3};
+
+        FASTBIT_CXX_DLLSPEC void packedName(const char* raw,
+                                            std::string& pk);
+        FASTBIT_CXX_DLLSPEC bool isPacked(const char* raw);
+        FASTBIT_CXX_DLLSPEC int64_t unpackedSize(const char* raw);
+        FASTBIT_CXX_DLLSPEC int64_t pack(const char* raw, ibis::TYPE_T t,
+                                         uint32_t nrows);
+        FASTBIT_CXX_DLLSPEC int64_t unpack(const char* raw, char* buf,
+                                           uint64_t nbytes);
+        FASTBIT_CXX_DLLSPEC int64_t unpack(const char* raw);
+
+        template <typename T> FASTBIT_CXX_DLLSPEC
+        long selectValues(const char* raw, const ibis::bitvector& mask,
+                          ibis::array_t<T>& vals);
+        template <typename T> FASTBIT_CXX_DLLSPEC
+        long selectValues(const char* raw, const ibis::bitvector& mask,
+                          ibis::array_t<T>& vals,
+                          ibis::array_t<uint32_t>& inds);
+        template <typename T> FASTBIT_CXX_DLLSPEC
+        long evaluateRange(const char* raw, const ibis::qRange& cmp,
+                           const ibis::bitvector& mask,
+                           ibis::bitvector& hits);
+    } // namespace colpack
+} // namespace ibis
+#endif // IBIS_COLPACK_H
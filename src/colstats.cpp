@@ -0,0 +1,528 @@
+// File $Id$
+// Author: John Wu <John.Wu at ACM.org>
+//      Lawrence Berkeley National Laboratory
+// Copyright (c) 2007-2016 the Regents of the University of California
+//
+// This file contains the implementation of the class ibis::colStats.  See
+// colstats.h for a description.
+#include "colstats.h"   // ibis::colStats
+#include "qExpr.h"      // ibis::qContinuousRange
+#include "resource.h"   // ibis::gParameters
+
+#include <algorithm>    // std::sort
+#include <cmath>        // std::pow, std::log
+#include <limits>       // std::numeric_limits
+#include <map>          // std::map
+
+/// The number of bits of the hash value used to select a register of the
+/// HyperLogLog sketch.  The sketch has 2^FASTBIT_COLSTATS_HLL_BITS
+/// registers of one byte each.
+#ifndef FASTBIT_COLSTATS_HLL_BITS
+#define FASTBIT_COLSTATS_HLL_BITS 12
+#endif
+/// The number of most common values kept.
+#ifndef FASTBIT_COLSTATS_MCVS
+#define FASTBIT_COLSTATS_MCVS 16
+#endif
+
+/// A 64-bit hash of the bit pattern of a value, the finalizer of
+/// splitmix64.  The values are hashed as doubles so that the sketches
+/// computed at different times can be merged.
+static inline uint64_t _ibis_colstats_hash(double v) {
+    if (v == 0.0) v = 0.0; // -0.0 and 0.0 are the same value
+    uint64_t x;
+    memcpy(&x, &v, sizeof(x));
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+} // _ibis_colstats_hash
+
+/// The number of bins of the histogram, from the parameter
+/// statistics.nbins.
+static uint32_t _ibis_colstats_nbins() {
+    double nb = ibis::gParameters().getNumber("statistics.nbins");
+    if (! (nb >= 1.0 && nb < 1e6))
+        nb = 64;
+    return static_cast<uint32_t>(nb);
+} // _ibis_colstats_nbins
+
+ibis::colStats::colStats()
+    : nrows(0), nnull(0), vmin(std::numeric_limits<double>::max()),
+      vmax(-std::numeric_limits<double>::max()),
+      hll(1U << FASTBIT_COLSTATS_HLL_BITS, 0) {
+} // ibis::colStats::colStats
+
+/// Exchange the content with @c rhs.
+void ibis::colStats::swap(colStats& rhs) {
+    uint32_t tmp = nrows;
+    nrows = rhs.nrows;
+    rhs.nrows = tmp;
+    tmp = nnull;
+    nnull = rhs.nnull;
+    rhs.nnull = tmp;
+    double dtmp = vmin;
+    vmin = rhs.vmin;
+    rhs.vmin = dtmp;
+    dtmp = vmax;
+    vmax = rhs.vmax;
+    rhs.vmax = dtmp;
+    bounds.swap(rhs.bounds);
+    counts.swap(rhs.counts);
+    mcvs.swap(rhs.mcvs);
+    mcvcnt.swap(rhs.mcvcnt);
+    hll.swap(rhs.hll);
+} // ibis::colStats::swap
+
+/// Add a value to the HyperLogLog sketch.
+void ibis::colStats::addHash(double v) {
+    const uint64_t h = _ibis_colstats_hash(v);
+    const uint32_t j = static_cast<uint32_t>
+        (h >> (64 - FASTBIT_COLSTATS_HLL_BITS));
+    uint64_t rest = (h << FASTBIT_COLSTATS_HLL_BITS);
+    unsigned char rho = 1;
+    while (rho <= 64 - FASTBIT_COLSTATS_HLL_BITS &&
+           (rest & 0x8000000000000000ULL) == 0) {
+        ++ rho;
+        rest <<= 1;
+    }
+    if (hll[j] < rho)
+        hll[j] = rho;
+} // ibis::colStats::addHash
+
+/// Compute the histogram and the most common values from the sorted list
+/// of values.  The sketch, the number of rows and the number of null
+/// values are not touched.
+void ibis::colStats::fromSorted(const std::vector<double>& vals) {
+    // fresh arrays, the old ones might be shared with other objects
+    ibis::array_t<double>().swap(bounds);
+    ibis::array_t<uint32_t>().swap(counts);
+    ibis::array_t<double>().swap(mcvs);
+    ibis::array_t<uint32_t>().swap(mcvcnt);
+    const uint32_t nv = vals.size();
+    if (nv == 0) return;
+
+    vmin = vals.front();
+    vmax = vals.back();
+    const uint32_t nb = (nv < _ibis_colstats_nbins() ?
+                         nv : _ibis_colstats_nbins());
+    bounds.resize(nb+1);
+    counts.resize(nb);
+    uint32_t prev = 0;
+    bounds[0] = vals[0];
+    for (uint32_t k = 1; k < nb; ++ k) {
+        const uint32_t pos = static_cast<uint32_t>
+            ((static_cast<uint64_t>(nv) * k) / nb);
+        bounds[k] = vals[pos];
+        counts[k-1] = pos - prev;
+        prev = pos;
+    }
+    bounds[nb] = vals.back();
+    counts[nb-1] = nv - prev;
+
+    // the longest runs of the same value
+    std::multimap<uint32_t, double> runs;
+    for (uint32_t j = 0; j < nv; ) {
+        uint32_t i = j + 1;
+        while (i < nv && vals[i] == vals[j]) ++ i;
+        if (i - j > 1 &&
+            (runs.size() < FASTBIT_COLSTATS_MCVS ||
+             i - j > runs.begin()->first)) {
+            runs.insert(std::make_pair(i - j, vals[j]));
+            if (runs.size() > FASTBIT_COLSTATS_MCVS)
+                runs.erase(runs.begin());
+        }
+        j = i;
+    }
+    for (std::multimap<uint32_t, double>::const_reverse_iterator it =
+             runs.rbegin(); it != runs.rend(); ++ it) {
+        mcvs.push_back(it->second);
+        mcvcnt.push_back(it->first);
+    }
+} // ibis::colStats::fromSorted
+
+/// Compute the statistics of the rows [begin, end) of @c vals.  The rows
+/// marked 0 in @c mask are treated as null values.  The existing content
+/// is replaced.
+template <typename T>
+void ibis::colStats::compute(const ibis::array_t<T>& vals,
+                             const ibis::bitvector& mask,
+                             uint32_t begin, uint32_t end) {
+    if (end > vals.size())
+        end = vals.size();
+    if (begin > end)
+        begin = end;
+    nrows = end - begin;
+    nnull = 0;
+    vmin = std::numeric_limits<double>::max();
+    vmax = -std::numeric_limits<double>::max();
+    ibis::array_t<unsigned char>(1U << FASTBIT_COLSTATS_HLL_BITS, 0)
+        .swap(hll);
+
+    std::vector<double> tmp;
+    tmp.reserve(nrows);
+    for (ibis::bitvector::indexSet is = mask.firstIndexSet();
+         is.nIndices() > 0 && *(is.indices()) < end; ++ is) {
+        const ibis::bitvector::word_t *idx = is.indices();
+        if (is.isRange()) {
+            const uint32_t last = (idx[1] < end ? idx[1] : end);
+            for (uint32_t j = (idx[0] > begin ? idx[0] : begin);
+                 j < last; ++ j)
+                tmp.push_back(static_cast<double>(vals[j]));
+        }
+        else {
+            for (uint32_t i = 0; i < is.nIndices(); ++ i) {
+                if (idx[i] >= begin && idx[i] < end)
+                    tmp.push_back(static_cast<double>(vals[idx[i]]));
+            }
+        }
+    }
+    nnull = nrows - tmp.size();
+    for (size_t j = 0; j < tmp.size(); ++ j)
+        addHash(tmp[j]);
+    std::sort(tmp.begin(), tmp.end());
+    fromSorted(tmp);
+} // ibis::colStats::compute
+
+/// Merge the statistics of another set of rows into this one.  The counts,
+/// the minimum, the maximum and the sketch are combined exactly.  The two
+/// histograms are combined assuming that the values are uniformly
+/// distributed within each bin and then divided into equi-depth bins
+/// again.  The counts of the most common values are added and the most
+/// frequent ones are kept.
+void ibis::colStats::merge(const ibis::colStats& rhs) {
+    if (rhs.nrows == 0) return;
+    if (nrows == 0) {
+        nrows = rhs.nrows;
+        nnull = rhs.nnull;
+        vmin = rhs.vmin;
+        vmax = rhs.vmax;
+        bounds.deepCopy(rhs.bounds);
+        counts.deepCopy(rhs.counts);
+        mcvs.deepCopy(rhs.mcvs);
+        mcvcnt.deepCopy(rhs.mcvcnt);
+        hll.deepCopy(rhs.hll);
+        return;
+    }
+
+    // the union of the bin boundaries and the cumulative counts
+    std::vector<double> xs;
+    xs.reserve(bounds.size() + rhs.bounds.size());
+    xs.insert(xs.end(), bounds.begin(), bounds.end());
+    xs.insert(xs.end(), rhs.bounds.begin(), rhs.bounds.end());
+    std::sort(xs.begin(), xs.end());
+    xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+    std::vector<double> cs(xs.size());
+    for (size_t j = 0; j < xs.size(); ++ j)
+        cs[j] = cumulative(xs[j], true) + rhs.cumulative(xs[j], true);
+
+    const double tot = (cs.empty() ? 0.0 : cs.back());
+    const uint32_t nb = (tot < _ibis_colstats_nbins() ?
+                         static_cast<uint32_t>(tot) : _ibis_colstats_nbins());
+    ibis::array_t<double> nbounds;
+    ibis::array_t<uint32_t> ncounts;
+    if (nb > 0) {
+        nbounds.resize(nb+1);
+        ncounts.resize(nb);
+        nbounds[0] = xs.front();
+        nbounds[nb] = xs.back();
+        double prev = 0.0;
+        size_t i = 0;
+        for (uint32_t k = 1; k < nb; ++ k) {
+            const double target = tot * k / nb;
+            while (i < cs.size() && cs[i] < target) ++ i;
+            if (i == 0 || i >= cs.size() || cs[i] <= cs[i-1]) {
+                nbounds[k] = xs[i < xs.size() ? i : xs.size()-1];
+            }
+            else {
+                nbounds[k] = xs[i-1] + (xs[i] - xs[i-1]) *
+                    (target - cs[i-1]) / (cs[i] - cs[i-1]);
+            }
+            const double cur = std::floor(target + 0.5);
+            ncounts[k-1] = static_cast<uint32_t>(cur - prev);
+            prev = cur;
+        }
+        ncounts[nb-1] = static_cast<uint32_t>(std::floor(tot + 0.5) - prev);
+    }
+    nbounds.swap(bounds);
+    ncounts.swap(counts);
+
+    std::map<double, uint32_t> freq;
+    for (size_t j = 0; j < mcvs.size(); ++ j)
+        freq[mcvs[j]] += mcvcnt[j];
+    for (size_t j = 0; j < rhs.mcvs.size(); ++ j)
+        freq[rhs.mcvs[j]] += rhs.mcvcnt[j];
+    std::multimap<uint32_t, double> top;
+    for (std::map<double, uint32_t>::const_iterator it = freq.begin();
+         it != freq.end(); ++ it) {
+        top.insert(std::make_pair(it->second, it->first));
+        if (top.size() > FASTBIT_COLSTATS_MCVS)
+            top.erase(top.begin());
+    }
+    ibis::array_t<double>().swap(mcvs);
+    ibis::array_t<uint32_t>().swap(mcvcnt);
+    for (std::multimap<uint32_t, double>::const_reverse_iterator it =
+             top.rbegin(); it != top.rend(); ++ it) {
+        mcvs.push_back(it->second);
+        mcvcnt.push_back(it->first);
+    }
+
+    hll.nosharing();
+    for (size_t j = 0; j < hll.size() && j < rhs.hll.size(); ++ j)
+        if (hll[j] < rhs.hll[j])
+            hll[j] = rhs.hll[j];
+    nrows += rhs.nrows;
+    nnull += rhs.nnull;
+    if (vmin > rhs.vmin)
+        vmin = rhs.vmin;
+    if (vmax < rhs.vmax)
+        vmax = rhs.vmax;
+} // ibis::colStats::merge
+
+/// The estimated number of distinct values from the HyperLogLog sketch.
+double ibis::colStats::distinct() const {
+    if (nrows <= nnull) return 0.0;
+    const double m = hll.size();
+    double sum = 0.0;
+    uint32_t nzero = 0;
+    for (size_t j = 0; j < hll.size(); ++ j) {
+        sum += std::pow(2.0, -static_cast<double>(hll[j]));
+        nzero += (hll[j] == 0);
+    }
+    double est = (0.7213 / (1.0 + 1.079 / m)) * m * m / sum;
+    if (est <= 2.5 * m && nzero > 0) // linear counting for small counts
+        est = m * std::log(m / nzero);
+    if (est > nrows - nnull)
+        est = nrows - nnull;
+    if (est < 1.0)
+        est = 1.0;
+    return est;
+} // ibis::colStats::distinct
+
+/// The estimated number of values less than (or equal to if @c inclusive
+/// is true) @c x according to the histogram.
+double ibis::colStats::cumulative(double x, bool inclusive) const {
+    double sum = 0.0;
+    for (size_t k = 0; k < counts.size(); ++ k) {
+        if (x > bounds[k+1] || (inclusive && x == bounds[k+1])) {
+            sum += counts[k];
+        }
+        else if (x > bounds[k] || (inclusive && x == bounds[k])) {
+            if (bounds[k+1] > bounds[k])
+                sum += counts[k] * (x - bounds[k]) / (bounds[k+1] - bounds[k]);
+            else
+                sum += counts[k];
+            break;
+        }
+        else {
+            break;
+        }
+    }
+    return sum;
+} // ibis::colStats::cumulative
+
+/// The estimated number of rows equal to @c val.
+double ibis::colStats::estimateEqual(double val) const {
+    if (nrows <= nnull || val < vmin || val > vmax) return 0.0;
+    double common = 0.0;
+    for (size_t j = 0; j < mcvs.size(); ++ j) {
+        if (mcvs[j] == val)
+            return mcvcnt[j];
+        common += mcvcnt[j];
+    }
+    const double nd = distinct() - mcvs.size();
+    const double rest = (nrows - nnull) - common;
+    if (rest <= 0.0)
+        return 0.0;
+    return (nd > 1.0 ? rest / nd : rest);
+} // ibis::colStats::estimateEqual
+
+/// The estimated number of rows with values between @c lo and @c hi.
+double ibis::colStats::estimate(double lo, bool lo_inclusive,
+                                double hi, bool hi_inclusive) const {
+    if (nrows <= nnull || lo > hi) return 0.0;
+    if (lo == hi)
+        return (lo_inclusive && hi_inclusive ? estimateEqual(lo) : 0.0);
+    if (lo > vmax || hi < vmin) return 0.0;
+
+    double est = cumulative(hi, hi_inclusive) - cumulative(lo, ! lo_inclusive);
+    if (est < 0.0)
+        est = 0.0;
+    // a narrow range containing a common value has at least as many rows
+    for (size_t j = 0; j < mcvs.size(); ++ j) {
+        if ((mcvs[j] > lo || (lo_inclusive && mcvs[j] == lo)) &&
+            (mcvs[j] < hi || (hi_inclusive && mcvs[j] == hi)) &&
+            est < mcvcnt[j])
+            est = mcvcnt[j];
+    }
+    return est;
+} // ibis::colStats::estimate
+
+/// The estimated number of rows satisfying the range condition.
+double ibis::colStats::estimate(const ibis::qContinuousRange& cmp) const {
+    double lo = -std::numeric_limits<double>::infinity();
+    double hi = std::numeric_limits<double>::infinity();
+    bool loinc = true, hiinc = true;
+    switch (cmp.leftOperator()) {
+    case ibis::qExpr::OP_LT: lo = cmp.leftBound(); loinc = false; break;
+    case ibis::qExpr::OP_LE: lo = cmp.leftBound(); break;
+    case ibis::qExpr::OP_GT: hi = cmp.leftBound(); hiinc = false; break;
+    case ibis::qExpr::OP_GE: hi = cmp.leftBound(); break;
+    case ibis::qExpr::OP_EQ: lo = hi = cmp.leftBound(); break;
+    default: break;
+    }
+    switch (cmp.rightOperator()) {
+    case ibis::qExpr::OP_LT:
+        if (cmp.rightBound() <= hi) {hi = cmp.rightBound(); hiinc = false;}
+        break;
+    case ibis::qExpr::OP_LE:
+        if (cmp.rightBound() < hi) {hi = cmp.rightBound(); hiinc = true;}
+        break;
+    case ibis::qExpr::OP_GT:
+        if (cmp.rightBound() >= lo) {lo = cmp.rightBound(); loinc = false;}
+        break;
+    case ibis::qExpr::OP_GE:
+        if (cmp.rightBound() > lo) {lo = cmp.rightBound(); loinc = true;}
+        break;
+    case ibis::qExpr::OP_EQ:
+        if (cmp.rightBound() >= lo && cmp.rightBound() <= hi)
+            lo = hi = cmp.rightBound();
+        else
+            return 0.0;
+        break;
+    default: break;
+    }
+    return estimate(lo, loinc, hi, hiinc);
+} // ibis::colStats::estimate
+
+/// The estimated number of rows with one of the values of the discrete
+/// range condition.
+double ibis::colStats::estimate(const ibis::qDiscreteRange& cmp) const {
+    const ibis::array_t<double>& vals = cmp.getValues();
+    double est = 0.0;
+    for (size_t j = 0; j < vals.size(); ++ j)
+        est += estimateEqual(vals[j]);
+    if (est > nrows - nnull)
+        est = nrows - nnull;
+    return est;
+} // ibis::colStats::estimate
+
+/// Print a summary of the statistics.
+void ibis::colStats::print(std::ostream& out) const {
+    out << nrows << " row" << (nrows>1?"s":"") << ", " << nnull << " null";
+    if (nrows > nnull) {
+        out << ", min " << vmin << ", max " << vmax << ", ~"
+            << static_cast<uint64_t>(distinct() + 0.5)
+            << " distinct value(s), " << counts.size()
+            << " histogram bin(s)";
+        if (! mcvs.empty()) {
+            out << ", most common:";
+            for (size_t j = 0; j < mcvs.size() && j < 4; ++ j)
+                out << " " << mcvs[j] << " (" << mcvcnt[j] << ")";
+        }
+    }
+} // ibis::colStats::print
+
+/// Append a binary representation to @c out.  The values are written in
+/// the byte order of the machine.
+void ibis::colStats::serialize(std::string& out) const {
+    const uint32_t nb = counts.size();
+    const uint32_t nm = mcvs.size();
+    const uint32_t nh = hll.size();
+    out.append(reinterpret_cast<const char*>(&nrows), sizeof(nrows));
+    out.append(reinterpret_cast<const char*>(&nnull), sizeof(nnull));
+    out.append(reinterpret_cast<const char*>(&vmin), sizeof(vmin));
+    out.append(reinterpret_cast<const char*>(&vmax), sizeof(vmax));
+    out.append(reinterpret_cast<const char*>(&nb), sizeof(nb));
+    out.append(reinterpret_cast<const char*>(&nm), sizeof(nm));
+    out.append(reinterpret_cast<const char*>(&nh), sizeof(nh));
+    if (nb > 0) {
+        out.append(reinterpret_cast<const char*>(bounds.begin()),
+                   sizeof(double)*(nb+1));
+        out.append(reinterpret_cast<const char*>(counts.begin()),
+                   sizeof(uint32_t)*nb);
+    }
+    if (nm > 0) {
+        out.append(reinterpret_cast<const char*>(mcvs.begin()),
+                   sizeof(double)*nm);
+        out.append(reinterpret_cast<const char*>(mcvcnt.begin()),
+                   sizeof(uint32_t)*nm);
+    }
+    out.append(reinterpret_cast<const char*>(hll.begin()), nh);
+} // ibis::colStats::serialize
+
+/// Read the binary representation produced by serialize.  Advances @c ptr
+/// past the bytes used.  Returns 0 on success or a negative number if the
+/// bytes between @c ptr and @c end are not a valid representation.
+int ibis::colStats::deserialize(const char*& ptr, const char* end) {
+    const size_t head = 2*sizeof(uint32_t) + 2*sizeof(double) +
+        3*sizeof(uint32_t);
+    if (ptr + head > end) return -1;
+    uint32_t nb, nm, nh;
+    memcpy(&nrows, ptr, sizeof(nrows)); ptr += sizeof(nrows);
+    memcpy(&nnull, ptr, sizeof(nnull)); ptr += sizeof(nnull);
+    memcpy(&vmin, ptr, sizeof(vmin)); ptr += sizeof(vmin);
+    memcpy(&vmax, ptr, sizeof(vmax)); ptr += sizeof(vmax);
+    memcpy(&nb, ptr, sizeof(nb)); ptr += sizeof(nb);
+    memcpy(&nm, ptr, sizeof(nm)); ptr += sizeof(nm);
+    memcpy(&nh, ptr, sizeof(nh)); ptr += sizeof(nh);
+    if (nh != (1U << FASTBIT_COLSTATS_HLL_BITS) || nnull > nrows)
+        return -2;
+    const size_t body = (nb > 0 ? sizeof(double)*(nb+1) +
+                         sizeof(uint32_t)*nb : 0) +
+        (sizeof(double)+sizeof(uint32_t))*nm + nh;
+    if (ptr + body > end) return -3;
+
+    bounds.resize(nb > 0 ? nb+1 : 0);
+    counts.resize(nb);
+    if (nb > 0) {
+        memcpy(bounds.begin(), ptr, sizeof(double)*(nb+1));
+        ptr += sizeof(double)*(nb+1);
+        memcpy(counts.begin(), ptr, sizeof(uint32_t)*nb);
+        ptr += sizeof(uint32_t)*nb;
+    }
+    mcvs.resize(nm);
+    mcvcnt.resize(nm);
+    if (nm > 0) {
+        memcpy(mcvs.begin(), ptr, sizeof(double)*nm);
+        ptr += sizeof(double)*nm;
+        memcpy(mcvcnt.begin(), ptr, sizeof(uint32_t)*nm);
+        ptr += sizeof(uint32_t)*nm;
+    }
+    hll.resize(nh);
+    memcpy(hll.begin(), ptr, nh);
+    ptr += nh;
+    return 0;
+} // ibis::colStats::deserialize
+
+// explicit instantiations
+template void ibis::colStats::compute(const ibis::array_t<char>&,
+                                      const ibis::bitvector&,
+                                      uint32_t, uint32_t);
+template void ibis::colStats::compute(const ibis::array_t<unsigned char>&,
+                                      const ibis::bitvector&,
+                                      uint32_t, uint32_t);
+template void ibis::colStats::compute(const ibis::array_t<int16_t>&,
+                                      const ibis::bitvector&,
+                                      uint32_t, uint32_t);
+template void ibis::colStats::compute(const ibis::array_t<uint16_t>&,
+                                      const ibis::bitvector&,
+                                      uint32_t, uint32_t);
+template void ibis::colStats::compute(const ibis::array_t<int32_t>&,
+                                      const ibis::bitvector&,
+                                      uint32_t, uint32_t);
+template void ibis::colStats::compute(const ibis::array_t<uint32_t>&,
+                                      const ibis::bitvector&,
+                                      uint32_t, uint32_t);
+template void ibis::colStats::compute(const ibis::array_t<int64_t>&,
+                                      const ibis::bitvector&,
+                                      uint32_t, uint32_t);
+template void ibis::colStats::compute(const ibis::array_t<uint64_t>&,
+                                      const ibis::bitvector&,
+                                      uint32_t, uint32_t);
+template void ibis::colStats::compute(const ibis::array_t<float>&,
+                                      const ibis::bitvector&,
+                                      uint32_t, uint32_t);
+template void ibis::colStats::compute(const ibis::array_t<double>&,
+                                      const ibis::bitvector&,
+                                      uint32_t, uint32_t);
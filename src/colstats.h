@@ -0,0 +1,82 @@
+// File: $Id$
+// Author: John Wu <John.Wu at acm.org>
+//      Lawrence Berkeley National Laboratory
+// Copyright (c) 2007-2016 the Regents of the University of California
+#ifndef IBIS_COLSTATS_H
+#define IBIS_COLSTATS_H
+///@file
+/// Statistics of the values of a column for estimating the number of rows
+/// satisfying a condition without an index.
+///
+/// The statistics of a column consist of the number of rows, the number
+/// of null values, the minimum and maximum values, an equi-depth histogram,
+/// a HyperLogLog sketch for counting the distinct values and the most
+/// common values with their frequencies.  The statistics of all columns of
+/// a data partition are stored in the file -part.stats next to -part.txt.
+/// When rows are appended, the statistics of the new rows are computed and
+/// merged with the existing ones; the histogram and the most common values
+/// become approximations while the sketch remains as accurate as before.
+#include "array_t.h"    // ibis::array_t
+#include "bitvector.h"  // ibis::bitvector
+
+namespace ibis {
+    class colStats; // forward declaration
+    class qContinuousRange;
+    class qDiscreteRange;
+}
+
+/// The statistics of the values of a column.
+class FASTBIT_CXX_DLLSPEC ibis::colStats {
+public:
+    colStats();
+
+    template <typename T>
+    void compute(const ibis::array_t<T>& vals, const ibis::bitvector& mask,
+                 uint32_t begin, uint32_t end);
+    void merge(const colStats& rhs);
+    void swap(colStats& rhs);
+
+    /// Number of rows covered.
+    uint32_t nRows() const {return nrows;}
+    /// Number of rows with null values.
+    uint32_t nNulls() const {return nnull;}
+    /// Fraction of rows with null values.
+    double nullFraction() const {
+        return (nrows > 0 ? static_cast<double>(nnull) / nrows : 0.0);}
+    /// The smallest value.
+    double minimum() const {return vmin;}
+    /// The largest value.
+    double maximum() const {return vmax;}
+    double distinct() const;
+
+    double estimate(double lo, bool lo_inclusive,
+                    double hi, bool hi_inclusive) const;
+    double estimate(const ibis::qContinuousRange& cmp) const;
+    double estimate(const ibis::qDiscreteRange& cmp) const;
+    double estimateEqual(double val) const;
+
+    void print(std::ostream& out) const;
+    void serialize(std::string& out) const;
+    int deserialize(const char*& ptr, const char* end);
+
+protected:
+    uint32_t nrows; ///!< Number of rows.
+    uint32_t nnull; ///!< Number of null values.
+    double vmin;    ///!< The minimum value.
+    double vmax;    ///!< The maximum value.
+    /// Boundaries of the equi-depth histogram, one more than the bins.
+    ibis::array_t<double> bounds;
+    /// Number of values in each bin of the histogram.
+    ibis::array_t<uint32_t> counts;
+    /// The most common values.
+    ibis::array_t<double> mcvs;
+    /// The number of times the most common values appear.
+    ibis::array_t<uint32_t> mcvcnt;
+    /// Registers of the HyperLogLog sketch.
+    ibis::array_t<unsigned char> hll;
+
+    double cumulative(double x, bool inclusive) const;
+    void addHash(double v);
+    void fromSorted(const std::vector<double>& vals);
+}; // ibis::colStats
+#endif // IBIS_COLSTATS_H
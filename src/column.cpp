@@ -11,6 +11,10 @@
 #include "iroster.h"    // ibis::roster
 #include "irelic.h"     // ibis::relic
 #include "ibin.h"       // ibis::bin
+#include "colpack.h"    // ibis::colpack
+#include "idxpack.h"    // ibis::idxpack
+#include "colstats.h"   // ibis::colStats
+#include "metrics.h"    // ibis::metrics
 
 #include <stdarg.h>     // vsprintf
 #include <ctype.h>      // tolower
@@ -44,7 +48,7 @@ ibis::column::column(const ibis::part* tbl, ibis::TYPE_T t,
                      double low, double high) :
     thePart(tbl), m_type(t), m_name(name), m_desc(desc), m_bins(""),
     m_sorted(false), lower(low), upper(high), m_utscribe(0), dataflag(0),
-    idx(0), idxcnt() {
+    idx(0), idxcnt(), stats(0) {
     if (0 != pthread_rwlock_init(&rwlock, 0)) {
         throw "column::ctor failed to initialize the rwlock" IBIS_FILE_LINE;
     }
@@ -73,7 +77,8 @@ ibis::column::column(const ibis::part* tbl, ibis::TYPE_T t,
 /// A well-formed column must have a valid name, i.e., ! m_name.empty().
 ibis::column::column(const part* tbl, FILE* file)
     : thePart(tbl), m_type(UINT), m_sorted(false), lower(DBL_MAX),
-      upper(-DBL_MAX), m_utscribe(0), dataflag(0), idx(0), idxcnt() {
+      upper(-DBL_MAX), m_utscribe(0), dataflag(0), idx(0), idxcnt(),
+      stats(0) {
     char buf[MAX_LINE];
     char *s1;
     char *s2;
@@ -315,7 +320,7 @@ ibis::column::column(const ibis::column& rhs) :
     m_name(rhs.m_name), m_desc(rhs.m_desc), m_bins(rhs.m_bins),
     m_sorted(rhs.m_sorted), lower(rhs.lower), upper(rhs.upper),
     m_utscribe(rhs.m_utscribe), dataflag(0),
-    idx(rhs.idx!=0 ? rhs.idx->dup() : 0), idxcnt() {
+    idx(rhs.idx!=0 ? rhs.idx->dup() : 0), idxcnt(), stats(0) {
     if (pthread_rwlock_init(&rwlock, 0)) {
         throw "column::ctor failed to initialize the rwlock" IBIS_FILE_LINE;
     }
@@ -341,6 +346,7 @@ ibis::column::~column() {
         writeLock wk(this, "~column");
         delete idx;
     }
+    delete stats;
 
     pthread_mutex_destroy(&mutex);
     pthread_rwlock_destroy(&rwlock);
@@ -1078,13 +1084,326 @@ bool ibis::column::hasRawData() const {
 
         const unsigned elm = elementSize();
         if (elm == 0) return true;
-        return (elm*nRows() == ibis::util::getFileSize(name));
+        if (elm*nRows() == ibis::util::getFileSize(name))
+            return true;
+        return (ibis::colpack::isPacked(name) &&
+                elm*nRows() == ibis::colpack::unpackedSize(name));
     }
     else {
         return (dataflag > 0);
     }
 } // ibis::column::hasRawData
 
+/// Replace the raw data file with a packed data file.  The values are
+/// compressed in blocks as described in ibis::colpack.  Afterward, the
+/// file manager decodes the whole file when the content of the raw data
+/// file is requested, while the functions selectValues and
+/// ibis::part::doScan decode only the blocks containing the selected
+/// rows.  Only columns with fixed-size elements can be packed.  Appending
+/// to a packed column restores the raw data file first.
+///
+/// Return the size of the packed data file in bytes, 0 if the column is
+/// already packed, or a negative number to indicate error.
+long ibis::column::packData() {
+    if (thePart == 0 || thePart->currentDataDir() == 0 ||
+        thePart->nRows() == 0)
+        return 0;
+    if (elementSize() <= 0 || m_type == ibis::CATEGORY ||
+        m_type == ibis::TEXT || m_type == ibis::BLOB)
+        return -2;
+
+    std::string fnm;
+    if (dataFileName(fnm) == 0)
+        return -1;
+    if (ibis::colpack::isPacked(fnm.c_str()))
+        return 0;
+
+    std::string evt = "column[";
+    evt += fullname();
+    evt += "]::packData";
+    writeLock lock(this, evt.c_str());
+    int64_t ierr = ibis::colpack::pack(fnm.c_str(), m_type, thePart->nRows());
+    if (ierr <= 0) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- " << evt << " failed to pack " << fnm
+            << ", ierr = " << ierr;
+        return (ierr < 0 ? ierr : -3);
+    }
+
+    ibis::fileManager::instance().flushFile(fnm.c_str());
+    if (remove(fnm.c_str()) != 0) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- " << evt << " failed to remove " << fnm
+            << " ... " << (errno ? strerror(errno) : "??");
+        std::string pk;
+        ibis::colpack::packedName(fnm.c_str(), pk);
+        remove(pk.c_str());
+        return -4;
+    }
+
+    LOGGER(ibis::gVerbose > 2)
+        << evt << " replaced " << elementSize()*thePart->nRows()
+        << " bytes in " << fnm << " with " << ierr << " bytes";
+    return ierr;
+} // ibis::column::packData
+
+/// Restore the raw data file of a packed column.  Return the size of the
+/// raw data file, 0 if the column is not packed, or a negative number to
+/// indicate error.
+long ibis::column::unpackData() {
+    std::string fnm;
+    if (dataFileName(fnm) == 0)
+        return 0;
+    if (! ibis::colpack::isPacked(fnm.c_str()))
+        return 0;
+
+    writeLock lock(this, "unpackData");
+    ibis::fileManager::instance().flushFile(fnm.c_str());
+    return ibis::colpack::unpack(fnm.c_str());
+} // ibis::column::unpackData
+
+/// Replace the index file with a packed index file.  The bitmaps are
+/// compressed in blocks as described in ibis::idxpack.  Afterward, the
+/// index is reconstructed from the uncompressed part of the packed file
+/// and only the blocks containing the bitmaps needed to answer a query are
+/// decompressed.  Only the equality encoded indexes of type
+/// ibis::index::RELIC, ibis::index::DIREKTE and ibis::index::KEYWORDS are
+/// packed.  Appending to the column restores the index file first.
+///
+/// Return the size of the packed index file in bytes, 0 if the index is
+/// already packed, or a negative number to indicate error.
+long ibis::column::packIndex() {
+    if (thePart == 0 || thePart->currentDataDir() == 0 ||
+        thePart->nRows() == 0)
+        return 0;
+
+    std::string fnm;
+    if (dataFileName(fnm) == 0)
+        return -1;
+    fnm += ".idx";
+    if (ibis::idxpack::isPacked(fnm.c_str()))
+        return 0;
+
+    std::string evt = "column[";
+    evt += fullname();
+    evt += "]::packIndex";
+    int64_t keep = 0, end = 0;
+    loadIndex();
+    {
+        indexLock lock(this, evt.c_str());
+        const ibis::index* ind = lock.getIndex();
+        if (ind == 0)
+            return -1;
+        if (ind->type() != ibis::index::RELIC &&
+            ind->type() != ibis::index::DIREKTE &&
+            ind->type() != ibis::index::KEYWORDS)
+            return -2;
+        ind->bitmapRange(keep, end);
+    }
+    if (keep < 16 || end <= keep ||
+        end != (int64_t)ibis::util::getFileSize(fnm.c_str())) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- " << evt << " expects the bitmaps of " << fnm
+            << " to occupy bytes [" << keep << ", " << end
+            << ") at the end of the file";
+        return -3;
+    }
+
+    writeLock lock(this, evt.c_str());
+    if (idxcnt() != 0)
+        return -4;
+    int64_t ierr = ibis::idxpack::pack(fnm.c_str(), keep);
+    if (ierr <= 0) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- " << evt << " failed to pack " << fnm
+            << ", ierr = " << ierr;
+        return (ierr < 0 ? ierr : -5);
+    }
+
+    delete idx;
+    idx = 0;
+    ibis::fileManager::instance().flushFile(fnm.c_str());
+    if (remove(fnm.c_str()) != 0) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- " << evt << " failed to remove " << fnm
+            << " ... " << (errno ? strerror(errno) : "??");
+        std::string pk;
+        ibis::idxpack::packedName(fnm.c_str(), pk);
+        ibis::fileManager::instance().flushBlocks(pk.c_str());
+        remove(pk.c_str());
+        return -6;
+    }
+
+    LOGGER(ibis::gVerbose > 2)
+        << evt << " replaced " << end << " bytes in " << fnm << " with "
+        << ierr << " bytes";
+    return ierr;
+} // ibis::column::packIndex
+
+/// Restore the index file from the packed index file.  Return the size of
+/// the index file, 0 if the index is not packed, or a negative number to
+/// indicate error.
+long ibis::column::unpackIndex() {
+    std::string fnm;
+    if (dataFileName(fnm) == 0)
+        return 0;
+    fnm += ".idx";
+    if (! ibis::idxpack::isPacked(fnm.c_str()))
+        return 0;
+
+    writeLock lock(this, "unpackIndex");
+    if (idxcnt() == 0) {
+        delete idx;
+        idx = 0;
+    }
+    return ibis::idxpack::unpack(fnm.c_str());
+} // ibis::column::unpackIndex
+
+/// Compute the statistics of the values in rows [begin, end).  Only the
+/// numerical columns have statistics.  Returns 0 on success or a negative
+/// number to indicate error.
+int ibis::column::computeStatistics(ibis::colStats& st, uint32_t begin,
+                                    uint32_t end) const {
+    if (! isNumeric())
+        return -1;
+
+    ibis::bitvector msk;
+    getNullMask(msk);
+    if (msk.size() < end)
+        msk.adjustSize(0, end);
+    int ierr = 0;
+    switch (m_type) {
+    case ibis::BYTE: {
+        array_t<char> vals;
+        ierr = getValuesArray(&vals);
+        if (ierr >= 0)
+            st.compute(vals, msk, begin, end);
+        break;}
+    case ibis::UBYTE: {
+        array_t<unsigned char> vals;
+        ierr = getValuesArray(&vals);
+        if (ierr >= 0)
+            st.compute(vals, msk, begin, end);
+        break;}
+    case ibis::SHORT: {
+        array_t<int16_t> vals;
+        ierr = getValuesArray(&vals);
+        if (ierr >= 0)
+            st.compute(vals, msk, begin, end);
+        break;}
+    case ibis::USHORT: {
+        array_t<uint16_t> vals;
+        ierr = getValuesArray(&vals);
+        if (ierr >= 0)
+            st.compute(vals, msk, begin, end);
+        break;}
+    case ibis::INT: {
+        array_t<int32_t> vals;
+        ierr = getValuesArray(&vals);
+        if (ierr >= 0)
+            st.compute(vals, msk, begin, end);
+        break;}
+    case ibis::UINT: {
+        array_t<uint32_t> vals;
+        ierr = getValuesArray(&vals);
+        if (ierr >= 0)
+            st.compute(vals, msk, begin, end);
+        break;}
+    case ibis::LONG: {
+        array_t<int64_t> vals;
+        ierr = getValuesArray(&vals);
+        if (ierr >= 0)
+            st.compute(vals, msk, begin, end);
+        break;}
+    case ibis::ULONG: {
+        array_t<uint64_t> vals;
+        ierr = getValuesArray(&vals);
+        if (ierr >= 0)
+            st.compute(vals, msk, begin, end);
+        break;}
+    case ibis::FLOAT: {
+        array_t<float> vals;
+        ierr = getValuesArray(&vals);
+        if (ierr >= 0)
+            st.compute(vals, msk, begin, end);
+        break;}
+    case ibis::DOUBLE: {
+        array_t<double> vals;
+        ierr = getValuesArray(&vals);
+        if (ierr >= 0)
+            st.compute(vals, msk, begin, end);
+        break;}
+    default:
+        ierr = -2;
+        break;
+    }
+    if (ierr < 0) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- column[" << fullname() << "]::computeStatistics "
+            "failed to read the values, ierr = " << ierr;
+        return ierr;
+    }
+    return 0;
+} // ibis::column::computeStatistics
+
+/// Make a copy of the statistics of the values.  Returns false if the
+/// statistics are not available.
+/// @sa ibis::part::loadStatistics
+bool ibis::column::getStatistics(ibis::colStats& st) const {
+    ibis::colStats tmp;
+    {
+        ibis::util::mutexLock lck(&mutex, "column::getStatistics");
+        if (stats == 0)
+            return false;
+        tmp.merge(*stats);
+    }
+    st.swap(tmp);
+    return true;
+} // ibis::column::getStatistics
+
+/// Replace the statistics of the values with a copy of @c st.  A nil
+/// pointer removes the statistics.  If the minimum and the maximum of the
+/// column are not known, they are taken from the statistics, which allows
+/// the conditions outside of the range of the values to be recognized
+/// without reading the values.
+void ibis::column::setStatistics(const ibis::colStats* st) {
+    ibis::colStats* tmp = 0;
+    if (st != 0) {
+        tmp = new ibis::colStats;
+        tmp->merge(*st);
+        if (! (lower <= upper) && tmp->nRows() > tmp->nNulls()) {
+            lower = tmp->minimum();
+            upper = tmp->maximum();
+        }
+    }
+
+    ibis::util::mutexLock lck(&mutex, "column::setStatistics");
+    delete stats;
+    stats = tmp;
+} // ibis::column::setStatistics
+
+/// Estimate the fraction of rows satisfying the range condition from the
+/// statistics of the values.  Returns a negative number if the statistics
+/// are not available.
+double ibis::column::estimateSelectivity
+(const ibis::qContinuousRange& cmp) const {
+    ibis::util::mutexLock lck(&mutex, "column::estimateSelectivity");
+    if (stats == 0 || stats->nRows() == 0)
+        return -1.0;
+    return stats->estimate(cmp) / stats->nRows();
+} // ibis::column::estimateSelectivity
+
+/// Estimate the fraction of rows satisfying the discrete range condition
+/// from the statistics of the values.  Returns a negative number if the
+/// statistics are not available.
+double ibis::column::estimateSelectivity
+(const ibis::qDiscreteRange& cmp) const {
+    ibis::util::mutexLock lck(&mutex, "column::estimateSelectivity");
+    if (stats == 0 || stats->nRows() == 0)
+        return -1.0;
+    return stats->estimate(cmp) / stats->nRows();
+} // ibis::column::estimateSelectivity
+
 /// Return the content of base data file as a storage object.
 ibis::fileManager::storage* ibis::column::getRawData() const {
     if (dataflag < 0) return 0;
@@ -4679,6 +4998,16 @@ long ibis::column::selectValuesT(const char* dfn,
             << " failed to allocate space for vals[" << tot << "]";
         return -2;
     }
+    if (dfn != 0 && *dfn != 0 && ibis::colpack::isPacked(dfn)) {
+        // decode only the blocks containing the selected values
+        ierr = ibis::colpack::selectValues(dfn, mask, vals);
+        LOGGER(ierr >= 0 && static_cast<unsigned long>(ierr) != tot &&
+               ibis::gVerbose > 0)
+            << "Warning -- " << evt << " got " << ierr << " out of "
+            << tot << " values from the packed version of " << dfn;
+        return ierr;
+    }
+
     array_t<T> incore; // make the raw storage more friendly
     if (dfn != 0 && *dfn != 0) {
         const off_t sz = ibis::util::getFileSize(dfn);
@@ -4877,6 +5206,16 @@ long ibis::column::selectValuesT(const char *dfn,
         return -2;
     }
 
+    if (dfn != 0 && *dfn != 0 && ibis::colpack::isPacked(dfn)) {
+        // decode only the blocks containing the selected values
+        ierr = ibis::colpack::selectValues(dfn, mask, vals, inds);
+        LOGGER(ierr >= 0 && static_cast<unsigned long>(ierr) != tot &&
+               ibis::gVerbose > 0)
+            << "Warning -- " << evt << " got " << ierr << " out of "
+            << tot << " values from the packed version of " << dfn;
+        return ierr;
+    }
+
     array_t<T> incore;
     if (dfn != 0 && *dfn != 0) {
         const off_t sz = ibis::util::getFileSize(dfn);
@@ -5780,6 +6119,8 @@ void ibis::column::loadIndex(const char* iopt, int ropt) const throw () {
         }
     }
 
+    ibis::metrics::timer mt(ibis::metrics::indexLoadTime);
+    ibis::metrics::indexLoads.add();
     ibis::index* tmp = 0;
     try { // if an index is not available, create one
         LOGGER(ibis::gVerbose > 4)
@@ -5950,6 +6291,79 @@ uint32_t ibis::column::indexedRows() const {
     }
 } // ibis::column::indexedRows
 
+/// Rebuild an index that lags behind the data.  When the index rebuilder
+/// is on (see ibis::part::indexRebuilderOn) and ibis::column::append can
+/// not extend an existing index, the index file is kept for the rows it
+/// covers and the new rows are scanned during query processing.  This
+/// function builds a new index over all rows once the rows not covered
+/// make up more than @c frac of the rows in the data partition.  The old
+/// bitmaps are not reused.
+///
+/// It returns the number of rows added to the index, zero if there is
+/// nothing to do, or a negative number to indicate error.
+///
+/// @note The index is built while holding the write lock on the column,
+/// the same way as in ibis::column::loadIndex.  Queries on this column
+/// wait for the new index instead of reading a partially written file.
+long ibis::column::rebuildLaggingIndex(double frac) const {
+    if (thePart == 0 || thePart->currentDataDir() == 0 ||
+        thePart->nRows() == 0)
+        return 0;
+
+    std::string fnm;
+    if (dataFileName(fnm) == 0)
+        return 0;
+    fnm += ".idx";
+    if (ibis::util::getFileSize(fnm.c_str()) <= 0)
+        return 0; // no index to merge into
+
+    std::string evt = "column[";
+    evt += fullname();
+    evt += "]::rebuildLaggingIndex";
+    writeLock lock(this, evt.c_str());
+    const uint32_t nr = thePart->nRows();
+    uint32_t ni = 0;
+    if (idx != 0) {
+        ni = idx->getNRows();
+    }
+    else {
+        std::unique_ptr<ibis::index>
+            tmp(ibis::index::create(this, thePart->currentDataDir()));
+        if (tmp.get() != 0)
+            ni = tmp->getNRows();
+    }
+    if (ni >= nr || (double)(nr - ni) < frac * nr)
+        return 0;
+    if (idxcnt() != 0) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- " << evt << " can not proceed because the index "
+            "is in use";
+        return -1;
+    }
+
+    delete idx;
+    idx = 0;
+    ibis::horometer timer;
+    if (ibis::gVerbose > 2)
+        timer.start();
+    std::unique_ptr<ibis::index>
+        tmp(ibis::index::create(this, static_cast<const char*>(0)));
+    if (tmp.get() == 0 || tmp->getNRows() != nr) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- " << evt << " failed to rebuild the index for "
+            << nr << " row" << (nr > 1 ? "s" : "");
+        return -2;
+    }
+    if (ibis::gVerbose > 2) {
+        timer.stop();
+        ibis::util::logger lg;
+        lg() << evt << " added " << nr - ni << " row" << (nr-ni > 1 ? "s" : "")
+             << " to the index of " << ni << " row" << (ni > 1 ? "s" : "")
+             << " in " << timer.realTime() << " sec";
+    }
+    return nr - ni;
+} // ibis::column::rebuildLaggingIndex
+
 /// Perform a set of built-in tests to determine the speed of common
 /// operations.
 void ibis::column::indexSpeedTest() const {
@@ -5976,6 +6390,9 @@ void ibis::column::purgeIndexFile(const char *dir) const {
     fnm += ".idx";
     ibis::fileManager::instance().flushFile(fnm.c_str());
     remove(fnm.c_str());
+    fnm += ".pk";
+    ibis::fileManager::instance().flushBlocks(fnm.c_str());
+    remove(fnm.c_str());
     fnm.erase(len);
     fnm += "bin";
     ibis::fileManager::instance().flushFile(fnm.c_str());
@@ -6021,6 +6438,153 @@ int ibis::column::contractRange(ibis::qContinuousRange& rng) const {
     return ret;
 } // ibis::column::contractRange
 
+/// The work of operating on one byte of bitmaps relative to reading one
+/// byte.
+#ifndef FASTBIT_COST_BITMAP_OP
+#define FASTBIT_COST_BITMAP_OP 0.5
+#endif
+/// The work of comparing one value with a range condition relative to
+/// reading one byte.
+#ifndef FASTBIT_COST_COMPARE
+#define FASTBIT_COST_COMPARE 1.0
+#endif
+
+/// Name of an access method.
+const char* ibis::column::accessPlan::name(METHOD m) {
+    switch (m) {
+    case NONE:       return "none";
+    case SCAN:       return "scan";
+    case INDEX:      return "index";
+    case INDEX_SCAN: return "index+scan";
+    case SORTED:     return "sorted";
+    default:         return "?";
+    }
+} // ibis::column::accessPlan::name
+
+/// Print the method and the estimated costs.
+void ibis::column::accessPlan::print(std::ostream& out) const {
+    out << name(method);
+    if (method == NONE) return;
+    out << " (scan " << scanCost;
+    if (indexBytes > 0.0 || bitmapCost > 0.0) {
+        out << ", index " << indexBytes << " bytes + bitmap operations "
+            << bitmapCost;
+        if (candidates > 0.0)
+            out << " + checking " << candidates << " candidate"
+                << (candidates > 1.0 ? "s " : " ") << checkCost;
+        out << " = " << indexCost();
+    }
+    out << ')';
+} // ibis::column::accessPlan::print
+
+/// Choose how to evaluate the range condition on the rows marked 1 in @c
+/// mask.  The index is loaded if necessary.
+void ibis::column::chooseAccess(const ibis::qContinuousRange& cmp,
+                                const ibis::bitvector& mask,
+                                accessPlan& plan) const {
+    indexLock lock(this, "chooseAccess");
+    planAccess(cmp, mask, plan);
+} // ibis::column::chooseAccess
+
+/// Choose how to evaluate the discrete range condition on the rows marked
+/// 1 in @c mask.  The index is loaded if necessary.
+void ibis::column::chooseAccess(const ibis::qDiscreteRange& cmp,
+                                const ibis::bitvector& mask,
+                                accessPlan& plan) const {
+    indexLock lock(this, "chooseAccess");
+    planAccess(cmp, mask, plan);
+} // ibis::column::chooseAccess
+
+/// Compare the costs of the ways to evaluate a range condition.  The
+/// sequential scan reads the pages of the raw data containing the rows in
+/// @c mask and compares every value.  The index reads the bitmaps and
+/// operates on them; the rows the index can not decide are then checked
+/// against the raw data.  Since the candidates are spread over the data
+/// file, checking a small fraction of the rows may touch most of the
+/// pages, which is why a poorly selective condition on a binned index can
+/// be slower than a single sequential scan.
+///
+/// The caller must hold the index lock.
+void ibis::column::planAccess(const ibis::qContinuousRange& cmp,
+                              const ibis::bitvector& mask,
+                              accessPlan& plan) const {
+    plan = accessPlan();
+    if ((cmp.leftOperator() == ibis::qExpr::OP_UNDEFINED &&
+         cmp.rightOperator() == ibis::qExpr::OP_UNDEFINED) ||
+        ! cmp.overlap(lower, upper) || mask.cnt() == 0)
+        return;
+
+    const int esize = elementSize();
+    const unsigned elem = (esize > 0 ? esize : 8);
+    const double psize = ibis::fileManager::pageSize();
+    const double pages = ibis::part::countPages(mask, elem);
+    plan.scanCost = psize * pages + FASTBIT_COST_COMPARE * mask.cnt() +
+        8.0 * mask.size() / psize;
+    if (idx == 0) {
+        plan.method = (m_sorted && dataflag >= 0 ? accessPlan::SORTED :
+                       accessPlan::SCAN);
+        return;
+    }
+
+    idx->estimateWork(cmp, plan.indexBytes, plan.candidates);
+    plan.bitmapCost = FASTBIT_COST_BITMAP_OP * plan.indexBytes +
+        mask.bytes();
+    if (idx->getNRows() < mask.size()) // rows not in the index
+        plan.candidates += mask.size() - idx->getNRows();
+    if (plan.candidates > 0.0) {
+        // only the candidates in the mask are checked
+        const double cnd = plan.candidates * mask.cnt() / mask.size();
+        const double frac = (cnd < mask.cnt() ? cnd / mask.cnt() : 1.0);
+        const double touched = pages * (1.0 - pow(1.0 - frac, psize / elem));
+        plan.checkCost = psize * touched + FASTBIT_COST_COMPARE * cnd;
+    }
+
+    if (dataflag < 0 || plan.indexCost() < plan.scanCost)
+        plan.method = (plan.candidates > 0.0 ? accessPlan::INDEX_SCAN :
+                       accessPlan::INDEX);
+    else if (m_sorted)
+        plan.method = accessPlan::SORTED;
+    else
+        plan.method = accessPlan::SCAN;
+} // ibis::column::planAccess
+
+/// Compare the costs of the ways to evaluate a discrete range condition.
+/// The index answers a discrete range condition exactly, but the bitmaps
+/// of the values have to be combined.  The caller must hold the index
+/// lock.
+void ibis::column::planAccess(const ibis::qDiscreteRange& cmp,
+                              const ibis::bitvector& mask,
+                              accessPlan& plan) const {
+    plan = accessPlan();
+    if (cmp.getValues().empty() || ! cmp.overlap(lower, upper) ||
+        mask.cnt() == 0)
+        return;
+
+    const int esize = elementSize();
+    const unsigned elem = (esize > 0 ? esize : 8);
+    const double psize = ibis::fileManager::pageSize();
+    plan.scanCost = psize * ibis::part::countPages(mask, elem) +
+        FASTBIT_COST_COMPARE * mask.cnt() *
+        (1.0 + log((double)cmp.nItems())) +
+        8.0 * mask.size() / psize;
+    if (idx == 0) {
+        plan.method = (m_sorted && dataflag >= 0 ? accessPlan::SORTED :
+                       accessPlan::SCAN);
+        return;
+    }
+
+    plan.indexBytes = idx->estimateCost(cmp);
+    plan.bitmapCost = plan.indexBytes * (FASTBIT_COST_BITMAP_OP +
+                                         log((double)cmp.nItems())) +
+        mask.bytes();
+    if (dataflag < 0 || plan.indexCost() <= plan.scanCost)
+        plan.method = accessPlan::INDEX;
+    else if (m_sorted)
+        plan.method = accessPlan::SORTED;
+    else
+        plan.method = accessPlan::SCAN;
+} // ibis::column::planAccess
+
 /// Compute the exact answer.  Attempts to use the index if one is
 /// available, otherwise use the base data.
 ///
@@ -6087,29 +6651,20 @@ long ibis::column::evaluateRange(const ibis::qContinuousRange& cmp,
                             dataflag = 1;
                         }
                         else {
-                            dataflag = -1;
+                            dataflag = (hasRawData() ? 1 : -1);
                         }
                     }
                 }
-                if (dataflag < 0) {
+                // use the index only if it is estimated to be cheaper
+                // than the sequential scan, see planAccess
+                accessPlan plan;
+                planAccess(cmp, mask, plan);
+                LOGGER(ibis::gVerbose > 2)
+                    << evt << " -- chose " << plan;
+                if (plan.method == accessPlan::INDEX ||
+                    plan.method == accessPlan::INDEX_SCAN) {
                     idx->estimate(cmp, low, high);
                 }
-                else {
-                    // Using the index only if the cost of using the index
-                    // (icost) is less than the cost of using the sequential
-                    // scan (scost).  Both costs are estimated based on the
-                    // expected number of bytes to be accessed.
-                    const double icost = idx->estimateCost(cmp);
-                    const double scost = ibis::fileManager::pageSize() *
-                        ibis::part::countPages(mask, elementSize()) +
-                        8.0 * mask.size() / ibis::fileManager::pageSize();
-                    LOGGER(ibis::gVerbose > 2)
-                        << evt << " -- estimated cost with index = "
-                        << icost << ", with sequential scan = " << scost;
-                    if (icost < scost) {
-                        idx->estimate(cmp, low, high);
-                    }
-                }
             }
             else if (m_sorted && dataflag >= 0) {
                 ierr = searchSorted(cmp, low);
@@ -6379,8 +6934,12 @@ long ibis::column::evaluateRange(const ibis::qDiscreteRange& cmp,
                     }
                 }
             }
-            if (ierr < 0 && idxcost <= ibis::fileManager::pageSize() *
-                ibis::part::countPages(mask, elem)) {
+            accessPlan plan;
+            if (ierr < 0)
+                planAccess(cmp, mask, plan);
+            LOGGER(ibis::gVerbose > 2 && ierr < 0)
+                << evt << " -- chose " << plan;
+            if (ierr < 0 && plan.method == accessPlan::INDEX) {
                 // the normal indexing option
                 ierr = idx->evaluate(cmp, low);
                 if (ierr >= 0) {
@@ -6576,10 +7135,14 @@ long ibis::column::estimateRange(const ibis::qContinuousRange& cmp) const {
 
     try {
         indexLock lock(this, "estimateRange");
-        if (idx != 0)
+        if (idx != 0) {
             ret = idx->estimate(cmp);
-        else
+            if (thePart != 0 && idx->getNRows() < thePart->nRows())
+                ret += thePart->nRows() - idx->getNRows(); // short index
+        }
+        else {
             ret = -1;
+        }
         return ret;
     }
     catch (std::exception &se) {
@@ -6625,6 +7188,11 @@ double ibis::column::estimateCost(const ibis::qContinuousRange& cmp) const {
         ret = elementSize();
         ret = static_cast<double>(thePart != 0 ? thePart->nRows() :
                                   0xFFFFFFFFU) * (ret > 0.0 ? ret : 32.0);
+        // all values are read, but the more selective conditions reduce
+        // the work of the conditions evaluated after them
+        const double sel = estimateSelectivity(cmp);
+        if (sel >= 0.0)
+            ret *= 0.5 * (1.0 + (sel < 1.0 ? sel : 1.0));
     }
     return ret;
 } // ibis::column::estimateCost
@@ -6647,6 +7215,9 @@ double ibis::column::estimateCost(const ibis::qDiscreteRange& cmp) const {
         if (upper > lower && width >= 1.0 && width < (1.0+upper-lower)) {
             ret *= width / (upper - lower);
         }
+        const double sel = estimateSelectivity(cmp);
+        if (sel >= 0.0)
+            ret *= 0.5 * (1.0 + (sel < 1.0 ? sel : 1.0));
     }
     return ret;
 } // ibis::column::estimateCost
@@ -6665,6 +7236,14 @@ float ibis::column::getUndecidable(const ibis::qContinuousRange& cmp,
         indexLock lock(this, "getUndecidable");
         if (idx != 0) {
             ret = idx->undecidable(cmp, iffy);
+            if (thePart != 0 && idx->getNRows() < thePart->nRows()) {
+                // rows not yet in the index are all undecidable
+                const uint32_t ni = idx->getNRows();
+                const uint32_t nr = thePart->nRows();
+                ret = (ret * ni + (nr - ni)) / nr;
+                iffy.adjustSize(0, ni);
+                iffy.adjustSize(nr, nr);
+            }
         }
         else {
             getNullMask(iffy);
@@ -6701,8 +7280,11 @@ long ibis::column::estimateRange(const ibis::qDiscreteRange& cmp) const {
     long ret = (thePart != 0 ? thePart->nRows() : LONG_MAX);
     try {
         indexLock lock(this, "estimateRange");
-        if (idx != 0)
+        if (idx != 0) {
             ret = idx->estimate(cmp);
+            if (thePart != 0 && idx->getNRows() < thePart->nRows())
+                ret += thePart->nRows() - idx->getNRows(); // short index
+        }
         return ret;
     }
     catch (std::exception &se) {
@@ -6731,6 +7313,14 @@ float ibis::column::getUndecidable(const ibis::qDiscreteRange& cmp,
         indexLock lock(this, "getUndecidable");
         if (idx != 0) {
             ret = idx->undecidable(cmp, iffy);
+            if (thePart != 0 && idx->getNRows() < thePart->nRows()) {
+                // rows not yet in the index are all undecidable
+                const uint32_t ni = idx->getNRows();
+                const uint32_t nr = thePart->nRows();
+                ret = (ret * ni + (nr - ni)) / nr;
+                iffy.adjustSize(0, ni);
+                iffy.adjustSize(nr, nr);
+            }
         }
         else {
             getNullMask(iffy);
@@ -7095,6 +7685,18 @@ long ibis::column::append(const char* dt, const char* df,
         << evt << " -- source \"" << from << "\" --> destination \""
         << to << "\", nold=" << nold << ", nnew=" << nnew;
 
+    if (ibis::colpack::isPacked(to.c_str())) {
+        // restore the raw data file before appending to it
+        ibis::fileManager::instance().flushFile(to.c_str());
+        ierr = ibis::colpack::unpack(to.c_str());
+        if (ierr < 0) {
+            LOGGER(ibis::gVerbose > 0)
+                << "Warning -- " << evt << " failed to unpack \"" << to
+                << "\", ierr = " << ierr;
+            return -3;
+        }
+    }
+
     // open destination file, position the file pointer
     int dest = UnixOpen(to.c_str(), OPEN_WRITEADD, OPEN_FILEMODE);
     if (dest < 0) {
@@ -7277,6 +7879,8 @@ long ibis::column::append(const char* dt, const char* df,
     filename[j] = 'd';
     -- j;
     filename[j] = 'i';
+    if (ibis::idxpack::isPacked(filename.c_str()))
+        (void) ibis::idxpack::unpack(filename.c_str());
     j = ibis::util::getFileSize(filename.c_str());
     if (thePart->getState() == ibis::part::TRANSITION_STATE) {
         if (thePart->currentDataDir() != 0) {
@@ -7326,13 +7930,52 @@ long ibis::column::append(const char* dt, const char* df,
                 }
                 else {                  // failed to append
                     delete ind;
+                    ind = 0;
+#ifndef FASTBIT_REBUILD_INDEX_ON_SIZE_MISMATCH
+                    // keep the old index file if it is still intact and
+                    // the index rebuilder is on, the new rows are scanned
+                    // until the index is rebuilt
+                    if (thePart->indexRebuilderOn())
+                        ind = ibis::index::create(this, dt);
+                    if (ind != 0 && ind->getNRows() == nold) {
+                        LOGGER(ibis::gVerbose > 4)
+                            << evt << " failed to extend the index (code: "
+                            << ierr << "), keeping \"" << filename
+                            << "\" for the first " << nold << " row"
+                            << (nold > 1 ? "s" : "");
+                    }
+                    else {
+                        ibis::fileManager::instance().flushFile
+                            (filename.c_str());
+                        remove(filename.c_str());
+                        if (ibis::gVerbose > 4)
+                            logMessage("append", "failed to extend the "
+                                       "index (code: %ld), removing file "
+                                       "\"%s\"", ierr, filename.c_str());
+                    }
+                    delete ind;
+#else
                     remove(filename.c_str());
                     if (ibis::gVerbose > 4)
                         logMessage("append", "failed to extend the index "
                                    "(code: %ld), removing file \"%s\"",
                                    ierr, filename.c_str());
+#endif
                 }
             }
+#ifndef FASTBIT_REBUILD_INDEX_ON_SIZE_MISMATCH
+            else if (ind != 0 && ind->getNRows() > 0 &&
+                     ind->getNRows() < nold && thePart->indexRebuilderOn()) {
+                // the index already lags behind the data, leave it for
+                // the index rebuilder, see ibis::part::rebuildLaggingIndexes
+                LOGGER(ibis::gVerbose > 4)
+                    << evt << " keeps \"" << filename << "\" for the first "
+                    << ind->getNRows() << " row"
+                    << (ind->getNRows() > 1 ? "s" : "") << " of "
+                    << nold + nnew;
+                delete ind;
+            }
+#endif
 #ifdef APPEND_UPDATE_INDEXES
             else { // directly create the new indices
                 ind = ibis::index::create(this, dt);
@@ -9332,7 +9975,7 @@ double ibis::column::computeSum() const {
 double ibis::column::getActualMin() const {
     double ret;
     indexLock lock(this, "getActualMin");
-    if (idx != 0) {
+    if (idx != 0 && (thePart == 0 || idx->getNRows() >= thePart->nRows())) {
         ret = idx->getMin();
         if (! (ret < 0.0 || ret >= 0.0))
             ret = computeMin();
@@ -9346,7 +9989,7 @@ double ibis::column::getActualMin() const {
 double ibis::column::getActualMax() const {
     double ret;
     indexLock lock(this, "getActualMax");
-    if (idx != 0) {
+    if (idx != 0 && (thePart == 0 || idx->getNRows() >= thePart->nRows())) {
         ret = idx->getMax();
         if (! (ret < 0.0 || ret >= 0.0))
             ret = computeMax();
@@ -9360,7 +10003,7 @@ double ibis::column::getActualMax() const {
 double ibis::column::getSum() const {
     double ret;
     indexLock lock(this, "getSum");
-    if (idx != 0) {
+    if (idx != 0 && (thePart == 0 || idx->getNRows() >= thePart->nRows())) {
         ret = idx->getSum();
         if (! (ret < 0.0 || ret >= 0.0))
             ret = computeSum();
@@ -12122,7 +12765,11 @@ ibis::column::indexLock::~indexLock() {
 /// Constructor.  No error checking, both incoming arguments must be valid.
 ibis::column::readLock::readLock(const ibis::column* col, const char* m)
     : theColumn(col), mesg(m) {
-    int ierr = pthread_rwlock_rdlock(&(col->rwlock));
+    double wait;
+    int ierr = (ibis::util::lockStats::enabled ?
+                ibis::util::lockStats::rdlock(&(col->rwlock),
+                                              "column::readLock", m, wait) :
+                pthread_rwlock_rdlock(&(col->rwlock)));
     if (0 != ierr) {
         LOGGER(ibis::gVerbose >= 0)
             << "Warning -- column[" << theColumn->fullname()
@@ -12141,6 +12788,8 @@ ibis::column::readLock::readLock(const ibis::column* col, const char* m)
 
 /// Destructor.
 ibis::column::readLock::~readLock() {
+    if (ibis::util::lockStats::enabled)
+        ibis::util::lockStats::release(&(theColumn->rwlock));
     int ierr = pthread_rwlock_unlock(&(theColumn->rwlock));
     if (0 != ierr) {
         LOGGER(ibis::gVerbose >= 0)
@@ -12161,7 +12810,11 @@ ibis::column::readLock::~readLock() {
 /// Constructor.  No error checking, both incoming arguments must be valid.
 ibis::column::writeLock::writeLock(const ibis::column* col, const char* m)
     : theColumn(col), mesg(m) {
-    int ierr = pthread_rwlock_wrlock(&(col->rwlock));
+    double wait;
+    int ierr = (ibis::util::lockStats::enabled ?
+                ibis::util::lockStats::wrlock(&(col->rwlock),
+                                              "column::writeLock", m, wait) :
+                pthread_rwlock_wrlock(&(col->rwlock)));
     if (0 != ierr) {
         LOGGER(ibis::gVerbose >= 0)
             << "Warning -- column[" << theColumn->fullname()
@@ -12180,6 +12833,8 @@ ibis::column::writeLock::writeLock(const ibis::column* col, const char* m)
 
 /// Destructor.
 ibis::column::writeLock::~writeLock() {
+    if (ibis::util::lockStats::enabled)
+        ibis::util::lockStats::release(&(theColumn->rwlock));
     int ierr = pthread_rwlock_unlock(&(theColumn->rwlock));
     if (0 != ierr) {
         LOGGER(ibis::gVerbose >= 0)
@@ -36,6 +36,8 @@ namespace ibis { // additional names to the namespace ibis
     class colDoubles;
     class colStrings;
     class colBlobs;
+
+    class colStats;   // statistics of the values (colstats.h)
 } // namespace
 
 /// @ingroup FastBitIBIS
@@ -130,6 +132,7 @@ public:
     virtual long indexSize() const;
 
     uint32_t indexedRows() const;
+    long rebuildLaggingIndex(double frac=0.0) const;
     void indexSpeedTest() const;
     void purgeIndexFile(const char *dir=0) const;
 
@@ -160,6 +163,16 @@ public:
     virtual int getValuesArray(void* vals) const;
     virtual ibis::fileManager::storage* getRawData() const;
     virtual bool hasRawData() const;
+    long packData();
+    long unpackData();
+    long packIndex();
+    long unpackIndex();
+    int  computeStatistics(ibis::colStats& st, uint32_t begin,
+                           uint32_t end) const;
+    bool getStatistics(ibis::colStats& st) const;
+    void setStatistics(const ibis::colStats* st);
+    double estimateSelectivity(const ibis::qContinuousRange& cmp) const;
+    double estimateSelectivity(const ibis::qDiscreteRange& cmp) const;
     int  getDataflag() const {return dataflag;}
     void setDataflag(int df) {dataflag = df;}
 
@@ -278,6 +291,37 @@ public:
     virtual double estimateCost(const ibis::qAnyString&) const {
 	return 0;}
 
+    /// The method chosen to evaluate a range condition together with the
+    /// estimated costs behind the choice.  The costs are measured in bytes
+    /// read or the equivalent amount of work.
+    struct accessPlan {
+        /// Methods to evaluate a range condition.
+        enum METHOD {
+            NONE=0,     ///!< Decided without reading anything.
+            SCAN,       ///!< Sequential scan of the raw data.
+            INDEX,      ///!< Index alone.
+            INDEX_SCAN, ///!< Index, then check the candidates.
+            SORTED      ///!< Binary search of the sorted values.
+        };
+        METHOD method;     ///!< The method chosen.
+        double indexBytes; ///!< Bytes of the bitmaps read.
+        double bitmapCost; ///!< Work of operating on the bitmaps.
+        double candidates; ///!< Number of candidates to check.
+        double checkCost;  ///!< Work of checking the candidates.
+        double scanCost;   ///!< Work of the sequential scan.
+
+        accessPlan() : method(NONE), indexBytes(0.0), bitmapCost(0.0),
+                       candidates(0.0), checkCost(0.0), scanCost(0.0) {}
+        /// Total cost of using the index.
+        double indexCost() const {return indexBytes+bitmapCost+checkCost;}
+        static const char* name(METHOD m);
+        void print(std::ostream& out) const;
+    };
+    void chooseAccess(const ibis::qContinuousRange& cmp,
+                      const ibis::bitvector& mask, accessPlan& plan) const;
+    void chooseAccess(const ibis::qDiscreteRange& cmp,
+                      const ibis::bitvector& mask, accessPlan& plan) const;
+
     virtual float getUndecidable(const ibis::qContinuousRange& cmp,
 				 ibis::bitvector& iffy) const;
     /// Find rows that can not be decided with the existing index.
@@ -427,6 +471,9 @@ protected:
     mutable ibis::index* idx;
     /// The number of functions using the index.
     mutable ibis::util::sharedInt32 idxcnt;
+    /// The statistics of the values, loaded by ibis::part::loadStatistics.
+    /// Protected by the member variable mutex.
+    mutable ibis::colStats* stats;
 
     /// Print messages started with "Error" and throw a string exception.
     void logError(const char* event, const char* fmt, ...) const;
@@ -434,6 +481,10 @@ protected:
     /// aid of a dictionary.
     long string2int(int fptr, dictionary& dic, uint32_t nbuf, char* buf,
 		    array_t<uint32_t>& out) const;
+    void planAccess(const ibis::qContinuousRange& cmp,
+                    const ibis::bitvector& mask, accessPlan& plan) const;
+    void planAccess(const ibis::qDiscreteRange& cmp,
+                    const ibis::bitvector& mask, accessPlan& plan) const;
     /// Read the data values and compute the minimum value.
     double computeMin() const;
     /// Read the base data to compute the maximum value.
@@ -531,6 +582,8 @@ protected:
     friend class indexLock;
     friend class mutexLock;
     friend class softWriteLock;
+    // ibis::index::build changes the index specification temporarily
+    friend class ibis::index;
 
 private:
     /// The actual read-write lock used by readLock, writeLock and
@@ -593,7 +646,10 @@ public:
             << "]::gainExclusiveAccess for " << (mesg && *mesg ? mesg : "???");
         pthread_mutex_t *mtx = (theColumn ? &theColumn->mutex :
                                 &ibis::util::envLock);
-	int ierr = pthread_mutex_lock(mtx);
+	int ierr = (ibis::util::lockStats::enabled ?
+                    ibis::util::lockStats::lock
+                    (mtx, "column::mutexLock", mesg) :
+                    pthread_mutex_lock(mtx));
 	LOGGER(0 != ierr && ibis::gVerbose > 0)
 	    << "Warning -- column["
             << (theColumn ? theColumn->fullname() : "?.?")
@@ -608,6 +664,8 @@ public:
             << (mesg && *mesg ? mesg : "???");
         pthread_mutex_t *mtx = (theColumn ? &theColumn->mutex :
                                 &ibis::util::envLock);
+        if (ibis::util::lockStats::enabled)
+            ibis::util::lockStats::release(mtx);
 	int ierr = pthread_mutex_unlock(mtx);
 	LOGGER(0 != ierr && ibis::gVerbose > 0)
 	    << "Warning -- column["
@@ -736,6 +794,13 @@ inline std::ostream& operator<<(std::ostream& out, const ibis::column& prop) {
     return out;
 }
 
+// the operator to print an access plan to an output stream
+inline std::ostream& operator<<(std::ostream& out,
+                                const ibis::column::accessPlan& plan) {
+    plan.print(out);
+    return out;
+}
+
 namespace ibis { // for template specialization
     template <> long column::selectToStrings<signed char>
     (const char*, const bitvector&, std::vector<std::string>&) const;
@@ -10,6 +10,11 @@
 #endif
 #include "countQuery.h"         // class countQuery
 #include "query.h"              // ibis::query
+#include "advisor.h"            // ibis::advisor
+#include "profile.h"            // ibis::profile
+#include "metrics.h"            // ibis::metrics
+#include "workload.h"           // ibis::workload
+#include "resultCache.h"        // ibis::resultCache
 
 #include <memory>       // std::unique_ptr
 #include <sstream>      // std::ostringstream
@@ -190,6 +195,36 @@ int ibis::countQuery::setWhereClause(const ibis::qExpr* qx) {
     return ierr;
 } // ibis::countQuery::setWhereClause
 
+/// This function accepts a where clause that has already been verified on
+/// the data partition of this query.  The content of the argument is taken
+/// over and the argument is left with the previous where clause.  No
+/// parsing or verification is performed.
+int ibis::countQuery::setWhereClause(ibis::whereClause& wc) {
+    if (wc.getExpr() == 0) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- countQuery::setWhereClause will not use an empty "
+            "where clause";
+        return -4;
+    }
+
+    wc.swap(conds);
+    if (hits == cand) {
+        delete hits;
+        hits = 0;
+        cand = 0;
+    }
+    else {
+        delete hits;
+        delete cand;
+        hits = 0;
+        cand = 0;
+    }
+    LOGGER(ibis::gVerbose > 1)
+        << "countQuery::setWhereClause accepted new query conditions \""
+        << *conds.getExpr() << "\"";
+    return 0;
+} // ibis::countQuery::setWhereClause
+
 /// Compute the possible hits expressed as hits and cand, where hits
 /// contains definite hits and cand may contain additional rows that need
 /// to be further examined.  This is done by using the indexes.  If
@@ -205,6 +240,25 @@ int ibis::countQuery::estimate() {
         return -1;
     }
     ibis::util::timer mytime("countQuery::estimate", 2);
+    ibis::profile::phase ph("estimate", mypart->name());
+    ibis::metrics::timer mt(ibis::metrics::estimateTime);
+    if (conds.getExpr() != 0) { // the exact hits may have been cached
+        ibis::bitvector tmp;
+        if (ibis::resultCache::lookup
+            (ibis::resultCache::key(*mypart, conds.getExpr(),
+                                    m_sel != 0 ? m_sel->getString() : 0),
+             tmp)) {
+            delete cand;
+            cand = 0;
+            delete hits;
+            hits = new ibis::bitvector;
+            hits->swap(tmp);
+            LOGGER(ibis::gVerbose > 1)
+                << "countQuery::estimate -- number of hits is "
+                << hits->cnt() << " (cached)";
+            return 0;
+        }
+    }
 #ifndef DONOT_REORDER_EXPRESSION
     if (conds.getExpr() != 0 && false == conds->directEval()) {
         ibis::query::weight wt(mypart);
@@ -290,6 +344,15 @@ long ibis::countQuery::getMaxNumHits() const {
 ///
 /// Returns 0 for success, a negative value for error.
 int ibis::countQuery::evaluate() {
+    ibis::workload::capture cap("count");
+    if (cap.active()) { // record the call and its result
+        cap.add(mypart != 0 ? mypart->name() : 0);
+        cap.add(conds.getString());
+        int ierr = evaluate();
+        cap.setRows(ierr >= 0 ? getNumHits() : -1);
+        return ierr;
+    }
+
     if (mypart == 0 || mypart->nRows() == 0 || mypart->nColumns() == 0) {
         LOGGER(ibis::gVerbose > 1)
             << "Warning -- countQuery::evaluate() can not proceed on an "
@@ -298,6 +361,26 @@ int ibis::countQuery::evaluate() {
     }
     int ierr;
     ibis::util::timer mytime("countQuery::evaluate", 1);
+    ibis::profile::phase ph("evaluate", mypart->name());
+    ibis::metrics::timer mt(ibis::metrics::evaluateTime);
+
+    std::string ckey; // the key of the answer in ibis::resultCache
+    if (conds.getExpr() != 0 && (hits == 0 || cand != 0)) {
+        ckey = ibis::resultCache::key(*mypart, conds.getExpr(),
+                                      m_sel != 0 ? m_sel->getString() : 0);
+        ibis::bitvector tmp;
+        if (ibis::resultCache::lookup(ckey, tmp)) {
+            delete cand;
+            cand = 0;
+            delete hits;
+            hits = new ibis::bitvector;
+            hits->swap(tmp);
+            ckey.clear();
+        }
+    }
+    ibis::horometer ctime; // time to compute the hits
+    if (! ckey.empty())
+        ctime.start();
 
     if (hits == 0) { // have not performed an estimate
         ibis::bitvector mask;
@@ -366,9 +449,15 @@ int ibis::countQuery::evaluate() {
             hits->compress();
         }
     }
+    if (! ckey.empty()) {
+        ctime.stop();
+        ibis::resultCache::insert(ckey, *mypart, *hits, ctime.realTime());
+    }
     LOGGER(ibis::gVerbose > 0)
         << "From " << mypart->name() << " Where " << conds << " --> "
         << hits->cnt();
+    if (ph.active())
+        ph.setRows(hits->cnt());
     return 0;
 } // ibis::countQuery::evaluate
 
@@ -940,6 +1029,20 @@ int ibis::countQuery::doEvaluate(const ibis::qExpr* term,
     }
     LOGGER(ibis::gVerbose > 7)
         << "countQuery::doEvaluate -- starting to evaluate " << *term;
+    ibis::profile::phase ph(*mypart, term, mask);
+
+    // the hits of a single term may be cached by an earlier query
+    const std::string tkey = ibis::resultCache::termKey(*mypart, term);
+    if (ibis::resultCache::lookup(tkey, ht)) {
+        ht &= mask;
+        ph.setMethod("cache");
+        if (ph.active())
+            ph.setRows(ht.cnt());
+        return ht.sloppyCount();
+    }
+    ibis::horometer ttime; // time to compute the hits of the term
+    if (! tkey.empty())
+        ttime.start();
 
     switch (term->getType()) {
     case ibis::qExpr::LOGICAL_NOT: {
@@ -1034,6 +1137,9 @@ int ibis::countQuery::doEvaluate(const ibis::qExpr* term,
                 ierr = ht.sloppyCount();
             }
         }
+        if (ierr >= 0 && ibis::advisor::enabled)
+            ibis::advisor::record
+                (*mypart, *(reinterpret_cast<const ibis::qRange*>(term)));
         break;}
     case ibis::qExpr::DRANGE: { // try evaluateRange, then doScan
         ierr = mypart->evaluateRange
@@ -1063,6 +1169,9 @@ int ibis::countQuery::doEvaluate(const ibis::qExpr* term,
             }
             ierr = ht.sloppyCount();
         }
+        if (ierr >= 0 && ibis::advisor::enabled)
+            ibis::advisor::record
+                (*mypart, *(reinterpret_cast<const ibis::qRange*>(term)));
         break;}
     case ibis::qExpr::INTHOD: {
         ierr = mypart->evaluateRange
@@ -1193,6 +1302,14 @@ int ibis::countQuery::doEvaluate(const ibis::qExpr* term,
         << "countQuery::doEvaluate(" << *term << ", mask.cnt()="
         << mask.cnt() << ") --> " << ht.cnt() << ", ierr = " << ierr;
 #endif
+    if (! tkey.empty() && ierr >= 0 && // evaluated on all active rows
+        mask.size() == mypart->getMaskRef().size() &&
+        mask.cnt() == mypart->getMaskRef().cnt()) {
+        ttime.stop();
+        ibis::resultCache::insert(tkey, *mypart, ht, ttime.realTime());
+    }
+    if (ph.active())
+        ph.setRows(ht.cnt());
     return ierr;
 } // ibis::countQuery::doEvaluate
 
@@ -34,6 +34,7 @@ public:
     int setWhereClause(const char *str);
     /// Specify the where clause in the form of a qExpr object.
     int setWhereClause(const ibis::qExpr*);
+    int setWhereClause(ibis::whereClause&);
     /// Return the where clause string.
     const char* getWhereClause() const {return conds.getString();}
     /// Resets the data partition used to evaluate the query conditions to
@@ -4,19 +4,31 @@
 #include "dictionary.h"
 #include "utilidor.h"
 
+#include <algorithm>	// std::sort, std::lower_bound
+
 /// The header of dictionary files.  It has 20 bytes exactly.
 static char _fastbit_dictionary_header[20] =
     {'#', 'I', 'B', 'I', 'S', ' ', 'D', 'i', 'c', 't',
-     'i', 'o', 'n', 'a', 'r', 'y', 2, 0, 0, 0};
+     'i', 'o', 'n', 'a', 'r', 'y', 3, 0, 0, 0};
+
+/// Order the codes of a dictionary by their string values.
+struct _ibis_dictionary_less {
+    const ibis::array_t<const char*> &raw;
+    explicit _ibis_dictionary_less(const ibis::array_t<const char*> &r)
+        : raw(r) {}
+    bool operator()(uint32_t x, uint32_t y) const {
+        return std::strcmp(raw[x], raw[y]) < 0;
+    }
+}; // _ibis_dictionary_less
 
 /// Default constructor.
-ibis::dictionary::dictionary() {
+ibis::dictionary::dictionary() : ordered_(true) {
 } // default constructor
 
 /// Copy constructor.  Places all the string in one contiguous buffer.
 ibis::dictionary::dictionary(const ibis::dictionary& old)
-    : raw_(old.raw_.size()), buffer_(1) {
-    if (old.key_.empty()) {
+    : raw_(old.raw_.size()), buffer_(1), ordered_(old.ordered_) {
+    if (old.numKeys() == 0) {
         buffer_.clear();
         return;
     }
@@ -34,7 +46,9 @@ ibis::dictionary::dictionary(const ibis::dictionary& old)
     char *str = new char[sz];
     buffer_[0] = str;
 
-    // copy the string values and populate the hash map
+    // copy the string values and populate the hash map, unless the old
+    // dictionary has the sorted codes to use as the lookup table
+    const bool usekey = old.sorted_.empty();
     for (size_t i = 0; i < nraw; ++ i) {
         if (old.raw_[i] != 0) {
             raw_[i] = str;
@@ -42,26 +56,36 @@ ibis::dictionary::dictionary(const ibis::dictionary& old)
                 *str = *t;
             *str = 0;
             ++ str;
-            key_[raw_[i]] = i;
+            if (usekey)
+                key_[raw_[i]] = i;
         }
         else {
             raw_[i] = 0;
         }
     }
+    if (! usekey)
+        sorted_.deepCopy(old.sorted_);
 } // copy constructor
 
 /// Compare whether this dicrionary and the other are equal in content.
 /// The two dictionaries are considered same only if they have the same
 /// keys in the same order.
 bool ibis::dictionary::equal_to(const ibis::dictionary& other) const {
-    if (key_.size() != other.key_.size())
+    if (numKeys() != other.numKeys())
         return false;
 
-    for (MYMAP::const_iterator it = key_.begin(); it != key_.end(); ++ it) {
-        MYMAP::const_iterator ot = other.key_.find(it->first);
-        if (it->second != ot->second)
+    const size_t nr = (raw_.size() <= other.raw_.size() ?
+                       raw_.size() : other.raw_.size());
+    for (size_t j = 0; j < nr; ++ j) {
+        if (raw_[j] == 0 || other.raw_[j] == 0) {
+            if (raw_[j] != other.raw_[j])
+                return false;
+        }
+        else if (std::strcmp(raw_[j], other.raw_[j]) != 0) {
             return false;
+        }
     }
+    // with the same number of keys, the extra entries must all be null
     return true;
 } // ibis::dictionary::equal_to
 
@@ -77,16 +101,26 @@ void ibis::dictionary::copy(const ibis::dictionary& old) {
    file is laid out as follows.
 
    \li Signature "#IBIS Dictionary " and version number (currently
-   0x020000). (20 bytes)
+   0x03000000). (20 bytes)
 
    \li N = Number of strings in the file. (4 bytes)
 
-   \li uint64_t[N+1]: the starting positions of the strings in this file.
+   \li M = Number of codes, i.e., size() of the dictionary. (4 bytes)
 
-   \li uint32_t[N]: The integer code corresponding to each string value.
+   \li Four bytes of padding, so that the following arrays are aligned.
+
+   \li uint64_t[M+1]: the starting positions of the strings relative to
+   the beginning of the string values.  The string for code j occupies
+   positions [pos[j], pos[j+1]), a null entry occupies no space.
+
+   \li uint32_t[N]: the codes in ascending order of their string values.
 
    \li the string values packed one after the other with their nil
-   terminators.
+   terminators in the order of their codes.
+
+   The new content is first written to a temporary file, which is then
+   renamed to the given name.  This leaves the existing file intact for
+   anyone who has it memory mapped.
 */
 int ibis::dictionary::write(const char* name) const {
     std::string evt = "dictionary::write";
@@ -101,165 +135,163 @@ int ibis::dictionary::write(const char* name) const {
         evt += name;
         evt += ')';
     }
-    if (key_.size() > raw_.size()) {
+    const uint32_t nkeys = numKeys();
+    if (nkeys > raw_.size()) {
         LOGGER(ibis::gVerbose > 1)
             << "Warning -- " << evt
-            << " can not write an inconsistent dictionary, key_.size("
-            << key_.size() << "), raw_.size(" << raw_.size() << ")";
+            << " can not write an inconsistent dictionary, number of keys ("
+            << nkeys << "), raw_.size(" << raw_.size() << ")";
         return -2;
     }
 
     ibis::util::timer mytimer(evt.c_str(), 4);
-    FILE* fptr = fopen(name, "wb");
-    if (fptr == 0) {
+    std::string tmpname = name;
+    tmpname += '~';
+    int ierr;
+    {
+        FILE* fptr = fopen(tmpname.c_str(), "wb");
+        if (fptr == 0) {
+            LOGGER(ibis::gVerbose > 1)
+                << "Warning -- " << evt << " failed to open the file "
+                << tmpname << " ... "
+                << (errno ? strerror(errno) : "no free stdio stream");
+            return -3;
+        }
+
+        IBIS_BLOCK_GUARD(fclose, fptr);
+        const uint32_t sizes[3] = {nkeys, (uint32_t)raw_.size(), 0U};
+        ierr = fwrite(_fastbit_dictionary_header, 1, 20, fptr);
+        if (ierr != 20) {
+            LOGGER(ibis::gVerbose > 1)
+                << "Warning -- " << evt
+                << " failed to write the header, fwrite returned " << ierr;
+            ierr = -4;
+        }
+        else if ((ierr = fwrite(sizes, sizeof(uint32_t), 3, fptr)) != 3) {
+            LOGGER(ibis::gVerbose > 1)
+                << "Warning -- " << evt << " failed to write the size("
+                << nkeys << "), fwrite returned " << ierr;
+            ierr = -5;
+        }
+        else {
+            ierr = writeArena(fptr, nkeys);
+        }
+    }
+    if (ierr < 0) {
+        (void) remove(tmpname.c_str());
+        return ierr;
+    }
+
+#if defined(_WIN32) && !defined(__CYGWIN__)
+    (void) remove(name); // rename does not replace an existing file
+#endif
+    ierr = rename(tmpname.c_str(), name);
+    if (ierr != 0) {
         LOGGER(ibis::gVerbose > 1)
-            << "Warning -- " << evt << " failed to open the file ... "
-            << (errno ? strerror(errno) : "no free stdio stream");
-        return -3;
+            << "Warning -- " << evt << " failed to rename " << tmpname
+            << " -- " << strerror(errno);
+        (void) remove(tmpname.c_str());
+        return -7;
     }
+    LOGGER(ibis::gVerbose > 1)
+        << evt << " complete with ierr = " << ierr;
+    return ierr;
+} // ibis::dictionary::write
 
-    IBIS_BLOCK_GUARD(fclose, fptr);
-    int ierr = fwrite(_fastbit_dictionary_header, 1, 20, fptr);
-    if (ierr != 20) {
+/// Write the positions, the sorted codes and the string values.  If the
+/// string values are stored one after another in the order of their codes,
+/// as after mergeBuffers or after reading a file of version 0x03000000,
+/// they are written with a single sequential write operation, otherwise
+/// they are written one at a time.
+int ibis::dictionary::writeArena(FILE *fptr, uint32_t nkeys) const {
+    mergeBuffers();
+    sortCodes();
+    if (sorted_.size() != nkeys) {
         LOGGER(ibis::gVerbose > 1)
-            << "Warning -- " << evt
-            << " failed to write the header, fwrite returned " << ierr;
-        return -4;
+            << "Warning -- dictionary::writeArena expected " << nkeys
+            << " key" << (nkeys>1?"s":"") << ", but found " << sorted_.size();
+        return -6;
     }
 
-    const uint32_t nkeys = key_.size();
-    ierr = fwrite(&nkeys, sizeof(nkeys), 1, fptr);
-    if (ierr != 1) {
+    const uint32_t nraw = raw_.size();
+    array_t<uint64_t> pos(nraw+1);
+    const char *base = 0;
+    bool contiguous = true;
+    pos[0] = 0;
+    for (uint32_t j = 0; j < nraw; ++ j) {
+        if (raw_[j] != 0) {
+            if (base == 0)
+                base = raw_[j];
+            contiguous = contiguous && (raw_[j] == base + pos[j]);
+            pos[j+1] = pos[j] + 1 + std::strlen(raw_[j]);
+        }
+        else {
+            pos[j+1] = pos[j];
+        }
+    }
+
+    size_t ierr = fwrite(pos.begin(), sizeof(uint64_t), nraw+1, fptr);
+    if (ierr != (size_t)(nraw+1)) {
         LOGGER(ibis::gVerbose > 1)
-            << "Warning -- " << evt << " failed to write the size(" << nkeys
-            << "), fwrite returned " << ierr;
-        return -5;
+            << "Warning -- dictionary::writeArena failed to write the "
+            "offsets, expected fwrite to return " << nraw+1
+            << ", but got " << ierr;
+        return -6;
     }
-    if (nkeys == 0) // nothing else to write
-        return 0;
 
-    mergeBuffers();
-    array_t<uint64_t> pos(nkeys+1);
-    array_t<uint32_t> qos(nkeys);
+    ierr = fwrite(sorted_.begin(), sizeof(uint32_t), nkeys, fptr);
+    if (ierr != (size_t)nkeys) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- dictionary::writeArena failed to write the "
+            "sorted codes, expected fwrite to return " << nkeys
+            << ", but got " << ierr;
+        return -6;
+    }
 
-    pos.clear();
-    qos.clear();
-    pos.push_back(0);
-    if (buffer_.size() == 1) {
-        for (uint32_t j = 0; j < raw_.size(); ++ j) {
-            if (raw_[j] != 0) {
-                pos.push_back(1U + strlen(raw_[j]));
-                qos.push_back(j);
+    if (contiguous) {
+        const char *buff = base;
+        size_t sz = pos[nraw];
+        while (sz > 0) { // a large buffer may need multuple fwrite calls
+            ierr = fwrite(buff, 1, sz, fptr);
+            if (ierr > 0U && ierr <= sz) {
+                buff += ierr;
+                sz -= ierr;
+            }
+            else {
+                LOGGER(ibis::gVerbose > 1)
+                    << "Warning -- dictionary::writeArena failed to write "
+                    "the string values, fwrite retruned 0";
+                return -6;
             }
         }
-        ierr = writeBuffer(fptr, nkeys, pos, qos);
     }
     else {
-        ierr = writeKeys(fptr, nkeys, pos, qos);
-    }
-    LOGGER(ibis::gVerbose > 1)
-        << evt << " complete with ierr = " << ierr;
-    return ierr;
-} // ibis::dictionary::write
+        for (uint32_t j = 0; j < nraw; ++ j) {
+            if (raw_[j] == 0) continue;
 
-/// Write the dictionary one keyword at a time.  This version requires on
-/// write call on each keyword, which can be time consuming when there are
-/// many keywords.
-int ibis::dictionary::writeKeys(FILE *fptr, uint32_t nkeys,
-                                array_t<uint64_t> &pos,
-                                array_t<uint32_t> &qos) const {
-    int ierr = fseek(fptr, 8*(nkeys+1)+4*nkeys, SEEK_CUR);
-    long int tmp = ftell(fptr);
-    pos.clear();
-    qos.clear();
-    pos.push_back(tmp);
-    for (uint32_t j = 0; j < raw_.size(); ++ j) {
-        if (raw_[j] != 0) {
-            const int len = 1 + std::strlen(raw_[j]);
+            const size_t len = pos[j+1] - pos[j];
             ierr = fwrite(raw_[j], 1, len, fptr);
-            LOGGER(ierr != len && ibis::gVerbose > 1)
-                << "Warning -- dictionary::writeKeys failed to write key["
-                << j << "]; expected fwrite to return " << len
-                << ", but got " << ierr;
-
-            tmp += len;
-            qos.push_back(j);
-            pos.push_back(tmp);
-        }
-    }
-
-    tmp = 0;
-    // go back to write the offsets/positions
-    ierr = fseek(fptr, 24, SEEK_SET);
-    LOGGER(ierr != 0 && ibis::gVerbose > 1)
-        << "Warning -- dictionary::writeKeys failed to seek to offset 24 "
-        "to write the offsets";
-
-    ierr = fwrite(pos.begin(), sizeof(uint64_t), nkeys+1, fptr);
-    LOGGER(ierr != (int)(nkeys+1) && ibis::gVerbose > 1)
-        << "Warning -- dictionary::writeKeys failed to write the offsets, "
-        "expected fwrite to return " << nkeys+1 << ", but got " << ierr;
-    tmp -= 7 * (ierr != (int)(nkeys+1));
-
-    ierr = fwrite(qos.begin(), sizeof(uint32_t), nkeys, fptr);
-    LOGGER(ierr != (int)(nkeys) && ibis::gVerbose > 1)
-        << "Warning -- dictionary::writeKeys failed to write the keys, "
-        "expected fwrite to return " << nkeys << ", but got " << ierr;
-    tmp -= 8 * (ierr != (int)(nkeys));
-    return tmp;
-} // ibis::dictionary::writeKeys
-
-/// Write the buffer out directly.
-///
-/// @ntoe This function is intended to be used by dictionary::write and
-/// must satisfy the following conditions.  There must be only one buffer,
-/// and the raw_ must be ordered in that buffer.  Under these conditions,
-/// we can write the buffer using a single sequential write operations,
-/// which should reduce the I/O time.  The easiest way to satisfy these
-/// conditions is to invoke mergeBuffers.
-int ibis::dictionary::writeBuffer(FILE *fptr, uint32_t nkeys,
-                                  array_t<uint64_t> &pos,
-                                  array_t<uint32_t> &qos) const {
-    size_t ierr;
-    pos[0] = 24 + 8 * (nkeys+1) + 4 * nkeys;
-    for (unsigned j = 0; j < nkeys; ++ j)
-        pos[j+1] += pos[j];
-
-    ierr = fwrite(pos.begin(), sizeof(uint64_t), nkeys+1, fptr);
-    LOGGER(ierr != (int)(nkeys+1) && ibis::gVerbose > 1)
-        << "Warning -- dictionary::writeBuffer failed to write the offsets, "
-        "expected fwrite to return " << nkeys+1 << ", but got " << ierr;
-
-    ierr = fwrite(qos.begin(), sizeof(uint32_t), nkeys, fptr);
-    LOGGER(ierr != (int)(nkeys) && ibis::gVerbose > 1)
-        << "Warning -- dictionary::writeBuffer failed to write the keys, "
-        "expected fwrite to return " << nkeys << ", but got " << ierr;
-
-    const char *buff = buffer_[0];
-    size_t sz = pos[nkeys] - pos[0];
-    while (sz > 0) {  // a large buffer may need multuple fwrite calls
-        ierr = fwrite(buff, 1, sz, fptr);
-        if (ierr > 0U && ierr <= sz) {
-            buff += ierr;
-            sz -= ierr;
-        }
-        else {
-            LOGGER(ibis::gVerbose > 1)
-                << "Warning -- dictionary::writeBuffer failed to write the "
-                "buffer, fwrite retruned 0";
-            return -6;
+            if (ierr != len) {
+                LOGGER(ibis::gVerbose > 1)
+                    << "Warning -- dictionary::writeArena failed to write "
+                    "key[" << j << "]; expected fwrite to return " << len
+                    << ", but got " << ierr;
+                return -6;
+            }
         }
     }
     return 0;
-} // ibis::dictionary::writeBuffer
+} // ibis::dictionary::writeArena
 
 /// Read the content of the named file.  The file content is read into the
 /// buffer in one-shot and then digested.
 ///
 /// This function determines the version of the dictionary and invokes the
 /// necessary reading function to perform the actual reading operations.
-/// Currently there are three possible version of dictioanries
-/// 0x02000000 - the version produced by the current write function,
+/// Currently there are four possible version of dictioanries
+/// 0x03000000 - the version produced by the current write function, the
+///              string values are used in place without copying,
+/// 0x02000000 - the version with 64-bit offsets and explicit codes,
 /// 0x01000000 - the version with 64-bit offsets, consecutive kyes, strings
 ///              are stored in key order
 /// 0x00000000 - the version 32-bit offsets and stores strings in
@@ -343,6 +375,9 @@ int ibis::dictionary::read(const char* name) {
 
     // invoke the actual reader based on version number
     switch (version) {
+    case 0x03000000:
+            ierr = readKeys3(evt.c_str(), name, fptr);
+            break;
     case 0x02000000:
             ierr = readKeys2(evt.c_str(), fptr);
             break;
@@ -356,6 +391,7 @@ int ibis::dictionary::read(const char* name) {
             ierr = readRaw(evt.c_str(), fptr);
             break;
     }
+    checkOrder();
     if (ibis::gVerbose > 3) {
         ibis::util::logger lg;
         lg() << evt << " completed with ";
@@ -634,11 +670,106 @@ int ibis::dictionary::readKeys2(const char *evt, FILE *fptr) {
     return 0;
 } // ibis::dictionary::readKeys2
 
+/// Read the string values.  This function processes the data produced by
+/// version 0x03000000 of the write function.  On successful completion, it
+/// returns 0.
+///
+/// The positions, the sorted codes and the string values are retrieved
+/// with a single call to ibis::fileManager::getFileSegment, which maps
+/// them into memory if the file is large.  The string values are used in
+/// place and the sorted codes serve as the lookup table, therefore there
+/// is no need to copy the strings or to build the hash_map.
+int ibis::dictionary::readKeys3(const char *evt, const char *name,
+                                FILE *fptr) {
+    uint32_t sizes[3];
+    int ierr = fread(sizes, 4, 3, fptr);
+    if (ierr != 3) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- " << evt
+            << " failed to read the number of keys, fread returned " << ierr;
+        return -6;
+    }
+
+    clear();
+    const uint32_t nkeys = sizes[0];
+    const uint32_t nraw = sizes[1];
+    ierr = fseek(fptr, 0, SEEK_END);
+    const long int sz = ftell(fptr); // file size
+    const size_t npos = 8 * (nraw + 1);
+    const size_t nend = npos + 4 * nkeys;
+    if (ierr != 0 || nkeys > nraw || sz < 32 || (size_t)(sz - 32) < nend) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- " << evt << " expected at least " << nend+32
+            << " bytes for " << nkeys << " key" << (nkeys>1?"s":"")
+            << ", but the file has " << sz;
+        return -7;
+    }
+
+    try {
+        array_t<char> all(name, -1, 32, sz);
+        ibis::fileManager::storage *st = all.getStorage();
+        array_t<uint64_t> pos(st, 0, npos);
+        array_t<uint32_t> srt(st, npos, nend);
+        array_t<char> arena(st, nend, sz-32);
+        if (pos.size() != nraw+1 || srt.size() != nkeys ||
+            pos[0] != 0 || pos[nraw] != arena.size()) {
+            LOGGER(ibis::gVerbose > 1)
+                << "Warning -- " << evt << " found the positions of the "
+                "string values to be inconsistent with the file size";
+            return -8;
+        }
+
+        raw_.resize(nraw);
+        for (uint32_t j = 0; j < nraw; ++ j) {
+            if (pos[j] < pos[j+1] && pos[j+1] <= arena.size() &&
+                arena[pos[j+1]-1] == 0) {
+                raw_[j] = arena.begin() + pos[j];
+            }
+            else if (pos[j] == pos[j+1]) {
+                raw_[j] = 0;
+            }
+            else {
+                LOGGER(ibis::gVerbose > 1)
+                    << "Warning -- " << evt << " found the position of key["
+                    << j << "] to be out of order or out of range";
+                raw_.clear();
+                return -9;
+            }
+        }
+        for (uint32_t j = 0; j < nkeys; ++ j) {
+            if (srt[j] >= nraw || raw_[srt[j]] == 0) {
+                LOGGER(ibis::gVerbose > 1)
+                    << "Warning -- " << evt << " encountered an invalid code "
+                    << srt[j] << " in the sorted list";
+                raw_.clear();
+                return -10;
+            }
+        }
+        sorted_.swap(srt);
+        arena_.swap(arena);
+    }
+    catch (...) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- " << evt << " failed to retrieve the content of "
+            "the dictionary file";
+        clear();
+        return -11;
+    }
+
+#if DEBUG+0 > 2 || _DEBUG+0 > 2
+    ibis::util::logger lg;
+    lg() << "DEBUG -- " << evt << " got the following keys\n\t";
+    for (uint32_t j = 0; j < sorted_.size(); ++ j)
+        lg() << "\n\t" << sorted_[j] << ": " << raw_[sorted_[j]];
+#endif
+    return 0;
+} // ibis::dictionary::readKeys3
+
 /// Output the current content in ASCII format.  Each non-empty entry is
 /// printed in the format of "number: string".
 void ibis::dictionary::toASCII(std::ostream &out) const {
     out << "-- dictionary @" << static_cast<const void*>(this) << " with "
-        << key_.size() << " entr" << (key_.size()>1?"ies":"y");
+        << numKeys() << " entr" << (numKeys()>1?"ies":"y");
     for (unsigned j = 0; j < raw_.size(); ++ j)
         if (raw_[j] != 0)
             out << "\n" << j << ": \"" << raw_[j] << '"';
@@ -736,6 +867,11 @@ void ibis::dictionary::clear() {
     buffer_.clear();
     key_.clear();
     raw_.clear();
+    array_t<uint32_t> tmp;
+    sorted_.swap(tmp);
+    array_t<char> arena;
+    arena_.swap(arena);
+    ordered_ = true;
 } // ibis::dictionary::clear
 
 /// Find all codes that matches the SQL LIKE pattern.
@@ -744,13 +880,13 @@ void ibis::dictionary::patternSearch(const char* pat,
                                      array_t<uint32_t>& matches) const {
     if (pat == 0) return;
     //if (*pat == 0) return;//empty string is allowed
-    if (key_.size() == 0) return;
-    if (key_.size() > raw_.size()) {
+    if (numKeys() == 0) return;
+    if (numKeys() > raw_.size()) {
         LOGGER(ibis::gVerbose > 0)
             << "Warning -- dictionary::patternSearch(" << pat
             << ") can not proceed because the member variables have "
-            "inconsistent sizes: raw_.size(" << raw_.size() << ", key_.size("
-            << key_.size() << ')';
+            "inconsistent sizes: raw_.size(" << raw_.size() << ", numKeys("
+            << numKeys() << ')';
         return;
     }
 
@@ -798,11 +934,34 @@ void ibis::dictionary::patternSearch(const char* pat,
         return;
     }
 
-    // match values in the range
-    for (MYMAP::const_iterator j = key_.begin();
-         j != key_.end(); ++ j) {
-        if (ibis::util::strMatch(j->first, pat)) {
-            matches.push_back(j->second);
+    if (! sorted_.empty() && ! prefix.empty()) {
+        // only the strings starting with the prefix need to be examined,
+        // they are next to each other in sorted_
+        const uint32_t *it = sorted_.begin();
+        for (size_t n = sorted_.size(); n > 0; ) {
+            const size_t half = n / 2;
+            if (std::strcmp(raw_[it[half]], prefix.c_str()) < 0) {
+                it += half + 1;
+                n -= half + 1;
+            }
+            else {
+                n = half;
+            }
+        }
+        for (; it < sorted_.end() &&
+                 std::strncmp(raw_[*it], prefix.c_str(), prefix.size()) == 0;
+             ++ it) {
+            if (ibis::util::strMatch(raw_[*it], pat)) {
+                matches.push_back(*it);
+            }
+        }
+    }
+    else {
+        // match all values
+        for (uint32_t j = 0; j < raw_.size(); ++ j) {
+            if (raw_[j] != 0 && ibis::util::strMatch(raw_[j], pat)) {
+                matches.push_back(j);
+            }
         }
     }
 
@@ -838,6 +997,9 @@ uint32_t ibis::dictionary::operator[](const char* str) const {
             lg() << '"' << it->first << '"' << ' ';
     }
 #endif
+    if (key_.empty() && ! sorted_.empty())
+        return findSorted(str);
+
     MYMAP::const_iterator it = key_.find(str);
     if (it != key_.end()) {
 #if DEBUG+0 > 2 || _DEBUG+0 > 2
@@ -880,6 +1042,7 @@ uint32_t ibis::dictionary::insert(const char* str, uint32_t pos) {
         *ptr = toupper(*ptr);
     }
 #endif
+    thaw();
     if (pos < raw_.size() && raw_[pos] != 0) {
         if (strcmp(str, raw_[pos]) == 0) // same string value
             return pos;
@@ -889,6 +1052,7 @@ uint32_t ibis::dictionary::insert(const char* str, uint32_t pos) {
         raw_[jt->second] = 0;
         key_.erase(jt);
         raw_[pos] = 0;
+        ordered_ = false;
         LOGGER(ibis::gVerbose > 0)
             << "dictionary::insert(" << str << ", " << pos
             << ") removed existing entry with code " << pos << " (" << old
@@ -904,6 +1068,7 @@ uint32_t ibis::dictionary::insert(const char* str, uint32_t pos) {
             raw_[jt->second] = 0;
             raw_[pos] = jt->first;
             jt->second = pos;
+            ordered_ = false;
         }
         return pos;
     }
@@ -923,6 +1088,7 @@ uint32_t ibis::dictionary::insert(const char* str, uint32_t pos) {
             buffer_.push_back(copy);
             key_[copy] = pos;
             raw_[pos] = copy;
+            ordered_ = false;
             return pos;
         }
     }
@@ -935,6 +1101,7 @@ uint32_t ibis::dictionary::insert(const char* str, uint32_t pos) {
     if (pos >= raw_.size()) {
         // need to expand raw_
         const uint32_t nk = raw_.size();
+        ordered_ = ordered_ && follows(str);
         if (raw_.capacity() < pos+1) {
             // attempt to double the storage to reduce the amountized cost
             raw_.reserve(nk+nk>pos+1?nk+nk:pos+1);
@@ -967,6 +1134,7 @@ uint32_t ibis::dictionary::insert(const char* str) {
         *ptr = toupper(*ptr);
     }
 #endif
+    thaw();
     MYMAP::const_iterator it = key_.find(str);
     if (it != key_.end()) {
 #if DEBUG+0 > 2 || _DEBUG+0 > 2
@@ -979,6 +1147,7 @@ uint32_t ibis::dictionary::insert(const char* str) {
     else {
         // incoming string is a new entry
         const uint32_t nk = raw_.size();
+        ordered_ = ordered_ && follows(str);
         char *copy = ibis::util::strnewdup(str);
         buffer_.push_back(copy);
         raw_.push_back(copy);
@@ -1012,6 +1181,7 @@ uint32_t ibis::dictionary::appendOrdered(const char* str) {
     }
 #endif
 
+    thaw();
     const uint32_t ind = key_.size();
     char *copy = ibis::util::strnewdup(str);
     buffer_.push_back(copy);
@@ -1035,6 +1205,7 @@ uint32_t ibis::dictionary::insertRaw(char* str) {
         *ptr = toupper(*ptr);
     }
 #endif
+    thaw();
     MYMAP::const_iterator it = key_.find(str);
     if (it != key_.end()) {
         return it->second;
@@ -1042,6 +1213,7 @@ uint32_t ibis::dictionary::insertRaw(char* str) {
     else {
         // incoming string is a new entry
         const uint32_t nk = raw_.size();
+        ordered_ = ordered_ && follows(str);
         buffer_.push_back(str);
         raw_.push_back(str);
         key_[str] = nk;
@@ -1059,6 +1231,7 @@ uint32_t ibis::dictionary::insertRaw(char* str) {
 /// previous assignment was k, the new assignement will be o2n[k].  Note
 /// that the name o2n is shorthand for old-to-new.
 void ibis::dictionary::sort(ibis::array_t<uint32_t> &o2n) {
+    thaw();
     const size_t nelm = raw_.size();
     ibis::array_t<uint32_t> n2o(nelm);
     for (size_t j = 0; j < nelm; ++ j)
@@ -1077,6 +1250,7 @@ void ibis::dictionary::sort(ibis::array_t<uint32_t> &o2n) {
         o2n[n2o[j]] = j;
     for (MYMAP::iterator it = key_.begin(); it != key_.end(); ++ it)
         it->second = o2n[it->second];
+    ordered_ = true;
 #if DEBUG+0 > 2 || _DEBUG+0 > 2
     {
         ibis::util::logger lg;
@@ -1093,19 +1267,87 @@ void ibis::dictionary::sort(ibis::array_t<uint32_t> &o2n) {
 
 /// Merge the incoming dictionary with this one.  It produces a dictionary
 /// that combines the words in both dictionaries.  Existing words in the
-/// current dictionary will keep their current assignment.
+/// current dictionary will keep their current assignment.  The new words
+/// are appended in the order of their codes in the incoming dictionary.
+///
+/// The two dictionaries are compared by walking through their codes in the
+/// sorted order, which takes linear time once the sorted codes are known,
+/// e.g., after reading a dictionary file of version 0x03000000.  All the
+/// new words are copied into one buffer.
 ///
 /// Upon successful completion of this function, the return value will be
 /// the new size of the dictionary.
 int ibis::dictionary::merge(const ibis::dictionary& rhs) {
-    const uint32_t nr = rhs.key_.size();
+    const uint32_t nr = rhs.numKeys();
     if (nr == 0) {
-        return key_.size();
+        return numKeys();
+    }
+
+    sortCodes();
+    rhs.sortCodes();
+    // mark the words in rhs that are not in this dictionary
+    std::vector<bool> fresh(rhs.raw_.size(), false);
+    size_t nfresh = 0;
+    size_t nbytes = 0;
+    const uint32_t *lt = sorted_.begin();
+    for (const uint32_t *rt = rhs.sorted_.begin(); rt < rhs.sorted_.end();
+         ++ rt) {
+        int cmp = -1;
+        while (lt < sorted_.end() &&
+               (cmp = std::strcmp(raw_[*lt], rhs.raw_[*rt])) < 0)
+            ++ lt;
+        if ((lt >= sorted_.end() || cmp > 0) && *rt > 0) {
+            fresh[*rt] = true;
+            ++ nfresh;
+            nbytes += 1 + std::strlen(rhs.raw_[*rt]);
+        }
+    }
+    if (nfresh == 0)
+        return numKeys();
+
+    // copy the new words into one buffer and assign them new codes
+    const uint32_t nold = raw_.size();
+    array_t<uint32_t> r2n(rhs.raw_.size(), 0U);
+    char *str = new char[nbytes];
+    buffer_.push_back(str);
+    raw_.reserve(nold + nfresh);
+    for (uint32_t j = 1; j < rhs.raw_.size(); ++ j) {
+        if (fresh[j]) {
+            r2n[j] = raw_.size();
+            raw_.push_back(str);
+            for (const char *t = rhs.raw_[j]; *t != 0; ++ t, ++ str)
+                *str = *t;
+            *str = 0;
+            ++ str;
+        }
     }
 
-    for (size_t j = 1; j < rhs.raw_.size(); ++ j)
-        (void) insert(rhs.raw_[j]);
-    return key_.size();
+    // merge the sorted codes of the existing words and the new words
+    array_t<uint32_t> srt(sorted_.size() + nfresh);
+    uint32_t *out = srt.begin();
+    lt = sorted_.begin();
+    for (const uint32_t *rt = rhs.sorted_.begin(); rt < rhs.sorted_.end();
+         ++ rt) {
+        if (! fresh[*rt]) continue;
+        while (lt < sorted_.end() &&
+               std::strcmp(raw_[*lt], rhs.raw_[*rt]) < 0) {
+            *out = *lt;
+            ++ out;
+            ++ lt;
+        }
+        *out = r2n[*rt];
+        ++ out;
+    }
+    for (; lt < sorted_.end(); ++ lt, ++ out)
+        *out = *lt;
+
+    if (! key_.empty()) {
+        for (uint32_t j = nold; j < raw_.size(); ++ j)
+            key_[raw_[j]] = j;
+    }
+    sorted_.swap(srt);
+    checkOrder();
+    return numKeys();
 } // ibis::dictionary::merge
 
 /// Produce an array that maps the integers in old dictionary to the new
@@ -1114,11 +1356,16 @@ int ibis::dictionary::merge(const ibis::dictionary& rhs) {
 ///
 /// Upon successful completion of this fuction, the array o2n will have
 /// (old.size()+1) number of elements, where the new value for the old code
-/// i is stored as o2n[i].
+/// i is stored as o2n[i].  A string that is not in this dictionary is
+/// mapped to size(), and a null entry of the old dictionary is mapped to
+/// 0.
+///
+/// The two dictionaries are compared by walking through their codes in the
+/// sorted order, which takes linear time once the sorted codes are known.
 int ibis::dictionary::morph(const ibis::dictionary &old,
                             ibis::array_t<uint32_t> &o2n) const {
-    const uint32_t nold = old.key_.size();
-    const uint32_t nnew = key_.size();
+    const uint32_t nold = old.numKeys();
+    const uint32_t nnew = numKeys();
     if (nold > nnew) {
         LOGGER(ibis::gVerbose > 0)
             << "Warning -- dictionary::morph can not proceed because the "
@@ -1130,11 +1377,169 @@ int ibis::dictionary::morph(const ibis::dictionary &old,
     o2n[0] = 0;
     if (nold == 0) return 0;
 
-    for (uint32_t j0 = 1; j0 < old.raw_.size(); ++ j0)
-        o2n[j0] = operator[](raw_[j0]);
+    for (uint32_t j0 = 1; j0 <= nold; ++ j0)
+        o2n[j0] = 0;
+    sortCodes();
+    old.sortCodes();
+    const uint32_t *nt = sorted_.begin();
+    for (const uint32_t *ot = old.sorted_.begin(); ot < old.sorted_.end();
+         ++ ot) {
+        if (*ot >= o2n.size()) continue;
+
+        int cmp = -1;
+        while (nt < sorted_.end() &&
+               (cmp = std::strcmp(raw_[*nt], old.raw_[*ot])) < 0)
+            ++ nt;
+        o2n[*ot] = (nt < sorted_.end() && cmp == 0 ? *nt : raw_.size());
+    }
     return nold;
 } // ibis::dictioniary::morph
 
+/// Return the smallest code whose string value is no less than @c str.
+/// If all strings in the dictionary are less than @c str, it returns
+/// size().  A null string is treated as the smallest string.
+///
+/// @note The codes between lowerBound(a) and lowerBound(b) are the codes
+/// of the strings in the range [a, b) only if isSorted() is true.
+uint32_t ibis::dictionary::lowerBound(const char* str) const {
+    return findBound(str, 0);
+} // ibis::dictionary::lowerBound
+
+/// Return the smallest code whose string value is greater than @c str.  If
+/// no string in the dictionary is greater than @c str, it returns size().
+/// The return value is only meaningful if isSorted() is true.
+uint32_t ibis::dictionary::upperBound(const char* str) const {
+    return findBound(str, 1);
+} // ibis::dictionary::upperBound
+
+/// Find the range of codes of the strings starting with the given prefix.
+/// On return, the strings starting with @c pre have codes in [lo, hi).  If
+/// no string starts with @c pre, lo will be equal to hi.  The output is
+/// only meaningful if isSorted() is true.
+void ibis::dictionary::prefixRange(const char* pre, uint32_t& lo,
+                                   uint32_t& hi) const {
+    lo = findBound(pre, 0);
+    hi = findBound(pre, 2);
+    if (hi < lo)
+        hi = lo;
+} // ibis::dictionary::prefixRange
+
+/// Binary search on a sorted dictionary.  The argument @c mode determines
+/// which code is returned: 0 for the first string no less than @c str, 1
+/// for the first string greater than @c str, and 2 for the first string
+/// that does not start with @c str and is greater than @c str.  The null
+/// entries are skipped, and the code returned is either size() or the
+/// code of a non-null entry.
+uint32_t ibis::dictionary::findBound(const char* str, int mode) const {
+    std::string key = (str != 0 ? str : "");
+#if FASTBIT_CASE_SENSITIVE_COMPARE+0 == 0
+    for (size_t j = 0; j < key.size(); ++ j)
+        key[j] = toupper(key[j]);
+#endif
+    uint32_t lo = 0;
+    uint32_t hi = raw_.size();
+    while (lo < hi) {
+        const uint32_t mid = (lo + hi) / 2;
+        uint32_t m = mid;
+        while (m < hi && raw_[m] == 0)
+            ++ m;
+        if (m >= hi) {
+            hi = mid;
+            continue;
+        }
+
+        int cmp = (mode < 2 ? std::strcmp(raw_[m], key.c_str()) :
+                   std::strncmp(raw_[m], key.c_str(), key.size()));
+        if (cmp < 0 || (cmp == 0 && mode > 0))
+            lo = m + 1;
+        else
+            hi = m;
+    }
+    while (lo < raw_.size() && raw_[lo] == 0)
+        ++ lo;
+    return lo;
+} // ibis::dictionary::findBound
+
+/// Determine whether the codes are assigned in the ascending order of the
+/// strings.  Set the member variable ordered_ accordingly.
+void ibis::dictionary::checkOrder() {
+    ordered_ = true;
+    if (! sorted_.empty()) {
+        for (size_t j = 1; ordered_ && j < sorted_.size(); ++ j)
+            ordered_ = (sorted_[j-1] < sorted_[j]);
+    }
+    else {
+        const char *last = 0;
+        for (size_t j = 0; ordered_ && j < raw_.size(); ++ j) {
+            if (raw_[j] != 0) {
+                ordered_ = (last == 0 || std::strcmp(last, raw_[j]) < 0);
+                last = raw_[j];
+            }
+        }
+    }
+} // ibis::dictionary::checkOrder
+
+/// Is the given string greater than all the strings in the dictionary?
+/// This is used to decide whether appending the string keeps the
+/// dictionary sorted.
+bool ibis::dictionary::follows(const char* str) const {
+    for (size_t j = raw_.size(); j > 0; -- j) {
+        if (raw_[j-1] != 0)
+            return (std::strcmp(raw_[j-1], str) < 0);
+    }
+    return true;
+} // ibis::dictionary::follows
+
+/// Find the code of a string with a binary search on the sorted codes.
+/// Returns size() if the string is not in the dictionary.
+uint32_t ibis::dictionary::findSorted(const char* str) const {
+    size_t lo = 0;
+    size_t hi = sorted_.size();
+    while (lo < hi) {
+        const size_t mid = (lo + hi) / 2;
+        const int cmp = std::strcmp(raw_[sorted_[mid]], str);
+        if (cmp < 0)
+            lo = mid + 1;
+        else if (cmp > 0)
+            hi = mid;
+        else
+            return sorted_[mid];
+    }
+    return raw_.size();
+} // ibis::dictionary::findSorted
+
+/// Fill sorted_ with the codes of the non-null entries in the ascending
+/// order of their string values.  Nothing is done if sorted_ is already
+/// available.
+void ibis::dictionary::sortCodes() const {
+    if (! sorted_.empty()) return;
+
+    array_t<uint32_t> tmp;
+    tmp.reserve(numKeys());
+    for (uint32_t j = 0; j < raw_.size(); ++ j) {
+        if (raw_[j] != 0)
+            tmp.push_back(j);
+    }
+    std::sort(tmp.begin(), tmp.end(), _ibis_dictionary_less(raw_));
+    sorted_.swap(tmp);
+} // ibis::dictionary::sortCodes
+
+/// Prepare the dictionary for modification.  If the dictionary is using
+/// the sorted codes as the lookup table, the hash_map is built here.  The
+/// sorted codes are discarded since they would be out of date after the
+/// modification.
+void ibis::dictionary::thaw() {
+    if (key_.empty() && ! sorted_.empty()) {
+#if __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ > 8)
+        key_.reserve(sorted_.size()+sorted_.size());
+#endif
+        for (size_t j = 0; j < sorted_.size(); ++ j)
+            key_[raw_[sorted_[j]]] = sorted_[j];
+    }
+    array_t<uint32_t> tmp;
+    sorted_.swap(tmp);
+} // ibis::dictionary::thaw
+
 /// Merge all buffers into a single one.  New memory is allocated to store
 /// the string values together if they are stored in different locations
 /// currently.
@@ -27,14 +27,22 @@ namespace std {
 /// to 0xFFFFFFFF (-1U) and is NOT counted as an entry in a dictionary.
 ///
 /// This version uses an in-memory hash_map to provide a mapping from a
-/// string to an integer.
+/// string to an integer while the dictionary is being modified.  A
+/// dictionary read from a file of version 0x03000000 keeps its strings in
+/// a single arena that is memory mapped when it is large, and looks up
+/// strings with a binary search on the codes sorted by the string values.
+/// The hash_map is only built when such a dictionary is modified.
 ///
 /// @note The integer returned from this class is a unsigned 32-bit integer
 /// (uint32_t).  This limits the size of the dictionary to be no more than
 /// 2^32 entries.  The dictionary file is written with 64-bit internal
-/// pointers.  However, since the dictionary has to be read into memory
-/// completely before any use, the size of a dictionary is generally
-/// limited by the size of the computer memory.
+/// pointers.
+///
+/// A dictionary whose codes are assigned in the ascending order of the
+/// strings is said to be sorted.  A range of strings in a sorted
+/// dictionary corresponds to a range of codes, which can be found with
+/// the functions lowerBound, upperBound and prefixRange.  The function
+/// sort reassigns the codes to make a dictionary sorted.
 ///
 /// @note If FASTBIT_CASE_SENSITIVE_COMPARE is defined to be 0, the values
 /// stored in a dictionary will be folded to the upper case.  This will
@@ -55,6 +63,12 @@ public:
     const char* find(const char* str) const;
     void patternSearch(const char* pat, array_t<uint32_t>& matches) const;
 
+    /// Are the codes assigned in the ascending order of the strings?
+    bool isSorted() const {return ordered_;}
+    uint32_t lowerBound(const char* str) const;
+    uint32_t upperBound(const char* str) const;
+    void prefixRange(const char* pre, uint32_t& lo, uint32_t& hi) const;
+
     uint32_t insert(const char*, uint32_t);
     uint32_t insert(const char*);
     uint32_t insertRaw(char*);
@@ -98,16 +112,36 @@ protected:
         <const char*, uint32_t, std::hash<const char*>,
          std::equal_to<const char*> > MYMAP;
     MYMAP key_;
+    /// Member variable sorted_ contains the codes of the strings in the
+    /// ascending order of the string values.  When key_ is empty, it is
+    /// the lookup table of the dictionary.  It is emptied whenever the
+    /// dictionary is modified.
+    mutable array_t<uint32_t> sorted_;
+    /// Member variable arena_ contains the string values read from a
+    /// dictionary file of version 0x03000000.  It may be a read-only
+    /// memory map of the file.
+    array_t<char> arena_;
+    /// Member variable ordered_ indicates whether the codes are assigned
+    /// in the ascending order of the strings.
+    bool ordered_;
+
+    /// Return the number of non-null entries.
+    uint32_t numKeys() const {
+        return (key_.empty() ? sorted_.size() : key_.size());}
+    uint32_t findSorted(const char*) const;
+    void sortCodes() const;
+    void thaw();
+    void checkOrder();
+    bool follows(const char*) const;
+    uint32_t findBound(const char*, int) const;
 
     int  readRaw(const char*, FILE *);
     int  readKeys0(const char*, FILE *);
     int  readKeys1(const char*, FILE *);
     int  readKeys2(const char*, FILE *);
+    int  readKeys3(const char*, const char*, FILE *);
     void mergeBuffers() const;
-    int  writeKeys(FILE*, uint32_t, array_t<uint64_t>&,
-                   array_t<uint32_t>&) const;
-    int  writeBuffer(FILE*, uint32_t, array_t<uint64_t>&,
-                     array_t<uint32_t>&) const;
+    int  writeArena(FILE*, uint32_t) const;
 
 private:
     dictionary& operator=(const dictionary&);
@@ -118,6 +152,11 @@ inline void ibis::dictionary::swap(ibis::dictionary& rhs) {
     raw_.swap(rhs.raw_);
     key_.swap(rhs.key_);
     buffer_.swap(rhs.buffer_);
+    sorted_.swap(rhs.sorted_);
+    arena_.swap(rhs.arena_);
+    const bool tmp = ordered_;
+    ordered_ = rhs.ordered_;
+    rhs.ordered_ = tmp;
 } // ibis::dictionary::swap
 
 /// Return a string corresponding to the integer.  If the index is beyond
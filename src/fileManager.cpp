@@ -18,6 +18,8 @@
 #include "fileManager.h"
 #include "resource.h"
 #include "array_t.h"
+#include "colpack.h"    // ibis::colpack
+#include "metrics.h"    // ibis::metrics
 
 #include <typeinfo>     // typeid
 #include <string>       // std::string
@@ -210,6 +212,9 @@ void ibis::fileManager::printStatus(std::ostream& out) const {
                                    - (itot + mtot))
         << "\nThe total size of all named and unnamed storages is "
         << ibis::util::groupby1000(ibis::fileManager::totalBytes())
+        << "\nSize of the " << blocks.size() << " decompressed block"
+        << (blocks.size()>1?"s":"") << " in the pool is "
+        << ibis::util::groupby1000(blockBytes)
         << "\nThe prescribed maximum size is "
         << ibis::util::groupby1000(maxBytes)
         << "\nNumber of pages accessed (recorded so far) is "
@@ -536,7 +541,8 @@ ibis::fileManager& ibis::fileManager::instance() {
 /// efficient to read the whole content into memory rather than keeping a
 /// file open.  The default value is defined by the macro FASTBIT_MIN_MAP_SIZE.
 ibis::fileManager::fileManager()
-    : page_count(0), minMapSize(FASTBIT_MIN_MAP_SIZE), nwaiting(0) {
+    : page_count(0), minMapSize(FASTBIT_MIN_MAP_SIZE), nwaiting(0),
+      blockBytes(0), maxBlockBytes(0) {
     {
         size_t sz = static_cast<size_t>
             (ibis::gParameters().getNumber("fileManager.maxBytes"));
@@ -682,6 +688,13 @@ ibis::fileManager::fileManager()
     if (pthread_cond_init(&readCond, 0) != 0)
         throw ibis::bad_alloc("pthread_cond_init(readCond) failed in "
                               "fileManager ctor" IBIS_FILE_LINE);
+    if (pthread_mutex_init(&blockMutex, 0) != 0)
+        throw ibis::bad_alloc("pthread_mutex_init(blockMutex) failed in "
+                              "fileManager ctor" IBIS_FILE_LINE);
+    maxBlockBytes = static_cast<uint64_t>
+        (ibis::gParameters().getNumber("fileManager.maxBlockBytes"));
+    if (maxBlockBytes == 0)
+        maxBlockBytes = maxBytes / 32;
 
     LOGGER(ibis::gVerbose > 1)
         << "fileManager initialization complete -- maxBytes="
@@ -691,8 +704,10 @@ ibis::fileManager::fileManager()
 /// Destructor.
 ibis::fileManager::~fileManager() {
     ibis::util::clear(ibis::datasets);
+    clearBlocks();
     clear();
     // (void)pthread_rwlock_destroy(&lock);
+    (void)pthread_mutex_destroy(&blockMutex);
     (void)pthread_mutex_destroy(&mutex);
     (void)pthread_cond_destroy(&cond);
     LOGGER(ibis::gVerbose > 1)
@@ -829,6 +844,11 @@ int ibis::fileManager::getFile(const char* name, storage **st,
                 return -106;
             }
         }
+        else if (errno == ENOENT && ibis::colpack::unpackedSize(name) > 0) {
+            // the raw data file is replaced by a packed data file
+            bytes = ibis::colpack::unpackedSize(name);
+            pref = PREFER_READ;
+        }
         else {
             if (ibis::gVerbose > 11 || errno != ENOENT) {
                 LOGGER(ibis::gVerbose >= 0)
@@ -845,6 +865,7 @@ int ibis::fileManager::getFile(const char* name, storage **st,
     fileList::iterator it = mapped.find(name);
     if (it != mapped.end()) { // found it
         *st = (*it).second;
+        ibis::metrics::fileHits.add();
         return ierr;
     }
 
@@ -852,6 +873,7 @@ int ibis::fileManager::getFile(const char* name, storage **st,
     it = incore.find(name);
     if (it != incore.end()) { // found it
         *st = (*it).second;
+        ibis::metrics::fileHits.add();
         return ierr;
     }
 
@@ -870,16 +892,19 @@ int ibis::fileManager::getFile(const char* name, storage **st,
         it = mapped.find(name);
         if (it != mapped.end()) {
             *st = (*it).second;
+            ibis::metrics::fileHits.add();
             return ierr;
         }
         it = incore.find(name);
         if (it != incore.end()) {
             *st = (*it).second;
+            ibis::metrics::fileHits.add();
             return ierr;
         }
         return -110; // the pending read did not succeed. retry?
     }
     reading.insert(name); // add to the reading list
+    ibis::metrics::fileMisses.add();
     LOGGER(ibis::gVerbose > 5)
         << evt << " -- attempting to read " << name << " ("
         << bytes << " bytes)";
@@ -1024,6 +1049,10 @@ int ibis::fileManager::getFile(const char* name, storage **st,
             }
         }
 
+        if (tmp->isFileMap())
+            ibis::metrics::bytesMapped.add(tmp->size());
+        else
+            ibis::metrics::bytesRead.add(tmp->size());
         *st = tmp; // pass tmp to the caller
         ierr = 0;
     }
@@ -1072,6 +1101,7 @@ int ibis::fileManager::tryGetFile(const char* name, storage **st,
     fileList::iterator it = mapped.find(name);
     if (it != mapped.end()) { // found it
         *st = (*it).second;
+        ibis::metrics::fileHits.add();
         return ierr;
     }
 
@@ -1079,6 +1109,7 @@ int ibis::fileManager::tryGetFile(const char* name, storage **st,
     it = incore.find(name);
     if (it != incore.end()) { // found it
         *st = (*it).second;
+        ibis::metrics::fileHits.add();
         return ierr;
     }
 
@@ -1092,6 +1123,11 @@ int ibis::fileManager::tryGetFile(const char* name, storage **st,
                 return -106;
             }
         }
+        else if (errno == ENOENT && ibis::colpack::unpackedSize(name) > 0) {
+            // the raw data file is replaced by a packed data file
+            bytes = ibis::colpack::unpackedSize(name);
+            pref = PREFER_READ;
+        }
         else {
             if (ibis::gVerbose > 11 || errno != ENOENT) {
                 LOGGER(ibis::gVerbose > 2)
@@ -1111,6 +1147,7 @@ int ibis::fileManager::tryGetFile(const char* name, storage **st,
         return -111; // another thread is reading the same file
     }
     reading.insert(name); // record the name
+    ibis::metrics::fileMisses.add();
     LOGGER(ibis::gVerbose > 5)
         << evt << " determined the file size to be " << bytes;
 
@@ -1220,6 +1257,10 @@ int ibis::fileManager::tryGetFile(const char* name, storage **st,
             }
         }
 
+        if (tmp->isFileMap())
+            ibis::metrics::bytesMapped.add(tmp->size());
+        else
+            ibis::metrics::bytesRead.add(tmp->size());
         *st = tmp; // pass tmp to the caller
         ierr = 0;
     }
@@ -1333,6 +1374,10 @@ ibis::fileManager::getFileSegment(const char* name, const int fdes,
     }
 #endif
     if (st->size() == bytes) {
+        if (st->isFileMap())
+            ibis::metrics::bytesMapped.add(st->size());
+        else
+            ibis::metrics::bytesRead.add(st->size());
         LOGGER(ibis::gVerbose > 4)
             << evt <<" completed " << (ismapped?"mmapping":"reading")
             << " " << st->size() << " bytes";
@@ -1363,6 +1408,104 @@ ibis::fileManager::getFileSegment(const char* name, const int fdes,
     return st;
 } // ibis::fileManager::getFileSegment
 
+/// Retrieve block @c b of the packed file @c name from the pool of
+/// decompressed blocks.  Return true if the block is in the pool, in
+/// which case @c blk shares the content of the block.
+bool ibis::fileManager::getBlock(const char* name, uint32_t b,
+                                 ibis::array_t<char>& blk) const {
+    if (name == 0 || *name == 0) return false;
+    std::ostringstream oss;
+    oss << name << '#' << b;
+    ibis::util::mutexLock lck(&blockMutex, "fileManager::getBlock");
+    blockList::iterator it = blocks.find(oss.str());
+    if (it == blocks.end())
+        return false;
+
+    (*it).second.last = hbeat++;
+    blk.copy(*((*it).second.arr));
+    return true;
+} // ibis::fileManager::getBlock
+
+/// Add block @c b of the packed file @c name to the pool of decompressed
+/// blocks.  The least recently used blocks are removed from the pool when
+/// the total size exceeds the parameter fileManager.maxBlockBytes, which
+/// defaults to 1/32 of fileManager.maxBytes.  The pool is also emptied
+/// whenever the file manager needs to free memory.
+void ibis::fileManager::putBlock(const char* name, uint32_t b,
+                                 const ibis::array_t<char>& blk) {
+    if (name == 0 || *name == 0 || blk.empty()) return;
+    std::ostringstream oss;
+    oss << name << '#' << b;
+    std::vector<ibis::array_t<char>*> evicted;
+    {
+        ibis::util::mutexLock lck(&blockMutex, "fileManager::putBlock");
+        blockList::iterator it = blocks.find(oss.str());
+        if (it != blocks.end()) {
+            (*it).second.last = hbeat++;
+            return;
+        }
+
+        block& ent = blocks[oss.str()];
+        ent.arr = new ibis::array_t<char>(blk);
+        ent.last = hbeat++;
+        blockBytes += blk.size();
+        while (blockBytes > maxBlockBytes && blocks.size() > 1) {
+            blockList::iterator old = blocks.begin();
+            for (it = blocks.begin(); it != blocks.end(); ++ it) {
+                if ((*it).second.last < (*old).second.last)
+                    old = it;
+            }
+            blockBytes -= (*old).second.arr->size();
+            evicted.push_back((*old).second.arr);
+            blocks.erase(old);
+        }
+    }
+    // free the evicted blocks without holding the lock
+    for (size_t j = 0; j < evicted.size(); ++ j)
+        delete evicted[j];
+} // ibis::fileManager::putBlock
+
+/// Remove the decompressed blocks of the packed file @c name from the
+/// pool.
+void ibis::fileManager::flushBlocks(const char* name) {
+    if (name == 0 || *name == 0) return;
+    const std::string prefix = std::string(name) + '#';
+    std::vector<ibis::array_t<char>*> evicted;
+    {
+        ibis::util::mutexLock lck(&blockMutex, "fileManager::flushBlocks");
+        blockList::iterator it = blocks.lower_bound(prefix);
+        while (it != blocks.end() &&
+               (*it).first.compare(0, prefix.size(), prefix) == 0) {
+            blockBytes -= (*it).second.arr->size();
+            evicted.push_back((*it).second.arr);
+            blocks.erase(it ++);
+        }
+    }
+    for (size_t j = 0; j < evicted.size(); ++ j)
+        delete evicted[j];
+} // ibis::fileManager::flushBlocks
+
+/// Remove all decompressed blocks from the pool.
+void ibis::fileManager::clearBlocks() const {
+    std::vector<ibis::array_t<char>*> evicted;
+    {
+        ibis::util::mutexLock lck(&blockMutex, "fileManager::clearBlocks");
+        if (blocks.empty()) return;
+        LOGGER(ibis::gVerbose > 6)
+            << "fileManager::clearBlocks -- removing " << blocks.size()
+            << " decompressed block" << (blocks.size()>1?"s":"") << " ("
+            << blockBytes << " bytes)";
+        evicted.reserve(blocks.size());
+        for (blockList::const_iterator it = blocks.begin();
+             it != blocks.end(); ++ it)
+            evicted.push_back((*it).second.arr);
+        blocks.clear();
+        blockBytes = 0;
+    }
+    for (size_t j = 0; j < evicted.size(); ++ j)
+        delete evicted[j];
+} // ibis::fileManager::clearBlocks
+
 /// Unload enough space so that @c sz bytes can be read into memory.
 /// Caller must hold a mutex lock to prevent simutaneous invocation of this
 /// function.  It will wait a maximum of FASTBIT_MAX_WAIT_TIME seconds if
@@ -1480,6 +1623,7 @@ int ibis::fileManager::unload(size_t sz) {
                 else {
                     incore.erase(it);
                 }
+                ibis::metrics::fileEvictions.add();
                 delete tmp;
             }
             return 0;
@@ -1505,6 +1649,7 @@ int ibis::fileManager::unload(size_t sz) {
                 else {
                     incore.erase(it);
                 }
+                ibis::metrics::fileEvictions.add();
                 delete tmp; // remove the target selected
                 candidates.resize(candidates.size()-1);
             }
@@ -1598,6 +1743,7 @@ int ibis::fileManager::unload(size_t sz) {
 
 /// Invoke the external cleanup function registered with the file manager.
 void ibis::fileManager::invokeCleaners() const {
+    clearBlocks();
     const uint64_t before = ibis::fileManager::totalBytes();
     if (before == 0 || cleaners.empty()) return;
 
@@ -2680,6 +2826,27 @@ void ibis::fileManager::roFile::doRead(const char* file) {
     if (0 == UnixStat(file, &tmp)) { // get stat correctly
         n = tmp.st_size;
     }
+    else if (ibis::colpack::unpackedSize(file) > 0) {
+        // the raw data file is replaced by a packed data file
+        n = ibis::colpack::unpackedSize(file);
+        enlarge(n);
+        if (ibis::colpack::unpack(file, m_begin, n) != (int64_t)n) {
+            LOGGER(ibis::gVerbose > 1)
+                << "Warning -- " << evt << " failed to unpack \"" << file
+                << "\"";
+            free(m_begin);
+            m_begin = 0;
+            m_end = 0;
+            return;
+        }
+        LOGGER(ibis::gVerbose > 6)
+            << "roFile::doRead -- unpacked " << n << " bytes of file \""
+            << file << "\" to " << static_cast<const void*>(m_begin);
+        name = ibis::util::strnewdup(file);
+        m_end = m_begin + n;
+        opened = time(0);
+        return;
+    }
     else {
         LOGGER(ibis::gVerbose > 2)
             << "Warning -- " << evt << " failed to find out the size of \""
@@ -2865,21 +3032,7 @@ ibis::fileManager::rofSegment::rofSegment(const char *fn, off_t b, off_t e)
                               IBIS_FILE_LINE);
     }
 
-    if (m_begin != 0) {
-        std::string evt = "fileManager::rofSegment";
-        if (ibis::gVerbose > 6) {
-            std::ostringstream oss;
-            oss << "("  << static_cast<void*>(this) << ", "
-                << static_cast<void*>(m_begin) << ", " << fn << ", " << b
-                << ", " << e << static_cast<void*>(m_end) << ")";
-            evt += oss.str();
-        }
-        ibis::fileManager::increaseUse(size(), evt.c_str());
-    }
-    else {
-        throw ibis::bad_alloc("fileManager::rofSegment::ctor failed to map file"
-                              IBIS_FILE_LINE);
-    }
+    // doMap has already added the mapped bytes to totalBytes
 } // ibis::fileManager::rofSegment::rofSegment
 
 void ibis::fileManager::rofSegment::printStatus(std::ostream& out) const {
@@ -85,6 +85,10 @@ public:
     static storage* getFileSegment(const char* name, const int fdes,
 				   const off_t b, const off_t e);
 
+    bool getBlock(const char* name, uint32_t b, array_t<char>& blk) const;
+    void putBlock(const char* name, uint32_t b, const array_t<char>& blk);
+    void flushBlocks(const char* name);
+
     // /// Obtain a read lock on the file manager.
     // inline void gainReadAccess(const char* mesg) const;
     // /// Release a read lock on the file manager.
@@ -201,6 +205,23 @@ private:
     /// The conditional variable for reading list.
     pthread_cond_t readCond;
 
+    /// A decompressed block and the time it was last used.
+    struct block {
+	array_t<char>* arr;
+	time_t last;
+    };
+    typedef std::map< std::string, block > blockList;
+    /// Decompressed blocks of packed files, keyed by the file name and
+    /// the block number.
+    mutable blockList blocks;
+    /// The number of bytes in @c blocks.
+    mutable uint64_t blockBytes;
+    /// The maximum number of bytes in @c blocks.
+    uint64_t maxBlockBytes;
+    /// Control access to @c blocks.
+    mutable pthread_mutex_t blockMutex;
+    void clearBlocks() const;
+
     /// The multiple read single write lock
     //mutable pthread_rwlock_t lock;
     /// Control access to incore and mapped
@@ -12,6 +12,8 @@
 #include "countQuery.h" // ibis::countQuery
 #include "filter.h"     // ibis::filter
 #include "util.h"       // ibis::util::makeGuard
+#include "profile.h"    // ibis::profile
+#include "metrics.h"    // ibis::metrics
 
 #include <memory>       // std::unique_ptr
 #include <algorithm>    // std::sort
@@ -311,6 +313,8 @@ ibis::table* ibis::filter::select() const {
     const ibis::constPartList &myparts =
         (parts_ != 0 ? *parts_ :
          reinterpret_cast<const ibis::constPartList&>(ibis::datasets));
+    ibis::profile::phase ph("select", sel_ != 0 ? sel_->getString() : 0);
+    ibis::metrics::timer mt(ibis::metrics::selectTime);
     if (sel_ == 0) {
         return new ibis::tabula(count());
     }
@@ -2687,6 +2691,8 @@ ibis::table* ibis::filter::sift2S(const ibis::selectClause        &tms,
 ibis::table* ibis::table::select(const ibis::constPartList& mylist,
                                  const char *sel, const char *cond) {
     try {
+        ibis::profile::phase ph("select", sel);
+        ibis::metrics::timer mt(ibis::metrics::selectTime);
         if (mylist.empty())
             return new ibis::tabula(); // return an empty unnamed table
 
@@ -2758,6 +2764,8 @@ ibis::table* ibis::table::select(const ibis::constPartList& mylist,
 ibis::table* ibis::table::select(const ibis::constPartList& plist,
                                  const char *sel, const ibis::qExpr *cond) {
     try {
+        ibis::profile::phase ph("select", sel);
+        ibis::metrics::timer mt(ibis::metrics::selectTime);
         if (plist.empty())
             return new ibis::tabula(); // return an empty unnamed table
 
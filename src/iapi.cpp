@@ -4,6 +4,7 @@
    Copyright (c) 2001-20164-2014 the Regents of the University of California
 */
 #include "iapi.h"
+#include "arrow.h"
 #include "bord.h"
 #include "ibin.h"
 #include "irelic.h"
@@ -1664,6 +1665,93 @@ extern "C" int fastbit_iapi_register_array
         return -2;
 } // fastbit_iapi_register_array
 
+/**
+   @arg schema the description of the Arrow array.  If its format is "+s",
+   each child is registered as an array under the name of the child,
+   otherwise the array itself is registered under the name in @c schema.
+
+   @arg array the Arrow array.  The children with the formats "c", "C",
+   "s", "S", "i", "I", "l", "L", "f" and "g" are registered, the others
+   are skipped.  The buffers are used in place, therefore the caller must
+   not release @c array before the arrays registered are removed with
+   fastbit_iapi_free_array or fastbit_iapi_free_all.  The validity bitmap
+   is converted into the null mask of the array registered.
+
+   @return This function returns the number of arrays registered, or a
+   negative number to indicate error.
+ */
+extern "C" int fastbit_iapi_register_arrow
+(const struct ArrowSchema *schema, const struct ArrowArray *array) {
+    if (schema == 0 || array == 0 || schema->format == 0 ||
+        array->release == 0)
+        return -1;
+
+    std::vector<const ArrowSchema*> fields;
+    std::vector<const ArrowArray*> arrays;
+    if (std::strcmp(schema->format, "+s") == 0) {
+        for (int64_t j = 0; j < schema->n_children &&
+                 j < array->n_children; ++ j) {
+            fields.push_back(schema->children[j]);
+            arrays.push_back(array->children[j]);
+        }
+    }
+    else {
+        fields.push_back(schema);
+        arrays.push_back(array);
+    }
+
+    int cnt = 0;
+    for (size_t j = 0; j < fields.size(); ++ j) {
+        const ArrowSchema &fld = *(fields[j]);
+        const ArrowArray  &arr = *(arrays[j]);
+        FastBitDataType dtype = FastBitDataTypeUnknown;
+        size_t width = 0;
+        if (fld.format != 0 && fld.format[0] != 0 && fld.format[1] == 0 &&
+            fld.dictionary == 0) {
+            switch (*fld.format) {
+            default: break;
+            case 'c': dtype = FastBitDataTypeByte;   width = 1; break;
+            case 'C': dtype = FastBitDataTypeUByte;  width = 1; break;
+            case 's': dtype = FastBitDataTypeShort;  width = 2; break;
+            case 'S': dtype = FastBitDataTypeUShort; width = 2; break;
+            case 'i': dtype = FastBitDataTypeInt;    width = 4; break;
+            case 'I': dtype = FastBitDataTypeUInt;   width = 4; break;
+            case 'l': dtype = FastBitDataTypeLong;   width = 8; break;
+            case 'L': dtype = FastBitDataTypeULong;  width = 8; break;
+            case 'f': dtype = FastBitDataTypeFloat;  width = 4; break;
+            case 'g': dtype = FastBitDataTypeDouble; width = 8; break;
+            }
+        }
+        if (dtype == FastBitDataTypeUnknown || fld.name == 0 ||
+            *fld.name == 0 || arr.n_buffers < 2 || arr.buffers[1] == 0 ||
+            arr.length <= 0) {
+            LOGGER(ibis::gVerbose > 1)
+                << "Warning -- fastbit_iapi_register_arrow skips field " << j
+                << " (" << (fld.name ? fld.name : "") << ") with format \""
+                << (fld.format ? fld.format : "") << "\"";
+            continue;
+        }
+
+        void *addr = const_cast<char*>(static_cast<const char*>
+                                       (arr.buffers[1])) + arr.offset * width;
+        ibis::bord::column *col = __fastbit_iapi_register_array
+            (fld.name, dtype, addr, arr.length);
+        if (col == 0)
+            continue;
+
+        ++ cnt;
+        const unsigned char *bits =
+            static_cast<const unsigned char*>(arr.buffers[0]);
+        if (bits != 0 && arr.null_count != 0) {
+            ibis::bitvector msk;
+            for (int64_t i = arr.offset; i < arr.offset + arr.length; ++ i)
+                msk += ((bits[i >> 3] >> (i & 7)) & 1);
+            col->setNullMask(msk);
+        }
+    }
+    return cnt;
+} // fastbit_iapi_register_arrow
+
 /**
    @arg nm: name of the array to be extended.
    @arg dtype: type of the array.
@@ -27,6 +27,9 @@ The word iapi appears to be a Dekota word for "word" or "language".
 #include "const.h"	// common definitions and declarations
 #include "capi.h"	// reuse the definitions from capi.h
 
+struct ArrowSchema;	/* the Arrow C Data Interface, see arrow.h */
+struct ArrowArray;
+
 /** An enum for data types supported by this interface.
 
     @note Only fixed-size data types are supported.
@@ -133,6 +136,9 @@ extern "C" {
     /** Register a simple array under the specified name. */
     int fastbit_iapi_register_array
     (const char*, FastBitDataType, void*, uint64_t);
+    /** Register the columns of an Arrow array without copying. */
+    int fastbit_iapi_register_arrow(const struct ArrowSchema*,
+                                    const struct ArrowArray*);
     /** Extend the array with the given name with new content. */
     int fastbit_iapi_extend_array
     (const char*, FastBitDataType, void*, uint64_t);
@@ -854,6 +854,168 @@ void ibis::bin::binning(const char* f, const array_t<double>& bd) {
     }
 } // ibis::bin::binning (specified bin boundaries)
 
+/// Compute the bin numbers of one segment of rows for
+/// ibis::bin::binValues, and the minimum and maximum values of each bin
+/// within the segment.  The rows not marked 1 in the mask are given the
+/// bin number nobs, which does not correspond to any bin.
+template <typename E>
+struct ibis::bin::binTask : public ibis::index::segmentTask {
+    const ibis::bin &self;
+    const array_t<E> &val;
+    const ibis::bitvector &mask;
+    const uint32_t seglen;
+    array_t<uint32_t> ibin;
+    std::vector< array_t<double> > minv;
+    std::vector< array_t<double> > maxv;
+
+    binTask(const ibis::bin &b, const array_t<E> &v,
+            const ibis::bitvector &m, uint32_t sl, uint32_t ns)
+        : self(b), val(v), mask(m), seglen(sl), ibin(v.size(), b.nobs),
+          minv(ns), maxv(ns) {}
+
+    virtual void run(uint32_t i) {
+        const uint32_t begin = i * seglen;
+        const uint32_t end = (val.size() - begin > seglen ?
+                              begin + seglen : val.size());
+        minv[i].resize(self.nobs);
+        maxv[i].resize(self.nobs);
+        for (uint32_t j = 0; j < self.nobs; ++ j) {
+            minv[i][j] = DBL_MAX;
+            maxv[i][j] = -DBL_MAX;
+        }
+        for (ibis::bitvector::indexSet is = mask.firstIndexSet();
+             is.nIndices() > 0 && *(is.indices()) < end; ++ is) {
+            const ibis::bitvector::word_t *iix = is.indices();
+            if (is.isRange()) {
+                const uint32_t last = (iix[1] < end ? iix[1] : end);
+                for (uint32_t k = (*iix > begin ? *iix : begin);
+                     k < last; ++ k)
+                    setBin(i, k);
+            }
+            else if (iix[is.nIndices()-1] >= begin) {
+                for (uint32_t k = 0; k < is.nIndices(); ++ k)
+                    if (iix[k] >= begin && iix[k] < end)
+                        setBin(i, iix[k]);
+            }
+        }
+    }
+
+    void setBin(uint32_t i, uint32_t k) {
+        const uint32_t j = self.locate(val[k]);
+        ibin[k] = j;
+        if (j < self.nobs) {
+            if (minv[i][j] > static_cast<double>(val[k]))
+                minv[i][j] = static_cast<double>(val[k]);
+            if (maxv[i][j] < static_cast<double>(val[k]))
+                maxv[i][j] = static_cast<double>(val[k]);
+        }
+    }
+}; // ibis::bin::binTask
+
+/// Place the values marked 1 in @c mask into the bins defined by bounds,
+/// i.e., set the bits of bits[j] for the rows falling in bin j, and record
+/// the minimum and maximum values of each bin in minval and maxval.  The
+/// caller must have set nobs and bounds, and allocated the bitmaps.
+///
+/// If more than one thread is to be used for building the index (see
+/// ibis::index::buildThreads), the bin numbers of segments of rows are
+/// computed concurrently using the common bin boundaries, and the rows are
+/// then grouped by bin numbers with groupValues, which builds the bitmaps
+/// of each segment concurrently and concatenates them.
+template <typename E>
+void ibis::bin::binValues(const array_t<E>& val,
+                          const ibis::bitvector& mask) {
+    const unsigned nthr = buildThreads(col);
+    const uint32_t seglen = segmentSize(nrows, nthr);
+    if (seglen < nrows && val.size() == nrows) {
+        const uint32_t nseg = (nrows + seglen - 1) / seglen;
+        binTask<E> task(*this, val, mask, seglen, nseg);
+        if (runSegments(task, nseg, nthr) == 0) {
+            array_t<double> keys;
+            array_t<ibis::bitvector*> bms;
+            groupValues(task.ibin, mask, keys, bms, nthr);
+            for (uint32_t i = 0; i < keys.size(); ++ i) {
+                const uint32_t j = static_cast<uint32_t>(keys[i]);
+                if (j < nobs) {
+                    delete bits[j];
+                    bits[j] = bms[i];
+                }
+                else {
+                    delete bms[i];
+                }
+            }
+            for (uint32_t i = 0; i < nseg; ++ i) {
+                for (uint32_t j = 0; j < nobs; ++ j) {
+                    if (minval[j] > task.minv[i][j])
+                        minval[j] = task.minv[i][j];
+                    if (maxval[j] < task.maxv[i][j])
+                        maxval[j] = task.maxv[i][j];
+                }
+            }
+            LOGGER(ibis::gVerbose > 4)
+                << "bin[" << (col ? col->fullname() : "?.?")
+                << "]::binValues used " << nthr << " threads on " << nseg
+                << " segments of " << seglen << " rows";
+            return;
+        }
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- bin[" << (col ? col->fullname() : "?.?")
+            << "]::binValues failed to locate the bins with " << nthr
+            << " threads, try again with one thread";
+    }
+
+    ibis::bitvector::indexSet iset = mask.firstIndexSet();
+    uint32_t nind = iset.nIndices();
+    const ibis::bitvector::word_t *iix = iset.indices();
+    while (nind) {
+        if (iset.isRange()) { // a range
+            uint32_t k = (iix[1] < nrows ? iix[1] : nrows);
+            for (uint32_t i = *iix; i < k; ++i) {
+                uint32_t j = locate(val[i]);
+                if (j < nobs) {
+                    bits[j]->setBit(i, 1);
+                    if (minval[j] > val[i])
+                        minval[j] = val[i];
+                    if (maxval[j] < val[i])
+                        maxval[j] = val[i];
+                }
+            }
+        }
+        else if (*iix+ibis::bitvector::bitsPerLiteral() < nrows) {
+            // a list of indices
+            for (uint32_t i = 0; i < nind; ++i) {
+                uint32_t k = iix[i];
+                uint32_t j = locate(val[k]);
+                if (j < nobs) {
+                    bits[j]->setBit(k, 1);
+                    if (minval[j] > val[k])
+                        minval[j] = val[k];
+                    if (maxval[j] < val[k])
+                        maxval[j] = val[k];
+                }
+            }
+        }
+        else {
+            for (uint32_t i = 0; i < nind; ++i) {
+                uint32_t k = iix[i];
+                if (k < nrows) {
+                    uint32_t j = locate(val[k]);
+                    if (j < nobs) {
+                        bits[j]->setBit(k, 1);
+                        if (minval[j] > val[k])
+                            minval[j] = val[k];
+                        if (maxval[j] < val[k])
+                            maxval[j] = val[k];
+                    }
+                }
+            }
+        }
+        ++iset;
+        nind = iset.nIndices();
+        if (*iix >= nrows) nind = 0;
+    } // while (nind)
+} // ibis::bin::binValues
+
 /// This function actually reads the values of the data file and produces
 /// the bitvectors for each bin.  The caller must have setup the bounds
 /// already.
@@ -910,56 +1072,7 @@ void ibis::bin::binning(const char* f) {
             nrows = val.size();
             if (nrows > mask.size())
                 mask.adjustSize(nrows, nrows);
-            ibis::bitvector::indexSet iset = mask.firstIndexSet();
-            uint32_t nind = iset.nIndices();
-            const ibis::bitvector::word_t *iix = iset.indices();
-            while (nind) {
-                if (iset.isRange()) { // a range
-                    uint32_t k = (iix[1] < nrows ? iix[1] : nrows);
-                    for (uint32_t i = *iix; i < k; ++i) {
-                        uint32_t j = locate(val[i]);
-                        if (j < nobs) {
-                            bits[j]->setBit(i, 1);
-                            if (minval[j] > val[i])
-                                minval[j] = val[i];
-                            if (maxval[j] < val[i])
-                                maxval[j] = val[i];
-                        }
-                    }
-                }
-                else if (*iix+ibis::bitvector::bitsPerLiteral() < nrows) {
-                    // a list of indices
-                    for (uint32_t i = 0; i < nind; ++i) {
-                        uint32_t k = iix[i];
-                        uint32_t j = locate(val[k]);
-                        if (j < nobs) {
-                            bits[j]->setBit(k, 1);
-                            if (minval[j] > val[k])
-                                minval[j] = val[k];
-                            if (maxval[j] < val[k])
-                                maxval[j] = val[k];
-                        }
-                    }
-                }
-                else {
-                    for (uint32_t i = 0; i < nind; ++i) {
-                        uint32_t k = iix[i];
-                        if (k < nrows) {
-                            uint32_t j = locate(val[k]);
-                            if (j < nobs) {
-                                bits[j]->setBit(k, 1);
-                                if (minval[j] > val[k])
-                                    minval[j] = val[k];
-                                if (maxval[j] < val[k])
-                                    maxval[j] = val[k];
-                            }
-                        }
-                    }
-                }
-                ++iset;
-                nind = iset.nIndices();
-                if (*iix >= nrows) nind = 0;
-            } // while (nind)
+            binValues(val, mask);
         }
         break;}
     case ibis::INT: {// signed int
@@ -977,56 +1090,7 @@ void ibis::bin::binning(const char* f) {
             nrows = val.size();
             if (nrows > mask.size())
                 mask.adjustSize(nrows, nrows);
-            ibis::bitvector::indexSet iset = mask.firstIndexSet();
-            uint32_t nind = iset.nIndices();
-            const ibis::bitvector::word_t *iix = iset.indices();
-            while (nind) {
-                if (iset.isRange()) { // a range
-                    uint32_t k = (iix[1] < nrows ? iix[1] : nrows);
-                    for (uint32_t i = *iix; i < k; ++i) {
-                        uint32_t j = locate(val[i]);
-                        if (j < nobs) {
-                            bits[j]->setBit(i, 1);
-                            if (minval[j] > val[i])
-                                minval[j] = val[i];
-                            if (maxval[j] < val[i])
-                                maxval[j] = val[i];
-                        }
-                    }
-                }
-                else if (*iix+ibis::bitvector::bitsPerLiteral() < nrows) {
-                    // a list of indices
-                    for (uint32_t i = 0; i < nind; ++i) {
-                        uint32_t k = iix[i];
-                        uint32_t j = locate(val[k]);
-                        if (j < nobs) {
-                            bits[j]->setBit(k, 1);
-                            if (minval[j] > val[k])
-                                minval[j] = val[k];
-                            if (maxval[j] < val[k])
-                                maxval[j] = val[k];
-                        }
-                    }
-                }
-                else {
-                    for (uint32_t i = 0; i < nind; ++i) {
-                        uint32_t k = iix[i];
-                        if (k < nrows) {
-                            uint32_t j = locate(val[k]);
-                            if (j < nobs) {
-                                bits[j]->setBit(k, 1);
-                                if (minval[j] > val[k])
-                                    minval[j] = val[k];
-                                if (maxval[j] < val[k])
-                                    maxval[j] = val[k];
-                            }
-                        }
-                    }
-                }
-                ++iset;
-                nind = iset.nIndices();
-                if (*iix >= nrows) nind = 0;
-            } // while (nind)
+            binValues(val, mask);
         }
         break;}
     case ibis::FLOAT: {// (4-byte) floating-point values
@@ -1044,62 +1108,7 @@ void ibis::bin::binning(const char* f) {
             nrows = val.size();
             if (nrows > mask.size())
                 mask.adjustSize(nrows, nrows);
-            ibis::bitvector::indexSet iset = mask.firstIndexSet();
-            uint32_t nind = iset.nIndices();
-            const ibis::bitvector::word_t *iix = iset.indices();
-            while (nind) {
-                if (iset.isRange()) { // a range
-                    uint32_t k = (iix[1] < nrows ? iix[1] : nrows);
-                    for (uint32_t i = *iix; i < k; ++i) {
-                        uint32_t j = locate(val[i]);
-#if defined(DBUG) || defined(_DEBUG)
-                        LOGGER(ibis::gVerbose > 8 && i%1000==0)
-                            << "DEBUG -- binning val[" << i << "] = "
-                            << val[i] << " ==> bin " << j
-                            << (j<nobs?"":" ***out-of-range***");
-#endif
-                        if (j < nobs) {
-                            bits[j]->setBit(i, 1);
-                            if (minval[j] > val[i])
-                                minval[j] = val[i];
-                            if (maxval[j] < val[i])
-                                maxval[j] = val[i];
-                        }
-                    }
-                }
-                else if (*iix+ibis::bitvector::bitsPerLiteral() < nrows) {
-                    // a list of indices
-                    for (uint32_t i = 0; i < nind; ++i) {
-                        uint32_t k = iix[i];
-                        uint32_t j = locate(val[k]);
-                        if (j < nobs) {
-                            bits[j]->setBit(k, 1);
-                            if (minval[j] > val[k])
-                                minval[j] = val[k];
-                            if (maxval[j] < val[k])
-                                maxval[j] = val[k];
-                        }
-                    }
-                }
-                else {
-                    for (uint32_t i = 0; i < nind; ++i) {
-                        uint32_t k = iix[i];
-                        if (k < nrows) {
-                            uint32_t j = locate(val[k]);
-                            if (j < nobs) {
-                                bits[j]->setBit(k, 1);
-                                if (minval[j] > val[k])
-                                    minval[j] = val[k];
-                                if (maxval[j] < val[k])
-                                    maxval[j] = val[k];
-                            }
-                        }
-                    }
-                }
-                ++iset;
-                nind = iset.nIndices();
-                if (*iix >= nrows) nind = 0;
-            } // while (nind)
+            binValues(val, mask);
 
             // reset the nominal boundaries of the bins
             for (uint32_t i = 0; i < nobs-1; ++ i) {
@@ -1124,56 +1133,7 @@ void ibis::bin::binning(const char* f) {
             nrows = val.size();
             if (nrows > mask.size())
                 mask.adjustSize(nrows, nrows);
-            ibis::bitvector::indexSet iset = mask.firstIndexSet();
-            uint32_t nind = iset.nIndices();
-            const ibis::bitvector::word_t *iix = iset.indices();
-            while (nind) {
-                if (iset.isRange()) { // a range
-                    uint32_t k = (iix[1] < nrows ? iix[1] : nrows);
-                    for (uint32_t i = *iix; i < k; ++i) {
-                        uint32_t j = locate(val[i]);
-                        if (j < nobs) {
-                            bits[j]->setBit(i, 1);
-                            if (minval[j] > val[i])
-                                minval[j] = val[i];
-                            if (maxval[j] < val[i])
-                                maxval[j] = val[i];
-                        }
-                    }
-                }
-                else if (*iix+ibis::bitvector::bitsPerLiteral() < nrows) {
-                    // a list of indices
-                    for (uint32_t i = 0; i < nind; ++i) {
-                        uint32_t k = iix[i];
-                        uint32_t j = locate(val[k]);
-                        if (j < nobs) {
-                            bits[j]->setBit(k, 1);
-                            if (minval[j] > val[k])
-                                minval[j] = val[k];
-                            if (maxval[j] < val[k])
-                                maxval[j] = val[k];
-                        }
-                    }
-                }
-                else {
-                    for (uint32_t i = 0; i < nind; ++i) {
-                        uint32_t k = iix[i];
-                        if (k < nrows) {
-                            uint32_t j = locate(val[k]);
-                            if (j < nobs) {
-                                bits[j]->setBit(k, 1);
-                                if (minval[j] > val[k])
-                                    minval[j] = val[k];
-                                if (maxval[j] < val[k])
-                                    maxval[j] = val[k];
-                            }
-                        }
-                    }
-                }
-                ++iset;
-                nind = iset.nIndices();
-                if (*iix >= nrows) nind = 0;
-            } // while (nind)
+            binValues(val, mask);
 
             // reset the nominal boundaries of the bins
             for (uint32_t i = 0; i < nobs-1; ++ i) {
@@ -1198,56 +1158,7 @@ void ibis::bin::binning(const char* f) {
             nrows = val.size();
             if (nrows > mask.size())
                 mask.adjustSize(nrows, nrows);
-            ibis::bitvector::indexSet iset = mask.firstIndexSet();
-            uint32_t nind = iset.nIndices();
-            const ibis::bitvector::word_t *iix = iset.indices();
-            while (nind) {
-                if (iset.isRange()) { // a range
-                    uint32_t k = (iix[1] < nrows ? iix[1] : nrows);
-                    for (uint32_t i = *iix; i < k; ++i) {
-                        uint32_t j = locate(val[i]);
-                        if (j < nobs) {
-                            bits[j]->setBit(i, 1);
-                            if (minval[j] > val[i])
-                                minval[j] = val[i];
-                            if (maxval[j] < val[i])
-                                maxval[j] = val[i];
-                        }
-                    }
-                }
-                else if (*iix+ibis::bitvector::bitsPerLiteral() < nrows) {
-                    // a list of indices
-                    for (uint32_t i = 0; i < nind; ++i) {
-                        uint32_t k = iix[i];
-                        uint32_t j = locate(val[k]);
-                        if (j < nobs) {
-                            bits[j]->setBit(k, 1);
-                            if (minval[j] > val[k])
-                                minval[j] = val[k];
-                            if (maxval[j] < val[k])
-                                maxval[j] = val[k];
-                        }
-                    }
-                }
-                else {
-                    for (uint32_t i = 0; i < nind; ++i) {
-                        uint32_t k = iix[i];
-                        if (k < nrows) {
-                            uint32_t j = locate(val[k]);
-                            if (j < nobs) {
-                                bits[j]->setBit(k, 1);
-                                if (minval[j] > val[k])
-                                    minval[j] = val[k];
-                                if (maxval[j] < val[k])
-                                    maxval[j] = val[k];
-                            }
-                        }
-                    }
-                }
-                ++iset;
-                nind = iset.nIndices();
-                if (*iix >= nrows) nind = 0;
-            } // while (nind)
+            binValues(val, mask);
 
             // reset the nominal boundaries of the bins
             for (uint32_t i = 0; i < nobs-1; ++ i) {
@@ -1272,56 +1183,7 @@ void ibis::bin::binning(const char* f) {
             nrows = val.size();
             if (nrows > mask.size())
                 mask.adjustSize(nrows, nrows);
-            ibis::bitvector::indexSet iset = mask.firstIndexSet();
-            uint32_t nind = iset.nIndices();
-            const ibis::bitvector::word_t *iix = iset.indices();
-            while (nind) {
-                if (iset.isRange()) { // a range
-                    uint32_t k = (iix[1] < nrows ? iix[1] : nrows);
-                    for (uint32_t i = *iix; i < k; ++i) {
-                        uint32_t j = locate(val[i]);
-                        if (j < nobs) {
-                            bits[j]->setBit(i, 1);
-                            if (minval[j] > val[i])
-                                minval[j] = val[i];
-                            if (maxval[j] < val[i])
-                                maxval[j] = val[i];
-                        }
-                    }
-                }
-                else if (*iix+ibis::bitvector::bitsPerLiteral() < nrows) {
-                    // a list of indices
-                    for (uint32_t i = 0; i < nind; ++i) {
-                        uint32_t k = iix[i];
-                        uint32_t j = locate(val[k]);
-                        if (j < nobs) {
-                            bits[j]->setBit(k, 1);
-                            if (minval[j] > val[k])
-                                minval[j] = val[k];
-                            if (maxval[j] < val[k])
-                                maxval[j] = val[k];
-                        }
-                    }
-                }
-                else {
-                    for (uint32_t i = 0; i < nind; ++i) {
-                        uint32_t k = iix[i];
-                        if (k < nrows) {
-                            uint32_t j = locate(val[k]);
-                            if (j < nobs) {
-                                bits[j]->setBit(k, 1);
-                                if (minval[j] > val[k])
-                                    minval[j] = val[k];
-                                if (maxval[j] < val[k])
-                                    maxval[j] = val[k];
-                            }
-                        }
-                    }
-                }
-                ++iset;
-                nind = iset.nIndices();
-                if (*iix >= nrows) nind = 0;
-            } // while (nind)
+            binValues(val, mask);
 
             // reset the nominal boundaries of the bins
             for (uint32_t i = 0; i < nobs-1; ++ i) {
@@ -1346,56 +1208,7 @@ void ibis::bin::binning(const char* f) {
             nrows = val.size();
             if (nrows > mask.size())
                 mask.adjustSize(nrows, nrows);
-            ibis::bitvector::indexSet iset = mask.firstIndexSet();
-            uint32_t nind = iset.nIndices();
-            const ibis::bitvector::word_t *iix = iset.indices();
-            while (nind) {
-                if (iset.isRange()) { // a range
-                    uint32_t k = (iix[1] < nrows ? iix[1] : nrows);
-                    for (uint32_t i = *iix; i < k; ++i) {
-                        uint32_t j = locate(val[i]);
-                        if (j < nobs) {
-                            bits[j]->setBit(i, 1);
-                            if (minval[j] > val[i])
-                                minval[j] = val[i];
-                            if (maxval[j] < val[i])
-                                maxval[j] = val[i];
-                        }
-                    }
-                }
-                else if (*iix+ibis::bitvector::bitsPerLiteral() < nrows) {
-                    // a list of indices
-                    for (uint32_t i = 0; i < nind; ++i) {
-                        uint32_t k = iix[i];
-                        uint32_t j = locate(val[k]);
-                        if (j < nobs) {
-                            bits[j]->setBit(k, 1);
-                            if (minval[j] > val[k])
-                                minval[j] = val[k];
-                            if (maxval[j] < val[k])
-                                maxval[j] = val[k];
-                        }
-                    }
-                }
-                else {
-                    for (uint32_t i = 0; i < nind; ++i) {
-                        uint32_t k = iix[i];
-                        if (k < nrows) {
-                            uint32_t j = locate(val[k]);
-                            if (j < nobs) {
-                                bits[j]->setBit(k, 1);
-                                if (minval[j] > val[k])
-                                    minval[j] = val[k];
-                                if (maxval[j] < val[k])
-                                    maxval[j] = val[k];
-                            }
-                        }
-                    }
-                }
-                ++iset;
-                nind = iset.nIndices();
-                if (*iix >= nrows) nind = 0;
-            } // while (nind)
+            binValues(val, mask);
 
             // reset the nominal boundaries of the bins
             for (uint32_t i = 0; i < nobs-1; ++ i) {
@@ -1420,56 +1233,7 @@ void ibis::bin::binning(const char* f) {
             nrows = val.size();
             if (nrows > mask.size())
                 mask.adjustSize(nrows, nrows);
-            ibis::bitvector::indexSet iset = mask.firstIndexSet();
-            uint32_t nind = iset.nIndices();
-            const ibis::bitvector::word_t *iix = iset.indices();
-            while (nind) {
-                if (iset.isRange()) { // a range
-                    uint32_t k = (iix[1] < nrows ? iix[1] : nrows);
-                    for (uint32_t i = *iix; i < k; ++i) {
-                        uint32_t j = locate(val[i]);
-                        if (j < nobs) {
-                            bits[j]->setBit(i, 1);
-                            if (minval[j] > val[i])
-                                minval[j] = val[i];
-                            if (maxval[j] < val[i])
-                                maxval[j] = val[i];
-                        }
-                    }
-                }
-                else if (*iix+ibis::bitvector::bitsPerLiteral() < nrows) {
-                    // a list of indices
-                    for (uint32_t i = 0; i < nind; ++i) {
-                        uint32_t k = iix[i];
-                        uint32_t j = locate(val[k]);
-                        if (j < nobs) {
-                            bits[j]->setBit(k, 1);
-                            if (minval[j] > val[k])
-                                minval[j] = val[k];
-                            if (maxval[j] < val[k])
-                                maxval[j] = val[k];
-                        }
-                    }
-                }
-                else {
-                    for (uint32_t i = 0; i < nind; ++i) {
-                        uint32_t k = iix[i];
-                        if (k < nrows) {
-                            uint32_t j = locate(val[k]);
-                            if (j < nobs) {
-                                bits[j]->setBit(k, 1);
-                                if (minval[j] > val[k])
-                                    minval[j] = val[k];
-                                if (maxval[j] < val[k])
-                                    maxval[j] = val[k];
-                            }
-                        }
-                    }
-                }
-                ++iset;
-                nind = iset.nIndices();
-                if (*iix >= nrows) nind = 0;
-            } // while (nind)
+            binValues(val, mask);
 
             // reset the nominal boundaries of the bins
             for (uint32_t i = 0; i < nobs-1; ++ i) {
@@ -1494,56 +1258,7 @@ void ibis::bin::binning(const char* f) {
             nrows = val.size();
             if (nrows > mask.size())
                 mask.adjustSize(nrows, nrows);
-            ibis::bitvector::indexSet iset = mask.firstIndexSet();
-            uint32_t nind = iset.nIndices();
-            const ibis::bitvector::word_t *iix = iset.indices();
-            while (nind) {
-                if (iset.isRange()) { // a range
-                    uint32_t k = (iix[1] < nrows ? iix[1] : nrows);
-                    for (uint32_t i = *iix; i < k; ++i) {
-                        uint32_t j = locate(val[i]);
-                        if (j < nobs) {
-                            bits[j]->setBit(i, 1);
-                            if (minval[j] > static_cast<double>(val[i]))
-                                minval[j] = static_cast<double>(val[i]);
-                            if (maxval[j] < static_cast<double>(val[i]))
-                                maxval[j] = static_cast<double>(val[i]);
-                        }
-                    }
-                }
-                else if (*iix+ibis::bitvector::bitsPerLiteral() < nrows) {
-                    // a list of indices
-                    for (uint32_t i = 0; i < nind; ++i) {
-                        uint32_t k = iix[i];
-                        uint32_t j = locate(val[k]);
-                        if (j < nobs) {
-                            bits[j]->setBit(k, 1);
-                            if (minval[j] > static_cast<double>(val[k]))
-                                minval[j] = static_cast<double>(val[k]);
-                            if (maxval[j] < static_cast<double>(val[k]))
-                                maxval[j] = static_cast<double>(val[k]);
-                        }
-                    }
-                }
-                else {
-                    for (uint32_t i = 0; i < nind; ++i) {
-                        uint32_t k = iix[i];
-                        if (k < nrows) {
-                            uint32_t j = locate(val[k]);
-                            if (j < nobs) {
-                                bits[j]->setBit(k, 1);
-                                if (minval[j] > static_cast<double>(val[k]))
-                                    minval[j] = static_cast<double>(val[k]);
-                                if (maxval[j] < static_cast<double>(val[k]))
-                                    maxval[j] = static_cast<double>(val[k]);
-                            }
-                        }
-                    }
-                }
-                ++iset;
-                nind = iset.nIndices();
-                if (*iix >= nrows) nind = 0;
-            } // while (nind)
+            binValues(val, mask);
 
             // reset the nominal boundaries of the bins
             for (uint32_t i = 0; i < nobs-1; ++ i) {
@@ -1568,56 +1283,7 @@ void ibis::bin::binning(const char* f) {
             nrows = val.size();
             if (nrows > mask.size())
                 mask.adjustSize(nrows, nrows);
-            ibis::bitvector::indexSet iset = mask.firstIndexSet();
-            uint32_t nind = iset.nIndices();
-            const ibis::bitvector::word_t *iix = iset.indices();
-            while (nind) {
-                if (iset.isRange()) { // a range
-                    uint32_t k = (iix[1] < nrows ? iix[1] : nrows);
-                    for (uint32_t i = *iix; i < k; ++i) {
-                        uint32_t j = locate(val[i]);
-                        if (j < nobs) {
-                            bits[j]->setBit(i, 1);
-                            if (minval[j] > static_cast<double>(val[i]))
-                                minval[j] = static_cast<double>(val[i]);
-                            if (maxval[j] < static_cast<double>(val[i]))
-                                maxval[j] = static_cast<double>(val[i]);
-                        }
-                    }
-                }
-                else if (*iix+ibis::bitvector::bitsPerLiteral() < nrows) {
-                    // a list of indices
-                    for (uint32_t i = 0; i < nind; ++i) {
-                        uint32_t k = iix[i];
-                        uint32_t j = locate(val[k]);
-                        if (j < nobs) {
-                            bits[j]->setBit(k, 1);
-                            if (minval[j] > static_cast<double>(val[k]))
-                                minval[j] = static_cast<double>(val[k]);
-                            if (maxval[j] < static_cast<double>(val[k]))
-                                maxval[j] = static_cast<double>(val[k]);
-                        }
-                    }
-                }
-                else {
-                    for (uint32_t i = 0; i < nind; ++i) {
-                        uint32_t k = iix[i];
-                        if (k < nrows) {
-                            uint32_t j = locate(val[k]);
-                            if (j < nobs) {
-                                bits[j]->setBit(k, 1);
-                                if (minval[j] > static_cast<double>(val[k]))
-                                    minval[j] = static_cast<double>(val[k]);
-                                if (maxval[j] < static_cast<double>(val[k]))
-                                    maxval[j] = static_cast<double>(val[k]);
-                            }
-                        }
-                    }
-                }
-                ++iset;
-                nind = iset.nIndices();
-                if (*iix >= nrows) nind = 0;
-            } // while (nind)
+            binValues(val, mask);
 
             // reset the nominal boundaries of the bins
             for (uint32_t i = 0; i < nobs-1; ++ i) {
@@ -6568,6 +6234,41 @@ double ibis::bin::estimateCost(const ibis::qContinuousRange& expr) const {
     return ret;
 } // ibis::bin::estimateCost
 
+/// The bitmaps read are those of estimateCost.  The candidates are the
+/// rows in the bins that are only partially covered by the range
+/// condition.  Their number is taken from the bitmaps already in memory,
+/// otherwise the rows are assumed to be evenly spread over the bins.
+void ibis::bin::estimateWork(const ibis::qContinuousRange& expr,
+                             double& bytes, double& cands) const {
+    bytes = 0.0;
+    cands = 0.0;
+    uint32_t cand0=0, cand1=nobs, hit0=nobs, hit1=0;
+    locate(expr, cand0, cand1, hit0, hit1);
+    if (cand0 >= cand1)
+        return;
+    if (offset64.size() > bits.size() && cand1 < offset64.size()) {
+        const int64_t tot = offset64.back() - offset64[0];
+        const int64_t mid = offset64[cand1] - offset64[cand0];
+        bytes = ((tot >> 1) >= mid ? mid : tot - mid);
+    }
+    else if (offset32.size() > bits.size() && cand1 < offset32.size()) {
+        const int32_t tot = offset32.back() - offset32[0];
+        const int32_t mid = offset32[cand1] - offset32[cand0];
+        bytes = ((tot >> 1) >= mid ? mid : tot - mid);
+    }
+
+    const double even = (nobs > 0 ? static_cast<double>(nrows) / nobs :
+                         static_cast<double>(nrows));
+    for (uint32_t i = cand0; i < cand1 && i < nobs; ++ i) {
+        if (hit0 <= hit1 && i >= hit0 && i < hit1)
+            continue; // sure hits
+        if (i < bits.size() && bits[i] != 0)
+            cands += bits[i]->cnt();
+        else
+            cands += even;
+    }
+} // ibis::bin::estimateWork
+
 double ibis::bin::estimateCost(const ibis::qDiscreteRange& expr) const {
     double ret = 0;
     const ibis::array_t<double>& vals = expr.getValues();
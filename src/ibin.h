@@ -132,6 +132,8 @@ public:
     virtual void speedTest(std::ostream& out) const;
     virtual double estimateCost(const ibis::qContinuousRange& expr) const;
     virtual double estimateCost(const ibis::qDiscreteRange& expr) const;
+    virtual void estimateWork(const ibis::qContinuousRange& expr,
+                              double& bytes, double& cands) const;
 
     virtual long getCumulativeDistribution(std::vector<double>& bds,
 					   std::vector<uint32_t>& cts) const;
@@ -297,6 +299,10 @@ protected:
     /// ordered data with .bin suffix.
     template <typename E>
     void binningT(const char* fname);
+    /// Place the values marked 1 in the mask into the existing bins.
+    template <typename E>
+    void binValues(const array_t<E>& val, const ibis::bitvector& mask);
+    template <typename E> struct binTask;
     template <typename E>
     long checkBin0(const ibis::qRange& cmp, uint32_t jbin,
 		   ibis::bitvector& res) const;
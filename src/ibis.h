@@ -42,6 +42,12 @@
 #include "part.h"		// ibis::part, ibis::column, ibis::table
 #include "blob.h"		// ibis::blob
 #include "rids.h"		// ibis::ridHandler
+#include "profile.h"		// ibis::profile
+#include "metrics.h"		// ibis::metrics
+#include "workload.h"		// ibis::workload
+#include "resultCache.h"	// ibis::resultCache
+#include "preparedQuery.h"	// ibis::preparedQuery
+#include "advisor.h"		// ibis::advisor
 
 /*! \mainpage Overview of FastBit IBIS Implementation
 
@@ -372,6 +378,29 @@ namespace ibis {
     ///   logfile = /tmp/ibis.log
     ///@endverbatim
     ///
+    /// The process-wide metrics (see ibis::metrics) are enabled by the
+    /// parameter metrics.enable, e.g.,
+    ///
+    ///@verbatim
+    ///   metrics.enable = true
+    ///@endverbatim
+    ///
+    /// Similarly, the statistics on the lock acquisitions (see
+    /// ibis::util::lockStats) are enabled by the parameter
+    /// lockStats.enable, and the recording of the conditions used to
+    /// recommend indexes (see ibis::advisor) by the parameter
+    /// advisor.recordWorkload.  The capture of the queries into a workload log
+    /// (see ibis::workload) is started by the parameter workload.capture,
+    /// e.g.,
+    ///
+    ///@verbatim
+    ///   workload.capture = /tmp/fastbit-workload.log
+    ///@endverbatim
+    ///
+    /// The memory used by the cache of query hits (see ibis::resultCache)
+    /// is limited by the parameter resultCache.maxBytes.  Setting it to 0
+    /// disables the cache.
+    ///
     /// One may call ibis::util::closeLogFile to close the log file, but
     /// this is not mandatory.  The runtime system will close all open
     /// files upon the termination of the user program.
@@ -423,6 +452,17 @@ namespace ibis {
                       << (rcfile!=0&&*rcfile!=0 ? rcfile : "") << '"'
                       << std::endl;
 	(void) ibis::fileManager::instance(); // initialize the file manager
+	if (ibis::gParameters().isTrue("metrics.enable"))
+	    ibis::metrics::enable(true);
+	if (ibis::gParameters().isTrue("lockStats.enable"))
+	    ibis::util::lockStats::enable(true);
+	if (ibis::gParameters().isTrue("advisor.recordWorkload"))
+	    ibis::advisor::enable(true);
+	{
+	    const char* wl = ibis::gParameters()["workload.capture"];
+	    if (wl != 0 && *wl != 0)
+		(void) ibis::workload::startCapture(wl);
+	}
 	if (! ibis::gParameters().empty()) {
 	    ierr = ibis::util::gatherParts(ibis::datasets, ibis::gParameters());
             if (ibis::gVerbose > 0 && ierr > 0)
@@ -199,6 +199,46 @@ ibis::index* ibis::direkte::dup() const {
     return new ibis::direkte(*this);
 }
 
+/// Generate one bitmap for each value in @c vals that is marked 1 in
+/// @c mask.  The bitmap for value v is placed in bits[v].  The rows are
+/// grouped with ibis::index::groupValues, which uses a counting sort for
+/// the small integer values typical of this index, and each bitmap is
+/// generated directly from the sorted list of rows.  It throws an
+/// exception if a value is negative or larger than 2^31.
+template <typename T>
+void ibis::direkte::bucketValues(const array_t<T>& vals,
+                                 const ibis::bitvector& mask) {
+    array_t<double> keys;
+    array_t<ibis::bitvector*> bms;
+    groupValues(vals, mask, keys, bms, buildThreads(col));
+    if (! keys.empty() && (keys[0] < 0.0 || keys.back() > 0x7FFFFFFF)) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- direkte[" << (col ? col->fullname() : "?.?")
+            << "]::bucketValues can not deal with value "
+            << (keys[0] < 0.0 ? keys[0] : keys.back());
+        for (uint32_t j = 0; j < bms.size(); ++ j)
+            delete bms[j];
+        throw "direkte can not index values larger than 2^31";
+    }
+
+    const uint32_t nbits = (keys.empty() ? 0U : (uint32_t)keys.back() + 1U);
+    for (uint32_t j = 0; j < bits.size(); ++ j)
+        delete bits[j];
+    bits.resize(nbits);
+    for (uint32_t j = 0; j < nbits; ++ j)
+        bits[j] = 0;
+    for (uint32_t j = 0; j < keys.size(); ++ j)
+        bits[(uint32_t)keys[j]] = bms[j];
+    for (uint32_t j = 0; j < nbits; ++ j)
+        if (bits[j] == 0)
+            bits[j] = new ibis::bitvector;
+    LOGGER(ibis::gVerbose > 6)
+        << "direkte[" << (col ? col->fullname() : "?.?")
+        << "]::bucketValues generated " << nbits << " bitvector"
+        << (nbits>1?"s":"") << " for " << vals.size() << " value"
+        << (vals.size()>1?"s":"");
+} // ibis::direkte::bucketValues
+
 template <typename T>
 int ibis::direkte::construct0(const char* dfname) {
     if (col == 0) return -1;
@@ -232,69 +272,7 @@ int ibis::direkte::construct0(const char* dfname) {
     else
         ierr = col->getValuesArray(&vals);
     if (ierr == 0) { // got a pointer to the base data
-        const uint32_t nbits = (uint32_t)col->upperBound() + 1;
-#ifdef RESERVE_SPACE_BEFORE_CREATING_INDEX
-        const uint32_t nset = (uint32_t)(nrows+nbits-1)/nbits;
-#endif
-        bits.resize(nbits);
-        for (uint32_t i = 0; i < nbits; ++ i) {
-            bits[i] = new ibis::bitvector();
-#ifdef RESERVE_SPACE_BEFORE_CREATING_INDEX
-            bits[i]->reserve(nbits, nset);
-#endif
-        }
-        LOGGER(ibis::gVerbose > 6)
-            << evt << " allocated " << nbits << " bitvector"
-            << (nbits>1?"s":"");
-
-        for (ibis::bitvector::indexSet is = mask.firstIndexSet();
-             is.nIndices() > 0; ++ is) {
-            const ibis::bitvector::word_t *iix = is.indices();
-            const uint32_t nbits = bits.size();
-            T vmax = bits.size();
-            if (is.isRange()) {
-                for (ibis::bitvector::word_t j = iix[0]; j < iix[1]; ++ j)
-                    if (vmax < vals[j])
-                        vmax = vals[j];
-                if ((uint64_t)vmax > 0x7FFFFFFFU) {
-                    LOGGER(ibis::gVerbose > 1)
-                        << "Warning -- " << evt << " can not deal with value "
-                        << vmax;
-                    throw "direkte can not index values larger than 2^31";
-                }
-                if ((uint64_t)vmax > nbits) {
-                    const uint32_t newsize =
-                        (vmax+1U>nbits+nbits?vmax+1U:nbits+nbits);
-                    bits.resize(newsize);
-                    for (uint32_t i = nbits; i < newsize; ++ i)
-                        bits[i] = new ibis::bitvector;
-                }
-
-                for (ibis::bitvector::word_t j = iix[0]; j < iix[1]; ++ j)
-                    bits[vals[j]]->setBit(j, 1);
-            }
-            else {
-                for (ibis::bitvector::word_t j = 0; j < is.nIndices(); ++ j)
-                    if (vmax < vals[iix[j]])
-                        vmax = vals[iix[j]];
-                if ((uint64_t)vmax > 0x7FFFFFFFU) {
-                    LOGGER(ibis::gVerbose > 1)
-                        << "Warning -- " << evt << " can not deal with value "
-                        << vmax;
-                    throw "direkte can not index values larger than 2^31";
-                }
-                if ((uint64_t)vmax > nbits) {
-                    const uint32_t newsize =
-                        (vmax+1U>nbits+nbits?vmax+1U:nbits+nbits);
-                    bits.resize(newsize);
-                    for (uint32_t i = nbits; i < newsize; ++ i)
-                        bits[i] = new ibis::bitvector;
-                }
-
-                for (ibis::bitvector::word_t j = 0; j < is.nIndices(); ++ j)
-                    bits[vals[iix[j]]]->setBit(iix[j], 1);
-            }
-        }
+        bucketValues(vals, mask);
     }
     else { // failed to read or memory map the data file, try to read the
            // values one at a time
@@ -430,55 +408,7 @@ int ibis::direkte::construct(const char* dfname) {
     else
         ierr = col->getValuesArray(&vals);
     if (ierr == 0) { // got a pointer to the base data
-        if (col->upperBound() > col->lowerBound()) {
-            const uint32_t nbits = (uint32_t)col->upperBound() + 1;
-#ifdef RESERVE_SPACE_BEFORE_CREATING_INDEX
-            const uint32_t nset = (uint32_t)(nrows+nbits-1)/nbits;
-#endif
-            bits.resize(nbits);
-            for (uint32_t i = 0; i < nbits; ++ i) {
-                bits[i] = new ibis::bitvector();
-#ifdef RESERVE_SPACE_BEFORE_CREATING_INDEX
-                bits[i]->reserve(nbits, nset);
-#endif
-            }
-            LOGGER(ibis::gVerbose > 6)
-                << "direkte[" << (col ? col->fullname() : "?.?")
-                << "]::construct finished allocating " << nbits
-                << " bitvectors";
-        }
-        // if (vals.size() > nrows)
-        //     vals.resize(nrows);
-
-        for (ibis::bitvector::indexSet iset = mask.firstIndexSet();
-             iset.nIndices() > 0; ++ iset) {
-            const ibis::bitvector::word_t *iis = iset.indices();
-            if (iset.isRange()) { // a range
-                for (uint32_t j = *iis; j < iis[1]; ++ j) {
-                    const uint32_t nbits = bits.size();
-                    if (nbits <= static_cast<uint32_t>(vals[j])) {
-                        const uint32_t newsize = vals[j]+1;
-                        bits.resize(newsize);
-                        for (uint32_t i = nbits; i < newsize; ++ i)
-                            bits[i] = new ibis::bitvector;
-                    }
-                    bits[vals[j]]->setBit(j, 1);
-                }
-            }
-            else {
-                for (uint32_t i = 0; i < iset.nIndices(); ++ i) {
-                    const ibis::bitvector::word_t j = iis[i];
-                    const uint32_t nbits = bits.size();
-                    if (nbits <= static_cast<uint32_t>(vals[j])) {
-                        const uint32_t newsize = vals[j]+1;
-                        bits.resize(newsize);
-                        for (uint32_t i = nbits; i < newsize; ++ i)
-                            bits[i] = new ibis::bitvector;
-                    }
-                    bits[vals[j]]->setBit(j, 1);
-                }
-            }
-        }
+        bucketValues(vals, mask);
     }
     else if (dfname && *dfname) {
         // failed to read or memory map the data file, try to read the
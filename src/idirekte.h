@@ -100,6 +100,8 @@ protected:
     int construct(const char* f);
     template <typename T>
     int construct0(const char* f);
+    template <typename T>
+    void bucketValues(const array_t<T>& vals, const ibis::bitvector& mask);
 
     void locate(const ibis::qContinuousRange& expr,
 		uint32_t& hit0, uint32_t& hit1) const;
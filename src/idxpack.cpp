@@ -0,0 +1,718 @@
+// File $Id$
+// Author: John Wu <John.Wu at ACM.org>
+//      Lawrence Berkeley National Laboratory
+// Copyright (c) 2007-2016 the Regents of the University of California
+//
+// This file contains the functions to pack and unpack index files.  See
+// idxpack.h for a description of the format.
+#include "idxpack.h"    // ibis::idxpack
+#include "array_t.h"    // ibis::array_t
+
+/// The number of bytes in a block of a packed index file.
+#ifndef FASTBIT_IDXPACK_BLOCK_SIZE
+#define FASTBIT_IDXPACK_BLOCK_SIZE 65536
+#endif
+
+namespace ibis {
+    namespace idxpack {
+        /// The content of the header of a packed index file.
+        struct header {
+            uint64_t size;    ///!< Size of the index file.
+            uint64_t keep;    ///!< Number of bytes stored as they are.
+            uint32_t bsize;   ///!< Number of bytes per block.
+            uint32_t nblocks; ///!< Number of blocks.
+            /// Starting positions (in bytes) of the compressed blocks,
+            /// followed by the size of the packed file.
+            ibis::array_t<uint64_t> offsets;
+        }; // header
+
+        /// The context given out by ibis::idxpack::context.  It holds the
+        /// header of the packed index file so that reading the bitmaps
+        /// does not need to parse it again.  It is shared by the copies
+        /// of an index object through a reference count.
+        struct reader {
+            std::string pk; ///!< Name of the packed index file.
+            header hdr;     ///!< The header of the packed index file.
+            uint32_t nref;  ///!< Number of index objects using this.
+        }; // reader
+    } // namespace idxpack
+} // namespace ibis
+
+/// The first eight bytes of a packed index file.
+static const char _ibis_idxpack_magic[] = "#IBISIZ1";
+/// The block number used to keep the header in the pool of decompressed
+/// blocks.
+static const uint32_t _ibis_idxpack_head = 0xFFFFFFFFU;
+/// Protects the reference counts of ibis::idxpack::reader.
+static pthread_mutex_t _ibis_idxpack_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/// Hash the four bytes starting at @c p into 12 bits.
+static inline uint32_t _ibis_idxpack_hash(const unsigned char* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return (v * 2654435761U) >> 20;
+} // _ibis_idxpack_hash
+
+/// Append a length to the output, 255 at a time.  Return false if the
+/// output is full.
+static inline bool _ibis_idxpack_putLength(size_t len, unsigned char*& op,
+                                           const unsigned char* oend) {
+    while (len >= 255) {
+        if (op >= oend) return false;
+        *op = 255;
+        ++ op;
+        len -= 255;
+    }
+    if (op >= oend) return false;
+    *op = static_cast<unsigned char>(len);
+    ++ op;
+    return true;
+} // _ibis_idxpack_putLength
+
+/// Compress @c n bytes with a simple LZ77 codec.  The output is a
+/// sequence of commands, each consists of a token byte holding the number
+/// of literals (upper four bits) and the match length minus four (lower
+/// four bits), the extra length bytes of the literals, the literals, the
+/// two-byte distance of the match and the extra length bytes of the
+/// match.  The last command has only literals.  Return the number of
+/// bytes produced, or 0 if the output would not be smaller than @c cap.
+static size_t _ibis_idxpack_compress(const unsigned char* in, size_t n,
+                                     unsigned char* out, size_t cap) {
+    if (n < 16) return 0;
+    uint32_t htab[4096];
+    memset(htab, 0, sizeof(htab));
+
+    const unsigned char* oend = out + cap;
+    unsigned char* op = out;
+    const size_t limit = n - 12; // the last bytes are always literals
+    size_t ip = 1, anchor = 0;
+    htab[_ibis_idxpack_hash(in)] = 0;
+    while (ip < limit) {
+        const uint32_t h = _ibis_idxpack_hash(in + ip);
+        const size_t cand = htab[h];
+        htab[h] = static_cast<uint32_t>(ip);
+        if (cand >= ip || ip - cand > 65535 ||
+            memcmp(in + cand, in + ip, 4) != 0) {
+            // skip faster through the bytes that do not match
+            ip += 1 + ((ip - anchor) >> 6);
+            continue;
+        }
+
+        size_t mlen = 4;
+        while (ip + mlen < n - 5 && in[cand + mlen] == in[ip + mlen])
+            ++ mlen;
+        const size_t nlit = ip - anchor;
+        if (op + 1 + nlit + 2 >= oend) return 0;
+        unsigned char* token = op;
+        ++ op;
+        *token = static_cast<unsigned char>
+            (((nlit < 15 ? nlit : 15) << 4) | (mlen-4 < 15 ? mlen-4 : 15));
+        if (nlit >= 15 && ! _ibis_idxpack_putLength(nlit - 15, op, oend))
+            return 0;
+        if (op + nlit + 2 >= oend) return 0;
+        memcpy(op, in + anchor, nlit);
+        op += nlit;
+        const size_t dist = ip - cand;
+        op[0] = static_cast<unsigned char>(dist & 255);
+        op[1] = static_cast<unsigned char>(dist >> 8);
+        op += 2;
+        if (mlen - 4 >= 15 &&
+            ! _ibis_idxpack_putLength(mlen - 4 - 15, op, oend))
+            return 0;
+
+        ip += mlen;
+        anchor = ip;
+        if (ip - 2 < limit)
+            htab[_ibis_idxpack_hash(in + ip - 2)] =
+                static_cast<uint32_t>(ip - 2);
+    }
+
+    const size_t nlit = n - anchor;
+    if (op >= oend) return 0;
+    *op = static_cast<unsigned char>((nlit < 15 ? nlit : 15) << 4);
+    ++ op;
+    if (nlit >= 15 && ! _ibis_idxpack_putLength(nlit - 15, op, oend))
+        return 0;
+    if (op + nlit >= oend) return 0;
+    memcpy(op, in + anchor, nlit);
+    op += nlit;
+    return op - out;
+} // _ibis_idxpack_compress
+
+/// Decompress @c n bytes produced by _ibis_idxpack_compress into @c out,
+/// which has room for @c cap bytes.  Return the number of bytes produced
+/// or a negative number if the input is not valid.
+static long _ibis_idxpack_decompress(const unsigned char* in, size_t n,
+                                     unsigned char* out, size_t cap) {
+    size_t ip = 0, op = 0;
+    while (ip < n) {
+        const unsigned token = in[ip];
+        ++ ip;
+        size_t nlit = (token >> 4);
+        if (nlit == 15) {
+            unsigned char c;
+            do {
+                if (ip >= n) return -1;
+                c = in[ip];
+                ++ ip;
+                nlit += c;
+            } while (c == 255);
+        }
+        if (nlit > n - ip || nlit > cap - op) return -2;
+        memcpy(out + op, in + ip, nlit);
+        ip += nlit;
+        op += nlit;
+        if (ip >= n) break; // the last command
+
+        if (ip + 2 > n) return -3;
+        const size_t dist = in[ip] | (static_cast<size_t>(in[ip+1]) << 8);
+        ip += 2;
+        size_t mlen = (token & 15) + 4;
+        if ((token & 15) == 15) {
+            unsigned char c;
+            do {
+                if (ip >= n) return -4;
+                c = in[ip];
+                ++ ip;
+                mlen += c;
+            } while (c == 255);
+        }
+        if (dist == 0 || dist > op || mlen > cap - op) return -5;
+        // the source and the destination may overlap
+        const unsigned char* src = out + op - dist;
+        for (size_t j = 0; j < mlen; ++ j)
+            out[op + j] = src[j];
+        op += mlen;
+    }
+    return op;
+} // _ibis_idxpack_decompress
+
+/// Position of the offsets of the compressed blocks in the packed file.
+static inline uint64_t _ibis_idxpack_tablePos(uint64_t keep) {
+    return 32 + ((keep + 7) / 8) * 8;
+} // _ibis_idxpack_tablePos
+
+/// Number of bytes in block @c b.
+static inline uint32_t
+_ibis_idxpack_blockSize(const ibis::idxpack::header& hdr, uint32_t b) {
+    const uint64_t rest = hdr.size - hdr.keep -
+        static_cast<uint64_t>(b) * hdr.bsize;
+    return (rest < hdr.bsize ? static_cast<uint32_t>(rest) : hdr.bsize);
+} // _ibis_idxpack_blockSize
+
+/// Fill the header of a packed index file from the four words at the
+/// start of the file and the offsets that follow @c w.  Return 0 on
+/// success, a negative number to indicate error.
+static int _ibis_idxpack_parse(const uint64_t* w, size_t nw,
+                               ibis::idxpack::header& hdr) {
+    if (nw < 4 || memcmp(w, _ibis_idxpack_magic, 8) != 0)
+        return -2;
+    hdr.size = w[1];
+    hdr.keep = w[2];
+    hdr.bsize = static_cast<uint32_t>(w[3]);
+    hdr.nblocks = static_cast<uint32_t>(w[3] >> 32);
+    if (hdr.keep > hdr.size || hdr.bsize == 0 ||
+        hdr.nblocks != (hdr.size - hdr.keep + hdr.bsize - 1) / hdr.bsize)
+        return -3;
+    if (nw > 4) {
+        if (nw < 4 + hdr.nblocks + 1)
+            return -4;
+        hdr.offsets.resize(hdr.nblocks + 1);
+        memcpy(hdr.offsets.begin(), w + 4,
+               sizeof(uint64_t) * (hdr.nblocks + 1));
+    }
+    return 0;
+} // _ibis_idxpack_parse
+
+/// Read the header of the packed index file @c pk.  The header and the
+/// offsets of the compressed blocks are kept in the pool of decompressed
+/// blocks of the file manager.  Return 0 on success, a negative number to
+/// indicate error.
+static int _ibis_idxpack_readHeader(const char* pk, int fdes,
+                                    ibis::idxpack::header& hdr) {
+    ibis::array_t<char> tmp;
+    if (ibis::fileManager::instance().getBlock(pk, _ibis_idxpack_head, tmp))
+        return _ibis_idxpack_parse
+            (reinterpret_cast<const uint64_t*>(tmp.begin()),
+             tmp.size() / 8, hdr);
+
+    uint64_t w[4];
+    if (UnixSeek(fdes, 0, SEEK_SET) != 0 ||
+        ibis::util::read(fdes, w, sizeof(w)) != (int64_t)sizeof(w))
+        return -1;
+    int ierr = _ibis_idxpack_parse(w, 4, hdr);
+    if (ierr < 0) return ierr;
+
+    tmp.resize(sizeof(w) + sizeof(uint64_t) * (hdr.nblocks + 1));
+    memcpy(tmp.begin(), w, sizeof(w));
+    const uint64_t pos = _ibis_idxpack_tablePos(hdr.keep);
+    const int64_t nb = sizeof(uint64_t) * (hdr.nblocks + 1);
+    if (UnixSeek(fdes, pos, SEEK_SET) != (off_t)pos ||
+        ibis::util::read(fdes, tmp.begin() + sizeof(w), nb) != nb)
+        return -5;
+    ierr = _ibis_idxpack_parse
+        (reinterpret_cast<const uint64_t*>(tmp.begin()), tmp.size() / 8, hdr);
+    if (ierr == 0)
+        ibis::fileManager::instance().putBlock(pk, _ibis_idxpack_head, tmp);
+    return ierr;
+} // _ibis_idxpack_readHeader
+
+/// Read and decompress block @c b into @c out.  Return the number of
+/// bytes in the block or a negative number to indicate error.
+static long _ibis_idxpack_readBlock(int fdes, const ibis::idxpack::header& hdr,
+                                    uint32_t b, char* out) {
+    const uint64_t start = hdr.offsets[b];
+    const uint64_t bytes = hdr.offsets[b+1] - start;
+    const uint32_t n = _ibis_idxpack_blockSize(hdr, b);
+    if (hdr.offsets[b+1] <= start || bytes > n)
+        return -11;
+
+    ibis::array_t<char> buf(bytes);
+    if (UnixSeek(fdes, start, SEEK_SET) != (off_t)start)
+        return -12;
+    if (ibis::util::read(fdes, buf.begin(), bytes) != (int64_t)bytes)
+        return -13;
+    ibis::fileManager::instance().recordPages(start, start+bytes);
+    if (bytes == n) { // stored as is
+        memcpy(out, buf.begin(), n);
+        return n;
+    }
+
+    long ierr = _ibis_idxpack_decompress
+        (reinterpret_cast<const unsigned char*>(buf.begin()), bytes,
+         reinterpret_cast<unsigned char*>(out), n);
+    return (ierr == (long)n ? ierr : -14);
+} // _ibis_idxpack_readBlock
+
+/// Retrieve block @c b from the pool of decompressed blocks or, if it is
+/// not there, read and decompress it and add it to the pool.  The packed
+/// file is opened only when a block has to be read from it, and @c fdes
+/// is left open for the caller to close.  Return the number of bytes in
+/// the block or a negative number to indicate error.
+static long _ibis_idxpack_getBlock(const char* pk, int& fdes,
+                                   const ibis::idxpack::header& hdr,
+                                   uint32_t b, ibis::array_t<char>& blk,
+                                   uint32_t& nread) {
+    if (ibis::fileManager::instance().getBlock(pk, b, blk))
+        return blk.size();
+
+    if (fdes < 0) {
+        fdes = UnixOpen(pk, OPEN_READONLY);
+        if (fdes < 0) {
+            LOGGER(ibis::gVerbose > 1)
+                << "Warning -- idxpack::readBitmaps failed to open " << pk
+                << " ... " << (errno ? strerror(errno) : "??");
+            return -2;
+        }
+#if defined(_WIN32) && defined(_MSC_VER)
+        (void)_setmode(fdes, _O_BINARY);
+#endif
+    }
+    ibis::array_t<char> tmp(_ibis_idxpack_blockSize(hdr, b));
+    long ierr = _ibis_idxpack_readBlock(fdes, hdr, b, tmp.begin());
+    if (ierr < 0) return ierr;
+    ++ nread;
+    ibis::fileManager::instance().putBlock(pk, b, tmp);
+    blk.swap(tmp);
+    return blk.size();
+} // _ibis_idxpack_getBlock
+
+/// Compose the name of the packed index file from the name of the index
+/// file.
+void ibis::idxpack::packedName(const char* idx, std::string& pk) {
+    pk = idx;
+    pk += ".pk";
+} // ibis::idxpack::packedName
+
+/// Has the index file been replaced by a packed index file?  Return true
+/// if the index file does not exist and the packed index file exists and
+/// has a valid header.
+bool ibis::idxpack::isPacked(const char* idx) {
+    if (idx == 0 || *idx == 0) return false;
+    Stat_T st;
+    if (UnixStat(idx, &st) == 0) return false;
+    return (unpackedSize(idx) >= 0);
+} // ibis::idxpack::isPacked
+
+/// Size (in bytes) of the index file recorded in the packed index file.
+/// Returns a negative number if the packed index file does not exist or
+/// is not valid.
+int64_t ibis::idxpack::unpackedSize(const char* idx) {
+    if (idx == 0 || *idx == 0) return -1;
+    std::string pk;
+    packedName(idx, pk);
+    int fdes = UnixOpen(pk.c_str(), OPEN_READONLY);
+    if (fdes < 0) return -2;
+#if defined(_WIN32) && defined(_MSC_VER)
+    (void)_setmode(fdes, _O_BINARY);
+#endif
+    IBIS_BLOCK_GUARD(UnixClose, fdes);
+
+    uint64_t w[4];
+    ibis::idxpack::header hdr;
+    if (ibis::util::read(fdes, w, sizeof(w)) != (int64_t)sizeof(w) ||
+        _ibis_idxpack_parse(w, 4, hdr) < 0)
+        return -3;
+    return hdr.size;
+} // ibis::idxpack::unpackedSize
+
+/// Pack the index file @c idx.  The first @c keep bytes of the file are
+/// stored as they are, the rest is compressed in blocks.  The packed
+/// index file is written next to the index file, which is left in place.
+/// Each block is decompressed and compared with the original bytes before
+/// it is written.
+///
+/// Returns the size of the packed index file in bytes, or a negative
+/// number to indicate error.
+int64_t ibis::idxpack::pack(const char* idx, uint64_t keep) {
+    if (idx == 0 || *idx == 0)
+        return -1;
+    const uint64_t size = ibis::util::getFileSize(idx);
+    if (size == 0 || keep > size) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- idxpack::pack can not keep " << keep
+            << " bytes of file " << idx << " with " << size << " bytes";
+        return -2;
+    }
+
+    ibis::array_t<char> raw(size);
+    {
+        int in = UnixOpen(idx, OPEN_READONLY);
+        if (in < 0) {
+            LOGGER(ibis::gVerbose > 1)
+                << "Warning -- idxpack::pack failed to open " << idx
+                << " for reading ... " << (errno ? strerror(errno) : "??");
+            return -3;
+        }
+#if defined(_WIN32) && defined(_MSC_VER)
+        (void)_setmode(in, _O_BINARY);
+#endif
+        IBIS_BLOCK_GUARD(UnixClose, in);
+        if (ibis::util::read(in, raw.begin(), size) != (int64_t)size)
+            return -4;
+    }
+
+    std::string pk;
+    packedName(idx, pk);
+    ibis::fileManager::instance().flushBlocks(pk.c_str());
+    int out = UnixOpen(pk.c_str(), OPEN_WRITENEW, OPEN_FILEMODE);
+    if (out < 0) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- idxpack::pack failed to open " << pk
+            << " for writing ... " << (errno ? strerror(errno) : "??");
+        return -5;
+    }
+#if defined(_WIN32) && defined(_MSC_VER)
+    (void)_setmode(out, _O_BINARY);
+#endif
+
+    const uint32_t bsize = FASTBIT_IDXPACK_BLOCK_SIZE;
+    const uint32_t nblocks = (size - keep + bsize - 1) / bsize;
+    ibis::array_t<uint64_t> offsets(nblocks+1);
+    uint64_t w[4];
+    memcpy(w, _ibis_idxpack_magic, 8);
+    w[1] = size;
+    w[2] = keep;
+    w[3] = bsize | (static_cast<uint64_t>(nblocks) << 32);
+    const uint64_t tpos = _ibis_idxpack_tablePos(keep);
+    offsets[0] = tpos + sizeof(uint64_t) * offsets.size();
+    int64_t ierr = ibis::util::write(out, w, sizeof(w));
+    if (ierr == (int64_t)sizeof(w))
+        ierr = ibis::util::write(out, raw.begin(), keep);
+    if (ierr == (int64_t)keep && tpos > sizeof(w) + keep) {
+        const uint64_t zero = 0;
+        const int64_t npad = tpos - sizeof(w) - keep;
+        ierr = (ibis::util::write(out, &zero, npad) == npad ? keep : -1);
+    }
+    if (ierr == (int64_t)keep)
+        ierr = ibis::util::write(out, offsets.begin(),
+                                 sizeof(uint64_t) * offsets.size());
+    if (ierr != (int64_t)(sizeof(uint64_t) * offsets.size())) {
+        UnixClose(out);
+        remove(pk.c_str());
+        return -6;
+    }
+
+    ibis::array_t<char> blk(bsize);
+    ibis::array_t<char> check(bsize);
+    ibis::idxpack::header hdr;
+    hdr.size = size;
+    hdr.keep = keep;
+    hdr.bsize = bsize;
+    hdr.nblocks = nblocks;
+    for (uint32_t b = 0; b < nblocks; ++ b) {
+        const uint32_t n = _ibis_idxpack_blockSize(hdr, b);
+        const char* src = raw.begin() + keep +
+            static_cast<uint64_t>(b) * bsize;
+        size_t nc = _ibis_idxpack_compress
+            (reinterpret_cast<const unsigned char*>(src), n,
+             reinterpret_cast<unsigned char*>(blk.begin()), n);
+        const char* bytes = blk.begin();
+        if (nc == 0) { // not compressible, store as is
+            nc = n;
+            bytes = src;
+        }
+        else {
+            ierr = _ibis_idxpack_decompress
+                (reinterpret_cast<const unsigned char*>(blk.begin()), nc,
+                 reinterpret_cast<unsigned char*>(check.begin()), n);
+            if (ierr != (int64_t)n || memcmp(src, check.begin(), n) != 0) {
+                LOGGER(ibis::gVerbose >= 0)
+                    << "Warning -- idxpack::pack failed to verify block "
+                    << b << " of " << idx << " (decompress returned "
+                    << ierr << ")";
+                ierr = -9;
+                break;
+            }
+        }
+        ierr = ibis::util::write(out, bytes, nc);
+        if (ierr != (int64_t)nc) {
+            ierr = -10;
+            break;
+        }
+        offsets[b+1] = offsets[b] + nc;
+    }
+    if (ierr >= 0) {
+        if (UnixSeek(out, tpos, SEEK_SET) == (off_t)tpos)
+            ierr = ibis::util::write(out, offsets.begin(),
+                                     sizeof(uint64_t) * offsets.size());
+        else
+            ierr = -11;
+        if (ierr >= 0 && ierr != (int64_t)(sizeof(uint64_t)*offsets.size()))
+            ierr = -11;
+    }
+#if defined(FASTBIT_SYNC_WRITE)
+#if _POSIX_FSYNC+0 > 0
+    (void) UnixFlush(out); // write to disk
+#elif defined(_WIN32) && defined(_MSC_VER)
+    (void) _commit(out);
+#endif
+#endif
+    UnixClose(out);
+    if (ierr < 0) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- idxpack::pack failed to write " << pk
+            << ", ierr = " << ierr;
+        remove(pk.c_str());
+        return ierr;
+    }
+
+    LOGGER(ibis::gVerbose > 3)
+        << "idxpack::pack -- wrote " << idx << " (" << size
+        << " bytes) to " << pk << " (" << offsets.back() << " bytes, "
+        << nblocks << " block" << (nblocks>1?"s":"") << ")";
+    return offsets.back();
+} // ibis::idxpack::pack
+
+/// Decompress the whole packed index file corresponding to @c idx into
+/// @c buf, which must have room for @c nbytes bytes.  Returns the number
+/// of bytes produced or a negative number to indicate error.
+int64_t ibis::idxpack::unpack(const char* idx, char* buf, uint64_t nbytes) {
+    if (idx == 0 || *idx == 0 || buf == 0)
+        return -1;
+    std::string pk;
+    packedName(idx, pk);
+    int fdes = UnixOpen(pk.c_str(), OPEN_READONLY);
+    if (fdes < 0) return -2;
+#if defined(_WIN32) && defined(_MSC_VER)
+    (void)_setmode(fdes, _O_BINARY);
+#endif
+    IBIS_BLOCK_GUARD(UnixClose, fdes);
+
+    ibis::idxpack::header hdr;
+    int ierr = _ibis_idxpack_readHeader(pk.c_str(), fdes, hdr);
+    if (ierr < 0) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- idxpack::unpack failed to read the header of "
+            << pk << ", ierr = " << ierr;
+        return -3;
+    }
+    if (hdr.size > nbytes)
+        return -4;
+    if (UnixSeek(fdes, 32, SEEK_SET) != 32 ||
+        ibis::util::read(fdes, buf, hdr.keep) != (int64_t)hdr.keep)
+        return -5;
+
+    for (uint32_t b = 0; b < hdr.nblocks; ++ b) {
+        long ierr = _ibis_idxpack_readBlock
+            (fdes, hdr, b,
+             buf + hdr.keep + static_cast<uint64_t>(b) * hdr.bsize);
+        if (ierr != (long)_ibis_idxpack_blockSize(hdr, b)) {
+            LOGGER(ibis::gVerbose > 1)
+                << "Warning -- idxpack::unpack failed to decompress block "
+                << b << " of " << pk << ", ierr = " << ierr;
+            return -6;
+        }
+    }
+    return hdr.size;
+} // ibis::idxpack::unpack
+
+/// Restore the index file from the packed index file and remove the
+/// packed index file.  Returns the size of the index file or a negative
+/// number to indicate error.
+int64_t ibis::idxpack::unpack(const char* idx) {
+    const int64_t nbytes = unpackedSize(idx);
+    if (nbytes < 0) return -1;
+
+    ibis::array_t<char> buf(nbytes);
+    int64_t ierr = unpack(idx, buf.begin(), nbytes);
+    if (ierr != nbytes) return -2;
+
+    int fdes = UnixOpen(idx, OPEN_WRITENEW, OPEN_FILEMODE);
+    if (fdes < 0) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- idxpack::unpack failed to open " << idx
+            << " for writing ... " << (errno ? strerror(errno) : "??");
+        return -3;
+    }
+#if defined(_WIN32) && defined(_MSC_VER)
+    (void)_setmode(fdes, _O_BINARY);
+#endif
+    ierr = ibis::util::write(fdes, buf.begin(), nbytes);
+    UnixClose(fdes);
+    if (ierr != nbytes) {
+        remove(idx);
+        return -4;
+    }
+
+    std::string pk;
+    packedName(idx, pk);
+    ibis::fileManager::instance().flushBlocks(pk.c_str());
+    remove(pk.c_str());
+    return nbytes;
+} // ibis::idxpack::unpack
+
+/// Read the part of the index file stored as it is, i.e., the header, the
+/// offsets and the other metadata of the index.  An index object can be
+/// reconstructed from it with the bitmaps read through the function
+/// readBitmaps.  The caller is responsible for freeing the storage object
+/// returned.  Returns nil if the packed index file is not valid.
+ibis::fileManager::storage* ibis::idxpack::readHead(const char* idx) {
+    if (idx == 0 || *idx == 0) return 0;
+    std::string pk;
+    packedName(idx, pk);
+    int fdes = UnixOpen(pk.c_str(), OPEN_READONLY);
+    if (fdes < 0) return 0;
+#if defined(_WIN32) && defined(_MSC_VER)
+    (void)_setmode(fdes, _O_BINARY);
+#endif
+    IBIS_BLOCK_GUARD(UnixClose, fdes);
+
+    ibis::idxpack::header hdr;
+    if (_ibis_idxpack_readHeader(pk.c_str(), fdes, hdr) < 0 || hdr.keep < 8)
+        return 0;
+    ibis::fileManager::storage* st = new ibis::fileManager::storage(hdr.keep);
+    if (UnixSeek(fdes, 32, SEEK_SET) != 32 ||
+        ibis::util::read(fdes, st->begin(), hdr.keep) != (int64_t)hdr.keep) {
+        delete st;
+        return 0;
+    }
+    ibis::fileManager::instance().recordPages(0, 32+hdr.keep);
+    return st;
+} // ibis::idxpack::readHead
+
+/// Return the context to be passed to readBitmaps for the index file
+/// @c idx.  The header of the packed index file is read here and kept in
+/// the context.  The context starts with one reference, which is dropped
+/// by calling share with a negative count.  Returns nil if the packed
+/// index file is not valid.
+void* ibis::idxpack::context(const char* idx) {
+    if (idx == 0 || *idx == 0) return 0;
+    std::string pk;
+    packedName(idx, pk);
+    int fdes = UnixOpen(pk.c_str(), OPEN_READONLY);
+    if (fdes < 0) return 0;
+#if defined(_WIN32) && defined(_MSC_VER)
+    (void)_setmode(fdes, _O_BINARY);
+#endif
+    IBIS_BLOCK_GUARD(UnixClose, fdes);
+
+    ibis::idxpack::reader* rd = new ibis::idxpack::reader;
+    if (_ibis_idxpack_readHeader(pk.c_str(), fdes, rd->hdr) < 0) {
+        delete rd;
+        return 0;
+    }
+    rd->pk.swap(pk);
+    rd->nref = 1;
+    return rd;
+} // ibis::idxpack::context
+
+/// Add @c n references to the context @c ctx, or remove them if @c n is
+/// negative.  The context is freed when no reference remains.  The
+/// signature matches the one expected by ibis::index::bitmapReader.
+void ibis::idxpack::share(void* ctx, int n) {
+    if (ctx == 0 || n == 0) return;
+    ibis::idxpack::reader* rd = static_cast<ibis::idxpack::reader*>(ctx);
+    bool done = false;
+    {
+        ibis::util::mutexLock lck(&_ibis_idxpack_mutex, "idxpack::share");
+        if (n > 0) {
+            rd->nref += n;
+        }
+        else {
+            rd->nref = (rd->nref > static_cast<uint32_t>(-n) ?
+                        rd->nref + n : 0);
+            done = (rd->nref == 0);
+        }
+    }
+    if (done)
+        delete rd;
+} // ibis::idxpack::share
+
+/// Read @c count 4-byte words starting at word @c start of the serialized
+/// bitmaps of the packed index file described by @c ctx, which must be
+/// obtained from the function context.  The words are counted from the
+/// first bitmap, i.e., from the end of the part stored as it is.  Only
+/// the blocks containing the requested words and not already in the pool
+/// of decompressed blocks are read and decompressed.  The signature of
+/// this function matches FastBitReadBitmaps, so that an index object can
+/// read its bitmaps through it.  Returns the number of words read or a
+/// negative number to indicate error.
+int ibis::idxpack::readBitmaps(void* ctx, uint64_t start, uint64_t count,
+                               uint32_t* buf) {
+    if (ctx == 0 || buf == 0) return -1;
+    if (count == 0) return 0;
+    const ibis::idxpack::reader& rd =
+        *static_cast<const ibis::idxpack::reader*>(ctx);
+    const ibis::idxpack::header& hdr = rd.hdr;
+    const char* pk = rd.pk.c_str();
+
+    uint64_t pos = hdr.keep + start * 4;
+    const uint64_t end = pos + count * 4;
+    if (end > hdr.size) return -4;
+    char* out = reinterpret_cast<char*>(buf);
+
+    int fdes = -1;
+    uint32_t nread = 0, nused = 0;
+    long ierr = 0;
+    ibis::array_t<char> blk;
+    while (pos < end) {
+        const uint32_t b = (pos - hdr.keep) / hdr.bsize;
+        const uint64_t boff = pos - hdr.keep -
+            static_cast<uint64_t>(b) * hdr.bsize;
+        ierr = _ibis_idxpack_getBlock(pk, fdes, hdr, b, blk, nread);
+        if (ierr < 0 || boff >= blk.size()) {
+            LOGGER(ibis::gVerbose > 1)
+                << "Warning -- idxpack::readBitmaps failed to decompress "
+                "block " << b << " of " << pk << ", ierr = " << ierr;
+            ierr = -6;
+            break;
+        }
+        const uint64_t nb = (end - pos < blk.size() - boff ? end - pos :
+                             blk.size() - boff);
+        memcpy(out, blk.begin() + boff, nb);
+        out += nb;
+        pos += nb;
+        ++ nused;
+    }
+    if (fdes >= 0)
+        UnixClose(fdes);
+    if (ierr < 0)
+        return ierr;
+
+    LOGGER(ibis::gVerbose > 6)
+        << "idxpack::readBitmaps -- read " << count << " word"
+        << (count>1?"s":"") << " from " << nused << " block"
+        << (nused>1?"s":"") << " of " << pk << ", decompressed " << nread;
+    return count;
+} // ibis::idxpack::readBitmaps
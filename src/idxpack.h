@@ -0,0 +1,49 @@
+// File: $Id$
+// Author: John Wu <John.Wu at acm.org>
+//      Lawrence Berkeley National Laboratory
+// Copyright (c) 2007-2016 the Regents of the University of California
+#ifndef IBIS_IDXPACK_H
+#define IBIS_IDXPACK_H
+///@file
+/// Block compression of index files.
+///
+/// A packed index file replaces an index file whose bitmaps are stored at
+/// the end of the file, after the header, the offsets and the other
+/// metadata.  The part of the index file in front of the first bitmap is
+/// kept as it is, so that an index object can be reconstructed from it
+/// without decompressing anything.  The serialized bitmaps are divided
+/// into blocks of a fixed number of bytes and each block is compressed
+/// separately with a simple LZ77 codec that favors speed over compression
+/// ratio.  A block that does not become smaller is stored as it is.
+///
+/// The packed file has the name of the index file followed by ".pk".  It
+/// starts with a header recording the size of the index file, the size of
+/// the part kept as it is and the block size, followed by this part and
+/// the offsets of the compressed blocks.  When the bitmaps are needed,
+/// only the blocks containing them are decompressed.  The decompressed
+/// blocks are kept in a pool maintained by ibis::fileManager so that
+/// bitmaps used repeatedly do not need to be decompressed again.
+#include "fileManager.h"        // ibis::fileManager
+
+namespace ibis {
+    /// Functions to pack and unpack index files.  The functions operate on
+    /// the names of the index files; the names of the packed files are
+    /// derived from them.
+    namespace idxpack {
+        FASTBIT_CXX_DLLSPEC void packedName(const char* idx,
+                                            std::string& pk);
+        FASTBIT_CXX_DLLSPEC bool isPacked(const char* idx);
+        FASTBIT_CXX_DLLSPEC int64_t unpackedSize(const char* idx);
+        FASTBIT_CXX_DLLSPEC int64_t pack(const char* idx, uint64_t keep);
+        FASTBIT_CXX_DLLSPEC int64_t unpack(const char* idx);
+        FASTBIT_CXX_DLLSPEC int64_t unpack(const char* idx, char* buf,
+                                           uint64_t nbytes);
+        FASTBIT_CXX_DLLSPEC ibis::fileManager::storage*
+        readHead(const char* idx);
+        FASTBIT_CXX_DLLSPEC void* context(const char* idx);
+        FASTBIT_CXX_DLLSPEC void share(void* ctx, int n);
+        FASTBIT_CXX_DLLSPEC int readBitmaps(void* ctx, uint64_t start,
+                                            uint64_t count, uint32_t* buf);
+    } // namespace idxpack
+} // namespace ibis
+#endif // IBIS_IDXPACK_H
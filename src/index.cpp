@@ -15,16 +15,20 @@
 #include "ibin.h"
 #include "irelic.h"
 #include "ikeywords.h"
+#include "ingram.h"
 #include "part.h"
 #include "category.h"
 #include "resource.h"
 #include "bitvector64.h"
+#include "idxpack.h"     // ibis::idxpack
+#include "profile.h"    // ibis::profile
 
 #include <memory>       // std::unique_ptr
 #include <queue>        // priority queue
 #include <algorithm>    // std::sort
 #include <sstream>      // std::ostringstream
 #include <typeinfo>     // typeid
+#include <limits>       // std::numeric_limits
 
 namespace ibis {
 #if defined(TEST_SUMBINS_OPTIONS)
@@ -277,7 +281,12 @@ ibis::index* ibis::index::create(const ibis::column* c, const char* dfname,
                 }
             }
 
-            if (header) { // reconstruct index from st
+            if (header == 0 && ibis::idxpack::isPacked(file.c_str())) {
+                // the index file has been replaced by a packed index file
+                ind = readPacked(c, file.c_str());
+                isRead = (ind != 0);
+            }
+            else if (header) { // reconstruct index from st
                 isRead = true;
                 ibis::horometer tm4;
                 if (ibis::gVerbose > 2)
@@ -481,6 +490,46 @@ ibis::index* ibis::index::create(const ibis::column* c, const char* dfname,
     return ind;
 } // ibis::index::create
 
+/// Build a new index in memory according to the index specification @c
+/// spec.  No index file is read or written and the index specification of
+/// the column is left unchanged.  This is used to compare the indexes
+/// that could be built for a column.  The caller is responsible for freeing
+/// the index returned.  In case of error, it returns a nil pointer.
+///
+/// @note The index specification of the column is replaced while the
+/// index is built, therefore the write lock on the column is held the
+/// same way as in ibis::column::loadIndex.
+ibis::index* ibis::index::build(const ibis::column* c, const char* spec) {
+    if (c == 0) return 0;
+    std::string evt = "index::build(";
+    evt += c->fullname();
+    evt += ')';
+    ibis::column::writeLock lock(c, evt.c_str());
+    // the column falls back to the specification of the data partition
+    // when it does not have its own
+    const bool own = (c->indexSpec() != 0 &&
+                      (c->partition() == 0 ||
+                       c->indexSpec() != c->partition()->indexSpec()));
+    const std::string old = (own ? c->indexSpec() : "");
+    ibis::index* ind = 0;
+    try {
+        ind = buildNew(c, static_cast<const char*>(0), spec);
+        if (ind != 0 && ind->getNRows() == 0) {
+            delete ind;
+            ind = 0;
+        }
+    }
+    catch (...) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- index::build(" << c->fullname() << ", "
+            << (spec ? spec : "") << ") received an exception";
+        delete ind;
+        ind = 0;
+    }
+    const_cast<ibis::column*>(c)->indexSpec(old.c_str());
+    return ind;
+} // ibis::index::build
+
 /// Read an index of the specified type from the incoming data file.  The
 /// index type t has been determined by the caller.  Furthermore, the
 /// caller might have read the index file into storage object st.
@@ -810,6 +859,91 @@ ibis::index* ibis::index::readOld(const ibis::column *c,
     return ind;
 } // ibis::index::readOld
 
+/// Read an index from the packed index file corresponding to @c f.  Only
+/// the part of the packed file in front of the bitmaps is read here; the
+/// bitmaps are decompressed block by block as they are activated.  Only
+/// indexes with a single list of bitmaps following the metadata, i.e.,
+/// the equality encoded indexes of type RELIC, DIREKTE and KEYWORDS, are
+/// packed.
+/// Returns a nil pointer in case of error.
+ibis::index* ibis::index::readPacked(const ibis::column *c, const char *f) {
+    ibis::fileManager::storage *st = ibis::idxpack::readHead(f);
+    if (st == 0) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- index::readPacked failed to read the header of "
+            "the packed index file for " << f;
+        return 0;
+    }
+    // hold on to st until the index object has been constructed
+    ibis::array_t<char> hold(st, 0, st->size());
+    const char *header = st->begin();
+    const bool check = (header[0] == '#' && header[1] == 'I' &&
+                        header[2] == 'B' && header[3] == 'I' &&
+                        header[4] == 'S' &&
+                        (header[6] == 8 || header[6] == 4) &&
+                        header[7] == static_cast<char>(0));
+    const INDEX_TYPE t = static_cast<INDEX_TYPE>(header[5]);
+    if (! check || (t != ibis::index::RELIC && t != ibis::index::DIREKTE &&
+                    t != ibis::index::KEYWORDS)) {
+        if (ibis::gVerbose > 0) {
+            ibis::util::logger lg;
+            lg() << "Warning -- packed index file for " << f
+                 << " contains an unexpected header (";
+            printHeader(lg(), header);
+            lg() << ')';
+        }
+        return 0;
+    }
+
+    ibis::index *ind = readOld(c, f, st, t);
+    if (ind == 0)
+        return ind;
+    if (ind->offset64.size() <= 1 && ind->offset32.size() <= 1) {
+        delete ind;
+        return 0;
+    }
+
+    // the bitmaps are counted from the first one, as the function
+    // activate expects of a bitmapReader
+    int64_t start, end;
+    ind->bitmapRange(start, end);
+    if (start != (int64_t)st->size()) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- index::readPacked expects the first bitmap of "
+            << f << " to start at " << st->size() << ", not " << start;
+        delete ind;
+        return 0;
+    }
+    if (ind->offset64.size() > 1) {
+        ibis::array_t<int64_t> offs(ind->offset64.size());
+        for (size_t j = 0; j < offs.size(); ++ j)
+            offs[j] = ind->offset64[j] - start;
+        ind->offset64.swap(offs);
+    }
+    else {
+        ibis::array_t<int32_t> offs(ind->offset32.size());
+        for (size_t j = 0; j < offs.size(); ++ j)
+            offs[j] = ind->offset32[j] - start;
+        ind->offset32.swap(offs);
+    }
+    void *ctx = ibis::idxpack::context(f);
+    if (ctx == 0) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- index::readPacked failed to prepare for reading "
+            "the bitmaps of the packed index file for " << f;
+        delete ind;
+        return 0;
+    }
+    ind->str = 0;
+    ind->initBitmaps(ctx, ibis::idxpack::readBitmaps, ibis::idxpack::share);
+    LOGGER(ibis::gVerbose > 3)
+        << "index::readPacked -- reconstructed an index of type #" << (int)t
+        << " with " << ind->bits.size() << " bitmap"
+        << (ind->bits.size()>1?"s":"") << " from the packed index file for "
+        << f;
+    return ind;
+} // ibis::index::readPacked
+
 /// Build a new index from attribute values.
 ibis::index* ibis::index::buildNew
 (const ibis::column *c, const char* dfname, const char* spec) {
@@ -822,6 +956,16 @@ ibis::index* ibis::index::buildNew
     else if (c->type() == ibis::TEXT) {
         if (spec != 0 && *spec != 0)
             const_cast<column*>(c)->indexSpec(spec);
+        if (ibis::ngram::requested(c->indexSpec())) {
+            try { // the trigram index is a companion of the keywords
+                ibis::ngram ngm(c, dfname);
+            }
+            catch (...) {
+                LOGGER(ibis::gVerbose > 1)
+                    << "Warning -- index::create failed to build the "
+                    "trigram index for " << c->fullname();
+            }
+        }
         return new ibis::keywords(c, dfname);
     }
     if (spec == 0 || *spec == 0) {
@@ -1751,16 +1895,36 @@ void ibis::index::computeMinMax(const char* f, double& min,
 /// IMPROTANT ASSUMPTION.
 /// A value of any supported type is supposed to be able to fit in a
 /// double with no rounding, no approximation and no overflow.
+///
+/// The bitmaps are produced by groupValues and inserted into @c bmap in
+/// ascending order of the values.
 void ibis::index::mapValues(const char* f, VMap& bmap) const {
+    bmap.clear();
+    array_t<double> keys;
+    array_t<ibis::bitvector*> bms;
+    mapValues(f, keys, bms);
+    for (uint32_t i = 0; i < keys.size(); ++ i)
+        bmap.insert(bmap.end(), VMap::value_type(keys[i], bms[i]));
+} // ibis::index::mapValues
+
+/// Map the locations of the values of one column.  The distinct values
+/// are placed in @c keys in ascending order, and the positions of
+/// keys[i] are marked in the bitmap bms[i].  The caller is responsible for
+/// freeing the bitmaps.  The values are read from the data file named by
+/// @c f (see dataFileName) or from the column in memory, and grouped by
+/// groupValues.
+void ibis::index::mapValues(const char* f, array_t<double>& keys,
+                            array_t<ibis::bitvector*>& bms) const {
+    keys.clear();
+    bms.clear();
     if (col == 0) return;
 
     horometer timer;
     if (ibis::gVerbose > 4)
         timer.start();
-    uint32_t i, j, k, nev;
+    uint32_t nev = 0;
     std::string fnm; // name of the data file
 
-    bmap.clear();
     dataFileName(fnm, f);
     std::string evt = "index";
     if (ibis::gVerbose > 0) {
@@ -1780,8 +1944,8 @@ void ibis::index::mapValues(const char* f, VMap& bmap) const {
         << ", will attempt to use in-memory data";
 
     if (! fnm.empty()) {
-        k = ibis::util::getFileSize(fnm.c_str());
-        if (k > 0) {
+        const off_t fsize = ibis::util::getFileSize(fnm.c_str());
+        if (fsize > 0) {
             LOGGER(ibis::gVerbose > 1)
                 << evt << " attempt to map the positions of every value in \""
                 << fnm << '"';
@@ -1793,7 +1957,8 @@ void ibis::index::mapValues(const char* f, VMap& bmap) const {
                         ibis::part::PRETRANSITION_STATE) {
                         ibis::bitvector *tmp = new ibis::bitvector;
                         tmp->set(1, col->partition()->nRows());
-                        bmap[1] = tmp;
+                        keys.push_back(1.0);
+                        bms.push_back(tmp);
                     }
                 }
                 else {
@@ -1808,7 +1973,7 @@ void ibis::index::mapValues(const char* f, VMap& bmap) const {
     }
 
     int ierr = 0;
-    VMap::iterator it;
+    const unsigned nthr = buildThreads(col);
     ibis::bitvector mask;
     col->getNullMask(mask);
 #if defined(MAPVALUES_EXCLUDE_INACTIVE)
@@ -1835,61 +2000,8 @@ void ibis::index::mapValues(const char* f, VMap& bmap) const {
 
         if (nev > mask.size())
             mask.adjustSize(nev, nev);
-        ibis::bitvector::indexSet iset = mask.firstIndexSet();
-        uint32_t nind = iset.nIndices();
-        const ibis::bitvector::word_t *iix = iset.indices();
-        while (nind) { // build the list of bitmaps
-            if (iset.isRange()) { // a range
-                k = (iix[1] < nev ? iix[1] : nev);
-                for (i = *iix; i < k; ++i) {
-                    it = bmap.find(val[i]);
-                    if (it != bmap.end()) {
-                        (*it).second->setBit(i, 1);
-                    }
-                    else {
-                        ibis::bitvector* tmp = new ibis::bitvector();
-                        tmp->setBit(i, 1);
-                        bmap[val[i]] = tmp;
-                    }
-                }
-            }
-            else if (*iix+ibis::bitvector::bitsPerLiteral() < nev) {
-                // a list of indices that are definitely within nev
-                for (i = 0; i < nind; ++i) {
-                    k = iix[i];
-                    it = bmap.find(val[k]);
-                    if (it != bmap.end()) {
-                        (*it).second->setBit(k, 1);
-                    }
-                    else {
-                        ibis::bitvector* tmp = new ibis::bitvector();
-                        tmp->setBit(k, 1);
-                        bmap[val[k]] = tmp;
-                    }
-                }
-            }
-            else { // a list of indices that may be larger than nev
-                for (i = 0; i < nind; ++i) {
-                    k = iix[i];
-                    if (k < nev) {
-                        it = bmap.find(val[k]);
-                        if (it != bmap.end()) {
-                            (*it).second->setBit(k, 1);
-                        }
-                        else {
-                            ibis::bitvector* tmp = new ibis::bitvector();
-                            tmp->setBit(k, 1);
-                            bmap[val[k]] = tmp;
-                        }
-                    }
-                }
-            }
-            ++iset;
-            nind = iset.nIndices();
-            if (*iix >= nev) nind = 0;
-        } // while (nind)
+        groupValues(val, mask, keys, bms, nthr);
         break;}
-
     case ibis::INT: {// signed int
         array_t<int32_t> val;
         if (! fnm.empty())
@@ -1902,61 +2014,8 @@ void ibis::index::mapValues(const char* f, VMap& bmap) const {
 
         if (nev > mask.size())
             mask.adjustSize(nev, nev);
-        ibis::bitvector::indexSet iset = mask.firstIndexSet();
-        unsigned nind = iset.nIndices();
-        const ibis::bitvector::word_t *iix = iset.indices();
-        while (nind) { // build the list of bitmaps
-            if (iset.isRange()) { // a range
-                k = (iix[1] < nev ? iix[1] : nev);
-                for (i = *iix; i < k; ++i) {
-                    it = bmap.find(val[i]);
-                    if (it != bmap.end()) {
-                        (*it).second->setBit(i, 1);
-                    }
-                    else {
-                        ibis::bitvector* tmp = new ibis::bitvector();
-                        tmp->setBit(i, 1);
-                        bmap[val[i]] = tmp;
-                    }
-                }
-            }
-            else if (*iix+ibis::bitvector::bitsPerLiteral() < nev) {
-                // a list of indices
-                for (i = 0; i < nind; ++i) {
-                    k = iix[i];
-                    it = bmap.find(val[k]);
-                    if (it != bmap.end()) {
-                        (*it).second->setBit(k, 1);
-                    }
-                    else {
-                        ibis::bitvector* tmp = new ibis::bitvector();
-                        tmp->setBit(k, 1);
-                        bmap[val[k]] = tmp;
-                    }
-                }
-            }
-            else {
-                for (i = 0; i < nind; ++i) {
-                    k = iix[i];
-                    if (k < nev) {
-                        it = bmap.find(val[k]);
-                        if (it != bmap.end()) {
-                            (*it).second->setBit(k, 1);
-                        }
-                        else {
-                            ibis::bitvector* tmp = new ibis::bitvector();
-                            tmp->setBit(k, 1);
-                            bmap[val[k]] = tmp;
-                        }
-                    }
-                }
-            }
-            ++iset;
-            nind = iset.nIndices();
-            if (*iix >= nev) nind = 0;
-        } // while (nind)
+        groupValues(val, mask, keys, bms, nthr);
         break;}
-
     case ibis::FLOAT: {// (4-byte) floating-point values
         array_t<float> val;
         if (! fnm.empty())
@@ -1969,61 +2028,8 @@ void ibis::index::mapValues(const char* f, VMap& bmap) const {
 
         if (nev > mask.size())
             mask.adjustSize(nev, nev);
-        ibis::bitvector::indexSet iset = mask.firstIndexSet();
-        unsigned nind = iset.nIndices();
-        const ibis::bitvector::word_t *iix = iset.indices();
-        while (nind) { // build the list of bitmaps
-            if (iset.isRange()) { // a range
-                k = (iix[1] < nev ? iix[1] : nev);
-                for (i = *iix; i < k; ++i) {
-                    it = bmap.find(val[i]);
-                    if (it != bmap.end()) {
-                        (*it).second->setBit(i, 1);
-                    }
-                    else {
-                        ibis::bitvector* tmp = new ibis::bitvector();
-                        tmp->setBit(i, 1);
-                        bmap[val[i]] = tmp;
-                    }
-                }
-            }
-            else if (*iix+ibis::bitvector::bitsPerLiteral() < nev) {
-                // a list of indices
-                for (i = 0; i < nind; ++i) {
-                    k = iix[i];
-                    it = bmap.find(val[k]);
-                    if (it != bmap.end()) {
-                        (*it).second->setBit(k, 1);
-                    }
-                    else {
-                        ibis::bitvector* tmp = new ibis::bitvector();
-                        tmp->setBit(k, 1);
-                        bmap[val[k]] = tmp;
-                    }
-                }
-            }
-            else {
-                for (i = 0; i < nind; ++i) {
-                    k = iix[i];
-                    if (k < nev) {
-                        it = bmap.find(val[k]);
-                        if (it != bmap.end()) {
-                            (*it).second->setBit(k, 1);
-                        }
-                        else {
-                            ibis::bitvector* tmp = new ibis::bitvector();
-                            tmp->setBit(k, 1);
-                            bmap[val[k]] = tmp;
-                        }
-                    }
-                }
-            }
-            ++iset;
-            nind = iset.nIndices();
-            if (*iix >= nev) nind = 0;
-        } // while (nind)
+        groupValues(val, mask, keys, bms, nthr);
         break;}
-
     case ibis::DOUBLE: {// (8-byte) floating-point values
         array_t<double> val;
         if (! fnm.empty())
@@ -2036,61 +2042,8 @@ void ibis::index::mapValues(const char* f, VMap& bmap) const {
 
         if (nev > mask.size())
             mask.adjustSize(nev, nev);
-        ibis::bitvector::indexSet iset = mask.firstIndexSet();
-        unsigned nind = iset.nIndices();
-        const ibis::bitvector::word_t *iix = iset.indices();
-        while (nind) { // build the list of bitmaps
-            if (iset.isRange()) { // a range
-                k = (iix[1] < nev ? iix[1] : nev);
-                for (i = *iix; i < k; ++i) {
-                    it = bmap.find(val[i]);
-                    if (it != bmap.end()) {
-                        (*it).second->setBit(i, 1);
-                    }
-                    else {
-                        ibis::bitvector* tmp = new ibis::bitvector();
-                        tmp->setBit(i, 1);
-                        bmap[val[i]] = tmp;
-                    }
-                }
-            }
-            else if (*iix+ibis::bitvector::bitsPerLiteral() < nev) {
-                // a list of indices
-                for (i = 0; i < nind; ++i) {
-                    k = iix[i];
-                    it = bmap.find(val[k]);
-                    if (it != bmap.end()) {
-                        (*it).second->setBit(k, 1);
-                    }
-                    else {
-                        ibis::bitvector* tmp = new ibis::bitvector();
-                        tmp->setBit(k, 1);
-                        bmap[val[k]] = tmp;
-                    }
-                }
-            }
-            else {
-                for (i = 0; i < nind; ++i) {
-                    k = iix[i];
-                    if (k < nev) {
-                        it = bmap.find(val[k]);
-                        if (it != bmap.end()) {
-                            (*it).second->setBit(k, 1);
-                        }
-                        else {
-                            ibis::bitvector* tmp = new ibis::bitvector();
-                            tmp->setBit(k, 1);
-                            bmap[val[k]] = tmp;
-                        }
-                    }
-                }
-            }
-            ++iset;
-            nind = iset.nIndices();
-            if (*iix >= nev) nind = 0;
-        } // while (nind)
+        groupValues(val, mask, keys, bms, nthr);
         break;}
-
     case ibis::BYTE: {// (1-byte) integer values
         array_t<signed char> val;
         if (! fnm.empty())
@@ -2103,61 +2056,8 @@ void ibis::index::mapValues(const char* f, VMap& bmap) const {
 
         if (nev > mask.size())
             mask.adjustSize(nev, nev);
-        ibis::bitvector::indexSet iset = mask.firstIndexSet();
-        unsigned nind = iset.nIndices();
-        const ibis::bitvector::word_t *iix = iset.indices();
-        while (nind) { // build the list of bitmaps
-            if (iset.isRange()) { // a range
-                k = (iix[1] < nev ? iix[1] : nev);
-                for (i = *iix; i < k; ++i) {
-                    it = bmap.find(val[i]);
-                    if (it != bmap.end()) {
-                        (*it).second->setBit(i, 1);
-                    }
-                    else {
-                        ibis::bitvector* tmp = new ibis::bitvector();
-                        tmp->setBit(i, 1);
-                        bmap[val[i]] = tmp;
-                    }
-                }
-            }
-            else if (*iix+ibis::bitvector::bitsPerLiteral() < nev) {
-                // a list of indices
-                for (i = 0; i < nind; ++i) {
-                    k = iix[i];
-                    it = bmap.find(val[k]);
-                    if (it != bmap.end()) {
-                        (*it).second->setBit(k, 1);
-                    }
-                    else {
-                        ibis::bitvector* tmp = new ibis::bitvector();
-                        tmp->setBit(k, 1);
-                        bmap[val[k]] = tmp;
-                    }
-                }
-            }
-            else {
-                for (i = 0; i < nind; ++i) {
-                    k = iix[i];
-                    if (k < nev) {
-                        it = bmap.find(val[k]);
-                        if (it != bmap.end()) {
-                            (*it).second->setBit(k, 1);
-                        }
-                        else {
-                            ibis::bitvector* tmp = new ibis::bitvector();
-                            tmp->setBit(k, 1);
-                            bmap[val[k]] = tmp;
-                        }
-                    }
-                }
-            }
-            ++iset;
-            nind = iset.nIndices();
-            if (*iix >= nev) nind = 0;
-        } // while (nind)
+        groupValues(val, mask, keys, bms, nthr);
         break;}
-
     case ibis::UBYTE: {// (1-byte) integer values
         array_t<unsigned char> val;
         if (! fnm.empty())
@@ -2170,61 +2070,8 @@ void ibis::index::mapValues(const char* f, VMap& bmap) const {
 
         if (nev > mask.size())
             mask.adjustSize(nev, nev);
-        ibis::bitvector::indexSet iset = mask.firstIndexSet();
-        unsigned nind = iset.nIndices();
-        const ibis::bitvector::word_t *iix = iset.indices();
-        while (nind) { // build the list of bitmaps
-            if (iset.isRange()) { // a range
-                k = (iix[1] < nev ? iix[1] : nev);
-                for (i = *iix; i < k; ++i) {
-                    it = bmap.find(val[i]);
-                    if (it != bmap.end()) {
-                        (*it).second->setBit(i, 1);
-                    }
-                    else {
-                        ibis::bitvector* tmp = new ibis::bitvector();
-                        tmp->setBit(i, 1);
-                        bmap[val[i]] = tmp;
-                    }
-                }
-            }
-            else if (*iix+ibis::bitvector::bitsPerLiteral() < nev) {
-                // a list of indices
-                for (i = 0; i < nind; ++i) {
-                    k = iix[i];
-                    it = bmap.find(val[k]);
-                    if (it != bmap.end()) {
-                        (*it).second->setBit(k, 1);
-                    }
-                    else {
-                        ibis::bitvector* tmp = new ibis::bitvector();
-                        tmp->setBit(k, 1);
-                        bmap[val[k]] = tmp;
-                    }
-                }
-            }
-            else {
-                for (i = 0; i < nind; ++i) {
-                    k = iix[i];
-                    if (k < nev) {
-                        it = bmap.find(val[k]);
-                        if (it != bmap.end()) {
-                            (*it).second->setBit(k, 1);
-                        }
-                        else {
-                            ibis::bitvector* tmp = new ibis::bitvector();
-                            tmp->setBit(k, 1);
-                            bmap[val[k]] = tmp;
-                        }
-                    }
-                }
-            }
-            ++iset;
-            nind = iset.nIndices();
-            if (*iix >= nev) nind = 0;
-        } // while (nind)
+        groupValues(val, mask, keys, bms, nthr);
         break;}
-
     case ibis::SHORT: {// (2-byte) integer values
         array_t<int16_t> val;
         if (! fnm.empty())
@@ -2237,61 +2084,8 @@ void ibis::index::mapValues(const char* f, VMap& bmap) const {
 
         if (nev > mask.size())
             mask.adjustSize(nev, nev);
-        ibis::bitvector::indexSet iset = mask.firstIndexSet();
-        unsigned nind = iset.nIndices();
-        const ibis::bitvector::word_t *iix = iset.indices();
-        while (nind) { // build the list of bitmaps
-            if (iset.isRange()) { // a range
-                k = (iix[1] < nev ? iix[1] : nev);
-                for (i = *iix; i < k; ++i) {
-                    it = bmap.find(val[i]);
-                    if (it != bmap.end()) {
-                        (*it).second->setBit(i, 1);
-                    }
-                    else {
-                        ibis::bitvector* tmp = new ibis::bitvector();
-                        tmp->setBit(i, 1);
-                        bmap[val[i]] = tmp;
-                    }
-                }
-            }
-            else if (*iix+ibis::bitvector::bitsPerLiteral() < nev) {
-                // a list of indices
-                for (i = 0; i < nind; ++i) {
-                    k = iix[i];
-                    it = bmap.find(val[k]);
-                    if (it != bmap.end()) {
-                        (*it).second->setBit(k, 1);
-                    }
-                    else {
-                        ibis::bitvector* tmp = new ibis::bitvector();
-                        tmp->setBit(k, 1);
-                        bmap[val[k]] = tmp;
-                    }
-                }
-            }
-            else {
-                for (i = 0; i < nind; ++i) {
-                    k = iix[i];
-                    if (k < nev) {
-                        it = bmap.find(val[k]);
-                        if (it != bmap.end()) {
-                            (*it).second->setBit(k, 1);
-                        }
-                        else {
-                            ibis::bitvector* tmp = new ibis::bitvector();
-                            tmp->setBit(k, 1);
-                            bmap[val[k]] = tmp;
-                        }
-                    }
-                }
-            }
-            ++iset;
-            nind = iset.nIndices();
-            if (*iix >= nev) nind = 0;
-        } // while (nind)
+        groupValues(val, mask, keys, bms, nthr);
         break;}
-
     case ibis::USHORT: {// (2-byte) integer values
         array_t<uint16_t> val;
         if (! fnm.empty())
@@ -2304,61 +2098,8 @@ void ibis::index::mapValues(const char* f, VMap& bmap) const {
 
         if (nev > mask.size())
             mask.adjustSize(nev, nev);
-        ibis::bitvector::indexSet iset = mask.firstIndexSet();
-        unsigned nind = iset.nIndices();
-        const ibis::bitvector::word_t *iix = iset.indices();
-        while (nind) { // build the list of bitmaps
-            if (iset.isRange()) { // a range
-                k = (iix[1] < nev ? iix[1] : nev);
-                for (i = *iix; i < k; ++i) {
-                    it = bmap.find(val[i]);
-                    if (it != bmap.end()) {
-                        (*it).second->setBit(i, 1);
-                    }
-                    else {
-                        ibis::bitvector* tmp = new ibis::bitvector();
-                        tmp->setBit(i, 1);
-                        bmap[val[i]] = tmp;
-                    }
-                }
-            }
-            else if (*iix+ibis::bitvector::bitsPerLiteral() < nev) {
-                // a list of indices
-                for (i = 0; i < nind; ++i) {
-                    k = iix[i];
-                    it = bmap.find(val[k]);
-                    if (it != bmap.end()) {
-                        (*it).second->setBit(k, 1);
-                    }
-                    else {
-                        ibis::bitvector* tmp = new ibis::bitvector();
-                        tmp->setBit(k, 1);
-                        bmap[val[k]] = tmp;
-                    }
-                }
-            }
-            else {
-                for (i = 0; i < nind; ++i) {
-                    k = iix[i];
-                    if (k < nev) {
-                        it = bmap.find(val[k]);
-                        if (it != bmap.end()) {
-                            (*it).second->setBit(k, 1);
-                        }
-                        else {
-                            ibis::bitvector* tmp = new ibis::bitvector();
-                            tmp->setBit(k, 1);
-                            bmap[val[k]] = tmp;
-                        }
-                    }
-                }
-            }
-            ++iset;
-            nind = iset.nIndices();
-            if (*iix >= nev) nind = 0;
-        } // while (nind)
+        groupValues(val, mask, keys, bms, nthr);
         break;}
-
     case ibis::ULONG: {// if data file exists, must be unsigned int64_t
         array_t<uint64_t> val;
         if (! fnm.empty())
@@ -2371,61 +2112,8 @@ void ibis::index::mapValues(const char* f, VMap& bmap) const {
 
         if (nev > mask.size())
             mask.adjustSize(nev, nev);
-        ibis::bitvector::indexSet iset = mask.firstIndexSet();
-        uint32_t nind = iset.nIndices();
-        const ibis::bitvector::word_t *iix = iset.indices();
-        while (nind) { // build the list of bitmaps
-            if (iset.isRange()) { // a range
-                k = (iix[1] < nev ? iix[1] : nev);
-                for (i = *iix; i < k; ++i) {
-                    it = bmap.find(val[i]);
-                    if (it != bmap.end()) {
-                        (*it).second->setBit(i, 1);
-                    }
-                    else {
-                        ibis::bitvector* tmp = new ibis::bitvector();
-                        tmp->setBit(i, 1);
-                        bmap[val[i]] = tmp;
-                    }
-                }
-            }
-            else if (*iix+ibis::bitvector::bitsPerLiteral() < nev) {
-                // a list of indices that are definitely within nev
-                for (i = 0; i < nind; ++i) {
-                    k = iix[i];
-                    it = bmap.find(val[k]);
-                    if (it != bmap.end()) {
-                        (*it).second->setBit(k, 1);
-                    }
-                    else {
-                        ibis::bitvector* tmp = new ibis::bitvector();
-                        tmp->setBit(k, 1);
-                        bmap[val[k]] = tmp;
-                    }
-                }
-            }
-            else { // a list of indices that may be larger than nev
-                for (i = 0; i < nind; ++i) {
-                    k = iix[i];
-                    if (k < nev) {
-                        it = bmap.find(val[k]);
-                        if (it != bmap.end()) {
-                            (*it).second->setBit(k, 1);
-                        }
-                        else {
-                            ibis::bitvector* tmp = new ibis::bitvector();
-                            tmp->setBit(k, 1);
-                            bmap[val[k]] = tmp;
-                        }
-                    }
-                }
-            }
-            ++iset;
-            nind = iset.nIndices();
-            if (*iix >= nev) nind = 0;
-        } // while (nind)
+        groupValues(val, mask, keys, bms, nthr);
         break;}
-
     case ibis::LONG: {// signed int64_t
         array_t<int64_t> val;
         if (! fnm.empty())
@@ -2438,61 +2126,8 @@ void ibis::index::mapValues(const char* f, VMap& bmap) const {
 
         if (nev > mask.size())
             mask.adjustSize(nev, nev);
-        ibis::bitvector::indexSet iset = mask.firstIndexSet();
-        unsigned nind = iset.nIndices();
-        const ibis::bitvector::word_t *iix = iset.indices();
-        while (nind) { // build the list of bitmaps
-            if (iset.isRange()) { // a range
-                k = (iix[1] < nev ? iix[1] : nev);
-                for (i = *iix; i < k; ++i) {
-                    it = bmap.find(val[i]);
-                    if (it != bmap.end()) {
-                        (*it).second->setBit(i, 1);
-                    }
-                    else {
-                        ibis::bitvector* tmp = new ibis::bitvector();
-                        tmp->setBit(i, 1);
-                        bmap[val[i]] = tmp;
-                    }
-                }
-            }
-            else if (*iix+ibis::bitvector::bitsPerLiteral() < nev) {
-                // a list of indices
-                for (i = 0; i < nind; ++i) {
-                    k = iix[i];
-                    it = bmap.find(val[k]);
-                    if (it != bmap.end()) {
-                        (*it).second->setBit(k, 1);
-                    }
-                    else {
-                        ibis::bitvector* tmp = new ibis::bitvector();
-                        tmp->setBit(k, 1);
-                        bmap[val[k]] = tmp;
-                    }
-                }
-            }
-            else {
-                for (i = 0; i < nind; ++i) {
-                    k = iix[i];
-                    if (k < nev) {
-                        it = bmap.find(val[k]);
-                        if (it != bmap.end()) {
-                            (*it).second->setBit(k, 1);
-                        }
-                        else {
-                            ibis::bitvector* tmp = new ibis::bitvector();
-                            tmp->setBit(k, 1);
-                            bmap[val[k]] = tmp;
-                        }
-                    }
-                }
-            }
-            ++iset;
-            nind = iset.nIndices();
-            if (*iix >= nev) nind = 0;
-        } // while (nind)
+        groupValues(val, mask, keys, bms, nthr);
         break;}
-
     default:
         LOGGER(ibis::gVerbose > 0)
             << "Warning -- " << evt << " can not process column type "
@@ -2512,42 +2147,425 @@ void ibis::index::mapValues(const char* f, VMap& bmap) const {
         return;
     }
 
-    // make sure all bit vectors are the same size
     if (mask.size() > nev)
         nev = mask.size();
-    j = nev - 1;
-    for (it = bmap.begin(); it != bmap.end(); ++it) {
-        if ((*it).second->size() < nev) {
-            (*it).second->setBit(j, 0);
-        }
-        else if ((*it).second->size() > nev) {
-            LOGGER(ibis::gVerbose > 0)
-                << "Warning -- " << evt << ": bitvector for value "
-                << (*it).first << "contains " << (*it).second->size()
-                << " bits while " << nev << " are expected -- "
-                "removing the extra bits";
-            (*it).second->adjustSize(nev, nev);
-        }
-    }
     if (ibis::gVerbose > 4) {
         timer.stop();
         ibis::util::logger lg;
-        lg() << evt << " mapped " << nev << " values to " << bmap.size()
+        lg() << evt << " mapped " << nev << " values to " << keys.size()
              << " bitvectors of " << nev << "-bit each in " << timer.realTime()
              << " sec(elapsed)";
-        if (ibis::gVerbose > 30 || ((1U<<ibis::gVerbose)>bmap.size())) {
+        if (ibis::gVerbose > 30 || ((1U<<ibis::gVerbose)>keys.size())) {
             lg() << "value, count (extracted from the bitvector)\n";
-            for (it = bmap.begin(); it != bmap.end(); ++it)
-                lg() << (*it).first << ",\t" << (*it).second->cnt() << "\n";
+            for (uint32_t i = 0; i < keys.size(); ++ i)
+                lg() << keys[i] << ",\t" << bms[i]->cnt() << "\n";
         }
     }
     else {
-        LOGGER(ibis::gVerbose > 2) 
-            << evt << " mapped " << nev << " values to " << bmap.size()
+        LOGGER(ibis::gVerbose > 2)
+            << evt << " mapped " << nev << " values to " << keys.size()
             << " bitvectors of " << nev << "-bit each";
     }
 } // ibis::index::mapValues
 
+// the number of threads for building an index in the current thread, see
+// ibis::index::buildThreads
+static thread_local unsigned _ibis_index_build_threads = 0;
+
+/// Arguments to the thread function ibis_index_run_segments.
+struct ibis_index_segment_pool {
+    ibis::util::counter cnt;
+    ibis::index::segmentTask &task;
+    const uint32_t nseg;
+    int ierr;
+
+    ibis_index_segment_pool(ibis::index::segmentTask &t, uint32_t n)
+        : cnt(), task(t), nseg(n), ierr(0) {}
+};
+
+extern "C" {
+    /// The thread function to process segments of rows.
+    static void* ibis_index_run_segments(void* arg) {
+        if (arg == 0) return reinterpret_cast<void*>(-1L);
+        ibis_index_segment_pool &pool =
+            *(reinterpret_cast<ibis_index_segment_pool*>(arg));
+        for (uint32_t i = pool.cnt(); i < pool.nseg; i = pool.cnt()) {
+            try {
+                pool.task.run(i);
+            }
+            catch (const std::exception &e) {
+                LOGGER(ibis::gVerbose > 0)
+                    << "Warning -- index::runSegments received "
+                    "std::exception \"" << e.what() << "\" from segment "
+                    << i;
+                pool.ierr = -2;
+            }
+            catch (const char* s) {
+                LOGGER(ibis::gVerbose > 0)
+                    << "Warning -- index::runSegments received exception \""
+                    << s << "\" from segment " << i;
+                pool.ierr = -3;
+            }
+            catch (...) {
+                LOGGER(ibis::gVerbose > 0)
+                    << "Warning -- index::runSegments received an "
+                    "unexpected exception from segment " << i;
+                pool.ierr = -4;
+            }
+        }
+        return 0;
+    } // ibis_index_run_segments
+} // extern "C"
+
+/// The number of threads to be used for building an index on column @c
+/// c.  It is taken from the first of the following that is set:
+/// - the keyword "threads=nnn" in the index specification of the column,
+/// - the parameter "<partition-name>.<column-name>.index.threads",
+/// - the parameter "index.build.threads",
+/// - the value given to setBuildThreads in the calling thread, which is
+///   set by ibis::part::buildIndexes when it has more threads than
+///   columns.
+///
+/// The default is one, i.e., build the index sequentially.  The number is
+/// capped at 256.
+unsigned ibis::index::buildThreads(const ibis::column* c) {
+    long nthr = 0;
+    if (c != 0) {
+        const char *spec = c->indexSpec();
+        const char *ptr = (spec != 0 ? strstr(spec, "threads=") : 0);
+        if (ptr != 0) {
+            ptr += 8;
+            while (isspace(*ptr)) ++ ptr;
+            if (isdigit(*ptr))
+                nthr = strtol(ptr, 0, 0);
+        }
+        if (nthr <= 0) {
+            std::string key = c->fullname();
+            key += ".index.threads";
+            nthr = ibis::gParameters().getNumber(key.c_str());
+        }
+    }
+    if (nthr <= 0)
+        nthr = ibis::gParameters().getNumber("index.build.threads");
+    if (nthr <= 0)
+        nthr = _ibis_index_build_threads;
+    if (nthr <= 0)
+        nthr = 1;
+    else if (nthr > 256)
+        nthr = 256;
+    return (unsigned) nthr;
+} // ibis::index::buildThreads
+
+/// Set the number of threads for building an individual index when
+/// neither the index specification nor the parameters say otherwise.
+/// The value only applies to the indexes built by the calling thread;
+/// zero restores the default of one thread.  It returns the previous
+/// value of the calling thread.
+unsigned ibis::index::setBuildThreads(unsigned nthr) {
+    const unsigned old = _ibis_index_build_threads;
+    _ibis_index_build_threads = nthr;
+    return old;
+} // ibis::index::setBuildThreads
+
+/// The number of rows in each segment when @c nrows rows are to be
+/// processed by @c nthr threads.  The segment size is a multiple of the
+/// number of bits in a bitvector word so that the bitmaps of consecutive
+/// segments can be concatenated without shifting, and it is at least
+/// 64K words so that the overhead of merging stays small.  A return value
+/// no less than @c nrows indicates that the rows should be processed in
+/// one piece.
+uint32_t ibis::index::segmentSize(uint32_t nrows, unsigned nthr) {
+    const uint32_t wbits = ibis::bitvector::bitsPerLiteral();
+    const uint32_t minseg = 65536U * wbits;
+    if (nthr <= 1 || nrows <= minseg)
+        return nrows;
+
+    // two segments per thread to even out the work load
+    uint32_t seg = nrows / (nthr + nthr) + 1;
+    seg = ((seg + wbits - 1) / wbits) * wbits;
+    if (seg < minseg)
+        seg = minseg;
+    return seg;
+} // ibis::index::segmentSize
+
+/// Run @c task on segments 0 through @c nseg-1 using up to @c nthr
+/// threads, including the calling thread.  It returns 0 if all segments
+/// were processed successfully, a negative number otherwise.  The
+/// exceptions thrown by the task are logged and turned into the negative
+/// return value.
+int ibis::index::runSegments(ibis::index::segmentTask& task, uint32_t nseg,
+                             unsigned nthr) {
+    ibis_index_segment_pool pool(task, nseg);
+    if (nthr > nseg)
+        nthr = nseg;
+    if (nthr <= 1) {
+        (void) ibis_index_run_segments((void*)&pool);
+        return pool.ierr;
+    }
+
+    pthread_attr_t tattr;
+    int ierr = pthread_attr_init(&tattr);
+    if (ierr == 0) {
+#if defined(PTHREAD_SCOPE_SYSTEM)
+        ierr = pthread_attr_setscope(&tattr, PTHREAD_SCOPE_SYSTEM);
+        if (ierr != 0
+#if defined(ENOTSUP)
+            && ierr != ENOTSUP
+#endif
+            ) {
+            LOGGER(ibis::gVerbose > 1)
+                << "Warning -- index::runSegments pthread_attr_setscope "
+                "failed to set system scope (ierr = " << ierr << ')';
+        }
+#endif
+        ierr = 0;
+    }
+    const bool useattr = (ierr == 0);
+    std::vector<pthread_t> tid(nthr-1);
+    for (uint32_t j = 0; j+1 < nthr; ++ j) {
+        ierr = pthread_create(&(tid[j]), (useattr ? &tattr : 0),
+                              ibis_index_run_segments, (void*)&pool);
+        if (0 != ierr) {
+            tid[j] = pthread_self();
+            LOGGER(ibis::gVerbose > 0)
+                << "Warning -- index::runSegments could not start thread # "
+                << j << " to run ibis_index_run_segments ("
+                << strerror(ierr) << ')';
+        }
+    }
+    (void) ibis_index_run_segments((void*)&pool);
+    for (uint32_t j = 0; j+1 < nthr; ++ j) {
+        if (pthread_equal(tid[j], pthread_self()) == 0) {
+            void *st;
+            pthread_join(tid[j], &st);
+        }
+    }
+    if (useattr)
+        pthread_attr_destroy(&tattr);
+    return pool.ierr;
+} // ibis::index::runSegments
+
+/// Group the rows in [@c begin, @c end) marked 1 in @c mask by their
+/// values.  The bitmaps have (end - begin) bits each, the first bit
+/// corresponding to row @c begin.  This is the work of
+/// ibis::index::groupValues on one segment of rows.
+template <typename E> static void
+_ibis_index_group_segment(const ibis::array_t<E>& val,
+                          const ibis::bitvector& mask,
+                          uint32_t begin, uint32_t end,
+                          ibis::array_t<double>& keys,
+                          ibis::array_t<ibis::bitvector*>& bms) {
+    keys.clear();
+    bms.clear();
+    const uint32_t nev = (val.size() < end ? val.size() : end);
+    const uint32_t nb = end - begin;
+    // the rows to be indexed
+    ibis::array_t<uint32_t> rows;
+    for (ibis::bitvector::indexSet is = mask.firstIndexSet();
+         is.nIndices() > 0 && *(is.indices()) < nev; ++ is) {
+        const ibis::bitvector::word_t *iix = is.indices();
+        if (is.isRange()) {
+            if (iix[1] <= begin) continue;
+            const uint32_t last = (iix[1] < nev ? iix[1] : nev);
+            for (uint32_t j = (*iix > begin ? *iix : begin); j < last; ++ j)
+                if (val[j] == val[j]) // exclude NaN
+                    rows.push_back(j);
+        }
+        else if (iix[is.nIndices()-1] >= begin) {
+            for (uint32_t j = 0; j < is.nIndices(); ++ j)
+                if (iix[j] >= begin && iix[j] < nev &&
+                    val[iix[j]] == val[iix[j]])
+                    rows.push_back(iix[j]);
+        }
+    }
+    if (rows.empty()) return;
+
+    E vmin = val[rows[0]];
+    E vmax = vmin;
+    for (uint32_t j = 1; j < rows.size(); ++ j) {
+        if (vmin > val[rows[j]])
+            vmin = val[rows[j]];
+        else if (vmax < val[rows[j]])
+            vmax = val[rows[j]];
+    }
+
+    try {
+        const double range = (double)vmax - (double)vmin;
+        if (std::numeric_limits<E>::is_integer &&
+            (range < 65536.0 || range < rows.size()) &&
+            (double)vmin > -9e15 && (double)vmax < 9e15) {
+            // counting sort on the values
+            const uint32_t nv = (uint32_t)range + 1;
+            ibis::array_t<uint32_t> starts(nv+1, 0U);
+            for (uint32_t j = 0; j < rows.size(); ++ j)
+                ++ starts[(uint32_t)(val[rows[j]] - vmin) + 1];
+            for (uint32_t j = 0; j < nv; ++ j)
+                starts[j+1] += starts[j];
+
+            ibis::array_t<uint32_t> pos(rows.size());
+            {
+                ibis::array_t<uint32_t> next(nv);
+                std::copy(starts.begin(), starts.begin()+nv, next.begin());
+                for (uint32_t j = 0; j < rows.size(); ++ j)
+                    pos[next[(uint32_t)(val[rows[j]] - vmin)]++] =
+                        rows[j] - begin;
+            }
+            for (uint32_t j = 0; j < nv; ++ j) {
+                if (starts[j+1] > starts[j]) {
+                    ibis::bitvector *tmp = new ibis::bitvector;
+                    bms.push_back(tmp);
+                    tmp->set(pos.begin()+starts[j], starts[j+1]-starts[j], nb);
+                    keys.push_back((double)vmin + j);
+                }
+            }
+        }
+        else { // sort the (value, row) pairs
+            std::vector< std::pair<double, uint32_t> > pairs(rows.size());
+            for (uint32_t j = 0; j < rows.size(); ++ j) {
+                pairs[j].first = val[rows[j]];
+                pairs[j].second = rows[j];
+            }
+            std::sort(pairs.begin(), pairs.end());
+            for (uint32_t j = 0; j < rows.size(); ++ j)
+                rows[j] = pairs[j].second - begin;
+
+            for (uint32_t i = 0; i < pairs.size(); ) {
+                uint32_t j = i + 1;
+                while (j < pairs.size() && pairs[j].first == pairs[i].first)
+                    ++ j;
+                ibis::bitvector *tmp = new ibis::bitvector;
+                bms.push_back(tmp);
+                tmp->set(rows.begin()+i, j-i, nb);
+                keys.push_back(pairs[i].first);
+                i = j;
+            }
+        }
+    }
+    catch (...) {
+        for (uint32_t j = 0; j < bms.size(); ++ j)
+            delete bms[j];
+        bms.clear();
+        keys.clear();
+        throw;
+    }
+} // _ibis_index_group_segment
+
+/// Group one segment of rows for ibis::index::groupValues.
+template <typename E>
+struct ibis_index_group_task : public ibis::index::segmentTask {
+    const ibis::array_t<E> &val;
+    const ibis::bitvector &mask;
+    const uint32_t seglen;
+    const uint32_t nrows;
+    std::vector< ibis::array_t<double> > keys;
+    std::vector< ibis::array_t<ibis::bitvector*> > bms;
+
+    ibis_index_group_task(const ibis::array_t<E> &v,
+                          const ibis::bitvector &m,
+                          uint32_t sl, uint32_t nr, uint32_t ns)
+        : val(v), mask(m), seglen(sl), nrows(nr), keys(ns), bms(ns) {}
+    virtual ~ibis_index_group_task() {
+        for (size_t i = 0; i < bms.size(); ++ i)
+            for (size_t j = 0; j < bms[i].size(); ++ j)
+                delete bms[i][j];
+    }
+    virtual void run(uint32_t i) {
+        const uint32_t end = (nrows - i*seglen > seglen ?
+                              (i+1)*seglen : nrows);
+        _ibis_index_group_segment(val, mask, i*seglen, end, keys[i], bms[i]);
+    }
+}; // ibis_index_group_task
+
+/// Group the rows marked 1 in @c mask by their values.  The distinct
+/// values are placed in @c keys in ascending order, and the rows with
+/// value keys[i] are marked in bms[i].  The bitmaps have max(val.size(),
+/// mask.size()) bits each.  NaN values are not indexed.
+///
+/// For integers spanning a range no larger than the number of rows (or
+/// 64K), the row numbers are distributed with a counting sort, otherwise
+/// the (value, row) pairs are sorted.  In either case, the row numbers of
+/// each value come out in ascending order and each bitmap is generated
+/// directly in compressed form with bitvector::set, instead of being
+/// looked up in a std::map and updated with setBit one row at a time.
+///
+/// With @c nthr > 1, the rows are divided into segments of whole
+/// bitvector words (see segmentSize), the segments are grouped
+/// concurrently, and the bitmaps of the same value from consecutive
+/// segments are concatenated.  Because each segment other than the last
+/// one ends on a word boundary, the concatenation simply appends the
+/// compressed words.
+///
+/// The caller is responsible for freeing the bitmaps.  In case of
+/// exception, the bitmaps already generated are freed before the
+/// exception is passed on.
+template <typename E>
+void ibis::index::groupValues(const array_t<E>& val,
+                              const ibis::bitvector& mask,
+                              array_t<double>& keys,
+                              array_t<ibis::bitvector*>& bms,
+                              unsigned nthr) {
+    const uint32_t nb = (mask.size() > val.size() ? mask.size() : val.size());
+    const uint32_t seglen = segmentSize(nb, nthr);
+    const uint32_t nseg = (nb > seglen ? (nb + seglen - 1) / seglen : 1U);
+    if (nseg <= 1) {
+        _ibis_index_group_segment(val, mask, 0, nb, keys, bms);
+        return;
+    }
+
+    keys.clear();
+    bms.clear();
+    ibis_index_group_task<E> task(val, mask, seglen, nb, nseg);
+    if (runSegments(task, nseg, nthr) < 0)
+        throw "index::groupValues failed to process all segments"
+            IBIS_FILE_LINE;
+
+    // merge the keys of the segments and concatenate the bitmaps
+    std::vector<uint32_t> next(nseg, 0U);
+    try {
+        while (true) {
+            double key = DBL_MAX;
+            bool found = false;
+            for (uint32_t i = 0; i < nseg; ++ i) {
+                if (next[i] < task.keys[i].size() &&
+                    (! found || task.keys[i][next[i]] < key)) {
+                    key = task.keys[i][next[i]];
+                    found = true;
+                }
+            }
+            if (! found) break;
+
+            ibis::bitvector *tmp = new ibis::bitvector;
+            bms.push_back(tmp);
+            keys.push_back(key);
+            for (uint32_t i = 0; i < nseg; ++ i) {
+                if (next[i] < task.keys[i].size() &&
+                    task.keys[i][next[i]] == key) {
+                    *tmp += *(task.bms[i][next[i]]);
+                    delete task.bms[i][next[i]];
+                    task.bms[i][next[i]] = 0;
+                    ++ next[i];
+                }
+                else {
+                    tmp->appendFill(0, (i+1 < nseg ? seglen :
+                                        nb - i * seglen));
+                }
+            }
+        }
+    }
+    catch (...) {
+        for (uint32_t j = 0; j < bms.size(); ++ j)
+            delete bms[j];
+        bms.clear();
+        keys.clear();
+        throw;
+    }
+    LOGGER(ibis::gVerbose > 4)
+        << "index::groupValues used " << nthr << " thread"
+        << (nthr>1?"s":"") << " on " << nseg << " segments of " << seglen
+        << " rows to produce " << keys.size() << " bitmap"
+        << (keys.size()>1?"s":"");
+} // ibis::index::groupValues
+
 template <typename E>
 void ibis::index::mapValues(const array_t<E>& val, VMap& bmap) {
     bmap.clear();
@@ -2557,36 +2575,17 @@ void ibis::index::mapValues(const array_t<E>& val, VMap& bmap) {
         return;
     }
 
-    uint32_t nev = val.size();
-    VMap::iterator it;
+    const uint32_t nev = val.size();
     ibis::horometer timer;
     timer.start();
-    for (uint32_t i = 0; i < nev; ++i) {
-        it = bmap.find(val[i]);
-        if (it != bmap.end()) {
-            (*it).second->setBit(i, 1);
-        }
-        else {
-            ibis::bitvector* tmp = new ibis::bitvector();
-            tmp->setBit(i, 1);
-            bmap[val[i]] = tmp;
-        }
-    }
-    const uint32_t j = nev - 1;
-    for (it = bmap.begin(); it != bmap.end(); ++it) {
-        if ((*it).second->size() < nev) {
-            (*it).second->setBit(j, 0);
-        }
-        else if ((*it).second->size() > nev) {
-            ibis::util::logMessage
-                ("index::mapValues", "bitvector for value %.9g "
-                 "contains %lu bits while %lu are expected -- "
-                 "removing the extra bits",
-                 (*it).first, static_cast<long unsigned>((*it).second->size()),
-                 static_cast<long unsigned>(nev));
-            (*it).second->adjustSize(nev, nev);
-        }
-    }
+    ibis::bitvector mask;
+    mask.set(1, nev);
+    array_t<double> keys;
+    array_t<ibis::bitvector*> bms;
+    groupValues(val, mask, keys, bms);
+    for (uint32_t i = 0; i < keys.size(); ++ i)
+        bmap.insert(bmap.end(), VMap::value_type(keys[i], bms[i]));
+
     if (ibis::gVerbose > 4) {
         timer.stop();
         ibis::util::logMessage
@@ -2598,7 +2597,8 @@ void ibis::index::mapValues(const array_t<E>& val, VMap& bmap) {
         if (ibis::gVerbose > 30 || ((1U<<ibis::gVerbose)>bmap.size())) {
             ibis::util::logger lg;
             lg() << "value, count (extracted from the bitvector)\n";
-            for (it = bmap.begin(); it != bmap.end(); ++it)
+            for (VMap::const_iterator it = bmap.begin(); it != bmap.end();
+                 ++it)
                 lg() << (*it).first << ",\t" << (*it).second->cnt() << "\n";
         }
     }
@@ -4474,7 +4474,8 @@ void ibis::index::initBitmaps(ibis::fileManager::storage* st) {
             }
 #endif
         }
-        else {// map all the bitvectors
+        else if (offset64.back() <= (int64_t)st->size()) {
+            // map all the bitvectors
             for (uint32_t i = 0; i < nobs; ++i) {
                 if (offset64[i+1] > offset64[i]) {
                     array_t<ibis::bitvector::word_t>
@@ -4508,7 +4509,8 @@ void ibis::index::initBitmaps(ibis::fileManager::storage* st) {
         }
 #endif
     }
-    else {// map all the bitvectors
+    else if (offset32.back() <= (int32_t)st->size()) {
+        // map all the bitvectors
         for (uint32_t i = 0; i < nobs; ++i) {
             if (offset32[i+1] > offset32[i]) {
                 array_t<ibis::bitvector::word_t>
@@ -4610,6 +4612,16 @@ void ibis::index::initBitmaps(uint32_t* st) {
 /// complex setting, however, we still view the content as if it is written
 /// as 1-D array.
 void ibis::index::initBitmaps(void *ctx, FastBitReadBitmaps rd) {
+    initBitmaps(ctx, rd, 0);
+} // ibis::index::initBitmaps
+
+/// Prepare bitmaps from a reference counted context.  If @c share is not
+/// nil, the index object takes over the reference held by the caller and
+/// releases it through @c share when the bitmaps are no longer read
+/// through this context.  The copies of the index object share the same
+/// context.
+void ibis::index::initBitmaps(void *ctx, FastBitReadBitmaps rd,
+                              void (*share)(void*, int)) {
     // initialize bits to zero pointers
     for (uint32_t i = 0; i < bits.size(); ++ i)
         delete bits[i];
@@ -4621,6 +4633,8 @@ void ibis::index::initBitmaps(void *ctx, FastBitReadBitmaps rd) {
             << "Warning -- index[" << col->fullname() << "]::initBitmaps("
             << ctx << ", "<< reinterpret_cast<const void*>(rd)
             << ") can not continue without a valid offset64 or offset32";
+        if (share != 0)
+            share(ctx, -1);
         return;
     }
 
@@ -4631,9 +4645,28 @@ void ibis::index::initBitmaps(void *ctx, FastBitReadBitmaps rd) {
     if (nrows == 0 && col != 0)
         nrows = col->nRows();
     if (breader != 0) delete breader;
-    breader = new bitmapReader(ctx, rd);
+    breader = new bitmapReader(ctx, rd, share);
 } // ibis::index::initBitmaps
 
+/// Return the positions of the first byte and one past the last byte of
+/// the serialized bitmaps.  For an index read from a file, these are the
+/// positions in the index file.  Both positions are zero if the index has
+/// no offsets.
+void ibis::index::bitmapRange(int64_t& start, int64_t& end) const {
+    if (offset64.size() > 1) {
+        start = offset64.front();
+        end = offset64.back();
+    }
+    else if (offset32.size() > 1) {
+        start = offset32.front();
+        end = offset32.back();
+    }
+    else {
+        start = 0;
+        end = 0;
+    }
+} // ibis::index::bitmapRange
+
 /// Activate all bitvectors.
 void ibis::index::activate() const {
     std::string evt = "index";
@@ -4647,6 +4680,8 @@ void ibis::index::activate() const {
     ibis::util::timer mytimer(evt.c_str(), 4);
 
     const size_t nobs = bits.size();
+    if (ibis::profile::enabled())
+        ibis::profile::countBitmaps(nobs);
     bool missing = false; // any bits[i] missing (is 0)?
     for (size_t i = 0; i < nobs && ! missing; ++ i)
         missing = (bits[i] == 0);
@@ -4957,6 +4992,8 @@ void ibis::index::activate() const {
 // activate the ith bitvector
 void ibis::index::activate(uint32_t i) const {
     if (i >= bits.size()) return;   // index out of range
+    if (ibis::profile::enabled())
+        ibis::profile::countBitmaps(1);
     std::string evt = "index";
     if (col != 0 && ibis::gVerbose > 0) {
         evt += '[';
@@ -5018,8 +5055,7 @@ void ibis::index::activate(uint32_t i) const {
             ibis::array_t<uint32_t> buf;
             if (breader->read(offset64[i]/4, (offset64[i+1]-offset64[i])/4, buf)
                 >= 0) {
-                bits[i] = new ibis::bitvector
-                    (buf, offset64[i]/4, offset64[i+1]/4);
+                bits[i] = new ibis::bitvector(buf);
                 if (nrows == 0) {
                     const_cast<index*>(this)->nrows = bits[i]->size();
                 }
@@ -5117,8 +5153,7 @@ void ibis::index::activate(uint32_t i) const {
         ibis::array_t<uint32_t> buf;
         if (breader->read(offset32[i]/4, (offset32[i+1]-offset32[i])/4, buf)
             >= 0) {
-            bits[i] = new ibis::bitvector
-                (buf, offset32[i]/4, offset32[i+1]/4);
+            bits[i] = new ibis::bitvector(buf);
             if (nrows == 0) {
                 const_cast<index*>(this)->nrows = bits[i]->size();
             }
@@ -5191,6 +5226,8 @@ void ibis::index::activate(uint32_t i, uint32_t j) const {
         j = bits.size();
     if (i >= j || i >= bits.size()) // empty range
         return;
+    if (ibis::profile::enabled())
+        ibis::profile::countBitmaps(j - i);
     std::string evt = "index";
     if (col != 0 && ibis::gVerbose > 0) {
         evt += '[';
@@ -9046,6 +9083,46 @@ template void ibis::index::mapValues(const array_t<int64_t>&, VMap&);
 template void ibis::index::mapValues(const array_t<uint64_t>&, VMap&);
 template void ibis::index::mapValues(const array_t<float>&, VMap&);
 template void ibis::index::mapValues(const array_t<double>&, VMap&);
+template void
+ibis::index::groupValues(const array_t<signed char>&, const ibis::bitvector&,
+                         array_t<double>&, array_t<ibis::bitvector*>&,
+                         unsigned);
+template void
+ibis::index::groupValues(const array_t<unsigned char>&, const ibis::bitvector&,
+                         array_t<double>&, array_t<ibis::bitvector*>&,
+                         unsigned);
+template void
+ibis::index::groupValues(const array_t<int16_t>&, const ibis::bitvector&,
+                         array_t<double>&, array_t<ibis::bitvector*>&,
+                         unsigned);
+template void
+ibis::index::groupValues(const array_t<uint16_t>&, const ibis::bitvector&,
+                         array_t<double>&, array_t<ibis::bitvector*>&,
+                         unsigned);
+template void
+ibis::index::groupValues(const array_t<int32_t>&, const ibis::bitvector&,
+                         array_t<double>&, array_t<ibis::bitvector*>&,
+                         unsigned);
+template void
+ibis::index::groupValues(const array_t<uint32_t>&, const ibis::bitvector&,
+                         array_t<double>&, array_t<ibis::bitvector*>&,
+                         unsigned);
+template void
+ibis::index::groupValues(const array_t<int64_t>&, const ibis::bitvector&,
+                         array_t<double>&, array_t<ibis::bitvector*>&,
+                         unsigned);
+template void
+ibis::index::groupValues(const array_t<uint64_t>&, const ibis::bitvector&,
+                         array_t<double>&, array_t<ibis::bitvector*>&,
+                         unsigned);
+template void
+ibis::index::groupValues(const array_t<float>&, const ibis::bitvector&,
+                         array_t<double>&, array_t<ibis::bitvector*>&,
+                         unsigned);
+template void
+ibis::index::groupValues(const array_t<double>&, const ibis::bitvector&,
+                         array_t<double>&, array_t<ibis::bitvector*>&,
+                         unsigned);
 
 template void
 ibis::index::mapValues(const array_t<signed char>&, histogram&, uint32_t);
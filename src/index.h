@@ -71,6 +71,7 @@ namespace ibis { // the concrete classes of index hierarchy
     class zona;  // Unbinned version of zone.
     class fuzz;  // Unbinned version of interval-equality encoding.
     class fuge;  // Binned version of interval-equality encoding.
+    class ngram; // Trigrams of string values.
 } // namespace ibis
 
 /// @ingroup FastBitIBIS
@@ -147,11 +148,14 @@ public:
 	/// ibis::slice, bit-sliced index.
 	SLICE,
 	/// externally defined index.
-	EXTERN
+	EXTERN,
+	/// ibis::ngram, trigrams to bitmaps.
+	NGRAM
     };
 
     static index* create(const column* c, const char* name=0,
 			 const char* spec=0, int inEntirety=0);
+    static index* build(const column* c, const char* spec);
     static bool isIndex(const char* f, INDEX_TYPE t);
 
     /// The destructor.
@@ -265,6 +269,14 @@ public:
     /// Estimate the cost of evaluating a range condition.
     virtual double estimateCost(const ibis::qDiscreteRange&) const {
 	return (offset32.empty() ? (nrows<<3) : offset32.back());}
+    /// Estimate the work of resolving a range condition with the function
+    /// estimate.  The argument @c bytes receives the number of bytes of
+    /// bitmaps involved and @c cands receives the number of rows that
+    /// the index can not decide and have to be checked against the raw
+    /// data.  The default implementation assumes the index is precise.
+    virtual void estimateWork(const ibis::qContinuousRange& expr,
+                              double& bytes, double& cands) const {
+	bytes = estimateCost(expr); cands = 0.0;}
 
     /// Prints human readable information.  Outputs information about the
     /// index as text to the specified output stream.
@@ -294,6 +306,7 @@ public:
     virtual index* dup() const = 0;
 
     float sizeInBytes() const;
+    void bitmapRange(int64_t& start, int64_t& end) const;
     /// Time some logical operations and print out their speed.
     virtual void speedTest(std::ostream&) const {};
     /// Returns the number of bit vectors used by the index.
@@ -362,6 +375,11 @@ public:
     template <typename E>
     static void mapValues(const array_t<E>& val, VMap& bmap);
     template <typename E>
+    static void groupValues(const array_t<E>& val, const ibis::bitvector& mask,
+			    array_t<double>& keys,
+			    array_t<ibis::bitvector*>& bms,
+			    unsigned nthr=1);
+    template <typename E>
     static void mapValues(const array_t<E>& val, histogram& hist,
 			  uint32_t count=0);
     template <typename E>
@@ -389,6 +407,22 @@ public:
 			 uint32_t nbase = 2);
     static void printHeader(std::ostream&, const char*);
 
+    static unsigned buildThreads(const ibis::column* c);
+    static unsigned setBuildThreads(unsigned nthr);
+    static uint32_t segmentSize(uint32_t nrows, unsigned nthr);
+
+    /// A task to be performed on each segment of rows.  The segments are
+    /// handed out to the threads by runSegments, each segment exactly
+    /// once.
+    struct segmentTask {
+	/// Process the ith segment.  It may throw an exception to indicate
+	/// failure.
+	virtual void run(uint32_t i) = 0;
+	/// Destructor.
+	virtual ~segmentTask() {}
+    }; // segmentTask
+    static int runSegments(segmentTask& task, uint32_t nseg, unsigned nthr);
+
 protected:
     // forward declarations.
     class barrel;
@@ -448,6 +482,9 @@ protected:
     ////////////////////////////////////////////////////////////////////////
     /// Map the positions of each individual value.
     void mapValues(const char* f, VMap& bmap) const;
+    /// Map the positions of each individual value into sorted arrays.
+    void mapValues(const char* f, array_t<double>& keys,
+		   array_t<ibis::bitvector*>& bms) const;
     /// Generate a histogram.
     void mapValues(const char* f, histogram& hist, uint32_t count=0) const;
 
@@ -465,11 +502,14 @@ protected:
     void initBitmaps(ibis::fileManager::storage *st);
     void initBitmaps(uint32_t *st);
     void initBitmaps(void *ctx, FastBitReadBitmaps rd);
+    void initBitmaps(void *ctx, FastBitReadBitmaps rd,
+                     void (*share)(void*, int));
 
 private:
 
     static index* readOld(const column*, const char*,
 			  fileManager::storage*, INDEX_TYPE);
+    static index* readPacked(const column*, const char*);
     static index* buildNew(const column*, const char*, const char*);
 }; // ibis::index
 
@@ -484,12 +524,26 @@ public:
 }; // ibis::index::barrel
 
 /// A simple container to hold the function pointer given by user for
-/// reading the serialized bitmaps.
+/// reading the serialized bitmaps.  If a function @c share is given, the
+/// context is reference counted: each copy of the reader adds a reference
+/// by calling share(ctx, 1) and each destruction removes one by calling
+/// share(ctx, -1).  The reader takes over the reference held by the
+/// caller of the constructor.
 class ibis::index::bitmapReader {
 public:
     /// Constructor.
-    bitmapReader(void *ctx, FastBitReadBitmaps rd)
-        : _context(ctx), _reader(rd) {}
+    bitmapReader(void *ctx, FastBitReadBitmaps rd,
+                 void (*share)(void*, int)=0)
+        : _context(ctx), _reader(rd), _share(share) {}
+    /// Copy constructor.
+    bitmapReader(const bitmapReader &rhs)
+        : _context(rhs._context), _reader(rhs._reader), _share(rhs._share) {
+        if (_share != 0) _share(_context, 1);
+    }
+    /// Destructor.
+    ~bitmapReader() {
+        if (_share != 0) _share(_context, -1);
+    }
 
     /// The main function to read the serialized bitmaps.  It assumes the
     /// bitmaps have been serialized and packed into a 1-D array of type
@@ -540,8 +594,10 @@ public:
 private:
     void *_context;
     FastBitReadBitmaps _reader;
+    void (*_share)(void*, int);
 
-    // Default constructor.  Declared, but not defined.
+    // Default constructor and assignment.  Declared, but not defined.
     bitmapReader();
+    bitmapReader& operator=(const bitmapReader&);
 }; // ibis::index::bitmapReader
 #endif // IBIS_INDEX_H
@@ -0,0 +1,717 @@
+// $Id$
+// Author: John Wu <John.Wu at ACM.org>
+// Copyright (c) 2006-2016 the Regents of the University of California
+//
+// This file implements the ibis::ngram class.
+#include "ingram.h"
+#include "part.h"       // ibis::part
+
+#include <algorithm>    // std::sort, std::unique, std::lower_bound
+
+/// Encode three characters as a trigram.  The characters are folded to
+/// lower case if the string comparisons are case-insensitive.
+static inline uint32_t _ibis_ngram_code(const char *s) {
+    const unsigned char *u = reinterpret_cast<const unsigned char*>(s);
+#if FASTBIT_CASE_SENSITIVE_COMPARE+0 == 0
+    return ((static_cast<uint32_t>(tolower(u[0]) & 0xFF) << 16) |
+            (static_cast<uint32_t>(tolower(u[1]) & 0xFF) << 8) |
+            static_cast<uint32_t>(tolower(u[2]) & 0xFF));
+#else
+    return ((static_cast<uint32_t>(u[0]) << 16) |
+            (static_cast<uint32_t>(u[1]) << 8) |
+            static_cast<uint32_t>(u[2]));
+#endif
+} // _ibis_ngram_code
+
+/// Append the trigrams of the first @c len bytes of @c str to @c grm.
+static void _ibis_ngram_add(const char *str, size_t len,
+                            std::vector<uint32_t> &grm) {
+    for (size_t j = 0; j+2 < len; ++ j)
+        grm.push_back(_ibis_ngram_code(str+j));
+} // _ibis_ngram_add
+
+/// Constructor.  For a text column, it first attempts to read an existing
+/// index file, and then builds a new index from the data file and writes
+/// it if the index file can not be used.  An index file older than the
+/// data file or with a different number of rows is not used.  For a
+/// category column, the index is built from the dictionary of the column.
+ibis::ngram::ngram(const ibis::column* c, const char* f)
+    : ibis::index(c) {
+    if (c == 0) return; // does nothing
+    if (c->type() != ibis::CATEGORY &&
+        c->type() != ibis::TEXT) {
+        LOGGER(ibis::gVerbose >= 0)
+            << "ngram::ngram -- can only index categorical "
+            "values or string values";
+        throw ibis::bad_alloc("wrong column type for ibis::ngram"
+                              IBIS_FILE_LINE);
+    }
+
+    int ierr;
+    if (c->type() == ibis::CATEGORY) {
+        const ibis::dictionary *dic =
+            static_cast<const ibis::category*>(c)->getDictionary();
+        ierr = (dic != 0 ? buildFromDictionary(*dic) : -1);
+    }
+    else {
+        std::string fnm, dfn;
+        ngramFileName(fnm, f);
+        dataFileName(dfn, f);
+        ierr = -1;
+        Stat_T ist, dst;
+        if (! fnm.empty() && UnixStat(fnm.c_str(), &ist) == 0 &&
+            ist.st_size > 0 && UnixStat(dfn.c_str(), &dst) == 0 &&
+            ist.st_mtime >= dst.st_mtime) {
+            ierr = read(f);
+            if (ierr >= 0 && c->partition() != 0 &&
+                nrows != c->partition()->nRows()) {
+                clear();
+                ierr = -1;
+            }
+        }
+        if (ierr < 0) {
+            ierr = buildFromText(f);
+            if (ierr >= 0 && write(f) < 0) {
+                LOGGER(ibis::gVerbose > 1)
+                    << "Warning -- ngram[" << c->fullname()
+                    << "]::ctor failed to write the trigram index to "
+                    << fnm;
+            }
+        }
+    }
+    if (ierr < 0) {
+        LOGGER(ibis::gVerbose >= 0)
+            << "Warning -- ngram[" << c->fullname()
+            << "]::ctor failed to build the trigram index, ierr = " << ierr;
+        throw ibis::bad_alloc("ngram::ctor failed to build an index"
+                              IBIS_FILE_LINE);
+    }
+
+    optionalUnpack(bits, col->indexSpec());
+    if (ibis::gVerbose > 4) {
+        ibis::util::logger lg;
+        print(lg());
+    }
+} // ibis::ngram::ngram
+
+/// Constructor.  Build a trigram index over the entries of a dictionary.
+/// The bitmaps are indexed by the integer codes of the dictionary.
+ibis::ngram::ngram(const ibis::column* c, const ibis::dictionary& dic)
+    : ibis::index(c) {
+    (void) buildFromDictionary(dic);
+} // ibis::ngram::ngram
+
+/// Constructor.  Reconstruct a trigram index from an existing file.
+ibis::ngram::ngram(const ibis::column* c, ibis::fileManager::storage* st)
+    : ibis::index(c, st) {
+    read(st);
+} // ibis::ngram::ngram
+
+ibis::index* ibis::ngram::dup() const {
+    return new ibis::ngram(*this);
+}
+
+/// Does the index specification ask for a trigram index?
+bool ibis::ngram::requested(const char* spec) {
+    return (spec != 0 && *spec != 0 &&
+            (strstr(spec, "ngram") != 0 || strstr(spec, "trigram") != 0 ||
+             strstr(spec, "NGRAM") != 0 || strstr(spec, "TRIGRAM") != 0));
+} // ibis::ngram::requested
+
+/// Extract the distinct trigrams of a null-terminated string.  The
+/// trigrams are returned in ascending order.
+void ibis::ngram::extractGrams(const char* str, std::vector<uint32_t>& grm) {
+    grm.clear();
+    if (str == 0) return;
+    _ibis_ngram_add(str, std::strlen(str), grm);
+    std::sort(grm.begin(), grm.end());
+    grm.erase(std::unique(grm.begin(), grm.end()), grm.end());
+} // ibis::ngram::extractGrams
+
+/// Extract the distinct trigrams that must appear in any string matching
+/// the SQL LIKE pattern.  These are the trigrams of the literal pieces
+/// between the meta characters.  An escaped meta character is treated as
+/// a literal character.
+void ibis::ngram::patternGrams(const char* pat, std::vector<uint32_t>& grm) {
+    grm.clear();
+    if (pat == 0) return;
+
+    std::string lit;
+    for (const char *ptr = pat; *ptr != 0; ++ ptr) {
+        switch (*ptr) {
+        case STRMATCH_META_ESCAPE:
+            if (ptr[1] != 0) {
+                ++ ptr;
+                lit += *ptr;
+            }
+            break;
+        case STRMATCH_META_CSH_ANY:
+        case STRMATCH_META_CSH_ONE:
+        case STRMATCH_META_SQL_ANY:
+        case STRMATCH_META_SQL_ONE:
+            _ibis_ngram_add(lit.data(), lit.size(), grm);
+            lit.clear();
+            break;
+        default:
+            lit += *ptr;
+            break;
+        }
+    }
+    _ibis_ngram_add(lit.data(), lit.size(), grm);
+    std::sort(grm.begin(), grm.end());
+    grm.erase(std::unique(grm.begin(), grm.end()), grm.end());
+} // ibis::ngram::patternGrams
+
+/// Build the index from the data file of a text column.  The strings in
+/// the data file are null-terminated and stored one after another, which
+/// allows the whole file to be mapped and scanned without the starting
+/// positions.
+int ibis::ngram::buildFromText(const char* f) {
+    std::string fnm, evt;
+    evt = "ngram";
+    if (col != 0 && ibis::gVerbose > 1) {
+        evt += '[';
+        evt += col->fullname();
+        evt += ']';
+    }
+    evt += "::buildFromText";
+    dataFileName(fnm, f);
+    if (fnm.empty()) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- " << evt << " failed to determine the data file "
+            "name from \"" << (f ? f : "") << '"';
+        return -1;
+    }
+    ibis::util::timer mytimer(evt.c_str(), 3);
+
+    const off_t nbytes = ibis::util::getFileSize(fnm.c_str());
+    if (nbytes <= 0) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- " << evt << " found data file " << fnm
+            << " to be empty or missing";
+        return -2;
+    }
+    int fdes = UnixOpen(fnm.c_str(), OPEN_READONLY);
+    if (fdes < 0) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- " << evt << " failed to open data file " << fnm;
+        return -3;
+    }
+    IBIS_BLOCK_GUARD(UnixClose, fdes);
+#if defined(_WIN32) && defined(_MSC_VER)
+    (void)_setmode(fdes, _O_BINARY);
+#endif
+
+    GMap gmap;
+    uint32_t irow = 0;
+    try {
+        const array_t<char> raw(fnm.c_str(), fdes, static_cast<off_t>(0),
+                                nbytes);
+        std::vector<uint32_t> grm;
+        const char *sptr = raw.begin();
+        const char *end = raw.end();
+        while (sptr < end) {
+            const char *nxt =
+                static_cast<const char*>(std::memchr(sptr, 0, end-sptr));
+            if (nxt == 0) { // the last string is not terminated
+                LOGGER(ibis::gVerbose > 1)
+                    << "Warning -- " << evt << " found the last string in "
+                    << fnm << " without a terminating null character";
+                break;
+            }
+
+            if (nxt - sptr > 2) {
+                extractGrams(sptr, grm);
+                for (std::vector<uint32_t>::const_iterator it = grm.begin();
+                     it != grm.end(); ++ it) {
+                    ibis::bitvector *&bv = gmap[*it];
+                    if (bv == 0)
+                        bv = new ibis::bitvector;
+                    bv->setBit(irow, 1);
+                }
+            }
+            ++ irow;
+            sptr = nxt + 1;
+        }
+        ibis::fileManager::instance().recordPages(0, nbytes);
+    }
+    catch (...) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- " << evt << " failed to process data file " << fnm
+            << " after " << irow << " string" << (irow>1?"s":"");
+        for (GMap::iterator it = gmap.begin(); it != gmap.end(); ++ it)
+            delete it->second;
+        return -4;
+    }
+
+    fillBitmaps(gmap, irow);
+    LOGGER(ibis::gVerbose > 3)
+        << evt << " extracted " << grams.size() << " distinct trigram"
+        << (grams.size()>1?"s":"") << " from " << nrows << " string"
+        << (nrows>1?"s":"") << " in " << fnm;
+    return grams.size();
+} // ibis::ngram::buildFromText
+
+/// Build the index from the entries of a dictionary.  The bitmaps are
+/// indexed by the integer codes of the dictionary, therefore nrows is the
+/// size of the dictionary.
+int ibis::ngram::buildFromDictionary(const ibis::dictionary& dic) {
+    GMap gmap;
+    try {
+        std::vector<uint32_t> grm;
+        for (uint32_t j = 0; j < dic.size(); ++ j) {
+            extractGrams(dic[j], grm);
+            for (std::vector<uint32_t>::const_iterator it = grm.begin();
+                 it != grm.end(); ++ it) {
+                ibis::bitvector *&bv = gmap[*it];
+                if (bv == 0)
+                    bv = new ibis::bitvector;
+                bv->setBit(j, 1);
+            }
+        }
+    }
+    catch (...) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- ngram[" << (col != 0 ? col->fullname() : "?.?")
+            << "]::buildFromDictionary failed to process "
+            << dic.size() << " dictionary entr" << (dic.size()>1?"ies":"y");
+        for (GMap::iterator it = gmap.begin(); it != gmap.end(); ++ it)
+            delete it->second;
+        return -1;
+    }
+
+    fillBitmaps(gmap, dic.size());
+    return grams.size();
+} // ibis::ngram::buildFromDictionary
+
+/// Move the bitmaps from the map to the member variables.  The bitvectors
+/// in gmap are owned by this object afterwards.
+void ibis::ngram::fillBitmaps(GMap& gmap, uint32_t nr) {
+    clear();
+    nrows = nr;
+    grams.resize(gmap.size());
+    bits.resize(gmap.size());
+    uint32_t j = 0;
+    for (GMap::iterator it = gmap.begin(); it != gmap.end(); ++ it, ++ j) {
+        grams[j] = it->first;
+        bits[j] = it->second;
+        bits[j]->adjustSize(0, nr);
+        bits[j]->compress();
+    }
+    gmap.clear();
+} // ibis::ngram::fillBitmaps
+
+/// Compute the candidates that might match the given SQL LIKE pattern.
+/// On successful completion, the bitvector @c cand is a superset of the
+/// strings matching the pattern and the return value is the number of
+/// candidates.  A negative value is returned if the pattern does not
+/// contain any trigram, in which case every string is a candidate.
+long ibis::ngram::candidates(const char* pat, ibis::bitvector& cand) const {
+    cand.clear();
+    if (pat == 0 || nrows == 0) return -1L;
+
+    std::vector<uint32_t> pg;
+    patternGrams(pat, pg);
+    if (pg.empty()) return -2L;
+
+    // pairs of (size of bitmap, position of the trigram)
+    std::vector< std::pair<uint32_t, uint32_t> > sel;
+    sel.reserve(pg.size());
+    for (std::vector<uint32_t>::const_iterator it = pg.begin();
+         it != pg.end(); ++ it) {
+        const uint32_t j = std::lower_bound(grams.begin(), grams.end(), *it)
+            - grams.begin();
+        const ibis::bitvector *bv =
+            (j < grams.size() && grams[j] == *it ? getBitvector(j) : 0);
+        if (bv == 0 || bv->sloppyCount() == 0) { // no string has the trigram
+            cand.set(0, nrows);
+            return 0L;
+        }
+        sel.push_back(std::make_pair(bv->bytes(), j));
+    }
+
+    // AND the smallest bitmaps first
+    std::sort(sel.begin(), sel.end());
+    cand.copy(*bits[sel[0].second]);
+    for (uint32_t j = 1; j < sel.size() && cand.sloppyCount() > 0; ++ j)
+        cand &= *bits[sel[j].second];
+
+    LOGGER(ibis::gVerbose > 5)
+        << "ngram[" << (col != 0 ? col->fullname() : "?.?")
+        << "]::candidates(" << pat << ") used " << sel.size()
+        << " trigram" << (sel.size()>1?"s":"") << " to select "
+        << cand.cnt() << " out of " << nrows;
+    return cand.cnt();
+} // ibis::ngram::candidates
+
+void ibis::ngram::binWeights(std::vector<uint32_t>& bw) const {
+    bw.resize(bits.size());
+    activate();
+    for (uint32_t i = 0; i < bits.size(); ++ i)
+        bw[i] = (bits[i] ? bits[i]->cnt() : 0);
+} // ibis::ngram::binWeights
+
+void ibis::ngram::print(std::ostream& out) const {
+    const uint32_t nobs = bits.size();
+    if (grams.size() == bits.size() && nobs > 0) {
+        out << "The ngram index for column ";
+        if (col != 0) {
+            if (col->partition() != 0)
+                out << col->partition()->name() << '.';
+            out << col->name();
+        }
+        out << " contains " << nobs << " trigram" << (nobs>1?"s":"")
+            << " over " << nrows
+            << (col != 0 && col->type() == ibis::CATEGORY ?
+                " dictionary entries" : " rows")
+            << " (followed by their frequencies)\n";
+        uint32_t skip = 0;
+        if (ibis::gVerbose <= 0) {
+            skip = nobs;
+        }
+        else if ((nobs >> ibis::gVerbose) > 2) {
+            skip = static_cast<uint32_t>
+                (ibis::util::compactValue
+                 (static_cast<double>(nobs >> (1+ibis::gVerbose)),
+                  static_cast<double>(nobs >> (ibis::gVerbose))));
+            if (skip < 1)
+                skip = 1;
+        }
+        else {
+            skip = 1;
+        }
+        if (skip == 0) skip = 1;
+        if (skip > 1) {
+            out << " (printing 1 out of every " << skip << ")\n";
+        }
+        for (uint32_t i = 0; i < nobs; i += skip) {
+            const ibis::bitvector *bv = getBitvector(i);
+            if (bv != 0) {
+                const char tri[4] = {static_cast<char>(grams[i] >> 16),
+                                     static_cast<char>(grams[i] >> 8),
+                                     static_cast<char>(grams[i]), 0};
+                out << '"' << tri << "\"\t" << bv->cnt() << "\n";
+            }
+        }
+    }
+    else if (col != 0) {
+        out << "The ngram index for " << col->name()
+            << " is empty or ill-formed";
+    }
+    out << std::endl;
+} // ibis::ngram::print
+
+/// Name of the index file.  The index is stored in a file with extension
+/// .ngm because the .idx file holds the primary index of the column, i.e.,
+/// ibis::keywords for a text column and ibis::direkte for a category
+/// column.
+void ibis::ngram::ngramFileName(std::string& fnm, const char* f) const {
+    dataFileName(fnm, f);
+    if (! fnm.empty())
+        fnm += ".ngm";
+} // ibis::ngram::ngramFileName
+
+/// Write the index to a file.  The file starts with the usual 8-byte
+/// header, the number of rows and the number of trigrams, followed by the
+/// offsets of the bitmaps, the trigrams and the bitmaps.
+int ibis::ngram::write(const char* dt) const {
+    std::string fnm, evt;
+    evt = "ngram";
+    if (col != 0 && ibis::gVerbose > 1) {
+        evt += '[';
+        evt += col->fullname();
+        evt += ']';
+    }
+    evt += "::write";
+    ngramFileName(fnm, dt);
+    if (fnm.empty()) return 0;
+    if (ibis::gVerbose > 1) {
+        evt += '(';
+        evt += fnm;
+        evt += ')';
+    }
+
+    if (fname != 0 || str != 0)
+        activate();
+    int fdes = UnixOpen(fnm.c_str(), OPEN_WRITENEW, OPEN_FILEMODE);
+    if (fdes < 0) {
+        ibis::fileManager::instance().flushFile(fnm.c_str());
+        fdes = UnixOpen(fnm.c_str(), OPEN_WRITENEW, OPEN_FILEMODE);
+        if (fdes < 0) {
+            LOGGER(ibis::gVerbose > 0)
+                << "Warning -- " << evt << " failed to open \"" << fnm
+                << "\" for writing";
+            return -1;
+        }
+    }
+    IBIS_BLOCK_GUARD(UnixClose, fdes);
+#if defined(_WIN32) && defined(_MSC_VER)
+    (void)_setmode(fdes, _O_BINARY);
+#endif
+#if defined(HAVE_FLOCK)
+    ibis::util::flock flck(fdes);
+    if (flck.isLocked() == false) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- " << evt << " failed to acquire an exclusive lock "
+            "on file " << fnm << " for writing, another thread must be "
+            "writing the index now";
+        return -6;
+    }
+#endif
+
+    off_t ierr = 0;
+    const uint32_t nobs = bits.size();
+#ifdef FASTBIT_USE_LONG_OFFSETS
+    const bool useoffset64 = true;
+#else
+    const bool useoffset64 = (8+getSerialSize() > 0x80000000UL);
+#endif
+    char header[] = "#IBIS\7\0\0";
+    header[5] = (char)ibis::index::NGRAM;
+    header[6] = (char)(useoffset64 ? 8 : 4);
+    ierr = UnixWrite(fdes, header, 8);
+    if (ierr < 8) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- " << evt
+            << " failed to write the 8-byte header, ierr = " << ierr;
+        return -3;
+    }
+    ierr  = UnixWrite(fdes, &nrows, sizeof(uint32_t));
+    ierr += UnixWrite(fdes, &nobs,  sizeof(uint32_t));
+    if (ierr < (off_t)(sizeof(uint32_t)*2)) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- " << evt
+            << " failed to write nrows and nobs, ierr = " << ierr;
+        return -4;
+    }
+    const off_t gstart = 16 + header[6]*(nobs+1);
+    ierr = UnixSeek(fdes, gstart, SEEK_SET);
+    if (ierr != gstart) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- " << evt
+            << " failed to seek to " << gstart << ", ierr = " << ierr;
+        return -5;
+    }
+    ierr = UnixWrite(fdes, grams.begin(), sizeof(uint32_t)*nobs);
+    if (ierr < (off_t)(sizeof(uint32_t)*nobs)) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- " << evt
+            << " failed to write " << nobs << " trigrams, ierr = " << ierr;
+        return -5;
+    }
+    offset64.resize(nobs+1);
+    offset64[0] = gstart + sizeof(uint32_t)*nobs;
+    for (uint32_t i = 0; i < nobs; ++ i) {
+        if (bits[i]) {
+            bits[i]->write(fdes);
+        }
+        offset64[i+1] = UnixSeek(fdes, 0, SEEK_CUR);
+    }
+    ierr = UnixSeek(fdes, 16, SEEK_SET);
+    if (ierr != 16) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- " << evt
+            << " failed to seek to offset 16, ierr = " << ierr;
+        return -6;
+    }
+    if (useoffset64) {
+        ierr = UnixWrite(fdes, offset64.begin(), 8*(nobs+1));
+        offset32.clear();
+    }
+    else {
+        offset32.resize(nobs+1);
+        for (unsigned j = 0; j <= nobs; ++ j)
+            offset32[j] = offset64[j];
+        ierr = UnixWrite(fdes, offset32.begin(), 4*(nobs+1));
+        offset64.clear();
+    }
+    if (ierr < (off_t)(header[6]*(nobs+1))) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- " << evt
+            << " failed to write bitmap offsets, ierr = " << ierr;
+        return -7;
+    }
+#if defined(FASTBIT_SYNC_WRITE)
+#if _POSIX_FSYNC+0 > 0
+    (void) UnixFlush(fdes); // write to disk
+#elif defined(_WIN32) && defined(_MSC_VER)
+    (void) _commit(fdes);
+#endif
+#endif
+
+    LOGGER(ibis::gVerbose > 5)
+        << evt << " wrote " << nobs
+        << " bitmap" << (nobs>1?"s":"") << " to " << fnm;
+    return 0;
+} // ibis::ngram::write
+
+/// Serialize the index into three arrays.  The trigrams are the keys.
+int ibis::ngram::write(ibis::array_t<double> &keys,
+                       ibis::array_t<int64_t> &starts,
+                       ibis::array_t<uint32_t> &bitmaps) const {
+    const uint32_t nobs = bits.size();
+    keys.resize(0);
+    if (nobs == 0) {
+        starts.resize(0);
+        bitmaps.resize(0);
+        return 0;
+    }
+
+    activate();
+    keys.resize(nobs);
+    starts.resize(nobs+1);
+    starts[0] = 0;
+    for (unsigned j = 0; j < nobs; ++ j) { // iterate over bitmaps
+        if (bits[j] != 0) {
+            ibis::array_t<ibis::bitvector::word_t> tmp;
+            bits[j]->write(tmp);
+            bitmaps.insert(bitmaps.end(), tmp.begin(), tmp.end());
+        }
+        starts[j+1] = bitmaps.size();
+        keys[j] = grams[j];
+    }
+    return 0;
+} // ibis::ngram::write
+
+void ibis::ngram::serialSizes
+(uint64_t &wkeys, uint64_t &woffsets, uint64_t &wbitmaps) const {
+    const uint32_t nobs = bits.size();
+    if (nobs == 0) {
+        wkeys = 0;
+        woffsets = 0;
+        wbitmaps = 0;
+    }
+    else {
+        wkeys = nobs;
+        woffsets = nobs + 1;
+        wbitmaps = 0;
+        for (unsigned j = 0; j < nobs; ++ j) {
+            if (bits[j] != 0)
+                wbitmaps += bits[j]->getSerialSize();
+        }
+        wbitmaps /= 4;
+    }
+} // ibis::ngram::serialSizes
+
+int ibis::ngram::read(const char* f) {
+    std::string fnm;
+    ngramFileName(fnm, f);
+    int fdes = UnixOpen(fnm.c_str(), OPEN_READONLY);
+    if (fdes < 0) return -1;
+
+    char header[8];
+    IBIS_BLOCK_GUARD(UnixClose, fdes);
+#if defined(_WIN32) && defined(_MSC_VER)
+    (void)_setmode(fdes, _O_BINARY);
+#endif
+    if (8 != UnixRead(fdes, static_cast<void*>(header), 8)) {
+        return -2;
+    }
+
+    if (false == (header[0] == '#' && header[1] == 'I' &&
+                  header[2] == 'B' && header[3] == 'I' &&
+                  header[4] == 'S' &&
+                  header[5] == static_cast<char>(ibis::index::NGRAM) &&
+                  (header[6] == 8 || header[6] == 4) &&
+                  header[7] == static_cast<char>(0))) {
+        if (ibis::gVerbose > 0) {
+            ibis::util::logger lg;
+            lg() << "Warning -- ngram[" << col->fullname()
+                 << "]::read the header from " << fnm << " (";
+            printHeader(lg(), header);
+            lg() << ") does not contain the expected values";
+        }
+        return -3;
+    }
+
+    uint32_t dim[2];
+    size_t begin, end;
+    clear(); // clear the current bit vectors
+    fname = ibis::util::strnewdup(fnm.c_str());
+
+    off_t ierr = UnixRead(fdes, static_cast<void*>(dim), 2*sizeof(uint32_t));
+    if (ierr < static_cast<int>(2*sizeof(uint32_t))) {
+        return -4;
+    }
+    nrows = dim[0];
+    // read offsets
+    begin = 8 + 2*sizeof(uint32_t);
+    ierr = initOffsets(fdes, header[6], begin, dim[1]);
+    if (ierr < 0)
+        return ierr;
+
+    // read the trigrams
+    begin += header[6] * (dim[1] + 1);
+    end = begin + sizeof(uint32_t) * dim[1];
+    try {
+        array_t<uint32_t> tmp(fname, fdes, begin, end);
+        grams.swap(tmp);
+    }
+    catch (...) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- ngram[" << col->fullname() << "]::read(" << fnm
+            << ") failed to read " << dim[1] << " trigrams";
+        clear();
+        return -5;
+    }
+    ibis::fileManager::instance().recordPages(0, end);
+
+    initBitmaps(fdes);
+    str = 0;
+    LOGGER(ibis::gVerbose > 7)
+        << "ngram[" << col->fullname() << "]::read(" << fnm
+        << ") finished reading index header with nrows="
+        << nrows << " and bits.size()=" << bits.size();
+    return 0;
+} // ibis::ngram::read
+
+// attempt to reconstruct an index from a piece of consecutive memory
+int ibis::ngram::read(ibis::fileManager::storage* st) {
+    if (st == 0) return -1;
+    if (st->begin()[5] != ibis::index::NGRAM) return -3;
+    clear();
+
+    const char offsetsize = st->begin()[6];
+    nrows = *(reinterpret_cast<uint32_t*>(st->begin()+8));
+    size_t pos = 8 + sizeof(uint32_t);
+    size_t end;
+    const uint32_t nobs = *(reinterpret_cast<uint32_t*>(st->begin()+pos));
+    pos += sizeof(uint32_t);
+    end = pos + offsetsize * (nobs + 1);
+    if (offsetsize == 8) {
+        array_t<int64_t> offs(st, pos, end);
+        offset64.copy(offs);
+    }
+    else if (offsetsize == 4) {
+        array_t<int32_t> offs(st, pos, end);
+        offset32.copy(offs);
+    }
+    else {
+        clear();
+        return -2;
+    }
+
+    pos = end;
+    end = pos + sizeof(uint32_t) * nobs;
+    array_t<uint32_t> tmp(st, pos, end);
+    grams.swap(tmp);
+
+    initBitmaps(st);
+    return 0;
+} // ibis::ngram::read
+
+/// Clear the current content.
+void ibis::ngram::clear() {
+    grams.clear();
+    ibis::index::clear();
+} // ibis::ngram::clear
+
+/// Estimate the size of the index file.  The bitmap offsets are assumed
+/// to be 8-byte long.
+size_t ibis::ngram::getSerialSize() const throw () {
+    size_t res = 24 + (bits.size() << 3) + (grams.size() << 2);
+    for (unsigned j = 0; j < bits.size(); ++ j)
+        if (bits[j] != 0)
+            res += bits[j]->getSerialSize();
+    return res;
+} // ibis::ngram::getSerialSize
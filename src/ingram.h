@@ -0,0 +1,102 @@
+//File: $Id$
+// Author: John Wu <John.Wu at ACM.org>
+// Copyright (c) 2006-2016 the Regents of the University of California
+#ifndef IBIS_NGRAM_H
+#define IBIS_NGRAM_H
+///@file
+/// This index is a trigram index for a string-valued column.  It is used
+/// to reduce the number of strings examined while evaluating LIKE
+/// conditions.
+
+#include "index.h"	// base index class
+#include "category.h"	// definitions of string-valued columns
+
+/// Class ibis::ngram maps each sequence of three consecutive characters
+/// (a trigram) to a bitmap.  For an ibis::text column, the bitmaps mark
+/// the rows containing the trigram.  For an ibis::category column, the
+/// bitmaps mark the integer codes of the dictionary entries containing
+/// the trigram.
+///
+/// A LIKE pattern is broken into its literal pieces, i.e., the characters
+/// between the meta characters '%', '_', '*' and '?'.  A string can only
+/// match the pattern if it contains every trigram of these literal
+/// pieces.  The function candidates ANDs together the bitmaps of these
+/// trigrams to produce a list of candidates, which must then be verified
+/// against the actual string values with ibis::util::strMatch.  Patterns
+/// without any literal piece of three or more characters can not be
+/// narrowed down with this index.
+///
+/// If the string comparisons are case-insensitive, i.e., the macro
+/// FASTBIT_CASE_SENSITIVE_COMPARE is defined to be 0, the trigrams are
+/// formed after folding the characters to lower case.
+///
+/// To build a trigram index on a text column, include the keyword "ngram"
+/// or "trigram" in its index specification, e.g.,
+/// @code
+/// index=ngram
+/// @endcode
+/// The trigram index is an addition to the keyword index of the column
+/// (ibis::keywords), which still answers the CONTAINS conditions.  It is
+/// stored in a separate file with extension .ngm, and is built along with
+/// the keyword index or on first use.  A category column with the same
+/// keyword in its index specification builds a trigram index over its
+/// dictionary in memory when needed.
+class ibis::ngram : public ibis::index {
+public:
+    virtual ~ngram() {clear();}
+    explicit ngram(const ibis::column* c, const char* f=0);
+    ngram(const ibis::column* c, const ibis::dictionary& dic);
+    ngram(const ibis::column* c, ibis::fileManager::storage* st);
+
+    virtual INDEX_TYPE type() const {return NGRAM;}
+    virtual const char* name() const {return "ngram";}
+    virtual void binBoundaries(std::vector<double>& b) const {b.clear();}
+    virtual void binWeights(std::vector<uint32_t>& b) const;
+    virtual double getMin() const {return DBL_MAX;}
+    virtual double getMax() const {return -DBL_MAX;}
+    virtual double getSum() const {return -DBL_MAX;}
+
+    long candidates(const char* pat, ibis::bitvector& cand) const;
+    static bool requested(const char* spec);
+
+    virtual index* dup() const;
+    virtual void print(std::ostream& out) const;
+    virtual void serialSizes(uint64_t&, uint64_t&, uint64_t&) const;
+    virtual int write(ibis::array_t<double> &,
+                      ibis::array_t<int64_t> &,
+                      ibis::array_t<uint32_t> &) const;
+    virtual int write(const char* dt) const;
+    virtual int read(const char* idxfile);
+    virtual int read(ibis::fileManager::storage* st);
+
+    using ibis::index::evaluate;
+    using ibis::index::estimate;
+    using ibis::index::undecidable;
+    /// A trigram index can not answer range conditions.
+    virtual long evaluate(const ibis::qContinuousRange&,
+			  ibis::bitvector&) const {return -1;}
+    virtual long select(const ibis::qContinuousRange&, void*) const {
+	return -1;}
+    virtual long select(const ibis::qContinuousRange&, void*,
+			ibis::bitvector&) const {
+	return -1;}
+
+protected:
+    /// The trigrams in ascending order.  The bitmap for grams[i] is
+    /// bits[i].
+    ibis::array_t<uint32_t> grams;
+
+    typedef std::map< uint32_t, ibis::bitvector* > GMap;
+
+    virtual size_t getSerialSize() const throw();
+    void ngramFileName(std::string& fnm, const char* f) const;
+    int  buildFromText(const char* f);
+    int  buildFromDictionary(const ibis::dictionary& dic);
+    void fillBitmaps(GMap& gmap, uint32_t nr);
+    static void extractGrams(const char* str, std::vector<uint32_t>& grm);
+    static void patternGrams(const char* pat, std::vector<uint32_t>& grm);
+
+    void clear();
+}; // class ibis::ngram
+
+#endif
@@ -831,37 +831,25 @@ void ibis::relic::clear() {
 void ibis::relic::construct(const char* f) {
     if (col == 0) return;
 
-    VMap bmap;
+    array_t<double> keys;
+    array_t<ibis::bitvector*> bms;
     try {
-        mapValues(f, bmap);
+        mapValues(f, keys, bms);
     }
-    catch (...) { // need to clean up bmap
+    catch (...) { // the bitmaps have been freed by mapValues
         LOGGER(ibis::gVerbose > 0)
             << "Warning -- relic[" << col->fullname()
-            << "]::construct reclaiming storage allocated to bitvectors ("
-            << bmap.size() << ")";
-
-        for (VMap::iterator it = bmap.begin(); it != bmap.end(); ++ it)
-            delete (*it).second;
-        bmap.clear();
+            << "]::construct failed to map the values";
         ibis::fileManager::instance().signalMemoryAvailable();
         throw; // rethrow the exception
     }
-    if (bmap.empty()) return; // bmap is empty
+    if (keys.empty()) return;
 
-    uint32_t i;
-    // copy the pointer in VMap into two linear structures
-    const uint32_t nobs = bmap.size();
-    bits.resize(nobs);
-    vals.resize(nobs);
-    VMap::const_iterator it;
-    for (it = bmap.begin(); nrows == 0 && it != bmap.end(); ++ it)
-        if ((*it).second)
-            nrows = (*it).second->size();
-    for (i = 0, it = bmap.begin(); i < nobs; ++ it, ++ i) {
-        vals[i] = (*it).first;
-        bits[i] = (*it).second;
-    }
+    for (uint32_t i = 0; nrows == 0 && i < bms.size(); ++ i)
+        if (bms[i] != 0)
+            nrows = bms[i]->size();
+    vals.swap(keys);
+    bits.swap(bms);
     optionalUnpack(bits, col->indexSpec());
 
     // write out the current content
@@ -877,36 +865,28 @@ void ibis::relic::construct(const char* f) {
 /// checked in this function is the directives for compression.
 template <typename E>
 void ibis::relic::construct(const array_t<E>& arr) {
-    VMap bmap;
     nrows = arr.size();
+    if (nrows == 0) return;
+
+    ibis::bitvector mask;
+    mask.set(1, nrows);
+    array_t<double> keys;
+    array_t<ibis::bitvector*> bms;
     try {
-        mapValues(arr, bmap);
+        groupValues(arr, mask, keys, bms, buildThreads(col));
     }
-    catch (...) { // need to clean up bmap
+    catch (...) {
         LOGGER(ibis::gVerbose > 0)
             << "Warning -- relic[" << (col ? col->fullname() : "?.?")
             << "]::construct<" << typeid(E).name()
-            << "> reclaiming storage allocated to bitvectors ("
-            << bmap.size() << ")";
-
-        for (VMap::iterator it = bmap.begin(); it != bmap.end(); ++ it)
-            delete (*it).second;
-        bmap.clear();
+            << "> failed to group " << nrows << " values";
         ibis::fileManager::instance().signalMemoryAvailable();
         throw;
     }
-    if (bmap.empty()) return; // bmap is empty
+    if (keys.empty()) return;
 
-    // copy the pointer in VMap into two linear structures
-    const uint32_t nobs = bmap.size();
-    bits.resize(nobs);
-    vals.resize(nobs);
-    uint32_t i;
-    VMap::const_iterator it;
-    for (i = 0, it = bmap.begin(); i < nobs; ++it, ++i) {
-        vals[i] = (*it).first;
-        bits[i] = (*it).second;
-    }
+    vals.swap(keys);
+    bits.swap(bms);
     optionalUnpack(bits, (col ? col->indexSpec() : ""));
 
     // write out the current content
@@ -12,11 +12,14 @@
 #include "countQuery.h" // ibis::countQuery
 #include "selectClause.h"       // ibis::selectClause
 #include "index.h"      // ibis::index
+#include "profile.h"    // ibis::profile
+#include "workload.h"   // ibis::workload
 
 #include "blob.h"       // ibis::blob
 #include "category.h"   // ibis::text
 
 #include <algorithm>    // std::sort, std::copy
+#include <memory>       // std::unique_ptr
 #include <sstream>      // std::ostringstream
 #include <limits>       // std::numeric_limits
 #include <cmath>        // std::floor
@@ -584,6 +587,22 @@ void ibis::mensa::estimate(const ibis::qExpr* cond,
 } // ibis::mensa::estimate
 
 ibis::table* ibis::mensa::select(const char* sel, const char* cond) const {
+    ibis::workload::capture cap("select");
+    if (cap.active()) { // record the call and its result
+        std::string pnames;
+        for (size_t j = 0; j < parts.size(); ++ j) {
+            if (j > 0)
+                pnames += ',';
+            pnames += parts[j]->name();
+        }
+        cap.add(pnames.c_str());
+        cap.add(sel);
+        cap.add(cond);
+        ibis::table* res = ibis::mensa::select(sel, cond);
+        cap.setRows(res != 0 ? static_cast<int64_t>(res->nRows()) : -1);
+        return res;
+    }
+
     if (cond == 0 || *cond == 0 || nRows() == 0 || nColumns() == 0) {
         LOGGER(ibis::gVerbose > 0)
             << "Warning -- mensa::select requires a non-empty table "
@@ -3169,6 +3188,92 @@ int ibis::mensa::cursor::fetch(uint64_t irow, ibis::table::row& res) {
     return 0;
 } // ibis::mensa::cursor::fetch
 
+/// Fetch the values of up to @c nr rows following the current row.  The
+/// values are copied a block at a time from the buffers filled through
+/// ibis::column::selectValues, which reads the data partitions through the
+/// file manager, and the null masks are taken from the columns of each
+/// data partition.  See ibis::table::cursor::fetchBatch for a description
+/// of the arguments and the return value.
+int64_t ibis::mensa::cursor::fetchBatch(uint64_t nr,
+                                        ibis::table::bufferArray& buf,
+                                        std::vector<ibis::bitvector>& valid) {
+    const ibis::table::typeArray tps = columnTypes();
+    int ierr = prepareBatch(tps, nr, buf, valid);
+    if (ierr < 0) return ierr;
+
+    uint64_t cnt = 0;
+    ibis::bitvector msk;
+    while (cnt < nr) {
+        // move to the next row, fetch reads the next block when necessary
+        ierr = fetch();
+        if (ierr < 0) {
+            if (curPart < tab.parts.size() && cnt == 0)
+                return ierr;
+            break;
+        }
+
+        uint64_t nb = bEnd - curRow;
+        if (nb > nr - cnt)
+            nb = nr - cnt;
+        const ibis::part& apart = *(tab.parts[curPart]);
+        const uint64_t prow = curRow - pBegin; // position in the partition
+        for (uint32_t j = 0; j < tps.size() && j < buffer.size(); ++ j) {
+            if (buf[j] == 0) {
+                valid[j].appendFill(0, static_cast<ibis::bitvector::word_t>
+                                    (nb));
+                continue;
+            }
+
+            const ibis::column* col = apart.getColumn(buffer[j].cname);
+            if (col == 0 || col->type() != tps[j] || buffer[j].cval == 0) {
+                // missing in this partition
+                appendBatch(tps[j], 0, 0, nb, buf[j]);
+                valid[j].appendFill(0, static_cast<ibis::bitvector::word_t>
+                                    (nb));
+                continue;
+            }
+
+            switch (tps[j]) {
+            case ibis::TEXT:
+            case ibis::CATEGORY: {
+                // the buffer holds the column object, not the strings
+                ibis::bitvector rng;
+                rng.appendFill(0, static_cast<ibis::bitvector::word_t>(prow));
+                rng.appendFill(1, static_cast<ibis::bitvector::word_t>(nb));
+                rng.adjustSize(0, apart.nRows());
+                std::unique_ptr< std::vector<std::string> >
+                    strs(col->selectStrings(rng));
+                appendBatch(tps[j], strs.get(), 0, nb, buf[j]);
+                break;}
+            case ibis::OID: {
+                // fillBuffer stores the OIDs as unsigned integers
+                const ibis::array_t<uint64_t>& src =
+                    *static_cast<const ibis::array_t<uint64_t>*>
+                    (buffer[j].cval);
+                ibis::array_t<ibis::rid_t>& out =
+                    *static_cast<ibis::array_t<ibis::rid_t>*>(buf[j]);
+                for (uint64_t i = curRow - bBegin;
+                     i < curRow - bBegin + nb; ++ i) {
+                    ibis::rid_t tmp;
+                    tmp.value = (i < src.size() ? src[i] : 0);
+                    out.push_back(tmp);
+                }
+                break;}
+            default:
+                appendBatch(tps[j], buffer[j].cval, curRow - bBegin, nb,
+                            buf[j]);
+                break;
+            }
+            col->getNullMask(msk);
+            appendValid(msk, prow, nb, valid[j]);
+        }
+
+        curRow += nb - 1;
+        cnt += nb;
+    }
+    return cnt;
+} // ibis::mensa::cursor::fetchBatch
+
 void ibis::mensa::cursor::fillRow(ibis::table::row& res) const {
     res.clear();
     const uint32_t il = static_cast<uint32_t>(curRow - bBegin);
@@ -4759,6 +4864,7 @@ int64_t ibis::table::computeHits(const ibis::constPartList& pts,
 
     int ierr;
     uint64_t nhits = 0;
+    ibis::profile::phase ph("count(*)", 0);
     ibis::countQuery qq;
     ierr = qq.setWhereClause(cond);
     if (ierr < 0)
@@ -4779,6 +4885,7 @@ int64_t ibis::table::computeHits(const ibis::constPartList& pts,
                  << ", query::evaluate returned " << ierr;
         }
     }
+    ph.setRows(nhits);
     return nhits;
 } // ibis::table::computeHits
 
@@ -4793,6 +4900,7 @@ int64_t ibis::table::computeHits(const ibis::constPartList& pts,
 
     int ierr;
     uint64_t nhits = 0;
+    ibis::profile::phase ph("count(*)", 0);
     ibis::countQuery qq;
     ierr = qq.setWhereClause(cond);
     if (ierr < 0)
@@ -4813,5 +4921,328 @@ int64_t ibis::table::computeHits(const ibis::constPartList& pts,
                  << ", query::evaluate returned " << ierr;
         }
     }
+    ph.setRows(nhits);
     return nhits;
 } // ibis::table::computeHits
+
+/// Append @c n values of the array @c in starting at position @c begin to
+/// the array @c out.  A nil @c in is taken as a missing column, in which
+/// case @c n zeros are appended.
+template <typename T> static void
+_ibis_table_appendBatch(const void* in, uint64_t begin, uint64_t n,
+                        void* out) {
+    ibis::array_t<T>& arr = *static_cast<ibis::array_t<T>*>(out);
+    const size_t old = arr.size();
+    arr.resize(old + n);
+    if (in == 0) {
+        std::fill(arr.begin()+old, arr.end(), T());
+        return;
+    }
+
+    const ibis::array_t<T>& src = *static_cast<const ibis::array_t<T>*>(in);
+    if (begin + n > src.size()) { // shorter than expected
+        const uint64_t nv = (begin < src.size() ? src.size() - begin : 0);
+        std::copy(src.begin()+begin, src.begin()+begin+nv, arr.begin()+old);
+        std::fill(arr.begin()+old+nv, arr.end(), T());
+    }
+    else {
+        std::copy(src.begin()+begin, src.begin()+begin+n, arr.begin()+old);
+    }
+} // _ibis_table_appendBatch
+
+/// Fetch the values of up to @c nr rows following the current row.  The
+/// values of column @c j, in the order given by @c columnTypes, are placed
+/// in @c buf[j], which is an ibis::array_t or a std::vector<std::string>
+/// as described in ibis::table::freeBuffer.  If @c buf is empty, the
+/// buffers are allocated with ibis::table::allocateBuffer and the caller
+/// is responsible for freeing them with ibis::table::freeBuffers;
+/// otherwise the existing buffers are reused.  The bit @c i of @c valid[j]
+/// is 1 if the value of column @c j in the @c ith row fetched is not
+/// null.  The columns that can not be stored in such buffers, e.g., blobs,
+/// are left as nil pointers with no valid values.
+///
+/// Upon successful completion, the last row fetched becomes the current
+/// row and the number of rows fetched is returned; a return value of 0
+/// indicates the end of the data.  A negative value is returned in case
+/// of error.
+///
+/// This implementation retrieves the values one row at a time through
+/// the functions getColumnAsTTT.  The derived classes may provide more
+/// efficient implementations.
+int64_t ibis::table::cursor::fetchBatch(uint64_t nr,
+                                        ibis::table::bufferArray& buf,
+                                        std::vector<ibis::bitvector>& valid) {
+    const ibis::table::typeArray tps = columnTypes();
+    int ierr = prepareBatch(tps, nr, buf, valid);
+    if (ierr < 0) return ierr;
+
+    uint64_t cnt = 0;
+    while (cnt < nr && fetch() >= 0) {
+        for (uint32_t j = 0; j < tps.size(); ++ j) {
+            if (buf[j] == 0) {
+                valid[j] += 0;
+                continue;
+            }
+
+            switch (tps[j]) {
+            default:
+                ierr = -1;
+                break;
+            case ibis::OID: {
+                uint64_t tmp = 0;
+                ierr = getColumnAsULong(j, tmp);
+                ibis::rid_t rid;
+                rid.value = (ierr >= 0 ? tmp : 0);
+                static_cast<array_t<ibis::rid_t>*>(buf[j])->push_back(rid);
+                break;}
+            case ibis::BYTE: {
+                char tmp = 0;
+                ierr = getColumnAsByte(j, tmp);
+                static_cast<array_t<signed char>*>(buf[j])->push_back
+                    (ierr >= 0 ? tmp : 0);
+                break;}
+            case ibis::UBYTE: {
+                unsigned char tmp = 0;
+                ierr = getColumnAsUByte(j, tmp);
+                static_cast<array_t<unsigned char>*>(buf[j])->push_back
+                    (ierr >= 0 ? tmp : 0);
+                break;}
+            case ibis::SHORT: {
+                int16_t tmp = 0;
+                ierr = getColumnAsShort(j, tmp);
+                static_cast<array_t<int16_t>*>(buf[j])->push_back
+                    (ierr >= 0 ? tmp : 0);
+                break;}
+            case ibis::USHORT: {
+                uint16_t tmp = 0;
+                ierr = getColumnAsUShort(j, tmp);
+                static_cast<array_t<uint16_t>*>(buf[j])->push_back
+                    (ierr >= 0 ? tmp : 0);
+                break;}
+            case ibis::INT: {
+                int32_t tmp = 0;
+                ierr = getColumnAsInt(j, tmp);
+                static_cast<array_t<int32_t>*>(buf[j])->push_back
+                    (ierr >= 0 ? tmp : 0);
+                break;}
+            case ibis::UINT: {
+                uint32_t tmp = 0;
+                ierr = getColumnAsUInt(j, tmp);
+                static_cast<array_t<uint32_t>*>(buf[j])->push_back
+                    (ierr >= 0 ? tmp : 0);
+                break;}
+            case ibis::LONG: {
+                int64_t tmp = 0;
+                ierr = getColumnAsLong(j, tmp);
+                static_cast<array_t<int64_t>*>(buf[j])->push_back
+                    (ierr >= 0 ? tmp : 0);
+                break;}
+            case ibis::ULONG: {
+                uint64_t tmp = 0;
+                ierr = getColumnAsULong(j, tmp);
+                static_cast<array_t<uint64_t>*>(buf[j])->push_back
+                    (ierr >= 0 ? tmp : 0);
+                break;}
+            case ibis::FLOAT: {
+                float tmp = 0;
+                ierr = getColumnAsFloat(j, tmp);
+                static_cast<array_t<float>*>(buf[j])->push_back
+                    (ierr >= 0 ? tmp : 0);
+                break;}
+            case ibis::DOUBLE: {
+                double tmp = 0;
+                ierr = getColumnAsDouble(j, tmp);
+                static_cast<array_t<double>*>(buf[j])->push_back
+                    (ierr >= 0 ? tmp : 0);
+                break;}
+            case ibis::TEXT:
+            case ibis::CATEGORY: {
+                std::vector<std::string>& strs =
+                    *static_cast<std::vector<std::string>*>(buf[j]);
+                strs.resize(strs.size()+1);
+                ierr = getColumnAsString(j, strs.back());
+                if (ierr < 0)
+                    strs.back().clear();
+                break;}
+            }
+            valid[j] += (ierr >= 0);
+        }
+        ++ cnt;
+    }
+    return cnt;
+} // ibis::table::cursor::fetchBatch
+
+/// Prepare the buffers for fetchBatch.  Allocate the buffers if @c buf is
+/// empty, otherwise check that they match the types and empty them.
+int ibis::table::cursor::prepareBatch(const ibis::table::typeArray& tps,
+                                      uint64_t nr,
+                                      ibis::table::bufferArray& buf,
+                                      std::vector<ibis::bitvector>& valid) {
+    if (nr > 0x7FFFFFFFU) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- table::cursor::fetchBatch can not fetch " << nr
+            << " rows at once, the maximum is " << 0x7FFFFFFFU;
+        return -1;
+    }
+    if (buf.empty()) {
+        buf.resize(tps.size());
+        for (uint32_t j = 0; j < tps.size(); ++ j)
+            buf[j] = ibis::table::allocateBuffer(tps[j], 0);
+    }
+    else if (buf.size() != tps.size()) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- table::cursor::fetchBatch expects " << tps.size()
+            << " buffer" << (tps.size()>1?"s":"") << ", but got "
+            << buf.size();
+        return -2;
+    }
+
+    valid.resize(tps.size());
+    for (uint32_t j = 0; j < tps.size(); ++ j) {
+        valid[j].clear();
+        if (buf[j] == 0) continue;
+
+        switch (tps[j]) {
+        default:
+            break;
+        case ibis::OID:
+            static_cast<array_t<ibis::rid_t>*>(buf[j])->clear();
+            static_cast<array_t<ibis::rid_t>*>(buf[j])->reserve(nr);
+            break;
+        case ibis::BYTE:
+            static_cast<array_t<signed char>*>(buf[j])->clear();
+            static_cast<array_t<signed char>*>(buf[j])->reserve(nr);
+            break;
+        case ibis::UBYTE:
+            static_cast<array_t<unsigned char>*>(buf[j])->clear();
+            static_cast<array_t<unsigned char>*>(buf[j])->reserve(nr);
+            break;
+        case ibis::SHORT:
+            static_cast<array_t<int16_t>*>(buf[j])->clear();
+            static_cast<array_t<int16_t>*>(buf[j])->reserve(nr);
+            break;
+        case ibis::USHORT:
+            static_cast<array_t<uint16_t>*>(buf[j])->clear();
+            static_cast<array_t<uint16_t>*>(buf[j])->reserve(nr);
+            break;
+        case ibis::INT:
+            static_cast<array_t<int32_t>*>(buf[j])->clear();
+            static_cast<array_t<int32_t>*>(buf[j])->reserve(nr);
+            break;
+        case ibis::UINT:
+            static_cast<array_t<uint32_t>*>(buf[j])->clear();
+            static_cast<array_t<uint32_t>*>(buf[j])->reserve(nr);
+            break;
+        case ibis::LONG:
+            static_cast<array_t<int64_t>*>(buf[j])->clear();
+            static_cast<array_t<int64_t>*>(buf[j])->reserve(nr);
+            break;
+        case ibis::ULONG:
+            static_cast<array_t<uint64_t>*>(buf[j])->clear();
+            static_cast<array_t<uint64_t>*>(buf[j])->reserve(nr);
+            break;
+        case ibis::FLOAT:
+            static_cast<array_t<float>*>(buf[j])->clear();
+            static_cast<array_t<float>*>(buf[j])->reserve(nr);
+            break;
+        case ibis::DOUBLE:
+            static_cast<array_t<double>*>(buf[j])->clear();
+            static_cast<array_t<double>*>(buf[j])->reserve(nr);
+            break;
+        case ibis::TEXT:
+        case ibis::CATEGORY:
+            static_cast<std::vector<std::string>*>(buf[j])->clear();
+            static_cast<std::vector<std::string>*>(buf[j])->reserve(nr);
+            break;
+        }
+    }
+    return 0;
+} // ibis::table::cursor::prepareBatch
+
+/// Append @c n values of the in-memory array @c in starting at position @c
+/// begin to the buffer @c out prepared by prepareBatch.  Both @c in and @c
+/// out must be of the type described in ibis::table::freeBuffer for the
+/// data type @c t.  A nil @c in is taken as a missing column, in which
+/// case @c n zeros or empty strings are appended.
+void ibis::table::cursor::appendBatch(ibis::TYPE_T t, const void* in,
+                                      uint64_t begin, uint64_t n,
+                                      void* out) {
+    if (out == 0 || n == 0) return;
+
+    switch (t) {
+    default:
+        break;
+    case ibis::OID:
+        _ibis_table_appendBatch<ibis::rid_t>(in, begin, n, out);
+        break;
+    case ibis::BYTE:
+        _ibis_table_appendBatch<signed char>(in, begin, n, out);
+        break;
+    case ibis::UBYTE:
+        _ibis_table_appendBatch<unsigned char>(in, begin, n, out);
+        break;
+    case ibis::SHORT:
+        _ibis_table_appendBatch<int16_t>(in, begin, n, out);
+        break;
+    case ibis::USHORT:
+        _ibis_table_appendBatch<uint16_t>(in, begin, n, out);
+        break;
+    case ibis::INT:
+        _ibis_table_appendBatch<int32_t>(in, begin, n, out);
+        break;
+    case ibis::UINT:
+        _ibis_table_appendBatch<uint32_t>(in, begin, n, out);
+        break;
+    case ibis::LONG:
+        _ibis_table_appendBatch<int64_t>(in, begin, n, out);
+        break;
+    case ibis::ULONG:
+        _ibis_table_appendBatch<uint64_t>(in, begin, n, out);
+        break;
+    case ibis::FLOAT:
+        _ibis_table_appendBatch<float>(in, begin, n, out);
+        break;
+    case ibis::DOUBLE:
+        _ibis_table_appendBatch<double>(in, begin, n, out);
+        break;
+    case ibis::TEXT:
+    case ibis::CATEGORY: {
+        std::vector<std::string>& strs =
+            *static_cast<std::vector<std::string>*>(out);
+        const size_t old = strs.size();
+        strs.resize(old + n);
+        if (in != 0) {
+            const std::vector<std::string>& src =
+                *static_cast<const std::vector<std::string>*>(in);
+            for (uint64_t i = 0; i < n && begin+i < src.size(); ++ i)
+                strs[old+i] = src[begin+i];
+        }
+        break;}
+    }
+} // ibis::table::cursor::appendBatch
+
+/// Append the bits [@c begin, @c begin+@c n) of the null mask @c mask to
+/// @c valid.  The rows beyond the end of @c mask are taken as null.
+void ibis::table::cursor::appendValid(const ibis::bitvector& mask,
+                                      uint64_t begin, uint64_t n,
+                                      ibis::bitvector& valid) {
+    if (n == 0) return;
+    if (mask.size() >= begin + n && mask.cnt() == mask.size()) {
+        valid.appendFill(1, static_cast<ibis::bitvector::word_t>(n));
+        return;
+    }
+    if (begin >= mask.size()) {
+        valid.appendFill(0, static_cast<ibis::bitvector::word_t>(n));
+        return;
+    }
+
+    const uint64_t nv = (begin + n <= mask.size() ? n : mask.size() - begin);
+    ibis::bitvector rng, tmp;
+    rng.appendFill(0, static_cast<ibis::bitvector::word_t>(begin));
+    rng.appendFill(1, static_cast<ibis::bitvector::word_t>(nv));
+    rng.adjustSize(0, mask.size());
+    mask.subset(rng, tmp);
+    valid += tmp;
+    if (nv < n)
+        valid.appendFill(0, static_cast<ibis::bitvector::word_t>(n - nv));
+} // ibis::table::cursor::appendValid
@@ -203,6 +203,9 @@ public:
     virtual int getColumnAsString(uint32_t, std::string&) const;
     virtual int getColumnAsOpaque(uint32_t, ibis::opaque&) const;
 
+    virtual int64_t fetchBatch(uint64_t, ibis::table::bufferArray&,
+                               std::vector<ibis::bitvector>&);
+
 protected:
     /// A buffer element is a minimal data structure to store a column in
     /// memory.  It only holds a pointer to the column name, therefore the
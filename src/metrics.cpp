@@ -0,0 +1,285 @@
+// File: $Id$
+// Author: John Wu <John.Wu at acm.org>
+//      Lawrence Berkeley National Laboratory
+// Copyright (c) 2007-2016 the Regents of the University of California
+//
+// This file contains the implementation of the process-wide metrics
+// defined in metrics.h and their output in the Prometheus text format.
+#include "metrics.h"    // ibis::metrics
+#include "fileManager.h"// ibis::fileManager
+#include "resultCache.h"// ibis::resultCache
+
+#include <fstream>      // std::ofstream
+#include <sstream>      // std::ostringstream
+#include <iomanip>      // std::setprecision
+#include <cstring>      // std::strcmp
+#include <stdio.h>      // rename, remove
+
+bool ibis::metrics::enabled = false;
+
+/// Turn the updating of the metrics on or off.  The values accumulated so
+/// far are kept.
+void ibis::metrics::enable(bool on) {
+    ibis::metrics::enabled = on;
+} // ibis::metrics::enable
+
+/// The mutex guarding the list of metrics.
+static pthread_mutex_t _ibis_metrics_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/// The list of metrics in the order of their registration.  It is a
+/// function-local static so that metrics defined in other files may
+/// register during the static initialization.
+static std::vector<const ibis::metrics::metric*>& _ibis_metrics_list() {
+    static std::vector<const ibis::metrics::metric*> lst;
+    return lst;
+} // _ibis_metrics_list
+
+/// Constructor.  Register the metric.
+ibis::metrics::metric::metric(const char* n, const char* h, const char* l)
+    : name_(n), help_(h), labels_(l) {
+    ibis::util::mutexLock lck(&_ibis_metrics_lock, "metrics::metric");
+    _ibis_metrics_list().push_back(this);
+} // ibis::metrics::metric::metric
+
+/// Destructor.  Remove the metric from the registry.
+ibis::metrics::metric::~metric() {
+    ibis::util::mutexLock lck(&_ibis_metrics_lock, "metrics::~metric");
+    std::vector<const metric*>& lst = _ibis_metrics_list();
+    for (size_t j = 0; j < lst.size(); ++ j) {
+        if (lst[j] == this) {
+            lst.erase(lst.begin()+j);
+            break;
+        }
+    }
+} // ibis::metrics::metric::~metric
+
+/// Print the name of a sample with the given suffix and labels.  The
+/// argument @c extra is an additional label, such as the upper bound of
+/// a histogram bucket.
+void ibis::metrics::metric::printName(std::ostream& out, const char* suffix,
+                                      const char* extra) const {
+    out << name_;
+    if (suffix != 0)
+        out << suffix;
+    const bool hasl = (labels_ != 0 && *labels_ != 0);
+    const bool hase = (extra != 0 && *extra != 0);
+    if (hasl || hase) {
+        out << '{';
+        if (hasl)
+            out << labels_;
+        if (hasl && hase)
+            out << ',';
+        if (hase)
+            out << extra;
+        out << '}';
+    }
+} // ibis::metrics::metric::printName
+
+void ibis::metrics::counter::print(std::ostream& out) const {
+    printName(out, "_total");
+    out << ' ' << val() << '\n';
+} // ibis::metrics::counter::print
+
+void ibis::metrics::gauge::print(std::ostream& out) const {
+    printName(out, 0);
+    out << ' ' << value() << '\n';
+} // ibis::metrics::gauge::print
+
+/// The default upper bounds of the histogram buckets, in seconds.
+static const double _ibis_metrics_bounds[] = {
+    1e-5, 1e-4, 1e-3, 1e-2, 0.1, 1.0, 10.0
+};
+
+/// Constructor.  Use the default buckets meant for latencies in seconds,
+/// from 10 microseconds to 10 seconds.
+ibis::metrics::histogram::histogram(const char* n, const char* h,
+                                    const char* l)
+    : metric(n, h, l),
+      bounds(_ibis_metrics_bounds, _ibis_metrics_bounds +
+             sizeof(_ibis_metrics_bounds)/sizeof(double)),
+      buckets(new ibis::util::sharedInt64[bounds.size()]) {
+} // ibis::metrics::histogram::histogram
+
+/// Constructor.  The upper bounds @c b of the @c nb buckets must be in
+/// ascending order.  A bucket for the values above the last bound is
+/// always present.
+ibis::metrics::histogram::histogram(const char* n, const char* h,
+                                    const double* b, unsigned nb,
+                                    const char* l)
+    : metric(n, h, l), bounds(b, b+nb),
+      buckets(new ibis::util::sharedInt64[nb > 0 ? nb : 1]) {
+} // ibis::metrics::histogram::histogram
+
+ibis::metrics::histogram::~histogram() {
+    delete [] buckets;
+} // ibis::metrics::histogram::~histogram
+
+/// Count the value in the first bucket whose upper bound is not less than
+/// @c v.  The buckets are not cumulative until they are printed.
+void ibis::metrics::histogram::record(double v) {
+    size_t j = 0;
+    while (j < bounds.size() && v > bounds[j])
+        ++ j;
+    if (j < bounds.size())
+        ++ buckets[j];
+    ++ cnt;
+    if (v > 0.0)
+        tot += static_cast<uint64_t>(v * 1e9);
+} // ibis::metrics::histogram::record
+
+void ibis::metrics::histogram::print(std::ostream& out) const {
+    uint64_t acc = 0;
+    for (size_t j = 0; j < bounds.size(); ++ j) {
+        std::ostringstream le;
+        le << "le=\"" << bounds[j] << '"';
+        acc += buckets[j]();
+        printName(out, "_bucket", le.str().c_str());
+        out << ' ' << acc << '\n';
+    }
+    printName(out, "_bucket", "le=\"+Inf\"");
+    out << ' ' << cnt() << '\n';
+    printName(out, "_sum");
+    out << ' ' << sum() << '\n';
+    printName(out, "_count");
+    out << ' ' << cnt() << '\n';
+} // ibis::metrics::histogram::print
+
+/// Print all metrics in the Prometheus text exposition format.  The
+/// instances of a metric with different labels are printed together
+/// under one pair of HELP and TYPE lines.
+void ibis::metrics::print(std::ostream& out) {
+    ibis::util::mutexLock lck(&_ibis_metrics_lock, "metrics::print");
+    const std::vector<const metric*>& lst = _ibis_metrics_list();
+    const std::streamsize prec = out.precision();
+    out << std::setprecision(9);
+    std::vector<bool> done(lst.size(), false);
+    for (size_t j = 0; j < lst.size(); ++ j) {
+        if (done[j]) continue;
+
+        const char* nm = lst[j]->name();
+        out << "# HELP " << nm;
+        if (std::strcmp(lst[j]->type(), "counter") == 0)
+            out << "_total";
+        out << ' ' << lst[j]->help() << "\n# TYPE " << nm;
+        if (std::strcmp(lst[j]->type(), "counter") == 0)
+            out << "_total";
+        out << ' ' << lst[j]->type() << '\n';
+        for (size_t k = j; k < lst.size(); ++ k) {
+            if (! done[k] && std::strcmp(nm, lst[k]->name()) == 0) {
+                lst[k]->print(out);
+                done[k] = true;
+            }
+        }
+    }
+    out << std::setprecision(prec);
+    out.flush();
+} // ibis::metrics::print
+
+/// Write all metrics to the named file in the Prometheus text exposition
+/// format.  The output is first written to a temporary file, which then
+/// replaces the named file, so that a reader never sees a partial file.
+/// Return 0 on success and a negative number on error.
+int ibis::metrics::write(const char* fname) {
+    if (fname == 0 || *fname == 0) return -1;
+
+    std::string tmp = fname;
+    tmp += ".tmp";
+    {
+        std::ofstream out(tmp.c_str());
+        if (! out) {
+            LOGGER(ibis::gVerbose > 0)
+                << "Warning -- metrics::write failed to open " << tmp;
+            return -2;
+        }
+        ibis::metrics::print(out);
+        if (! out) {
+            LOGGER(ibis::gVerbose > 0)
+                << "Warning -- metrics::write failed to write " << tmp;
+            out.close();
+            (void) remove(tmp.c_str());
+            return -3;
+        }
+    }
+#if defined(_WIN32) && !defined(__CYGWIN__)
+    (void) remove(fname);
+#endif
+    if (rename(tmp.c_str(), fname) != 0) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- metrics::write failed to rename " << tmp
+            << " to " << fname;
+        (void) remove(tmp.c_str());
+        return -4;
+    }
+    return 0;
+} // ibis::metrics::write
+
+static double _ibis_metrics_cacheBytes() {
+    return static_cast<double>(ibis::fileManager::bytesInUse());
+} // _ibis_metrics_cacheBytes
+
+static double _ibis_metrics_cacheLimit() {
+    return static_cast<double>(ibis::fileManager::currentCacheSize());
+} // _ibis_metrics_cacheLimit
+
+static double _ibis_metrics_resultBytes() {
+    return static_cast<double>(ibis::resultCache::bytes());
+} // _ibis_metrics_resultBytes
+
+ibis::metrics::counter ibis::metrics::fileHits
+("fastbit_file_cache_hits", "Files found in the cache of the file manager.");
+ibis::metrics::counter ibis::metrics::fileMisses
+("fastbit_file_cache_misses", "Files read into the cache of the file manager.");
+ibis::metrics::counter ibis::metrics::fileEvictions
+("fastbit_file_cache_evictions",
+ "Files unloaded from the cache of the file manager.");
+ibis::metrics::counter ibis::metrics::bytesMapped
+("fastbit_file_bytes", "Bytes brought into memory by the file manager.",
+ "method=\"mmap\"");
+ibis::metrics::counter ibis::metrics::bytesRead
+("fastbit_file_bytes", "Bytes brought into memory by the file manager.",
+ "method=\"read\"");
+static ibis::metrics::gauge _ibis_metrics_cacheBytesGauge
+("fastbit_file_cache_bytes", "Bytes in use by the file manager.",
+ _ibis_metrics_cacheBytes);
+static ibis::metrics::gauge _ibis_metrics_cacheLimitGauge
+("fastbit_file_cache_limit_bytes", "Bytes the file manager may use.",
+ _ibis_metrics_cacheLimit);
+ibis::metrics::counter ibis::metrics::bitvectorAnd
+("fastbit_bitvector_ops", "Bitwise logical operations on bitvectors.",
+ "op=\"and\"");
+ibis::metrics::counter ibis::metrics::bitvectorOr
+("fastbit_bitvector_ops", "Bitwise logical operations on bitvectors.",
+ "op=\"or\"");
+ibis::metrics::counter ibis::metrics::bitvectorXor
+("fastbit_bitvector_ops", "Bitwise logical operations on bitvectors.",
+ "op=\"xor\"");
+ibis::metrics::counter ibis::metrics::bitvectorMinus
+("fastbit_bitvector_ops", "Bitwise logical operations on bitvectors.",
+ "op=\"minus\"");
+ibis::metrics::counter ibis::metrics::indexLoads
+("fastbit_index_loads", "Indexes read or built by the columns.");
+ibis::metrics::histogram ibis::metrics::indexLoadTime
+("fastbit_index_load_seconds", "Time to read or build an index.");
+ibis::metrics::histogram ibis::metrics::estimateTime
+("fastbit_query_seconds", "Latency of the query processing steps.",
+ "phase=\"estimate\"");
+ibis::metrics::histogram ibis::metrics::evaluateTime
+("fastbit_query_seconds", "Latency of the query processing steps.",
+ "phase=\"evaluate\"");
+ibis::metrics::histogram ibis::metrics::selectTime
+("fastbit_query_seconds", "Latency of the query processing steps.",
+ "phase=\"select\"");
+ibis::metrics::histogram ibis::metrics::readLockWait
+("fastbit_part_lock_wait_seconds",
+ "Time waiting for the lock of a data partition.", "mode=\"read\"");
+ibis::metrics::histogram ibis::metrics::writeLockWait
+("fastbit_part_lock_wait_seconds",
+ "Time waiting for the lock of a data partition.", "mode=\"write\"");
+ibis::metrics::counter ibis::metrics::resultCacheHits
+("fastbit_result_cache_hits", "Answers found in the cache of query hits.");
+ibis::metrics::counter ibis::metrics::resultCacheMisses
+("fastbit_result_cache_misses",
+ "Answers not found in the cache of query hits.");
+static ibis::metrics::gauge _ibis_metrics_resultBytesGauge
+("fastbit_result_cache_bytes", "Bytes used by the cache of query hits.",
+ _ibis_metrics_resultBytes);
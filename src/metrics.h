@@ -0,0 +1,193 @@
+// File: $Id$
+// Author: John Wu <John.Wu at acm.org>
+//      Lawrence Berkeley National Laboratory
+// Copyright (c) 2007-2016 the Regents of the University of California
+#ifndef IBIS_METRICS_H
+#define IBIS_METRICS_H
+///@file
+/// A registry of process-wide metrics in the Prometheus text format.
+///
+/// The metrics are counters, gauges and histograms.  The counters and the
+/// histogram buckets are atomic integers, therefore the updates take no
+/// lock.  All updates are skipped unless the metrics are enabled, either
+/// by calling ibis::metrics::enable or by setting the parameter
+/// metrics.enable to true before calling ibis::init, which keeps the
+/// overhead to the test of a single flag when the metrics are disabled.
+///
+/// The library updates the following metrics,
+/// - fastbit_file_cache_hits_total, fastbit_file_cache_misses_total and
+///   fastbit_file_cache_evictions_total: files found in the cache of the
+///   file manager, files read into the cache and files unloaded from it;
+/// - fastbit_file_bytes_total{method="mmap"|"read"}: bytes brought into
+///   memory by the file manager;
+/// - fastbit_file_cache_bytes and fastbit_file_cache_limit_bytes: the
+///   memory in use by the file manager and its limit;
+/// - fastbit_bitvector_ops_total{op="and"|"or"|"xor"|"minus"}: bitwise
+///   logical operations on bitvectors;
+/// - fastbit_index_loads_total and fastbit_index_load_seconds: indexes
+///   read or built by the columns;
+/// - fastbit_query_seconds{phase="estimate"|"evaluate"|"select"}: the
+///   latencies of the query processing steps;
+/// - fastbit_part_lock_wait_seconds{mode="read"|"write"}: the time spent
+///   waiting for the read-write lock of a data partition.
+/// - fastbit_result_cache_hits_total, fastbit_result_cache_misses_total
+///   and fastbit_result_cache_bytes: the answers found in the cache of
+///   query hits, the answers not found and the memory used by the cache.
+#include "util.h"       // ibis::util
+#include "horometer.h"  // ibis::horometer
+
+#include <vector>       // std::vector
+
+namespace ibis {
+    /// Process-wide metrics.
+    namespace metrics {
+        /// Are the metrics being updated?  Use ibis::metrics::enable to
+        /// change it.
+        extern FASTBIT_CXX_DLLSPEC bool enabled;
+        FASTBIT_CXX_DLLSPEC void enable(bool on);
+
+        /// The common part of all metrics.  The metrics register
+        /// themselves in their constructors and are expected to live
+        /// until the end of the program.
+        class FASTBIT_CXX_DLLSPEC metric {
+        public:
+            virtual ~metric();
+            /// The name of the metric.
+            const char* name() const {return name_;}
+            /// The description of the metric.
+            const char* help() const {return help_;}
+            /// The labels of this instance of the metric, such as
+            /// <code>op="and"</code>.  May be nil.
+            const char* labels() const {return labels_;}
+            /// The type of the metric: counter, gauge or histogram.
+            virtual const char* type() const = 0;
+            /// Print the samples of the metric.
+            virtual void print(std::ostream& out) const = 0;
+
+        protected:
+            const char* name_;   ///!< Name.
+            const char* help_;   ///!< Description.
+            const char* labels_; ///!< Labels.
+
+            metric(const char* n, const char* h, const char* l);
+            void printName(std::ostream& out, const char* suffix,
+                           const char* extra=0) const;
+
+        private:
+            metric();
+            metric(const metric&);
+            metric& operator=(const metric&);
+        }; // metric
+
+        /// A monotonically increasing count.
+        class FASTBIT_CXX_DLLSPEC counter : public metric {
+        public:
+            counter(const char* n, const char* h, const char* l=0)
+                : metric(n, h, l) {}
+            /// Add @c n to the count.
+            void add(uint64_t n=1) {if (enabled) val += n;}
+            /// The current count.
+            uint64_t value() const {return val();}
+
+            virtual const char* type() const {return "counter";}
+            virtual void print(std::ostream& out) const;
+
+        private:
+            ibis::util::sharedInt64 val;
+        }; // counter
+
+        /// A value that may go up and down.  The value is obtained from
+        /// a function when the metrics are printed, therefore a gauge
+        /// costs nothing to maintain.
+        class FASTBIT_CXX_DLLSPEC gauge : public metric {
+        public:
+            gauge(const char* n, const char* h, double (*f)(),
+                  const char* l=0) : metric(n, h, l), fun(f) {}
+            /// The current value.
+            double value() const {return (fun != 0 ? fun() : 0.0);}
+
+            virtual const char* type() const {return "gauge";}
+            virtual void print(std::ostream& out) const;
+
+        private:
+            double (*fun)();
+        }; // gauge
+
+        /// A distribution of observed values, such as latencies in
+        /// seconds.  The values are counted in buckets with fixed upper
+        /// bounds.  The sum is kept in units of 1e-9.
+        class FASTBIT_CXX_DLLSPEC histogram : public metric {
+        public:
+            histogram(const char* n, const char* h, const char* l=0);
+            histogram(const char* n, const char* h, const double* b,
+                      unsigned nb, const char* l=0);
+            virtual ~histogram();
+            /// Record an observed value.
+            void observe(double v) {if (enabled) record(v);}
+            /// The number of values observed.
+            uint64_t count() const {return cnt();}
+            /// The sum of the values observed.
+            double sum() const {return 1e-9 * tot();}
+
+            virtual const char* type() const {return "histogram";}
+            virtual void print(std::ostream& out) const;
+
+        private:
+            std::vector<double> bounds;
+            ibis::util::sharedInt64* buckets;
+            ibis::util::sharedInt64 cnt;
+            ibis::util::sharedInt64 tot;
+
+            void record(double v);
+        }; // histogram
+
+        /// Observe the elapsed time of a block of code in a histogram.
+        /// When the metrics are disabled, the clock is not read.
+        class FASTBIT_CXX_DLLSPEC timer {
+        public:
+            explicit timer(histogram& h) : hist(enabled ? &h : 0) {
+                if (hist != 0) clock.start();
+            }
+            ~timer() {
+                if (hist != 0) {
+                    clock.stop();
+                    hist->observe(clock.realTime());
+                }
+            }
+
+        private:
+            histogram* hist;
+            ibis::horometer clock;
+
+            timer();
+            timer(const timer&);
+            timer& operator=(const timer&);
+        }; // timer
+
+        FASTBIT_CXX_DLLSPEC void print(std::ostream& out);
+        FASTBIT_CXX_DLLSPEC int write(const char* fname);
+
+        /// @name Metrics updated by the library.
+        //@{
+        extern FASTBIT_CXX_DLLSPEC counter fileHits;
+        extern FASTBIT_CXX_DLLSPEC counter fileMisses;
+        extern FASTBIT_CXX_DLLSPEC counter fileEvictions;
+        extern FASTBIT_CXX_DLLSPEC counter bytesMapped;
+        extern FASTBIT_CXX_DLLSPEC counter bytesRead;
+        extern FASTBIT_CXX_DLLSPEC counter bitvectorAnd;
+        extern FASTBIT_CXX_DLLSPEC counter bitvectorOr;
+        extern FASTBIT_CXX_DLLSPEC counter bitvectorXor;
+        extern FASTBIT_CXX_DLLSPEC counter bitvectorMinus;
+        extern FASTBIT_CXX_DLLSPEC counter indexLoads;
+        extern FASTBIT_CXX_DLLSPEC histogram indexLoadTime;
+        extern FASTBIT_CXX_DLLSPEC histogram estimateTime;
+        extern FASTBIT_CXX_DLLSPEC histogram evaluateTime;
+        extern FASTBIT_CXX_DLLSPEC histogram selectTime;
+        extern FASTBIT_CXX_DLLSPEC histogram readLockWait;
+        extern FASTBIT_CXX_DLLSPEC histogram writeLockWait;
+        extern FASTBIT_CXX_DLLSPEC counter resultCacheHits;
+        extern FASTBIT_CXX_DLLSPEC counter resultCacheMisses;
+        //@}
+    } // namespace metrics
+} // namespace ibis
+#endif // IBIS_METRICS_H
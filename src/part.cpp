@@ -21,6 +21,11 @@
 #include "countQuery.h" // ibis::countQuery
 #include "iroster.h"
 #include "twister.h"    // ibis::MersenneTwister
+#include "colpack.h"    // ibis::colpack
+#include "advisor.h"    // ibis::advisor
+#include "colstats.h"   // ibis::colStats
+#include "profile.h"    // ibis::profile
+#include "resultCache.h"        // ibis::resultCache
 
 #include <fstream>
 #include <sstream>      // std::ostringstream
@@ -184,6 +189,31 @@ extern "C" {
         }
     } // ibis_part_startBackup
 
+    /// This routine runs rebuildLaggingIndexes in a separated thread.
+    static void* ibis_part_rebuild_indexes(void* arg) {
+        if (arg == 0) return reinterpret_cast<void*>(-1L);
+        ibis::part* et = (ibis::part*)arg; // arg is actually a part*
+        try {
+            long ierr = et->rebuildLaggingIndexes();
+            return(reinterpret_cast<void*>(ierr < 0 ? ierr : 0L));
+        }
+        catch (const std::exception &e) {
+            et->logMessage("startIndexRebuilder", "rebuildLaggingIndexes received "
+                           "exception \"%s\"", e.what());
+            return(reinterpret_cast<void*>(-41L));
+        }
+        catch (const char* s) {
+            et->logMessage("startIndexRebuilder", "rebuildLaggingIndexes received "
+                           "exception \"%s\"", s);
+            return(reinterpret_cast<void*>(-42L));
+        }
+        catch (...) {
+            et->logMessage("startIndexRebuilder", "rebuildLaggingIndexes received "
+                           "an unexpected exception");
+            return(reinterpret_cast<void*>(-40L));
+        }
+    } // ibis_part_rebuild_indexes
+
     /// The thread function to building indexes.
     static void* ibis_part_build_indexes(void* arg) {
         if (arg == 0) return reinterpret_cast<void*>(-1L);
@@ -191,6 +221,9 @@ extern "C" {
             *(reinterpret_cast<ibis::part::indexBuilderPool*>(arg));
         const ibis::table::stringArray &opt = pool.opt;
         const char *iopt;
+        // the threads for building each index belong to this thread
+        const unsigned oldnthr = ibis::index::setBuildThreads(pool.nthr);
+        IBIS_BLOCK_GUARD(ibis::index::setBuildThreads, oldnthr);
         try {
             for (uint32_t i = pool.cnt(); i < pool.tbl.nColumns();
                  i = pool.cnt()) {
@@ -274,7 +307,7 @@ extern "C" {
 ibis::part::part(const char* name, bool ro) :
     m_name(0), m_desc(), rids(0), nEvents(0), activeDir(0),
     backupDir(0), switchTime(0), state(UNKNOWN_STATE), idxstr(0),
-    myCleaner(0), readonly(ro) {
+    myCleaner(0), readonly(ro), rebuilding(false) {
     // initialize the locks
     if (0 != pthread_mutex_init
         (&mutex, static_cast<const pthread_mutexattr_t*>(0))) {
@@ -298,7 +331,7 @@ ibis::part::part(const char* name, bool ro) :
 ibis::part::part(const std::vector<const char*> &mtags, bool ro) :
     m_name(0), m_desc(), rids(0), nEvents(0), activeDir(0),
     backupDir(0), switchTime(0), state(UNKNOWN_STATE), idxstr(0),
-    myCleaner(0), readonly(ro) {
+    myCleaner(0), readonly(ro), rebuilding(false) {
     // initialize the locks
     if (0 != pthread_mutex_init
         (&mutex, static_cast<const pthread_mutexattr_t*>(0))) {
@@ -321,7 +354,7 @@ ibis::part::part(const std::vector<const char*> &mtags, bool ro) :
 ibis::part::part(const ibis::resource::vList &mtags, bool ro) :
     m_name(0), m_desc(), rids(0), nEvents(0), activeDir(0),
     backupDir(0), switchTime(0), state(UNKNOWN_STATE), idxstr(0),
-    myCleaner(0), readonly(ro) {
+    myCleaner(0), readonly(ro), rebuilding(false) {
     // initialize the locks
     if (0 != pthread_mutex_init
         (&mutex, static_cast<const pthread_mutexattr_t*>(0))) {
@@ -356,7 +389,7 @@ ibis::part::part(const ibis::resource::vList &mtags, bool ro) :
 ibis::part::part(const char* adir, const char* bdir, bool ro) :
     m_name(0), m_desc(), rids(0), nEvents(0), activeDir(0),
     backupDir(0), switchTime(0), state(UNKNOWN_STATE), idxstr(0),
-    myCleaner(0), readonly(ro) {
+    myCleaner(0), readonly(ro), rebuilding(false) {
     (void) ibis::fileManager::instance(); // initialize the file manager
     // initialize the locks
     if (pthread_mutex_init(&mutex, 0)) {
@@ -563,6 +596,9 @@ ibis::part::part(const char* adir, const char* bdir, bool ro) :
     else { // assumed to be in stable state
         state = STABLE_STATE;
     }
+    // statistics of the values for estimating the costs of conditions
+    if (nEvents > 0)
+        (void) loadStatistics();
 
     myCleaner = new ibis::part::cleaner(this);
     ibis::fileManager::instance().addCleaner(myCleaner);
@@ -600,6 +636,10 @@ ibis::part::part(const char* adir, const char* bdir, bool ro) :
 ibis::part::~part() {
     LOGGER(ibis::gVerbose > 3 && m_name != 0)
         << "clearing data partition " << name();
+    {
+        mutexLock lock(this, "~part");
+        waitForIndexRebuilder();
+    }
     {   // make sure all read accesses have finished
         writeLock lock(this, "~part");
 
@@ -619,6 +659,7 @@ ibis::part::~part() {
     }
 
     ibis::fileManager::instance().removeCleaner(myCleaner);
+    ibis::resultCache::invalidate(*this);
     ibis::resource::clear(metaList);
     // clear the rid list and the rest
     delete rids;
@@ -1119,6 +1160,10 @@ void ibis::part::init(const char* iname) {
     myCleaner = new ibis::part::cleaner(this);
     ibis::fileManager::instance().addCleaner(myCleaner);
 
+    // statistics of the values for estimating the costs of conditions
+    if (m_name != 0 && nEvents > 0)
+        (void) loadStatistics();
+
     if (ibis::gVerbose > 0 && m_name != 0) {
         ibis::util::logger lg;
         lg() << "Constructed ";
@@ -4303,6 +4348,8 @@ long ibis::part::doScan(const ibis::qRange &cmp,
     if (columns.empty() || nEvents == 0 || cmp.colName() == 0 ||
         mask.size() == 0 || mask.cnt() == 0)
         return 0;
+    if (ibis::profile::enabled())
+        ibis::profile::countRows(mask.cnt());
 
     std::string evt = "part[";
     evt += m_name;
@@ -4323,6 +4370,63 @@ long ibis::part::doScan(const ibis::qRange &cmp,
     std::string sname;
     (void) col->dataFileName(sname);
     long ierr = 0;
+    if ((cmp.getType() == ibis::qExpr::RANGE ||
+         cmp.getType() == ibis::qExpr::DRANGE) &&
+        ibis::colpack::isPacked(sname.c_str())) {
+        // evaluate the condition on the packed data file directly
+        switch (col->type()) {
+        default: ierr = -1; break;
+        case ibis::BYTE:
+            ierr = ibis::colpack::evaluateRange<signed char>
+                (sname.c_str(), cmp, mask, hits);
+            break;
+        case ibis::UBYTE:
+            ierr = ibis::colpack::evaluateRange<unsigned char>
+                (sname.c_str(), cmp, mask, hits);
+            break;
+        case ibis::SHORT:
+            ierr = ibis::colpack::evaluateRange<int16_t>
+                (sname.c_str(), cmp, mask, hits);
+            break;
+        case ibis::USHORT:
+            ierr = ibis::colpack::evaluateRange<uint16_t>
+                (sname.c_str(), cmp, mask, hits);
+            break;
+        case ibis::INT:
+            ierr = ibis::colpack::evaluateRange<int32_t>
+                (sname.c_str(), cmp, mask, hits);
+            break;
+        case ibis::UINT:
+            ierr = ibis::colpack::evaluateRange<uint32_t>
+                (sname.c_str(), cmp, mask, hits);
+            break;
+        case ibis::LONG:
+            ierr = ibis::colpack::evaluateRange<int64_t>
+                (sname.c_str(), cmp, mask, hits);
+            break;
+        case ibis::ULONG:
+            ierr = ibis::colpack::evaluateRange<uint64_t>
+                (sname.c_str(), cmp, mask, hits);
+            break;
+        case ibis::FLOAT:
+            ierr = ibis::colpack::evaluateRange<float>
+                (sname.c_str(), cmp, mask, hits);
+            break;
+        case ibis::DOUBLE:
+            ierr = ibis::colpack::evaluateRange<double>
+                (sname.c_str(), cmp, mask, hits);
+            break;
+        }
+        if (ierr >= 0) {
+            LOGGER(ibis::gVerbose > 7)
+                << evt << " examined " << mask.cnt() << " candidates in "
+                "packed data file " << sname << " and found " << ierr
+                << " hits";
+            return ierr;
+        }
+        ierr = 0;
+    }
+
     switch (col->type()) {
     default:
         LOGGER(ibis::gVerbose > 0)
@@ -4688,6 +4792,8 @@ long ibis::part::doScan(const ibis::qRange &cmp,
     if (columns.empty() || nEvents == 0 || cmp.colName() == 0 ||
         mask.size() == 0 || mask.cnt() == 0)
         return 0;
+    if (ibis::profile::enabled())
+        ibis::profile::countRows(mask.cnt());
 
     std::string evt = "part[";
     evt += m_name;
@@ -5007,6 +5113,8 @@ long ibis::part::doScan(const ibis::qRange &cmp,
     if (columns.empty() || nEvents == 0 || cmp.colName() == 0 ||
         mask.size() == 0 || mask.cnt() == 0)
         return 0;
+    if (ibis::profile::enabled())
+        ibis::profile::countRows(mask.cnt());
 
     std::string evt = "part[";
     evt += m_name;
@@ -6002,6 +6110,8 @@ long ibis::part::doScan(const ibis::compRange &cmp,
                         ibis::bitvector &hits) const {
     if (columns.empty() || nEvents == 0)
         return 0;
+    if (ibis::profile::enabled())
+        ibis::profile::countRows(mask.cnt());
 
     ibis::horometer timer;
     if (ibis::gVerbose > 3) {
@@ -6495,20 +6605,47 @@ void ibis::part::buildSorted(const char* cname) const {
 /// Make sure indexes for all columns are available.
 /// May use @c nthr threads to build indexes.  The argument iopt is used to
 /// build new indexes if the corresponding columns do not already have
-/// indexes.
+/// indexes.  If iopt is "advise", or the parameter
+/// <partition-name>.adviseIndexes or adviseIndexes is true, the index
+/// specifications are first chosen with ibis::part::adviseIndexes.  The
+/// columns are handed out to the threads one at a time.  If there are
+/// more threads than columns, each index is built with
+/// nthr/nColumns() threads working on segments of rows, see
+/// ibis::index::buildThreads.
 /// @sa ibis::part::loadIndexes
 int ibis::part::buildIndexes(const char* iopt, int nthr) {
     std::string evt = "part[";
     evt += m_name;
     evt += "]::buildIndexes";
+    if (iopt != 0 && stricmp(iopt, "advise") == 0) {
+        (void) adviseIndexes();
+        iopt = 0;
+    }
+    else {
+        std::string key = m_name;
+        key += ".adviseIndexes";
+        if (ibis::gParameters().isTrue(key.c_str()) ||
+            ibis::gParameters().isTrue("adviseIndexes")) {
+            (void) adviseIndexes(iopt);
+            iopt = 0;
+        }
+    }
     readLock lock(this, evt.c_str());
     ibis::horometer timer;
     timer.start();
     LOGGER(ibis::gVerbose > 5)
         << evt << " -- starting ...";
+    // hand the threads beyond one per column to the individual indexes,
+    // which build their bitmaps on segments of rows concurrently
+    unsigned nsub = 0;
+    if (nthr > (int)nColumns() && nColumns() > 0) {
+        nsub = nthr / nColumns();
+        nthr = nColumns();
+    }
     if (nthr > 1) {
         -- nthr; // spawn one less thread than specified
         indexBuilderPool pool(*this, iopt);
+        pool.nthr = nsub;
         std::vector<pthread_t> tid(nthr);
         pthread_attr_t tattr;
         int ierr = pthread_attr_init(&tattr);
@@ -6576,6 +6713,7 @@ int ibis::part::buildIndexes(const char* iopt, int nthr) {
     }
     else { // do not spawn any new threads
         indexBuilderPool pool(*this, iopt);
+        pool.nthr = nsub;
         (void) ibis_part_build_indexes((void*)&pool);
         nthr = 1; // used only this thread
     }
@@ -6626,7 +6764,8 @@ int ibis::part::buildIndexes(const char* iopt, int nthr) {
 ///
 /// May use @c nthr threads to build indexes.  The argument iopt is used to
 /// build new indexes if the corresponding columns do not already have
-/// indexes.
+/// indexes.  The threads beyond one per column are used to build the
+/// individual indexes as in the other version of this function.
 ///
 /// @sa ibis::part::loadIndexes
 int ibis::part::buildIndexes(const ibis::table::stringArray &iopt, int nthr) {
@@ -6638,9 +6777,17 @@ int ibis::part::buildIndexes(const ibis::table::stringArray &iopt, int nthr) {
     timer.start();
     LOGGER(ibis::gVerbose > 5)
         << evt << " -- starting ...";
+    // hand the threads beyond one per column to the individual indexes,
+    // which build their bitmaps on segments of rows concurrently
+    unsigned nsub = 0;
+    if (nthr > (int)nColumns() && nColumns() > 0) {
+        nsub = nthr / nColumns();
+        nthr = nColumns();
+    }
     if (nthr > 1) {
         -- nthr; // spawn one less thread than specified
         indexBuilderPool pool(*this, iopt);
+        pool.nthr = nsub;
         std::vector<pthread_t> tid(nthr);
         pthread_attr_t tattr;
         int ierr = pthread_attr_init(&tattr);
@@ -6705,6 +6852,7 @@ int ibis::part::buildIndexes(const ibis::table::stringArray &iopt, int nthr) {
     }
     else { // do not spawn any new threads
         indexBuilderPool pool(*this, iopt);
+        pool.nthr = nsub;
         (void) ibis_part_build_indexes((void*)&pool);
         nthr = 1; // used only this thread
     }
@@ -6852,6 +7000,378 @@ void ibis::part::purgeIndexFiles() const {
     }
 } // ibis::part::purgeIndexFiles
 
+/// Rebuild the indexes that lag behind the data.  An index that could
+/// not be extended during an append operation only covers the rows that
+/// were present before the append, the rows after them are scanned when
+/// answering queries.  This function rebuilds each such index from all
+/// rows once the rows not covered exceed @c frac of all rows.  The old
+/// bitmaps are not reused, the cost is the same as building a new index.
+/// If @c frac is negative, its value is taken from the parameter
+/// <partition-name>.indexRebuildFraction, which defaults to 0.1.  Columns
+/// without an index file are left alone.
+///
+/// The read lock on the data partition keeps the rows from changing
+/// while the indexes are rebuilt, and each index is replaced under the
+/// write lock of its column, see ibis::column::rebuildLaggingIndex.
+///
+/// Return the number of indexes rebuilt or a negative number to indicate
+/// error.
+long ibis::part::rebuildLaggingIndexes(double frac) const {
+    readLock lock(this, "rebuildLaggingIndexes");
+    if (activeDir == 0 || nEvents == 0)
+        return 0;
+    if (frac < 0.0) {
+        std::string pname = m_name;
+        pname += ".indexRebuildFraction";
+        frac = ibis::gParameters().getNumber(pname.c_str());
+        if (! (frac > 0.0))
+            frac = 0.1;
+    }
+
+    long ierr = 0, cnt = 0;
+    for (columnList::const_iterator it = columns.begin();
+         it != columns.end(); ++ it) {
+        long jerr = (*it).second->rebuildLaggingIndex(frac);
+        if (jerr > 0)
+            ++ cnt;
+        else if (jerr < 0)
+            ierr = jerr;
+    }
+    LOGGER(ibis::gVerbose > 3 && cnt > 0)
+        << "part[" << name() << "]::rebuildLaggingIndexes updated " << cnt
+        << " index" << (cnt > 1 ? "es" : "");
+    return (cnt > 0 || ierr == 0 ? cnt : ierr);
+} // ibis::part::rebuildLaggingIndexes
+
+/// Replace the raw data files of the fixed-size columns with packed data
+/// files.  See ibis::column::packData for details.  The packed data files
+/// are read transparently by the rest of the software.  Return the number
+/// of columns packed or a negative number to indicate error.
+long ibis::part::packData() {
+    writeLock lock(this, "packData");
+    if (activeDir == 0 || nEvents == 0)
+        return 0;
+
+    long ierr = 0, cnt = 0;
+    for (columnList::const_iterator it = columns.begin();
+         it != columns.end(); ++ it) {
+        long jerr = (*it).second->packData();
+        if (jerr > 0)
+            ++ cnt;
+        else if (jerr < 0 && jerr != -2)
+            ierr = jerr;
+    }
+    LOGGER(ibis::gVerbose > 2 && cnt > 0)
+        << "part[" << name() << "]::packData packed the data files of "
+        << cnt << " column" << (cnt > 1 ? "s" : "");
+    return (cnt > 0 || ierr == 0 ? cnt : ierr);
+} // ibis::part::packData
+
+/// Restore the raw data files of all packed columns.  Return the number
+/// of columns unpacked or a negative number to indicate error.
+long ibis::part::unpackData() {
+    writeLock lock(this, "unpackData");
+    if (activeDir == 0 || nEvents == 0)
+        return 0;
+
+    long ierr = 0, cnt = 0;
+    for (columnList::const_iterator it = columns.begin();
+         it != columns.end(); ++ it) {
+        long jerr = (*it).second->unpackData();
+        if (jerr > 0)
+            ++ cnt;
+        else if (jerr < 0)
+            ierr = jerr;
+    }
+    return (cnt > 0 || ierr == 0 ? cnt : ierr);
+} // ibis::part::unpackData
+
+/// Replace the index files of all columns with packed index files.  See
+/// ibis::column::packIndex for details.  Return the number of indexes
+/// packed or a negative number to indicate error.
+long ibis::part::packIndexes() {
+    readLock lock(this, "packIndexes");
+    if (activeDir == 0 || nEvents == 0)
+        return 0;
+
+    long ierr = 0, cnt = 0;
+    for (columnList::const_iterator it = columns.begin();
+         it != columns.end(); ++ it) {
+        long jerr = (*it).second->packIndex();
+        if (jerr > 0)
+            ++ cnt;
+        else if (jerr < 0 && jerr != -2)
+            ierr = jerr;
+    }
+    LOGGER(ibis::gVerbose > 2 && cnt > 0)
+        << "part[" << name() << "]::packIndexes packed the index files of "
+        << cnt << " column" << (cnt > 1 ? "s" : "");
+    return (cnt > 0 || ierr == 0 ? cnt : ierr);
+} // ibis::part::packIndexes
+
+/// Restore the index files of all columns with packed indexes.  Return
+/// the number of indexes unpacked or a negative number to indicate error.
+long ibis::part::unpackIndexes() {
+    readLock lock(this, "unpackIndexes");
+    if (activeDir == 0 || nEvents == 0)
+        return 0;
+
+    long ierr = 0, cnt = 0;
+    for (columnList::const_iterator it = columns.begin();
+         it != columns.end(); ++ it) {
+        long jerr = (*it).second->unpackIndex();
+        if (jerr > 0)
+            ++ cnt;
+        else if (jerr < 0)
+            ierr = jerr;
+    }
+    return (cnt > 0 || ierr == 0 ? cnt : ierr);
+} // ibis::part::unpackIndexes
+
+/// Choose the index specifications of the columns according to the
+/// conditions recorded by ibis::advisor.  A column whose recommended
+/// specification differs from its current one receives the new
+/// specification and its index files are removed, so that the next call
+/// to buildIndexes or loadIndexes builds the recommended index.  The
+/// columns without a recommendation receive the specification @c iopt if
+/// it is not empty.  Return the number of columns whose specification is
+/// changed.
+long ibis::part::adviseIndexes(const char* iopt) {
+    std::map<std::string, std::string> specs;
+    (void) ibis::advisor::advise(*this, specs);
+
+    // the index specifications and the index files are changed
+    writeLock lock(this, "adviseIndexes");
+    long cnt = 0;
+    for (columnList::const_iterator it = columns.begin();
+         it != columns.end(); ++ it) {
+        ibis::column* col = (*it).second;
+        std::map<std::string, std::string>::const_iterator sit =
+            specs.find(col->name());
+        if (sit == specs.end()) {
+            if (iopt != 0 && *iopt != 0)
+                col->indexSpec(iopt);
+            continue;
+        }
+
+        const char* old = col->indexSpec();
+        if (old != 0 && (*sit).second.compare(old) == 0)
+            continue;
+        col->indexSpec((*sit).second.c_str());
+        col->unloadIndex();
+        col->purgeIndexFile();
+        ++ cnt;
+    }
+    LOGGER(ibis::gVerbose > 1)
+        << "part[" << name() << "]::adviseIndexes changed the index "
+        "specifications of " << cnt << " column" << (cnt > 1 ? "s" : "")
+        << " out of " << specs.size() << " with recorded conditions";
+    return cnt;
+} // ibis::part::adviseIndexes
+
+/// Compute the statistics of the values of all numerical columns and
+/// store them in the file -part.stats in the active data directory.  The
+/// statistics are used to estimate the number of rows satisfying the
+/// conditions without indexes, see ibis::colStats.  The file is not
+/// written for a read-only data partition.  Return the number of columns
+/// with statistics or a negative number to indicate error.
+long ibis::part::computeStatistics() {
+    readLock lock(this, "computeStatistics");
+    if (activeDir == 0 || nEvents == 0)
+        return 0;
+
+    long cnt = 0;
+    for (columnList::iterator it = columns.begin();
+         it != columns.end(); ++ it) {
+        ibis::column* col = (*it).second;
+        if (! col->isNumeric()) continue;
+
+        ibis::colStats st;
+        if (col->computeStatistics(st, 0, nEvents) == 0) {
+            col->setStatistics(&st);
+            ++ cnt;
+        }
+    }
+    long ierr = (readonly ? 0 : writeStatistics(activeDir));
+    LOGGER(ibis::gVerbose > 2)
+        << "part[" << name() << "]::computeStatistics computed the "
+        "statistics of " << cnt << " column" << (cnt > 1 ? "s" : "");
+    return (ierr < 0 ? ierr : cnt);
+} // ibis::part::computeStatistics
+
+/// Read the statistics of the columns from the file -part.stats.  If the
+/// data partition has more rows than recorded in the file, which happens
+/// after new rows are appended, the statistics of the new rows are
+/// computed and merged with the recorded ones, and the file is updated
+/// unless the data partition is read-only.
+/// The statistics of a column missing from the file or recorded with too
+/// many rows are computed from all rows.  If the file does not exist, the
+/// statistics are only computed if the parameter
+/// <partition-name>.computeStatistics or computeStatistics is true.
+/// Return the number of columns with statistics or a negative number to
+/// indicate error.
+long ibis::part::loadStatistics() {
+    if (activeDir == 0 || nEvents == 0)
+        return 0;
+
+    std::string fnm(activeDir);
+    fnm += FASTBIT_DIRSEP;
+    fnm += "-part.stats";
+    std::map<std::string, ibis::colStats> known;
+    const off_t size = ibis::util::getFileSize(fnm.c_str());
+    if (size > 16) {
+        ibis::array_t<char> buf(size);
+        int fdes = UnixOpen(fnm.c_str(), OPEN_READONLY);
+        if (fdes < 0) {
+            LOGGER(ibis::gVerbose > 1)
+                << "Warning -- part[" << name() << "]::loadStatistics "
+                "failed to open " << fnm << " ... "
+                << (errno ? strerror(errno) : "??");
+            return -1;
+        }
+#if defined(_WIN32) && defined(_MSC_VER)
+        (void)_setmode(fdes, _O_BINARY);
+#endif
+        IBIS_BLOCK_GUARD(UnixClose, fdes);
+        if (ibis::util::read(fdes, buf.begin(), size) != (int64_t)size)
+            return -2;
+
+        const char* ptr = buf.begin();
+        const char* end = buf.end();
+        uint32_t ncols;
+        if (strncmp(ptr, "#IBISST1", 8) != 0) {
+            LOGGER(ibis::gVerbose > 1)
+                << "Warning -- part[" << name() << "]::loadStatistics "
+                "found " << fnm << " to have an unknown header";
+            return -3;
+        }
+        ptr += 8;
+        memcpy(&ncols, ptr, sizeof(ncols));
+        ptr += sizeof(ncols);
+        for (uint32_t j = 0; j < ncols; ++ j) {
+            uint32_t nch;
+            if (ptr + sizeof(nch) > end) break;
+            memcpy(&nch, ptr, sizeof(nch));
+            ptr += sizeof(nch);
+            if (ptr + nch > end) break;
+            std::string cn(ptr, nch);
+            ptr += nch;
+            if (known[cn].deserialize(ptr, end) < 0) {
+                known.erase(cn);
+                break;
+            }
+        }
+    }
+    else {
+        std::string key = m_name;
+        key += ".computeStatistics";
+        if (! ibis::gParameters().isTrue(key.c_str()) &&
+            ! ibis::gParameters().isTrue("computeStatistics"))
+            return 0;
+    }
+
+    readLock lock(this, "loadStatistics");
+    bool changed = false;
+    long cnt = 0;
+    for (columnList::iterator it = columns.begin();
+         it != columns.end(); ++ it) {
+        ibis::column* col = (*it).second;
+        if (! col->isNumeric()) continue;
+
+        std::map<std::string, ibis::colStats>::iterator sit =
+            known.find(col->name());
+        if (sit != known.end() && (*sit).second.nRows() < nEvents) {
+            // new rows since the statistics were recorded
+            ibis::colStats tail;
+            if (col->computeStatistics(tail, (*sit).second.nRows(),
+                                       nEvents) == 0) {
+                (*sit).second.merge(tail);
+                changed = true;
+            }
+            else {
+                known.erase(sit);
+                sit = known.end();
+            }
+        }
+        else if (sit == known.end() || (*sit).second.nRows() > nEvents) {
+            ibis::colStats st;
+            if (col->computeStatistics(st, 0, nEvents) == 0) {
+                known[col->name()].swap(st);
+                sit = known.find(col->name());
+                changed = true;
+            }
+            else if (sit != known.end()) {
+                known.erase(sit);
+                sit = known.end();
+            }
+        }
+        if (sit != known.end()) {
+            col->setStatistics(&((*sit).second));
+            ++ cnt;
+        }
+    }
+    if (changed && ! readonly)
+        (void) writeStatistics(activeDir);
+    LOGGER(ibis::gVerbose > 3)
+        << "part[" << name() << "]::loadStatistics "
+        << (changed ? "updated" : "loaded") << " the statistics of " << cnt
+        << " column" << (cnt > 1 ? "s" : "");
+    return cnt;
+} // ibis::part::loadStatistics
+
+/// Write the statistics of the columns to the file -part.stats in the
+/// directory @c dir.  Return the number of bytes written or a negative
+/// number to indicate error.
+long ibis::part::writeStatistics(const char* dir) const {
+    if (dir == 0 || *dir == 0)
+        return -1;
+
+    std::string buf("#IBISST1");
+    buf.append(4, '\0');
+    uint32_t ncols = 0;
+    ibis::colStats st;
+    for (columnList::const_iterator it = columns.begin();
+         it != columns.end(); ++ it) {
+        if (! (*it).second->getStatistics(st)) continue;
+        const uint32_t nch = std::strlen((*it).second->name());
+        buf.append(reinterpret_cast<const char*>(&nch), sizeof(nch));
+        buf.append((*it).second->name(), nch);
+        st.serialize(buf);
+        ++ ncols;
+    }
+    memcpy(&buf[8], &ncols, sizeof(ncols));
+
+    std::string fnm(dir);
+    fnm += FASTBIT_DIRSEP;
+    fnm += "-part.stats";
+    if (ncols == 0) {
+        (void) remove(fnm.c_str());
+        return 0;
+    }
+    int fdes = UnixOpen(fnm.c_str(), OPEN_WRITENEW, OPEN_FILEMODE);
+    if (fdes < 0) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- part[" << name() << "]::writeStatistics failed "
+            "to open " << fnm << " for writing ... "
+            << (errno ? strerror(errno) : "??");
+        return -2;
+    }
+#if defined(_WIN32) && defined(_MSC_VER)
+    (void)_setmode(fdes, _O_BINARY);
+#endif
+    IBIS_BLOCK_GUARD(UnixClose, fdes);
+    const int64_t ierr = ibis::util::write(fdes, buf.data(), buf.size());
+    if (ierr != (int64_t)buf.size()) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- part[" << name() << "]::writeStatistics expected "
+            "to write " << buf.size() << " bytes to " << fnm
+            << ", but wrote " << ierr;
+        (void) remove(fnm.c_str());
+        return -3;
+    }
+    return ierr;
+} // ibis::part::writeStatistics
+
 void ibis::part::indexSpec(const char *spec) {
     writeLock lock(this, "indexSpec");
     delete [] idxstr;
@@ -19146,6 +19666,88 @@ void ibis::part::makeBackupCopy() {
     ierr = pthread_attr_destroy(&tattr);
 } // ibis::part::makeBackupCopy
 
+/// Spawn another thread to rebuild the indexes of the active directory
+/// that lag behind the data after an append operation, see
+/// rebuildLaggingIndexes.  The thread is joined by waitForIndexRebuilder
+/// before the next change to the data partition.  The caller must hold
+/// the mutex of the data partition, which guards the thread handle.
+///
+/// The index rebuilder is off by default, see indexRebuilderOn.
+void ibis::part::startIndexRebuilder() {
+    if (activeDir == 0 || *activeDir == 0 || readonly || nEvents == 0)
+        return; // nothing to do
+
+    if (! indexRebuilderOn())
+        return;
+
+    waitForIndexRebuilder();
+    pthread_attr_t tattr;
+    int ierr = pthread_attr_init(&tattr);
+    if (ierr) {
+        logError("startIndexRebuilder", "pthread_attr_init failed with %d",
+                 ierr);
+    }
+#if defined(PTHREAD_SCOPE_SYSTEM)
+    ierr = pthread_attr_setscope(&tattr, PTHREAD_SCOPE_SYSTEM);
+    if (ierr
+#if defined(ENOTSUP)
+        && ierr != ENOTSUP
+#endif
+        ) {
+        logMessage("startIndexRebuilder", "pthread_attr_setscope could not "
+                   "set system scope (ierr = %d ... %s)", ierr,
+                   strerror(ierr));
+    }
+#endif
+
+    ierr = pthread_create(&rebuilder, &tattr, ibis_part_rebuild_indexes,
+                          (void*)this);
+    if (ierr) {
+        logWarning("startIndexRebuilder", "pthread_create could not create "
+                   "a thread to rebuild indexes, returned value is %d", ierr);
+    }
+    else {
+        rebuilding = true;
+        if (ibis::gVerbose > 1)
+            logMessage("startIndexRebuilder", "created a new thread to "
+                       "rebuild the indexes");
+    }
+    ierr = pthread_attr_destroy(&tattr);
+} // ibis::part::startIndexRebuilder
+
+/// Is the index rebuilder turned on for this data partition?  It is
+/// controlled by the parameter <partition-name>.indexRebuilder, or
+/// indexRebuilder if the former is not set, and is off by default.  When
+/// it is off, column::append removes an index it can not extend, as it
+/// did before the index rebuilder existed.
+bool ibis::part::indexRebuilderOn() const {
+    std::string pname = m_name;
+    pname += ".indexRebuilder";
+    const char *str = ibis::gParameters()[pname.c_str()];
+    return (str != 0 && *str != 0 ?
+            ibis::gParameters().isTrue(pname.c_str()) :
+            ibis::gParameters().isTrue("indexRebuilder"));
+} // ibis::part::indexRebuilderOn
+
+/// Wait for the thread started by startIndexRebuilder to finish.  The
+/// caller must hold the mutex of the data partition.
+void ibis::part::waitForIndexRebuilder() {
+    if (! rebuilding)
+        return;
+
+    void *ret;
+    int ierr = pthread_join(rebuilder, &ret);
+    rebuilding = false;
+    if (ierr != 0) {
+        logWarning("waitForIndexRebuilder", "pthread_join returned %d (%s)",
+                   ierr, strerror(ierr));
+    }
+    else if (ret != 0 && ibis::gVerbose > 1) {
+        logMessage("waitForIndexRebuilder", "the index rebuilder returned %ld",
+                   reinterpret_cast<long>(ret));
+    }
+} // ibis::part::waitForIndexRebuilder
+
 double ibis::part::getActualMin(const char *name) const {
     const ibis::column* col = getColumn(name);
     if (col != 0)
@@ -20560,7 +21162,7 @@ uint32_t ibis::part::vault::tellReal() const {
 
 ibis::part::indexBuilderPool::indexBuilderPool
 (const ibis::part &t, const ibis::table::stringArray &p)
-    : cnt(), opt(p.size()), tbl(t) {
+    : cnt(), opt(p.size()), tbl(t), nthr(0) {
     for (size_t j = 0; j < p.size(); ++ j)
         opt[j] = p[j];
 } // ibis::part::indexBuilderPool
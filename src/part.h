@@ -12,6 +12,7 @@
 #include "column.h"
 #include "resource.h"
 #include "utilidor.h"
+#include "metrics.h"
 
 #include <string>
 #include <vector>
@@ -59,6 +60,15 @@ public:
     void loadIndexes(const char* iopt=0, int ropt=0) const;
     void unloadIndexes() const;
     void purgeIndexFiles() const;
+    long rebuildLaggingIndexes(double frac=-1.0) const;
+    bool indexRebuilderOn() const;
+    long packData();
+    long unpackData();
+    long packIndexes();
+    long unpackIndexes();
+    long adviseIndexes(const char* iopt=0);
+    long computeStatistics();
+    long loadStatistics();
 
     /// Return the name of the partition.
     const char* name()		const {return (m_name?m_name:"?");}
@@ -653,8 +663,9 @@ public:
 	ibis::util::counter cnt;
 	ibis::table::stringArray opt;
 	const part &tbl;
+	unsigned nthr; ///!< Number of threads for building each index.
 	indexBuilderPool(const part &t, const char* spec)
-	    : cnt(), tbl(t) {opt.push_back(spec);}
+	    : cnt(), tbl(t), nthr(0) {opt.push_back(spec);}
 	indexBuilderPool(const part&, const ibis::table::stringArray&);
     };
 
@@ -699,9 +710,9 @@ public:
 			    const std::vector<ibis::opaque>& opq,
 			    ibis::bitvector& totmask,
 			    const ibis::bitvector& newmask);
-    int gainReadAccess() const;
+    int gainReadAccess(const char* mesg=0) const;
     int releaseAccess() const;
-    int gainWriteAccess() const;
+    int gainWriteAccess(const char* mesg=0) const;
     int tryWriteAccess() const;
     ///@}
     class barrel;
@@ -742,6 +753,8 @@ protected:
 
     ibis::part::cleaner* myCleaner;	///!< The cleaner for the file manager.
     bool readonly;			///!< Don't change the data.
+    bool rebuilding;			///!< The index rebuilder is running.
+    pthread_t rebuilder;		///!< The thread rebuilding indexes.
 
 
     /******************************************************************/
@@ -752,6 +765,8 @@ protected:
     /// Write metadata file -part.txt.
     void writeMetaData(const uint32_t nrows, const columnList &plist,
 		       const char* dir) const;
+    /// Write the statistics of the columns to file -part.stats.
+    long writeStatistics(const char* dir) const;
     void readRIDs() const; ///!< Read RIDs from file 'rids'.
     void freeRIDs() const; ///!< Remove the rids list from memory.
 
@@ -771,6 +786,8 @@ protected:
     void logError(const char* event, const char* fmt, ...) const;
 
     void makeBackupCopy(); // copy the content of activeDir to backupDir
+    void startIndexRebuilder(); // rebuild lagging indexes in background
+    void waitForIndexRebuilder(); // join the index rebuilder thread
     long verifyBackupDir(); // minimal consistency check
     void deriveBackupDirName();
     long appendToBackup(const char* dir); // append to the backup directory
@@ -1478,7 +1495,7 @@ private:
 class ibis::part::readLock {
 public:
     readLock(const part* tbl, const char* m) : thePart(tbl), mesg(m) {
-	int ierr = tbl->gainReadAccess();
+	int ierr = tbl->gainReadAccess(m);
         if (0 != ierr) {
             LOGGER(ibis::gVerbose > 0)
                 << "Warning -- part[" << thePart->name()
@@ -1519,7 +1536,7 @@ private:
 class ibis::part::writeLock {
 public:
     writeLock(const part* tbl, const char* m) : thePart(tbl), mesg(m) {
-	int ierr = tbl->gainWriteAccess();
+	int ierr = tbl->gainWriteAccess(m);
         if (0 != ierr) {
             LOGGER(ibis::gVerbose >= 0)
                 << "Warning -- part[" << thePart->name()
@@ -1588,7 +1605,10 @@ public:
 	if (ibis::gVerbose > 9)
 	    tbl->logMessage("gainExclusiveAccess",
 			    "pthread_mutex_lock for %s", m);
-	int ierr = pthread_mutex_lock(&(tbl->mutex));
+	int ierr = (ibis::util::lockStats::enabled ?
+		    ibis::util::lockStats::lock(&(tbl->mutex), "part::mutexLock",
+						m) :
+		    pthread_mutex_lock(&(tbl->mutex)));
 	if (0 != ierr)
 	    tbl->logWarning("gainExclusiveAccess", "pthread_mutex_lock for %s "
 			    "returned %d (%s)", m, ierr, strerror(ierr));
@@ -1597,6 +1617,8 @@ public:
 	if (ibis::gVerbose > 9)
 	    thePart->logMessage("releaseExclusiveAccess",
 				"pthread_mutex_unlock for %s", mesg);
+	if (ibis::util::lockStats::enabled)
+	    ibis::util::lockStats::release(&(thePart->mutex));
 	int ierr = pthread_mutex_unlock(&(thePart->mutex));
 	if (0 != ierr)
 	    thePart->logWarning("releaseExclusiveAccess",
@@ -1826,21 +1848,41 @@ inline int64_t ibis::part::evaluateJoin
 /// simple wrap over pthread_rwlock_unlock.  Returns the return value of
 /// pthread_rwlock_unlock.
 inline int ibis::part::releaseAccess() const {
+    if (ibis::util::lockStats::enabled)
+        ibis::util::lockStats::release(&rwlock);
     return pthread_rwlock_unlock(&rwlock);
 } // ibis::part::releaseAccess
 
 /// Attempt to gain a read access to this part object.  A simple wrap over
 /// pthread_rwlock_rdlock.  Returns the return value of
-/// pthread_rwlock_rdlock.
-inline int ibis::part::gainReadAccess() const {
-    return pthread_rwlock_rdlock(&rwlock);
+/// pthread_rwlock_rdlock.  When the metrics or the lock statistics are
+/// enabled, the time spent waiting is recorded, the lock statistics under
+/// the purpose @c mesg.
+inline int ibis::part::gainReadAccess(const char* mesg) const {
+    if (! ibis::metrics::enabled && ! ibis::util::lockStats::enabled)
+        return pthread_rwlock_rdlock(&rwlock);
+
+    double wait;
+    int ierr = ibis::util::lockStats::rdlock(&rwlock, "part::readLock",
+                                             mesg, wait);
+    ibis::metrics::readLockWait.observe(wait);
+    return ierr;
 } // ibis::part::gainReadAccess
 
 /// Attempt to gain a write access to this part object.  A simple wrap over
 /// pthread_rwlock_wrlock.  Returns the return value of
-/// pthread_rwlock_wrlock.
-inline int ibis::part::gainWriteAccess() const {
-    return pthread_rwlock_wrlock(&rwlock);
+/// pthread_rwlock_wrlock.  When the metrics or the lock statistics are
+/// enabled, the time spent waiting is recorded, the lock statistics under
+/// the purpose @c mesg.
+inline int ibis::part::gainWriteAccess(const char* mesg) const {
+    if (! ibis::metrics::enabled && ! ibis::util::lockStats::enabled)
+        return pthread_rwlock_wrlock(&rwlock);
+
+    double wait;
+    int ierr = ibis::util::lockStats::wrlock(&rwlock, "part::writeLock",
+                                             mesg, wait);
+    ibis::metrics::writeLockWait.observe(wait);
+    return ierr;
 } // ibis::part::gainWriteAccess
 
 /// A soft attempt to gain a write access to this part object.  A simple
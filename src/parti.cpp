@@ -10,6 +10,7 @@
 #include "part.h"       // ibis::part definition, ibis header files
 #include "category.h"
 #include "selectClause.h"       // for parsing arithmetic expressions
+#include "resultCache.h"        // ibis::resultCache
 
 #include <sstream>      // std::ostringstream
 #include <typeinfo>     // typeid
@@ -187,6 +188,7 @@ long ibis::part::reorder(const ibis::table::stringArray& names,
         << evt << " start sorting ...";
 
     writeLock lock(this, evt.c_str()); // can't process other operations
+    ibis::resultCache::invalidate(*this);
     for (columnList::const_iterator it = columns.begin();
          it != columns.end();
          ++ it) { // purge all index files
@@ -722,6 +724,7 @@ long ibis::part::append(const char* dir) {
     evt += ')';
     ibis::util::mutexLock lock(&mutex, evt.c_str());
     ibis::util::timer mytimer(evt.c_str());
+    waitForIndexRebuilder();
     // can only do this in RECEIVING state and have received something
     if (state == STABLE_STATE)
         state = RECEIVING_STATE;
@@ -740,6 +743,8 @@ long ibis::part::append(const char* dir) {
         else {
             //ibis::fileManager::instance().flushDir(activeDir);
             ierr = append1(dir);
+            if (ierr > 0 && state == STABLE_STATE)
+                startIndexRebuilder();
         }
     }
     catch (const char* s) { // revert to previous state
@@ -760,6 +765,10 @@ long ibis::part::append(const char* dir) {
         throw; // can not handle unknown error -- rethrow exception
     }
 
+    if (ierr != 0) // the cached answers are no longer valid
+        ibis::resultCache::invalidate(*this);
+    if (ierr > 0) // bring the statistics up to date with the new rows
+        (void) loadStatistics();
     return ierr;
 } // ibis::part::append
 
@@ -989,10 +998,12 @@ long ibis::part::rollback() {
     ibis::util::mutexLock lock(&mutex, "part::rollback");
     if (state != TRANSITION_STATE)
         return ierr;
+    waitForIndexRebuilder();
 
     try {
         // process no more queries, clear RID list, close all open files
         writeLock rw(this, "rollback");
+        ibis::resultCache::invalidate(*this);
         unloadIndexes();        // remove all indices
         delete rids;    // remove the RID list
         rids = 0;
@@ -1100,6 +1111,8 @@ long ibis::part::commit(const char* dir) {
     }
 
     ibis::util::mutexLock lock(&mutex, "part::commit");
+    waitForIndexRebuilder();
+    ibis::resultCache::invalidate(*this);
     try {
         ierr = appendToBackup(dir); // make the backup copy
         state = POSTTRANSITION_STATE;
@@ -1121,6 +1134,7 @@ long ibis::part::commit(const char* dir) {
             LOGGER(ibis::gVerbose > 0)
                 << "part[" << name() << "]::commit -- successfully "
                 "integrated new data from " << dir << ", nrows=" << nEvents;
+            startIndexRebuilder();
         }
         else {
             logWarning("commit", "failed to integrate new data into "
@@ -1360,6 +1374,7 @@ long ibis::part::deactivate(const ibis::bitvector& rows) {
     mskfile += "-part.msk";
 
     writeLock lock(this, "deactivate");
+    ibis::resultCache::invalidate(*this);
     amask.adjustSize(rows.size(), rows.size());
     amask -= rows;
     if (amask.cnt() < amask.size()) {
@@ -1385,6 +1400,7 @@ long ibis::part::reactivate(const ibis::bitvector& rows) {
     mskfile += "-part.msk";
 
     writeLock lock(this, "reactivate");
+    ibis::resultCache::invalidate(*this);
     amask.adjustSize(rows.size(), rows.size());
     amask |= rows;
     if (amask.cnt() < amask.size())
@@ -1533,6 +1549,7 @@ long ibis::part::purgeInactive() {
             writeMetaData(amask.cnt(), columns, backupDir);
 
             writeLock rw(this, "purgeInactive");
+            ibis::resultCache::invalidate(*this);
             delete rids;        // remove the RID list
             rids = 0;
             ibis::fileManager::instance().flushDir(activeDir);
@@ -1563,6 +1580,7 @@ long ibis::part::purgeInactive() {
     }
     else { // only have one directory
         writeLock lock(this, "purgeInactive");
+        ibis::resultCache::invalidate(*this);
         delete rids;    // remove the RID list
         rids = 0;
         ibis::fileManager::instance().flushDir(activeDir);
@@ -1619,6 +1637,7 @@ long ibis::part::purgeInactive() {
 void ibis::part::emptyCache() const {
     LOGGER(ibis::gVerbose > 2)
         << "part[" << name() << "]::emptyCache ...";
+    ibis::resultCache::invalidate(*this);
     unloadIndexes();
     if (myCleaner != 0)
         (*myCleaner)(); // invoke the cleaner
@@ -0,0 +1,458 @@
+// File: $Id$
+// Author: John Wu <John.Wu at acm.org>
+//      Lawrence Berkeley National Laboratory
+// Copyright (c) 2007-2016 the Regents of the University of California
+//
+// This file contains the implementation of the class
+// ibis::preparedQuery defined in preparedQuery.h.
+#include "preparedQuery.h"      // ibis::preparedQuery
+#include "query.h"              // ibis::query
+#include "countQuery.h"         // ibis::countQuery
+#include "part.h"               // ibis::part
+#include "qExpr.h"              // ibis::qExpr
+
+#include <cmath>        // ldexp
+#include <sstream>      // std::ostringstream
+#include <iomanip>      // std::setprecision
+#include <algorithm>    // std::sort
+#include <ctype.h>      // isspace, isalnum
+
+/// The number of placeholders that can be told apart by the sentinels.
+static const uint32_t _ibis_preparedQuery_max = 1048576U;
+
+/// The sentinel value standing in for the ith placeholder while the where
+/// clause is parsed and verified.  The values of the first set are large
+/// positive integers and the values of the second set are large negative
+/// integers.  Both sets increase with i, so that the conditions comparing
+/// two placeholders are simplified the same way with either set.  The
+/// sentinels are exactly representable and far apart, so that any
+/// arithmetic performed on them by the parser produces a value that is
+/// not a sentinel.
+static double _ibis_preparedQuery_sentinel(uint32_t i, uint32_t n, bool neg) {
+    if (neg)
+        return -ldexp(1.0 + ldexp((double)(n - i), -27), 51);
+    else
+        return ldexp(1.0 + ldexp((double)(i + 1), -27), 51);
+} // _ibis_preparedQuery_sentinel
+
+/// Return the placeholder represented by the value, or n if the value is
+/// not a sentinel.  With @c neg set, the sentinels of both sets are
+/// recognized.
+static uint32_t _ibis_preparedQuery_index(double x, uint32_t n, bool neg) {
+    const bool isneg = (x < 0.0);
+    if (isneg && ! neg) return n;
+    const double f = ldexp(isneg ? -x : x, -51) - 1.0;
+    if (! (f > 0.0 && f < 1.0)) return n;
+    uint32_t i = static_cast<uint32_t>(ldexp(f, 27) + 0.5);
+    if (i == 0 || i > n) return n;
+    i = (isneg ? n - i : i - 1);
+    if (_ibis_preparedQuery_sentinel(i, n, isneg) != x)
+        return n;
+    return i;
+} // _ibis_preparedQuery_index
+
+/// Replace the placeholders in @c str with the given values and place the
+/// result in @c out.  If @c vals is nil, the string is only scanned.  The
+/// question marks in quoted strings are not placeholders.  The values in
+/// @c lst are used for the placeholders in the lists of the IN operator,
+/// because the parser only accepts negative numbers in lists of three or
+/// more numbers.  Return the number of placeholders.
+static uint32_t
+_ibis_preparedQuery_substitute(const std::string& str, const double* vals,
+                               const double* lst, std::string& out) {
+    uint32_t cnt = 0;
+    char quote = 0;
+    bool inlist = false;
+    std::ostringstream oss;
+    oss << std::setprecision(17);
+    for (size_t j = 0; j < str.size(); ++ j) {
+        if (quote != 0) {
+            if (str[j] == '\\' && j+1 < str.size()) {
+                if (vals != 0) oss << str[j];
+                ++ j;
+            }
+            else if (str[j] == quote) {
+                quote = 0;
+            }
+        }
+        else if (str[j] == '\'' || str[j] == '"') {
+            quote = str[j];
+        }
+        else if (str[j] == '(') {
+            // is it preceded by the word IN?
+            size_t k = j;
+            while (k > 0 && isspace(str[k-1])) -- k;
+            inlist = (k >= 2 && (str[k-1] == 'n' || str[k-1] == 'N') &&
+                      (str[k-2] == 'i' || str[k-2] == 'I') &&
+                      (k == 2 || ! (isalnum(str[k-3]) || str[k-3] == '_')));
+        }
+        else if (str[j] == ')') {
+            inlist = false;
+        }
+        else if (str[j] == '?') {
+            if (vals != 0)
+                oss << ' ' << (inlist && lst != 0 ? lst[cnt] : vals[cnt])
+                    << ' ';
+            ++ cnt;
+            continue;
+        }
+        if (vals != 0)
+            oss << str[j];
+    }
+    if (vals != 0)
+        out = oss.str();
+    return cnt;
+} // _ibis_preparedQuery_substitute
+
+/// Print the token of a constant in the signature of a query expression.
+static void _ibis_preparedQuery_token(std::ostream& out, double x, uint32_t n,
+                                      bool neg, std::vector<uint32_t>& cnts) {
+    const uint32_t i = _ibis_preparedQuery_index(x, n, neg);
+    if (i < n) {
+        out << '?' << i;
+        ++ cnts[i];
+    }
+    else {
+        out << x;
+    }
+} // _ibis_preparedQuery_token
+
+/// Print the structure of a query expression with the sentinels replaced
+/// by the placeholders they stand for, and count the number of times each
+/// placeholder appears.  If the expressions produced with the two sets of
+/// sentinels have the same signature, the structure of the expression does
+/// not depend on the values of the placeholders.
+static void _ibis_preparedQuery_signature(std::ostream& out,
+                                          const ibis::qExpr* x, uint32_t n,
+                                          bool neg,
+                                          std::vector<uint32_t>& cnts) {
+    if (x == 0) {
+        out << "nil";
+        return;
+    }
+
+    switch (x->getType()) {
+    case ibis::qExpr::RANGE: {
+        const ibis::qContinuousRange* cr =
+            static_cast<const ibis::qContinuousRange*>(x);
+        out << "R(" << (cr->colName() ? cr->colName() : "") << ','
+            << (int)cr->leftOperator() << ',';
+        _ibis_preparedQuery_token(out, cr->leftBound(), n, neg, cnts);
+        out << ',' << (int)cr->rightOperator() << ',';
+        _ibis_preparedQuery_token(out, cr->rightBound(), n, neg, cnts);
+        out << ')';
+        break;}
+    case ibis::qExpr::DRANGE: {
+        // the sentinels sort to either end of the list, print the plain
+        // values before the placeholders
+        const ibis::qDiscreteRange* dr =
+            static_cast<const ibis::qDiscreteRange*>(x);
+        const ibis::array_t<double>& val = dr->getValues();
+        std::vector<uint32_t> ind;
+        out << "D(" << (dr->colName() ? dr->colName() : "");
+        for (size_t j = 0; j < val.size(); ++ j) {
+            const uint32_t i = _ibis_preparedQuery_index(val[j], n, neg);
+            if (i < n) {
+                ind.push_back(i);
+                ++ cnts[i];
+            }
+            else {
+                out << ',' << val[j];
+            }
+        }
+        std::sort(ind.begin(), ind.end());
+        for (size_t j = 0; j < ind.size(); ++ j)
+            out << ",?" << ind[j];
+        out << ')';
+        break;}
+    case ibis::qExpr::LOGICAL_NOT:
+    case ibis::qExpr::LOGICAL_AND:
+    case ibis::qExpr::LOGICAL_OR:
+    case ibis::qExpr::LOGICAL_XOR:
+    case ibis::qExpr::LOGICAL_MINUS: {
+        out << 'L' << (int)x->getType() << '(';
+        _ibis_preparedQuery_signature(out, x->getLeft(), n, neg, cnts);
+        out << ',';
+        _ibis_preparedQuery_signature(out, x->getRight(), n, neg, cnts);
+        out << ')';
+        break;}
+    default: {
+        out << 'X' << (int)x->getType() << '(';
+        x->printFull(out);
+        out << ')';
+        break;}
+    }
+} // _ibis_preparedQuery_signature
+
+/// Constructor.  The select clause @c sel may be nil or empty.  The where
+/// clause @c cond may contain placeholders.
+ibis::preparedQuery::preparedQuery(const char* sel, const char* cond)
+    : selstr(sel != 0 ? sel : ""),
+      condstr(cond != 0 && *cond != 0 ? cond : "1=1"),
+      nparams(0), nbound(0) {
+    std::string tmp;
+    nparams = _ibis_preparedQuery_substitute(condstr, 0, 0, tmp);
+    values.resize(nparams);
+    isbound.resize(nparams);
+    if (pthread_mutex_init(&mutex, 0) != 0)
+        throw ibis::bad_alloc("pthread_mutex_init failed in preparedQuery"
+                              IBIS_FILE_LINE);
+    LOGGER(ibis::gVerbose > 3)
+        << "preparedQuery::ctor -- where \"" << condstr << "\" with "
+        << nparams << " placeholder" << (nparams>1?"s":"");
+} // ibis::preparedQuery::preparedQuery
+
+/// Destructor.
+ibis::preparedQuery::~preparedQuery() {
+    for (planList::iterator it = plans.begin(); it != plans.end(); ++ it)
+        delete it->second;
+    pthread_mutex_destroy(&mutex);
+} // ibis::preparedQuery::~preparedQuery
+
+/// Bind the value @c v to the ith placeholder.  The placeholders are
+/// numbered from 0.  Return 0 on success and -1 if there is no such
+/// placeholder.
+int ibis::preparedQuery::bind(uint32_t i, double v) {
+    if (i >= nparams) {
+        LOGGER(ibis::gVerbose > 1)
+            << "Warning -- preparedQuery::bind can not bind placeholder " << i
+            << " because the where clause \"" << condstr << "\" has only "
+            << nparams << " placeholder" << (nparams>1?"s":"");
+        return -1;
+    }
+
+    if (! isbound[i]) {
+        isbound[i] = true;
+        ++ nbound;
+    }
+    values[i] = v;
+    return 0;
+} // ibis::preparedQuery::bind
+
+/// Forget all values bound.
+void ibis::preparedQuery::clearBindings() {
+    nbound = 0;
+    for (uint32_t i = 0; i < nparams; ++ i) {
+        isbound[i] = false;
+        values[i] = 0.0;
+    }
+} // ibis::preparedQuery::clearBindings
+
+/// The where clause with the bound values in place of the placeholders.
+std::string ibis::preparedQuery::boundWhereClause() const {
+    return substitute(values);
+} // ibis::preparedQuery::boundWhereClause
+
+/// Replace the placeholders of the where clause with the given values.
+std::string
+ibis::preparedQuery::substitute(const std::vector<double>& vals) const {
+    std::string out;
+    if (nparams == 0)
+        out = condstr;
+    else
+        (void) _ibis_preparedQuery_substitute(condstr, &vals[0], 0, out);
+    return out;
+} // ibis::preparedQuery::substitute
+
+/// Parse and verify the query on the data partition ahead of the first
+/// execution.  Return 0 if the bound values can be written directly into
+/// the verified expression, 1 if the where clause has to be parsed again
+/// with the bound values for each execution, and a negative number if the
+/// query can not be verified on the data partition.
+int ibis::preparedQuery::prepare(const ibis::part& p) {
+    const plan* pl = getPlan(p);
+    if (pl == 0) return -1;
+    if (pl->cond.empty()) return -2;
+    return (pl->direct ? 0 : 1);
+} // ibis::preparedQuery::prepare
+
+/// Find the plan for the data partition, build one if necessary.  The
+/// where clause is parsed and verified twice, with the placeholders
+/// replaced by two different sets of sentinels.  If the two expressions
+/// have the same structure and every placeholder appears exactly once,
+/// the expression with the first set of sentinels is kept as the
+/// template for the executions.
+const ibis::preparedQuery::plan*
+ibis::preparedQuery::getPlan(const ibis::part& p) {
+    ibis::util::mutexLock lock(&mutex, "preparedQuery::getPlan");
+    planList::iterator it = plans.find(&p);
+    if (it != plans.end()) {
+        if (it->second->ncols == p.nColumns() &&
+            it->second->part.compare(p.name()) == 0)
+            return it->second;
+
+        // the data partition has changed
+        delete it->second;
+        plans.erase(it);
+    }
+
+    plan* pl = new plan;
+    pl->part = p.name();
+    pl->ncols = p.nColumns();
+    plans[&p] = pl;
+    try {
+        if (! selstr.empty()) {
+            if (selstr.compare("*") == 0) {
+                pl->sel = new ibis::selectClause(p.columnNames());
+            }
+            else {
+                pl->sel = new ibis::selectClause(selstr.c_str());
+                if (pl->sel->verify(p) != 0) {
+                    delete pl->sel;
+                    pl->sel = 0;
+                }
+            }
+        }
+
+        if (nparams >= _ibis_preparedQuery_max)
+            return pl;
+
+        std::string str;
+        std::vector<double> vala(nparams+1), valb(nparams+1);
+        for (uint32_t i = 0; i < nparams; ++ i) {
+            vala[i] = _ibis_preparedQuery_sentinel(i, nparams, false);
+            valb[i] = _ibis_preparedQuery_sentinel(i, nparams, true);
+        }
+        (void) _ibis_preparedQuery_substitute(condstr, &vala[0], 0, str);
+        pl->cond.parse(str.c_str());
+        if (pl->cond.empty() || pl->cond.verify(p) != 0 ||
+            pl->cond.empty()) {
+            pl->cond.clear();
+            return pl;
+        }
+
+        (void) _ibis_preparedQuery_substitute(condstr, &valb[0], &vala[0],
+                                              str);
+        ibis::whereClause wcb;
+        wcb.parse(str.c_str());
+        if (wcb.empty() || wcb.verify(p) != 0 || wcb.empty())
+            return pl;
+
+        std::vector<uint32_t> cnta(nparams), cntb(nparams);
+        std::ostringstream siga, sigb;
+        siga << std::setprecision(17);
+        sigb << std::setprecision(17);
+        _ibis_preparedQuery_signature(siga, pl->cond.getExpr(), nparams,
+                                      false, cnta);
+        _ibis_preparedQuery_signature(sigb, wcb.getExpr(), nparams,
+                                      true, cntb);
+        pl->direct = (siga.str().compare(sigb.str()) == 0);
+        for (uint32_t i = 0; pl->direct && i < nparams; ++ i)
+            pl->direct = (cnta[i] == 1 && cntb[i] == 1);
+        LOGGER(ibis::gVerbose > 2)
+            << "preparedQuery::getPlan -- where \"" << condstr
+            << "\" on data partition " << p.name() << (pl->direct ?
+                " takes the bound values directly" :
+                " has to be parsed again with the bound values");
+    }
+    catch (...) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- preparedQuery::getPlan failed to prepare \""
+            << condstr << "\" on data partition " << p.name();
+        pl->cond.clear();
+        pl->direct = false;
+    }
+    return pl;
+} // ibis::preparedQuery::getPlan
+
+/// Replace the sentinels in the expression with the bound values.
+void ibis::preparedQuery::bindValues(ibis::qExpr* x) const {
+    if (x == 0) return;
+    switch (x->getType()) {
+    case ibis::qExpr::RANGE: {
+        ibis::qContinuousRange* cr = static_cast<ibis::qContinuousRange*>(x);
+        uint32_t i = _ibis_preparedQuery_index(cr->leftBound(), nparams,
+                                               false);
+        if (i < nparams)
+            cr->leftBound() = values[i];
+        i = _ibis_preparedQuery_index(cr->rightBound(), nparams, false);
+        if (i < nparams)
+            cr->rightBound() = values[i];
+        break;}
+    case ibis::qExpr::DRANGE: {
+        // the values are shared with the template, place the new values in
+        // a new array
+        ibis::qDiscreteRange* dr = static_cast<ibis::qDiscreteRange*>(x);
+        const ibis::array_t<double>& val = dr->getValues();
+        ibis::array_t<double> tmp;
+        tmp.reserve(val.size());
+        for (size_t j = 0; j < val.size(); ++ j) {
+            const uint32_t i = _ibis_preparedQuery_index(val[j], nparams,
+                                                         false);
+            tmp.push_back(i < nparams ? values[i] : val[j]);
+        }
+        tmp.deduplicate();
+        dr->getValues().swap(tmp);
+        break;}
+    default: {
+        bindValues(x->getLeft());
+        bindValues(x->getRight());
+        break;}
+    }
+} // ibis::preparedQuery::bindValues
+
+/// Apply the select clause and the where clause with the bound values to
+/// the query object.  The query must have a data partition for the
+/// prepared expressions to be used, otherwise the clauses are given to
+/// the query as strings.  Return 0 on success and a negative number on
+/// error, the return values of ibis::query::setWhereClause and
+/// ibis::query::setSelectClause are passed through.
+int ibis::preparedQuery::apply(ibis::query& q) {
+    if (! complete()) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- preparedQuery::apply needs values for all "
+            << nparams << " placeholder" << (nparams>1?"s":"") << ", only "
+            << nbound << (nbound>1?" are":" is") << " bound";
+        return -2;
+    }
+
+    int ierr;
+    const plan* pl = (q.partition() != 0 ? getPlan(*q.partition()) : 0);
+    if (pl != 0 && pl->direct) {
+        ibis::whereClause wc;
+        wc.setExpr(pl->cond.getExpr());
+        bindValues(wc.getExpr());
+        wc.resetString();
+        ierr = q.setWhereClause(wc);
+    }
+    else {
+        ierr = q.setWhereClause(boundWhereClause().c_str());
+    }
+    if (ierr < 0 || selstr.empty()) return ierr;
+
+    if (pl != 0 && pl->sel != 0) {
+        if (q.components().empty() ||
+            stricmp(*q.components(), *(*pl->sel)) != 0) {
+            ibis::selectClause sc(*pl->sel);
+            ierr = q.setSelectClause(sc);
+        }
+    }
+    else {
+        ierr = q.setSelectClause(selstr.c_str());
+    }
+    return ierr;
+} // ibis::preparedQuery::apply
+
+/// Apply the where clause with the bound values to the count query.  The
+/// select clause of a count query is owned by the caller, therefore it is
+/// not changed here.  Return 0 on success and a negative number on error.
+int ibis::preparedQuery::apply(ibis::countQuery& q) {
+    if (! complete()) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- preparedQuery::apply needs values for all "
+            << nparams << " placeholder" << (nparams>1?"s":"") << ", only "
+            << nbound << (nbound>1?" are":" is") << " bound";
+        return -2;
+    }
+
+    const plan* pl = (q.getPartition() != 0 ? getPlan(*q.getPartition()) : 0);
+    if (pl != 0 && pl->direct) {
+        ibis::whereClause wc;
+        wc.setExpr(pl->cond.getExpr());
+        bindValues(wc.getExpr());
+        return q.setWhereClause(wc);
+    }
+    else {
+        return q.setWhereClause(boundWhereClause().c_str());
+    }
+} // ibis::preparedQuery::apply
@@ -0,0 +1,106 @@
+// File: $Id$
+// Author: John Wu <John.Wu at acm.org>
+//      Lawrence Berkeley National Laboratory
+// Copyright (c) 2007-2016 the Regents of the University of California
+#ifndef IBIS_PREPAREDQUERY_H
+#define IBIS_PREPAREDQUERY_H
+///@file
+/// Define the class ibis::preparedQuery, a query that is parsed once and
+/// executed many times with different values.
+#include "whereClause.h"        // ibis::whereClause
+#include "selectClause.h"       // ibis::selectClause
+
+#include <map>          // std::map
+
+namespace ibis {
+    class preparedQuery;
+    class query;
+    class countQuery;
+}
+
+/// A query with placeholders that is parsed and verified once and
+/// executed many times.  The where clause may contain question marks
+/// (?) in place of the numbers in range conditions and in the lists of
+/// the IN operator, e.g.,
+/// @code
+/// ibis::preparedQuery pq("a, b", "a = ? and b between ? and ? and c in (1, ?)");
+/// pq.bind(0, 17);
+/// pq.bind(1, 0.5);
+/// pq.bind(2, 2.5);
+/// pq.bind(3, 3);
+/// ibis::query q(ibis::util::userName(), part0);
+/// pq.apply(q);
+/// q.evaluate();
+/// @endcode
+/// The placeholders are numbered from 0 in the order they appear in the
+/// where clause.  A question mark inside a quoted string is not a
+/// placeholder.
+///
+/// The query conditions are parsed, simplified and verified once for
+/// each data partition, and the resulting expression tree and select
+/// clause are kept in this object.  Each call to apply copies the tree
+/// and writes the bound values into it.  When the structure of the
+/// expression tree depends on the values of the placeholders, for
+/// example, when the parser merges two range conditions on the same
+/// column, or when a placeholder is used in an arithmetic expression, the
+/// bound values are written into the where clause string, which is then
+/// parsed as usual.  The result is the same either way.
+///
+/// The functions of this class may be called from multiple threads, but
+/// the values bound are shared by all threads.
+class FASTBIT_CXX_DLLSPEC ibis::preparedQuery {
+public:
+    preparedQuery(const char* sel, const char* cond);
+    ~preparedQuery();
+
+    /// The number of placeholders in the where clause.
+    uint32_t nParameters() const {return nparams;}
+    int bind(uint32_t i, double v);
+    void clearBindings();
+    /// Have all placeholders been bound?
+    bool complete() const {return nbound == nparams;}
+
+    /// The select clause.
+    const char* getSelectClause() const {return selstr.c_str();}
+    /// The where clause with the placeholders.
+    const char* getWhereClause() const {return condstr.c_str();}
+    std::string boundWhereClause() const;
+
+    int prepare(const ibis::part& p);
+    int apply(ibis::query& q);
+    int apply(ibis::countQuery& q);
+
+protected:
+    /// The where clause and the select clause verified on a data
+    /// partition.
+    struct plan {
+        ibis::whereClause cond;   ///!< The where clause with sentinels.
+        ibis::selectClause* sel;  ///!< The select clause, may be nil.
+        std::string part;         ///!< The name of the data partition.
+        uint32_t ncols;           ///!< The number of columns.
+        bool direct;              ///!< Can the values be written to cond?
+
+        plan() : sel(0), ncols(0), direct(false) {}
+        ~plan() {delete sel;}
+    }; // plan
+    typedef std::map<const ibis::part*, plan*> planList;
+
+    std::string selstr;         ///!< The select clause.
+    std::string condstr;        ///!< The where clause with placeholders.
+    uint32_t nparams;           ///!< The number of placeholders.
+    uint32_t nbound;            ///!< The number of placeholders bound.
+    std::vector<double> values; ///!< The bound values.
+    std::vector<bool> isbound;  ///!< Is a placeholder bound?
+    planList plans;             ///!< The plans for the data partitions.
+    mutable pthread_mutex_t mutex; ///!< Guards the plans.
+
+    const plan* getPlan(const ibis::part& p);
+    std::string substitute(const std::vector<double>& vals) const;
+    void bindValues(ibis::qExpr* x) const;
+
+private:
+    preparedQuery();
+    preparedQuery(const preparedQuery&);
+    preparedQuery& operator=(const preparedQuery&);
+}; // ibis::preparedQuery
+#endif // IBIS_PREPAREDQUERY_H
@@ -0,0 +1,317 @@
+// File: $Id$
+// Author: John Wu <John.Wu at acm.org>
+//      Lawrence Berkeley National Laboratory
+// Copyright (c) 2007-2016 the Regents of the University of California
+//
+// This file contains the implementation of the class ibis::profile, a
+// record of the work done to answer a query.
+#include "profile.h"    // ibis::profile
+#include "fileManager.h"// ibis::fileManager
+#include "part.h"       // ibis::part
+#include "qExpr.h"      // ibis::qExpr
+
+#include <iomanip>      // std::setprecision
+
+/// The profile active on the current thread.
+static thread_local ibis::profile* _ibis_profile_active = 0;
+/// Guards the changes to ibis::profile::nactive.
+static pthread_mutex_t _ibis_profile_mutex = PTHREAD_MUTEX_INITIALIZER;
+uint32_t volatile ibis::profile::nactive = 0;
+
+/// Free the sub-phases.
+ibis::profile::node::~node() {
+    for (size_t j = 0; j < children.size(); ++ j)
+        delete children[j];
+} // ibis::profile::node::~node
+
+/// Constructor.  The label names the root of the tree of phases.
+ibis::profile::profile(const char* label) : top(new node), cur(0) {
+    if (label != 0)
+        top->label = label;
+    cur = top;
+} // ibis::profile::profile
+
+/// Destructor.  A profile must not be destroyed while it is active.
+ibis::profile::~profile() {
+    delete top;
+} // ibis::profile::~profile
+
+/// Remove all phases recorded.  The label of the root is kept.
+void ibis::profile::clear() {
+    if (cur != top) return; // in use
+
+    std::string label = top->label;
+    delete top;
+    top = new node;
+    top->label = label;
+    cur = top;
+    tally = counters();
+} // ibis::profile::clear
+
+/// Return the profile active on the current thread, a nil pointer if there
+/// is none.
+ibis::profile* ibis::profile::current() {
+    return _ibis_profile_active;
+} // ibis::profile::current
+
+/// Record the activation of @c n bitmaps.
+void ibis::profile::countBitmaps(uint64_t n) {
+    if (_ibis_profile_active != 0)
+        _ibis_profile_active->tally.bitmaps += n;
+} // ibis::profile::countBitmaps
+
+/// Record a bitwise logical operation on operands of @c bytes bytes.
+void ibis::profile::countBitvectorOp(uint64_t bytes) {
+    if (_ibis_profile_active != 0) {
+        ++ _ibis_profile_active->tally.bitvectorOps;
+        _ibis_profile_active->tally.bitvectorBytes += bytes;
+    }
+} // ibis::profile::countBitvectorOp
+
+/// Record @c n rows checked against the raw data.
+void ibis::profile::countRows(uint64_t n) {
+    if (_ibis_profile_active != 0)
+        _ibis_profile_active->tally.rowsChecked += n;
+} // ibis::profile::countRows
+
+/// Add the difference between two snapshots of the counters to @c work.
+static void _ibis_profile_add(ibis::profile::counters& work,
+                              const ibis::profile::counters& start,
+                              const ibis::profile::counters& end,
+                              double pages) {
+    work.bitmaps += end.bitmaps - start.bitmaps;
+    work.bitvectorOps += end.bitvectorOps - start.bitvectorOps;
+    work.bitvectorBytes += end.bitvectorBytes - start.bitvectorBytes;
+    work.rowsChecked += end.rowsChecked - start.rowsChecked;
+    if (pages > 0.0)
+        work.bytesRead += static_cast<uint64_t>
+            (pages * ibis::fileManager::pageSize());
+} // _ibis_profile_add
+
+/// Make the profile @c p active on the current thread.  The time and the
+/// work done while it is active are added to the root of @c p.
+ibis::profile::activate::activate(ibis::profile& p)
+    : prof(&p), prev(_ibis_profile_active), start(p.tally),
+      pages(ibis::fileManager::instance().pageCount()) {
+    _ibis_profile_active = prof;
+    {
+        ibis::util::quietLock lock(&_ibis_profile_mutex);
+        ++ nactive;
+    }
+    timer.start();
+} // ibis::profile::activate::activate
+
+/// Restore the previously active profile.
+ibis::profile::activate::~activate() {
+    timer.stop();
+    _ibis_profile_active = prev;
+    {
+        ibis::util::quietLock lock(&_ibis_profile_mutex);
+        -- nactive;
+    }
+    prof->top->realTime += timer.realTime();
+    prof->top->cpuTime += timer.CPUTime();
+    _ibis_profile_add(prof->top->work, start, prof->tally,
+                      ibis::fileManager::instance().pageCount() - pages);
+} // ibis::profile::activate::~activate
+
+/// Start a phase.
+ibis::profile::phase::phase(const char* label)
+    : prof(_ibis_profile_active), me(0), parent(0), pages(0.0) {
+    if (prof != 0)
+        init(label != 0 ? label : "");
+} // ibis::profile::phase::phase
+
+/// Start a phase.
+ibis::profile::phase::phase(const std::string& label)
+    : prof(_ibis_profile_active), me(0), parent(0), pages(0.0) {
+    if (prof != 0)
+        init(label);
+} // ibis::profile::phase::phase
+
+/// Start a phase labeled by @c what followed by @c name, such as the name
+/// of a data partition.  The label is only formed if the phase is recorded.
+ibis::profile::phase::phase(const char* what, const char* name)
+    : prof(_ibis_profile_active), me(0), parent(0), pages(0.0) {
+    if (prof == 0) return;
+
+    std::string label = (what != 0 ? what : "");
+    if (name != 0 && *name != 0) {
+        label += ' ';
+        label += name;
+    }
+    init(label);
+} // ibis::profile::phase::phase
+
+/// Start a phase for evaluating the term of a where clause on the rows
+/// marked 1 in @c mask.  The logical operators are labeled with their
+/// names, the other terms with their string forms.  For a range condition,
+/// the access method chosen by the column is recorded.
+ibis::profile::phase::phase(const ibis::part& p, const ibis::qExpr* term,
+                            const ibis::bitvector& mask)
+    : prof(_ibis_profile_active), me(0), parent(0), pages(0.0) {
+    if (prof == 0 || term == 0) return;
+
+    const char* method = 0;
+    if (term->getType() == ibis::qExpr::RANGE ||
+        term->getType() == ibis::qExpr::DRANGE) {
+        const ibis::qRange& cmp = *static_cast<const ibis::qRange*>(term);
+        const ibis::column* col = p.getColumn(cmp.colName());
+        if (col != 0) {
+            ibis::column::accessPlan plan;
+            if (term->getType() == ibis::qExpr::DRANGE)
+                col->chooseAccess
+                    (static_cast<const ibis::qDiscreteRange&>(cmp),
+                     mask, plan);
+            else
+                col->chooseAccess
+                    (static_cast<const ibis::qContinuousRange&>(cmp),
+                     mask, plan);
+            method = ibis::column::accessPlan::name(plan.method);
+        }
+    }
+
+    switch (term->getType()) {
+    case ibis::qExpr::LOGICAL_NOT:
+        init("NOT");
+        break;
+    case ibis::qExpr::LOGICAL_AND:
+        init("AND");
+        break;
+    case ibis::qExpr::LOGICAL_OR:
+        init("OR");
+        break;
+    case ibis::qExpr::LOGICAL_XOR:
+        init("XOR");
+        break;
+    case ibis::qExpr::LOGICAL_MINUS:
+        init("AND NOT");
+        break;
+    default: {
+        std::ostringstream oss;
+        oss << *term;
+        init(oss.str());
+        break;}
+    }
+    setMethod(method);
+} // ibis::profile::phase::phase
+
+/// Add a new node under the innermost phase in progress.
+void ibis::profile::phase::init(const std::string& label) {
+    parent = prof->cur;
+    me = new node;
+    me->label = label;
+    parent->children.push_back(me);
+    prof->cur = me;
+    start = prof->tally;
+    pages = ibis::fileManager::instance().pageCount();
+    timer.start();
+} // ibis::profile::phase::init
+
+/// End the phase.  Record the time and the work done.
+ibis::profile::phase::~phase() {
+    if (me == 0) return;
+
+    timer.stop();
+    me->realTime = timer.realTime();
+    me->cpuTime = timer.CPUTime();
+    _ibis_profile_add(me->work, start, prof->tally,
+                      ibis::fileManager::instance().pageCount() - pages);
+    prof->cur = parent;
+} // ibis::profile::phase::~phase
+
+/// Print a node and its children with the given indentation.
+static void _ibis_profile_print(std::ostream& out,
+                                const ibis::profile::node& nd,
+                                unsigned lvl) {
+    for (unsigned j = 0; j < lvl; ++ j)
+        out << "  ";
+    out << (lvl > 0 ? "-> " : "") << nd.label;
+    if (! nd.method.empty())
+        out << " [" << nd.method << "]";
+    if (nd.rows >= 0)
+        out << " rows=" << nd.rows;
+    out << " (time=" << nd.realTime << "s, cpu=" << nd.cpuTime << "s";
+    if (nd.work.bytesRead > 0)
+        out << ", read=" << nd.work.bytesRead << "B";
+    if (nd.work.bitmaps > 0)
+        out << ", bitmaps=" << nd.work.bitmaps;
+    if (nd.work.bitvectorOps > 0)
+        out << ", bitvector ops=" << nd.work.bitvectorOps << " on "
+            << nd.work.bitvectorBytes << "B";
+    if (nd.work.rowsChecked > 0)
+        out << ", rows checked=" << nd.work.rowsChecked;
+    out << ")\n";
+    for (size_t j = 0; j < nd.children.size(); ++ j)
+        _ibis_profile_print(out, *(nd.children[j]), lvl+1);
+} // _ibis_profile_print
+
+/// Print the tree of phases, one phase per line, with the sub-phases
+/// indented under their parent.
+void ibis::profile::print(std::ostream& out) const {
+    const std::streamsize prec = out.precision();
+    out << std::setprecision(6);
+    _ibis_profile_print(out, *top, 0);
+    out << std::setprecision(prec);
+    out.flush();
+} // ibis::profile::print
+
+/// Print a string as a JSON string literal.
+static void _ibis_profile_quote(std::ostream& out, const std::string& str) {
+    out << '"';
+    for (size_t j = 0; j < str.size(); ++ j) {
+        const unsigned char c = static_cast<unsigned char>(str[j]);
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        }
+        else if (c < 0x20) {
+            char buf[8];
+            sprintf(buf, "\\u%04x", static_cast<unsigned>(c));
+            out << buf;
+        }
+        else {
+            out << c;
+        }
+    }
+    out << '"';
+} // _ibis_profile_quote
+
+/// Print a node and its children as a JSON object.
+static void _ibis_profile_json(std::ostream& out,
+                               const ibis::profile::node& nd) {
+    out << "{\"label\":";
+    _ibis_profile_quote(out, nd.label);
+    if (! nd.method.empty()) {
+        out << ",\"method\":";
+        _ibis_profile_quote(out, nd.method);
+    }
+    if (nd.rows >= 0)
+        out << ",\"rows\":" << nd.rows;
+    out << ",\"realTime\":" << nd.realTime << ",\"cpuTime\":" << nd.cpuTime
+        << ",\"bytesRead\":" << nd.work.bytesRead
+        << ",\"bitmaps\":" << nd.work.bitmaps
+        << ",\"bitvectorOps\":" << nd.work.bitvectorOps
+        << ",\"bitvectorBytes\":" << nd.work.bitvectorBytes
+        << ",\"rowsChecked\":" << nd.work.rowsChecked;
+    if (! nd.children.empty()) {
+        out << ",\"children\":[";
+        for (size_t j = 0; j < nd.children.size(); ++ j) {
+            if (j > 0)
+                out << ',';
+            _ibis_profile_json(out, *(nd.children[j]));
+        }
+        out << ']';
+    }
+    out << '}';
+} // _ibis_profile_json
+
+/// Print the tree of phases as a JSON object.  Each phase has the fields
+/// label, realTime, cpuTime, bytesRead, bitmaps, bitvectorOps,
+/// bitvectorBytes and rowsChecked, and optionally method, rows and
+/// children.
+void ibis::profile::printJSON(std::ostream& out) const {
+    const std::streamsize prec = out.precision();
+    out << std::setprecision(9);
+    _ibis_profile_json(out, *top);
+    out << std::setprecision(prec) << std::endl;
+} // ibis::profile::printJSON
@@ -0,0 +1,164 @@
+// File: $Id$
+// Author: John Wu <John.Wu at acm.org>
+//      Lawrence Berkeley National Laboratory
+// Copyright (c) 2007-2016 the Regents of the University of California
+#ifndef IBIS_PROFILE_H
+#define IBIS_PROFILE_H
+///@file
+/// A record of the work done to answer a query.
+///
+/// A profile is a tree of phases, such as the evaluation of a query on a
+/// data partition and the evaluation of each term of its where clause.
+/// Each phase records the elapsed time, the CPU time, the bytes read into
+/// memory by the file manager, the number of bitmaps activated, the
+/// number and the sizes of the bitwise logical operations, the number of
+/// candidate rows checked against the raw data, the number of rows
+/// produced and, for the range conditions, the access method chosen.
+///
+/// A profile collects the work of the thread it is activated on.  The
+/// counters of a phase include the work of its sub-phases.  The bytes read
+/// are taken from the page count of the file manager, which also includes
+/// the reads performed by other threads during the same period.
+#include "util.h"       // ibis::util
+#include "horometer.h"  // ibis::horometer
+
+#include <vector>       // std::vector
+
+namespace ibis {
+    class profile; // forward declaration
+    class part;
+    class qExpr;
+    class bitvector;
+}
+
+/// A record of the work done to answer a query.  To profile a query,
+/// create a profile object and activate it on the thread that runs the
+/// query,
+/// @code
+/// ibis::profile prof("my query");
+/// {
+///     ibis::profile::activate act(prof);
+///     std::unique_ptr<ibis::table> res(tbl->select(sel, cond));
+/// }
+/// prof.print(std::cout);
+/// @endcode
+/// The functions ibis::query::estimate, ibis::query::evaluate,
+/// ibis::countQuery::evaluate, ibis::table::select and ibis::filter::select
+/// add their phases to the active profile.
+class FASTBIT_CXX_DLLSPEC ibis::profile {
+public:
+    /// Counters of the work done.
+    struct counters {
+        uint64_t bytesRead;   ///!< Bytes read by the file manager.
+        uint64_t bitmaps;     ///!< Bitmaps activated.
+        uint64_t bitvectorOps;   ///!< Bitwise logical operations.
+        uint64_t bitvectorBytes; ///!< Bytes of the operands.
+        uint64_t rowsChecked; ///!< Rows checked against the raw data.
+
+        counters() : bytesRead(0), bitmaps(0), bitvectorOps(0),
+                     bitvectorBytes(0), rowsChecked(0) {}
+    };
+
+    /// A phase of the query processing.
+    struct node {
+        std::string label;  ///!< What is being done.
+        std::string method; ///!< How a range condition is evaluated.
+        double realTime;    ///!< Elapsed time in seconds.
+        double cpuTime;     ///!< CPU time in seconds.
+        int64_t rows;       ///!< Number of rows produced, -1 if unknown.
+        counters work;      ///!< Work done, including the sub-phases.
+        std::vector<node*> children; ///!< The sub-phases.
+
+        node() : realTime(0.0), cpuTime(0.0), rows(-1) {}
+        ~node();
+
+    private:
+        node(const node&);
+        node& operator=(const node&);
+    }; // node
+
+    explicit profile(const char* label);
+    ~profile();
+
+    /// The root of the tree of phases.
+    const node& root() const {return *top;}
+    void print(std::ostream& out) const;
+    void printJSON(std::ostream& out) const;
+    void clear();
+
+    static profile* current();
+
+    /// Activate a profile on the current thread for the lifetime of this
+    /// object.  The previously active profile is restored afterward.
+    class FASTBIT_CXX_DLLSPEC activate {
+    public:
+        explicit activate(ibis::profile& p);
+        ~activate();
+
+    private:
+        ibis::profile* prof;
+        ibis::profile* prev;
+        counters start;
+        double pages;
+        ibis::horometer timer;
+
+        activate();
+        activate(const activate&);
+        activate& operator=(const activate&);
+    }; // activate
+
+    /// Record a phase in the profile active on the current thread.  A
+    /// phase lasts until this object is destroyed.  Without an active
+    /// profile, this object does nothing.
+    class FASTBIT_CXX_DLLSPEC phase {
+    public:
+        explicit phase(const char* label);
+        explicit phase(const std::string& label);
+        phase(const char* what, const char* name);
+        phase(const ibis::part& p, const ibis::qExpr* term,
+              const ibis::bitvector& mask);
+        ~phase();
+
+        /// Is the phase being recorded?
+        bool active() const {return me != 0;}
+        /// Record the access method.
+        void setMethod(const char* m) {if (me != 0 && m != 0) me->method = m;}
+        /// Record the number of rows produced.
+        void setRows(int64_t n) {if (me != 0) me->rows = n;}
+
+    private:
+        ibis::profile* prof;
+        node* me;
+        node* parent;
+        counters start;
+        double pages;
+        ibis::horometer timer;
+
+        void init(const std::string& label);
+
+        phase();
+        phase(const phase&);
+        phase& operator=(const phase&);
+    }; // phase
+
+    static void countBitmaps(uint64_t n);
+    static void countBitvectorOp(uint64_t bytes);
+    static void countRows(uint64_t n);
+    /// Is a profile active on any thread?  The callers on the hot paths
+    /// check this before calling the count functions above.
+    static bool enabled() {return nactive != 0;}
+
+protected:
+    node* top;      ///!< The root of the tree.
+    node* cur;      ///!< The innermost phase in progress.
+    counters tally; ///!< Running totals of the counters.
+
+    /// The number of profiles active on all threads.
+    static uint32_t volatile nactive;
+
+private:
+    profile();
+    profile(const profile&);
+    profile& operator=(const profile&);
+}; // ibis::profile
+#endif // IBIS_PROFILE_H
@@ -3446,6 +3446,19 @@ void ibis::qDiscreteRange::print(std::ostream& out) const {
     out << ')';
 } // ibis::qDiscreteRange::print
 
+/// Print all the values.  Unlike print, which omits some of the values
+/// of a long list, this function prints every value with the precision
+/// of the output stream.
+void ibis::qDiscreteRange::printFull(std::ostream& out) const {
+    out << name << " IN (";
+    if (values.size() > 0) {
+        out << values[0];
+        for (uint32_t i = 1; i < values.size(); ++ i)
+            out << ", " << values[i];
+    }
+    out << ')';
+} // ibis::qDiscreteRange::printFull
+
 /// Convert to a sequence of qContinuousRange.
 ibis::qExpr* ibis::qDiscreteRange::convert() const {
     if (name.empty()) return 0;
@@ -372,7 +372,7 @@ public:
     bool overlap(double, double) const;
 
     virtual void print(std::ostream&) const;
-    virtual void printFull(std::ostream& out) const {print(out);}
+    virtual void printFull(std::ostream& out) const;
 
 private:
     std::string name; ///!< Column name.
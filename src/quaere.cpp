@@ -6,6 +6,7 @@
 #include "filter.h"     // ibis::filter
 #include "fromClause.h" // ibis::fromClause
 #include "whereClause.h"// ibis::whereClause
+#include "workload.h"   // ibis::workload
 
 #include <memory>       // std::unique_ptr
 
@@ -36,6 +37,16 @@ ibis::quaere*
 ibis::quaere::create(const char* sel, const char* fr, const char* wh,
                      const ibis::partList& prts) {
     if (prts.empty()) return 0;
+    ibis::workload::capture cap("quaere");
+    if (cap.active()) { // record the call and the number of rows
+        cap.add(sel);
+        cap.add(fr);
+        cap.add(wh);
+        ibis::quaere* qr = ibis::quaere::create(sel, fr, wh, prts);
+        cap.setRows(qr != 0 ? qr->count() : -1);
+        return qr;
+    }
+
     std::string sql;
     if (fr != 0 && *fr != 0) {
         sql += "From ";
@@ -1056,6 +1067,19 @@ ibis::quaere*
 ibis::quaere::create(const ibis::part* partr, const ibis::part* parts,
                      const char* colname, const char* condr,
                      const char* conds, const char* sel) {
+    ibis::workload::capture cap("join");
+    if (cap.active()) { // record the call and the number of rows
+        cap.add(partr != 0 ? partr->name() : 0);
+        cap.add(parts != 0 ? parts->name() : 0);
+        cap.add(colname);
+        cap.add(condr);
+        cap.add(conds);
+        cap.add(sel);
+        ibis::quaere* qr = ibis::quaere::create(partr, parts, colname,
+                                                condr, conds, sel);
+        cap.setRows(qr != 0 ? qr->count() : -1);
+        return qr;
+    }
     return new ibis::jNatural(partr, parts, colname, condr, conds, sel);
 } // ibis::quaere::create
 
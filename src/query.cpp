@@ -16,6 +16,11 @@
 #include "iroster.h"    // ibis::roster
 #include "irelic.h"     // ibis::join::estimate
 #include "bitvector64.h"
+#include "advisor.h"    // ibis::advisor
+#include "profile.h"    // ibis::profile
+#include "metrics.h"    // ibis::metrics
+#include "workload.h"   // ibis::workload
+#include "resultCache.h"        // ibis::resultCache
 
 #include <stdio.h>      // remove()
 #include <stdarg.h>     // vsprintf
@@ -252,6 +257,49 @@ int ibis::query::setSelectClause(const char* str) {
     return 0;
 } // ibis::query::setSelectClause
 
+/// Specify the select clause through a selectClause object that has
+/// already been verified on the data partition of this query.  The content
+/// of the incoming object is taken over by this query and the argument is
+/// left with the previous select clause of this query.  It is used by
+/// ibis::preparedQuery to avoid parsing the same select clause again.
+int ibis::query::setSelectClause(ibis::selectClause& sc) {
+    if (sc.empty()) return -2;
+
+    {
+        writeLock control(this, "setSelectClause");
+        comps.swap(sc);
+    }
+
+    if (state == FULL_EVALUATE || state == BUNDLES_TRUNCATED ||
+        state == HITS_TRUNCATED || state == QUICK_ESTIMATE) {
+        dstime = 0;
+        if (hits == sup) {
+            delete hits;
+            hits = 0;
+            sup = 0;
+        }
+        else {
+            delete hits;
+            delete sup;
+            hits = 0;
+            sup = 0;
+        }
+        removeFiles();
+    }
+
+    if (rids_in || conds.getExpr() != 0) {
+        state = SPECIFIED;
+        writeQuery();
+    }
+    else {
+        state = SET_COMPONENTS;
+    }
+    if (ibis::gVerbose > 1) {
+        logMessage("setSelectClause", "SELECT %s", *comps);
+    }
+    return 0;
+} // ibis::query::setSelectClause
+
 /// Specify the where clause in the string form.
 /// The where clause is a string representing a list of range conditions.
 /// By SQL convention, an empty where clause matches all rows.
@@ -553,6 +601,55 @@ int ibis::query::setWhereClause(const ibis::qExpr* qx) {
     return ierr;
 } // ibis::query::setWhereClause
 
+/// Specify the where clause through a whereClause object that has already
+/// been verified on the data partition of this query.  The content of the
+/// incoming object is taken over by this query and the argument is left
+/// with the previous where clause of this query.  Since neither parsing
+/// nor verification is performed, this is the least expensive way to
+/// change the query conditions.  It is used by ibis::preparedQuery.
+int ibis::query::setWhereClause(ibis::whereClause& wc) {
+    if (wc.getExpr() == 0) return -4;
+
+    if (ibis::gVerbose > 0 && *wc.getString() == 0 &&
+        wc.getExpr()->nItems() <= static_cast<unsigned>(ibis::gVerbose)) {
+        wc.resetString(); // regenerate the string form of the query expression
+    }
+
+    writeLock lck(this, "setWhereClause");
+    wc.swap(conds);
+
+    if (state == FULL_EVALUATE || state == BUNDLES_TRUNCATED ||
+        state == HITS_TRUNCATED || state == QUICK_ESTIMATE) {
+        dstime = 0;
+        if (hits == sup) {
+            delete hits;
+            hits = 0;
+            sup = 0;
+        }
+        else {
+            delete hits;
+            delete sup;
+            hits = 0;
+            sup = 0;
+        }
+        removeFiles();
+    }
+
+    if (! comps.empty()) {
+        state = SPECIFIED;
+        writeQuery();
+    }
+    else {
+        state = SET_PREDICATE;
+    }
+    LOGGER(ibis::gVerbose > 1)
+        << "query[" << myID
+        << "]::setWhereClause accepted new query conditions \""
+        << (conds.getString() ? conds.getString() : "<long expression>")
+        << "\"";
+    return 0;
+} // ibis::query::setWhereClause
+
 /// Add a set of conditions to the existing where clause.  The new query
 /// expression is joined with the existing conditions with the AND operator.
 ///
@@ -772,6 +869,8 @@ int ibis::query::estimate() {
         << evt << " -- starting to estimate query";
 
     double pcnt = ibis::fileManager::instance().pageCount();
+    ibis::profile::phase ph("estimate", mypart->name());
+    ibis::metrics::timer mt(ibis::metrics::estimateTime);
     if (dstime != 0 && dstime != mypart->timestamp()) {
         // clear the current results and prepare for re-evaluation
         dstime = 0;
@@ -1003,6 +1102,16 @@ long ibis::query::getCandidateRows(std::vector<uint32_t> &rids) const {
 ///
 /// @see getQualifiedInts
 int ibis::query::evaluate(const bool evalSelect) {
+    ibis::workload::capture cap("query");
+    if (cap.active()) { // record the call and its result
+        cap.add(mypart != 0 ? mypart->name() : 0);
+        cap.add(comps.getString());
+        cap.add(conds.getString());
+        int ierr = evaluate(evalSelect);
+        cap.setRows(ierr >= 0 ? getNumHits() : -1);
+        return ierr;
+    }
+
     if (mypart == 0 || mypart->nRows() == 0 || mypart->nColumns() == 0)
         return -1;
     if (rids_in == 0 && conds.empty() && comps.empty()) {
@@ -1019,6 +1128,8 @@ int ibis::query::evaluate(const bool evalSelect) {
     int ierr=-1;
     ibis::horometer timer;
     double pcnt = ibis::fileManager::instance().pageCount();
+    ibis::profile::phase ph("evaluate", mypart->name());
+    ibis::metrics::timer mt(ibis::metrics::evaluateTime);
     writeLock lck(this, "evaluate");
     if ((state < FULL_EVALUATE) ||
         (dstime != 0 && dstime != mypart->timestamp())) {
@@ -1237,6 +1348,8 @@ int ibis::query::evaluate(const bool evalSelect) {
                  (1U<<ibis::gVerbose) >= hits->bytes())))
             << "The hit vector" << *hits;
     }
+    if (ph.active() && hits != 0 && (sup == 0 || sup == hits))
+        ph.setRows(hits->cnt());
     return ierr;
 } // ibis::query::evaluate
 
@@ -2005,8 +2118,8 @@ std::string ibis::query::removeComplexConditions() {
 ///      disables the logging feature.
 ibis::query::query(const char* uid, const part* et, const char* pref) :
     user(ibis::util::strnewdup((uid && *uid) ? uid : ibis::util::userName())),
-    state(UNINITIALIZED), hits(0), sup(0), dslock(0), myID(0),
-    myDir(0), rids_in(0), mypart(et), dstime(0) {
+    state(UNINITIALIZED), hits(0), sup(0), dslock(0), logPlans(false),
+    myID(0), myDir(0), rids_in(0), mypart(et), dstime(0) {
     myID = newToken(user);
     lastError[0] = static_cast<char>(0);
 
@@ -2041,8 +2154,8 @@ ibis::query::query(const char* uid, const part* et, const char* pref) :
 /// with the recovery feature, which is enabled through a configuration
 /// parameter prefix.enableRecovery = true.
 ibis::query::query(const char* dir, const ibis::partList& tl) :
-    user(0), state(UNINITIALIZED), hits(0), sup(0), dslock(0), myID(0),
-    myDir(0), rids_in(0), mypart(0), dstime(0) {
+    user(0), state(UNINITIALIZED), hits(0), sup(0), dslock(0),
+    logPlans(false), myID(0), myDir(0), rids_in(0), mypart(0), dstime(0) {
     const char *ptr = strrchr(dir, FASTBIT_DIRSEP);
     if (ptr == 0) {
         myID = ibis::util::strnewdup(dir);
@@ -3032,6 +3145,25 @@ int ibis::query::computeHits() {
     }
 
     int ierr = 0;
+    std::string ckey; // the key of the answer in ibis::resultCache
+    ibis::horometer ctime; // time to compute the hits
+    if (hits == 0 && rids_in == 0 && conds.getExpr() != 0) {
+        ckey = ibis::resultCache::key(*mypart, conds.getExpr(),
+                                      comps.getString());
+        ibis::bitvector tmp;
+        if (ibis::resultCache::lookup(ckey, tmp)) {
+            dstime = mypart->timestamp();
+            delete sup;
+            hits = new ibis::bitvector;
+            hits->swap(tmp);
+            sup = hits;
+            plans.clear();
+            return ierr;
+        }
+        if (! ckey.empty())
+            ctime.start();
+    }
+
     if (hits == 0) { // have not performed an estimate
         ibis::bitvector mask;
         conds.getNullMask(*mypart, mask);
@@ -3061,11 +3193,19 @@ int ibis::query::computeHits() {
 #endif
             delete sup;
             sup = 0;
+            plans.clear();
+            logPlans = true;
             ierr = doEvaluate(conds.getExpr(), mask, *hits);
+            logPlans = false;
             if (ierr < 0)
                 return ierr - 20;
             hits->compress();
             sup = hits;
+            if (! ckey.empty()) {
+                ctime.stop();
+                ibis::resultCache::insert(ckey, *mypart, *hits,
+                                          ctime.realTime());
+            }
         }
         else {
             hits = new ibis::bitvector(mask);
@@ -3229,6 +3369,92 @@ long ibis::query::sequentialScan(ibis::bitvector& res) const {
     return ierr;
 } // ibis::query::sequentialScan
 
+/// Record the access method chosen for the range condition @c cmp on the
+/// rows marked 1 in @c mask.
+void ibis::query::recordPlan(const ibis::qRange& cmp,
+                             const ibis::bitvector& mask) const {
+    const ibis::column* col = mypart->getColumn(cmp.colName());
+    if (col == 0) return;
+
+    ibis::column::accessPlan plan;
+    if (cmp.getType() == ibis::qExpr::DRANGE)
+        col->chooseAccess(static_cast<const ibis::qDiscreteRange&>(cmp),
+                          mask, plan);
+    else
+        col->chooseAccess(static_cast<const ibis::qContinuousRange&>(cmp),
+                          mask, plan);
+    std::ostringstream oss;
+    oss << cmp;
+    plans.push_back(std::make_pair(oss.str(), plan));
+} // ibis::query::recordPlan
+
+/// Choose the access methods for the range conditions in @c term assuming
+/// every term is evaluated on all rows of the data partition.
+static void _ibis_query_plans
+(const ibis::part& p, const ibis::qExpr* term,
+ std::vector< std::pair<std::string, ibis::column::accessPlan> >& plans) {
+    if (term == 0) return;
+    if (term->getType() == ibis::qExpr::RANGE ||
+        term->getType() == ibis::qExpr::DRANGE) {
+        const ibis::qRange& cmp = *static_cast<const ibis::qRange*>(term);
+        const ibis::column* col = p.getColumn(cmp.colName());
+        if (col == 0) return;
+
+        ibis::column::accessPlan plan;
+        if (term->getType() == ibis::qExpr::DRANGE)
+            col->chooseAccess(static_cast<const ibis::qDiscreteRange&>(cmp),
+                              p.getMaskRef(), plan);
+        else
+            col->chooseAccess
+                (static_cast<const ibis::qContinuousRange&>(cmp),
+                 p.getMaskRef(), plan);
+        std::ostringstream oss;
+        oss << cmp;
+        plans.push_back(std::make_pair(oss.str(), plan));
+    }
+    else {
+        _ibis_query_plans(p, term->getLeft(), plans);
+        _ibis_query_plans(p, term->getRight(), plans);
+    }
+} // _ibis_query_plans
+
+/// Print the access methods of the range conditions together with the
+/// estimated costs that led to the choices.  After the query is evaluated,
+/// the methods actually chosen during the evaluation are printed, where
+/// the conditions evaluated later are restricted to the rows selected by
+/// the earlier ones.  Before the evaluation, the methods are chosen as if
+/// each condition were evaluated on all rows.
+void ibis::query::explain(std::ostream& out) const {
+    readLock lock(this, "explain");
+    out << "query[" << myID << "]";
+    if (mypart == 0 || conds.getExpr() == 0) {
+        out << " has no conditions to evaluate" << std::endl;
+        return;
+    }
+
+    out << " on data partition " << mypart->name() << " ("
+        << mypart->nRows() << " rows)\n  where ";
+    if (conds.getString() != 0)
+        out << conds.getString();
+    else
+        out << *conds.getExpr();
+    std::vector< std::pair<std::string, ibis::column::accessPlan> > tmp;
+    const std::vector< std::pair<std::string, ibis::column::accessPlan> >*
+        ptr = &plans;
+    if (plans.empty() || hits == 0) {
+        ibis::part::readLock lds(mypart, myID);
+        _ibis_query_plans(*mypart, conds.getExpr(), tmp);
+        ptr = &tmp;
+        out << "\n  estimated access methods:";
+    }
+    else {
+        out << "\n  access methods used:";
+    }
+    for (size_t j = 0; j < ptr->size(); ++ j)
+        out << "\n    " << (*ptr)[j].first << " -> " << (*ptr)[j].second;
+    out << std::endl;
+} // ibis::query::explain
+
 /// Get a bitvector containing all rows satisfying the query
 /// condition. The resulting bitvector inculdes both active rows and
 /// inactive rows.
@@ -3895,6 +4121,7 @@ int ibis::query::doEvaluate(const ibis::qExpr* term,
     LOGGER(ibis::gVerbose > 5)
         << "query[" << myID << "]::doEvaluate -- starting to evaluate "
         << *term;
+    ibis::profile::phase ph(*mypart, term, mypart->getMaskRef());
 
     int ierr = 0;
     switch (term->getType()) {
@@ -3989,6 +4216,9 @@ int ibis::query::doEvaluate(const ibis::qExpr* term,
                 ierr = ht.sloppyCount();
             }
         }
+        if (ierr >= 0 && ibis::advisor::enabled)
+            ibis::advisor::record
+                (*mypart, *(reinterpret_cast<const ibis::qRange*>(term)));
         break;
     }
     case ibis::qExpr::DRANGE: { // call evalauteRange, use doScan on failure
@@ -4013,6 +4243,9 @@ int ibis::query::doEvaluate(const ibis::qExpr* term,
                 ierr = ht.sloppyCount();
             }
         }
+        if (ierr >= 0 && ibis::advisor::enabled)
+            ibis::advisor::record
+                (*mypart, *(reinterpret_cast<const ibis::qRange*>(term)));
         break;
     }
     case ibis::qExpr::INTHOD: { // call evalauteRange, use doScan on failure
@@ -4132,6 +4365,8 @@ int ibis::query::doEvaluate(const ibis::qExpr* term,
         << static_cast<const void*>(term) << ": " << *term
         << ") --> " << ht.cnt() << ", ierr = " << ierr;
 #endif
+    if (ph.active())
+        ph.setRows(ht.cnt());
     return ierr;
 } // ibis::query::doEvaluate
 
@@ -4151,6 +4386,20 @@ int ibis::query::doEvaluate(const ibis::qExpr* term,
     LOGGER(ibis::gVerbose > 7)
         << "query[" << myID << "]::doEvaluate -- starting to evaluate "
         << *term;
+    ibis::profile::phase ph(*mypart, term, mask);
+
+    // the hits of a single term may be cached by an earlier query
+    const std::string tkey = ibis::resultCache::termKey(*mypart, term);
+    if (ibis::resultCache::lookup(tkey, ht)) {
+        ht &= mask;
+        ph.setMethod("cache");
+        if (ph.active())
+            ph.setRows(ht.cnt());
+        return ht.sloppyCount();
+    }
+    ibis::horometer ttime; // time to compute the hits of the term
+    if (! tkey.empty())
+        ttime.start();
 
     int ierr = 0;
     switch (term->getType()) {
@@ -4221,6 +4470,8 @@ int ibis::query::doEvaluate(const ibis::qExpr* term,
         ierr = ht.sloppyCount();
         break;}
     case ibis::qExpr::RANGE: {
+        if (logPlans)
+            recordPlan(*(reinterpret_cast<const ibis::qRange*>(term)), mask);
         ierr = mypart->evaluateRange
             (*(reinterpret_cast<const ibis::qContinuousRange*>(term)),
              mask, ht);
@@ -4249,9 +4500,14 @@ int ibis::query::doEvaluate(const ibis::qExpr* term,
                 ierr = ht.sloppyCount();
             }
         }
+        if (ierr >= 0 && ibis::advisor::enabled)
+            ibis::advisor::record
+                (*mypart, *(reinterpret_cast<const ibis::qRange*>(term)));
         break;
     }
     case ibis::qExpr::DRANGE: { // try evaluateRange, then doScan
+        if (logPlans)
+            recordPlan(*(reinterpret_cast<const ibis::qRange*>(term)), mask);
         ierr = mypart->evaluateRange
             (*(reinterpret_cast<const ibis::qDiscreteRange*>(term)), mask, ht);
         if (ierr < 0) { // revert to estimate and scan
@@ -4279,6 +4535,9 @@ int ibis::query::doEvaluate(const ibis::qExpr* term,
                 ierr = ht.sloppyCount();
             }
         }
+        if (ierr >= 0 && ibis::advisor::enabled)
+            ibis::advisor::record
+                (*mypart, *(reinterpret_cast<const ibis::qRange*>(term)));
         break;
     }
     case ibis::qExpr::INTHOD: { // try evaluateRange, then doScan
@@ -4468,6 +4727,14 @@ int ibis::query::doEvaluate(const ibis::qExpr* term,
         << ", mask.cnt()=" << mask.cnt() << ") --> " << ht.cnt()
         << ", ierr = " << ierr;
 #endif
+    if (! tkey.empty() && ierr >= 0 && // evaluated on all active rows
+        mask.size() == mypart->getMaskRef().size() &&
+        mask.cnt() == mypart->getMaskRef().cnt()) {
+        ttime.stop();
+        ibis::resultCache::insert(tkey, *mypart, ht, ttime.realTime());
+    }
+    if (ph.active())
+        ph.setRows(ht.cnt());
     return ierr;
 } // ibis::query::doEvaluate
 
@@ -84,9 +84,11 @@ public:
 		       const std::vector<double>& lbounds,
 		       const std::vector<double>& rbounds);
     int setWhereClause(const ibis::qExpr* qexp);
+    int setWhereClause(ibis::whereClause& wc);
     int addConditions(const ibis::qExpr* qexp);
     int addConditions(const char*);
     virtual int setSelectClause(const char *str);
+    int setSelectClause(ibis::selectClause& sc);
     /// Resets the data partition associated with the query.
     int setPartition(const ibis::part* tbl);
     /// This is deprecated, will be removed soon.
@@ -185,6 +187,7 @@ public:
 
     long sequentialScan(ibis::bitvector& bv) const;
     long getExpandedHits(ibis::bitvector&) const;
+    void explain(std::ostream& out) const;
 
     // used by ibis::bundle
     RIDSet* readRIDs() const;
@@ -235,12 +238,20 @@ protected:
     ibis::bitvector* sup;///!< Estimated upper bound
     mutable ibis::part::readLock* dslock;	///!< A read lock on the mypart
     mutable char lastError[MAX_LINE+PATH_MAX];	///!< The warning/error message
+    /// The access methods chosen for the range conditions during the last
+    /// evaluation, see explain.
+    mutable std::vector< std::pair<std::string, ibis::column::accessPlan> >
+    plans;
+    /// Are the access methods being recorded?
+    mutable bool logPlans;
 
     void logError(const char* event, const char* fmt, ...) const;
     void logWarning(const char* event, const char* fmt, ...) const;
     void storeErrorMesg(const char*) const;
 
     void reorderExpr(); // reorder query expression
+    void recordPlan(const ibis::qRange& cmp,
+                    const ibis::bitvector& mask) const;
 
     bool hasBundles() const;
     void getBounds();
@@ -0,0 +1,400 @@
+// File: $Id$
+// Author: John Wu <John.Wu at acm.org>
+//      Lawrence Berkeley National Laboratory
+// Copyright (c) 2007-2016 the Regents of the University of California
+//
+// This file contains the implementation of the cache of query hits
+// defined in resultCache.h.
+#include "resultCache.h"        // ibis::resultCache
+#include "part.h"               // ibis::part
+#include "qExpr.h"              // ibis::qExpr
+#include "metrics.h"            // ibis::metrics
+
+#include <map>          // std::map
+#include <memory>       // std::unique_ptr
+#include <sstream>      // std::ostringstream
+#include <iomanip>      // std::setprecision
+#include <algorithm>    // std::sort
+
+/// The entries of the cache.  It registers itself with the file manager
+/// as a cleaner, so that the cached bitvectors are released when the file
+/// manager needs memory.  The cleaner is invoked while the file manager
+/// holds its own mutex, therefore no function of this class may call the
+/// file manager while holding the mutex of the cache.  The bitvectors
+/// removed from the cache are deleted after the mutex is released.
+class _ibis_resultCache_store : public ibis::fileManager::cleaner {
+public:
+    /// A cached answer.
+    struct entry {
+        ibis::bitvector* hits;  ///!< The hits.
+        const ibis::part* part; ///!< The data partition.
+        double cost;            ///!< Seconds taken to compute the hits.
+        double prio;            ///!< Priority for keeping the entry.
+    };
+    typedef std::map<std::string, entry> entryList;
+
+    _ibis_resultCache_store();
+    virtual ~_ibis_resultCache_store();
+    virtual void operator()() const;
+
+    void touch(entry& ent) const;
+    void evict(std::vector<ibis::bitvector*>& evicted) const;
+    void takeAll(std::vector<ibis::bitvector*>& evicted) const;
+
+    mutable pthread_mutex_t mutex; ///!< Guards all other members.
+    mutable entryList entries;  ///!< The cached answers.
+    mutable uint64_t curBytes;  ///!< Bytes of the cached bitvectors.
+    uint64_t maxBytes;          ///!< Maximum bytes of the cached bitvectors.
+    mutable double floor;       ///!< Priority of the last evicted entry.
+
+private:
+    _ibis_resultCache_store(const _ibis_resultCache_store&);
+    _ibis_resultCache_store& operator=(const _ibis_resultCache_store&);
+}; // _ibis_resultCache_store
+
+/// The store while it exists.  The data partitions may be destroyed after
+/// the store at the end of the program.
+static const _ibis_resultCache_store* _ibis_resultCache_live = 0;
+
+/// Constructor.  Read the parameter resultCache.maxBytes.  Since the file
+/// manager is initialized before this object, it is destroyed after this
+/// object.
+_ibis_resultCache_store::_ibis_resultCache_store()
+    : curBytes(0), maxBytes(0), floor(0.0) {
+    if (pthread_mutex_init(&mutex, 0) != 0)
+        throw ibis::bad_alloc("pthread_mutex_init failed in resultCache"
+                              IBIS_FILE_LINE);
+    const char* str = ibis::gParameters()["resultCache.maxBytes"];
+    if (str != 0 && *str != 0)
+        maxBytes = static_cast<uint64_t>
+            (ibis::gParameters().getNumber("resultCache.maxBytes"));
+    else
+        maxBytes = ibis::fileManager::currentCacheSize() / 32;
+    ibis::fileManager::instance().addCleaner(this);
+    _ibis_resultCache_live = this;
+    LOGGER(ibis::gVerbose > 2)
+        << "resultCache initialized with maxBytes=" << maxBytes;
+} // _ibis_resultCache_store::_ibis_resultCache_store
+
+/// Destructor.
+_ibis_resultCache_store::~_ibis_resultCache_store() {
+    _ibis_resultCache_live = 0;
+    ibis::fileManager::instance().removeCleaner(this);
+    for (entryList::iterator it = entries.begin(); it != entries.end(); ++ it)
+        delete (*it).second.hits;
+    entries.clear();
+    pthread_mutex_destroy(&mutex);
+} // _ibis_resultCache_store::~_ibis_resultCache_store
+
+/// Remove all entries.  Called by the file manager when it needs memory.
+void _ibis_resultCache_store::operator()() const {
+    std::vector<ibis::bitvector*> evicted;
+    takeAll(evicted);
+    if (! evicted.empty()) {
+        LOGGER(ibis::gVerbose > 6)
+            << "resultCache -- the file manager removed " << evicted.size()
+            << " cached answer" << (evicted.size()>1?"s":"");
+    }
+    for (size_t j = 0; j < evicted.size(); ++ j)
+        delete evicted[j];
+} // _ibis_resultCache_store::operator()
+
+/// Move all bitvectors out of the cache.  The caller deletes them.
+void _ibis_resultCache_store::takeAll(std::vector<ibis::bitvector*>& evicted)
+    const {
+    ibis::util::mutexLock lck(&mutex, "resultCache::takeAll");
+    evicted.reserve(evicted.size() + entries.size());
+    for (entryList::const_iterator it = entries.begin();
+         it != entries.end(); ++ it)
+        evicted.push_back((*it).second.hits);
+    entries.clear();
+    curBytes = 0;
+    floor = 0.0;
+} // _ibis_resultCache_store::takeAll
+
+/// Refresh the priority of an entry that is used.  The priority is the
+/// priority of the last evicted entry plus the cost of recomputing the
+/// hits per byte of memory they occupy, following the GreedyDual-Size
+/// policy.  An entry that is expensive to compute and small is kept
+/// longer, and an entry not used for a while falls behind the entries
+/// used recently.  Must be called with the mutex held.
+void _ibis_resultCache_store::touch(entry& ent) const {
+    const double nb = static_cast<double>(ent.hits->bytes());
+    ent.prio = floor + ent.cost / (nb > 1.0 ? nb : 1.0);
+} // _ibis_resultCache_store::touch
+
+/// Remove the entries with the lowest priorities until the total size is
+/// within the limit.  Must be called with the mutex held.
+void _ibis_resultCache_store::evict(std::vector<ibis::bitvector*>& evicted)
+    const {
+    while (curBytes > maxBytes && ! entries.empty()) {
+        entryList::iterator old = entries.begin();
+        for (entryList::iterator it = entries.begin();
+             it != entries.end(); ++ it) {
+            if ((*it).second.prio < (*old).second.prio)
+                old = it;
+        }
+        floor = (*old).second.prio;
+        curBytes -= (*old).second.hits->bytes();
+        evicted.push_back((*old).second.hits);
+        entries.erase(old);
+    }
+} // _ibis_resultCache_store::evict
+
+/// The only instance of the store.  It is created after the file manager.
+static _ibis_resultCache_store& _ibis_resultCache_instance() {
+    (void) ibis::fileManager::instance();
+    static _ibis_resultCache_store theStore;
+    return theStore;
+} // _ibis_resultCache_instance
+
+/// Print the canonical form of an expression.  The operands of a chain of
+/// the same associative operator are sorted by their canonical forms.
+static void _ibis_resultCache_print(std::ostream& out, const ibis::qExpr* x) {
+    if (x == 0) return;
+    switch (x->getType()) {
+    case ibis::qExpr::LOGICAL_AND:
+    case ibis::qExpr::LOGICAL_OR:
+    case ibis::qExpr::LOGICAL_XOR: {
+        const ibis::qExpr::TYPE t = x->getType();
+        std::vector<const ibis::qExpr*> stack, terms;
+        stack.push_back(x);
+        while (! stack.empty()) {
+            const ibis::qExpr* y = stack.back();
+            stack.pop_back();
+            if (y->getType() == t) {
+                if (y->getRight() != 0)
+                    stack.push_back(y->getRight());
+                if (y->getLeft() != 0)
+                    stack.push_back(y->getLeft());
+            }
+            else {
+                terms.push_back(y);
+            }
+        }
+
+        std::vector<std::string> strs(terms.size());
+        for (size_t j = 0; j < terms.size(); ++ j) {
+            std::ostringstream oss;
+            oss << std::setprecision(17);
+            _ibis_resultCache_print(oss, terms[j]);
+            strs[j] = oss.str();
+        }
+        std::sort(strs.begin(), strs.end());
+        const char* op = (t == ibis::qExpr::LOGICAL_AND ? " AND " :
+                          t == ibis::qExpr::LOGICAL_OR ? " OR " : " XOR ");
+        out << '(';
+        for (size_t j = 0; j < strs.size(); ++ j) {
+            if (j > 0) out << op;
+            out << strs[j];
+        }
+        out << ')';
+        break;}
+    case ibis::qExpr::LOGICAL_MINUS: {
+        out << '(';
+        _ibis_resultCache_print(out, x->getLeft());
+        out << " AND NOT ";
+        _ibis_resultCache_print(out, x->getRight());
+        out << ')';
+        break;}
+    case ibis::qExpr::LOGICAL_NOT: {
+        out << "( ! ";
+        _ibis_resultCache_print(out, x->getLeft());
+        out << ')';
+        break;}
+    default: {
+        x->printFull(out);
+        break;}
+    }
+} // _ibis_resultCache_print
+
+/// Print the canonical form of a query expression.  The operands of AND,
+/// OR and XOR are flattened and sorted, and the constants are printed in
+/// full precision.  Two expressions with the same canonical form select
+/// the same rows.
+void ibis::resultCache::canonicalize(std::ostream& out, const ibis::qExpr* x) {
+    const std::streamsize prec = out.precision(17);
+    _ibis_resultCache_print(out, x);
+    out.precision(prec);
+} // ibis::resultCache::canonicalize
+
+/// Compose a key.  The argument @c kind distinguishes the answers to
+/// whole where clauses from the answers to single terms.
+static std::string _ibis_resultCache_key(const ibis::part& p, char kind,
+                                         const char* sel,
+                                         const ibis::qExpr* x) {
+    std::ostringstream oss;
+    oss << kind << '|' << p.name() << '@' << static_cast<const void*>(&p)
+        << '|' << p.timestamp() << '|' << p.nRows() << '|'
+        << p.getMaskRef().cnt() << '|' << (sel != 0 ? sel : "") << '|';
+    ibis::resultCache::canonicalize(oss, x);
+    return oss.str();
+} // _ibis_resultCache_key
+
+/// Compose the key of the cache entry for the expression @c x evaluated
+/// on the data partition @c p.  The argument @c sel is the select clause
+/// whose null masks are applied to the hits, or nil.  It returns an empty
+/// string if the answer is not to be cached.
+std::string ibis::resultCache::key(const ibis::part& p, const ibis::qExpr* x,
+                                   const char* sel) {
+    if (x == 0 || p.currentDataDir() == 0 || p.nRows() == 0 ||
+        _ibis_resultCache_instance().maxBytes == 0)
+        return std::string();
+    return _ibis_resultCache_key(p, 'Q', sel, x);
+} // ibis::resultCache::key
+
+/// Compose the key of the cache entry for a single term of a where
+/// clause.  Only the range conditions and the string and keyword
+/// searches are cached.  The cached bitvector holds the hits among all
+/// active rows of the data partition, which is then combined with the
+/// mask of the current evaluation.  It returns an empty string if the
+/// term is not to be cached.
+std::string ibis::resultCache::termKey(const ibis::part& p,
+                                       const ibis::qExpr* x) {
+    if (x == 0 || p.currentDataDir() == 0 || p.nRows() == 0 ||
+        _ibis_resultCache_instance().maxBytes == 0)
+        return std::string();
+    switch (x->getType()) {
+    case ibis::qExpr::RANGE:
+    case ibis::qExpr::DRANGE:
+    case ibis::qExpr::INTHOD:
+    case ibis::qExpr::UINTHOD:
+    case ibis::qExpr::STRING:
+    case ibis::qExpr::ANYSTRING:
+    case ibis::qExpr::KEYWORD:
+    case ibis::qExpr::ALLWORDS:
+    case ibis::qExpr::LIKE:
+        return _ibis_resultCache_key(p, 'T', 0, x);
+    default:
+        return std::string();
+    }
+} // ibis::resultCache::termKey
+
+/// Retrieve the hits stored under the key @c k.  Return true if found.
+/// The content of @c hits is replaced with a copy of the cached answer.
+/// The copy does not share memory with the cached answer, because some
+/// functions of ibis::bitvector, such as compress, modify a shared array
+/// in place.
+bool ibis::resultCache::lookup(const std::string& k, ibis::bitvector& hits) {
+    if (k.empty()) return false;
+    _ibis_resultCache_store& st = _ibis_resultCache_instance();
+    std::unique_ptr<ibis::bitvector> tmp;
+    {
+        ibis::util::mutexLock lck(&st.mutex, "resultCache::lookup");
+        _ibis_resultCache_store::entryList::iterator it = st.entries.find(k);
+        if (it == st.entries.end()) {
+            ibis::metrics::resultCacheMisses.add();
+            return false;
+        }
+        st.touch((*it).second);
+        tmp.reset(new ibis::bitvector(*(*it).second.hits));
+    }
+    hits.copy(*tmp); // deep copy without holding the mutex
+    ibis::metrics::resultCacheHits.add();
+    LOGGER(ibis::gVerbose > 4)
+        << "resultCache::lookup found " << hits.cnt() << " hit"
+        << (hits.cnt()>1?"s":"") << " for " << k;
+    return true;
+} // ibis::resultCache::lookup
+
+/// Store the hits under the key @c k.  The key must have been produced by
+/// ibis::resultCache::key or ibis::resultCache::termKey for the data
+/// partition @c p.  The argument @c cost is the time in seconds taken to
+/// compute the hits, which together with the size of the hits determines
+/// how long the entry is kept.
+void ibis::resultCache::insert(const std::string& k, const ibis::part& p,
+                               const ibis::bitvector& hits, double cost) {
+    if (k.empty() || hits.size() != p.nRows()) return;
+    _ibis_resultCache_store& st = _ibis_resultCache_instance();
+    if (hits.bytes() > st.maxBytes) return;
+
+    ibis::bitvector* bv = new ibis::bitvector;
+    bv->copy(hits);
+    std::vector<ibis::bitvector*> evicted;
+    {
+        ibis::util::mutexLock lck(&st.mutex, "resultCache::insert");
+        _ibis_resultCache_store::entry& ent = st.entries[k];
+        if (ent.hits != 0) { // another thread got here first
+            st.curBytes -= ent.hits->bytes();
+            evicted.push_back(ent.hits);
+        }
+        ent.hits = bv;
+        ent.part = &p;
+        ent.cost = cost;
+        st.touch(ent);
+        st.curBytes += bv->bytes();
+        st.evict(evicted);
+    }
+    for (size_t j = 0; j < evicted.size(); ++ j)
+        delete evicted[j];
+} // ibis::resultCache::insert
+
+/// Remove the entries of the data partition @c p.  The data partitions
+/// call this function whenever their content changes.
+void ibis::resultCache::invalidate(const ibis::part& p) {
+    if (_ibis_resultCache_live == 0) return; // nothing cached
+    _ibis_resultCache_store& st = _ibis_resultCache_instance();
+    std::vector<ibis::bitvector*> evicted;
+    {
+        ibis::util::mutexLock lck(&st.mutex, "resultCache::invalidate");
+        _ibis_resultCache_store::entryList::iterator it = st.entries.begin();
+        while (it != st.entries.end()) {
+            if ((*it).second.part == &p) {
+                st.curBytes -= (*it).second.hits->bytes();
+                evicted.push_back((*it).second.hits);
+                st.entries.erase(it ++);
+            }
+            else {
+                ++ it;
+            }
+        }
+    }
+    LOGGER(! evicted.empty() && ibis::gVerbose > 4)
+        << "resultCache::invalidate removed " << evicted.size()
+        << " cached answer" << (evicted.size()>1?"s":"") << " of "
+        << p.name();
+    for (size_t j = 0; j < evicted.size(); ++ j)
+        delete evicted[j];
+} // ibis::resultCache::invalidate
+
+/// Remove all entries.
+void ibis::resultCache::clear() {
+    std::vector<ibis::bitvector*> evicted;
+    _ibis_resultCache_instance().takeAll(evicted);
+    for (size_t j = 0; j < evicted.size(); ++ j)
+        delete evicted[j];
+} // ibis::resultCache::clear
+
+/// The maximum number of bytes of the cached bitvectors.
+uint64_t ibis::resultCache::limit() {
+    return _ibis_resultCache_instance().maxBytes;
+} // ibis::resultCache::limit
+
+/// Change the maximum number of bytes of the cached bitvectors.  The
+/// least recently used entries are removed if the cache exceeds the new
+/// limit.  A limit of 0 disables the cache.
+void ibis::resultCache::setLimit(uint64_t nb) {
+    _ibis_resultCache_store& st = _ibis_resultCache_instance();
+    std::vector<ibis::bitvector*> evicted;
+    {
+        ibis::util::mutexLock lck(&st.mutex, "resultCache::setLimit");
+        st.maxBytes = nb;
+        st.evict(evicted);
+    }
+    for (size_t j = 0; j < evicted.size(); ++ j)
+        delete evicted[j];
+} // ibis::resultCache::setLimit
+
+/// The number of bytes of the cached bitvectors.
+uint64_t ibis::resultCache::bytes() {
+    _ibis_resultCache_store& st = _ibis_resultCache_instance();
+    ibis::util::mutexLock lck(&st.mutex, "resultCache::bytes");
+    return st.curBytes;
+} // ibis::resultCache::bytes
+
+/// The number of cached answers.
+uint32_t ibis::resultCache::size() {
+    _ibis_resultCache_store& st = _ibis_resultCache_instance();
+    ibis::util::mutexLock lck(&st.mutex, "resultCache::size");
+    return st.entries.size();
+} // ibis::resultCache::size
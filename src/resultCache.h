@@ -0,0 +1,64 @@
+// File: $Id$
+// Author: John Wu <John.Wu at acm.org>
+//      Lawrence Berkeley National Laboratory
+// Copyright (c) 2007-2016 the Regents of the University of California
+#ifndef IBIS_RESULTCACHE_H
+#define IBIS_RESULTCACHE_H
+///@file
+/// A cache of the hits of the query conditions.
+///
+/// The exact hits computed by ibis::countQuery and ibis::query are kept in
+/// memory so that the same where clause on the same data partition is not
+/// evaluated again.  An entry is identified by the data partition, the
+/// time of its last switch operation, the number of rows and the number
+/// of active rows, the select clause whose null masks are part of the
+/// answer, and the query expression in a canonical form, in which the
+/// operands of AND, OR and XOR are flattened and sorted and the constants
+/// are printed in full precision.  Therefore, the same conditions written
+/// in different orders share an entry.
+///
+/// The hits of the individual range conditions, string searches and
+/// keyword searches are also cached, so that the queries sharing some of
+/// their terms only need to combine the cached bitvectors.  A term is
+/// cached when it is evaluated over all active rows of the data
+/// partition, e.g., as the first term of a conjunction on columns without
+/// null values, and reused in any later evaluation.
+///
+/// The data partitions remove their entries when they append new rows,
+/// mark rows inactive or active, commit, roll back or reorder.  When the
+/// total size of the cached bitvectors exceeds the parameter
+/// resultCache.maxBytes, which defaults to 1/32 of fileManager.maxBytes,
+/// the entries are removed according to the GreedyDual-Size policy, which
+/// keeps longer the entries that took more time to compute per byte of
+/// memory and the entries used recently.  Setting resultCache.maxBytes to
+/// 0 disables the cache.  The cache is also emptied whenever the file
+/// manager needs to free memory.  Only the data partitions with a data
+/// directory are cached.
+#include "util.h"       // ibis::util
+
+namespace ibis {
+    /// The cache of the hits of the query conditions.
+    namespace resultCache {
+        FASTBIT_CXX_DLLSPEC std::string
+        key(const ibis::part& p, const ibis::qExpr* x, const char* sel);
+        FASTBIT_CXX_DLLSPEC std::string
+        termKey(const ibis::part& p, const ibis::qExpr* x);
+        FASTBIT_CXX_DLLSPEC void canonicalize(std::ostream& out,
+                                              const ibis::qExpr* x);
+
+        FASTBIT_CXX_DLLSPEC bool lookup(const std::string& k,
+                                        ibis::bitvector& hits);
+        FASTBIT_CXX_DLLSPEC void insert(const std::string& k,
+                                        const ibis::part& p,
+                                        const ibis::bitvector& hits,
+                                        double cost);
+        FASTBIT_CXX_DLLSPEC void invalidate(const ibis::part& p);
+        FASTBIT_CXX_DLLSPEC void clear();
+
+        FASTBIT_CXX_DLLSPEC uint64_t limit();
+        FASTBIT_CXX_DLLSPEC void setLimit(uint64_t nb);
+        FASTBIT_CXX_DLLSPEC uint64_t bytes();
+        FASTBIT_CXX_DLLSPEC uint32_t size();
+    } // namespace resultCache
+} // namespace ibis
+#endif // IBIS_RESULTCACHE_H
@@ -0,0 +1,593 @@
+// File $Id$
+// author: John Wu <John.Wu at ACM.org> Lawrence Berkeley National Laboratory
+// Copyright (c) 2007-2016 the Regents of the University of California
+//
+#if defined(_WIN32) && defined(_MSC_VER)
+#pragma warning(disable:4786)   // some identifier longer than 256 characters
+#endif
+
+#include "tab.h"        // ibis::tabula and ibis::tabele
+#include "bord.h"       // ibis::bord
+#include "rivus.h"      // ibis::rivus
+#include "countQuery.h" // ibis::countQuery
+
+#include <memory>       // std::unique_ptr
+#include <sstream>      // std::ostringstream
+
+extern "C" {
+    /// The thread function to write the in-memory data partitions of an
+    /// ibis::rivus object to disk.
+    static void* ibis_rivus_sealer(void* arg) {
+        if (arg == 0) return reinterpret_cast<void*>(-1L);
+        ibis::rivus* rv = (ibis::rivus*)arg;
+        try {
+            rv->sealerLoop();
+            return 0;
+        }
+        catch (const std::exception &e) {
+            LOGGER(ibis::gVerbose >= 0)
+                << "Warning -- rivus[" << rv->name() << "]::sealerLoop "
+                "received std::exception \"" << e.what() << '"';
+            return(reinterpret_cast<void*>(-11L));
+        }
+        catch (const char* s) {
+            LOGGER(ibis::gVerbose >= 0)
+                << "Warning -- rivus[" << rv->name() << "]::sealerLoop "
+                "received exception \"" << s << '"';
+            return(reinterpret_cast<void*>(-12L));
+        }
+        catch (...) {
+            LOGGER(ibis::gVerbose >= 0)
+                << "Warning -- rivus[" << rv->name() << "]::sealerLoop "
+                "received an unexpected exception";
+            return(reinterpret_cast<void*>(-10L));
+        }
+    } // ibis_rivus_sealer
+} // extern "C"
+
+/// Constructor.  The data partitions already in directory @c dir are
+/// loaded as in ibis::mensa.  The new data partitions produced from the
+/// in-memory rows are written to subdirectories of @c dir named after the
+/// table name @c tname.
+ibis::rivus::rivus(const char* dir, const char* tname, const char* tdesc)
+    : ibis::mensa(), active(0), firstRow(0), nfrozen(0), nextSeq(0),
+      maxRows(1000000), maxSeconds(60.0), stopping(false), running(false) {
+    if (dir == 0 || *dir == 0)
+        throw "rivus::ctor needs a valid directory name" IBIS_FILE_LINE;
+    if (tname == 0 || *tname == 0)
+        throw "rivus::ctor needs a valid table name" IBIS_FILE_LINE;
+    if (0 != pthread_mutex_init(&wmutex, 0))
+        throw "rivus::ctor failed to initialize a mutex lock" IBIS_FILE_LINE;
+    if (0 != pthread_mutex_init(&smutex, 0))
+        throw "rivus::ctor failed to initialize a mutex lock" IBIS_FILE_LINE;
+    if (0 != pthread_rwlock_init(&plock, 0))
+        throw "rivus::ctor failed to initialize a rwlock" IBIS_FILE_LINE;
+    if (0 != pthread_cond_init(&scond, 0))
+        throw "rivus::ctor failed to initialize a condition variable"
+            IBIS_FILE_LINE;
+
+    topdir = dir;
+    int ierr = ibis::util::makeDir(dir);
+    if (ierr < 0)
+        throw "rivus::ctor failed to create the data directory"
+            IBIS_FILE_LINE;
+    if (ibis::util::gatherParts(parts, dir, true) > 0) {
+        for (ibis::partList::const_iterator it = parts.begin();
+             it != parts.end(); ++ it) {
+            (*it)->combineNames(naty);
+            nrows += (*it)->nRows();
+        }
+    }
+    name_ = tname;
+    if (tdesc != 0 && *tdesc != 0)
+        desc_ = tdesc;
+    else
+        desc_ = dir;
+
+    std::string pname = name_;
+    pname += ".maxMemoryRows";
+    double tmp = ibis::gParameters().getNumber(pname.c_str());
+    if (tmp >= 1.0)
+        maxRows = (tmp < 2e9 ? static_cast<uint32_t>(tmp) : 2000000000U);
+    pname = name_;
+    pname += ".maxMemorySeconds";
+    tmp = ibis::gParameters().getNumber(pname.c_str());
+    if (tmp > 0.0)
+        maxSeconds = tmp;
+
+    active = new ibis::tafel;
+    ierr = pthread_create(&sealer, 0, ibis_rivus_sealer, (void*)this);
+    if (ierr != 0) {
+        LOGGER(ibis::gVerbose >= 0)
+            << "Warning -- rivus[" << name_ << "]::ctor failed to start "
+            "the thread to write the in-memory data, pthread_create "
+            "returned " << ierr << " (" << strerror(ierr)
+            << "), the rows will be written only by function flush";
+    }
+    else {
+        running = true;
+    }
+    LOGGER(ibis::gVerbose > 0)
+        << "rivus -- constructed table " << name_ << " (" << desc_
+        << ") with " << parts.size() << " data partition"
+        << (parts.size()>1 ? "s" : "") << " and " << nrows << " row"
+        << (nrows>1 ? "s" : "") << " on disk";
+} // ibis::rivus::rivus
+
+/// Destructor.  Stops the writing thread and writes all remaining rows in
+/// memory to disk.
+ibis::rivus::~rivus() {
+    if (running) {
+        {
+            ibis::util::mutexLock lck(&smutex, "rivus::dtor");
+            stopping = true;
+            (void) pthread_cond_signal(&scond);
+        }
+        (void) pthread_join(sealer, 0);
+        running = false;
+    }
+    (void) flush();
+
+    for (size_t j = 0; j < frozen.size(); ++ j)
+        delete frozen[j];
+    frozen.clear();
+    delete active;
+    clear(); // naty may refer to the names in schema
+    parts.clear();
+    for (size_t j = 0; j < schema.size(); ++ j)
+        delete schema[j];
+    schema.clear();
+
+    pthread_cond_destroy(&scond);
+    pthread_mutex_destroy(&smutex);
+    pthread_mutex_destroy(&wmutex);
+    pthread_rwlock_destroy(&plock);
+} // ibis::rivus::~rivus
+
+/// Add a new column.  It has to be called before any row with the column
+/// is appended.  Return 0 if the column is added, 1 if a column with the
+/// same name and type already exists, and a negative number to indicate
+/// error.
+int ibis::rivus::addColumn(const char* cname, ibis::TYPE_T ctype,
+                           const char* cdesc, const char* idx) {
+    if (cname == 0 || *cname == 0 || ctype == ibis::UNKNOWN_TYPE)
+        return -1;
+    ibis::util::mutexLock lck(&wmutex, "rivus::addColumn");
+    for (size_t j = 0; j < schema.size(); ++ j) {
+        if (stricmp(schema[j]->name.c_str(), cname) == 0)
+            return (schema[j]->type == ctype ? 1 : -2);
+    }
+
+    int ierr = active->addColumn(cname, ctype, cdesc, idx);
+    if (ierr < 0)
+        return ierr;
+
+    colspec* cs = new colspec;
+    cs->name = cname;
+    if (cdesc != 0)
+        cs->desc = cdesc;
+    if (idx != 0)
+        cs->idx = idx;
+    cs->type = ctype;
+    schema.push_back(cs);
+
+    ibis::util::writeLock wlck(&plock, "rivus::addColumn");
+    if (naty.find(cs->name.c_str()) == naty.end())
+        naty[cs->name.c_str()] = ctype;
+    return 0;
+} // ibis::rivus::addColumn
+
+/// Set the limits on the rows held in memory.  A value of zero leaves the
+/// corresponding limit unchanged.
+void ibis::rivus::setLimits(uint32_t maxrows, double maxsec) {
+    ibis::util::mutexLock lck(&wmutex, "rivus::setLimits");
+    if (maxrows > 0)
+        maxRows = maxrows;
+    if (maxsec > 0.0)
+        maxSeconds = maxsec;
+} // ibis::rivus::setLimits
+
+/// Append a row.  The row becomes visible to the next select operation.
+/// Return 0 on success, a negative number on error.
+int ibis::rivus::appendRow(const ibis::table::row& r) {
+    int ierr;
+    bool full;
+    {
+        ibis::util::mutexLock lck(&wmutex, "rivus::appendRow");
+        ierr = active->appendRow(r);
+        if (ierr >= 0) {
+            ++ generation;
+            if (firstRow == 0)
+                firstRow = time(0);
+        }
+        full = (active->mRows() + nfrozen >= maxRows);
+    }
+    if (full)
+        (void) pthread_cond_signal(&scond);
+    return ierr;
+} // ibis::rivus::appendRow
+
+/// Append a row given as a line of text.  The values are separated by the
+/// delimiters in @c del as in ibis::tablex::appendRow.
+int ibis::rivus::appendRow(const char* line, const char* del) {
+    int ierr;
+    bool full;
+    {
+        ibis::util::mutexLock lck(&wmutex, "rivus::appendRow");
+        ierr = active->appendRow(line, del);
+        if (ierr >= 0) {
+            ++ generation;
+            if (firstRow == 0)
+                firstRow = time(0);
+        }
+        full = (active->mRows() + nfrozen >= maxRows);
+    }
+    if (full)
+        (void) pthread_cond_signal(&scond);
+    return ierr;
+} // ibis::rivus::appendRow
+
+/// Append a list of rows.  Return the number of rows appended or a
+/// negative number on error.
+int ibis::rivus::appendRows(const std::vector<ibis::table::row>& rs) {
+    int ierr;
+    bool full;
+    {
+        ibis::util::mutexLock lck(&wmutex, "rivus::appendRows");
+        ierr = active->appendRows(rs);
+        if (ierr > 0) {
+            ++ generation;
+            if (firstRow == 0)
+                firstRow = time(0);
+        }
+        full = (active->mRows() + nfrozen >= maxRows);
+    }
+    if (full)
+        (void) pthread_cond_signal(&scond);
+    return ierr;
+} // ibis::rivus::appendRows
+
+/// Create an empty in-memory buffer with the known columns.
+ibis::tafel* ibis::rivus::newBuffer() const {
+    ibis::tafel* tf = new ibis::tafel;
+    for (size_t j = 0; j < schema.size(); ++ j)
+        tf->addColumn(schema[j]->name.c_str(), schema[j]->type,
+                      schema[j]->desc.c_str(), schema[j]->idx.c_str());
+    return tf;
+} // ibis::rivus::newBuffer
+
+/// Turn the rows in the in-memory buffer into an in-memory data partition.
+/// The content of the buffer is transferred without copying and a new
+/// empty buffer takes its place.  If no row has been appended since the
+/// last call, the existing in-memory data partitions are current and this
+/// function returns without taking any lock.  The caller must not hold
+/// @c plock.
+void ibis::rivus::freeze() const {
+    if (generation() == frozenGen())
+        return;
+
+    ibis::util::mutexLock lck(&wmutex, "rivus::freeze");
+    // the appenders hold wmutex while changing generation
+    const uint64_t gen = generation();
+    frozenGen += gen - frozenGen();
+    if (active == 0 || active->mRows() == 0)
+        return;
+
+    const uint32_t nr = active->mRows();
+    ibis::table* tbl = active->toTable(name_.c_str(), desc_.c_str());
+    delete active;
+    active = newBuffer();
+    ibis::bord* brd = dynamic_cast<ibis::bord*>(tbl);
+    if (brd == 0 || brd->nRows() != nr) {
+        LOGGER(ibis::gVerbose >= 0)
+            << "Warning -- rivus[" << name_ << "]::freeze failed to convert "
+            << nr << " row" << (nr>1?"s":"") << " into an in-memory data "
+            "partition, these rows are lost";
+        delete tbl;
+        return;
+    }
+
+    ibis::util::writeLock wlck(&plock, "rivus::freeze");
+    frozen.push_back(brd);
+    nfrozen += nr;
+} // ibis::rivus::freeze
+
+/// Have the rows held in memory exceeded the limits?
+bool ibis::rivus::overLimits() const {
+    ibis::util::mutexLock lck(&wmutex, "rivus::overLimits");
+    const uint64_t nr = active->mRows() + nfrozen;
+    return (nr > 0 &&
+            (nr >= maxRows ||
+             (firstRow > 0 && difftime(time(0), firstRow) >= maxSeconds)));
+} // ibis::rivus::overLimits
+
+/// Write the in-memory data partitions to a new data partition on disk and
+/// replace them with the new one.  The caller must hold @c smutex.  Return
+/// the number of rows written or a negative number to indicate error.
+long ibis::rivus::sealMemory() {
+    std::vector<ibis::bord*> batch;
+    {
+        ibis::util::readLock rlck(&plock, "rivus::sealMemory");
+        batch = frozen;
+    }
+    if (batch.empty())
+        return 0;
+
+    // skip the names of existing data partitions
+    std::string pname, dir, mdfile;
+    do {
+        std::ostringstream oss;
+        oss << name_ << '_' << nextSeq;
+        ++ nextSeq;
+        pname = oss.str();
+        dir = topdir;
+        dir += FASTBIT_DIRSEP;
+        dir += pname;
+        mdfile = dir;
+        mdfile += FASTBIT_DIRSEP;
+        mdfile += "-part.txt";
+    } while (ibis::util::getFileSize(mdfile.c_str()) > 0);
+
+    ibis::horometer timer;
+    if (ibis::gVerbose > 1)
+        timer.start();
+    uint64_t nr = 0;
+    for (size_t j = 0; j < batch.size(); ++ j) {
+        int ierr = batch[j]->backup(dir.c_str(), pname.c_str(),
+                                    desc_.c_str());
+        if (ierr < 0) {
+            LOGGER(ibis::gVerbose >= 0)
+                << "Warning -- rivus[" << name_ << "]::sealMemory failed to "
+                "write in-memory data partition " << j << " to " << dir
+                << ", ierr = " << ierr;
+            ibis::util::removeDir(dir.c_str());
+            return -1;
+        }
+        nr += batch[j]->nRows();
+    }
+
+    std::unique_ptr<ibis::part> pt;
+    try {
+        pt.reset(new ibis::part(dir.c_str(), static_cast<const char*>(0)));
+    }
+    catch (...) {
+    }
+    if (pt.get() == 0 || pt->nRows() != nr) {
+        LOGGER(ibis::gVerbose >= 0)
+            << "Warning -- rivus[" << name_ << "]::sealMemory expected "
+            << nr << " row" << (nr>1?"s":"") << " in " << dir
+            << ", but found " << (pt.get() != 0 ? pt->nRows() : 0);
+        pt.reset();
+        ibis::util::removeDir(dir.c_str());
+        return -2;
+    }
+
+    {
+        ibis::util::writeLock wlck(&plock, "rivus::sealMemory");
+        frozen.erase(frozen.begin(), frozen.begin()+batch.size());
+        nfrozen -= nr;
+        pt->combineNames(naty);
+        nrows += pt->nRows();
+        parts.push_back(pt.release());
+    }
+    {
+        ibis::util::mutexLock lck(&wmutex, "rivus::sealMemory");
+        if (nfrozen == 0 && active->mRows() == 0)
+            firstRow = 0;
+        else if (firstRow > 0)
+            firstRow = time(0);
+    }
+    for (size_t j = 0; j < batch.size(); ++ j)
+        delete batch[j];
+
+    if (ibis::gVerbose > 1) {
+        timer.stop();
+        ibis::util::logger lg;
+        lg() << "rivus[" << name_ << "]::sealMemory wrote " << nr << " row"
+             << (nr>1?"s":"") << " to " << dir << " in "
+             << timer.realTime() << " sec";
+    }
+    return nr;
+} // ibis::rivus::sealMemory
+
+/// The main loop of the thread writing the in-memory data to disk.  It
+/// wakes up once a second or when signaled by the writers.  This function
+/// is started by the constructor and is not meant to be called otherwise.
+void ibis::rivus::sealerLoop() {
+    ibis::util::mutexLock lck(&smutex, "rivus::sealerLoop");
+    while (! stopping) {
+        struct timespec tsp;
+        tsp.tv_sec = time(0) + 1;
+        tsp.tv_nsec = 0;
+        (void) pthread_cond_timedwait(&scond, &smutex, &tsp);
+        if (stopping)
+            break;
+        if (overLimits()) {
+            freeze();
+            (void) sealMemory();
+        }
+    }
+} // ibis::rivus::sealerLoop
+
+/// Write all rows in memory to disk.  Returns the number of rows written
+/// or a negative number to indicate error.
+int ibis::rivus::flush() {
+    freeze();
+    ibis::util::mutexLock lck(&smutex, "rivus::flush");
+    return sealMemory();
+} // ibis::rivus::flush
+
+/// Collect the data partitions on disk and in memory.  The caller must
+/// hold a read lock on @c plock.
+void ibis::rivus::gatherPartitions(ibis::constPartList& lst) const {
+    lst.clear();
+    lst.reserve(parts.size() + frozen.size());
+    for (size_t j = 0; j < parts.size(); ++ j)
+        lst.push_back(parts[j]);
+    for (size_t j = 0; j < frozen.size(); ++ j)
+        lst.push_back(frozen[j]);
+} // ibis::rivus::gatherPartitions
+
+/// The number of rows, including those in memory.
+uint64_t ibis::rivus::nRows() const {
+    uint64_t nr;
+    {
+        ibis::util::readLock rlck(&plock, "rivus::nRows");
+        nr = nrows + nfrozen;
+    }
+    ibis::util::mutexLock lck(&wmutex, "rivus::nRows");
+    return nr + active->mRows();
+} // ibis::rivus::nRows
+
+/// The number of columns.  If no column has been declared through
+/// addColumn, it is the number of columns in the data partitions on disk.
+uint32_t ibis::rivus::nColumns() const {
+    ibis::util::readLock rlck(&plock, "rivus::nColumns");
+    return (schema.empty() ? ibis::mensa::nColumns() : schema.size());
+} // ibis::rivus::nColumns
+
+ibis::table::stringArray ibis::rivus::columnNames() const {
+    ibis::util::readLock rlck(&plock, "rivus::columnNames");
+    if (schema.empty())
+        return ibis::mensa::columnNames();
+
+    ibis::table::stringArray res(schema.size());
+    for (size_t j = 0; j < schema.size(); ++ j)
+        res[j] = schema[j]->name.c_str();
+    return res;
+} // ibis::rivus::columnNames
+
+ibis::table::typeArray ibis::rivus::columnTypes() const {
+    ibis::util::readLock rlck(&plock, "rivus::columnTypes");
+    if (schema.empty())
+        return ibis::mensa::columnTypes();
+
+    ibis::table::typeArray res(schema.size());
+    for (size_t j = 0; j < schema.size(); ++ j)
+        res[j] = schema[j]->type;
+    return res;
+} // ibis::rivus::columnTypes
+
+/// Retrieve the data partitions on disk.  The in-memory data partitions
+/// are not included.
+int ibis::rivus::getPartitions(ibis::constPartList& lst) const {
+    ibis::util::readLock rlck(&plock, "rivus::getPartitions");
+    return ibis::mensa::getPartitions(lst);
+} // ibis::rivus::getPartitions
+
+void ibis::rivus::estimate(const char* cond,
+                           uint64_t& nmin, uint64_t& nmax) const {
+    nmin = 0;
+    nmax = 0;
+    ibis::countQuery qq;
+    int ierr = qq.setWhereClause(cond);
+    if (ierr < 0) {
+        nmax = nRows();
+        return;
+    }
+
+    freeze();
+    ibis::util::readLock rlck(&plock, "rivus::estimate");
+    ibis::constPartList lst;
+    gatherPartitions(lst);
+    for (size_t j = 0; j < lst.size(); ++ j) {
+        ierr = qq.setPartition(lst[j]);
+        if (ierr >= 0)
+            ierr = qq.estimate();
+        if (ierr >= 0) {
+            nmin += qq.getMinNumHits();
+            nmax += qq.getMaxNumHits();
+        }
+        else {
+            nmax += lst[j]->nRows();
+        }
+    }
+} // ibis::rivus::estimate
+
+void ibis::rivus::estimate(const ibis::qExpr* cond,
+                           uint64_t& nmin, uint64_t& nmax) const {
+    nmin = 0;
+    nmax = 0;
+    ibis::countQuery qq;
+    int ierr = qq.setWhereClause(cond);
+    if (ierr < 0) {
+        nmax = nRows();
+        return;
+    }
+
+    freeze();
+    ibis::util::readLock rlck(&plock, "rivus::estimate");
+    ibis::constPartList lst;
+    gatherPartitions(lst);
+    for (size_t j = 0; j < lst.size(); ++ j) {
+        ierr = qq.setPartition(lst[j]);
+        if (ierr >= 0)
+            ierr = qq.estimate();
+        if (ierr >= 0) {
+            nmin += qq.getMinNumHits();
+            nmax += qq.getMaxNumHits();
+        }
+        else {
+            nmax += lst[j]->nRows();
+        }
+    }
+} // ibis::rivus::estimate
+
+/// Select the rows satisfying the conditions from the data partitions on
+/// disk and the rows in memory.  All rows appended before this function
+/// is called are considered.
+ibis::table* ibis::rivus::select(const char* sel, const char* cond) const {
+    if (cond == 0 || *cond == 0) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- rivus::select requires a valid where clause";
+        return 0;
+    }
+
+    freeze();
+    ibis::util::readLock rlck(&plock, "rivus::select");
+    ibis::constPartList lst;
+    gatherPartitions(lst);
+    if (lst.empty()) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- rivus::select requires a non-empty table";
+        return 0;
+    }
+
+    if (sel != 0) // skip leading space
+        while (isspace(*sel)) ++ sel;
+    if (sel == 0 || *sel == 0 || stricmp(sel, "count(*)") == 0) {
+        int64_t nhits = ibis::table::computeHits(lst, cond);
+        if (nhits < 0)
+            return 0;
+
+        std::string des = name_;
+        if (! desc_.empty()) {
+            des += " -- ";
+            des += desc_;
+        }
+        if (sel == 0 || *sel == 0)
+            return new ibis::tabula(cond, des.c_str(), nhits);
+        else
+            return new ibis::tabele(cond, des.c_str(), nhits, sel);
+    }
+    return ibis::table::select(lst, sel, cond);
+} // ibis::rivus::select
+
+/// Select the rows satisfying the query expression from the data
+/// partitions on disk and the rows in memory.
+ibis::table* ibis::rivus::select(const char* sel,
+                                 const ibis::qExpr* cond) const {
+    if (cond == 0) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- rivus::select requires a valid query expression";
+        return 0;
+    }
+
+    freeze();
+    ibis::util::readLock rlck(&plock, "rivus::select");
+    ibis::constPartList lst;
+    gatherPartitions(lst);
+    if (lst.empty())
+        return 0;
+    return ibis::table::select(lst, sel, cond);
+} // ibis::rivus::select
@@ -0,0 +1,139 @@
+// File: $Id$
+// Author: John Wu <John.Wu at acm.org>
+//      Lawrence Berkeley National Laboratory
+// Copyright (c) 2007-2016 the Regents of the University of California
+#ifndef IBIS_RIVUS_H
+#define IBIS_RIVUS_H
+#include "mensa.h"	// ibis::mensa
+#include "tafel.h"	// ibis::tafel
+
+/**@file
+
+A table that accepts a stream of new rows.  The most recent rows are kept
+in memory and are answered together with the data partitions on disk.
+ */
+namespace ibis {
+    class rivus;
+    class bord;
+} // namespace ibis
+
+/// Class ibis::rivus is a table that accepts new rows continuously and
+/// makes them available to queries right away.  The rows are appended to
+/// an in-memory buffer (an ibis::tafel).  A query first turns the
+/// buffered rows into an in-memory data partition (an ibis::bord) and
+/// then evaluates the query on these in-memory data partitions together
+/// with the data partitions on disk.  Each append increments a generation
+/// counter, and the in-memory data partitions are reused without locking
+/// the in-memory buffer as long as no new row has arrived.
+///
+/// Once the number of rows held in memory reaches a limit, or the oldest
+/// of them has been held for longer than a time limit, the in-memory data
+/// partitions are written to a new subdirectory of the top-level data
+/// directory by a separate thread.  The new on-disk data partition
+/// replaces the in-memory ones when the writing is complete.  The writers
+/// only need to wait while the in-memory buffer is handed over, and the
+/// readers only need to wait while the lists of data partitions are
+/// updated.  The limits are specified through the parameters
+/// <table-name>.maxMemoryRows (default 1000000) and
+/// <table-name>.maxMemorySeconds (default 60) or the function
+/// setLimits.  The writing thread checks the limits once a second and
+/// whenever the writers find the row limit reached.
+///
+/// @note The functions select, estimate and nRows include the rows in
+/// memory.  The other functions inherited from ibis::mensa, such as
+/// createCursor and getColumnAsDoubles, only see the data partitions on
+/// disk.  Call function flush before using them to get a stable view of
+/// all rows.
+///
+/// @note Rivus is a Latin word for "stream."
+class ibis::rivus : public ibis::mensa {
+public:
+    rivus(const char* dir, const char* tname, const char* tdesc=0);
+    virtual ~rivus();
+
+    virtual uint64_t nRows() const;
+    virtual uint32_t nColumns() const;
+    virtual typeArray columnTypes() const;
+    virtual stringArray columnNames() const;
+    virtual int getPartitions(ibis::constPartList&) const;
+
+    int addColumn(const char* cname, ibis::TYPE_T ctype,
+		  const char* cdesc=0, const char* idx=0);
+    int appendRow(const ibis::table::row&);
+    int appendRow(const char* line, const char* del=0);
+    int appendRows(const std::vector<ibis::table::row>&);
+
+    void setLimits(uint32_t maxrows, double maxsec);
+    int flush();
+
+    virtual void estimate(const char* cond,
+			  uint64_t& nmin, uint64_t& nmax) const;
+    virtual void estimate(const ibis::qExpr* cond,
+			  uint64_t& nmin, uint64_t& nmax) const;
+    using table::select;
+    virtual table* select(const char* sel, const char* cond) const;
+    virtual table* select(const char* sel, const ibis::qExpr* cond) const;
+
+    long sealMemory();
+    void sealerLoop();
+
+protected:
+    /// Description of a column, used to start new in-memory buffers.
+    struct colspec {
+	std::string name;
+	std::string desc;
+	std::string idx;
+	ibis::TYPE_T type;
+    }; // colspec
+
+    /// The top-level data directory.
+    std::string topdir;
+    /// The columns in the order they were added.
+    std::vector<colspec*> schema;
+    /// The in-memory buffer receiving new rows.
+    mutable ibis::tafel* active;
+    /// Time when the first row in the in-memory buffer was received.
+    mutable time_t firstRow;
+    /// In-memory data partitions not yet written to disk.
+    mutable std::vector<ibis::bord*> frozen;
+    /// Number of rows in the in-memory data partitions.
+    mutable uint64_t nfrozen;
+    /// Generation of the in-memory buffer, incremented by every append.
+    ibis::util::sharedInt64 generation;
+    /// The generation of the in-memory buffer when it was last frozen.
+    /// Only changed by freeze while holding @c wmutex.
+    mutable ibis::util::sharedInt64 frozenGen;
+    /// Sequence number for naming the next on-disk data partition.
+    unsigned nextSeq;
+    /// Limit on the number of rows in memory.
+    uint32_t maxRows;
+    /// Limit on the age of the rows in memory (in seconds).
+    double maxSeconds;
+    /// Has the thread writing the in-memory data partitions been asked
+    /// to stop?
+    bool stopping;
+    /// Is the thread writing the in-memory data partitions running?
+    bool running;
+    /// The thread writing the in-memory data partitions.
+    pthread_t sealer;
+
+    /// Protects the in-memory buffer @c active and @c firstRow.
+    mutable pthread_mutex_t wmutex;
+    /// Protects the lists of data partitions.
+    mutable pthread_rwlock_t plock;
+    /// Serializes the writing of in-memory data partitions.
+    pthread_mutex_t smutex;
+    /// Used to wake up the writing thread.
+    pthread_cond_t scond;
+
+    ibis::tafel* newBuffer() const;
+    void freeze() const;
+    bool overLimits() const;
+    void gatherPartitions(ibis::constPartList&) const;
+
+private:
+    // disallow copying.
+    rivus(const rivus&);
+    rivus& operator=(const rivus&);
+}; // ibis::rivus
+#endif // IBIS_RIVUS_H
@@ -63,6 +63,7 @@ namespace ibis {
     class table;
     class tablex;
     class tableList;
+    class bitvector;
 } // namespace ibis
 
 /// @ingroup FastBitMain
@@ -910,8 +911,20 @@ public:
     virtual int getColumnAsOpaque(uint32_t cnum, ibis::opaque& val) const =0;
     ///@}
 
+    virtual int64_t fetchBatch(uint64_t nr, ibis::table::bufferArray& buf,
+                               std::vector<ibis::bitvector>& valid);
+
 protected:
     cursor() {};
+
+    static int prepareBatch(const ibis::table::typeArray& tps, uint64_t nr,
+                            ibis::table::bufferArray& buf,
+                            std::vector<ibis::bitvector>& valid);
+    static void appendBatch(ibis::TYPE_T t, const void* in, uint64_t begin,
+                            uint64_t n, void* out);
+    static void appendValid(const ibis::bitvector& mask, uint64_t begin,
+                            uint64_t n, ibis::bitvector& valid);
+
     cursor(const cursor&); // not implemented
     cursor& operator=(const cursor&) ; // not implemented
 }; // ibis::table::cursor
@@ -9,6 +9,7 @@
 #include "tafel.h"      // ibis::tafel
 #include "bord.h"       // ibis::part, ibis::bord
 #include "blob.h"       // ibis::opaque
+#include "colpack.h"    // ibis::colpack
 
 #include <fstream>      // std::ofstream
 #include <limits>       // std::numeric_limits
@@ -2150,6 +2151,11 @@ int ibis::tafel::writeData(const char* dir, const char* tname,
         std::string cnm = mydir;
         cnm += FASTBIT_DIRSEP;
         cnm += (*it).first;
+        if (ibis::colpack::isPacked(cnm.c_str())) {
+            // restore the raw data file before appending to it
+            ibis::fileManager::instance().flushFile(cnm.c_str());
+            (void) ibis::colpack::unpack(cnm.c_str());
+        }
         int fdes = UnixOpen(cnm.c_str(), OPEN_WRITEADD, OPEN_FILEMODE);
         if (fdes < 0) {
             LOGGER(ibis::gVerbose >= 0)
@@ -3306,6 +3312,21 @@ int ibis::tafel::appendRow(const char* line, const char* del) {
     return ierr;
 } // ibis::tafel::appendRow
 
+/// Read the records in a text file.  The values of each record are
+/// expected to be on one line and separated by the given delimiters.  The
+/// values are assigned to the columns in the order they are specified
+/// through addColumn.  If maxrows is positive and outdir is not empty,
+/// the in-memory records are written to outdir whenever there are more
+/// than maxrows of them.
+///
+/// A file larger than 4 MB is processed with multiple threads.  The
+/// number of threads is taken from the parameter
+/// "tafel.readCSV.threads", which defaults to the number of processors
+/// online.  Setting the parameter to 1 selects the sequential reader.  See
+/// readCSVParallel for details.
+///
+/// Return the number of records read or a negative number to indicate
+/// error.
 int ibis::tafel::readCSV(const char* filename, int maxrows,
                          const char* outdir, const char* del) {
     if (filename == 0 || *filename == 0) {
@@ -3319,6 +3340,22 @@ int ibis::tafel::readCSV(const char* filename, int maxrows,
             "improper initialization (colorder is empty)";
         return -2;
     }
+    long nthr = 1;
+    const char *nstr = ibis::gParameters()["tafel.readCSV.threads"];
+    if (nstr != 0 && *nstr != 0) {
+        nthr = strtol(nstr, 0, 0);
+    }
+#if defined(_SC_NPROCESSORS_ONLN)
+    else {
+        nthr = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+#endif
+    if (nthr > 1 && ibis::util::getFileSize(filename) > 4194304) {
+        if (nthr > 256)
+            nthr = 256;
+        return readCSVParallel(filename, maxrows, outdir, del, nthr);
+    }
+
     ibis::horometer timer;
     timer.start();
 
@@ -3458,6 +3495,534 @@ int ibis::tafel::readCSV(const char* filename, int maxrows,
     return ret;
 } // ibis::tafel::readCSV
 
+/// Locate the end of the CSV record starting at @c s.  A record ends with
+/// a new line character that is not inside a quoted string.  As in
+/// ibis::util::readString, a quote only starts a quoted string when it is
+/// the first character of a field, and a quote preceded by a back slash
+/// does not end the string.  A comment line ends at the first new line.
+/// Return the position following the new line character, or a nil
+/// pointer if the record is not complete before @c end.
+static const char* _ibis_tafel_record_end(const char *s, const char *end,
+                                          const char *del) {
+    while (s < end && *s != '\n' && isspace(*s)) ++ s;
+    if (s < end && (*s == '#' || (*s == '-' && s+1 < end && s[1] == '-'))) {
+        s = static_cast<const char*>(memchr(s, '\n', end - s));
+        return (s != 0 ? s + 1 : s);
+    }
+
+    bool start = true; // at the start of a field
+    while (s < end) {
+        if (*s == '\n') {
+            return s + 1;
+        }
+        else if (start && (*s == '\'' || *s == '"')) {
+            const char quote = *s;
+            for (++ s; s < end && (*s != quote || s[-1] == '\\'); ++ s);
+            if (s >= end)
+                return 0;
+            start = false;
+        }
+        else if (strchr(del, *s) != 0) {
+            start = true;
+        }
+        else if (isspace(*s) == 0) {
+            start = false;
+        }
+        ++ s;
+    }
+    return 0;
+} // _ibis_tafel_record_end
+
+/// A block of CSV records to be parsed by one thread.
+struct ibis_tafel_csv_chunk {
+    const char *begin; ///!< Start of the first record.
+    const char *end;   ///!< End of the last record.
+    uint32_t nrec;     ///!< Number of records in the block.
+    int ierr;          ///!< Return value of readCSVBlock.
+    ibis::tafel *tab;  ///!< Receives the values parsed.
+};
+
+/// Arguments to the thread function ibis_tafel_read_csv.
+struct ibis_tafel_csv_pool {
+    ibis::util::counter cnt;
+    std::vector<ibis_tafel_csv_chunk> &chunks;
+    const char *del;
+    const char *id;
+
+    ibis_tafel_csv_pool(std::vector<ibis_tafel_csv_chunk> &c, const char *d,
+                        const char *i) : cnt(), chunks(c), del(d), id(i) {}
+};
+
+extern "C" {
+    /// The thread function to parse blocks of CSV records.
+    static void* ibis_tafel_read_csv(void* arg) {
+        if (arg == 0) return reinterpret_cast<void*>(-1L);
+        ibis_tafel_csv_pool &pool =
+            *(reinterpret_cast<ibis_tafel_csv_pool*>(arg));
+        for (uint32_t i = pool.cnt(); i < pool.chunks.size(); i = pool.cnt()) {
+            ibis_tafel_csv_chunk &chk = pool.chunks[i];
+            try {
+                chk.tab->reserveBuffer(chk.nrec);
+                chk.ierr = chk.tab->readCSVBlock(chk.begin, chk.end,
+                                                 pool.del, pool.id);
+            }
+            catch (...) {
+                chk.ierr = -4;
+            }
+        }
+        return 0;
+    } // ibis_tafel_read_csv
+} // extern "C"
+
+/// Parse the CSV records in the memory between @c begin and @c end.  The
+/// records are separated by new line characters that are not inside
+/// quoted strings, and the last record does not need to be terminated.
+/// Blank lines and comment lines are skipped.  The argument @c id is used
+/// to identify the source in log messages.
+///
+/// Return the number of records appended, or a negative number to
+/// indicate error.  It may throw exceptions if it runs out of memory.
+int ibis::tafel::readCSVBlock(const char* begin, const char* end,
+                              const char* del, const char* id) {
+    if (begin == 0 || end <= begin) return 0;
+    if (colorder.empty()) return -2;
+    if (del == 0 || *del == 0)
+        del = " ,;\t\n\v";
+    if (id == 0)
+        id = "";
+
+    int ret = 0;
+    uint32_t cnt = 0;
+    std::string line;
+    const uint32_t ncol = colorder.size();
+    while (begin < end) {
+        const char *next = _ibis_tafel_record_end(begin, end, del);
+        if (next == 0)
+            next = end;
+        while (begin < next && isspace(*begin)) ++ begin;
+        if (begin < next && *begin != '#' &&
+            ! (*begin == '-' && begin+1 < next && begin[1] == '-')) {
+            line.assign(begin, next[-1] == '\n' ? next-1 : next);
+            if (0 < cnt && cnt < ncol)
+                normalize();
+            cnt = parseLine(line.c_str(), del, id);
+            mrows += (cnt > 0);
+            ret += (cnt > 0);
+        }
+        begin = next;
+    }
+    if (0 < cnt && cnt < ncol)
+        normalize();
+    return ret;
+} // ibis::tafel::readCSVBlock
+
+/// Read a CSV file with @c nthr threads.  The file is read in blocks of
+/// 8 MB per thread through ibis::fileManager::getFileSegment, which memory
+/// maps the blocks when possible.  The records in a block are located with a single sequential
+/// scan and divided into @c nthr chunks of roughly equal sizes.  Each
+/// thread parses its chunks into a separate tafel object, and the results
+/// are appended to this object in the order of the chunks.  Therefore the
+/// records are stored in the same order as in the file.
+///
+/// When outdir is specified, the in-memory records are written out after
+/// a chunk brings the number of rows to maxrows or more.  Unlike the
+/// sequential reader, the data partitions written may contain somewhat
+/// more than maxrows rows.
+///
+/// Return the number of records read or a negative number to indicate
+/// error.
+int ibis::tafel::readCSVParallel(const char* filename, int maxrows,
+                                 const char* outdir, const char* del,
+                                 uint32_t nthr) {
+    std::string evt = "tafel::readCSVParallel(";
+    evt += filename;
+    evt += ')';
+    const off_t fsize = ibis::util::getFileSize(filename);
+    if (fsize <= 0) {
+        LOGGER(ibis::gVerbose >= 0)
+            << "Warning -- " << evt << " failed to determine the size of "
+            "the named file";
+        return -3;
+    }
+    ibis::horometer timer;
+    timer.start();
+    if (del == 0 || *del == 0)
+        del = " ,;\t\n\v";
+    if (maxrows <= 0)
+        maxrows = preferredSize();
+    if (maxrows > 1) {
+        try { // try to reserve request amount of space
+            reserveBuffer(maxrows);
+        }
+        catch (...) {
+            LOGGER(ibis::gVerbose > 0)
+                << evt << " -- failed to reserve space for "
+                << maxrows << " rows for reading, continue anyway";
+        }
+    }
+
+    std::vector<ibis_tafel_csv_chunk> chunks(nthr);
+    std::vector<ibis::tafel*> tabs(nthr);
+    for (uint32_t j = 0; j < nthr; ++ j) {
+        tabs[j] = spawn();
+        chunks[j].tab = tabs[j];
+    }
+    pthread_attr_t tattr;
+    int ierr = pthread_attr_init(&tattr);
+    if (ierr == 0) {
+#if defined(PTHREAD_SCOPE_SYSTEM)
+        ierr = pthread_attr_setscope(&tattr, PTHREAD_SCOPE_SYSTEM);
+        if (ierr != 0
+#if defined(ENOTSUP)
+            && ierr != ENOTSUP
+#endif
+            ) {
+            LOGGER(ibis::gVerbose > 1)
+                << "Warning -- " << evt << " pthread_attr_setscope failed "
+                "to set system scope (ierr = " << ierr << ')';
+        }
+#endif
+        ierr = 0;
+    }
+    else {
+        LOGGER(ibis::gVerbose > 2)
+            << evt << " -- pthread_attr_init completed with " << ierr
+            << ", using default attributes";
+    }
+    const bool useattr = (ierr == 0);
+    std::vector<pthread_t> tid(nthr-1);
+
+    int ret = 0;
+    uint64_t iline = 0;
+    off_t blksz = (off_t) nthr << 23; // 8 MB per thread
+    off_t pos = 0;
+    while (pos < fsize && ret >= 0) {
+        const off_t blkend = (pos + blksz < fsize ? pos + blksz : fsize);
+        // the block is owned here so that a mapped segment is released
+        // as soon as its records are parsed
+        std::unique_ptr<ibis::fileManager::storage> blk;
+        try {
+            blk.reset(ibis::fileManager::getFileSegment
+                      (filename, -1, pos, blkend));
+        }
+        catch (...) {
+            blk.reset();
+        }
+        if (blk.get() == 0 ||
+            blk->size() != static_cast<size_t>(blkend - pos)) {
+            LOGGER(ibis::gVerbose >= 0)
+                << "Warning -- " << evt << " failed to read bytes " << pos
+                << " -- " << blkend;
+            ret = -3;
+            break;
+        }
+
+        // divide the records into nthr chunks of roughly equal sizes
+        const char *const b0 = blk->begin();
+        const char *const b1 = blk->end();
+        const size_t len = b1 - b0;
+        const char *rec = b0;
+        uint32_t k = 0;
+        chunks[0].begin = b0;
+        chunks[0].nrec = 0;
+        while (rec < b1) {
+            const char *next = _ibis_tafel_record_end(rec, b1, del);
+            if (next == 0) {
+                if (blkend < fsize)
+                    break; // the rest will be read with the next block
+                next = b1;
+            }
+            rec = next;
+            ++ chunks[k].nrec;
+            if (k+1 < nthr &&
+                static_cast<size_t>(rec - b0) >= len * (k+1) / nthr) {
+                chunks[k].end = rec;
+                ++ k;
+                chunks[k].begin = rec;
+                chunks[k].nrec = 0;
+            }
+        }
+        if (rec == b0) { // a single record longer than the block
+            blksz += blksz;
+            LOGGER(ibis::gVerbose > 2)
+                << evt << " found no complete record in bytes " << pos
+                << " -- " << blkend << ", increasing block size to "
+                << blksz;
+            continue;
+        }
+        chunks[k].end = rec;
+        for (++ k; k < nthr; ++ k) {
+            chunks[k].begin = rec;
+            chunks[k].end = rec;
+            chunks[k].nrec = 0;
+        }
+
+        // parse the chunks
+        ibis_tafel_csv_pool pool(chunks, del, filename);
+        for (uint32_t j = 0; j+1 < nthr; ++ j) {
+            ierr = pthread_create(&(tid[j]), (useattr ? &tattr : 0),
+                                  ibis_tafel_read_csv, (void*)&pool);
+            if (0 != ierr) {
+                tid[j] = pthread_self();
+                LOGGER(ibis::gVerbose > 0)
+                    << "Warning -- " << evt << " could not start thread # "
+                    << j << " to run ibis_tafel_read_csv ("
+                    << strerror(ierr) << ')';
+            }
+        }
+        (void) ibis_tafel_read_csv((void*)&pool);
+        for (uint32_t j = 0; j+1 < nthr; ++ j) {
+            if (pthread_equal(tid[j], pthread_self()) == 0) {
+                void *st;
+                pthread_join(tid[j], &st);
+            }
+        }
+
+        // append the results in order
+        for (k = 0; k < nthr; ++ k) {
+            iline += chunks[k].nrec;
+            if (chunks[k].ierr < 0) {
+                LOGGER(ibis::gVerbose >= 0)
+                    << "Warning -- " << evt << " failed to parse the "
+                    << chunks[k].nrec << " record" << (chunks[k].nrec>1?"s":"")
+                    << " starting at byte " << pos + (chunks[k].begin - b0)
+                    << ", readCSVBlock returned " << chunks[k].ierr;
+                ret = -4;
+                break;
+            }
+            if (concat(*(tabs[k])) < 0) {
+                ret = -5;
+                break;
+            }
+            if (maxrows > 1 && mrows >= static_cast<unsigned>(maxrows) &&
+                outdir != 0 && *outdir != 0) {
+                ierr = write(outdir, 0, 0, 0);
+                if (ierr < 0) {
+                    ret = ierr - 20;
+                    break;
+                }
+                ret += mrows;
+                clearData();
+            }
+        }
+        LOGGER(ibis::gVerbose > 2 && ret >= 0)
+            << evt << " processed " << iline << " line"
+            << (iline>1?"s":"") << " ...";
+        pos += (rec - b0);
+    }
+
+    if (useattr)
+        pthread_attr_destroy(&tattr);
+    for (uint32_t j = 0; j < nthr; ++ j)
+        delete tabs[j];
+    if (ret < 0) {
+        if (outdir != 0 && *outdir != 0 && mrows > 0) {
+            // preserve the records already in memory
+            (void) write(outdir, 0, 0, 0);
+            clearData();
+        }
+        return ret;
+    }
+
+    ret += mrows;
+    timer.stop();
+    LOGGER(ibis::gVerbose > 0)
+        << evt << " processed " << iline << (iline>1 ? " lines":" line")
+        << " of text and extracted " << ret << (ret>1?" records":" record")
+        << " using " << nthr << " threads, " << timer.CPUTime()
+        << " sec(CPU), " << timer.realTime() << " sec(elapsed)";
+    return ret;
+} // ibis::tafel::readCSVParallel
+
+/// Create an empty tafel object with the same columns as this one.  The
+/// names, types, descriptions, index specifications, ASCII dictionaries
+/// and default values are copied, but not the data.  The caller is
+/// responsible for freeing the object returned.
+ibis::tafel* ibis::tafel::spawn() const {
+    ibis::tafel *tab = new ibis::tafel;
+    for (uint32_t j = 0; j < colorder.size(); ++ j) {
+        const column &col = *(colorder[j]);
+        tab->addColumn(col.name.c_str(), col.type, col.desc.c_str(),
+                       col.indexSpec.c_str());
+        column &nc = *(tab->colorder.back());
+        nc.dictfile = col.dictfile;
+        if (col.defval == 0) continue;
+
+        switch (col.type) {
+        case ibis::BYTE:
+            nc.defval = new signed char(*static_cast<signed char*>(col.defval));
+            break;
+        case ibis::UBYTE:
+            nc.defval =
+                new unsigned char(*static_cast<unsigned char*>(col.defval));
+            break;
+        case ibis::SHORT:
+            nc.defval = new int16_t(*static_cast<int16_t*>(col.defval));
+            break;
+        case ibis::USHORT:
+            nc.defval = new uint16_t(*static_cast<uint16_t*>(col.defval));
+            break;
+        case ibis::INT:
+            nc.defval = new int32_t(*static_cast<int32_t*>(col.defval));
+            break;
+        case ibis::UINT:
+            nc.defval = new uint32_t(*static_cast<uint32_t*>(col.defval));
+            break;
+        case ibis::LONG:
+            nc.defval = new int64_t(*static_cast<int64_t*>(col.defval));
+            break;
+        case ibis::ULONG:
+            nc.defval = new uint64_t(*static_cast<uint64_t*>(col.defval));
+            break;
+        case ibis::FLOAT:
+            nc.defval = new float(*static_cast<float*>(col.defval));
+            break;
+        case ibis::DOUBLE:
+            nc.defval = new double(*static_cast<double*>(col.defval));
+            break;
+        case ibis::TEXT:
+        case ibis::CATEGORY:
+            nc.defval =
+                new std::string(*static_cast<std::string*>(col.defval));
+            break;
+        case ibis::BLOB:
+            nc.defval =
+                new ibis::opaque(*static_cast<ibis::opaque*>(col.defval));
+            break;
+        default:
+            break;
+        }
+    }
+    return tab;
+} // ibis::tafel::spawn
+
+/// Append the records in @c rhs to this object and remove them from @c
+/// rhs.  The two objects must have the same columns in the same order,
+/// such as a tafel object and the one produced by its function spawn.
+/// Return the number of rows appended or a negative number to indicate
+/// error.
+int ibis::tafel::concat(ibis::tafel& rhs) {
+    if (rhs.colorder.size() != colorder.size()) return -1;
+    rhs.normalize();
+    if (rhs.mrows == 0) return 0;
+
+    normalize();
+    const ibis::bitvector::word_t nr = rhs.mrows;
+    for (uint32_t j = 0; j < colorder.size(); ++ j) {
+        column &col = *(colorder[j]);
+        column &rc = *(rhs.colorder[j]);
+        if (col.type != rc.type) return -2;
+        if (col.values == 0) {
+            reserveBuffer(mrows + nr);
+            if (col.values == 0) return -3;
+        }
+        if (rc.values == 0) return -4;
+
+        switch (col.type) {
+        case ibis::BYTE: {
+            array_t<signed char> &vals =
+                *static_cast<array_t<signed char>*>(col.values);
+            const array_t<signed char> &rv =
+                *static_cast<array_t<signed char>*>(rc.values);
+            vals.insert(vals.end(), rv.begin(), rv.end());
+            break;}
+        case ibis::UBYTE: {
+            array_t<unsigned char> &vals =
+                *static_cast<array_t<unsigned char>*>(col.values);
+            const array_t<unsigned char> &rv =
+                *static_cast<array_t<unsigned char>*>(rc.values);
+            vals.insert(vals.end(), rv.begin(), rv.end());
+            break;}
+        case ibis::SHORT: {
+            array_t<int16_t> &vals =
+                *static_cast<array_t<int16_t>*>(col.values);
+            const array_t<int16_t> &rv =
+                *static_cast<array_t<int16_t>*>(rc.values);
+            vals.insert(vals.end(), rv.begin(), rv.end());
+            break;}
+        case ibis::USHORT: {
+            array_t<uint16_t> &vals =
+                *static_cast<array_t<uint16_t>*>(col.values);
+            const array_t<uint16_t> &rv =
+                *static_cast<array_t<uint16_t>*>(rc.values);
+            vals.insert(vals.end(), rv.begin(), rv.end());
+            break;}
+        case ibis::INT: {
+            array_t<int32_t> &vals =
+                *static_cast<array_t<int32_t>*>(col.values);
+            const array_t<int32_t> &rv =
+                *static_cast<array_t<int32_t>*>(rc.values);
+            vals.insert(vals.end(), rv.begin(), rv.end());
+            break;}
+        case ibis::UINT: {
+            array_t<uint32_t> &vals =
+                *static_cast<array_t<uint32_t>*>(col.values);
+            const array_t<uint32_t> &rv =
+                *static_cast<array_t<uint32_t>*>(rc.values);
+            vals.insert(vals.end(), rv.begin(), rv.end());
+            break;}
+        case ibis::LONG: {
+            array_t<int64_t> &vals =
+                *static_cast<array_t<int64_t>*>(col.values);
+            const array_t<int64_t> &rv =
+                *static_cast<array_t<int64_t>*>(rc.values);
+            vals.insert(vals.end(), rv.begin(), rv.end());
+            break;}
+        case ibis::OID:
+        case ibis::ULONG: {
+            array_t<uint64_t> &vals =
+                *static_cast<array_t<uint64_t>*>(col.values);
+            const array_t<uint64_t> &rv =
+                *static_cast<array_t<uint64_t>*>(rc.values);
+            vals.insert(vals.end(), rv.begin(), rv.end());
+            break;}
+        case ibis::FLOAT: {
+            array_t<float> &vals =
+                *static_cast<array_t<float>*>(col.values);
+            const array_t<float> &rv =
+                *static_cast<array_t<float>*>(rc.values);
+            vals.insert(vals.end(), rv.begin(), rv.end());
+            break;}
+        case ibis::DOUBLE: {
+            array_t<double> &vals =
+                *static_cast<array_t<double>*>(col.values);
+            const array_t<double> &rv =
+                *static_cast<array_t<double>*>(rc.values);
+            vals.insert(vals.end(), rv.begin(), rv.end());
+            break;}
+        case ibis::TEXT:
+        case ibis::CATEGORY: {
+            std::vector<std::string> &vals =
+                *static_cast<std::vector<std::string>*>(col.values);
+            std::vector<std::string> &rv =
+                *static_cast<std::vector<std::string>*>(rc.values);
+            const size_t n0 = vals.size();
+            vals.resize(n0 + rv.size());
+            for (size_t i = 0; i < rv.size(); ++ i)
+                vals[n0+i].swap(rv[i]);
+            break;}
+        case ibis::BLOB: {
+            std::vector<ibis::opaque> &vals =
+                *static_cast<std::vector<ibis::opaque>*>(col.values);
+            std::vector<ibis::opaque> &rv =
+                *static_cast<std::vector<ibis::opaque>*>(rc.values);
+            const size_t n0 = vals.size();
+            vals.resize(n0 + rv.size());
+            for (size_t i = 0; i < rv.size(); ++ i)
+                vals[n0+i].swap(rv[i]);
+            break;}
+        default:
+            break;
+        }
+        col.mask.adjustSize(mrows, mrows);
+        rc.mask.adjustSize(nr, nr);
+        col.mask += rc.mask;
+    }
+    mrows += nr;
+    rhs.clearData();
+    return nr;
+} // ibis::tafel::concat
+
 int ibis::tafel::readSQLDump(const char* filename, std::string& tname,
                              int maxrows, const char* outdir) {
     if (filename == 0 || *filename == 0) {
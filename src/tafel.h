@@ -38,6 +38,8 @@ public:
     virtual int appendRows(const std::vector<ibis::table::row>&);
     virtual int readCSV(const char* filename, int maxrows,
 			const char* outputdir, const char* delimiters);
+    int readCSVBlock(const char* begin, const char* end,
+		     const char* delimiters, const char* id);
     virtual int readSQLDump(const char* filename, std::string& tname,
 			    int maxrows, const char* outputdir);
 
@@ -151,6 +153,11 @@ protected:
 		    std::vector<std::vector<ibis::opaque>*>& buf,
 		    std::vector<ibis::bitvector*>& msk);
     int parseLine(const char* str, const char* del, const char* id);
+    int readCSVParallel(const char* filename, int maxrows,
+			const char* outputdir, const char* delimiters,
+			uint32_t nthr);
+    tafel* spawn() const;
+    int concat(tafel& rhs);
 
     int32_t doReserve(uint32_t);
     int assignDefaultValue(ibis::tafel::column &col, const char *val) const;
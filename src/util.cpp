@@ -22,6 +22,7 @@
 
 #include <set>          // std::set
 #include <limits>       // std::numeric_limits
+#include <algorithm>    // std::swap
 #include <locale>       // std::numpunct<char>
 #include <iostream>     // std::cout
 #if  (defined(HAVE_GETPWUID) || defined(HAVE_GETPWUID_R)) && !(defined(__MINGW__) || defined(__MINGW32__) || defined(__MINGW64__) || defined(__CYGWIN__))
@@ -2586,6 +2587,360 @@ void ibis::util::getGMTime(char *str) {
 #endif
 } // ibis::util::getGMTime
 
+bool ibis::util::lockStats::enabled = false;
+
+typedef std::map<std::pair<std::string, std::string>,
+                 ibis::util::lockStats::entry> _ibis_lockStats_entries;
+
+/// Add the counts in @c from to @c to.
+static void _ibis_lockStats_merge(_ibis_lockStats_entries& to,
+                                  const _ibis_lockStats_entries& from) {
+    for (_ibis_lockStats_entries::const_iterator it = from.begin();
+         it != from.end(); ++ it) {
+        const ibis::util::lockStats::entry& src = it->second;
+        ibis::util::lockStats::entry& ent = to[it->first];
+        if (ent.acquired == 0) {
+            ent.kind = src.kind;
+            ent.tag = src.tag;
+        }
+        ent.acquired += src.acquired;
+        ent.contended += src.contended;
+        ent.waitTime += src.waitTime;
+        if (ent.maxWait < src.maxWait)
+            ent.maxWait = src.maxWait;
+        for (unsigned j = 0; j < ibis::util::lockStats::nwaits; ++ j)
+            ent.waits[j] += src.waits[j];
+        for (std::map<std::string, uint64_t>::const_iterator bit =
+                 src.blockers.begin(); bit != src.blockers.end(); ++ bit)
+            ent.blockers[bit->first] += bit->second;
+    }
+} // _ibis_lockStats_merge
+
+/// The statistics collected by one thread.  The mutex is only contended
+/// when the statistics are being reported or cleared.
+struct _ibis_lockStats_local {
+    pthread_mutex_t mutex;
+    _ibis_lockStats_entries entries;
+
+    _ibis_lockStats_local();
+    ~_ibis_lockStats_local();
+}; // _ibis_lockStats_local
+
+/// The statistics of the locks and the purposes of the current holders.
+/// Each thread records the acquisitions in its own table, the tables are
+/// merged when the statistics are requested, and the tables of the
+/// threads that have terminated are merged into @c retired.  The holders
+/// are spread over a number of stripes by the addresses of the locks.
+/// The destructor turns off the statistics so that the locks used during
+/// the termination of the program do not touch the destroyed maps.
+struct _ibis_lockStats_data {
+    static const unsigned nstripes = 61;
+    struct stripe {
+        pthread_mutex_t mutex;
+        std::map<const void*, std::string> holders;
+    };
+
+    pthread_mutex_t mutex; ///!< Guards tables and retired.
+    std::set<_ibis_lockStats_local*> tables;
+    _ibis_lockStats_entries retired;
+    stripe stripes[nstripes];
+
+    _ibis_lockStats_data() {
+        (void) pthread_mutex_init(&mutex, 0);
+        for (unsigned j = 0; j < nstripes; ++ j)
+            (void) pthread_mutex_init(&(stripes[j].mutex), 0);
+    }
+    ~_ibis_lockStats_data();
+
+    stripe& stripeOf(const void* lk) {
+        return stripes[reinterpret_cast<uintptr_t>(lk) % nstripes];
+    }
+}; // _ibis_lockStats_data
+
+/// Has the shared data been destroyed?
+static bool _ibis_lockStats_gone = false;
+
+_ibis_lockStats_data::~_ibis_lockStats_data() {
+    ibis::util::lockStats::enabled = false;
+    _ibis_lockStats_gone = true;
+    (void) pthread_mutex_destroy(&mutex);
+    for (unsigned j = 0; j < nstripes; ++ j)
+        (void) pthread_mutex_destroy(&(stripes[j].mutex));
+} // _ibis_lockStats_data::~_ibis_lockStats_data
+
+static _ibis_lockStats_data& _ibis_lockStats_get() {
+    static _ibis_lockStats_data data;
+    return data;
+} // _ibis_lockStats_get
+
+/// Register the table of the current thread.
+_ibis_lockStats_local::_ibis_lockStats_local() {
+    (void) pthread_mutex_init(&mutex, 0);
+    _ibis_lockStats_data& data = _ibis_lockStats_get();
+    ibis::util::quietLock lck(&data.mutex);
+    data.tables.insert(this);
+} // _ibis_lockStats_local::_ibis_lockStats_local
+
+/// Keep the statistics of a terminating thread in the shared data.
+_ibis_lockStats_local::~_ibis_lockStats_local() {
+    if (! _ibis_lockStats_gone) {
+        _ibis_lockStats_data& data = _ibis_lockStats_get();
+        ibis::util::quietLock lck(&data.mutex);
+        data.tables.erase(this);
+        _ibis_lockStats_merge(data.retired, entries);
+    }
+    (void) pthread_mutex_destroy(&mutex);
+} // _ibis_lockStats_local::~_ibis_lockStats_local
+
+/// The table of the current thread, created on the first use.
+static _ibis_lockStats_local& _ibis_lockStats_mine() {
+    static thread_local _ibis_lockStats_local mine;
+    return mine;
+} // _ibis_lockStats_mine
+
+/// Remove the parts of a message in brackets and parentheses.  A message
+/// in the form of a query token, which the queries use to identify
+/// themselves, is replaced by "query".
+static std::string _ibis_lockStats_tag(const char* m) {
+    std::string tag;
+    if (m == 0 || *m == 0) {
+        tag = "?";
+        return tag;
+    }
+    if (std::strlen(m) == 16) {
+        bool tok = true;
+        for (unsigned j = 0; tok && j < 16; ++ j)
+            tok = (static_cast<unsigned char>(m[j]) < 127 &&
+                   ibis::util::charIndex[static_cast<unsigned>(m[j])] < 64);
+        if (tok) {
+            tag = "query";
+            return tag;
+        }
+    }
+
+    int depth = 0;
+    for (; *m != 0; ++ m) {
+        if (*m == '[' || *m == '(')
+            ++ depth;
+        else if ((*m == ']' || *m == ')') && depth > 0)
+            -- depth;
+        else if (depth == 0)
+            tag += *m;
+    }
+    return tag;
+} // _ibis_lockStats_tag
+
+/// The purpose of the current holder of the lock, or @c dflt if the
+/// holder is not known.
+static std::string _ibis_lockStats_holder(const void* lk, const char* dflt) {
+    _ibis_lockStats_data::stripe& stp = _ibis_lockStats_get().stripeOf(lk);
+    ibis::util::quietLock lck(&stp.mutex);
+    std::map<const void*, std::string>::const_iterator it =
+        stp.holders.find(lk);
+    return (it != stp.holders.end() ? it->second : std::string(dflt));
+} // _ibis_lockStats_holder
+
+/// Record an acquisition of a lock in the table of the current thread.
+/// If @c excl is true, the purpose is remembered as the holder of the
+/// lock.
+static void _ibis_lockStats_record(const void* lk, const char* kind,
+                                   const char* mesg, bool excl,
+                                   bool waited, double wait,
+                                   const std::string& blocker) {
+    const std::string tag = _ibis_lockStats_tag(mesg);
+    {
+        _ibis_lockStats_local& mine = _ibis_lockStats_mine();
+        ibis::util::quietLock lck(&mine.mutex);
+        ibis::util::lockStats::entry& ent =
+            mine.entries[std::make_pair(std::string(kind), tag)];
+        if (ent.acquired == 0) {
+            ent.kind = kind;
+            ent.tag = tag;
+        }
+        ++ ent.acquired;
+        unsigned j = 0;
+        for (double b = 1e-6; j+1 < ibis::util::lockStats::nwaits &&
+                 wait > b; b *= 10.0)
+            ++ j;
+        ++ ent.waits[j];
+        if (waited) {
+            ++ ent.contended;
+            ent.waitTime += wait;
+            if (ent.maxWait < wait)
+                ent.maxWait = wait;
+            ++ ent.blockers[blocker];
+        }
+    }
+    if (excl) {
+        _ibis_lockStats_data::stripe& stp =
+            _ibis_lockStats_get().stripeOf(lk);
+        ibis::util::quietLock lck(&stp.mutex);
+        stp.holders[lk] = tag;
+    }
+} // _ibis_lockStats_record
+
+/// Turn the collection of the statistics on or off.  The statistics
+/// collected so far are kept.
+void ibis::util::lockStats::enable(bool on) {
+    (void) _ibis_lockStats_get(); // make sure the maps exist
+    ibis::util::lockStats::enabled = on;
+} // ibis::util::lockStats::enable
+
+/// Remove the statistics collected so far.
+void ibis::util::lockStats::clear() {
+    _ibis_lockStats_data& data = _ibis_lockStats_get();
+    ibis::util::quietLock lck(&data.mutex);
+    data.retired.clear();
+    for (std::set<_ibis_lockStats_local*>::const_iterator it =
+             data.tables.begin(); it != data.tables.end(); ++ it) {
+        ibis::util::quietLock tlck(&((*it)->mutex));
+        (*it)->entries.clear();
+    }
+} // ibis::util::lockStats::clear
+
+/// Copy the statistics collected so far, in the order of decreasing total
+/// wait time.
+void ibis::util::lockStats::snapshot(std::vector<entry>& lst) {
+    lst.clear();
+    _ibis_lockStats_entries all;
+    {
+        _ibis_lockStats_data& data = _ibis_lockStats_get();
+        ibis::util::quietLock lck(&data.mutex);
+        all = data.retired;
+        for (std::set<_ibis_lockStats_local*>::const_iterator it =
+                 data.tables.begin(); it != data.tables.end(); ++ it) {
+            ibis::util::quietLock tlck(&((*it)->mutex));
+            _ibis_lockStats_merge(all, (*it)->entries);
+        }
+    }
+    lst.reserve(all.size());
+    for (_ibis_lockStats_entries::const_iterator it = all.begin();
+         it != all.end(); ++ it)
+        lst.push_back(it->second);
+    for (size_t j = 1; j < lst.size(); ++ j) { // insertion sort
+        for (size_t k = j; k > 0 &&
+                 lst[k-1].waitTime < lst[k].waitTime; -- k)
+            std::swap(lst[k-1], lst[k]);
+    }
+} // ibis::util::lockStats::snapshot
+
+/// Print the statistics, one line per kind of lock and purpose, in the
+/// order of decreasing total wait time.
+void ibis::util::lockStats::print(std::ostream& out) {
+    static const char* bnd[nwaits] = {
+        "<=1us", "<=10us", "<=100us", "<=1ms", "<=10ms", "<=100ms", "<=1s",
+        ">1s"};
+    std::vector<entry> lst;
+    snapshot(lst);
+    out << "lock statistics (" << lst.size() << " entr"
+        << (lst.size() > 1 ? "ies" : "y") << ")\n";
+    for (size_t j = 0; j < lst.size(); ++ j) {
+        const entry& ent = lst[j];
+        out << ent.kind << " for " << ent.tag << ": acquired "
+            << ent.acquired << ", waited " << ent.contended;
+        if (ent.contended > 0) {
+            out << " for " << ent.waitTime << " sec (max " << ent.maxWait
+                << " sec), waits";
+            for (unsigned k = 0; k < nwaits; ++ k)
+                if (ent.waits[k] > 0)
+                    out << ' ' << bnd[k] << ':' << ent.waits[k];
+            out << ", blocked by";
+            for (std::map<std::string, uint64_t>::const_iterator it =
+                     ent.blockers.begin(); it != ent.blockers.end(); ++ it)
+                out << ' ' << it->first << " (" << it->second << ')';
+        }
+        out << '\n';
+    }
+    out.flush();
+} // ibis::util::lockStats::print
+
+/// Acquire a mutex lock and record the acquisition.  The purpose @c tag
+/// is remembered as the holder until ibis::util::lockStats::release is
+/// called.  Returns the return value of pthread_mutex_lock.
+int ibis::util::lockStats::lock(pthread_mutex_t* lk, const char* kind,
+                                const char* tag) {
+    int ierr = pthread_mutex_trylock(lk);
+    if (ierr == 0) {
+        _ibis_lockStats_record(lk, kind, tag, true, false, 0.0,
+                               std::string());
+        return ierr;
+    }
+
+    const std::string blocker = _ibis_lockStats_holder(lk, "?");
+    ibis::horometer clock;
+    clock.start();
+    ierr = pthread_mutex_lock(lk);
+    clock.stop();
+    if (ierr == 0)
+        _ibis_lockStats_record(lk, kind, tag, true, true, clock.realTime(),
+                               blocker);
+    return ierr;
+} // ibis::util::lockStats::lock
+
+/// Acquire a read lock and measure the time waited.  The acquisition is
+/// only recorded if the statistics are enabled, which allows the caller to
+/// use the wait time elsewhere.  Returns the return value of
+/// pthread_rwlock_rdlock.
+int ibis::util::lockStats::rdlock(pthread_rwlock_t* lk, const char* kind,
+                                  const char* tag, double& wait) {
+    wait = 0.0;
+    int ierr = pthread_rwlock_tryrdlock(lk);
+    if (ierr == 0) {
+        if (enabled)
+            _ibis_lockStats_record(lk, kind, tag, false, false, 0.0,
+                                   std::string());
+        return ierr;
+    }
+
+    std::string blocker;
+    if (enabled)
+        blocker = _ibis_lockStats_holder(lk, "?");
+    ibis::horometer clock;
+    clock.start();
+    ierr = pthread_rwlock_rdlock(lk);
+    clock.stop();
+    wait = clock.realTime();
+    if (ierr == 0 && enabled)
+        _ibis_lockStats_record(lk, kind, tag, false, true, wait, blocker);
+    return ierr;
+} // ibis::util::lockStats::rdlock
+
+/// Acquire a write lock and measure the time waited.  The acquisition is
+/// only recorded if the statistics are enabled.  A lock held by readers
+/// has no known holder, the blocker is recorded as "readers".  Returns
+/// the return value of pthread_rwlock_wrlock.
+int ibis::util::lockStats::wrlock(pthread_rwlock_t* lk, const char* kind,
+                                  const char* tag, double& wait) {
+    wait = 0.0;
+    int ierr = pthread_rwlock_trywrlock(lk);
+    if (ierr == 0) {
+        if (enabled)
+            _ibis_lockStats_record(lk, kind, tag, true, false, 0.0,
+                                   std::string());
+        return ierr;
+    }
+
+    std::string blocker;
+    if (enabled)
+        blocker = _ibis_lockStats_holder(lk, "readers");
+    ibis::horometer clock;
+    clock.start();
+    ierr = pthread_rwlock_wrlock(lk);
+    clock.stop();
+    wait = clock.realTime();
+    if (ierr == 0 && enabled)
+        _ibis_lockStats_record(lk, kind, tag, true, true, wait, blocker);
+    return ierr;
+} // ibis::util::lockStats::wrlock
+
+/// Forget the holder of a lock.  To be called before the lock is
+/// released.
+void ibis::util::lockStats::release(const void* lk) {
+    _ibis_lockStats_data::stripe& stp = _ibis_lockStats_get().stripeOf(lk);
+    ibis::util::quietLock lck(&stp.mutex);
+    stp.holders.erase(lk);
+} // ibis::util::lockStats::release
+
 void ibis::nameList::select(const char* str) {
     if (str == 0) return;
     if (*str == static_cast<char>(0)) return;
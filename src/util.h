@@ -736,6 +736,66 @@ namespace ibis {
             ioLock& operator=(const ioLock&);
         };
 
+        /// Statistics on the acquisitions of the locks.  When enabled,
+        /// the lock wrappers, such as ibis::util::mutexLock,
+        /// ibis::part::readLock and ibis::column::mutexLock, count their
+        /// acquisitions and the time spent waiting, grouped by the kind
+        /// of the wrapper and the message passed to it, which tells the
+        /// purpose of the lock.  The parts of a message in brackets and
+        /// parentheses, typically the names of data partitions, columns
+        /// and files, are removed so that the same purpose is counted
+        /// together.  For the mutex locks and the write locks, the
+        /// purpose of the current holder is remembered so that a waiting
+        /// thread can tell which holder it waited for.
+        ///
+        /// An uncontended acquisition is detected with a try-lock and
+        /// does not read the clock.  Each thread counts its acquisitions
+        /// in its own table, and the tables are merged when the
+        /// statistics are requested.  When disabled, the wrappers only
+        /// test the flag ibis::util::lockStats::enabled.
+        class FASTBIT_CXX_DLLSPEC lockStats {
+        public:
+            /// The number of buckets of the wait times.
+            static const unsigned nwaits = 8;
+            /// The statistics of one kind of lock used for one purpose.
+            struct entry {
+                std::string kind; ///!< The lock wrapper.
+                std::string tag;  ///!< The purpose of the lock.
+                uint64_t acquired;  ///!< Number of acquisitions.
+                uint64_t contended; ///!< Number of acquisitions that waited.
+                double waitTime;    ///!< Total time waited in seconds.
+                double maxWait;     ///!< Longest wait in seconds.
+                /// Number of acquisitions that waited no more than 1, 10
+                /// and 100 microseconds, 1, 10 and 100 milliseconds, 1
+                /// second, and longer.
+                uint64_t waits[nwaits];
+                /// The purposes of the holders waited for and the number
+                /// of times each of them was waited for.
+                std::map<std::string, uint64_t> blockers;
+
+                entry() : acquired(0), contended(0), waitTime(0.0),
+                          maxWait(0.0) {
+                    for (unsigned j = 0; j < nwaits; ++ j)
+                        waits[j] = 0;
+                }
+            }; // entry
+
+            /// Are the statistics being collected?
+            static bool enabled;
+            static void enable(bool on);
+            static void clear();
+            static void snapshot(std::vector<entry>& lst);
+            static void print(std::ostream& out);
+
+            static int lock(pthread_mutex_t* lk, const char* kind,
+                            const char* tag);
+            static int rdlock(pthread_rwlock_t* lk, const char* kind,
+                              const char* tag, double& wait);
+            static int wrlock(pthread_rwlock_t* lk, const char* kind,
+                              const char* tag, double& wait);
+            static void release(const void* lk);
+        }; // lockStats
+
         /// An wrapper class for perform pthread_mutex_lock/unlock.
         class mutexLock {
         public:
@@ -744,7 +804,10 @@ namespace ibis {
                 LOGGER(ibis::gVerbose > 10)
                     << "util::mutexLock -- acquiring lock (" << lock
                     << ") for " << mesg;
-                if (0 != pthread_mutex_lock(lock)) {
+                if (0 != (ibis::util::lockStats::enabled ?
+                          ibis::util::lockStats::lock
+                          (lock, "util::mutexLock", mesg) :
+                          pthread_mutex_lock(lock))) {
                     throw "mutexLock failed to obtain a lock";
                 }
             }
@@ -752,6 +815,8 @@ namespace ibis {
                 LOGGER(ibis::gVerbose > 10)
                     << "util::mutexLock -- releasing lock (" << lock
                     << ") for " << mesg;
+                if (ibis::util::lockStats::enabled)
+                    ibis::util::lockStats::release(lock);
                 (void) pthread_mutex_unlock(lock);
             }
 
@@ -819,11 +884,17 @@ namespace ibis {
         public:
             readLock(pthread_rwlock_t* lk, const char* m)
                 : mesg(m), lock(lk) {
-                if (0 != pthread_rwlock_rdlock(lock)) {
+                double wait;
+                if (0 != (ibis::util::lockStats::enabled ?
+                          ibis::util::lockStats::rdlock
+                          (lock, "util::readLock", mesg, wait) :
+                          pthread_rwlock_rdlock(lock))) {
                     throw "readLock failed to obtain a lock";
                 }
             }
             ~readLock() {
+                if (ibis::util::lockStats::enabled)
+                    ibis::util::lockStats::release(lock);
                 (void) pthread_rwlock_unlock(lock);
             }
 
@@ -842,12 +913,18 @@ namespace ibis {
             /// Constructor.
             writeLock(pthread_rwlock_t* lk, const char* m)
                 : mesg(m), lock(lk) {
-                if (0 != pthread_rwlock_wrlock(lock)) {
+                double wait;
+                if (0 != (ibis::util::lockStats::enabled ?
+                          ibis::util::lockStats::wrlock
+                          (lock, "util::writeLock", mesg, wait) :
+                          pthread_rwlock_wrlock(lock))) {
                     throw "writeLock failed to obtain a lock";
                 }
             }
             /// Destructor.
             ~writeLock() {
+                if (ibis::util::lockStats::enabled)
+                    ibis::util::lockStats::release(lock);
                 (void) pthread_rwlock_unlock(lock);
             }
 
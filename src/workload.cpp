@@ -0,0 +1,189 @@
+// File: $Id$
+// Author: John Wu <John.Wu at acm.org>
+//      Lawrence Berkeley National Laboratory
+// Copyright (c) 2007-2016 the Regents of the University of California
+//
+// This file contains the implementation of the workload capture defined
+// in workload.h and the reader of the workload logs.
+#include "workload.h"   // ibis::workload
+
+#include <fstream>      // std::ofstream, std::ifstream
+#include <iomanip>      // std::setprecision
+#include <cstdlib>      // strtod, strtoll
+
+bool ibis::workload::capturing = false;
+
+/// The mutex guarding the log.
+static pthread_mutex_t _ibis_workload_lock = PTHREAD_MUTEX_INITIALIZER;
+/// The log being written.
+static std::ofstream* _ibis_workload_log = 0;
+/// The clock started with the capture.
+static ibis::horometer _ibis_workload_clock;
+/// The number of captured calls in progress on the current thread.
+static thread_local unsigned _ibis_workload_depth = 0;
+
+/// Start capturing the workload into the named file.  The records are
+/// appended to the file if it already exists.  A capture in progress is
+/// stopped first.  Return 0 on success and a negative number on error.
+int ibis::workload::startCapture(const char* fname) {
+    if (fname == 0 || *fname == 0) return -1;
+
+    ibis::util::mutexLock lck(&_ibis_workload_lock, "workload::startCapture");
+    ibis::workload::capturing = false;
+    delete _ibis_workload_log;
+    _ibis_workload_log = new std::ofstream(fname, std::ios::app);
+    if (! *_ibis_workload_log) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- workload::startCapture failed to open " << fname;
+        delete _ibis_workload_log;
+        _ibis_workload_log = 0;
+        return -2;
+    }
+    if (_ibis_workload_log->tellp() <= 0)
+        *_ibis_workload_log << "# fastbit workload 1" << std::endl;
+    _ibis_workload_clock.start();
+    ibis::workload::capturing = true;
+    LOGGER(ibis::gVerbose > 1)
+        << "workload::startCapture -- recording queries in " << fname;
+    return 0;
+} // ibis::workload::startCapture
+
+/// Stop the capture and close the log.
+void ibis::workload::stopCapture() {
+    ibis::util::mutexLock lck(&_ibis_workload_lock, "workload::stopCapture");
+    ibis::workload::capturing = false;
+    delete _ibis_workload_log;
+    _ibis_workload_log = 0;
+} // ibis::workload::stopCapture
+
+/// Write an argument with the tabs, the newlines and the backslashes
+/// escaped.
+static void _ibis_workload_escape(std::ostream& out, const std::string& str) {
+    for (size_t j = 0; j < str.size(); ++ j) {
+        switch (str[j]) {
+        case '\t': out << "\\t"; break;
+        case '\n': out << "\\n"; break;
+        case '\r': out << "\\r"; break;
+        case '\\': out << "\\\\"; break;
+        default:   out << str[j]; break;
+        }
+    }
+} // _ibis_workload_escape
+
+/// Split a line of the log into fields and undo the escapes.
+static void _ibis_workload_split(const std::string& line,
+                                 std::vector<std::string>& fields) {
+    fields.clear();
+    fields.push_back(std::string());
+    for (size_t j = 0; j < line.size(); ++ j) {
+        if (line[j] == '\t') {
+            fields.push_back(std::string());
+        }
+        else if (line[j] == '\\' && j+1 < line.size()) {
+            ++ j;
+            switch (line[j]) {
+            case 't': fields.back() += '\t'; break;
+            case 'n': fields.back() += '\n'; break;
+            case 'r': fields.back() += '\r'; break;
+            default:  fields.back() += line[j]; break;
+            }
+        }
+        else {
+            fields.back() += line[j];
+        }
+    }
+} // _ibis_workload_split
+
+/// Start recording a call of the given kind.
+ibis::workload::capture::capture(const char* kind)
+    : rec(0), counted(ibis::workload::capturing) {
+    if (! counted) return;
+    ++ _ibis_workload_depth;
+    if (_ibis_workload_depth > 1) return;
+
+    rec = new record;
+    rec->kind = kind;
+    ibis::horometer now(_ibis_workload_clock);
+    now.stop();
+    rec->start = now.realTime();
+    timer.start();
+} // ibis::workload::capture::capture
+
+/// Write the record to the log.
+ibis::workload::capture::~capture() {
+    if (counted)
+        -- _ibis_workload_depth;
+    if (rec == 0) return;
+
+    timer.stop();
+    rec->elapsed = timer.realTime();
+    ibis::util::mutexLock lck(&_ibis_workload_lock, "workload::capture");
+    if (_ibis_workload_log != 0) {
+        std::ostream& out = *_ibis_workload_log;
+        out << rec->kind << '\t' << std::setprecision(9) << rec->start
+            << '\t' << rec->elapsed << '\t' << rec->rows;
+        for (size_t j = 0; j < rec->args.size(); ++ j) {
+            out << '\t';
+            _ibis_workload_escape(out, rec->args[j]);
+        }
+        out << std::endl;
+    }
+    delete rec;
+} // ibis::workload::capture::~capture
+
+/// Read the records from a workload log.  The records are appended to
+/// @c recs.  Return the number of records read, or a negative number if
+/// the file can not be read.  The lines that are not valid records are
+/// skipped.
+///
+/// A log may contain several captures appended one after another, each
+/// starting with its own header line.  The start times of a later capture
+/// are shifted to follow the end of the earlier ones.
+int ibis::workload::readLog(const char* fname,
+                            std::vector<ibis::workload::record>& recs) {
+    if (fname == 0 || *fname == 0) return -1;
+    std::ifstream in(fname);
+    if (! in) {
+        LOGGER(ibis::gVerbose > 0)
+            << "Warning -- workload::readLog failed to open " << fname;
+        return -2;
+    }
+
+    int cnt = 0;
+    size_t lineno = 0;
+    double offset = 0.0, end = 0.0;
+    std::string line;
+    std::vector<std::string> fields;
+    while (std::getline(in, line)) {
+        ++ lineno;
+        if (line.empty()) continue;
+        if (line[0] == '#') { // the header of a capture
+            offset = end;
+            continue;
+        }
+
+        _ibis_workload_split(line, fields);
+        if (fields.size() < 5) {
+            LOGGER(ibis::gVerbose > 1)
+                << "Warning -- workload::readLog skips line " << lineno
+                << " of " << fname << " because it has only "
+                << fields.size() << " field(s)";
+            continue;
+        }
+
+        record rec;
+        rec.kind = fields[0];
+        rec.start = offset + strtod(fields[1].c_str(), 0);
+        rec.elapsed = strtod(fields[2].c_str(), 0);
+        if (end < rec.start + rec.elapsed)
+            end = rec.start + rec.elapsed;
+        rec.rows = strtoll(fields[3].c_str(), 0, 10);
+        rec.args.assign(fields.begin()+4, fields.end());
+        recs.push_back(rec);
+        ++ cnt;
+    }
+    LOGGER(ibis::gVerbose > 2)
+        << "workload::readLog read " << cnt << " record" << (cnt>1?"s":"")
+        << " from " << fname;
+    return cnt;
+} // ibis::workload::readLog
@@ -0,0 +1,97 @@
+// File: $Id$
+// Author: John Wu <John.Wu at acm.org>
+//      Lawrence Berkeley National Laboratory
+// Copyright (c) 2007-2016 the Regents of the University of California
+#ifndef IBIS_WORKLOAD_H
+#define IBIS_WORKLOAD_H
+///@file
+/// Capture the queries processed by FastBit into a log for later replay.
+///
+/// While the capture is on, the library appends one line to the log for
+/// each of the following calls,
+/// - ibis::mensa::select, recorded as "select" with the names of the data
+///   partitions of the table separated by commas, the select clause and
+///   the where clause;
+/// - ibis::query::evaluate, recorded as "query" with the name of the data
+///   partition, the select clause and the where clause;
+/// - ibis::countQuery::evaluate, recorded as "count" with the name of the
+///   data partition and the where clause;
+/// - ibis::quaere::create, recorded as "quaere" with the select clause,
+///   the from clause and the where clause, or as "join" with the names of
+///   the two data partitions, the join column, the two conditions and the
+///   select clause.
+/// Each line also records the start time of the call relative to the start
+/// of the capture, the elapsed time and the number of rows produced, or -1
+/// if the call failed.  The calls made while processing another captured
+/// call are not recorded.  Since the number of rows of a quaere is only
+/// known after it is counted, the capture counts the result of
+/// ibis::quaere::create immediately, which is included in the elapsed
+/// time.
+///
+/// The log is a text file.  The first line is "# fastbit workload 1",
+/// and each following line contains the fields separated by tabs:
+/// kind, start time, elapsed time, number of rows, followed by the
+/// arguments of the call.  A tab, a newline or a backslash in an argument
+/// is written as \\t, \\n or \\\\.
+///
+/// The capture is started by calling ibis::workload::startCapture or by
+/// setting the parameter workload.capture to the name of the log file
+/// before calling ibis::init.  The example program replay re-executes a
+/// log against a set of data partitions.
+#include "util.h"       // ibis::util
+#include "horometer.h"  // ibis::horometer
+
+#include <vector>       // std::vector
+
+namespace ibis {
+    /// Capture and replay of query workloads.
+    namespace workload {
+        /// Is a capture in progress?
+        extern FASTBIT_CXX_DLLSPEC bool capturing;
+        FASTBIT_CXX_DLLSPEC int startCapture(const char* fname);
+        FASTBIT_CXX_DLLSPEC void stopCapture();
+
+        /// A call recorded in a workload log.
+        struct FASTBIT_CXX_DLLSPEC record {
+            std::string kind;   ///!< select, query, count, quaere or join.
+            double start;       ///!< Seconds since the start of the capture.
+            double elapsed;     ///!< Duration of the call in seconds.
+            int64_t rows;       ///!< Number of rows produced.
+            std::vector<std::string> args; ///!< Arguments of the call.
+
+            record() : start(0.0), elapsed(0.0), rows(-1) {}
+        }; // record
+
+        FASTBIT_CXX_DLLSPEC int readLog(const char* fname,
+                                        std::vector<record>& recs);
+
+        /// Record a call for the lifetime of this object.  The record is
+        /// written when the object is destroyed.  When no capture is in
+        /// progress or the call is made while processing another
+        /// captured call, this object does nothing.
+        class FASTBIT_CXX_DLLSPEC capture {
+        public:
+            explicit capture(const char* kind);
+            ~capture();
+
+            /// Is the call being recorded?
+            bool active() const {return rec != 0;}
+            /// Add an argument of the call.
+            void add(const char* arg) {
+                if (rec != 0) rec->args.push_back(arg != 0 ? arg : "");
+            }
+            /// Record the number of rows produced.
+            void setRows(int64_t n) {if (rec != 0) rec->rows = n;}
+
+        private:
+            record* rec;
+            bool counted;
+            ibis::horometer timer;
+
+            capture();
+            capture(const capture&);
+            capture& operator=(const capture&);
+        }; // capture
+    } // namespace workload
+} // namespace ibis
+#endif // IBIS_WORKLOAD_H
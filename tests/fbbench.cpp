@@ -0,0 +1,556 @@
+/// $Id$
+///
+/// A benchmark of the bitvector operations, the indexes and the query
+/// processing paths of FastBit.  It generates a synthetic data set with a
+/// fixed seed, runs each benchmark a number of times, and writes the
+/// timing results as a JSON document that can be compared across commits
+/// with scripts/bench-compare.pl.
+///
+/// The synthetic data set contains a fact table with the following columns
+///   - u: integers uniformly distributed in [0, 1000),
+///   - z: integers in [0, 1000) following a Zipf distribution,
+///   - m: integers in [0, 1000) generated by a Markov process that keeps
+///     the previous value with probability 0.99, which produces long runs
+///     of the same value as in clustered data,
+///   - d: doubles uniformly distributed in [0, 1),
+///   - k: a join key uniformly distributed over the rows of the dimension
+///     table,
+/// and a dimension table with the columns k and w.  The same fact table is
+/// also written as a CSV file for the ingestion benchmark.
+///
+/// The benchmarks are
+///   - bitvector.*: the logical operations on compressed and decompressed
+///     bitvectors, counting the ones and iterating over the index sets,
+///   - index.build.* and index.evaluate.*: building and evaluating the
+///     indexes of different encodings on the column u,
+///   - scan.*: the scan kernels ibis::part::doScan on integers and doubles,
+///   - query.*: a where clause, a group-by and a join on the data
+///     partitions,
+///   - ingest.csv: reading the CSV file into memory.
+/// All measurements are taken with warm caches.  Each result records the
+/// minimum, median, mean and standard deviation of the elapsed time of
+/// one operation, the number of items processed per operation and a check
+/// value, such as the number of hits, that should not change across
+/// commits.
+///
+/// Usage:
+/// fbbench [-d data-dir] [-n #rows] [-r #repeats] [-s seed] [-b name]
+///         [-o output.json] [-t label] [-c conf-file] [-v]
+///
+/// The option -b selects the benchmarks whose names contain the given
+/// string, and may be repeated.
+///
+#include <ibis.h>       // ibis::init, ibis::part, ibis::table
+#include <twister.h>    // ibis::MersenneTwister, ibis::discreteZipf
+#include <index.h>      // ibis::index
+#include <countQuery.h> // ibis::countQuery
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <algorithm>    // std::sort
+#include <cmath>        // std::sqrt
+#include <cstring>      // std::strstr
+#include <time.h>       // time, strftime
+
+/// The number of distinct values of the columns u, z and m.
+#define FBBENCH_CARD 1000
+
+/// The result of one benchmark.
+struct benchResult {
+    std::string name;   ///!< Name of the benchmark.
+    uint64_t items;     ///!< Items processed per operation.
+    long check;         ///!< A value that should not change.
+    std::vector<double> times; ///!< Elapsed time of each operation.
+};
+
+/// The options and the results of the benchmarks.
+struct benchEnv {
+    std::string dir;    ///!< Directory of the data.
+    uint32_t nrows;     ///!< Number of rows of the fact table.
+    uint32_t ndim;      ///!< Number of rows of the dimension table.
+    unsigned repeats;   ///!< Times to repeat each benchmark.
+    unsigned seed;      ///!< The seed of the random number generator.
+    std::vector<const char*> only; ///!< Benchmarks selected.
+    std::vector<benchResult> results;
+
+    benchEnv() : nrows(1000000), ndim(10000), repeats(5), seed(1234) {}
+
+    /// Is the named benchmark selected?
+    bool selected(const char* name) const {
+        if (only.empty()) return true;
+        for (size_t j = 0; j < only.size(); ++ j)
+            if (std::strstr(name, only[j]) != 0)
+                return true;
+        return false;
+    }
+};
+
+/// Run a benchmark.  The function @c fn performs one operation and returns
+/// the check value.  The first operation is not timed in order to warm up
+/// the caches.
+template <typename F>
+static void runBench(benchEnv& env, const char* name, uint64_t items, F fn) {
+    if (! env.selected(name)) return;
+
+    benchResult res;
+    res.name = name;
+    res.items = items;
+    res.check = fn();
+    for (unsigned j = 0; j < env.repeats; ++ j) {
+        ibis::horometer timer;
+        timer.start();
+        long chk = fn();
+        timer.stop();
+        res.times.push_back(timer.realTime());
+        if (chk != res.check) {
+            std::cerr << "Warning -- " << name << " produced " << chk
+                      << " instead of " << res.check << " in repeat " << j
+                      << std::endl;
+        }
+    }
+    LOGGER(ibis::gVerbose > 0)
+        << "fbbench -- " << name << " took "
+        << *std::min_element(res.times.begin(), res.times.end())
+        << " sec (minimum of " << res.times.size() << "), check = "
+        << res.check;
+    env.results.push_back(res);
+} // runBench
+
+/// Generate the data and write them to the data directory.  The fact table
+/// is written to dir/fact and dir/fact.csv, the dimension table to
+/// dir/dim.
+static int generateData(const benchEnv& env) {
+    ibis::MersenneTwister mt(env.seed);
+    ibis::discreteZipf zipf(mt, 1.2, FBBENCH_CARD-1);
+    std::vector<int32_t> u(env.nrows), z(env.nrows), m(env.nrows),
+        k(env.nrows);
+    std::vector<double> d(env.nrows);
+    int32_t prev = mt.next(FBBENCH_CARD);
+    for (uint32_t j = 0; j < env.nrows; ++ j) {
+        u[j] = mt.next(FBBENCH_CARD);
+        z[j] = zipf();
+        if (mt.nextDouble() >= 0.99)
+            prev = mt.next(FBBENCH_CARD);
+        m[j] = prev;
+        d[j] = mt.nextDouble();
+        k[j] = mt.next(env.ndim);
+    }
+
+    std::string fdir = env.dir + FASTBIT_DIRSEP + "fact";
+    std::string ddir = env.dir + FASTBIT_DIRSEP + "dim";
+    std::string csv = env.dir + FASTBIT_DIRSEP + "fact.csv";
+    ibis::util::removeDir(fdir.c_str());
+    ibis::util::removeDir(ddir.c_str());
+    {
+        std::unique_ptr<ibis::tablex> tab(ibis::tablex::create());
+        tab->addColumn("u", ibis::INT);
+        tab->addColumn("z", ibis::INT);
+        tab->addColumn("m", ibis::INT);
+        tab->addColumn("d", ibis::DOUBLE);
+        tab->addColumn("k", ibis::INT);
+        tab->append("u", 0, env.nrows, &u[0]);
+        tab->append("z", 0, env.nrows, &z[0]);
+        tab->append("m", 0, env.nrows, &m[0]);
+        tab->append("d", 0, env.nrows, &d[0]);
+        tab->append("k", 0, env.nrows, &k[0]);
+        int ierr = tab->write(fdir.c_str(), "fact",
+                              "synthetic data for fbbench");
+        if (ierr < 0) {
+            std::cerr << "fbbench failed to write the fact table to "
+                      << fdir << ", ierr = " << ierr << std::endl;
+            return -1;
+        }
+    }
+    {
+        std::vector<int32_t> dk(env.ndim), dw(env.ndim);
+        for (uint32_t j = 0; j < env.ndim; ++ j) {
+            dk[j] = j;
+            dw[j] = j % 17;
+        }
+        std::unique_ptr<ibis::tablex> tab(ibis::tablex::create());
+        tab->addColumn("k", ibis::INT);
+        tab->addColumn("w", ibis::INT);
+        tab->append("k", 0, env.ndim, &dk[0]);
+        tab->append("w", 0, env.ndim, &dw[0]);
+        int ierr = tab->write(ddir.c_str(), "dim",
+                              "synthetic data for fbbench");
+        if (ierr < 0) {
+            std::cerr << "fbbench failed to write the dimension table to "
+                      << ddir << ", ierr = " << ierr << std::endl;
+            return -2;
+        }
+    }
+    {
+        std::ofstream out(csv.c_str());
+        if (! out) {
+            std::cerr << "fbbench failed to open " << csv << std::endl;
+            return -3;
+        }
+        out << std::setprecision(17);
+        for (uint32_t j = 0; j < env.nrows; ++ j)
+            out << u[j] << ',' << z[j] << ',' << m[j] << ',' << d[j] << ','
+                << k[j] << '\n';
+    }
+    return 0;
+} // generateData
+
+/// Form a bitvector marking the rows where the values satisfy @c pred.
+template <typename T, typename P>
+static void markRows(const ibis::array_t<T>& vals, P pred,
+                     ibis::bitvector& bv) {
+    bv.clear();
+    for (size_t j = 0; j < vals.size(); ++ j)
+        if (pred(vals[j]))
+            bv.setBit(j, 1);
+    bv.adjustSize(0, vals.size());
+} // markRows
+
+/// The operations on bitvectors.
+static void benchBitvector(benchEnv& env, const ibis::part& fact) {
+    ibis::array_t<int32_t> u, m;
+    ibis::array_t<double> d;
+    if (fact.getColumn("u")->getValuesArray(&u) < 0 ||
+        fact.getColumn("m")->getValuesArray(&m) < 0 ||
+        fact.getColumn("d")->getValuesArray(&d) < 0) {
+        std::cerr << "fbbench failed to read the values of the fact table"
+                  << std::endl;
+        return;
+    }
+
+    // sparse and random, compressed
+    ibis::bitvector sp1, sp2;
+    markRows(u, [](int32_t v) {return v == 1;}, sp1);
+    markRows(u, [](int32_t v) {return v % 100 == 1;}, sp2);
+    // clustered, compressed
+    ibis::bitvector cl1, cl2;
+    markRows(m, [](int32_t v) {return v < 100;}, cl1);
+    markRows(m, [](int32_t v) {return v >= 900;}, cl2);
+    // dense and random, not compressible
+    ibis::bitvector dn;
+    markRows(d, [](double v) {return v < 0.5;}, dn);
+    ibis::bitvector dnd(dn);
+    dnd.decompress();
+    const uint64_t nb = fact.nRows();
+
+    runBench(env, "bitvector.and_c2", nb, [&]() -> long {
+            std::unique_ptr<ibis::bitvector> res(sp1 & sp2);
+            return res->cnt();});
+    runBench(env, "bitvector.or_c2", nb, [&]() -> long {
+            std::unique_ptr<ibis::bitvector> res(cl1 | cl2);
+            return res->cnt();});
+    runBench(env, "bitvector.and_d2", nb, [&]() -> long {
+            std::unique_ptr<ibis::bitvector> res(dn & cl1);
+            return res->cnt();});
+    runBench(env, "bitvector.or_d1", nb, [&]() -> long {
+            ibis::bitvector res(dnd);
+            res |= sp1;
+            return res.cnt();});
+    runBench(env, "bitvector.and_d1", nb, [&]() -> long {
+            ibis::bitvector res(dnd);
+            res &= cl1;
+            return res.cnt();});
+    runBench(env, "bitvector.minus_c2", nb, [&]() -> long {
+            std::unique_ptr<ibis::bitvector> res(cl1 - sp1);
+            return res->cnt();});
+
+    ibis::array_t<ibis::bitvector::word_t> ser;
+    dn.write(ser);
+    runBench(env, "bitvector.cnt", nb, [&]() -> long {
+            ibis::bitvector bv(ser);
+            return bv.cnt();});
+    runBench(env, "bitvector.indexSet.sparse", nb, [&]() -> long {
+            long sum = 0;
+            for (ibis::bitvector::indexSet is = sp2.firstIndexSet();
+                 is.nIndices() > 0; ++ is) {
+                const ibis::bitvector::word_t *ind = is.indices();
+                if (is.isRange())
+                    sum += ind[1] - ind[0];
+                else
+                    sum += is.nIndices();
+            }
+            return sum;});
+    runBench(env, "bitvector.indexSet.clustered", nb, [&]() -> long {
+            long sum = 0;
+            for (ibis::bitvector::indexSet is = cl1.firstIndexSet();
+                 is.nIndices() > 0; ++ is) {
+                const ibis::bitvector::word_t *ind = is.indices();
+                if (is.isRange())
+                    sum += ind[1] - ind[0];
+                else
+                    sum += is.nIndices();
+            }
+            return sum;});
+} // benchBitvector
+
+/// Build and evaluate the indexes of different encodings on the column u.
+static void benchIndex(benchEnv& env, const ibis::part& fact) {
+    static const char* encodings[][2] = {
+        {"basic", "<binning none/>"},
+        {"equality", "<binning none/><encoding equality/>"},
+        {"range", "<binning none/><encoding range/>"},
+        {"interval", "<binning none/><encoding interval/>"},
+        {"binary", "<binning none/><encoding binary/>"},
+        {"bitslice", "<binning none/> bit-slice"},
+        {"equality-equality", "<binning none/><encoding equality-equality/>"},
+        {"binned", "<binning precision=2/>"}
+    };
+    static const double bounds[] = {10, 100, 500, 900};
+    const ibis::column* col = fact.getColumn("u");
+    const uint64_t nr = fact.nRows();
+
+    for (size_t e = 0; e < sizeof(encodings)/sizeof(encodings[0]); ++ e) {
+        std::string bname = "index.build.";
+        bname += encodings[e][0];
+        std::string ename = "index.evaluate.";
+        ename += encodings[e][0];
+        if (! env.selected(bname.c_str()) && ! env.selected(ename.c_str()))
+            continue;
+
+        const char* spec = encodings[e][1];
+        runBench(env, bname.c_str(), nr, [&]() -> long {
+                std::unique_ptr<ibis::index>
+                    idx(ibis::index::create(col, static_cast<const char*>(0),
+                                            spec));
+                return (idx.get() != 0 ? idx->numBitvectors() : -1);});
+
+        std::unique_ptr<ibis::index>
+            idx(ibis::index::create(col, static_cast<const char*>(0), spec));
+        if (idx.get() == 0) continue;
+        const ibis::index* ix = idx.get();
+        runBench(env, ename.c_str(), nr*4, [&]() -> long {
+                long sum = 0;
+                for (unsigned j = 0; j < 4; ++ j) {
+                    ibis::qContinuousRange cmp("u", ibis::qExpr::OP_LT,
+                                               bounds[j]);
+                    ibis::bitvector hits;
+                    long ierr = ix->evaluate(cmp, hits);
+                    sum += (ierr >= 0 ? static_cast<long>(hits.cnt()) : -1);
+                }
+                return sum;});
+    }
+} // benchIndex
+
+/// The scan kernels.
+static void benchScan(benchEnv& env, const ibis::part& fact) {
+    ibis::bitvector mask;
+    mask.set(1, fact.nRows());
+    ibis::bitvector half;
+    for (uint32_t j = 0; j < fact.nRows(); ++ j)
+        half.setBit(j, (j / 4096) % 2);
+    half.adjustSize(0, fact.nRows());
+    const uint64_t nr = fact.nRows();
+
+    runBench(env, "scan.int", nr, [&]() -> long {
+            ibis::qContinuousRange cmp("u", ibis::qExpr::OP_LT, 500.0);
+            ibis::bitvector hits;
+            long ierr = fact.doScan(cmp, mask, hits);
+            return (ierr >= 0 ? static_cast<long>(hits.cnt()) : ierr);});
+    runBench(env, "scan.int.between", nr, [&]() -> long {
+            ibis::qContinuousRange cmp(100.0, ibis::qExpr::OP_LE, "z",
+                                       ibis::qExpr::OP_LT, 200.0);
+            ibis::bitvector hits;
+            long ierr = fact.doScan(cmp, mask, hits);
+            return (ierr >= 0 ? static_cast<long>(hits.cnt()) : ierr);});
+    runBench(env, "scan.int.masked", nr/2, [&]() -> long {
+            ibis::qContinuousRange cmp("u", ibis::qExpr::OP_LT, 500.0);
+            ibis::bitvector hits;
+            long ierr = fact.doScan(cmp, half, hits);
+            return (ierr >= 0 ? static_cast<long>(hits.cnt()) : ierr);});
+    runBench(env, "scan.double", nr, [&]() -> long {
+            ibis::qContinuousRange cmp("d", ibis::qExpr::OP_LT, 0.25);
+            ibis::bitvector hits;
+            long ierr = fact.doScan(cmp, mask, hits);
+            return (ierr >= 0 ? static_cast<long>(hits.cnt()) : ierr);});
+} // benchScan
+
+/// The query processing on the data partitions.
+static void benchQuery(benchEnv& env, const ibis::part& fact,
+                       const ibis::part& dim) {
+    std::unique_ptr<ibis::table> tbl(ibis::table::create(fact.currentDataDir()));
+    if (tbl.get() == 0) return;
+    const uint64_t nr = fact.nRows();
+
+    runBench(env, "query.where", nr, [&]() -> long {
+            ibis::countQuery qq(&fact);
+            qq.setWhereClause("u < 100 and z > 3 and d < 0.5");
+            return (qq.evaluate() >= 0 ? qq.getNumHits() : -1);});
+    runBench(env, "query.select", nr, [&]() -> long {
+            std::unique_ptr<ibis::table>
+                res(tbl->select("u, d", "m < 100 and u < 500"));
+            return (res.get() != 0 ? static_cast<long>(res->nRows()) : -1);});
+    runBench(env, "query.groupby", nr, [&]() -> long {
+            std::unique_ptr<ibis::table>
+                res(tbl->select("z, count(*), avg(d)", "u < 500"));
+            return (res.get() != 0 ? static_cast<long>(res->nRows()) : -1);});
+    runBench(env, "query.groupby.clustered", nr, [&]() -> long {
+            std::unique_ptr<ibis::table>
+                res(tbl->select("m, sum(u), max(d)", "z < 10"));
+            return (res.get() != 0 ? static_cast<long>(res->nRows()) : -1);});
+    runBench(env, "query.join", nr + dim.nRows(), [&]() -> long {
+            std::unique_ptr<ibis::quaere>
+                jn(ibis::quaere::create(&fact, &dim, "k", "u < 100",
+                                        "w < 5"));
+            return (jn.get() != 0 ? static_cast<long>(jn->count()) : -1);});
+} // benchQuery
+
+/// Read the CSV file into memory.
+static void benchIngest(benchEnv& env) {
+    std::string csv = env.dir + FASTBIT_DIRSEP + "fact.csv";
+    runBench(env, "ingest.csv", env.nrows, [&]() -> long {
+            std::unique_ptr<ibis::tablex> tab(ibis::tablex::create());
+            tab->addColumn("u", ibis::INT);
+            tab->addColumn("z", ibis::INT);
+            tab->addColumn("m", ibis::INT);
+            tab->addColumn("d", ibis::DOUBLE);
+            tab->addColumn("k", ibis::INT);
+            return tab->readCSV(csv.c_str(), 0, 0, ",");});
+} // benchIngest
+
+/// Print a string as a JSON string literal.
+static void printJSONString(std::ostream& out, const std::string& str) {
+    out << '"';
+    for (size_t j = 0; j < str.size(); ++ j) {
+        if (str[j] == '"' || str[j] == '\\')
+            out << '\\';
+        out << str[j];
+    }
+    out << '"';
+} // printJSONString
+
+/// Write the results as a JSON document.
+static void printJSON(std::ostream& out, const benchEnv& env,
+                      const char* label) {
+    char tstr[32];
+    const time_t now = time(0);
+    (void) strftime(tstr, sizeof(tstr), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    out << std::setprecision(9) << "{\n  \"benchmark\": \"fbbench\",\n"
+        << "  \"version\": ";
+    printJSONString(out, ibis::util::getVersionString());
+    out << ",\n  \"label\": ";
+    printJSONString(out, label != 0 ? label : "");
+    out << ",\n  \"time\": \"" << tstr << "\",\n  \"rows\": " << env.nrows
+        << ",\n  \"seed\": " << env.seed << ",\n  \"repeats\": "
+        << env.repeats << ",\n  \"results\": [";
+    for (size_t j = 0; j < env.results.size(); ++ j) {
+        const benchResult& res = env.results[j];
+        std::vector<double> tms(res.times);
+        std::sort(tms.begin(), tms.end());
+        double mean = 0.0, var = 0.0, median = 0.0;
+        if (! tms.empty()) {
+            for (size_t i = 0; i < tms.size(); ++ i)
+                mean += tms[i];
+            mean /= tms.size();
+            for (size_t i = 0; i < tms.size(); ++ i)
+                var += (tms[i] - mean) * (tms[i] - mean);
+            if (tms.size() > 1)
+                var /= (tms.size() - 1);
+            median = (tms.size() % 2 != 0 ? tms[tms.size()/2] :
+                      0.5 * (tms[tms.size()/2-1] + tms[tms.size()/2]));
+        }
+        out << (j > 0 ? ",\n" : "\n") << "    {\"name\": ";
+        printJSONString(out, res.name);
+        out << ", \"items\": " << res.items << ", \"check\": " << res.check
+            << ", \"min\": " << (tms.empty() ? 0.0 : tms[0])
+            << ", \"median\": " << median << ", \"mean\": " << mean
+            << ", \"stddev\": " << std::sqrt(var)
+            << ", \"itemsPerSecond\": "
+            << (median > 0.0 ? res.items / median : 0.0) << "}";
+    }
+    out << "\n  ]\n}" << std::endl;
+} // printJSON
+
+static void usage(const char* name) {
+    std::cout << "usage:\n" << name
+              << " [-d data-dir] [-n #rows] [-r #repeats] [-s seed]"
+        " [-b name] [-o output.json] [-t label] [-c conf-file] [-v]\n"
+        "\nGenerates a synthetic data set in data-dir (default fbbench-data)"
+        ", runs the benchmarks whose names contain one of the strings given"
+        " with -b (all by default), and writes the results as JSON to"
+        " output.json (default standard output).\n" << std::endl;
+} // usage
+
+int main(int argc, char** argv) {
+    benchEnv env;
+    env.dir = "fbbench-data";
+    const char* outfile = 0;
+    const char* label = 0;
+    const char* conffile = 0;
+    for (int i = 1; i < argc; ++ i) {
+        if (*argv[i] != '-') {
+            usage(*argv);
+            return -1;
+        }
+        switch (argv[i][1]) {
+        case 'b': case 'B':
+            if (i+1 < argc) env.only.push_back(argv[++i]);
+            break;
+        case 'c': case 'C':
+            if (i+1 < argc) conffile = argv[++i];
+            break;
+        case 'd': case 'D':
+            if (i+1 < argc) env.dir = argv[++i];
+            break;
+        case 'n': case 'N':
+            if (i+1 < argc) env.nrows = (uint32_t) atof(argv[++i]);
+            break;
+        case 'o': case 'O':
+            if (i+1 < argc) outfile = argv[++i];
+            break;
+        case 'r': case 'R':
+            if (i+1 < argc) env.repeats = (unsigned) atoi(argv[++i]);
+            break;
+        case 's': case 'S':
+            if (i+1 < argc) env.seed = (unsigned) atoi(argv[++i]);
+            break;
+        case 't': case 'T':
+            if (i+1 < argc) label = argv[++i];
+            break;
+        case 'v': case 'V':
+            ++ ibis::gVerbose;
+            break;
+        default:
+            usage(*argv);
+            return -1;
+        }
+    }
+    if (env.nrows < 1000)
+        env.nrows = 1000;
+    env.ndim = (env.nrows >= 1000000 ? env.nrows / 100 : 10000);
+    if (env.repeats == 0)
+        env.repeats = 1;
+
+    ibis::init(conffile);
+    ibis::util::timer mytimer(*argv, 0);
+    if (generateData(env) < 0)
+        return -2;
+
+    std::string fdir = env.dir + FASTBIT_DIRSEP + "fact";
+    std::string ddir = env.dir + FASTBIT_DIRSEP + "dim";
+    ibis::part fact(fdir.c_str(), static_cast<const char*>(0));
+    ibis::part dim(ddir.c_str(), static_cast<const char*>(0));
+    if (fact.nRows() != env.nrows || dim.nRows() != env.ndim) {
+        std::cerr << "fbbench failed to read the generated data from "
+                  << env.dir << std::endl;
+        return -3;
+    }
+
+    benchBitvector(env, fact);
+    benchIndex(env, fact);
+    benchScan(env, fact);
+    benchQuery(env, fact, dim);
+    benchIngest(env);
+
+    if (outfile != 0 && *outfile != 0) {
+        std::ofstream out(outfile);
+        if (! out) {
+            std::cerr << "fbbench failed to open " << outfile << std::endl;
+            return -4;
+        }
+        printJSON(out, env, label);
+    }
+    else {
+        printJSON(std::cout, env, label);
+    }
+    return 0;
+} // main
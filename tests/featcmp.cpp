@@ -0,0 +1,672 @@
+/// $Id$
+///
+/// A tester for the optional features of the query processing.  Each
+/// feature is a different way of computing the same answer, therefore the
+/// queries are evaluated with and without the feature and the hits are
+/// compared.
+///
+/// Usage:
+/// featcmp <datadir> [feature ...]
+///
+/// If the directory datadir does not contain a data partition, a synthetic
+/// one is generated with the following columns
+///   - i: integers uniformly distributed in [0, 1000),
+///   - s: text values made of two words w0, ..., w299,
+///   - k: categorical values k0, ..., k99.
+/// The known features are
+///   - ngram: LIKE and CONTAINS on a text column with and without a
+///     trigram index.
+///   - dictionary: the lookups in a dictionary read from its file, which
+///     uses the sorted codes in place, and in a copy built with insert,
+///     which uses a hash map.
+///   - packed: range conditions on 64-bit integers beyond 2^53 with and
+///     without packing the data files.
+///   - idxpack: queries answered with a packed index and with the index
+///     file it replaces, and the index file restored from the packed one.
+///   - advisor: queries answered with the indexes recommended from the
+///     recorded conditions and without them.
+///   - stats: queries on read-only and writable data partitions with
+///     the statistics of the columns, where only the writable one may
+///     store the statistics.
+///   - profile: queries answered with and without an active profile,
+///     which must count the bitmaps and the bitwise logical operations.
+///   - lockstats: queries answered by several threads with and without
+///     the statistics of the locks, which must include the acquisitions
+///     of the threads that have terminated.
+///   - rivus: the counts from a stream of rows reusing the in-memory data
+///     partitions between appends, and the counts computed directly.
+/// Without any feature name, all features are tested.  For each feature,
+/// it prints "<feature> matched" if all the answers agree, otherwise, the
+/// number of queries that disagree.
+#include "ibis.h"
+#include "resultCache.h"	// ibis::resultCache
+#include "dictionary.h"	// ibis::dictionary
+#include "idxpack.h"	// ibis::idxpack
+#include "advisor.h"	// ibis::advisor
+#include "colstats.h"	// ibis::colStats
+#include "profile.h"	// ibis::profile
+#include "rivus.h"	// ibis::rivus
+#include <memory>	// std::unique_ptr
+#include <algorithm>	// std::sort
+#include <iostream>	// std::cout
+
+/// A minimal linear congruential generator for reproducible data.
+static uint32_t featcmp_random() {
+    static uint64_t state = 20161018;
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return static_cast<uint32_t>(state >> 33);
+} // featcmp_random
+
+/// Generate the data partition in datadir.
+static void builtindata(const char* datadir) {
+    const uint32_t nrows = 50000;
+    std::unique_ptr<ibis::tablex> ta(ibis::tablex::create());
+    ta->addColumn("i", ibis::INT);
+    ta->addColumn("s", ibis::TEXT);
+    ta->addColumn("k", ibis::CATEGORY);
+
+    ibis::table::row irow;
+    irow.intsnames.push_back("i");
+    irow.intsvalues.resize(1);
+    irow.textsnames.push_back("s");
+    irow.textsvalues.resize(1);
+    irow.catsnames.push_back("k");
+    irow.catsvalues.resize(1);
+    char buf[64];
+    for (uint32_t j = 0; j < nrows; ++ j) {
+        irow.intsvalues[0] = featcmp_random() % 1000;
+        sprintf(buf, "w%u w%u", featcmp_random() % 300,
+                featcmp_random() % 300);
+        irow.textsvalues[0] = buf;
+        sprintf(buf, "k%u", featcmp_random() % 100);
+        irow.catsvalues[0] = buf;
+        ta->appendRow(irow);
+    }
+    ta->write(datadir, "featcmp", "data for featcmp");
+    LOGGER(ibis::gVerbose > 0)
+        << "generated " << ta->mRows() << " rows in directory " << datadir;
+} // builtindata
+
+/// Evaluate the where clause and copy the hits to bv.  Return the number
+/// of hits or a negative number to indicate error.
+static long evaluate(const ibis::part& p, const char* cond,
+                     ibis::bitvector& bv) {
+    ibis::query q(ibis::util::userName(), &p);
+    bv.clear();
+    if (q.setWhereClause(cond) < 0 || q.evaluate() < 0 ||
+        q.getHitVector() == 0) {
+        LOGGER(ibis::gVerbose >= 0)
+            << "featcmp failed to evaluate \"" << cond << '"';
+        return -1;
+    }
+    bv.copy(*q.getHitVector());
+    return bv.cnt();
+} // evaluate
+
+/// Compare the answers recorded in ref with the answers of the same where
+/// clauses.  Return the number of where clauses with different answers.
+static int compare(const ibis::part& p, const char* feature,
+                   const std::vector<const char*>& conds,
+                   const std::vector<ibis::bitvector>& ref) {
+    int nerr = 0;
+    for (unsigned j = 0; j < conds.size(); ++ j) {
+        ibis::bitvector bv;
+        long ierr = evaluate(p, conds[j], bv);
+        // bitvector::operator== compares the compressed words, which may
+        // differ for the same bits
+        bool same = (ierr >= 0 && bv.size() == ref[j].size());
+        if (same) {
+            ibis::bitvector diff(bv);
+            diff ^= ref[j];
+            same = (diff.cnt() == 0);
+        }
+        if (! same) {
+            ++ nerr;
+            LOGGER(ibis::gVerbose >= 0)
+                << feature << " produced " << ierr << " hit"
+                << (ierr>1?"s":"") << " for \"" << conds[j]
+                << "\", expected " << ref[j].cnt();
+        }
+    }
+    return nerr;
+} // compare
+
+/// LIKE and CONTAINS on a text column with and without a trigram index.
+/// The trigram index is a companion of the keyword index, therefore
+/// CONTAINS must produce the same answers with it.
+static int ngram(ibis::part& p) {
+    std::vector<const char*> conds;
+    conds.push_back("s like 'w12%'");
+    conds.push_back("s like '%w299'");
+    conds.push_back("s like '%w1_7 w%'");
+    conds.push_back("s like '%w2%'");
+    conds.push_back("s like '%w77 w1%'");
+    conds.push_back("s contains 'w7'");
+    conds.push_back("s contains 'w210'");
+
+    ibis::column* c = p.getColumn("s");
+    if (c == 0) return 1;
+    c->unloadIndex();
+    c->purgeIndexFile();
+    c->indexSpec("");
+    std::vector<ibis::bitvector> ref(conds.size());
+    for (unsigned j = 0; j < conds.size(); ++ j)
+        (void) evaluate(p, conds[j], ref[j]);
+
+    c->unloadIndex();
+    c->purgeIndexFile();
+    c->indexSpec("ngram");
+    const int nerr = compare(p, "ngram", conds, ref);
+    c->indexSpec("");
+    return nerr;
+} // ngram
+
+/// The lookups in the dictionary of the category column k.  The
+/// dictionary read from the file uses the sorted codes in place, while
+/// the same strings inserted one at a time use a hash map.
+static int dictionary(ibis::part& p) {
+    ibis::column* c = p.getColumn("k");
+    if (c == 0) return 1;
+    c->loadIndex(); // writes the dictionary file if it does not exist
+    std::string fnm = p.currentDataDir();
+    fnm += FASTBIT_DIRSEP;
+    fnm += "k.dic";
+    ibis::dictionary d1, d2;
+    if (d1.read(fnm.c_str()) < 0 || d1.size() == 0) {
+        LOGGER(ibis::gVerbose >= 0)
+            << "featcmp failed to read dictionary " << fnm;
+        return 1;
+    }
+    for (uint32_t j = 0; j < d1.size(); ++ j)
+        if (d1[j] != 0)
+            d2.insert(d1[j], j);
+
+    int nerr = (d1.equal_to(d2) ? 0 : 1);
+    char buf[16];
+    for (unsigned j = 0; j < 120; ++ j) {
+        sprintf(buf, "k%u", j);
+        if (d1[buf] != d2[buf]) {
+            ++ nerr;
+            LOGGER(ibis::gVerbose >= 0)
+                << "dictionary found " << d1[buf] << " for " << buf
+                << ", expected " << d2[buf];
+        }
+    }
+
+    const char* pats[] = {"k1%", "%5", "k_", "%", "x%", 0};
+    for (unsigned j = 0; pats[j] != 0; ++ j) {
+        ibis::array_t<uint32_t> m1, m2;
+        d1.patternSearch(pats[j], m1);
+        d2.patternSearch(pats[j], m2);
+        std::sort(m1.begin(), m1.end());
+        std::sort(m2.begin(), m2.end());
+        if (! m1.equal_to(m2)) {
+            ++ nerr;
+            LOGGER(ibis::gVerbose >= 0)
+                << "dictionary found " << m1.size() << " match"
+                << (m1.size()>1?"es":"") << " for " << pats[j]
+                << ", expected " << m2.size();
+        }
+    }
+
+    ibis::array_t<uint32_t> o2n;
+    if (d1.morph(d2, o2n) < 0) {
+        ++ nerr;
+    }
+    else {
+        for (uint32_t j = 0; j < d2.size(); ++ j)
+            nerr += (j >= o2n.size() || o2n[j] != j);
+    }
+    return nerr;
+} // dictionary
+
+/// Range conditions on 64-bit integers that can not be represented
+/// exactly as doubles, evaluated on the raw data files and on the packed
+/// data files.  The conditions combined with a selective condition on
+/// column a have the packed blocks decoded for a few rows only.
+static int packed(ibis::part& p) {
+    std::string dir = p.currentDataDir();
+    dir += "-packed";
+    ibis::util::removeDir(dir.c_str());
+    {
+        std::unique_ptr<ibis::tablex> ta(ibis::tablex::create());
+        ta->addColumn("a", ibis::INT);
+        ta->addColumn("l", ibis::LONG, 0, "noindex");
+        ta->addColumn("u", ibis::ULONG, 0, "noindex");
+        ibis::table::row irow;
+        irow.intsnames.push_back("a");
+        irow.intsvalues.resize(1);
+        irow.longsnames.push_back("l");
+        irow.longsvalues.resize(1);
+        irow.ulongsnames.push_back("u");
+        irow.ulongsvalues.resize(1);
+        for (uint32_t j = 0; j < 50000; ++ j) {
+            irow.intsvalues[0] = featcmp_random() % 100;
+            irow.longsvalues[0] = (static_cast<int64_t>(1) << 60) +
+                static_cast<int64_t>(featcmp_random() % 1000) - 500;
+            irow.ulongsvalues[0] = (static_cast<uint64_t>(1) << 63) +
+                featcmp_random() % 1000;
+            ta->appendRow(irow);
+        }
+        ta->write(dir.c_str(), "featcmppacked");
+    }
+
+    std::vector<const char*> conds;
+    conds.push_back("l <= 1152921504606846976");
+    conds.push_back("l < 1152921504606847000");
+    conds.push_back("l between 1152921504606846977 and 1152921504606847200");
+    conds.push_back("u > 9223372036854775808");
+    conds.push_back("u <= 9223372036854775809");
+    conds.push_back("a < 5 and l <= 1152921504606846976");
+    conds.push_back("a < 5 and u > 9223372036854775808");
+
+    int nerr = 0;
+    {
+        ibis::part pk(dir.c_str(), static_cast<const char*>(0));
+        std::vector<ibis::bitvector> ref(conds.size());
+        for (unsigned j = 0; j < conds.size(); ++ j)
+            (void) evaluate(pk, conds[j], ref[j]);
+
+        if (pk.getColumn("l") == 0 || pk.getColumn("u") == 0 ||
+            pk.getColumn("l")->packData() <= 0 ||
+            pk.getColumn("u")->packData() <= 0) {
+            LOGGER(ibis::gVerbose >= 0)
+                << "featcmp failed to pack the data files in " << dir;
+            nerr = 1;
+        }
+        else {
+            nerr = compare(pk, "packed", conds, ref);
+        }
+    }
+    ibis::util::removeDir(dir.c_str());
+    return nerr;
+} // packed
+
+/// Queries on column i answered with an equality encoded index, then with
+/// the same index packed, twice so that the second round finds the
+/// decompressed blocks in memory.  Finally, the packed index file is
+/// decompressed and compared with the original index file byte by byte.
+static int idxpack(ibis::part& p) {
+    std::vector<const char*> conds;
+    conds.push_back("i = 17");
+    conds.push_back("i < 100");
+    conds.push_back("i between 250 and 260");
+    conds.push_back("i in (1, 500, 999)");
+    conds.push_back("i > 990 and k = 'k5'");
+
+    ibis::column* c = p.getColumn("i");
+    if (c == 0) return 1;
+    c->unloadIndex();
+    c->purgeIndexFile();
+    c->indexSpec("<binning none/><encoding equality/>");
+    c->loadIndex();
+    std::vector<ibis::bitvector> ref(conds.size());
+    for (unsigned j = 0; j < conds.size(); ++ j)
+        (void) evaluate(p, conds[j], ref[j]);
+
+    std::string fnm;
+    (void) c->dataFileName(fnm);
+    fnm += ".idx";
+    ibis::array_t<char> orig;
+    if (ibis::fileManager::instance().getFile(fnm.c_str(), orig) != 0 ||
+        orig.empty()) {
+        LOGGER(ibis::gVerbose >= 0)
+            << "featcmp failed to read index file " << fnm;
+        return 1;
+    }
+    ibis::array_t<char> saved(orig.size());
+    memcpy(saved.begin(), orig.begin(), orig.size());
+    orig.clear();
+
+    int nerr = 0;
+    c->unloadIndex();
+    if (c->packIndex() <= 0) {
+        LOGGER(ibis::gVerbose >= 0)
+            << "featcmp failed to pack index file " << fnm;
+        nerr = 1;
+    }
+    else {
+        nerr = compare(p, "idxpack", conds, ref);
+        nerr += compare(p, "idxpack", conds, ref);
+
+        ibis::array_t<char> buf(saved.size());
+        const int64_t ierr = ibis::idxpack::unpack
+            (fnm.c_str(), buf.begin(), buf.size());
+        if (ierr != (int64_t)saved.size() ||
+            memcmp(buf.begin(), saved.begin(), saved.size()) != 0) {
+            ++ nerr;
+            LOGGER(ibis::gVerbose >= 0)
+                << "idxpack restored " << ierr << " byte" << (ierr>1?"s":"")
+                << " different from the " << saved.size()
+                << " bytes of " << fnm;
+        }
+    }
+    c->unloadIndex();
+    c->purgeIndexFile();
+    c->indexSpec("");
+    return nerr;
+} // idxpack
+
+/// Queries on a read-only and on a writable copy of the data partition
+/// with the statistics of the columns computed when the copies are
+/// created.  The statistics only change the estimated costs, therefore
+/// the answers must agree, and only the writable copy may store the
+/// statistics in the file -part.stats.
+static int stats(ibis::part& p) {
+    std::vector<const char*> conds;
+    conds.push_back("i < 100");
+    conds.push_back("i between 10 and 20 and k = 'k3'");
+    std::vector<ibis::bitvector> ref(conds.size());
+    for (unsigned j = 0; j < conds.size(); ++ j)
+        (void) evaluate(p, conds[j], ref[j]);
+
+    std::string fnm = p.currentDataDir();
+    fnm += FASTBIT_DIRSEP;
+    fnm += "-part.stats";
+    remove(fnm.c_str());
+    ibis::gParameters().add("computeStatistics", "true");
+    int nerr = 0;
+    {
+        ibis::part ro(p.currentDataDir(), static_cast<const char*>(0), true);
+        ibis::colStats st;
+        if (ro.getColumn("i") == 0 ||
+            ! ro.getColumn("i")->getStatistics(st)) {
+            ++ nerr;
+            LOGGER(ibis::gVerbose >= 0)
+                << "stats found no statistics for column i of the "
+                "read-only data partition";
+        }
+        nerr += compare(ro, "stats", conds, ref);
+    }
+    if (ibis::util::getFileSize(fnm.c_str()) > 0) {
+        ++ nerr;
+        LOGGER(ibis::gVerbose >= 0)
+            << "stats found " << fnm << " written for a read-only data "
+            "partition";
+    }
+    {
+        ibis::part rw(p.currentDataDir(), static_cast<const char*>(0));
+        nerr += compare(rw, "stats", conds, ref);
+    }
+    if (ibis::util::getFileSize(fnm.c_str()) <= 0) {
+        ++ nerr;
+        LOGGER(ibis::gVerbose >= 0)
+            << "stats did not find " << fnm << " written for a writable "
+            "data partition";
+    }
+    ibis::gParameters().add("computeStatistics", "false");
+    remove(fnm.c_str());
+    return nerr;
+} // stats
+
+/// Queries answered with and without an active ibis::profile.  The
+/// profile only counts the work, therefore the answers must agree, and
+/// the bitmaps and the bitwise logical operations used by the index must
+/// be counted while it is active.
+static int profile(ibis::part& p) {
+    std::vector<const char*> conds;
+    conds.push_back("i in (3, 30, 300)");
+    conds.push_back("i between 100 and 200 and k = 'k7'");
+
+    ibis::column* c = p.getColumn("i");
+    if (c == 0) return 1;
+    c->unloadIndex();
+    c->purgeIndexFile();
+    c->indexSpec("<binning none/><encoding equality/>");
+    c->loadIndex();
+    std::vector<ibis::bitvector> ref(conds.size());
+    for (unsigned j = 0; j < conds.size(); ++ j)
+        (void) evaluate(p, conds[j], ref[j]);
+
+    int nerr = 0;
+    ibis::profile prof("featcmp");
+    {
+        ibis::profile::activate act(prof);
+        nerr = compare(p, "profile", conds, ref);
+    }
+    if (ibis::profile::enabled()) {
+        ++ nerr;
+        LOGGER(ibis::gVerbose >= 0)
+            << "profile is still enabled after its activation ended";
+    }
+    if (prof.root().work.bitmaps == 0 || prof.root().work.bitvectorOps == 0) {
+        ++ nerr;
+        LOGGER(ibis::gVerbose >= 0)
+            << "profile counted " << prof.root().work.bitmaps
+            << " bitmap(s) and " << prof.root().work.bitvectorOps
+            << " bitwise logical operation(s)";
+    }
+    c->unloadIndex();
+    c->purgeIndexFile();
+    c->indexSpec("");
+    return nerr;
+} // profile
+
+/// The arguments of the threads started by lockstats.
+struct lockstatsArgs {
+    const ibis::part* part;
+    const std::vector<const char*>* conds;
+    const std::vector<ibis::bitvector>* ref;
+    int nerr;
+};
+
+static void* lockstatsThread(void* arg) {
+    lockstatsArgs* la = static_cast<lockstatsArgs*>(arg);
+    la->nerr = compare(*(la->part), "lockstats", *(la->conds), *(la->ref));
+    return 0;
+}
+
+/// Queries answered by several threads with and without the statistics of
+/// the locks.  The statistics only count the acquisitions, therefore the
+/// answers must agree, and the acquisitions made by the threads must be
+/// reported after the threads have terminated.
+static int lockstats(ibis::part& p) {
+    std::vector<const char*> conds;
+    conds.push_back("i < 100");
+    conds.push_back("i between 10 and 20 and k = 'k3'");
+    std::vector<ibis::bitvector> ref(conds.size());
+    for (unsigned j = 0; j < conds.size(); ++ j)
+        (void) evaluate(p, conds[j], ref[j]);
+
+    const unsigned nthreads = 4;
+    std::vector<lockstatsArgs> args(nthreads);
+    std::vector<pthread_t> tids(nthreads);
+    ibis::util::lockStats::clear();
+    ibis::util::lockStats::enable(true);
+    for (unsigned j = 0; j < nthreads; ++ j) {
+        args[j].part = &p;
+        args[j].conds = &conds;
+        args[j].ref = &ref;
+        args[j].nerr = 1;
+        if (pthread_create(&(tids[j]), 0, lockstatsThread, &(args[j])) != 0)
+            tids[j] = pthread_self();
+    }
+    int nerr = 0;
+    for (unsigned j = 0; j < nthreads; ++ j) {
+        if (! pthread_equal(tids[j], pthread_self()))
+            (void) pthread_join(tids[j], 0);
+        nerr += args[j].nerr;
+    }
+    ibis::util::lockStats::enable(false);
+
+    std::vector<ibis::util::lockStats::entry> lst;
+    ibis::util::lockStats::snapshot(lst);
+    uint64_t nread = 0;
+    for (size_t j = 0; j < lst.size(); ++ j)
+        if (lst[j].kind == "part::readLock")
+            nread += lst[j].acquired;
+    if (nread < nthreads * conds.size()) {
+        ++ nerr;
+        LOGGER(ibis::gVerbose >= 0)
+            << "lockstats reported " << nread << " read lock"
+            << (nread>1?"s":"") << " on the data partition, expected at "
+            "least " << nthreads * conds.size();
+    }
+    ibis::util::lockStats::clear();
+    ibis::util::lockStats::snapshot(lst);
+    if (! lst.empty()) {
+        ++ nerr;
+        LOGGER(ibis::gVerbose >= 0)
+            << "lockstats reported " << lst.size() << " entr"
+            << (lst.size()>1?"ies":"y") << " after clear";
+    }
+    return nerr;
+} // lockstats
+
+/// Queries answered before and after the index specifications are chosen
+/// by ibis::advisor.  The conditions evaluated while the recording is off
+/// must leave no trace, and those evaluated while it is on must lead to a
+/// recommendation for column i.
+static int advisor(ibis::part& p) {
+    std::vector<const char*> conds;
+    conds.push_back("i = 17");
+    conds.push_back("i in (3, 30, 300)");
+    conds.push_back("i between 100 and 200");
+    conds.push_back("i > 900 and k = 'k7'");
+
+    ibis::column* c = p.getColumn("i");
+    if (c == 0) return 1;
+    c->unloadIndex();
+    c->purgeIndexFile();
+    c->indexSpec("");
+    ibis::advisor::clear(&p);
+    ibis::advisor::enable(false);
+    std::vector<ibis::bitvector> ref(conds.size());
+    for (unsigned j = 0; j < conds.size(); ++ j)
+        (void) evaluate(p, conds[j], ref[j]);
+
+    int nerr = 0;
+    std::map<std::string, std::string> specs;
+    if (ibis::advisor::advise(p, specs) != 0) {
+        ++ nerr;
+        LOGGER(ibis::gVerbose >= 0)
+            << "advisor recorded conditions while it was turned off";
+    }
+
+    ibis::advisor::enable(true);
+    nerr += compare(p, "advisor", conds, ref);
+    ibis::advisor::enable(false);
+    if (p.adviseIndexes() <= 0 || c->indexSpec() == 0 ||
+        *(c->indexSpec()) == 0) {
+        ++ nerr;
+        LOGGER(ibis::gVerbose >= 0)
+            << "advisor did not recommend an index for " << c->fullname();
+    }
+    else {
+        c->loadIndex();
+        nerr += compare(p, "advisor", conds, ref);
+    }
+
+    ibis::advisor::clear(&p);
+    c->unloadIndex();
+    c->purgeIndexFile();
+    c->indexSpec("");
+    return nerr;
+} // advisor
+
+/// The counts from an ibis::rivus fed with the values of column i.  The
+/// rows stay in memory, and each count is computed twice, once right
+/// after the rows are appended and once more from the in-memory data
+/// partitions kept from the previous query.  Both must agree with the
+/// number of values satisfying the condition.
+static int rivus(ibis::part& p) {
+    ibis::bitvector mask;
+    p.getNullMask(mask);
+    std::unique_ptr< ibis::array_t<int32_t> > vals
+        (p.getColumn("i") != 0 ? p.getColumn("i")->selectInts(mask) : 0);
+    if (vals.get() == 0 || vals->empty()) return 1;
+
+    std::string dir = p.currentDataDir();
+    dir += "-rivus";
+    ibis::util::removeDir(dir.c_str());
+    int nerr = 0;
+    {
+        ibis::rivus rv(dir.c_str(), "featcmprivus");
+        rv.addColumn("i", ibis::INT);
+        rv.setLimits(vals->size()+1, 1e6);
+        ibis::table::row irow;
+        irow.intsnames.push_back("i");
+        irow.intsvalues.resize(1);
+        uint64_t expected = 0;
+        for (uint32_t j = 0; j < vals->size(); ++ j) {
+            irow.intsvalues[0] = (*vals)[j];
+            rv.appendRow(irow);
+            expected += ((*vals)[j] < 100);
+            if ((j+1) % 7000 != 0 && j+1 < vals->size()) continue;
+
+            for (unsigned k = 0; k < 2; ++ k) {
+                std::unique_ptr<ibis::table> res(rv.select("", "i < 100"));
+                const uint64_t nhits = (res.get() != 0 ? res->nRows() : 0);
+                if (nhits != expected) {
+                    ++ nerr;
+                    LOGGER(ibis::gVerbose >= 0)
+                        << "rivus produced " << nhits << " hit"
+                        << (nhits>1?"s":"") << " from " << j+1 << " row"
+                        << (j>0?"s":"") << ", expected " << expected;
+                }
+            }
+        }
+    }
+    ibis::util::removeDir(dir.c_str());
+    return nerr;
+} // rivus
+
+/// The list of features.
+static const struct {
+    const char* name;
+    int (*run)(ibis::part&);
+} features[] = {
+    {"ngram", ngram},
+    {"dictionary", dictionary},
+    {"idxpack", idxpack},
+    {"advisor", advisor},
+    {"stats", stats},
+    {"profile", profile},
+    {"lockstats", lockstats},
+    {"rivus", rivus},
+    {"packed", packed},
+};
+static const unsigned nfeatures = sizeof(features) / sizeof(features[0]);
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cout << "\nUsage:\n" << *argv << " <datadir> [feature ...]\n\n";
+        return 0;
+    }
+#if defined(_DEBUG)
+    ibis::util::setVerboseLevel(5);
+#elif defined(DEBUG)
+    ibis::util::setVerboseLevel(7);
+#endif
+
+    const char* datadir = argv[1];
+    {
+        ibis::part tmp(datadir, static_cast<const char*>(0));
+        if (tmp.nRows() == 0)
+            builtindata(datadir);
+    }
+    ibis::part p(datadir, static_cast<const char*>(0));
+    if (p.nRows() == 0) {
+        std::cout << "featcmp failed to find data in " << datadir << "\n";
+        return -1;
+    }
+
+    // the features are tested on the answers computed afresh
+    ibis::resultCache::setLimit(0);
+    int ret = 0;
+    for (unsigned j = 0; j < nfeatures; ++ j) {
+        bool run = (argc == 2);
+        for (int i = 2; i < argc && ! run; ++ i)
+            run = (std::strcmp(argv[i], features[j].name) == 0);
+        if (! run) continue;
+
+        const int nerr = features[j].run(p);
+        if (nerr == 0)
+            std::cout << features[j].name << " matched" << std::endl;
+        else
+            std::cout << features[j].name << " found " << nerr
+                      << " different answer" << (nerr>1?"s":"") << std::endl;
+        ret += nerr;
+    }
+    return ret;
+} // main
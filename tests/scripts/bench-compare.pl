@@ -0,0 +1,85 @@
+#!/usr/bin/perl
+#
+# Compare two JSON files produced by fbbench and report the benchmarks
+# whose median time changed by more than the given threshold (default 10
+# percent).  The check values of the same benchmark are also compared,
+# since a different check value indicates a change in the results rather
+# than in the speed.  The exit status is 1 if any benchmark is slower by
+# more than the threshold or has a different check value, 0 otherwise.
+#
+# Usage:
+# bench-compare.pl old.json new.json [threshold-in-percent]
+use strict;
+use JSON::PP;
+
+if ($#ARGV < 1) {
+    print "bench-compare.pl expects two JSON files produced by fbbench ",
+    "on the command line.\n  If a third argument is present, it is the ",
+    "threshold for reporting changes in percent (default 10)\n";
+    die;
+}
+my $threshold = ($#ARGV >= 2 ? $ARGV[2] : 10.0);
+
+sub readBench {
+    my ($fname) = @_;
+    open my $fh, '<', $fname or die "$fname: $!";
+    local $/;
+    my $doc = decode_json(<$fh>);
+    close $fh;
+    my %res;
+    foreach my $r (@{$doc->{results}}) {
+	$res{$r->{name}} = $r;
+    }
+    return ($doc, \%res);
+}
+
+my ($docA, $resA) = readBench($ARGV[0]);
+my ($docB, $resB) = readBench($ARGV[1]);
+if ($docA->{rows} != $docB->{rows} || $docA->{seed} != $docB->{seed}) {
+    print "Warning -- the two files were produced with different data ",
+    "(rows $docA->{rows} vs $docB->{rows}, seed $docA->{seed} vs ",
+    "$docB->{seed}), the check values are not compared\n";
+}
+my $samedata = ($docA->{rows} == $docB->{rows} &&
+		$docA->{seed} == $docB->{seed});
+
+my ($nslower, $nfaster, $nchecks) = (0, 0, 0);
+printf "%-36s %12s %12s %9s\n", "benchmark", "old (sec)", "new (sec)",
+    "change";
+foreach my $name (sort keys %$resB) {
+    my $b = $resB->{$name};
+    if (! exists $resA->{$name}) {
+	printf "%-36s %12s %12.6g %9s\n", $name, "-", $b->{median}, "new";
+	next;
+    }
+    my $a = $resA->{$name};
+    my $chg = ($a->{median} > 0 ?
+	       100.0 * ($b->{median} - $a->{median}) / $a->{median} : 0);
+    my $note = "";
+    if ($chg > $threshold) {
+	++ $nslower;
+	$note = " slower";
+    }
+    elsif ($chg < -$threshold) {
+	++ $nfaster;
+	$note = " faster";
+    }
+    if ($samedata && $a->{check} != $b->{check}) {
+	++ $nchecks;
+	$note .= " check $a->{check} != $b->{check}";
+    }
+    printf "%-36s %12.6g %12.6g %8.1f%%%s\n", $name, $a->{median},
+	$b->{median}, $chg, $note;
+}
+foreach my $name (sort keys %$resA) {
+    printf "%-36s %12.6g %12s %9s\n", $name, $resA->{$name}->{median}, "-",
+	"missing" unless exists $resB->{$name};
+}
+
+print "\n$nslower slower, $nfaster faster by more than $threshold%",
+    ($nchecks > 0 ? ", $nchecks with different check values" : ""), "\n";
+if ($nslower > 0 || $nchecks > 0) {
+    print "Did NOT pass bench-compare\n";
+    exit 1;
+}
+print "Passed bench-compare\n";
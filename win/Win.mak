@@ -29,6 +29,16 @@ OBJ =  parth3d.obj parth3da.obj parth3db.obj parth3dw.obj \
  column.obj \
  dictionary.obj \
  fileManager.obj \
+ colpack.obj \
+ idxpack.obj \
+ advisor.obj \
+ colstats.obj \
+ arrow.obj \
+ profile.obj \
+ metrics.obj \
+ workload.obj \
+ resultCache.obj \
+ preparedQuery.obj \
  ibin.obj \
  jnatural.obj \
  jrange.obj \
@@ -37,6 +47,7 @@ OBJ =  parth3d.obj parth3da.obj parth3db.obj parth3dw.obj \
  bordm.obj \
  tafel.obj \
  mensa.obj \
+ rivus.obj \
  party.obj \
  part.obj \
  parth.obj \
@@ -50,6 +61,7 @@ OBJ =  parth3d.obj parth3da.obj parth3db.obj parth3dw.obj \
  idirekte.obj \
  ifade.obj \
  ikeywords.obj \
+ ingram.obj \
  imesa.obj \
  index.obj \
  irange.obj \
@@ -87,7 +99,7 @@ OBJ =  parth3d.obj parth3da.obj parth3db.obj parth3dw.obj \
 
 #
 ibis: ibis.exe
-all: ibis.exe ardea.exe rara.exe thula.exe tcapi.exe
+all: ibis.exe ardea.exe rara.exe thula.exe tcapi.exe replay.exe
 
 lib: fastbit.lib
 fastbit.lib: $(OBJ)
@@ -100,6 +112,10 @@ rara: rara.exe
 rara.exe: rara.obj fastbit.lib
 	$(LINK) /NOLOGO $(LIB) /out:$@ rara.obj fastbit.lib
 
+replay: replay.exe
+replay.exe: replay.obj fastbit.lib
+	$(LINK) /NOLOGO $(LIB) /out:$@ replay.obj fastbit.lib
+
 thula: thula.exe
 thula.exe: thula.obj fastbit.lib
 	$(LINK) /NOLOGO $(LIB) /out:$@ thula.obj fastbit.lib
@@ -212,6 +228,36 @@ dictionary.obj: ../src/dictionary.cpp ../src/dictionary.h ../src/util.h \
 fileManager.obj: ../src/fileManager.cpp ../src/fileManager.h ../src/util.h \
   ../src/const.h  ../src/resource.h ../src/array_t.h ../src/horometer.h
 	$(CXX) $(CCFLAGS) -c ../src/fileManager.cpp
+colpack.obj: ../src/colpack.cpp ../src/colpack.h ../src/util.h \
+  ../src/const.h  ../src/resource.h ../src/array_t.h ../src/horometer.h
+	$(CXX) $(CCFLAGS) -c ../src/colpack.cpp
+idxpack.obj: ../src/idxpack.cpp ../src/idxpack.h ../src/util.h \
+  ../src/const.h  ../src/resource.h ../src/array_t.h ../src/horometer.h
+	$(CXX) $(CCFLAGS) -c ../src/idxpack.cpp
+advisor.obj: ../src/advisor.cpp ../src/advisor.h ../src/util.h \
+  ../src/const.h  ../src/resource.h ../src/array_t.h ../src/horometer.h
+	$(CXX) $(CCFLAGS) -c ../src/advisor.cpp
+colstats.obj: ../src/colstats.cpp ../src/colstats.h ../src/util.h \
+  ../src/const.h  ../src/resource.h ../src/array_t.h ../src/horometer.h
+	$(CXX) $(CCFLAGS) -c ../src/colstats.cpp
+arrow.obj: ../src/arrow.cpp ../src/arrow.h ../src/util.h \
+  ../src/const.h  ../src/resource.h ../src/array_t.h ../src/horometer.h
+	$(CXX) $(CCFLAGS) -c ../src/arrow.cpp
+profile.obj: ../src/profile.cpp ../src/profile.h ../src/util.h \
+  ../src/const.h  ../src/resource.h ../src/array_t.h ../src/horometer.h
+	$(CXX) $(CCFLAGS) -c ../src/profile.cpp
+metrics.obj: ../src/metrics.cpp ../src/metrics.h ../src/util.h \
+  ../src/const.h  ../src/resource.h ../src/array_t.h ../src/horometer.h
+	$(CXX) $(CCFLAGS) -c ../src/metrics.cpp
+workload.obj: ../src/workload.cpp ../src/workload.h ../src/util.h \
+  ../src/const.h  ../src/resource.h ../src/array_t.h ../src/horometer.h
+	$(CXX) $(CCFLAGS) -c ../src/workload.cpp
+resultCache.obj: ../src/resultCache.cpp ../src/resultCache.h ../src/util.h \
+  ../src/const.h  ../src/resource.h ../src/array_t.h ../src/horometer.h
+	$(CXX) $(CCFLAGS) -c ../src/resultCache.cpp
+preparedQuery.obj: ../src/preparedQuery.cpp ../src/preparedQuery.h ../src/util.h \
+  ../src/const.h  ../src/resource.h ../src/array_t.h ../src/horometer.h
+	$(CXX) $(CCFLAGS) -c ../src/preparedQuery.cpp
 ibin.obj: ../src/ibin.cpp ../src/ibin.h ../src/index.h ../src/qExpr.h \
   ../src/util.h ../src/const.h  ../src/bitvector.h \
   ../src/array_t.h ../src/fileManager.h ../src/horometer.h ../src/part.h \
@@ -261,6 +307,13 @@ ikeywords.obj: ../src/ikeywords.cpp ../src/ikeywords.h ../src/index.h \
   ../src/table.h ../src/iroster.h ../src/part.h ../src/resource.h \
   ../src/utilidor.h
 	$(CXX) $(CCFLAGS) -c ../src/ikeywords.cpp
+ingram.obj: ../src/ingram.cpp ../src/ingram.h ../src/index.h \
+  ../src/qExpr.h ../src/util.h ../src/const.h  \
+  ../src/bitvector.h ../src/array_t.h ../src/fileManager.h \
+  ../src/horometer.h ../src/category.h ../src/irelic.h ../src/column.h \
+  ../src/table.h ../src/iroster.h ../src/part.h ../src/resource.h \
+  ../src/utilidor.h
+	$(CXX) $(CCFLAGS) -c ../src/ingram.cpp
 imesa.obj: ../src/imesa.cpp ../src/ibin.h ../src/index.h ../src/qExpr.h \
   ../src/util.h ../src/const.h  ../src/bitvector.h \
   ../src/array_t.h ../src/fileManager.h ../src/horometer.h ../src/part.h \
@@ -382,6 +435,14 @@ mensa.obj: ../src/mensa.cpp ../src/tab.h ../src/table.h ../src/const.h \
   ../src/whereClause.h ../src/index.h ../src/category.h ../src/irelic.h \
   ../src/selectClause.h
 	$(CXX) $(CCFLAGS) -c ../src/mensa.cpp
+rivus.obj: ../src/rivus.cpp ../src/tab.h ../src/table.h ../src/const.h \
+  ../src/bord.h ../src/util.h ../src/part.h \
+  ../src/column.h ../src/qExpr.h ../src/bitvector.h ../src/array_t.h \
+  ../src/fileManager.h ../src/horometer.h ../src/resource.h \
+  ../src/utilidor.h ../src/rivus.h ../src/countQuery.h \
+  ../src/whereClause.h ../src/index.h ../src/category.h ../src/irelic.h \
+  ../src/selectClause.h
+	$(CXX) $(CCFLAGS) -c ../src/rivus.cpp
 meshQuery.obj: ../src/meshQuery.cpp ../src/meshQuery.h ../src/query.h \
   ../src/part.h ../src/column.h ../src/table.h ../src/const.h \
   ../src/qExpr.h ../src/util.h ../src/bitvector.h \
@@ -545,6 +606,10 @@ rara.obj: ../examples/rara.cpp ../src/ibis.h ../src/countQuery.h \
   ../src/meshQuery.h ../src/query.h ../src/bundle.h ../src/colValues.h \
   ../src/quaere.h ../src/rids.h
 	$(CXX) $(CCFLAGS) -c ../examples/rara.cpp
+replay.obj: ../examples/replay.cpp ../src/ibis.h ../src/workload.h \
+  ../src/util.h ../src/horometer.h ../src/table.h ../src/query.h \
+  ../src/countQuery.h ../src/quaere.h
+	$(CXX) $(CCFLAGS) -c ../examples/replay.cpp
 thula.obj: ../examples/thula.cpp ../src/table.h ../src/const.h \
   ../src/resource.h ../src/util.h ../src/mensa.h \
   ../src/table.h ../src/fileManager.h
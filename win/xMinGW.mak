@@ -41,6 +41,16 @@ OBJ =  parth3d.o parth3da.o parth3db.o parth3dw.o \
  countQuery.o \
  dictionary.o \
  fileManager.o \
+ colpack.o \
+ idxpack.o \
+ advisor.o \
+ colstats.o \
+ arrow.o \
+ profile.o \
+ metrics.o \
+ workload.o \
+ resultCache.o \
+ preparedQuery.o \
  ibin.o \
  jnatural.o \
  jrange.o \
@@ -49,6 +59,7 @@ OBJ =  parth3d.o parth3da.o parth3db.o parth3dw.o \
  bordm.o \
  tafel.o \
  mensa.o \
+ rivus.o \
  party.o \
  part.o \
  parth.o \
@@ -62,6 +73,7 @@ OBJ =  parth3d.o parth3da.o parth3db.o parth3dw.o \
  idirekte.o \
  ifade.o \
  ikeywords.o \
+ ingram.o \
  imesa.o \
  index.o \
  irange.o \
@@ -289,6 +301,46 @@ fileManager.o: ../src/fileManager.cpp ../src/fileManager.h ../src/util.h \
   ../src/const.h  ../src/resource.h \
   ../src/array_t.h ../src/horometer.h
 	$(CXX) $(CCFLAGS) -c -o fileManager.o ../src/fileManager.cpp
+colpack.o: ../src/colpack.cpp ../src/colpack.h ../src/util.h \
+  ../src/const.h  ../src/resource.h \
+  ../src/array_t.h ../src/horometer.h
+	$(CXX) $(CCFLAGS) -c -o colpack.o ../src/colpack.cpp
+idxpack.o: ../src/idxpack.cpp ../src/idxpack.h ../src/util.h \
+  ../src/const.h  ../src/resource.h \
+  ../src/array_t.h ../src/horometer.h
+	$(CXX) $(CCFLAGS) -c -o idxpack.o ../src/idxpack.cpp
+advisor.o: ../src/advisor.cpp ../src/advisor.h ../src/util.h \
+  ../src/const.h  ../src/resource.h \
+  ../src/array_t.h ../src/horometer.h
+	$(CXX) $(CCFLAGS) -c -o advisor.o ../src/advisor.cpp
+colstats.o: ../src/colstats.cpp ../src/colstats.h ../src/util.h \
+  ../src/const.h  ../src/resource.h \
+  ../src/array_t.h ../src/horometer.h
+	$(CXX) $(CCFLAGS) -c -o colstats.o ../src/colstats.cpp
+arrow.o: ../src/arrow.cpp ../src/arrow.h ../src/util.h \
+  ../src/const.h  ../src/resource.h \
+  ../src/array_t.h ../src/horometer.h
+	$(CXX) $(CCFLAGS) -c -o arrow.o ../src/arrow.cpp
+profile.o: ../src/profile.cpp ../src/profile.h ../src/util.h \
+  ../src/const.h  ../src/resource.h \
+  ../src/array_t.h ../src/horometer.h
+	$(CXX) $(CCFLAGS) -c -o profile.o ../src/profile.cpp
+metrics.o: ../src/metrics.cpp ../src/metrics.h ../src/util.h \
+  ../src/const.h  ../src/resource.h \
+  ../src/array_t.h ../src/horometer.h
+	$(CXX) $(CCFLAGS) -c -o metrics.o ../src/metrics.cpp
+workload.o: ../src/workload.cpp ../src/workload.h ../src/util.h \
+  ../src/const.h  ../src/resource.h \
+  ../src/array_t.h ../src/horometer.h
+	$(CXX) $(CCFLAGS) -c -o workload.o ../src/workload.cpp
+resultCache.o: ../src/resultCache.cpp ../src/resultCache.h ../src/util.h \
+  ../src/const.h  ../src/resource.h \
+  ../src/array_t.h ../src/horometer.h
+	$(CXX) $(CCFLAGS) -c -o resultCache.o ../src/resultCache.cpp
+preparedQuery.o: ../src/preparedQuery.cpp ../src/preparedQuery.h ../src/util.h \
+  ../src/const.h  ../src/resource.h \
+  ../src/array_t.h ../src/horometer.h
+	$(CXX) $(CCFLAGS) -c -o preparedQuery.o ../src/preparedQuery.cpp
 filter.o: ../src/filter.cpp ../src/filter.h ../src/query.h \
   ../src/part.h ../src/column.h ../src/table.h ../src/const.h \
   ../src/qExpr.h ../src/util.h ../src/bitvector.h \
@@ -344,6 +396,13 @@ ikeywords.o: ../src/ikeywords.cpp ../src/ikeywords.h ../src/index.h \
   ../src/table.h ../src/iroster.h ../src/part.h ../src/resource.h \
   ../src/utilidor.h
 	$(CXX) $(CCFLAGS) -c -o ikeywords.o ../src/ikeywords.cpp
+ingram.o: ../src/ingram.cpp ../src/ingram.h ../src/index.h \
+  ../src/qExpr.h ../src/util.h ../src/const.h  \
+  ../src/bitvector.h ../src/array_t.h ../src/fileManager.h \
+  ../src/horometer.h ../src/category.h ../src/irelic.h ../src/column.h \
+  ../src/table.h ../src/iroster.h ../src/part.h ../src/resource.h \
+  ../src/utilidor.h
+	$(CXX) $(CCFLAGS) -c -o ingram.o ../src/ingram.cpp
 imesa.o: ../src/imesa.cpp ../src/ibin.h ../src/index.h ../src/qExpr.h \
   ../src/util.h ../src/const.h  ../src/bitvector.h \
   ../src/array_t.h ../src/fileManager.h ../src/horometer.h ../src/part.h \
@@ -459,6 +518,14 @@ mensa.o: ../src/mensa.cpp ../src/tab.h ../src/table.h ../src/const.h \
   ../src/whereClause.h ../src/index.h ../src/category.h ../src/irelic.h \
   ../src/selectClause.h
 	$(CXX) $(CCFLAGS) -c -o mensa.o ../src/mensa.cpp
+rivus.o: ../src/rivus.cpp ../src/tab.h ../src/table.h ../src/const.h \
+  ../src/bord.h ../src/util.h ../src/part.h \
+  ../src/column.h ../src/qExpr.h ../src/bitvector.h ../src/array_t.h \
+  ../src/fileManager.h ../src/horometer.h ../src/resource.h \
+  ../src/utilidor.h ../src/rivus.h ../src/countQuery.h \
+  ../src/whereClause.h ../src/index.h ../src/category.h ../src/irelic.h \
+  ../src/selectClause.h
+	$(CXX) $(CCFLAGS) -c -o rivus.o ../src/rivus.cpp
 meshQuery.o: ../src/meshQuery.cpp ../src/meshQuery.h ../src/query.h \
   ../src/part.h ../src/column.h ../src/table.h ../src/const.h \
    ../src/qExpr.h ../src/util.h ../src/bitvector.h \